@@ -231,6 +231,47 @@ void computeEdgesOfFrustum(F32 far, F32 fovX, F32 fovY, Vec3 points[4]);
 /// Welzl's algorithm that computes a compact bounding sphere given a point cloud.
 Sphere computeBoundingSphere(ConstWeakArray<Vec3> points);
 
+/// Many AABBs stored as a structure of arrays. Used in the batched tests. The arrays don't need any special alignment.
+class AabbSoa
+{
+public:
+	Array<const F32*, 3> m_min = {}; ///< The X, Y and Z of the min.
+	Array<const F32*, 3> m_max = {}; ///< The X, Y and Z of the max.
+	U32 m_count = 0;
+};
+
+/// Many spheres stored as a structure of arrays. Used in the batched tests.
+class SphereSoa
+{
+public:
+	Array<const F32*, 3> m_center = {};
+	const F32* m_radius = nullptr;
+	U32 m_count = 0;
+};
+
+/// Many OBBs stored as a structure of arrays. Used in the batched tests.
+class ObbSoa
+{
+public:
+	Array<const F32*, 3> m_center = {};
+	Array<const F32*, 3> m_extend = {};
+	Array<const F32*, 9> m_rotation = {}; ///< The 3x3 rotation in row-major order.
+	U32 m_count = 0;
+};
+
+/// Batched version of testPlane(). A shape is inside if it's not behind any of the planes (a frustum for example). It uses 8-wide AVX2 if
+/// the CPU supports it, 4-wide SSE or NEON otherwise.
+/// @param planes The planes.
+/// @param aabbs The shapes.
+/// @param[out] insideMask One bit per shape. It's set if the shape is inside. Its size should be at least (count + 31) / 32.
+void insidePlanes(ConstWeakArray<Plane> planes, const AabbSoa& aabbs, WeakArray<U32> insideMask);
+
+/// @copydoc insidePlanes(ConstWeakArray<Plane>, const AabbSoa&, WeakArray<U32>)
+void insidePlanes(ConstWeakArray<Plane> planes, const SphereSoa& spheres, WeakArray<U32> insideMask);
+
+/// @copydoc insidePlanes(ConstWeakArray<Plane>, const AabbSoa&, WeakArray<U32>)
+void insidePlanes(ConstWeakArray<Plane> planes, const ObbSoa& obbs, WeakArray<U32> insideMask);
+
 /// @}
 
 } // end namespace anki
@@ -0,0 +1,105 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Collision/Functions.h>
+#include <AnKi/Collision/FunctionsBatchKernels.h>
+
+namespace anki {
+
+/// The max number of planes of the batched tests.
+constexpr U32 kMaxBatchPlanes = 32;
+
+#if ANKI_COLLISION_AVX2
+static Bool cpuSupportsAvx2()
+{
+	static const Bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	return supported;
+}
+#endif
+
+template<typename TShapes>
+static void insidePlanesInternal(ConstWeakArray<Plane> planes, const TShapes& shapes, U32 count, WeakArray<U32> insideMask)
+{
+	ANKI_ASSERT(planes.getSize() <= kMaxBatchPlanes);
+	ANKI_ASSERT(insideMask.getSize() >= (count + 31) / 32);
+
+	if(count == 0)
+	{
+		return;
+	}
+
+	Array<BatchPlane, kMaxBatchPlanes> batchPlanes;
+	for(U32 p = 0; p < planes.getSize(); ++p)
+	{
+		for(U32 i = 0; i < 3; ++i)
+		{
+			batchPlanes[p].m_normal[i] = planes[p].getNormal()[i];
+			batchPlanes[p].m_positive[i] = planes[p].getNormal()[i] >= 0.0f;
+		}
+		batchPlanes[p].m_offset = planes[p].getOffset();
+	}
+
+	memset(&insideMask[0], 0, sizeof(U32) * ((count + 31) / 32));
+
+	U32 begin = 0;
+#if ANKI_COLLISION_AVX2
+	if(cpuSupportsAvx2())
+	{
+		begin = insidePlanesAvx2(&batchPlanes[0], planes.getSize(), shapes, count, &insideMask[0]);
+	}
+#endif
+
+#if ANKI_SIMD_SSE
+	begin = insidePlanesKernel<BatchSse>(&batchPlanes[0], planes.getSize(), shapes, begin, count, &insideMask[0]);
+#elif ANKI_SIMD_NEON
+	begin = insidePlanesKernel<BatchNeon>(&batchPlanes[0], planes.getSize(), shapes, begin, count, &insideMask[0]);
+#endif
+
+	// The remaining
+	insidePlanesKernel<BatchScalar>(&batchPlanes[0], planes.getSize(), shapes, begin, count, &insideMask[0]);
+}
+
+void insidePlanes(ConstWeakArray<Plane> planes, const AabbSoa& aabbs, WeakArray<U32> insideMask)
+{
+	BatchAabbs batch;
+	for(U32 i = 0; i < 3; ++i)
+	{
+		batch.m_min[i] = aabbs.m_min[i];
+		batch.m_max[i] = aabbs.m_max[i];
+	}
+
+	insidePlanesInternal(planes, batch, aabbs.m_count, insideMask);
+}
+
+void insidePlanes(ConstWeakArray<Plane> planes, const SphereSoa& spheres, WeakArray<U32> insideMask)
+{
+	BatchSpheres batch;
+	for(U32 i = 0; i < 3; ++i)
+	{
+		batch.m_center[i] = spheres.m_center[i];
+	}
+	batch.m_radius = spheres.m_radius;
+
+	insidePlanesInternal(planes, batch, spheres.m_count, insideMask);
+}
+
+void insidePlanes(ConstWeakArray<Plane> planes, const ObbSoa& obbs, WeakArray<U32> insideMask)
+{
+	BatchObbs batch;
+	for(U32 i = 0; i < 3; ++i)
+	{
+		batch.m_center[i] = obbs.m_center[i];
+		batch.m_extend[i] = obbs.m_extend[i];
+	}
+
+	for(U32 i = 0; i < 9; ++i)
+	{
+		batch.m_rotation[i] = obbs.m_rotation[i];
+	}
+
+	insidePlanesInternal(planes, batch, obbs.m_count, insideMask);
+}
+
+} // end namespace anki
@@ -0,0 +1,35 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+// This file is compiled with AVX2 and FMA enabled (see the CMakeLists.txt). Don't include anything else than FunctionsBatchKernels.h
+
+#include <AnKi/Collision/FunctionsBatchKernels.h>
+
+#if ANKI_COLLISION_AVX2
+
+#	if !defined(__AVX2__) || !defined(__FMA__)
+#		error "This file should be compiled with AVX2 and FMA"
+#	endif
+
+namespace anki {
+
+U32 insidePlanesAvx2(const BatchPlane* planes, U32 planeCount, const BatchAabbs& aabbs, U32 count, U32* insideMask)
+{
+	return insidePlanesKernel<BatchAvx2>(planes, planeCount, aabbs, 0, count, insideMask);
+}
+
+U32 insidePlanesAvx2(const BatchPlane* planes, U32 planeCount, const BatchSpheres& spheres, U32 count, U32* insideMask)
+{
+	return insidePlanesKernel<BatchAvx2>(planes, planeCount, spheres, 0, count, insideMask);
+}
+
+U32 insidePlanesAvx2(const BatchPlane* planes, U32 planeCount, const BatchObbs& obbs, U32 count, U32* insideMask)
+{
+	return insidePlanesKernel<BatchAvx2>(planes, planeCount, obbs, 0, count, insideMask);
+}
+
+} // end namespace anki
+
+#endif
@@ -0,0 +1,368 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+// Internal header of the batched tests of Functions.h. It's included by FunctionsBatchAvx2.cpp that is compiled with AVX2 enabled. If
+// that file used any of the inline functions of the engine (math, containers etc) the linker might pick its AVX2 version for everyone
+// so the kernels only use intrinsics, plain pointers and the types of this file.
+
+#include <AnKi/Util/StdTypes.h>
+
+#if ANKI_SIMD_SSE
+#	include <immintrin.h>
+#elif ANKI_SIMD_NEON
+#	include <arm_neon.h>
+#endif
+
+/// If 1 the AVX2 kernels are compiled and they will be used if the CPU supports AVX2.
+#define ANKI_COLLISION_AVX2 (ANKI_SIMD_SSE && ANKI_COMPILER_GCC_COMPATIBLE)
+
+namespace anki {
+
+/// @addtogroup collision
+/// @{
+
+/// A plane ready for the batched tests.
+class BatchPlane
+{
+public:
+	F32 m_normal[3];
+	F32 m_offset;
+	Bool m_positive[3]; ///< The sign of the normal's components.
+};
+
+/// Scalar "SIMD" for the shapes that don't fill a whole register.
+class BatchScalar
+{
+public:
+	using Vec = F32;
+	static constexpr U32 kWidth = 1;
+
+	static Vec load(const F32* p)
+	{
+		return *p;
+	}
+
+	static Vec set1(F32 f)
+	{
+		return f;
+	}
+
+	static Vec add(Vec a, Vec b)
+	{
+		return a + b;
+	}
+
+	static Vec mul(Vec a, Vec b)
+	{
+		return a * b;
+	}
+
+	/// a * b + c
+	static Vec madd(Vec a, Vec b, Vec c)
+	{
+		return a * b + c;
+	}
+
+	static Vec abs(Vec a)
+	{
+		return (a < 0.0f) ? -a : a;
+	}
+
+	/// One bit for every lane that is less than zero.
+	static U32 negativeMask(Vec a)
+	{
+		return a < 0.0f;
+	}
+};
+
+#if ANKI_SIMD_SSE
+class BatchSse
+{
+public:
+	using Vec = __m128;
+	static constexpr U32 kWidth = 4;
+
+	static Vec load(const F32* p)
+	{
+		return _mm_loadu_ps(p);
+	}
+
+	static Vec set1(F32 f)
+	{
+		return _mm_set1_ps(f);
+	}
+
+	static Vec add(Vec a, Vec b)
+	{
+		return _mm_add_ps(a, b);
+	}
+
+	static Vec mul(Vec a, Vec b)
+	{
+		return _mm_mul_ps(a, b);
+	}
+
+	static Vec madd(Vec a, Vec b, Vec c)
+	{
+		return _mm_add_ps(_mm_mul_ps(a, b), c);
+	}
+
+	static Vec abs(Vec a)
+	{
+		return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+	}
+
+	static U32 negativeMask(Vec a)
+	{
+		return U32(_mm_movemask_ps(_mm_cmplt_ps(a, _mm_setzero_ps())));
+	}
+};
+
+#	if defined(__AVX2__) && defined(__FMA__)
+class BatchAvx2
+{
+public:
+	using Vec = __m256;
+	static constexpr U32 kWidth = 8;
+
+	static Vec load(const F32* p)
+	{
+		return _mm256_loadu_ps(p);
+	}
+
+	static Vec set1(F32 f)
+	{
+		return _mm256_set1_ps(f);
+	}
+
+	static Vec add(Vec a, Vec b)
+	{
+		return _mm256_add_ps(a, b);
+	}
+
+	static Vec mul(Vec a, Vec b)
+	{
+		return _mm256_mul_ps(a, b);
+	}
+
+	static Vec madd(Vec a, Vec b, Vec c)
+	{
+		return _mm256_fmadd_ps(a, b, c);
+	}
+
+	static Vec abs(Vec a)
+	{
+		return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+	}
+
+	static U32 negativeMask(Vec a)
+	{
+		return U32(_mm256_movemask_ps(_mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_LT_OQ)));
+	}
+};
+#	endif
+#elif ANKI_SIMD_NEON
+class BatchNeon
+{
+public:
+	using Vec = float32x4_t;
+	static constexpr U32 kWidth = 4;
+
+	static Vec load(const F32* p)
+	{
+		return vld1q_f32(p);
+	}
+
+	static Vec set1(F32 f)
+	{
+		return vdupq_n_f32(f);
+	}
+
+	static Vec add(Vec a, Vec b)
+	{
+		return vaddq_f32(a, b);
+	}
+
+	static Vec mul(Vec a, Vec b)
+	{
+		return vmulq_f32(a, b);
+	}
+
+	static Vec madd(Vec a, Vec b, Vec c)
+	{
+		return vmlaq_f32(c, a, b);
+	}
+
+	static Vec abs(Vec a)
+	{
+		return vabsq_f32(a);
+	}
+
+	static U32 negativeMask(Vec a)
+	{
+		const uint32x4_t laneBits = {1, 2, 4, 8};
+		const uint32x4_t bits = vandq_u32(vcltq_f32(a, vdupq_n_f32(0.0f)), laneBits);
+		const uint32x2_t sum = vadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+		return vget_lane_u32(vpadd_u32(sum, sum), 0);
+	}
+};
+#endif
+
+/// AABBs for the batched tests.
+class BatchAabbs
+{
+public:
+	const F32* m_min[3];
+	const F32* m_max[3];
+
+	/// @return One bit for every AABB (of a register) that is behind some plane.
+	template<typename TSimd>
+	U32 computeOutsideMask(const BatchPlane* planes, U32 planeCount, U32 offset) const
+	{
+		using Vec = typename TSimd::Vec;
+		constexpr U32 kAllLanes = (1u << TSimd::kWidth) - 1;
+
+		U32 outside = 0;
+		for(U32 p = 0; p < planeCount && outside != kAllLanes; ++p)
+		{
+			const BatchPlane& plane = planes[p];
+
+			// Test the corner that is furthest along the normal
+			Vec dist = TSimd::set1(-plane.m_offset);
+			for(U32 i = 0; i < 3; ++i)
+			{
+				const Vec corner = TSimd::load(((plane.m_positive[i]) ? m_max[i] : m_min[i]) + offset);
+				dist = TSimd::madd(TSimd::set1(plane.m_normal[i]), corner, dist);
+			}
+
+			outside |= TSimd::negativeMask(dist);
+		}
+
+		return outside;
+	}
+};
+
+/// Spheres for the batched tests.
+class BatchSpheres
+{
+public:
+	const F32* m_center[3];
+	const F32* m_radius;
+
+	template<typename TSimd>
+	U32 computeOutsideMask(const BatchPlane* planes, U32 planeCount, U32 offset) const
+	{
+		using Vec = typename TSimd::Vec;
+		constexpr U32 kAllLanes = (1u << TSimd::kWidth) - 1;
+
+		const Vec x = TSimd::load(m_center[0] + offset);
+		const Vec y = TSimd::load(m_center[1] + offset);
+		const Vec z = TSimd::load(m_center[2] + offset);
+		const Vec r = TSimd::load(m_radius + offset);
+
+		U32 outside = 0;
+		for(U32 p = 0; p < planeCount && outside != kAllLanes; ++p)
+		{
+			const BatchPlane& plane = planes[p];
+
+			// Outside if the distance of the center is less than -radius
+			Vec dist = TSimd::add(r, TSimd::set1(-plane.m_offset));
+			dist = TSimd::madd(TSimd::set1(plane.m_normal[0]), x, dist);
+			dist = TSimd::madd(TSimd::set1(plane.m_normal[1]), y, dist);
+			dist = TSimd::madd(TSimd::set1(plane.m_normal[2]), z, dist);
+
+			outside |= TSimd::negativeMask(dist);
+		}
+
+		return outside;
+	}
+};
+
+/// OBBs for the batched tests.
+class BatchObbs
+{
+public:
+	const F32* m_center[3];
+	const F32* m_extend[3];
+	const F32* m_rotation[9]; ///< Row-major.
+
+	template<typename TSimd>
+	U32 computeOutsideMask(const BatchPlane* planes, U32 planeCount, U32 offset) const
+	{
+		using Vec = typename TSimd::Vec;
+		constexpr U32 kAllLanes = (1u << TSimd::kWidth) - 1;
+
+		Vec center[3];
+		Vec extend[3];
+		Vec rot[9];
+		for(U32 i = 0; i < 3; ++i)
+		{
+			center[i] = TSimd::load(m_center[i] + offset);
+			extend[i] = TSimd::load(m_extend[i] + offset);
+		}
+
+		for(U32 i = 0; i < 9; ++i)
+		{
+			rot[i] = TSimd::load(m_rotation[i] + offset);
+		}
+
+		U32 outside = 0;
+		for(U32 p = 0; p < planeCount && outside != kAllLanes; ++p)
+		{
+			const BatchPlane& plane = planes[p];
+			const Vec nx = TSimd::set1(plane.m_normal[0]);
+			const Vec ny = TSimd::set1(plane.m_normal[1]);
+			const Vec nz = TSimd::set1(plane.m_normal[2]);
+
+			// The extent of the box along the normal. Transform the normal to the box space to compute it
+			Vec radius = TSimd::set1(0.0f);
+			for(U32 i = 0; i < 3; ++i)
+			{
+				const Vec localNormal = TSimd::madd(rot[i], nx, TSimd::madd(rot[3 + i], ny, TSimd::mul(rot[6 + i], nz)));
+				radius = TSimd::add(radius, TSimd::abs(TSimd::mul(extend[i], localNormal)));
+			}
+
+			Vec dist = TSimd::add(radius, TSimd::set1(-plane.m_offset));
+			dist = TSimd::madd(nx, center[0], dist);
+			dist = TSimd::madd(ny, center[1], dist);
+			dist = TSimd::madd(nz, center[2], dist);
+
+			outside |= TSimd::negativeMask(dist);
+		}
+
+		return outside;
+	}
+};
+
+/// Test the shapes from begin to end (or as many as fit in whole registers) and set the bits of the ones that are inside.
+/// @return Where it stopped.
+template<typename TSimd, typename TShapes>
+U32 insidePlanesKernel(const BatchPlane* planes, U32 planeCount, const TShapes& shapes, U32 begin, U32 end, U32* insideMask)
+{
+	constexpr U32 kWidth = TSimd::kWidth;
+	constexpr U32 kAllLanes = (1u << kWidth) - 1;
+	static_assert(32 % kWidth == 0, "The lanes of a register shouldn't cross mask words");
+
+	U32 i = begin;
+	for(; i + kWidth <= end; i += kWidth)
+	{
+		const U32 outside = shapes.template computeOutsideMask<TSimd>(planes, planeCount, i);
+		insideMask[i / 32] |= (~outside & kAllLanes) << (i % 32);
+	}
+
+	return i;
+}
+
+#if ANKI_COLLISION_AVX2
+// Defined in FunctionsBatchAvx2.cpp
+U32 insidePlanesAvx2(const BatchPlane* planes, U32 planeCount, const BatchAabbs& aabbs, U32 count, U32* insideMask);
+U32 insidePlanesAvx2(const BatchPlane* planes, U32 planeCount, const BatchSpheres& spheres, U32 count, U32* insideMask);
+U32 insidePlanesAvx2(const BatchPlane* planes, U32 planeCount, const BatchObbs& obbs, U32 count, U32* insideMask);
+#endif
+/// @}
+
+} // end namespace anki
@@ -330,7 +330,7 @@ Error App::initInternal()
 	g_dataPathsCVar.set(shadersPath);
 #endif
 
-	ANKI_CHECK(ResourceManager::allocateSingleton().init(allocCb, allocCbUserData));
+	ANKI_CHECK(ResourceManager::allocateSingleton().init(allocCb, allocCbUserData, m_cacheDir));
 
 	//
 	// UI
@@ -470,6 +470,7 @@ Error App::mainLoop()
 			GpuSceneBuffer::getSingleton().endFrame();
 			GpuVisibleTransientMemoryPool::getSingleton().endFrame();
 			GpuReadbackMemoryPool::getSingleton().endFrame();
+			ResourceManager::getSingleton().endFrame();
 
 			// Sleep
 			const Second endTime = HighRezTimer::getCurrentTime();
@@ -32,6 +32,9 @@ private:
 	~CoreMemoryPool() = default;
 };
 
+/// The single set of pinned worker threads of the engine. Everything that goes wide (the scene, the renderer, the TaskGraph, ThreadHive
+/// and ThreadPool) should use these workers instead of creating its own. The only threads that live outside of it are the ones that
+/// block for long: The AsyncLoader's (they wait for I/O and would starve the workers), the tracer's and the stdin listener's.
 class CoreThreadJobManager : public ThreadJobManager, public MakeSingleton<CoreThreadJobManager>
 {
 	template<typename>
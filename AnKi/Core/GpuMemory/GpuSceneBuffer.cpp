@@ -19,6 +19,10 @@ static StatCounter g_gpuSceneBufferTotalStatVar(StatCategory::kGpuMem, "GPU scen
 static StatCounter g_gpuSceneBufferFragmentationStatVar(StatCategory::kGpuMem, "GPU scene fragmentation",
 														StatFlag::kFloat | StatFlag::kMainThreadUpdates);
 
+static StatCounter g_gpuSceneMicroPatchesStatVar(StatCategory::kGpuMem, "GPU scene patches", StatFlag::kZeroEveryFrame);
+static StatCounter g_gpuSceneCoalescedMicroPatchesStatVar(StatCategory::kGpuMem, "GPU scene patches coalesced", StatFlag::kZeroEveryFrame);
+static StatCounter g_gpuSceneMicroPatchUploadStatVar(StatCategory::kGpuMem, "GPU scene patch upload", StatFlag::kBytes | StatFlag::kZeroEveryFrame);
+
 static NumericCVar<PtrSize> g_gpuSceneInitialSizeCVar(CVarSubsystem::kCore, "GpuSceneInitialSize", 64_MB, 16_MB, 2_GB,
 													  "Global memory for the GPU scene");
 
@@ -56,13 +60,49 @@ public:
 	U32 m_dstDwordOffset;
 };
 
+/// A copy as it was requested by newCopy.
+class GpuSceneMicroPatcher::Copy
+{
+public:
+	U32 m_dstDwordOffset;
+	U32 m_dwordCount;
+	U32 m_srcDwordOffset; ///< Offset in the ThreadLocal::m_data.
+	U32 m_order; ///< The global order of the copy. If copies overlap the latest wins.
+};
+
+/// The copies of a single thread for the current frame.
+class alignas(ANKI_CACHE_LINE_SIZE) GpuSceneMicroPatcher::ThreadLocal
+{
+public:
+	DynamicArray<Copy, MemoryPoolPtrWrapper<StackMemoryPool>> m_copies;
+	DynamicArray<U32, MemoryPoolPtrWrapper<StackMemoryPool>> m_data;
+};
+
+thread_local GpuSceneMicroPatcher::ThreadLocal* GpuSceneMicroPatcher::m_threadLocal = nullptr;
+thread_local U32 GpuSceneMicroPatcher::m_threadLocalOwnerUuid = 0;
+
+static Atomic<U32> g_gpuSceneMicroPatcherUuid = {0};
+
 GpuSceneMicroPatcher::GpuSceneMicroPatcher()
+	: m_uuid(g_gpuSceneMicroPatcherUuid.fetchAdd(1) + 1)
 {
 }
 
 GpuSceneMicroPatcher::~GpuSceneMicroPatcher()
 {
 	static_assert(sizeof(PatchHeader) == 8);
+
+	for(ThreadLocal* tlocal : m_allThreadLocals)
+	{
+		// The arrays point to frame memory, don't free it
+		Copy* copies;
+		U32* data;
+		U32 size, storage;
+		tlocal->m_copies.moveAndReset(copies, size, storage);
+		tlocal->m_data.moveAndReset(data, size, storage);
+
+		deleteInstance(CoreMemoryPool::getSingleton(), tlocal);
+	}
 }
 
 Error GpuSceneMicroPatcher::init()
@@ -75,66 +115,167 @@ Error GpuSceneMicroPatcher::init()
 	return Error::kNone;
 }
 
+GpuSceneMicroPatcher::ThreadLocal& GpuSceneMicroPatcher::getThreadLocal()
+{
+	// Check the owner as well because the thread local might belong to a previous instance of the singleton
+	ThreadLocal* out = m_threadLocal;
+	if(out == nullptr || m_threadLocalOwnerUuid != m_uuid) [[unlikely]]
+	{
+		out = newInstance<ThreadLocal>(CoreMemoryPool::getSingleton());
+		m_threadLocal = out;
+		m_threadLocalOwnerUuid = m_uuid;
+
+		LockGuard lock(m_allThreadLocalsMtx);
+		m_allThreadLocals.emplaceBack(out);
+	}
+
+	return *out;
+}
+
 void GpuSceneMicroPatcher::newCopy(StackMemoryPool& frameCpuPool, PtrSize gpuSceneDestOffset, PtrSize dataSize, const void* data)
 {
 	ANKI_ASSERT(dataSize > 0 && (dataSize % 4) == 0);
 	ANKI_ASSERT((ptrToNumber(data) % 4) == 0);
 	ANKI_ASSERT((gpuSceneDestOffset % 4) == 0 && gpuSceneDestOffset / 4 < kMaxU32);
 
-	const U32 dataDwords = U32(dataSize / 4);
-	U32 gpuSceneDestDwordOffset = U32(gpuSceneDestOffset / 4);
-
-	const U32* patchIt = static_cast<const U32*>(data);
-	const U32* const patchEnd = patchIt + dataDwords;
+	ThreadLocal& tlocal = getThreadLocal();
 
-	// Break the data into multiple copies
-	LockGuard lock(m_mtx);
-
-	if(m_crntFramePatchHeaders.getSize() == 0)
+	if(tlocal.m_copies.getSize() == 0)
 	{
-		m_crntFramePatchHeaders = DynamicArray<PatchHeader, MemoryPoolPtrWrapper<StackMemoryPool>>(&frameCpuPool);
-		m_crntFramePatchData = DynamicArray<U32, MemoryPoolPtrWrapper<StackMemoryPool>>(&frameCpuPool);
+		tlocal.m_copies = DynamicArray<Copy, MemoryPoolPtrWrapper<StackMemoryPool>>(&frameCpuPool);
+		tlocal.m_data = DynamicArray<U32, MemoryPoolPtrWrapper<StackMemoryPool>>(&frameCpuPool);
 	}
 
-	while(patchIt < patchEnd)
-	{
-		const U32 patchDwords = min(kDwordsPerPatch, U32(patchEnd - patchIt));
-
-		PatchHeader& header = *m_crntFramePatchHeaders.emplaceBack();
-		ANKI_ASSERT(((patchDwords - 1) & 0b111111) == (patchDwords - 1));
-		header.m_dwordCountAndSrcDwordOffsetPack = patchDwords - 1;
-		header.m_dwordCountAndSrcDwordOffsetPack <<= 26;
-		ANKI_ASSERT((m_crntFramePatchData.getSize() & 0x3FFFFFF) == m_crntFramePatchData.getSize());
-		header.m_dwordCountAndSrcDwordOffsetPack |= m_crntFramePatchData.getSize();
-		header.m_dstDwordOffset = gpuSceneDestDwordOffset;
-
-		const U32 srcOffset = m_crntFramePatchData.getSize();
-		m_crntFramePatchData.resize(srcOffset + patchDwords);
-		memcpy(&m_crntFramePatchData[srcOffset], patchIt, patchDwords * 4);
-
-		patchIt += patchDwords;
-		gpuSceneDestDwordOffset += patchDwords;
-	}
+	Copy& copy = *tlocal.m_copies.emplaceBack();
+	copy.m_dstDwordOffset = U32(gpuSceneDestOffset / 4);
+	copy.m_dwordCount = U32(dataSize / 4);
+	copy.m_srcDwordOffset = tlocal.m_data.getSize();
+	copy.m_order = m_crntFrameCopyCount.fetchAdd(1);
+
+	tlocal.m_data.resize(copy.m_srcDwordOffset + copy.m_dwordCount);
+	memcpy(&tlocal.m_data[copy.m_srcDwordOffset], data, dataSize);
 }
 
 void GpuSceneMicroPatcher::patchGpuScene(CommandBuffer& cmdb)
 {
-	if(m_crntFramePatchHeaders.getSize() == 0)
+	const U32 copyCount = m_crntFrameCopyCount.load();
+	if(copyCount == 0)
 	{
 		return;
 	}
 
-	ANKI_ASSERT(m_crntFramePatchData.getSize() > 0);
+	ANKI_TRACE_SCOPED_EVENT(GpuSceneMicroPatching);
+
+	// Gather the copies of all threads. Use the frame memory of the copies for the temporary data
+	class GatheredCopy
+	{
+	public:
+		const U32* m_data;
+		U32 m_dstDwordOffset;
+		U32 m_dwordCount;
+		U32 m_order;
+	};
+
+	StackMemoryPool* framePool = nullptr;
+	for(ThreadLocal* tlocal : m_allThreadLocals)
+	{
+		if(tlocal->m_copies.getSize())
+		{
+			framePool = &static_cast<StackMemoryPool&>(tlocal->m_copies.getMemoryPool());
+			break;
+		}
+	}
+	ANKI_ASSERT(framePool);
+
+	DynamicArray<GatheredCopy, MemoryPoolPtrWrapper<StackMemoryPool>> copies(framePool);
+	copies.resizeStorage(copyCount);
+	U32 totalDwordCount = 0;
+	U32 uncoalescedPatchCount = 0;
+	for(ThreadLocal* tlocal : m_allThreadLocals)
+	{
+		for(const Copy& copy : tlocal->m_copies)
+		{
+			GatheredCopy& gathered = *copies.emplaceBack();
+			gathered.m_data = &tlocal->m_data[copy.m_srcDwordOffset];
+			gathered.m_dstDwordOffset = copy.m_dstDwordOffset;
+			gathered.m_dwordCount = copy.m_dwordCount;
+			gathered.m_order = copy.m_order;
+
+			totalDwordCount += copy.m_dwordCount;
+			uncoalescedPatchCount += (copy.m_dwordCount + kDwordsPerPatch - 1) / kDwordsPerPatch;
+		}
+	}
+	ANKI_ASSERT(copies.getSize() == copyCount);
+
+	// Sort by destination. Copies that overlap or touch form a range that will be uploaded as one
+	std::sort(copies.getBegin(), copies.getEnd(), [](const GatheredCopy& a, const GatheredCopy& b) {
+		return (a.m_dstDwordOffset != b.m_dstDwordOffset) ? a.m_dstDwordOffset < b.m_dstDwordOffset : a.m_order < b.m_order;
+	});
+
+	DynamicArray<PatchHeader, MemoryPoolPtrWrapper<StackMemoryPool>> headers(framePool);
+	headers.resizeStorage(uncoalescedPatchCount);
+	DynamicArray<U32, MemoryPoolPtrWrapper<StackMemoryPool>> data(framePool);
+	data.resizeStorage(totalDwordCount);
+
+	U32 rangeBegin = 0;
+	while(rangeBegin < copyCount)
+	{
+		const U32 rangeDstBegin = copies[rangeBegin].m_dstDwordOffset;
+		U32 rangeDstEnd = rangeDstBegin + copies[rangeBegin].m_dwordCount;
+		Bool overlapping = false;
+		U32 rangeEnd = rangeBegin + 1;
+		while(rangeEnd < copyCount && copies[rangeEnd].m_dstDwordOffset <= rangeDstEnd)
+		{
+			overlapping = overlapping || copies[rangeEnd].m_dstDwordOffset < rangeDstEnd;
+			rangeDstEnd = max(rangeDstEnd, copies[rangeEnd].m_dstDwordOffset + copies[rangeEnd].m_dwordCount);
+			++rangeEnd;
+		}
+
+		// Write the copies of the range in the order they were requested so the latest wins
+		if(overlapping)
+		{
+			std::sort(copies.getBegin() + rangeBegin, copies.getBegin() + rangeEnd, [](const GatheredCopy& a, const GatheredCopy& b) {
+				return a.m_order < b.m_order;
+			});
+		}
+
+		const U32 srcDwordOffset = data.getSize();
+		data.resize(srcDwordOffset + rangeDstEnd - rangeDstBegin);
+		for(U32 i = rangeBegin; i < rangeEnd; ++i)
+		{
+			const GatheredCopy& copy = copies[i];
+			memcpy(&data[srcDwordOffset + copy.m_dstDwordOffset - rangeDstBegin], copy.m_data, copy.m_dwordCount * sizeof(U32));
+		}
+
+		// Break the range into multiple patches
+		for(U32 dwordOffset = 0; dwordOffset < rangeDstEnd - rangeDstBegin; dwordOffset += kDwordsPerPatch)
+		{
+			const U32 patchDwords = min(kDwordsPerPatch, rangeDstEnd - rangeDstBegin - dwordOffset);
+
+			PatchHeader& header = *headers.emplaceBack();
+			ANKI_ASSERT(((patchDwords - 1) & 0b111111) == (patchDwords - 1));
+			header.m_dwordCountAndSrcDwordOffsetPack = patchDwords - 1;
+			header.m_dwordCountAndSrcDwordOffsetPack <<= 26;
+			ANKI_ASSERT(((srcDwordOffset + dwordOffset) & 0x3FFFFFF) == srcDwordOffset + dwordOffset);
+			header.m_dwordCountAndSrcDwordOffsetPack |= srcDwordOffset + dwordOffset;
+			header.m_dstDwordOffset = rangeDstBegin + dwordOffset;
+		}
+
+		rangeBegin = rangeEnd;
+	}
 
-	ANKI_TRACE_INC_COUNTER(GpuSceneMicroPatches, m_crntFramePatchHeaders.getSize());
-	ANKI_TRACE_INC_COUNTER(GpuSceneMicroPatchUploadData, m_crntFramePatchData.getSizeInBytes());
+	ANKI_TRACE_INC_COUNTER(GpuSceneMicroPatches, headers.getSize());
+	ANKI_TRACE_INC_COUNTER(GpuSceneMicroPatchUploadData, data.getSizeInBytes());
+	g_gpuSceneMicroPatchesStatVar.increment(uncoalescedPatchCount);
+	g_gpuSceneCoalescedMicroPatchesStatVar.increment(headers.getSize());
+	g_gpuSceneMicroPatchUploadStatVar.increment(data.getSizeInBytes());
 
 	void* mapped;
-	const RebarAllocation headersToken = RebarTransientMemoryPool::getSingleton().allocateFrame(m_crntFramePatchHeaders.getSizeInBytes(), mapped);
-	memcpy(mapped, &m_crntFramePatchHeaders[0], m_crntFramePatchHeaders.getSizeInBytes());
+	const RebarAllocation headersToken = RebarTransientMemoryPool::getSingleton().allocateFrame(headers.getSizeInBytes(), mapped);
+	memcpy(mapped, &headers[0], headers.getSizeInBytes());
 
-	const RebarAllocation dataToken = RebarTransientMemoryPool::getSingleton().allocateFrame(m_crntFramePatchData.getSizeInBytes(), mapped);
-	memcpy(mapped, &m_crntFramePatchData[0], m_crntFramePatchData.getSizeInBytes());
+	const RebarAllocation dataToken = RebarTransientMemoryPool::getSingleton().allocateFrame(data.getSizeInBytes(), mapped);
+	memcpy(mapped, &data[0], data.getSizeInBytes());
 
 	cmdb.bindUavBuffer(0, 0, headersToken);
 	cmdb.bindUavBuffer(0, 1, dataToken);
@@ -142,15 +283,29 @@ void GpuSceneMicroPatcher::patchGpuScene(CommandBuffer& cmdb)
 
 	cmdb.bindShaderProgram(m_grProgram.get());
 
-	const U32 workgroupCountX = m_crntFramePatchHeaders.getSize();
+	const U32 workgroupCountX = headers.getSize();
 	cmdb.dispatchCompute(workgroupCountX, 1, 1);
 
-	// Cleanup to prepare for the new frame
-	U32* data;
+	// Cleanup to prepare for the new frame. The memory is frame memory so don't free it
 	U32 size, storage;
-	m_crntFramePatchData.moveAndReset(data, size, storage);
-	PatchHeader* datah;
-	m_crntFramePatchHeaders.moveAndReset(datah, size, storage);
+	{
+		U32* mem;
+		data.moveAndReset(mem, size, storage);
+		PatchHeader* memh;
+		headers.moveAndReset(memh, size, storage);
+		GatheredCopy* memc;
+		copies.moveAndReset(memc, size, storage);
+	}
+
+	for(ThreadLocal* tlocal : m_allThreadLocals)
+	{
+		Copy* mem;
+		tlocal->m_copies.moveAndReset(mem, size, storage);
+		U32* memd;
+		tlocal->m_data.moveAndReset(memd, size, storage);
+	}
+
+	m_crntFrameCopyCount.store(0);
 }
 
 } // end namespace anki
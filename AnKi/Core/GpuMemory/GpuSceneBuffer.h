@@ -121,7 +121,8 @@ inline GpuSceneBufferAllocation::~GpuSceneBufferAllocation()
 	GpuSceneBuffer::getSingleton().deferredFree(*this);
 }
 
-/// Creates the copy jobs that will patch the GPU Scene.
+/// Creates the copy jobs that will patch the GPU Scene. Every thread writes its copies to its own stream so newCopy() doesn't lock. The
+/// streams are merged in patchGpuScene(). Copies that overlap or touch are coalesced into one and when they overlap the latest copy wins.
 class GpuSceneMicroPatcher : public MakeSingleton<GpuSceneMicroPatcher>
 {
 	template<typename>
@@ -135,7 +136,7 @@ public:
 	Error init();
 
 	/// Copy data for the GPU scene to a staging buffer.
-	/// @note It's thread-safe.
+	/// @note It's thread-safe and lock-free (after the 1st call of every thread).
 	void newCopy(StackMemoryPool& frameCpuPool, PtrSize gpuSceneDestOffset, PtrSize dataSize, const void* data);
 
 	template<typename T>
@@ -163,7 +164,7 @@ public:
 	/// @note Not thread-safe. Nothing else should be happening before calling it.
 	Bool patchingIsNeeded() const
 	{
-		return m_crntFramePatchHeaders.getSize() > 0;
+		return m_crntFrameCopyCount.load() > 0;
 	}
 
 	/// Copy the data to the GPU scene buffer.
@@ -174,10 +175,18 @@ private:
 	static constexpr U32 kDwordsPerPatch = 64;
 
 	class PatchHeader;
+	class Copy;
+	class ThreadLocal;
 
-	DynamicArray<PatchHeader, MemoryPoolPtrWrapper<StackMemoryPool>> m_crntFramePatchHeaders;
-	DynamicArray<U32, MemoryPoolPtrWrapper<StackMemoryPool>> m_crntFramePatchData;
-	Mutex m_mtx;
+	static thread_local ThreadLocal* m_threadLocal;
+	static thread_local U32 m_threadLocalOwnerUuid; ///< The m_uuid of the patcher that created the m_threadLocal.
+
+	U32 m_uuid;
+
+	CoreDynamicArray<ThreadLocal*> m_allThreadLocals;
+	Mutex m_allThreadLocalsMtx;
+
+	Atomic<U32> m_crntFrameCopyCount = {0}; ///< Also gives the order of the copies.
 
 	ShaderProgramResourcePtr m_copyProgram;
 	ShaderProgramPtr m_grProgram;
@@ -185,6 +194,8 @@ private:
 	GpuSceneMicroPatcher();
 
 	~GpuSceneMicroPatcher();
+
+	ThreadLocal& getThreadLocal();
 };
 /// @}
 
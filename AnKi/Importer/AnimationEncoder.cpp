@@ -0,0 +1,305 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Importer/AnimationEncoder.h>
+#include <AnKi/Resource/AnimationBinary.h>
+#include <AnKi/Util/File.h>
+
+namespace anki {
+
+/// Checking if a key can be removed gets more expensive the more keys were removed before it. Keep at least a key every that many.
+constexpr U32 kMaxReducedKeySpan = 128;
+
+/// Pick the keys to keep. A key is removed if it and all the keys removed since the last kept key can be reconstructed by interpolating the
+/// kept keys around them. It compares against the original keys so the error doesn't accumulate.
+/// @param[out] keptKeys The indices of the keys to keep. Empty if the track is the identity.
+template<typename T, typename TErrorFunc, typename TInterpolateFunc>
+static void reduceKeys(ConstWeakArray<AnimationEncoderKey<T>> keys, const T& identity, Bool reduce, F32 maxError, TErrorFunc errorFunc,
+					   TInterpolateFunc interpolateFunc, ImporterDynamicArray<U32>& keptKeys)
+{
+	ANKI_ASSERT(keys.getSize() > 1);
+
+	Bool isIdentity = true;
+	Bool isConstant = true;
+	for(const AnimationEncoderKey<T>& key : keys)
+	{
+		isIdentity = isIdentity && errorFunc(key.m_value, identity) <= maxError;
+		isConstant = isConstant && errorFunc(key.m_value, keys[0].m_value) <= maxError;
+	}
+
+	if(isIdentity)
+	{
+		return;
+	}
+
+	keptKeys.emplaceBack(0);
+
+	if(!reduce)
+	{
+		for(U32 i = 1; i < keys.getSize() - 1; ++i)
+		{
+			keptKeys.emplaceBack(i);
+		}
+	}
+	else if(!isConstant)
+	{
+		U32 anchor = 0;
+		for(U32 end = 2; end < keys.getSize(); ++end)
+		{
+			const AnimationEncoderKey<T>& left = keys[anchor];
+			const AnimationEncoderKey<T>& right = keys[end];
+
+			Bool canRemove = end - anchor <= kMaxReducedKeySpan;
+			for(U32 k = anchor + 1; canRemove && k < end; ++k)
+			{
+				const F32 u = F32((keys[k].m_time - left.m_time) / (right.m_time - left.m_time));
+				canRemove = errorFunc(interpolateFunc(left.m_value, right.m_value, u), keys[k].m_value) <= maxError;
+			}
+
+			if(!canRemove)
+			{
+				anchor = end - 1;
+				keptKeys.emplaceBack(anchor);
+			}
+		}
+	}
+
+	keptKeys.emplaceBack(keys.getSize() - 1);
+}
+
+namespace {
+
+/// Builds the data part of the file.
+class AnimationDataBuilder
+{
+public:
+	ImporterDynamicArrayLarge<U8> m_data;
+
+	AnimationDataBuilder(BaseMemoryPool* pool)
+		: m_data(pool)
+	{
+	}
+
+	U32 append(const void* data, PtrSize size)
+	{
+		const PtrSize offset = m_data.getSize();
+		m_data.resize(getAlignedRoundUp(kAnimationBinaryDataAlignment, offset + size), U8(0));
+		memcpy(&m_data[offset], data, size);
+		return U32(offset);
+	}
+};
+
+} // namespace
+
+template<typename T, typename TErrorFunc, typename TInterpolateFunc, typename TQuantizeFunc>
+static Error encodeTrack(BaseMemoryPool& pool, CString channelName, ConstWeakArray<AnimationEncoderKey<T>> keys, const T& identity, Bool reduce,
+						 F32 maxError, TErrorFunc errorFunc, TInterpolateFunc interpolateFunc, TQuantizeFunc quantizeFunc, AnimationDataBuilder& data,
+						 ImporterDynamicArray<ImporterDynamicArray<F32>>& channelTimes, ImporterDynamicArray<U32>& channelTimeOffsets,
+						 AnimationBinaryTrack& out, AnimationEncoderStats& stats)
+{
+	memset(&out, 0, sizeof(out));
+	stats.m_inputKeyCount += keys.getSize();
+
+	if(keys.getSize() < 2)
+	{
+		// Sampling ignores tracks with less than 2 keys
+		return Error::kNone;
+	}
+
+	for(U32 i = 1; i < keys.getSize(); ++i)
+	{
+		if(!(F32(keys[i].m_time) > F32(keys[i - 1].m_time)))
+		{
+			ANKI_IMPORTER_LOGE("The key times of the channel %s are not increasing", channelName.cstr());
+			return Error::kUserData;
+		}
+	}
+
+	ImporterDynamicArray<U32> keptKeys(&pool);
+	reduceKeys(keys, identity, reduce, maxError, errorFunc, interpolateFunc, keptKeys);
+	if(keptKeys.getSize() == 0)
+	{
+		return Error::kNone;
+	}
+
+	out.m_keyCount = keptKeys.getSize();
+	stats.m_outputKeyCount += keptKeys.getSize();
+
+	// Times. Share them with the other tracks of the channel if they are the same
+	ImporterDynamicArray<F32> times(&pool);
+	times.resize(keptKeys.getSize());
+	for(U32 i = 0; i < keptKeys.getSize(); ++i)
+	{
+		times[i] = F32(keys[keptKeys[i]].m_time);
+	}
+
+	out.m_timesOffset = kMaxU32;
+	for(U32 i = 0; i < channelTimes.getSize(); ++i)
+	{
+		if(channelTimes[i].getSize() == times.getSize() && memcmp(&channelTimes[i][0], &times[0], times.getSizeInBytes()) == 0)
+		{
+			out.m_timesOffset = channelTimeOffsets[i];
+			break;
+		}
+	}
+
+	if(out.m_timesOffset == kMaxU32)
+	{
+		out.m_timesOffset = data.append(&times[0], times.getSizeInBytes());
+		channelTimeOffsets.emplaceBack(out.m_timesOffset);
+		channelTimes.emplaceBack(std::move(times));
+	}
+
+	// Values
+	ImporterDynamicArray<U16> values(&pool);
+	quantizeFunc(keys, ConstWeakArray<U32>(keptKeys), out, values);
+	out.m_valuesOffset = data.append(&values[0], values.getSizeInBytes());
+
+	return Error::kNone;
+}
+
+/// Quantize the positions or the scales to 16bit inside their range.
+template<U32 kComponentCount, typename T>
+static void quantizeRange(ConstWeakArray<AnimationEncoderKey<T>> keys, ConstWeakArray<U32> keptKeys, AnimationBinaryTrack& out,
+						  ImporterDynamicArray<U16>& values)
+{
+	auto getComponent = [&](U32 key, U32 c) -> F32 {
+		if constexpr(kComponentCount == 1)
+		{
+			return keys[key].m_value;
+		}
+		else
+		{
+			return keys[key].m_value[c];
+		}
+	};
+
+	Vec3 minVal(kMaxF32);
+	Vec3 maxVal(kMinF32);
+	for(U32 key : keptKeys)
+	{
+		for(U32 c = 0; c < kComponentCount; ++c)
+		{
+			minVal[c] = min(minVal[c], getComponent(key, c));
+			maxVal[c] = max(maxVal[c], getComponent(key, c));
+		}
+	}
+
+	out.m_min = Vec3(0.0f);
+	out.m_range = Vec3(0.0f);
+	for(U32 c = 0; c < kComponentCount; ++c)
+	{
+		out.m_min[c] = minVal[c];
+		out.m_range[c] = maxVal[c] - minVal[c];
+	}
+
+	values.resize(keptKeys.getSize() * kComponentCount);
+	for(U32 i = 0; i < keptKeys.getSize(); ++i)
+	{
+		for(U32 c = 0; c < kComponentCount; ++c)
+		{
+			const F32 f = (out.m_range[c] > 0.0f) ? (getComponent(keptKeys[i], c) - out.m_min[c]) / out.m_range[c] : 0.0f;
+			values[i * kComponentCount + c] = U16(std::round(clamp(f, 0.0f, 1.0f) * kAnimationQuantizationMax));
+		}
+	}
+}
+
+Error encodeAnimation(BaseMemoryPool& pool, ConstWeakArray<AnimationEncoderChannel> channels, const AnimationEncoderConfig& config, CString filename,
+					  AnimationEncoderStats* stats)
+{
+	if(channels.getSize() == 0)
+	{
+		ANKI_IMPORTER_LOGE("No channels to encode");
+		return Error::kUserData;
+	}
+
+	AnimationEncoderStats localStats;
+	AnimationDataBuilder data(&pool);
+	ImporterDynamicArray<AnimationBinaryChannel> binChannels(&pool);
+	binChannels.resize(channels.getSize());
+
+	for(U32 i = 0; i < channels.getSize(); ++i)
+	{
+		const AnimationEncoderChannel& inChannel = channels[i];
+		AnimationBinaryChannel& outChannel = binChannels[i];
+
+		outChannel.m_nameLength = inChannel.m_name.getLength();
+		outChannel.m_nameOffset = data.append(inChannel.m_name.cstr(), outChannel.m_nameLength + 1);
+
+		ImporterDynamicArray<ImporterDynamicArray<F32>> channelTimes(&pool);
+		ImporterDynamicArray<U32> channelTimeOffsets(&pool);
+
+		ANKI_CHECK(encodeTrack(
+			pool, inChannel.m_name, inChannel.m_positions, Vec3(0.0f), config.m_reduceKeys, config.m_positionError,
+			[](const Vec3& a, const Vec3& b) {
+				return (a - b).getLength();
+			},
+			[](const Vec3& a, const Vec3& b, F32 u) {
+				return linearInterpolate(a, b, u);
+			},
+			quantizeRange<3, Vec3>, data, channelTimes, channelTimeOffsets, outChannel.m_positions, localStats));
+
+		ANKI_CHECK(encodeTrack(
+			pool, inChannel.m_name, inChannel.m_rotations, Quat::getIdentity(), config.m_reduceKeys, config.m_rotationError,
+			[](const Quat& a, const Quat& b) {
+				// The angle between the 2 rotations. Compute it from the chord between the quaternions since acos() is imprecise near 1
+				const Vec4 va(a.x(), a.y(), a.z(), a.w());
+				const Vec4 vb(b.x(), b.y(), b.z(), b.w());
+				const F32 chord = sqrt(min((va - vb).getLengthSquared(), (va + vb).getLengthSquared()));
+				return 4.0f * asin(min(chord * 0.5f, 1.0f));
+			},
+			[](const Quat& a, const Quat& b, F32 u) {
+				return a.slerp(b, u);
+			},
+			[](ConstWeakArray<AnimationEncoderKey<Quat>> keys, ConstWeakArray<U32> keptKeys, [[maybe_unused]] AnimationBinaryTrack& out,
+			   ImporterDynamicArray<U16>& values) {
+				values.resize(keptKeys.getSize() * 3);
+				for(U32 k = 0; k < keptKeys.getSize(); ++k)
+				{
+					Quat q = keys[keptKeys[k]].m_value;
+					q.normalize();
+					const Array<U16, 3> packed = quantizeAnimationRotation(q);
+					memcpy(&values[k * 3], &packed[0], sizeof(packed));
+				}
+			},
+			data, channelTimes, channelTimeOffsets, outChannel.m_rotations, localStats));
+
+		ANKI_CHECK(encodeTrack(
+			pool, inChannel.m_name, inChannel.m_scales, 1.0f, config.m_reduceKeys, config.m_scaleError,
+			[](F32 a, F32 b) {
+				return absolute(a - b);
+			},
+			[](F32 a, F32 b, F32 u) {
+				return linearInterpolate(a, b, u);
+			},
+			quantizeRange<1, F32>, data, channelTimes, channelTimeOffsets, outChannel.m_scales, localStats));
+	}
+
+	// Write the file
+	AnimationBinaryHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(&header.m_magic[0], kAnimationMagic, sizeof(header.m_magic));
+	header.m_channelCount = binChannels.getSize();
+	header.m_dataSize = U32(data.m_data.getSize());
+
+	File file;
+	ANKI_CHECK(file.open(filename, FileOpenFlag::kWrite | FileOpenFlag::kBinary));
+	ANKI_CHECK(file.write(&header, sizeof(header)));
+	ANKI_CHECK(file.write(&binChannels[0], binChannels.getSizeInBytes()));
+	if(data.m_data.getSize())
+	{
+		ANKI_CHECK(file.write(&data.m_data[0], data.m_data.getSize()));
+	}
+
+	localStats.m_fileSize = sizeof(header) + binChannels.getSizeInBytes() + data.m_data.getSize();
+	if(stats)
+	{
+		*stats = localStats;
+	}
+
+	return Error::kNone;
+}
+
+} // end namespace anki
@@ -0,0 +1,64 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Importer/Common.h>
+#include <AnKi/Util/WeakArray.h>
+#include <AnKi/Math.h>
+
+namespace anki {
+
+/// @addtogroup importer
+/// @{
+
+/// A keyframe of an animation before it's encoded.
+template<typename T>
+class AnimationEncoderKey
+{
+public:
+	Second m_time;
+	T m_value;
+};
+
+/// The keys of a node before they are encoded. The times of the keys should be increasing. All the keys are optional.
+class AnimationEncoderChannel
+{
+public:
+	CString m_name;
+	ConstWeakArray<AnimationEncoderKey<Vec3>> m_positions;
+	ConstWeakArray<AnimationEncoderKey<Quat>> m_rotations;
+	ConstWeakArray<AnimationEncoderKey<F32>> m_scales;
+};
+
+/// Options of encodeAnimation().
+class AnimationEncoderConfig
+{
+public:
+	/// Remove the keys that can be reconstructed from the keys around them within the error bounds below.
+	Bool m_reduceKeys = true;
+
+	F32 m_positionError = 0.1_mm;
+	F32 m_rotationError = 0.001f; ///< In radians.
+	F32 m_scaleError = 0.0001f;
+};
+
+/// Info about the outcome of encodeAnimation().
+class AnimationEncoderStats
+{
+public:
+	U32 m_inputKeyCount = 0;
+	U32 m_outputKeyCount = 0;
+	PtrSize m_fileSize = 0;
+};
+
+/// Reduce the keys of an animation, quantize them and write them to an .ankianim (see AnimationBinary.h). Tracks that stay within the error
+/// bounds of the identity are dropped. The quantization adds its own error on top of the error bounds of the key reduction. It's 1/131070
+/// of the range of the positions and scales of a track and less than 0.01 degrees for the rotations.
+Error encodeAnimation(BaseMemoryPool& pool, ConstWeakArray<AnimationEncoderChannel> channels, const AnimationEncoderConfig& config, CString filename,
+					  AnimationEncoderStats* stats = nullptr);
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,465 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Importer/BcEncoder.h>
+#include <AnKi/Util/ThreadJobManager.h>
+#include <AnKi/Math.h>
+
+namespace anki {
+
+/// The texels of a block. Every texel is a Vec4 so the math maps to SIMD registers.
+using BcBlockTexels = Array<Vec4, 16>;
+
+/// Roughly how many blocks a task compresses.
+constexpr U32 kBcBlocksPerTask = 1024;
+
+static void loadBlock(ConstWeakArray<U8, PtrSize> inPixels, U32 width, U32 channelCount, U32 blockX, U32 blockY, BcBlockTexels& texels)
+{
+	for(U32 y = 0; y < 4; ++y)
+	{
+		for(U32 x = 0; x < 4; ++x)
+		{
+			const U8* in = &inPixels[(PtrSize(blockY * 4 + y) * width + blockX * 4 + x) * channelCount];
+			Vec4 texel(0.0f, 0.0f, 0.0f, 255.0f);
+			for(U32 c = 0; c < channelCount; ++c)
+			{
+				texel[c] = F32(in[c]);
+			}
+
+			texels[y * 4 + x] = texel;
+		}
+	}
+}
+
+static U16 packRgb565(Vec4 color)
+{
+	const Vec4 c = color.clamp(0.0f, 255.0f) * Vec4(31.0f / 255.0f, 63.0f / 255.0f, 31.0f / 255.0f, 0.0f) + 0.5f;
+	return U16((U32(c.x()) << 11) | (U32(c.y()) << 5) | U32(c.z()));
+}
+
+static Vec4 unpackRgb565(U16 color)
+{
+	const U32 r = (color >> 11) & 31;
+	const U32 g = (color >> 5) & 63;
+	const U32 b = color & 31;
+	return Vec4(F32((r << 3) | (r >> 2)), F32((g << 2) | (g >> 4)), F32((b << 3) | (b >> 2)), 0.0f);
+}
+
+static void writeU16(U16 value, U8* out)
+{
+	out[0] = U8(value & 0xFF);
+	out[1] = U8(value >> 8);
+}
+
+static U16 readU16(const U8* in)
+{
+	return U16(in[0] | (in[1] << 8));
+}
+
+/// Encode the RGB of a block into a BC1 color block. It fits the endpoints on the principal axis of the colors and then refines them with
+/// least squares.
+static void encodeBc1Color(const BcBlockTexels& texels, U8* out)
+{
+	Array<Vec4, 16> colors;
+	Vec4 minColor(255.0f);
+	Vec4 maxColor(0.0f);
+	Vec4 mean(0.0f);
+	for(U32 i = 0; i < 16; ++i)
+	{
+		colors[i] = texels[i] * Vec4(1.0f, 1.0f, 1.0f, 0.0f);
+		minColor = minColor.min(colors[i]);
+		maxColor = maxColor.max(colors[i]);
+		mean += colors[i];
+	}
+	mean /= 16.0f;
+
+	Vec4 endpoint0 = maxColor;
+	Vec4 endpoint1 = minColor;
+	if((maxColor - minColor).getLengthSquared() > kEpsilonf)
+	{
+		// Covariance
+		Vec4 covDiag(0.0f); // xx, yy, zz
+		Vec4 covOffDiag(0.0f); // xy, xz, yz
+		for(const Vec4& color : colors)
+		{
+			const Vec4 d = color - mean;
+			covDiag += d * d;
+			covOffDiag += Vec4(d.x(), d.x(), d.y(), 0.0f) * Vec4(d.y(), d.z(), d.z(), 0.0f);
+		}
+
+		// Principal axis with a few power iterations
+		Vec4 axis = maxColor - minColor;
+		for(U32 i = 0; i < 8; ++i)
+		{
+			axis = Vec4(covDiag.x() * axis.x() + covOffDiag.x() * axis.y() + covOffDiag.y() * axis.z(),
+						covOffDiag.x() * axis.x() + covDiag.y() * axis.y() + covOffDiag.z() * axis.z(),
+						covOffDiag.y() * axis.x() + covOffDiag.z() * axis.y() + covDiag.z() * axis.z(), 0.0f);
+
+			const F32 maxComponent = max(absolute(axis.x()), max(absolute(axis.y()), absolute(axis.z())));
+			if(maxComponent < kEpsilonf)
+			{
+				break;
+			}
+			axis /= maxComponent;
+		}
+
+		if(axis.getLengthSquared() < kEpsilonf)
+		{
+			axis = maxColor - minColor;
+		}
+		axis.normalize();
+
+		F32 minT = kMaxF32;
+		F32 maxT = kMinF32;
+		for(const Vec4& color : colors)
+		{
+			const F32 t = (color - mean).dot(axis);
+			minT = min(minT, t);
+			maxT = max(maxT, t);
+		}
+
+		endpoint0 = (mean + axis * maxT).clamp(0.0f, 255.0f);
+		endpoint1 = (mean + axis * minT).clamp(0.0f, 255.0f);
+
+		// Refine. Assign the colors to the palette and solve for the endpoints that minimize the error
+		constexpr Array<F32, 4> kWeights = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+		for(U32 iteration = 0; iteration < 2; ++iteration)
+		{
+			Array<Vec4, 4> palette;
+			for(U32 i = 0; i < 4; ++i)
+			{
+				palette[i] = endpoint0 * (1.0f - kWeights[i]) + endpoint1 * kWeights[i];
+			}
+
+			F32 aa = 0.0f, bb = 0.0f, ab = 0.0f;
+			Vec4 ax(0.0f), bx(0.0f);
+			for(const Vec4& color : colors)
+			{
+				U32 best = 0;
+				F32 bestDist = kMaxF32;
+				for(U32 i = 0; i < 4; ++i)
+				{
+					const F32 dist = (color - palette[i]).getLengthSquared();
+					if(dist < bestDist)
+					{
+						bestDist = dist;
+						best = i;
+					}
+				}
+
+				const F32 beta = kWeights[best];
+				const F32 alpha = 1.0f - beta;
+				aa += alpha * alpha;
+				bb += beta * beta;
+				ab += alpha * beta;
+				ax += color * alpha;
+				bx += color * beta;
+			}
+
+			const F32 det = aa * bb - ab * ab;
+			if(absolute(det) < kEpsilonf)
+			{
+				break;
+			}
+
+			endpoint0 = ((ax * bb - bx * ab) / det).clamp(0.0f, 255.0f);
+			endpoint1 = ((bx * aa - ax * ab) / det).clamp(0.0f, 255.0f);
+		}
+	}
+
+	// Quantize. The 1st endpoint needs to be the larger one for the 4 color mode
+	U16 color0 = packRgb565(endpoint0);
+	U16 color1 = packRgb565(endpoint1);
+	if(color0 < color1)
+	{
+		std::swap(color0, color1);
+	}
+
+	U32 indices = 0;
+	if(color0 != color1)
+	{
+		const Vec4 c0 = unpackRgb565(color0);
+		const Vec4 c1 = unpackRgb565(color1);
+		const Array<Vec4, 4> palette = {c0, c1, (c0 * 2.0f + c1) / 3.0f, (c0 + c1 * 2.0f) / 3.0f};
+
+		for(U32 t = 0; t < 16; ++t)
+		{
+			U32 best = 0;
+			F32 bestDist = kMaxF32;
+			for(U32 i = 0; i < 4; ++i)
+			{
+				const F32 dist = (colors[t] - palette[i]).getLengthSquared();
+				if(dist < bestDist)
+				{
+					bestDist = dist;
+					best = i;
+				}
+			}
+
+			indices |= best << (t * 2);
+		}
+	}
+
+	writeU16(color0, out);
+	writeU16(color1, out + 2);
+	memcpy(out + 4, &indices, sizeof(indices));
+}
+
+/// Compute the 8 values of a BC4 palette.
+static void computeBc4Palette(U32 value0, U32 value1, Array<F32, 8>& palette)
+{
+	palette[0] = F32(value0);
+	palette[1] = F32(value1);
+	if(value0 > value1)
+	{
+		for(U32 i = 1; i < 7; ++i)
+		{
+			palette[i + 1] = (F32(value0) * F32(7 - i) + F32(value1) * F32(i)) / 7.0f;
+		}
+	}
+	else
+	{
+		for(U32 i = 1; i < 5; ++i)
+		{
+			palette[i + 1] = (F32(value0) * F32(5 - i) + F32(value1) * F32(i)) / 5.0f;
+		}
+		palette[6] = 0.0f;
+		palette[7] = 255.0f;
+	}
+}
+
+/// Find the palette entries of the values. Returns the squared error.
+static F32 findBc4Indices(const Array<F32, 16>& values, const Array<F32, 8>& palette, U64& indices)
+{
+	F32 error = 0.0f;
+	indices = 0;
+	for(U32 t = 0; t < 16; ++t)
+	{
+		U64 best = 0;
+		F32 bestDist = kMaxF32;
+		for(U32 i = 0; i < 8; ++i)
+		{
+			const F32 dist = (values[t] - palette[i]) * (values[t] - palette[i]);
+			if(dist < bestDist)
+			{
+				bestDist = dist;
+				best = i;
+			}
+		}
+
+		indices |= best << (t * 3);
+		error += bestDist;
+	}
+
+	return error;
+}
+
+/// Encode one channel of a block into a BC4 block. It tries both the 8 value and the 6 value modes and keeps the best.
+static void encodeBc4(const BcBlockTexels& texels, U32 channel, U8* out)
+{
+	Array<F32, 16> values;
+	U32 minValue = 255, maxValue = 0;
+	U32 minInnerValue = 255, maxInnerValue = 0; // Excluding 0 and 255 that the 6 value mode has for free
+	for(U32 i = 0; i < 16; ++i)
+	{
+		values[i] = texels[i][channel];
+
+		const U32 value = U32(values[i]);
+		minValue = min(minValue, value);
+		maxValue = max(maxValue, value);
+		if(value > 0 && value < 255)
+		{
+			minInnerValue = min(minInnerValue, value);
+			maxInnerValue = max(maxInnerValue, value);
+		}
+	}
+
+	// 8 value mode
+	Array<F32, 8> palette;
+	computeBc4Palette(maxValue, minValue, palette);
+	U64 indices;
+	const F32 error = findBc4Indices(values, palette, indices);
+	U32 value0 = maxValue;
+	U32 value1 = minValue;
+
+	// 6 value mode
+	if(error > 0.0f && minInnerValue <= maxInnerValue)
+	{
+		computeBc4Palette(minInnerValue, maxInnerValue, palette);
+		U64 indices6;
+		if(findBc4Indices(values, palette, indices6) < error)
+		{
+			value0 = minInnerValue;
+			value1 = maxInnerValue;
+			indices = indices6;
+		}
+	}
+
+	out[0] = U8(value0);
+	out[1] = U8(value1);
+	for(U32 i = 0; i < 6; ++i)
+	{
+		out[2 + i] = U8(indices >> (i * 8));
+	}
+}
+
+static void encodeBlock(BcFormat format, const BcBlockTexels& texels, U8* out)
+{
+	switch(format)
+	{
+	case BcFormat::kBc1:
+		encodeBc1Color(texels, out);
+		break;
+	case BcFormat::kBc3:
+		encodeBc4(texels, 3, out);
+		encodeBc1Color(texels, out + 8);
+		break;
+	case BcFormat::kBc4:
+		encodeBc4(texels, 0, out);
+		break;
+	case BcFormat::kBc5:
+		encodeBc4(texels, 0, out);
+		encodeBc4(texels, 1, out + 8);
+		break;
+	default:
+		ANKI_ASSERT(0);
+	}
+}
+
+static void compressBlockRows(BcFormat format, ConstWeakArray<U8, PtrSize> inPixels, U32 width, U32 channelCount, U32 firstBlockRow,
+							  U32 blockRowCount, WeakArray<U8, PtrSize> outBlocks)
+{
+	const U32 blockSize = getBcBlockSize(format);
+	const U32 blockCountX = width / 4;
+	BcBlockTexels texels;
+	for(U32 blockY = firstBlockRow; blockY < firstBlockRow + blockRowCount; ++blockY)
+	{
+		for(U32 blockX = 0; blockX < blockCountX; ++blockX)
+		{
+			loadBlock(inPixels, width, channelCount, blockX, blockY, texels);
+			encodeBlock(format, texels, &outBlocks[(PtrSize(blockY) * blockCountX + blockX) * blockSize]);
+		}
+	}
+}
+
+void compressBc(BcFormat format, ConstWeakArray<U8, PtrSize> inPixels, U32 width, U32 height, U32 channelCount, WeakArray<U8, PtrSize> outBlocks,
+				ThreadJobManager* jobManager, ThreadJobCounter* counter)
+{
+	ANKI_ASSERT(channelCount >= 1 && channelCount <= 4);
+	ANKI_ASSERT(width > 0 && (width % 4) == 0 && height > 0 && (height % 4) == 0);
+	ANKI_ASSERT(inPixels.getSizeInBytes() == PtrSize(width) * height * channelCount);
+	ANKI_ASSERT(outBlocks.getSizeInBytes() == PtrSize(getBcBlockSize(format)) * (width / 4) * (height / 4));
+
+	const U32 blockRowCount = height / 4;
+	if(!jobManager)
+	{
+		compressBlockRows(format, inPixels, width, channelCount, 0, blockRowCount, outBlocks);
+		return;
+	}
+
+	const U32 rowsPerTask = max(1u, kBcBlocksPerTask / (width / 4));
+	for(U32 firstRow = 0; firstRow < blockRowCount; firstRow += rowsPerTask)
+	{
+		const U32 rowCount = min(rowsPerTask, blockRowCount - firstRow);
+		jobManager->dispatchTask(
+			[format, inPixels, width, channelCount, firstRow, rowCount, outBlocks]([[maybe_unused]] U32 threadId) {
+				compressBlockRows(format, inPixels, width, channelCount, firstRow, rowCount, outBlocks);
+			},
+			counter);
+	}
+}
+
+static void decodeBc1Color(const U8* in, WeakArray<U8, PtrSize> outPixels, U32 width, U32 blockX, U32 blockY)
+{
+	const U16 color0 = readU16(in);
+	const U16 color1 = readU16(in + 2);
+	U32 indices;
+	memcpy(&indices, in + 4, sizeof(indices));
+
+	const Vec4 c0 = unpackRgb565(color0);
+	const Vec4 c1 = unpackRgb565(color1);
+	Array<Vec4, 4> palette;
+	if(color0 > color1)
+	{
+		palette = {c0, c1, (c0 * 2.0f + c1) / 3.0f, (c0 + c1 * 2.0f) / 3.0f};
+	}
+	else
+	{
+		palette = {c0, c1, (c0 + c1) / 2.0f, Vec4(0.0f)};
+	}
+
+	for(U32 t = 0; t < 16; ++t)
+	{
+		const Vec4 color = palette[(indices >> (t * 2)) & 3] + 0.5f;
+		U8* out = &outPixels[(PtrSize(blockY * 4 + t / 4) * width + blockX * 4 + t % 4) * 4];
+		out[0] = U8(color.x());
+		out[1] = U8(color.y());
+		out[2] = U8(color.z());
+	}
+}
+
+static void decodeBc4(const U8* in, U32 channel, WeakArray<U8, PtrSize> outPixels, U32 width, U32 blockX, U32 blockY)
+{
+	Array<F32, 8> palette;
+	computeBc4Palette(in[0], in[1], palette);
+
+	U64 indices = 0;
+	for(U32 i = 0; i < 6; ++i)
+	{
+		indices |= U64(in[2 + i]) << (i * 8);
+	}
+
+	for(U32 t = 0; t < 16; ++t)
+	{
+		U8* out = &outPixels[(PtrSize(blockY * 4 + t / 4) * width + blockX * 4 + t % 4) * 4];
+		out[channel] = U8(palette[(indices >> (t * 3)) & 7] + 0.5f);
+	}
+}
+
+void decompressBc(BcFormat format, ConstWeakArray<U8, PtrSize> inBlocks, U32 width, U32 height, WeakArray<U8, PtrSize> outPixels)
+{
+	ANKI_ASSERT(width > 0 && (width % 4) == 0 && height > 0 && (height % 4) == 0);
+	ANKI_ASSERT(inBlocks.getSizeInBytes() == PtrSize(getBcBlockSize(format)) * (width / 4) * (height / 4));
+	ANKI_ASSERT(outPixels.getSizeInBytes() == PtrSize(width) * height * 4);
+
+	// Start from black and opaque because not all formats write all channels
+	for(PtrSize i = 0; i < outPixels.getSize(); i += 4)
+	{
+		outPixels[i + 0] = 0;
+		outPixels[i + 1] = 0;
+		outPixels[i + 2] = 0;
+		outPixels[i + 3] = 255;
+	}
+
+	const U32 blockSize = getBcBlockSize(format);
+	for(U32 blockY = 0; blockY < height / 4; ++blockY)
+	{
+		for(U32 blockX = 0; blockX < width / 4; ++blockX)
+		{
+			const U8* in = &inBlocks[(PtrSize(blockY) * (width / 4) + blockX) * blockSize];
+			switch(format)
+			{
+			case BcFormat::kBc1:
+				decodeBc1Color(in, outPixels, width, blockX, blockY);
+				break;
+			case BcFormat::kBc3:
+				decodeBc4(in, 3, outPixels, width, blockX, blockY);
+				decodeBc1Color(in + 8, outPixels, width, blockX, blockY);
+				break;
+			case BcFormat::kBc4:
+				decodeBc4(in, 0, outPixels, width, blockX, blockY);
+				break;
+			case BcFormat::kBc5:
+				decodeBc4(in, 0, outPixels, width, blockX, blockY);
+				decodeBc4(in + 8, 1, outPixels, width, blockX, blockY);
+				break;
+			default:
+				ANKI_ASSERT(0);
+			}
+		}
+	}
+}
+
+} // end namespace anki
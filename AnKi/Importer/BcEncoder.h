@@ -0,0 +1,50 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Importer/Common.h>
+#include <AnKi/Util/WeakArray.h>
+
+namespace anki {
+
+// Forward
+class ThreadJobManager;
+class ThreadJobCounter;
+
+/// @addtogroup importer
+/// @{
+
+/// The block compressed formats of the built-in encoder.
+enum class BcFormat : U8
+{
+	kBc1, ///< RGB. 8 bytes per block.
+	kBc3, ///< RGBA. 16 bytes per block.
+	kBc4, ///< R. 8 bytes per block.
+	kBc5, ///< RG. 16 bytes per block.
+
+	kCount
+};
+
+inline U32 getBcBlockSize(BcFormat format)
+{
+	return (format == BcFormat::kBc1 || format == BcFormat::kBc4) ? 8 : 16;
+}
+
+/// Compress an 8bit image to BC blocks. The image's width and height need to be multiples of 4. It doesn't touch the filesystem.
+/// @param inPixels The pixels of the image. They are tightly packed and have channelCount U8 components.
+/// @param channelCount From 1 to 4. The missing channels are considered zero and the missing alpha is considered 255.
+/// @param outBlocks Where the blocks will be written. Its size should be getBcBlockSize(format) * (width / 4) * (height / 4).
+/// @param jobManager If it's not nullptr the blocks will be compressed in tasks. The tasks capture the input and output arrays so they
+///                   need to stay alive until the counter is done.
+/// @param counter The counter of the tasks. Wait on it with ThreadJobManager::waitForCounter(). Ignored if jobManager is nullptr.
+void compressBc(BcFormat format, ConstWeakArray<U8, PtrSize> inPixels, U32 width, U32 height, U32 channelCount, WeakArray<U8, PtrSize> outBlocks,
+				ThreadJobManager* jobManager = nullptr, ThreadJobCounter* counter = nullptr);
+
+/// Decompress BC blocks to a tightly packed RGBA8 image. It's mainly used to measure the quality of compressBc().
+void decompressBc(BcFormat format, ConstWeakArray<U8, PtrSize> inBlocks, U32 width, U32 height, WeakArray<U8, PtrSize> outPixels);
+/// @}
+
+} // end namespace anki
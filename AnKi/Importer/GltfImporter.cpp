@@ -215,6 +215,7 @@ Error GltfImporter::init(const GltfImporterInitInfo& initInfo)
 	}
 
 	m_importTextures = initInfo.m_importTextures;
+	m_incremental = initInfo.m_incremental;
 
 	return Error::kNone;
 }
@@ -223,6 +224,11 @@ Error GltfImporter::writeAll()
 {
 	populateNodePtrToIdx();
 
+	if(m_incremental)
+	{
+		ANKI_CHECK(loadManifest());
+	}
+
 	ImporterString sceneFname(m_pool);
 	sceneFname.sprintf("%sScene.lua", m_outDir.cstr());
 	ANKI_CHECK(m_sceneFile.open(sceneFname.toCString(), FileOpenFlag::kWrite));
@@ -353,6 +359,13 @@ Error GltfImporter::writeAll()
 		ANKI_CHECK(writeAnimation(*anim));
 	}
 
+	// Store the manifest last so a failed import won't mark anything as up to date
+	ANKI_CHECK(storeManifest());
+	if(m_incremental)
+	{
+		ANKI_IMPORTER_LOGI("%u meshes, materials and animations were up to date and skipped", m_upToDateCount.load());
+	}
+
 	ANKI_IMPORTER_LOGV("Importing GLTF has completed");
 	return Error::kNone;
 }
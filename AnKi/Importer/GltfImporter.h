@@ -10,6 +10,7 @@
 #include <AnKi/Util/StringList.h>
 #include <AnKi/Util/File.h>
 #include <AnKi/Util/HashMap.h>
+#include <AnKi/Util/Thread.h>
 #include <AnKi/Resource/Common.h>
 #include <AnKi/Math.h>
 #include <Cgltf/cgltf.h>
@@ -35,6 +36,7 @@ public:
 	U32 m_threadCount = kMaxU32;
 	CString m_comment;
 	Bool m_importTextures = false;
+	Bool m_incremental = true; ///< Don't re-write the meshes, materials and animations that didn't change since the last import.
 };
 
 /// Import GLTF and spit AnKi scenes.
@@ -82,6 +84,20 @@ private:
 
 	Bool m_importTextures = false;
 
+	// Incremental import. The manifest holds the hash of the inputs of every mesh, material and animation of the last import
+	class ManifestEntry
+	{
+	public:
+		ImporterString m_filename;
+		U64 m_hash = 0;
+	};
+
+	Bool m_incremental = false;
+	ImporterHashMap<U64, U64> m_prevManifest = {m_pool}; ///< Hash of the output filename to the hash of its inputs.
+	mutable ImporterDynamicArray<ManifestEntry> m_manifest = {m_pool};
+	mutable Mutex m_manifestMtx;
+	mutable Atomic<U32> m_upToDateCount = {0};
+
 	template<typename T>
 	class ImportRequest
 	{
@@ -174,11 +190,25 @@ private:
 	ImporterString computeAnimationResourceFilename(const cgltf_animation& anim) const;
 	ImporterString computeSkeletonResourceFilename(const cgltf_skin& skin) const;
 
+	// Manifest
+	ImporterString computeManifestFilename() const;
+	Error loadManifest();
+	Error storeManifest() const;
+	Bool isUpToDate(CString filename, U64 hash) const;
+	Bool materialTexturesExist(CString filename) const;
+	void addManifestEntry(CString filename, U64 hash) const;
+	static U64 appendAccessorHash(const cgltf_accessor& accessor, U64 hash);
+	U64 appendExtrasHash(const cgltf_extras& extras, U64 hash) const;
+	U64 computeMeshHash(const cgltf_mesh& mesh) const;
+	Error computeMaterialHash(const cgltf_material& mtl, Bool writeRayTracing, U64& hash) const;
+	U64 computeAnimationHash(const cgltf_animation& anim) const;
+
 	// Resources
 	Error writeMesh(const cgltf_mesh& mesh) const;
 	Error writeMaterial(const cgltf_material& mtl, Bool writeRayTracing) const;
 	Error writeModel(const cgltf_mesh& mesh) const;
 	Error writeAnimation(const cgltf_animation& anim);
+	Error writeAnimationFile(const cgltf_animation& anim, CString fname) const;
 	Error writeSkeleton(const cgltf_skin& skin) const;
 
 	// Scene
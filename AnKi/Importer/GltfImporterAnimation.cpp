@@ -4,25 +4,17 @@
 // http://www.anki3d.org/LICENSE
 
 #include <AnKi/Importer/GltfImporter.h>
-#include <AnKi/Util/Xml.h>
+#include <AnKi/Importer/AnimationEncoder.h>
 
 namespace anki {
 
-template<typename T>
-class GltfAnimKey
-{
-public:
-	Second m_time;
-	T m_value;
-};
-
 class GltfAnimChannel
 {
 public:
 	ImporterString m_name;
-	ImporterDynamicArray<GltfAnimKey<Vec3>> m_positions;
-	ImporterDynamicArray<GltfAnimKey<Quat>> m_rotations;
-	ImporterDynamicArray<GltfAnimKey<F32>> m_scales;
+	ImporterDynamicArray<AnimationEncoderKey<Vec3>> m_positions;
+	ImporterDynamicArray<AnimationEncoderKey<Quat>> m_rotations;
+	ImporterDynamicArray<AnimationEncoderKey<F32>> m_scales;
 	const cgltf_node* m_targetNode;
 
 	GltfAnimChannel(BaseMemoryPool* pool)
@@ -34,93 +26,49 @@ public:
 	}
 };
 
-/// Optimize out same animation keys.
-template<typename T, typename TZeroFunc, typename TLerpFunc>
-static void optimizeChannel(ImporterDynamicArray<GltfAnimKey<T>>& arr, const T& identity, TZeroFunc isZeroFunc, TLerpFunc lerpFunc)
+Error GltfImporter::writeAnimation(const cgltf_animation& anim)
 {
-	constexpr F32 kMinSkippedToTotalRatio = 0.1f;
+	ImporterString fname(m_pool);
+	ImporterString animFname = computeAnimationResourceFilename(anim);
+	fname.sprintf("%s%s", m_outDir.cstr(), animFname.cstr());
+	fname = fixFilename(fname);
 
-	U32 iterationCount = 0;
-	while(true)
+	const ImporterString manifestFname = fixFilename(animFname);
+	const U64 hash = computeAnimationHash(anim);
+	if(isUpToDate(manifestFname, hash))
 	{
-		if(arr.getSize() < 3)
-		{
-			break;
-		}
-
-		ImporterDynamicArray<GltfAnimKey<T>> newArr(&arr.getMemoryPool());
-		U32 it = 0;
-		while(true)
-		{
-			const GltfAnimKey<T>& left = arr[it];
-			const GltfAnimKey<T>& middle = arr[it + 1];
-			const GltfAnimKey<T>& right = arr[it + 2];
-
-			newArr.emplaceBack(left);
-
-			if(left.m_value == middle.m_value && middle.m_value == right.m_value)
-			{
-				// Skip it
-			}
-			else
-			{
-				const F32 factor = F32((middle.m_time - left.m_time) / (right.m_time - left.m_time));
-				ANKI_ASSERT(factor > 0.0f && factor < 1.0f);
-				const T lerpRez = lerpFunc(left.m_value, right.m_value, factor);
-				if(isZeroFunc(middle.m_value - lerpRez))
-				{
-					// It's redundant, skip it
-				}
-				else
-				{
-					newArr.emplaceBack(middle);
-				}
-			}
-
-			it += 2;
-			if(it + 2 >= arr.getSize())
-			{
-				break;
-			}
-		}
-
-		for(; it < arr.getSize(); ++it)
-		{
-			newArr.emplaceBack(arr[it]);
-		}
-
-		ANKI_ASSERT(newArr.getSize() <= arr.getSize());
+		ANKI_IMPORTER_LOGV("Animation is up to date: %s", fname.cstr());
+	}
+	else
+	{
+		ANKI_IMPORTER_LOGV("Importing animation %s", fname.cstr());
+		ANKI_CHECK(writeAnimationFile(anim, fname));
+		addManifestEntry(manifestFname, hash);
+	}
 
-		// Check if identity
-		if(newArr.getSize() == 2 && isZeroFunc(newArr[0].m_value - newArr[1].m_value) && isZeroFunc(newArr[0].m_value - identity))
+	// Hook up the animation to the scene. Every node once
+	ImporterHashMap<const void*, Bool> hookedNodes(m_pool);
+	for(U32 i = 0; i < anim.channels_count; ++i)
+	{
+		// Only animate cameras for now
+		const cgltf_node* node = anim.channels[i].target_node;
+		if(node == nullptr || node->camera == nullptr || node->name == nullptr || hookedNodes.find(node) != hookedNodes.getEnd())
 		{
-			newArr.destroy();
+			continue;
 		}
 
-		const F32 skippedToTotalRatio = 1.0f - F32(newArr.getSize()) / F32(arr.getSize());
-
-		arr.destroy();
-		arr = std::move(newArr);
-
-		++iterationCount;
+		hookedNodes.emplace(node, true);
 
-		if(skippedToTotalRatio <= kMinSkippedToTotalRatio)
-		{
-			break;
-		}
+		ANKI_CHECK(m_sceneFile.writeTextf("\nnode = scene:tryFindSceneNode(\"%s\")\n", node->name));
+		ANKI_CHECK(
+			m_sceneFile.writeTextf("getEventManager():newAnimationEvent(\"%s%s\", \"%s\", node)\n", m_rpath.cstr(), animFname.cstr(), node->name));
 	}
 
-	ANKI_IMPORTER_LOGV("Channel optimization iteration count: %u", iterationCount);
+	return Error::kNone;
 }
 
-Error GltfImporter::writeAnimation(const cgltf_animation& anim)
+Error GltfImporter::writeAnimationFile(const cgltf_animation& anim, CString fname) const
 {
-	ImporterString fname(m_pool);
-	ImporterString animFname = computeAnimationResourceFilename(anim);
-	fname.sprintf("%s%s", m_outDir.cstr(), animFname.cstr());
-	fname = fixFilename(fname);
-	ANKI_IMPORTER_LOGV("Importing animation %s", fname.cstr());
-
 	// Gather the channels
 	ImporterHashMap<CString, Array<const cgltf_animation_channel*, 3>> channelMap(m_pool);
 	U32 channelCount = 0;
@@ -189,7 +137,7 @@ Error GltfImporter::writeAnimation(const cgltf_animation& anim)
 
 			for(U32 i = 0; i < keys.getSize(); ++i)
 			{
-				GltfAnimKey<Vec3> key;
+				AnimationEncoderKey<Vec3> key;
 				key.m_time = keys[i];
 				key.m_value = Vec3(positions[i].x(), positions[i].y(), positions[i].z());
 
@@ -213,7 +161,7 @@ Error GltfImporter::writeAnimation(const cgltf_animation& anim)
 
 			for(U32 i = 0; i < keys.getSize(); ++i)
 			{
-				GltfAnimKey<Quat> key;
+				AnimationEncoderKey<Quat> key;
 				key.m_time = keys[i];
 				key.m_value = Quat(rotations[i].x(), rotations[i].y(), rotations[i].z(), rotations[i].w());
 
@@ -250,7 +198,7 @@ Error GltfImporter::writeAnimation(const cgltf_animation& anim)
 					scaleErrorReported = true;
 				}
 
-				GltfAnimKey<F32> key;
+				AnimationEncoderKey<F32> key;
 				key.m_time = keys[i];
 				key.m_value = scales[i][0];
 
@@ -266,110 +214,22 @@ Error GltfImporter::writeAnimation(const cgltf_animation& anim)
 		++channelCount;
 	}
 
-	// Optimize animation
-	if(m_optimizeAnimations)
+	// Reduce, quantize and write
+	ImporterDynamicArray<AnimationEncoderChannel> encoderChannels(m_pool);
+	encoderChannels.resize(tempChannels.getSize());
+	for(U32 i = 0; i < tempChannels.getSize(); ++i)
 	{
-		constexpr F32 kKillEpsilon = 1.0_cm;
-		for(GltfAnimChannel& channel : tempChannels)
-		{
-			optimizeChannel(
-				channel.m_positions, Vec3(0.0f),
-				[&](const Vec3& a) -> Bool {
-					return a.abs() < kKillEpsilon;
-				},
-				[&](const Vec3& a, const Vec3& b, F32 u) -> Vec3 {
-					return linearInterpolate(a, b, u);
-				});
-			optimizeChannel(
-				channel.m_rotations, Quat::getIdentity(),
-				[&](const Quat& a) -> Bool {
-					return a.abs() < Quat(kEpsilonf * 20.0f);
-				},
-				[&](const Quat& a, const Quat& b, F32 u) -> Quat {
-					return a.slerp(b, u);
-				});
-			optimizeChannel(
-				channel.m_scales, 1.0f,
-				[&](const F32& a) -> Bool {
-					return absolute(a) < kKillEpsilon;
-				},
-				[&](const F32& a, const F32& b, F32 u) -> F32 {
-					return linearInterpolate(a, b, u);
-				});
-		}
+		encoderChannels[i].m_name = tempChannels[i].m_name;
+		encoderChannels[i].m_positions = tempChannels[i].m_positions;
+		encoderChannels[i].m_rotations = tempChannels[i].m_rotations;
+		encoderChannels[i].m_scales = tempChannels[i].m_scales;
 	}
 
-	// Write file
-	File file;
-	ANKI_CHECK(file.open(fname.toCString(), FileOpenFlag::kWrite));
-
-	ANKI_CHECK(file.writeTextf("%s\n<animation>\n", XmlDocument<MemoryPoolPtrWrapper<BaseMemoryPool>>::kXmlHeader.cstr()));
-	ANKI_CHECK(file.writeText("\t<channels>\n"));
-
-	for(const GltfAnimChannel& channel : tempChannels)
-	{
-		ANKI_CHECK(file.writeTextf("\t\t<channel name=\"%s\">\n", channel.m_name.cstr()));
-
-		// Positions
-		if(channel.m_positions.getSize())
-		{
-			ANKI_CHECK(file.writeText("\t\t\t<positionKeys>\n"));
-			for(const GltfAnimKey<Vec3>& key : channel.m_positions)
-			{
-				ANKI_CHECK(
-					file.writeTextf("\t\t\t\t<key time=\"%f\">%f %f %f</key>\n", key.m_time, key.m_value.x(), key.m_value.y(), key.m_value.z()));
-			}
-			ANKI_CHECK(file.writeText("\t\t\t</positionKeys>\n"));
-		}
-
-		// Rotations
-		if(channel.m_rotations.getSize())
-		{
-			ANKI_CHECK(file.writeText("\t\t\t<rotationKeys>\n"));
-			for(const GltfAnimKey<Quat>& key : channel.m_rotations)
-			{
-				ANKI_CHECK(file.writeTextf("\t\t\t\t<key time=\"%f\">%f %f %f %f</key>\n", key.m_time, key.m_value.x(), key.m_value.y(),
-										   key.m_value.z(), key.m_value.w()));
-			}
-			ANKI_CHECK(file.writeText("\t\t\t</rotationKeys>\n"));
-		}
-
-		// Scales
-		if(channel.m_scales.getSize())
-		{
-			ANKI_CHECK(file.writeText("\t\t\t<scaleKeys>\n"));
-			for(const GltfAnimKey<F32>& key : channel.m_scales)
-			{
-				ANKI_CHECK(file.writeTextf("\t\t\t\t<key time=\"%f\">%f</key>\n", key.m_time, key.m_value));
-			}
-			ANKI_CHECK(file.writeText("\t\t\t</scaleKeys>\n"));
-		}
-
-		ANKI_CHECK(file.writeText("\t\t</channel>\n"));
-	}
-
-	ANKI_CHECK(file.writeText("\t</channels>\n"));
-	ANKI_CHECK(file.writeText("</animation>\n"));
-
-	// Hook up the animation to the scene
-	for(const GltfAnimChannel& channel : tempChannels)
-	{
-		if(channel.m_targetNode == nullptr)
-		{
-			continue;
-		}
-
-		// Only animate cameras for now
-		const cgltf_node& node = *channel.m_targetNode;
-		if(node.camera == nullptr || node.name == nullptr)
-		{
-			continue;
-		}
-
-		ANKI_CHECK(m_sceneFile.writeTextf("\nnode = scene:tryFindSceneNode(\"%s\")\n", node.name));
-		ANKI_CHECK(
-			m_sceneFile.writeTextf("getEventManager():newAnimationEvent(\"%s%s\", \"%s\", node)\n", m_rpath.cstr(), animFname.cstr(), node.name));
-	}
+	AnimationEncoderConfig config;
+	config.m_reduceKeys = m_optimizeAnimations;
+	AnimationEncoderStats stats;
+	ANKI_CHECK(encodeAnimation(*m_pool, encoderChannels, config, fname, &stats));
+	ANKI_IMPORTER_LOGV("Animation keys reduced from %u to %u. File size %zu", stats.m_inputKeyCount, stats.m_outputKeyCount, stats.m_fileSize);
 
 	return Error::kNone;
 }
@@ -0,0 +1,309 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Importer/GltfImporter.h>
+#include <AnKi/Util/Filesystem.h>
+
+namespace anki {
+
+/// Bump it when the output of the importer changes. It will invalidate all manifests.
+constexpr U32 kManifestVersion = 2;
+
+ImporterString GltfImporter::computeManifestFilename() const
+{
+	ImporterString fname(m_pool);
+	fname.sprintf("%sImportManifest.txt", m_outDir.cstr());
+	return fname;
+}
+
+Error GltfImporter::loadManifest()
+{
+	const ImporterString fname = computeManifestFilename();
+	if(!fileExists(fname))
+	{
+		ANKI_IMPORTER_LOGV("No manifest found. Will import everything");
+		return Error::kNone;
+	}
+
+	File file;
+	ImporterString txt(m_pool);
+	if(file.open(fname, FileOpenFlag::kRead) || file.readAllText(txt))
+	{
+		ANKI_IMPORTER_LOGW("Failed to read the manifest. Will import everything: %s", fname.cstr());
+		return Error::kNone;
+	}
+
+	ImporterStringList lines(m_pool);
+	lines.splitString(txt, '\n');
+
+	Bool versionFound = false;
+	for(const ImporterString& line : lines)
+	{
+		if(line.isEmpty() || line[0] == '#')
+		{
+			continue;
+		}
+
+		ImporterStringList tokens(m_pool);
+		tokens.splitString(line, ' ');
+		auto it = tokens.getBegin();
+		if(!versionFound)
+		{
+			U32 version = 0;
+			if(tokens.getSize() != 2 || *it != "version" || (++it)->toNumber(version) || version != kManifestVersion)
+			{
+				ANKI_IMPORTER_LOGV("Manifest is from another version of the importer. Will import everything");
+				return Error::kNone;
+			}
+
+			versionFound = true;
+			continue;
+		}
+
+		// <hash of the inputs> <hash of the filename> <filename>
+		U64 hash, filenameHash;
+		if(tokens.getSize() < 3 || it->toNumber(hash) || (++it)->toNumber(filenameHash))
+		{
+			ANKI_IMPORTER_LOGW("Manifest is corrupted. Will import everything: %s", fname.cstr());
+			m_prevManifest.destroy();
+			return Error::kNone;
+		}
+
+		auto prev = m_prevManifest.find(filenameHash);
+		if(prev != m_prevManifest.getEnd())
+		{
+			// The same output was written more than once with different inputs. Don't trust it
+			*prev = 0;
+		}
+		else
+		{
+			m_prevManifest.emplace(filenameHash, hash);
+		}
+	}
+
+	return Error::kNone;
+}
+
+Error GltfImporter::storeManifest() const
+{
+	// Sort to have something that diffs nicely
+	std::sort(m_manifest.getBegin(), m_manifest.getEnd(), [](const ManifestEntry& a, const ManifestEntry& b) {
+		return a.m_filename < b.m_filename;
+	});
+
+	File file;
+	ANKI_CHECK(file.open(computeManifestFilename(), FileOpenFlag::kWrite));
+	ANKI_CHECK(
+		file.writeTextf("# Generated by the glTF importer. It holds the hashes of the inputs of the last import\nversion %u\n", kManifestVersion));
+	for(const ManifestEntry& entry : m_manifest)
+	{
+		ANKI_CHECK(file.writeTextf("%" PRIu64 " %" PRIu64 " %s\n", entry.m_hash, computeHash(entry.m_filename.cstr(), entry.m_filename.getLength()),
+								   entry.m_filename.cstr()));
+	}
+
+	return Error::kNone;
+}
+
+Bool GltfImporter::isUpToDate(CString filename, U64 hash) const
+{
+	if(!m_incremental)
+	{
+		return false;
+	}
+
+	auto it = m_prevManifest.find(computeHash(filename.cstr(), filename.getLength()));
+	if(it == m_prevManifest.getEnd() || *it != hash)
+	{
+		return false;
+	}
+
+	// Someone might have deleted the output
+	ImporterString fullFilename(m_pool);
+	fullFilename.sprintf("%s%s", m_outDir.cstr(), filename.cstr());
+	if(!fileExists(fullFilename))
+	{
+		return false;
+	}
+
+	addManifestEntry(filename, hash);
+	m_upToDateCount.fetchAdd(1);
+	return true;
+}
+
+Bool GltfImporter::materialTexturesExist(CString filename) const
+{
+	ImporterString fullFilename(m_pool);
+	fullFilename.sprintf("%s%s", m_outDir.cstr(), filename.cstr());
+
+	File file;
+	ImporterString xml(m_pool);
+	if(!fileExists(fullFilename) || file.open(fullFilename, FileOpenFlag::kRead) || file.readAllText(xml))
+	{
+		return false;
+	}
+
+	if(!m_importTextures || xml.isEmpty())
+	{
+		return true;
+	}
+
+	// Find the textures the material references and the importer wrote. The height map is not written by the importer
+	const Array<CString, 5> inputNames = {"m_diffTex", "m_roughnessTex", "m_metallicTex", "m_normalTex", "m_emissiveTex"};
+	for(CString inputName : inputNames)
+	{
+		ImporterString prefix(m_pool);
+		prefix.sprintf("<input name=\"%s\" value=\"%s", inputName.cstr(), m_texrpath.cstr());
+
+		const PtrSize begin = xml.find(prefix);
+		if(begin == ImporterString::kNpos)
+		{
+			continue;
+		}
+
+		const PtrSize uriBegin = begin + prefix.getLength();
+		const PtrSize uriEnd = (uriBegin < xml.getLength()) ? xml.find(CString("\""), uriBegin) : ImporterString::kNpos;
+		if(uriEnd == ImporterString::kNpos || uriEnd == uriBegin)
+		{
+			return false;
+		}
+
+		// The URI in the material is relative to the texture path. The texture is relative to the output dir
+		ImporterString texFilename = m_outDir;
+		texFilename += ImporterString(xml.getBegin() + uriBegin, xml.getBegin() + uriEnd, m_pool);
+		if(!fileExists(texFilename))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void GltfImporter::addManifestEntry(CString filename, U64 hash) const
+{
+	LockGuard lock(m_manifestMtx);
+	ManifestEntry& entry = *m_manifest.emplaceBack();
+	entry.m_filename = ImporterString(filename, m_pool);
+	entry.m_hash = hash;
+}
+
+U64 GltfImporter::appendAccessorHash(const cgltf_accessor& accessor, U64 hash)
+{
+	const Array<U64, 5> desc = {U64(accessor.component_type), U64(accessor.type), U64(accessor.normalized), U64(accessor.count),
+								U64(accessor.stride)};
+	hash = appendHash(&desc[0], sizeof(desc), hash);
+
+	if(accessor.buffer_view && accessor.count > 0)
+	{
+		const cgltf_buffer_view& view = *accessor.buffer_view;
+		const U8* base = static_cast<const U8*>(view.buffer->data) + view.offset + accessor.offset;
+		const PtrSize stride = (view.stride) ? view.stride : accessor.stride;
+
+		// If the buffer is interleaved this will include other accessors as well. It's fine since they are part of the same primitive
+		const PtrSize size = min<PtrSize>(stride * accessor.count, view.size - accessor.offset);
+		hash = appendHash(base, size, hash);
+	}
+
+	return hash;
+}
+
+U64 GltfImporter::appendExtrasHash(const cgltf_extras& extras, U64 hash) const
+{
+	if(extras.end_offset > extras.start_offset)
+	{
+		hash = appendHash(m_gltf->json + extras.start_offset, extras.end_offset - extras.start_offset, hash);
+	}
+
+	return hash;
+}
+
+U64 GltfImporter::computeMeshHash(const cgltf_mesh& mesh) const
+{
+	const Array<F32, 6> options = {F32(kManifestVersion), F32(m_optimizeMeshes), F32(m_lodCount), m_lodFactor, F32(m_skipLodVertexCountThreshold),
+								   m_normalsMergeAngle};
+	U64 hash = computeHash(&options[0], sizeof(options));
+
+	for(const cgltf_primitive* primitive = mesh.primitives; primitive < mesh.primitives + mesh.primitives_count; ++primitive)
+	{
+		const Array<U32, 2> desc = {U32(primitive->type), U32(primitive->attributes_count)};
+		hash = appendHash(&desc[0], sizeof(desc), hash);
+
+		for(const cgltf_attribute* attrib = primitive->attributes; attrib < primitive->attributes + primitive->attributes_count; ++attrib)
+		{
+			const Array<I32, 2> attribDesc = {I32(attrib->type), I32(attrib->index)};
+			hash = appendHash(&attribDesc[0], sizeof(attribDesc), hash);
+			hash = appendAccessorHash(*attrib->data, hash);
+		}
+
+		if(primitive->indices)
+		{
+			hash = appendAccessorHash(*primitive->indices, hash);
+		}
+	}
+
+	return hash;
+}
+
+Error GltfImporter::computeMaterialHash(const cgltf_material& mtl, Bool writeRayTracing, U64& hash) const
+{
+	const cgltf_pbr_metallic_roughness& pbr = mtl.pbr_metallic_roughness;
+	const Array<F32, 13> desc = {F32(kManifestVersion),    F32(writeRayTracing),     F32(m_importTextures),    F32(mtl.has_pbr_metallic_roughness),
+								 pbr.base_color_factor[0], pbr.base_color_factor[1], pbr.base_color_factor[2], pbr.base_color_factor[3],
+								 pbr.metallic_factor,      pbr.roughness_factor,     mtl.emissive_factor[0],   mtl.emissive_factor[1],
+								 mtl.emissive_factor[2]};
+	hash = computeHash(&desc[0], sizeof(desc));
+	hash = appendHash(m_texrpath.cstr(), m_texrpath.getLength(), hash);
+	hash = appendExtrasHash(mtl.extras, hash);
+
+	// The material reads the textures to find constant colors and it might import them so their contents are inputs as well
+	const Array<const cgltf_texture_view*, 4> views = {&pbr.base_color_texture, &pbr.metallic_roughness_texture, &mtl.normal_texture,
+													   &mtl.emissive_texture};
+	for(const cgltf_texture_view* view : views)
+	{
+		if(!view->texture || !view->texture->image || !view->texture->image->uri)
+		{
+			continue;
+		}
+
+		const CString uri = view->texture->image->uri;
+		hash = appendHash(uri.cstr(), uri.getLength(), hash);
+
+		File file;
+		ANKI_CHECK(file.open(uri, FileOpenFlag::kRead | FileOpenFlag::kBinary));
+		ImporterDynamicArrayLarge<U8> data(m_pool);
+		data.resize(file.getSize());
+		if(data.getSize())
+		{
+			ANKI_CHECK(file.read(&data[0], data.getSize()));
+		}
+		hash = appendHash(data.getBegin(), data.getSize(), hash);
+	}
+
+	return Error::kNone;
+}
+
+U64 GltfImporter::computeAnimationHash(const cgltf_animation& anim) const
+{
+	const Array<U32, 2> options = {kManifestVersion, m_optimizeAnimations};
+	U64 hash = computeHash(&options[0], sizeof(options));
+
+	for(const cgltf_animation_channel* channel = anim.channels; channel < anim.channels + anim.channels_count; ++channel)
+	{
+		if(channel->target_node)
+		{
+			const ImporterString name = getNodeName(*channel->target_node);
+			hash = appendHash(name.cstr(), name.getLength(), hash);
+		}
+
+		const Array<U32, 2> desc = {U32(channel->target_path), U32(channel->sampler->interpolation)};
+		hash = appendHash(&desc[0], sizeof(desc), hash);
+		hash = appendAccessorHash(*channel->sampler->input, hash);
+		hash = appendAccessorHash(*channel->sampler->output, hash);
+	}
+
+	return hash;
+}
+
+} // end namespace anki
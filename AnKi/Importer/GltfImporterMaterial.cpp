@@ -100,11 +100,16 @@ static Error findConstantColorsInImage(CString fname, Vec4& constantColor, BaseM
 	return Error::kNone;
 }
 
-static Error importImage(BaseMemoryPool& pool, CString in, CString out, Bool alpha)
+/// The alpha test of the GBuffer passes when the alpha is not zero.
+constexpr F32 kAlphaTestReference = 0.0f;
+
+static Error importImage(BaseMemoryPool& pool, ThreadJobManager* jobManager, CString in, CString out, Bool alpha, Bool sRgb = false,
+						 Bool alphaTested = false)
 {
 	ImageImporterConfig config;
 
 	config.m_pool = &pool;
+	config.m_jobManager = jobManager;
 
 	Array<CString, 1> inputFnames = {in};
 	config.m_inputFilenames = inputFnames;
@@ -113,6 +118,8 @@ static Error importImage(BaseMemoryPool& pool, CString in, CString out, Bool alp
 	config.m_compressions = ImageBinaryDataCompression::kS3tc | ImageBinaryDataCompression::kAstc;
 	config.m_minMipmapDimension = 8;
 	config.m_noAlpha = !alpha;
+	config.m_sRgb = sRgb;
+	config.m_alphaCoverageReference = (alphaTested) ? kAlphaTestReference : -1.0f;
 
 	String tmp;
 	if(getTempDirectory(tmp))
@@ -150,8 +157,22 @@ static void fixImageUri(ImporterString& uri)
 
 Error GltfImporter::writeMaterial(const cgltf_material& mtl, Bool writeRayTracing) const
 {
+	const ImporterString mtlFname = computeMaterialResourceFilename(mtl);
 	ImporterString fname(m_pool);
-	fname.sprintf("%s%s", m_outDir.cstr(), computeMaterialResourceFilename(mtl).cstr());
+	fname.sprintf("%s%s", m_outDir.cstr(), mtlFname.cstr());
+
+	// Hashing reads all the textures so do it only if it's needed. The textures are outputs of the material as well so check them too
+	U64 hash = 0;
+	if(m_incremental)
+	{
+		ANKI_CHECK(computeMaterialHash(mtl, writeRayTracing, hash));
+		if(materialTexturesExist(mtlFname) && isUpToDate(mtlFname, hash))
+		{
+			ANKI_IMPORTER_LOGV("Material is up to date: %s", fname.cstr());
+			return Error::kNone;
+		}
+	}
+
 	ANKI_IMPORTER_LOGV("Importing material %s", fname.cstr());
 
 	if(!mtl.has_pbr_metallic_roughness)
@@ -197,7 +218,7 @@ Error GltfImporter::writeMaterial(const cgltf_material& mtl, Bool writeRayTracin
 			ImporterString out = m_outDir;
 			out += fname;
 			fixImageUri(out);
-			ANKI_CHECK(importImage(*m_pool, fname, out, !constantAlpha));
+			ANKI_CHECK(importImage(*m_pool, m_jobManager, fname, out, !constantAlpha, true, alphaTested));
 		}
 	}
 	else
@@ -308,7 +329,7 @@ Error GltfImporter::writeMaterial(const cgltf_material& mtl, Bool writeRayTracin
 		ImporterString out = m_outDir;
 		out += in;
 		fixImageUri(out);
-		ANKI_CHECK(importImage(*m_pool, in, out, false));
+		ANKI_CHECK(importImage(*m_pool, m_jobManager, in, out, false));
 	}
 
 	// Normal texture
@@ -331,7 +352,7 @@ Error GltfImporter::writeMaterial(const cgltf_material& mtl, Bool writeRayTracin
 				ImporterString out = m_outDir;
 				out += in;
 				fixImageUri(out);
-				ANKI_CHECK(importImage(*m_pool, in, out, false));
+				ANKI_CHECK(importImage(*m_pool, m_jobManager, in, out, false));
 			}
 		}
 		else
@@ -362,7 +383,7 @@ Error GltfImporter::writeMaterial(const cgltf_material& mtl, Bool writeRayTracin
 			ImporterString out = m_outDir;
 			out += in;
 			fixImageUri(out);
-			ANKI_CHECK(importImage(*m_pool, in, out, false));
+			ANKI_CHECK(importImage(*m_pool, m_jobManager, in, out, false, true));
 		}
 	}
 	else
@@ -419,6 +440,11 @@ Error GltfImporter::writeMaterial(const cgltf_material& mtl, Bool writeRayTracin
 	ANKI_CHECK(file.open(fname.toCString(), FileOpenFlag::kWrite));
 	ANKI_CHECK(file.writeText(xml));
 
+	if(m_incremental)
+	{
+		addManifestEntry(mtlFname, hash);
+	}
+
 	return Error::kNone;
 }
 
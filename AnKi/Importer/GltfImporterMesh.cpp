@@ -7,6 +7,7 @@
 #include <AnKi/Util/StringList.h>
 #include <AnKi/Collision/Plane.h>
 #include <AnKi/Collision/Functions.h>
+#include <AnKi/Util/HighRezTimer.h>
 #include <AnKi/Resource/MeshBinary.h>
 #include <AnKi/Shaders/Include/MeshTypes.h>
 #include <MeshOptimizer/meshoptimizer.h>
@@ -414,6 +415,73 @@ static Bool isConvex(const ImporterList<SubMesh>& submeshes)
 	return convex;
 }
 
+class MeshletStats
+{
+public:
+	U32 m_meshletCount = 0;
+	U32 m_primitiveCount = 0;
+	U32 m_vertexCount = 0;
+	U32 m_culledConeCount = 0; ///< Meshlets that have a cone that can be used for backface culling.
+	F64 m_coneCutoffSum = 0.0;
+};
+
+/// Split a submesh into meshlets and append them to the meshlet buffers of its LOD.
+/// @param firstVertex The offset of the submesh's vertices in the vertex buffers of the LOD.
+static Error generateMeshlets(const SubMesh& submesh, U32 firstVertex, ImporterDynamicArray<MeshBinaryMeshlet>& meshlets,
+							  ImporterDynamicArray<U16>& meshletVertices, ImporterDynamicArray<U8Vec4>& primitives, MeshletStats& stats,
+							  BaseMemoryPool* pool)
+{
+	ImporterDynamicArray<meshopt_Meshlet> tmpMeshlets(pool);
+	tmpMeshlets.resize(U32(meshopt_buildMeshletsBound(submesh.m_indices.getSize(), kMaxVerticesPerMeshlet, kMaxPrimitivesPerMeshlet)));
+
+	const U32 meshletCount = U32(meshopt_buildMeshlets(&tmpMeshlets[0], &submesh.m_indices[0], submesh.m_indices.getSize(), submesh.m_verts.getSize(),
+													   kMaxVerticesPerMeshlet, kMaxPrimitivesPerMeshlet));
+
+	for(U32 i = 0; i < meshletCount; ++i)
+	{
+		const meshopt_Meshlet& in = tmpMeshlets[i];
+		const meshopt_Bounds bounds =
+			meshopt_computeMeshletBounds(&in, &submesh.m_verts[0].m_position[0], submesh.m_verts.getSize(), sizeof(TempVertex));
+
+		MeshBinaryMeshlet& out = *meshlets.emplaceBack();
+		memset(&out, 0, sizeof(out));
+		out.m_firstPrimitive = primitives.getSize();
+		out.m_firstVertex = meshletVertices.getSize();
+		out.m_primitiveCount = in.triangle_count;
+		out.m_vertexCount = in.vertex_count;
+		out.m_sphereCenter = Vec3(&bounds.center[0]);
+		out.m_sphereRadius = bounds.radius;
+		out.m_coneApex = Vec3(&bounds.cone_apex[0]);
+		out.m_coneAxis = Vec3(&bounds.cone_axis[0]);
+		out.m_coneCutoff = bounds.cone_cutoff;
+
+		for(U32 v = 0; v < in.vertex_count; ++v)
+		{
+			const U32 idx = in.vertices[v] + firstVertex;
+			if(idx > kMaxU16)
+			{
+				ANKI_IMPORTER_LOGE("Only supports 16bit indices for now (%u)", idx);
+				return Error::kUserData;
+			}
+
+			meshletVertices.emplaceBack(U16(idx));
+		}
+
+		for(U32 t = 0; t < in.triangle_count; ++t)
+		{
+			primitives.emplaceBack(in.indices[t][0], in.indices[t][1], in.indices[t][2], U8(0));
+		}
+
+		++stats.m_meshletCount;
+		stats.m_primitiveCount += in.triangle_count;
+		stats.m_vertexCount += in.vertex_count;
+		stats.m_culledConeCount += (bounds.cone_cutoff < 1.0f) ? 1 : 0;
+		stats.m_coneCutoffSum += bounds.cone_cutoff;
+	}
+
+	return Error::kNone;
+}
+
 static void writeVertexAttribAndBufferInfoToHeader(VertexStreamId stream, MeshBinaryHeader& header, const Vec4& scale = Vec4(1.0f),
 												   const Vec4& translation = Vec4(0.0f))
 {
@@ -445,6 +513,14 @@ Error GltfImporter::writeMesh(const cgltf_mesh& mesh) const
 	ImporterString meshName = computeMeshResourceFilename(mesh);
 	ImporterString fname(m_pool);
 	fname.sprintf("%s%s", m_outDir.cstr(), meshName.cstr());
+
+	const U64 hash = computeMeshHash(mesh);
+	if(isUpToDate(meshName, hash))
+	{
+		ANKI_IMPORTER_LOGV("Mesh is up to date: %s", fname.cstr());
+		return Error::kNone;
+	}
+
 	ANKI_IMPORTER_LOGV("Importing mesh (%s): %s", (m_optimizeMeshes) ? "optimize" : "WON'T optimize", fname.cstr());
 
 	Array<ImporterList<SubMesh>, kMaxLodCount> submeshes = {{{m_pool}, {m_pool}, {m_pool}}};
@@ -699,9 +775,58 @@ Error GltfImporter::writeMesh(const cgltf_mesh& mesh) const
 		}
 	}
 
+	// Generate the meshlets. They are sorted by submesh
+	Array<ImporterDynamicArray<MeshBinaryMeshlet>, kMaxLodCount> meshlets = {{{m_pool}, {m_pool}, {m_pool}}};
+	Array<ImporterDynamicArray<U16>, kMaxLodCount> meshletVertices = {{{m_pool}, {m_pool}, {m_pool}}};
+	Array<ImporterDynamicArray<U8Vec4>, kMaxLodCount> meshletPrimitives = {{{m_pool}, {m_pool}, {m_pool}}};
+	MeshletStats meshletStats;
+	const Second meshletsBegin = HighRezTimer::getCurrentTime();
+	for(U32 lod = 0; lod <= maxLod; ++lod)
+	{
+		U32 vertCount = 0;
+		U32 submeshIdx = 0;
+		for(const SubMesh& submesh : submeshes[lod])
+		{
+			MeshBinarySubMesh& out = outSubmeshes[submeshIdx++];
+			out.m_firstMeshlets[lod] = meshlets[lod].getSize();
+
+			ANKI_CHECK(generateMeshlets(submesh, vertCount, meshlets[lod], meshletVertices[lod], meshletPrimitives[lod], meshletStats, m_pool));
+
+			out.m_meshletCounts[lod] = meshlets[lod].getSize() - out.m_firstMeshlets[lod];
+			vertCount += submesh.m_verts.getSize();
+		}
+
+		ANKI_ASSERT(meshletPrimitives[lod].getSize() * 3 == header.m_totalIndexCounts[lod]);
+		header.m_totalMeshletCounts[lod] = meshlets[lod].getSize();
+		header.m_totalMeshletVertexCounts[lod] = meshletVertices[lod].getSize();
+	}
+
+	const Second meshletsTime = HighRezTimer::getCurrentTime() - meshletsBegin;
+	ANKI_IMPORTER_LOGV("Meshlets of %s: %u meshlets, %.1f triangles and %.1f vertices per meshlet, %.1f%% can be cone culled (average "
+					   "cutoff %.3f), built in %.3fms (%.0f triangles/s)",
+					   meshName.cstr(), meshletStats.m_meshletCount, F64(meshletStats.m_primitiveCount) / F64(meshletStats.m_meshletCount),
+					   F64(meshletStats.m_vertexCount) / F64(meshletStats.m_meshletCount),
+					   F64(meshletStats.m_culledConeCount) * 100.0 / F64(meshletStats.m_meshletCount),
+					   meshletStats.m_coneCutoffSum / F64(meshletStats.m_meshletCount), meshletsTime * 1000.0,
+					   F64(meshletStats.m_primitiveCount) / max(meshletsTime, Second(kEpsilonf)));
+
 	ANKI_CHECK(file.write(&header, sizeof(header)));
 	ANKI_CHECK(file.write(&outSubmeshes[0], outSubmeshes.getSizeInBytes()));
 
+	// The buffers are aligned in the file so the loader can copy them to the GPU as they are
+	auto alignBuffer = [&]() -> Error {
+		constexpr Array<U8, kMeshBinaryBufferAlignment> zeros = {};
+		const PtrSize offset = file.tell();
+		const PtrSize paddingSize = getAlignedRoundUp(kMeshBinaryBufferAlignment, offset) - offset;
+		if(paddingSize)
+		{
+			ANKI_CHECK(file.write(&zeros[0], paddingSize));
+		}
+		return Error::kNone;
+	};
+
+	ANKI_CHECK(alignBuffer());
+
 	// Write LODs
 	for(I32 lod = I32(maxLod); lod >= 0; --lod)
 	{
@@ -727,6 +852,8 @@ Error GltfImporter::writeMesh(const cgltf_mesh& mesh) const
 			vertCount += submesh.m_verts.getSize();
 		}
 
+		ANKI_CHECK(alignBuffer());
+
 		// Write positions
 		for(const SubMesh& submesh : submeshes[lod])
 		{
@@ -744,6 +871,8 @@ Error GltfImporter::writeMesh(const cgltf_mesh& mesh) const
 			ANKI_CHECK(file.write(&positions[0], positions.getSizeInBytes()));
 		}
 
+		ANKI_CHECK(alignBuffer());
+
 		// Write normals
 		for(const SubMesh& submesh : submeshes[lod])
 		{
@@ -757,6 +886,8 @@ Error GltfImporter::writeMesh(const cgltf_mesh& mesh) const
 			ANKI_CHECK(file.write(&normals[0], normals.getSizeInBytes()));
 		}
 
+		ANKI_CHECK(alignBuffer());
+
 		// Write tangent
 		for(const SubMesh& submesh : submeshes[lod])
 		{
@@ -770,6 +901,8 @@ Error GltfImporter::writeMesh(const cgltf_mesh& mesh) const
 			ANKI_CHECK(file.write(&tangents[0], tangents.getSizeInBytes()));
 		}
 
+		ANKI_CHECK(alignBuffer());
+
 		// Write UV
 		for(const SubMesh& submesh : submeshes[lod])
 		{
@@ -783,6 +916,8 @@ Error GltfImporter::writeMesh(const cgltf_mesh& mesh) const
 			ANKI_CHECK(file.write(&uvs[0], uvs.getSizeInBytes()));
 		}
 
+		ANKI_CHECK(alignBuffer());
+
 		if(hasBoneWeights)
 		{
 			// Bone IDs
@@ -798,6 +933,8 @@ Error GltfImporter::writeMesh(const cgltf_mesh& mesh) const
 				ANKI_CHECK(file.write(&boneids[0], boneids.getSizeInBytes()));
 			}
 
+			ANKI_CHECK(alignBuffer());
+
 			// Bone weights
 			for(const SubMesh& submesh : submeshes[lod])
 			{
@@ -810,9 +947,23 @@ Error GltfImporter::writeMesh(const cgltf_mesh& mesh) const
 
 				ANKI_CHECK(file.write(&boneWeights[0], boneWeights.getSizeInBytes()));
 			}
+
+			ANKI_CHECK(alignBuffer());
 		}
+
+		// Write meshlets
+		ANKI_CHECK(file.write(&meshlets[lod][0], meshlets[lod].getSizeInBytes()));
+		ANKI_CHECK(alignBuffer());
+
+		ANKI_CHECK(file.write(&meshletVertices[lod][0], meshletVertices[lod].getSizeInBytes()));
+		ANKI_CHECK(alignBuffer());
+
+		ANKI_CHECK(file.write(&meshletPrimitives[lod][0], meshletPrimitives[lod].getSizeInBytes()));
+		ANKI_CHECK(alignBuffer());
 	}
 
+	addManifestEntry(meshName, hash);
+
 	return Error::kNone;
 }
 
@@ -5,11 +5,14 @@
 
 #include <AnKi/Importer/ImageImporter.h>
 #include <AnKi/Importer/TinyExr.h>
+#include <AnKi/Importer/BcEncoder.h>
 #include <AnKi/Gr/Common.h>
 #include <AnKi/Resource/Stb.h>
 #include <AnKi/Util/Process.h>
 #include <AnKi/Util/File.h>
 #include <AnKi/Util/Filesystem.h>
+#include <AnKi/Util/ThreadJobManager.h>
+#include <AnKi/Util/HighRezTimer.h>
 
 namespace anki {
 
@@ -514,51 +517,6 @@ static Error loadFirstMipmap(const ImageImporterConfig& config, ImageImporterCon
 	return Error::kNone;
 }
 
-template<typename TStorageVec>
-static void generateSurfaceMipmap(ConstWeakArray<U8, PtrSize> inBuffer, U32 inWidth, U32 inHeight, WeakArray<U8, PtrSize> outBuffer)
-{
-	constexpr U32 channelCount = TStorageVec::getSize();
-	using FVecType = typename std::conditional_t<channelCount == 3, Vec3, Vec4>;
-
-	const ConstWeakArray<TStorageVec, PtrSize> inPixels(reinterpret_cast<const TStorageVec*>(&inBuffer[0]),
-														inBuffer.getSizeInBytes() / sizeof(TStorageVec));
-	WeakArray<TStorageVec, PtrSize> outPixels(reinterpret_cast<TStorageVec*>(&outBuffer[0]), outBuffer.getSizeInBytes() / sizeof(TStorageVec));
-
-	const U32 outWidth = inWidth >> 1;
-	const U32 outHeight = inHeight >> 1;
-
-	for(U32 h = 0; h < outHeight; ++h)
-	{
-		for(U32 w = 0; w < outWidth; ++w)
-		{
-			// Gather input
-			FVecType average(0.0f);
-			for(U32 y = 0; y < 2; ++y)
-			{
-				for(U32 x = 0; x < 2; ++x)
-				{
-					const U32 idx = (h * 2 + y) * inWidth + (w * 2 + x);
-					const TStorageVec inPixel = inPixels[idx];
-					for(U32 c = 0; c < channelCount; ++c)
-					{
-						average[c] += F32(inPixel[c]) * 0.25f;
-					}
-				}
-			}
-
-			TStorageVec uaverage;
-			for(U32 c = 0; c < channelCount; ++c)
-			{
-				uaverage[c] = typename TStorageVec::Scalar(average[c]);
-			}
-
-			// Store
-			const U32 idx = h * outWidth + w;
-			outPixels[idx] = uaverage;
-		}
-	}
-}
-
 static Error compressS3tc(BaseMemoryPool& pool, CString tempDirectory, CString compressonatorFilename, ConstWeakArray<U8, PtrSize> inPixels,
 						  U32 inWidth, U32 inHeight, U32 channelCount, Bool hdr, WeakArray<U8, PtrSize> outPixels)
 {
@@ -973,50 +931,52 @@ static Error importImageInternal(const ImageImporterConfig& configOriginal)
 	const U32 mipCount = min(config.m_mipmapCount, (config.m_type == ImageBinaryType::k3D)
 													   ? computeMaxMipmapCount3d(width, height, ctx.m_depth, config.m_minMipmapDimension)
 													   : computeMaxMipmapCount2d(width, height, config.m_minMipmapDimension));
+	const Bool sRgb = !ctx.m_hdr && ((config.m_sRgb && !config.m_sRgbToLinear) || config.m_linearToSRgb);
+	const Bool preserveCoverage =
+		!ctx.m_hdr && ctx.m_channelCount == 4 && config.m_alphaCoverageReference >= 0.0f && config.m_alphaCoverageReference <= 1.0f;
+
+	ImporterDynamicArray<F32> alphaCoverages(&pool);
+	if(preserveCoverage && config.m_type != ImageBinaryType::k3D)
+	{
+		alphaCoverages.resize(ctx.m_faceCount * ctx.m_layerCount);
+		for(U32 i = 0; i < alphaCoverages.getSize(); ++i)
+		{
+			alphaCoverages[i] = computeAlphaCoverage(ctx.m_mipmaps[0].m_surfacesOrVolume[i].m_pixels, config.m_alphaCoverageReference);
+		}
+	}
+
+	HighRezTimer mipTimer;
+	mipTimer.start();
 	for(U32 mip = 1; mip < mipCount; ++mip)
 	{
 		ctx.m_mipmaps.emplaceBack(&pool);
 
 		if(config.m_type != ImageBinaryType::k3D)
 		{
+			// All the surfaces of a mip are generated in parallel. The next mip has to wait since it reads this one
+			ThreadJobCounter mipCounter;
 			ctx.m_mipmaps[mip].m_surfacesOrVolume.resize(ctx.m_faceCount * ctx.m_layerCount, &pool);
-			for(U32 l = 0; l < ctx.m_layerCount; ++l)
+			for(U32 idx = 0; idx < ctx.m_faceCount * ctx.m_layerCount; ++idx)
 			{
-				for(U32 f = 0; f < ctx.m_faceCount; ++f)
-				{
-					const U32 idx = l * ctx.m_faceCount + f;
-					const SurfaceOrVolumeData& inSurface = ctx.m_mipmaps[mip - 1].m_surfacesOrVolume[idx];
-					SurfaceOrVolumeData& outSurface = ctx.m_mipmaps[mip].m_surfacesOrVolume[idx];
-					outSurface.m_pixels.resize((ctx.m_width >> mip) * (ctx.m_height >> mip) * ctx.m_pixelSize);
+				const SurfaceOrVolumeData& inSurface = ctx.m_mipmaps[mip - 1].m_surfacesOrVolume[idx];
+				SurfaceOrVolumeData& outSurface = ctx.m_mipmaps[mip].m_surfacesOrVolume[idx];
+				outSurface.m_pixels.resize((ctx.m_width >> mip) * (ctx.m_height >> mip) * ctx.m_pixelSize);
 
-					if(ctx.m_channelCount == 3)
-					{
-						if(ctx.m_hdr)
-						{
-							generateSurfaceMipmap<Vec3>(ConstWeakArray<U8, PtrSize>(inSurface.m_pixels), ctx.m_width >> (mip - 1),
-														ctx.m_height >> (mip - 1), WeakArray<U8, PtrSize>(outSurface.m_pixels));
-						}
-						else
-						{
-							generateSurfaceMipmap<U8Vec3>(ConstWeakArray<U8, PtrSize>(inSurface.m_pixels), ctx.m_width >> (mip - 1),
-														  ctx.m_height >> (mip - 1), WeakArray<U8, PtrSize>(outSurface.m_pixels));
-						}
-					}
-					else
-					{
-						ANKI_ASSERT(ctx.m_channelCount == 4);
+				generateMipmap(pool, config.m_mipmapFilter, inSurface.m_pixels, ctx.m_width >> (mip - 1), ctx.m_height >> (mip - 1),
+							   ctx.m_channelCount, ctx.m_hdr, sRgb, WeakArray<U8, PtrSize>(outSurface.m_pixels), config.m_jobManager, &mipCounter);
+			}
 
-						if(ctx.m_hdr)
-						{
-							generateSurfaceMipmap<Vec4>(ConstWeakArray<U8, PtrSize>(inSurface.m_pixels), ctx.m_width >> (mip - 1),
-														ctx.m_height >> (mip - 1), WeakArray<U8, PtrSize>(outSurface.m_pixels));
-						}
-						else
-						{
-							generateSurfaceMipmap<U8Vec4>(ConstWeakArray<U8, PtrSize>(inSurface.m_pixels), ctx.m_width >> (mip - 1),
-														  ctx.m_height >> (mip - 1), WeakArray<U8, PtrSize>(outSurface.m_pixels));
-						}
-					}
+			if(config.m_jobManager)
+			{
+				config.m_jobManager->waitForCounter(mipCounter);
+			}
+
+			if(preserveCoverage)
+			{
+				for(U32 idx = 0; idx < ctx.m_faceCount * ctx.m_layerCount; ++idx)
+				{
+					preserveAlphaCoverage(WeakArray<U8, PtrSize>(ctx.m_mipmaps[mip].m_surfacesOrVolume[idx].m_pixels),
+										  config.m_alphaCoverageReference, alphaCoverages[idx]);
 				}
 			}
 		}
@@ -1025,11 +985,46 @@ static Error importImageInternal(const ImageImporterConfig& configOriginal)
 			ANKI_ASSERT(!"TODO");
 		}
 	}
+	mipTimer.stop();
+
+	if(mipCount > 1)
+	{
+		ANKI_IMPORTER_LOGV("Mipmap generation took %fms", mipTimer.getElapsedTime() * 1000.0);
+	}
+
+	// Compress. The built-in encoder splits every surface into tasks and the external compressors run one task per surface
+	ThreadJobCounter counter;
+	Atomic<I32> errorInThread = {0};
+	auto runTask = [&](auto func) -> Error {
+		if(config.m_jobManager)
+		{
+			config.m_jobManager->dispatchTask(
+				[func, &errorInThread]([[maybe_unused]] U32 threadId) {
+					if(!errorInThread.load())
+					{
+						const Error err = func();
+						if(err)
+						{
+							errorInThread.store(err._getCode());
+						}
+					}
+				},
+				&counter);
+			return Error::kNone;
+		}
+		else
+		{
+			return func();
+		}
+	};
+
+	HighRezTimer timer;
+	timer.start();
 
-	// Compress
 	if(!!(config.m_compressions & ImageBinaryDataCompression::kS3tc))
 	{
-		ANKI_IMPORTER_LOGV("Will compress in S3TC");
+		const Bool builtin = !ctx.m_hdr && config.m_builtinS3tcEncoder;
+		ANKI_IMPORTER_LOGV("Will compress in S3TC (%s)", (builtin) ? "built-in encoder" : "Compressonator");
 
 		for(U32 mip = 0; mip < mipCount; ++mip)
 		{
@@ -1047,9 +1042,20 @@ static Error importImageInternal(const ImageImporterConfig& configOriginal)
 
 					surface.m_s3tcPixels.resize(s3tcImageSize);
 
-					ANKI_CHECK(compressS3tc(pool, config.m_tempDirectory, config.m_compressonatorFilename,
-											ConstWeakArray<U8, PtrSize>(surface.m_pixels), width, height, ctx.m_channelCount, ctx.m_hdr,
-											WeakArray<U8, PtrSize>(surface.m_s3tcPixels)));
+					const ConstWeakArray<U8, PtrSize> inPixels(surface.m_pixels);
+					const WeakArray<U8, PtrSize> outPixels(surface.m_s3tcPixels);
+					if(builtin)
+					{
+						compressBc((ctx.m_channelCount == 3) ? BcFormat::kBc1 : BcFormat::kBc3, inPixels, width, height, ctx.m_channelCount,
+								   outPixels, config.m_jobManager, &counter);
+					}
+					else
+					{
+						ANKI_CHECK(runTask([&pool, &config, &ctx, inPixels, width, height, outPixels]() {
+							return compressS3tc(pool, config.m_tempDirectory, config.m_compressonatorFilename, inPixels, width, height,
+												ctx.m_channelCount, ctx.m_hdr, outPixels);
+						}));
+					}
 				}
 			}
 		}
@@ -1075,14 +1081,32 @@ static Error importImageInternal(const ImageImporterConfig& configOriginal)
 
 					surface.m_astcPixels.resize(astcImageSize);
 
-					ANKI_CHECK(compressAstc(pool, config.m_tempDirectory, config.m_astcencFilename, ConstWeakArray<U8, PtrSize>(surface.m_pixels),
-											width, height, ctx.m_channelCount, config.m_astcBlockSize, ctx.m_hdr,
-											WeakArray<U8, PtrSize>(surface.m_astcPixels)));
+					const ConstWeakArray<U8, PtrSize> inPixels(surface.m_pixels);
+					const WeakArray<U8, PtrSize> outPixels(surface.m_astcPixels);
+					ANKI_CHECK(runTask([&pool, &config, &ctx, inPixels, width, height, outPixels]() {
+						return compressAstc(pool, config.m_tempDirectory, config.m_astcencFilename, inPixels, width, height, ctx.m_channelCount,
+											config.m_astcBlockSize, ctx.m_hdr, outPixels);
+					}));
 				}
 			}
 		}
 	}
 
+	if(config.m_jobManager)
+	{
+		config.m_jobManager->waitForCounter(counter);
+
+		const Error err = errorInThread.load();
+		if(err)
+		{
+			ANKI_IMPORTER_LOGE("Compression failed in a thread");
+			return err;
+		}
+	}
+
+	timer.stop();
+	ANKI_IMPORTER_LOGV("Compression took %fms", timer.getElapsedTime() * 1000.0);
+
 	if(!!(config.m_compressions & ImageBinaryDataCompression::kEtc))
 	{
 		ANKI_ASSERT(!"TODO");
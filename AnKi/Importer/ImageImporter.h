@@ -4,12 +4,16 @@
 // http://www.anki3d.org/LICENSE
 
 #include <AnKi/Importer/Common.h>
+#include <AnKi/Importer/MipmapGenerator.h>
 #include <AnKi/Util/String.h>
 #include <AnKi/Util/WeakArray.h>
 #include <AnKi/Resource/ImageBinary.h>
 
 namespace anki {
 
+// Forward
+class ThreadJobManager;
+
 /// @addtogroup importer
 /// @{
 
@@ -27,14 +31,19 @@ public:
 	U32 m_mipmapCount = kMaxU32;
 	Bool m_noAlpha = true;
 	CString m_tempDirectory;
-	CString m_compressonatorFilename; ///< Optional.
+	CString m_compressonatorFilename; ///< Optional. Used for BC6H and for BC1/BC3 if m_builtinS3tcEncoder is false.
 	CString m_astcencFilename; ///< Optional.
 	Vec3 m_hdrScale = Vec3(1.0f); ///< Scale the values of HDR textures.
 	Vec3 m_hdrBias = Vec3(0.0f); ///< Add that value to the HDR textures.
 	UVec2 m_astcBlockSize = UVec2(8u);
 	Bool m_sRgbToLinear = false;
 	Bool m_linearToSRgb = false;
+	Bool m_sRgb = false; ///< The LDR input is sRGB encoded (eg albedo). The mipmaps will be filtered in linear space.
+	ImageMipmapFilter m_mipmapFilter = ImageMipmapFilter::kBox;
+	F32 m_alphaCoverageReference = -1.0f; ///< If it's in [0, 1] the mipmaps will keep the alpha test coverage of the 1st mip.
 	Bool m_flipImage = true;
+	Bool m_builtinS3tcEncoder = true; ///< Compress LDR images to BC1/BC3 in-process instead of calling Compressonator.
+	ThreadJobManager* m_jobManager = nullptr; ///< Optional. If it's set the mipmaps and the compression will run in parallel.
 };
 
 /// Converts images to AnKi's specific format.
@@ -0,0 +1,420 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Importer/MipmapGenerator.h>
+#include <AnKi/Util/ThreadJobManager.h>
+#include <AnKi/Math.h>
+
+namespace anki {
+
+/// How many output pixels a task will produce, roughly.
+constexpr U32 kMipmapPixelsPerTask = 256 * 1024;
+
+/// The resolution of the table that converts linear to sRGB. It's high enough so that the darker values don't get banding.
+constexpr U32 kLinearToSRgbTableSize = 16 * 1024;
+
+namespace {
+
+class SRgbTables
+{
+public:
+	Array<F32, 256> m_toLinear;
+	Array<U8, kLinearToSRgbTableSize> m_toSRgb;
+
+	SRgbTables()
+	{
+		for(U32 i = 0; i < 256; ++i)
+		{
+			const F32 c = F32(i) / 255.0f;
+			m_toLinear[i] = (c < 0.04045f) ? c / 12.92f : pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+
+		for(U32 i = 0; i < kLinearToSRgbTableSize; ++i)
+		{
+			const F32 c = F32(i) / F32(kLinearToSRgbTableSize - 1);
+			const F32 s = (c < 0.0031308f) ? c * 12.92f : 1.055f * pow(c, 1.0f / 2.4f) - 0.055f;
+			m_toSRgb[i] = U8(clamp(s * 255.0f + 0.5f, 0.0f, 255.0f));
+		}
+	}
+};
+
+/// The 1D weights of a 2x downsample. Output texel x reads the input texels [2 * x + m_firstTap, 2 * x + m_firstTap + m_tapCount).
+class MipmapKernel
+{
+public:
+	static constexpr U32 kMaxTapCount = 12;
+
+	Array<F32, kMaxTapCount> m_weights;
+	U32 m_tapCount = 0;
+	I32 m_firstTap = 0;
+};
+
+} // namespace
+
+static const SRgbTables& getSRgbTables()
+{
+	static const SRgbTables tables;
+	return tables;
+}
+
+static F32 sinc(F32 x)
+{
+	if(absolute(x) < kEpsilonf)
+	{
+		return 1.0f;
+	}
+
+	x *= kPi;
+	return sin(x) / x;
+}
+
+/// Zero order modified Bessel function of the first kind.
+static F32 besselI0(F32 x)
+{
+	F32 sum = 1.0f;
+	F32 term = 1.0f;
+	const F32 halfX2 = x * x * 0.25f;
+	for(U32 k = 1; k < 32 && term > sum * 1e-7f; ++k)
+	{
+		term *= halfX2 / F32(k * k);
+		sum += term;
+	}
+
+	return sum;
+}
+
+static void initMipmapKernel(ImageMipmapFilter filter, MipmapKernel& kernel)
+{
+	if(filter == ImageMipmapFilter::kBox)
+	{
+		kernel.m_tapCount = 2;
+		kernel.m_firstTap = 0;
+		kernel.m_weights[0] = 0.5f;
+		kernel.m_weights[1] = 0.5f;
+		return;
+	}
+
+	// Both windowed sincs have a radius of 3 output texels which is 6 input texels
+	constexpr F32 kRadius = 3.0f;
+	constexpr F32 kKaiserAlpha = 4.0f;
+	kernel.m_tapCount = MipmapKernel::kMaxTapCount;
+	kernel.m_firstTap = -I32(MipmapKernel::kMaxTapCount / 2) + 1;
+
+	F32 sum = 0.0f;
+	for(U32 i = 0; i < kernel.m_tapCount; ++i)
+	{
+		// Distance from the center of the output texel in output texels
+		const F32 t = (F32(kernel.m_firstTap + I32(i)) - 0.5f) * 0.5f;
+
+		F32 window;
+		if(filter == ImageMipmapFilter::kKaiser)
+		{
+			const F32 r = t / kRadius;
+			window = besselI0(kKaiserAlpha * sqrt(max(0.0f, 1.0f - r * r))) / besselI0(kKaiserAlpha);
+		}
+		else
+		{
+			ANKI_ASSERT(filter == ImageMipmapFilter::kLanczos);
+			window = sinc(t / kRadius);
+		}
+
+		kernel.m_weights[i] = sinc(t) * window;
+		sum += kernel.m_weights[i];
+	}
+
+	for(U32 i = 0; i < kernel.m_tapCount; ++i)
+	{
+		kernel.m_weights[i] /= sum;
+	}
+}
+
+static void loadRow(ConstWeakArray<U8, PtrSize> inPixels, U32 width, U32 y, U32 channelCount, Bool hdr, Bool sRgb, WeakArray<Vec4, PtrSize> out)
+{
+	if(hdr)
+	{
+		const F32* in = reinterpret_cast<const F32*>(&inPixels[PtrSize(y) * width * channelCount * sizeof(F32)]);
+		for(U32 x = 0; x < width; ++x, in += channelCount)
+		{
+			out[x] = Vec4(in[0], in[1], in[2], (channelCount == 4) ? in[3] : 1.0f);
+		}
+	}
+	else
+	{
+		const SRgbTables& tables = getSRgbTables();
+		const U8* in = &inPixels[PtrSize(y) * width * channelCount];
+		for(U32 x = 0; x < width; ++x, in += channelCount)
+		{
+			const F32 a = (channelCount == 4) ? F32(in[3]) / 255.0f : 1.0f;
+			if(sRgb)
+			{
+				out[x] = Vec4(tables.m_toLinear[in[0]], tables.m_toLinear[in[1]], tables.m_toLinear[in[2]], a);
+			}
+			else
+			{
+				out[x] = Vec4(F32(in[0]) / 255.0f, F32(in[1]) / 255.0f, F32(in[2]) / 255.0f, a);
+			}
+		}
+	}
+}
+
+static void storeRow(ConstWeakArray<Vec4, PtrSize> in, U32 width, U32 y, U32 channelCount, Bool hdr, Bool sRgb, WeakArray<U8, PtrSize> outPixels)
+{
+	if(hdr)
+	{
+		F32* out = reinterpret_cast<F32*>(&outPixels[PtrSize(y) * width * channelCount * sizeof(F32)]);
+		for(U32 x = 0; x < width; ++x, out += channelCount)
+		{
+			// The negative lobes of the sincs might produce negative values
+			const Vec4 v = in[x].max(Vec4(0.0f));
+			for(U32 c = 0; c < channelCount; ++c)
+			{
+				out[c] = v[c];
+			}
+		}
+	}
+	else
+	{
+		const SRgbTables& tables = getSRgbTables();
+		U8* out = &outPixels[PtrSize(y) * width * channelCount];
+		for(U32 x = 0; x < width; ++x, out += channelCount)
+		{
+			const Vec4 v = in[x].clamp(0.0f, 1.0f);
+			if(sRgb)
+			{
+				const Vec4 idx = v * F32(kLinearToSRgbTableSize - 1) + 0.5f;
+				out[0] = tables.m_toSRgb[U32(idx.x())];
+				out[1] = tables.m_toSRgb[U32(idx.y())];
+				out[2] = tables.m_toSRgb[U32(idx.z())];
+			}
+			else
+			{
+				const Vec4 u = v * 255.0f + 0.5f;
+				out[0] = U8(u.x());
+				out[1] = U8(u.y());
+				out[2] = U8(u.z());
+			}
+
+			if(channelCount == 4)
+			{
+				out[3] = U8(v.w() * 255.0f + 0.5f);
+			}
+		}
+	}
+}
+
+/// Filter some rows of the output mipmap. The input rows are filtered horizontally into a ring buffer of kTapCount rows and then the ring is
+/// filtered vertically. Every output row needs 2 new input rows. The tap count is a template parameter so the compiler can unroll the loops.
+template<U32 kTapCount>
+static void generateMipmapRowsInternal(BaseMemoryPool& pool, const MipmapKernel& kernel, ConstWeakArray<U8, PtrSize> inPixels, U32 inWidth,
+									   U32 inHeight, U32 channelCount, Bool hdr, Bool sRgb, U32 firstOutRow, U32 outRowCount,
+									   WeakArray<U8, PtrSize> outPixels)
+{
+	const U32 outWidth = inWidth >> 1;
+	const I32 lastInX = I32(inWidth) - 1;
+	const I32 lastInY = I32(inHeight) - 1;
+
+	ImporterDynamicArrayLarge<Vec4> inRow(&pool);
+	inRow.resize(inWidth);
+	ImporterDynamicArrayLarge<Vec4> ring(&pool);
+	ring.resize(PtrSize(kTapCount) * outWidth);
+	ImporterDynamicArrayLarge<Vec4> outRow(&pool);
+	outRow.resize(outWidth);
+
+	// The ring is indexed with the unclamped input row
+	const I32 firstRingRow = I32(firstOutRow * 2) + kernel.m_firstTap;
+	auto ringRow = [&](I32 inRowIdx) {
+		return &ring[PtrSize(U32(inRowIdx - firstRingRow) % kTapCount) * outWidth];
+	};
+
+	for(U32 y = firstOutRow; y < firstOutRow + outRowCount; ++y)
+	{
+		const I32 firstY = I32(y * 2) + kernel.m_firstTap;
+
+		// Horizontal
+		for(I32 inY = (y == firstOutRow) ? firstY : firstY + I32(kTapCount) - 2; inY < firstY + I32(kTapCount); ++inY)
+		{
+			loadRow(inPixels, inWidth, U32(clamp(inY, 0, lastInY)), channelCount, hdr, sRgb, WeakArray<Vec4, PtrSize>(inRow));
+
+			Vec4* filtered = ringRow(inY);
+			for(U32 x = 0; x < outWidth; ++x)
+			{
+				const I32 firstX = I32(x * 2) + kernel.m_firstTap;
+				Vec4 sum(0.0f);
+				if(firstX >= 0 && firstX + I32(kTapCount) - 1 <= lastInX)
+				{
+					const Vec4* in = &inRow[firstX];
+					for(U32 t = 0; t < kTapCount; ++t)
+					{
+						sum += in[t] * kernel.m_weights[t];
+					}
+				}
+				else
+				{
+					// Clamp at the edges
+					for(U32 t = 0; t < kTapCount; ++t)
+					{
+						sum += inRow[clamp<I32>(firstX + I32(t), 0, lastInX)] * kernel.m_weights[t];
+					}
+				}
+
+				filtered[x] = sum;
+			}
+		}
+
+		// Vertical
+		for(U32 t = 0; t < kTapCount; ++t)
+		{
+			const Vec4* filtered = ringRow(firstY + I32(t));
+			const F32 weight = kernel.m_weights[t];
+
+			if(t == 0)
+			{
+				for(U32 x = 0; x < outWidth; ++x)
+				{
+					outRow[x] = filtered[x] * weight;
+				}
+			}
+			else
+			{
+				for(U32 x = 0; x < outWidth; ++x)
+				{
+					outRow[x] += filtered[x] * weight;
+				}
+			}
+		}
+
+		storeRow(outRow, outWidth, y, channelCount, hdr, sRgb, outPixels);
+	}
+}
+
+static void generateMipmapRows(BaseMemoryPool& pool, const MipmapKernel& kernel, ConstWeakArray<U8, PtrSize> inPixels, U32 inWidth, U32 inHeight,
+							   U32 channelCount, Bool hdr, Bool sRgb, U32 firstOutRow, U32 outRowCount, WeakArray<U8, PtrSize> outPixels)
+{
+	if(kernel.m_tapCount == 2)
+	{
+		generateMipmapRowsInternal<2>(pool, kernel, inPixels, inWidth, inHeight, channelCount, hdr, sRgb, firstOutRow, outRowCount, outPixels);
+	}
+	else
+	{
+		ANKI_ASSERT(kernel.m_tapCount == MipmapKernel::kMaxTapCount);
+		generateMipmapRowsInternal<MipmapKernel::kMaxTapCount>(pool, kernel, inPixels, inWidth, inHeight, channelCount, hdr, sRgb, firstOutRow,
+															   outRowCount, outPixels);
+	}
+}
+
+void generateMipmap(BaseMemoryPool& pool, ImageMipmapFilter filter, ConstWeakArray<U8, PtrSize> inPixels, U32 inWidth, U32 inHeight, U32 channelCount,
+					Bool hdr, Bool sRgb, WeakArray<U8, PtrSize> outPixels, ThreadJobManager* jobManager, ThreadJobCounter* counter)
+{
+	ANKI_ASSERT(filter < ImageMipmapFilter::kCount);
+	ANKI_ASSERT(channelCount == 3 || channelCount == 4);
+	ANKI_ASSERT(inWidth >= 2 && inHeight >= 2);
+	const PtrSize componentSize = (hdr) ? sizeof(F32) : sizeof(U8);
+	ANKI_ASSERT(inPixels.getSizeInBytes() == PtrSize(inWidth) * inHeight * channelCount * componentSize);
+	ANKI_ASSERT(outPixels.getSizeInBytes() == PtrSize(inWidth >> 1) * (inHeight >> 1) * channelCount * componentSize);
+	(void)componentSize;
+
+	MipmapKernel kernel;
+	initMipmapKernel(filter, kernel);
+
+	const U32 outHeight = inHeight >> 1;
+	if(!jobManager)
+	{
+		generateMipmapRows(pool, kernel, inPixels, inWidth, inHeight, channelCount, hdr, sRgb, 0, outHeight, outPixels);
+		return;
+	}
+
+	// Make sure the tables are initialized before the tasks start
+	getSRgbTables();
+
+	const U32 rowsPerTask = max(1u, kMipmapPixelsPerTask / (inWidth >> 1));
+	for(U32 firstRow = 0; firstRow < outHeight; firstRow += rowsPerTask)
+	{
+		const U32 rowCount = min(rowsPerTask, outHeight - firstRow);
+		jobManager->dispatchTask(
+			[&pool, kernel, inPixels, inWidth, inHeight, channelCount, hdr, sRgb, firstRow, rowCount, outPixels]([[maybe_unused]] U32 threadId) {
+				generateMipmapRows(pool, kernel, inPixels, inWidth, inHeight, channelCount, hdr, sRgb, firstRow, rowCount, outPixels);
+			},
+			counter);
+	}
+}
+
+static void computeAlphaHistogram(ConstWeakArray<U8, PtrSize> pixels, Array<PtrSize, 256>& histogram)
+{
+	ANKI_ASSERT((pixels.getSize() % 4) == 0);
+	zeroMemory(histogram);
+	for(PtrSize i = 3; i < pixels.getSize(); i += 4)
+	{
+		++histogram[pixels[i]];
+	}
+}
+
+/// The coverage if the alpha gets multiplied by scale and then stored to U8.
+static F32 computeScaledAlphaCoverage(const Array<PtrSize, 256>& histogram, PtrSize texelCount, F32 alphaReference, F32 scale)
+{
+	const F32 reference = alphaReference * 255.0f;
+	PtrSize passCount = 0;
+	for(U32 a = 0; a < 256; ++a)
+	{
+		const F32 scaled = min(255.0f, std::round(F32(a) * scale));
+		if(scaled > reference)
+		{
+			passCount += histogram[a];
+		}
+	}
+
+	return (texelCount) ? F32(passCount) / F32(texelCount) : 0.0f;
+}
+
+F32 computeAlphaCoverage(ConstWeakArray<U8, PtrSize> pixels, F32 alphaReference)
+{
+	Array<PtrSize, 256> histogram;
+	computeAlphaHistogram(pixels, histogram);
+	return computeScaledAlphaCoverage(histogram, pixels.getSize() / 4, alphaReference, 1.0f);
+}
+
+void preserveAlphaCoverage(WeakArray<U8, PtrSize> pixels, F32 alphaReference, F32 targetCoverage)
+{
+	Array<PtrSize, 256> histogram;
+	computeAlphaHistogram(pixels, histogram);
+	const PtrSize texelCount = pixels.getSize() / 4;
+
+	// The coverage grows with the scale so binary search it
+	F32 minScale = 0.0f;
+	F32 maxScale = 4.0f;
+	F32 bestScale = 1.0f;
+	F32 bestDiff = absolute(computeScaledAlphaCoverage(histogram, texelCount, alphaReference, 1.0f) - targetCoverage);
+	for(U32 i = 0; i < 16 && bestDiff > 0.0f; ++i)
+	{
+		const F32 scale = (minScale + maxScale) * 0.5f;
+		const F32 coverage = computeScaledAlphaCoverage(histogram, texelCount, alphaReference, scale);
+		const F32 diff = absolute(coverage - targetCoverage);
+		if(diff < bestDiff)
+		{
+			bestDiff = diff;
+			bestScale = scale;
+		}
+
+		if(coverage < targetCoverage)
+		{
+			minScale = scale;
+		}
+		else
+		{
+			maxScale = scale;
+		}
+	}
+
+	if(bestScale == 1.0f)
+	{
+		return;
+	}
+
+	for(PtrSize i = 3; i < pixels.getSize(); i += 4)
+	{
+		pixels[i] = U8(min(255.0f, std::round(F32(pixels[i]) * bestScale)));
+	}
+}
+
+} // end namespace anki
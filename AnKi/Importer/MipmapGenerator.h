@@ -0,0 +1,54 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Importer/Common.h>
+#include <AnKi/Util/WeakArray.h>
+#include <AnKi/Util/Enum.h>
+
+namespace anki {
+
+// Forward
+class ThreadJobManager;
+class ThreadJobCounter;
+
+/// @addtogroup importer
+/// @{
+
+/// The downsampling filter of the mipmaps.
+enum class ImageMipmapFilter : U8
+{
+	kBox, ///< 2x2 average. Fast but blurry and aliases.
+	kKaiser, ///< Kaiser windowed sinc. Sharp with little ringing.
+	kLanczos, ///< Lanczos 3. The sharpest but it rings on hard edges.
+
+	kCount,
+	kFirst = 0
+};
+ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS(ImageMipmapFilter)
+
+/// Generate a mipmap from the previous one. The filtering is separable and happens in floating point.
+/// @param inPixels Tightly packed pixels with channelCount components. The components are U8 or F32 if it's HDR.
+/// @param channelCount 3 or 4.
+/// @param sRgb The RGB of the LDR pixels is sRGB encoded. It will be filtered in linear space. The alpha is always linear.
+/// @param outPixels The output. Its size is (inWidth / 2) * (inHeight / 2) texels.
+/// @param jobManager If it's not nullptr the rows will be filtered in tasks. The tasks capture the input and output arrays so they need to
+///                   stay alive until the counter is done.
+/// @param counter The counter of the tasks. Ignored if jobManager is nullptr.
+void generateMipmap(BaseMemoryPool& pool, ImageMipmapFilter filter, ConstWeakArray<U8, PtrSize> inPixels, U32 inWidth, U32 inHeight, U32 channelCount,
+					Bool hdr, Bool sRgb, WeakArray<U8, PtrSize> outPixels, ThreadJobManager* jobManager = nullptr,
+					ThreadJobCounter* counter = nullptr);
+
+/// Compute the fraction of the texels of a RGBA8 image that pass an alpha test.
+/// @param alphaReference The alpha test passes if the alpha is greater than that. In [0, 1].
+F32 computeAlphaCoverage(ConstWeakArray<U8, PtrSize> pixels, F32 alphaReference);
+
+/// Scale the alpha of a RGBA8 image so its alpha coverage matches a target coverage. Used to stop alpha tested geometry from thinning out
+/// or growing in the smaller mipmaps.
+void preserveAlphaCoverage(WeakArray<U8, PtrSize> pixels, F32 alphaReference, F32 targetCoverage);
+/// @}
+
+} // end namespace anki
@@ -16,6 +16,7 @@
 #include <AnKi/Renderer/Dbg.h>
 #include <AnKi/Renderer/VolumetricLightingAccumulation.h>
 #include <AnKi/Shaders/Include/MaterialTypes.h>
+#include <AnKi/Scene/SceneGraph.h>
 #include <AnKi/Core/App.h>
 #include <AnKi/Util/Tracer.h>
 
@@ -37,6 +38,7 @@ void ForwardShading::populateRenderGraph(RenderingContext& ctx)
 	visIn.m_gatherAabbIndices = g_dbgCVar.get();
 	RenderTargetHandle hzb = getRenderer().getGBuffer().getHzbRt();
 	visIn.m_hzbRt = &hzb;
+	visIn.m_cpuOccludedRenderables = SceneGraph::getSingleton().getOcclusionCuller().getOccludedRenderables(RenderingTechnique::kForward);
 
 	getRenderer().getGpuVisibility().populateRenderGraph(visIn, m_runCtx.m_visOut);
 }
@@ -8,6 +8,7 @@
 #include <AnKi/Renderer/VrsSriGeneration.h>
 #include <AnKi/Renderer/Scale.h>
 #include <AnKi/Renderer/Dbg.h>
+#include <AnKi/Scene/SceneGraph.h>
 #include <AnKi/Util/Logger.h>
 #include <AnKi/Util/Tracer.h>
 #include <AnKi/Core/CVarSet.h>
@@ -174,6 +175,7 @@ void GBuffer::populateRenderGraph(RenderingContext& ctx)
 		visIn.m_lodDistances = lodDistances;
 		visIn.m_rgraph = &rgraph;
 		visIn.m_hzbRt = &m_runCtx.m_hzbRt;
+		visIn.m_cpuOccludedRenderables = SceneGraph::getSingleton().getOcclusionCuller().getOccludedRenderables(RenderingTechnique::kGBuffer);
 		visIn.m_gatherAabbIndices = g_dbgCVar.get();
 
 		getRenderer().getGpuVisibility().populateRenderGraph(visIn, visOut);
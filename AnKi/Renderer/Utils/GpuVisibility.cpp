@@ -62,6 +62,7 @@ void GpuVisibility::populateRenderGraphInternal(Bool distanceBased, BaseGpuVisib
 	public:
 		RenderTargetHandle m_hzbRt;
 		Mat4 m_viewProjMat;
+		WeakArray<U32> m_cpuOccludedRenderables;
 	};
 
 	FrustumTestData* frustumTestData = nullptr;
@@ -79,6 +80,13 @@ void GpuVisibility::populateRenderGraphInternal(Bool distanceBased, BaseGpuVisib
 		frustumTestData = newInstance<FrustumTestData>(getRenderer().getFrameMemoryPool());
 		const FrustumGpuVisibilityInput& fin = static_cast<FrustumGpuVisibilityInput&>(in);
 		frustumTestData->m_viewProjMat = fin.m_viewProjectionMatrix;
+
+		if(fin.m_cpuOccludedRenderables.getSize())
+		{
+			U32* words = static_cast<U32*>(getRenderer().getFrameMemoryPool().allocate(fin.m_cpuOccludedRenderables.getSizeInBytes(), alignof(U32)));
+			memcpy(words, fin.m_cpuOccludedRenderables.getBegin(), fin.m_cpuOccludedRenderables.getSizeInBytes());
+			frustumTestData->m_cpuOccludedRenderables = WeakArray<U32>(words, fin.m_cpuOccludedRenderables.getSize());
+		}
 	}
 
 	U32 aabbCount = 0;
@@ -255,6 +263,18 @@ void GpuVisibility::populateRenderGraphInternal(Bool distanceBased, BaseGpuVisib
 			unis->m_lodReferencePoint = lodReferencePoint;
 			unis->m_viewProjectionMat = frustumTestData->m_viewProjMat;
 
+			const ConstWeakArray<U32> cpuOccluded = frustumTestData->m_cpuOccludedRenderables;
+			unis->m_cpuOccludedRenderableWordCount = cpuOccluded.getSize();
+			U32* cpuOccludedWords = allocateAndBindUav<U32>(cmdb, 0, 10, max(1u, cpuOccluded.getSize()));
+			if(cpuOccluded.getSize())
+			{
+				memcpy(cpuOccludedWords, cpuOccluded.getBegin(), cpuOccluded.getSizeInBytes());
+			}
+			else
+			{
+				cpuOccludedWords[0] = 0;
+			}
+
 			if(frustumTestData->m_hzbRt.isValid())
 			{
 				rpass.bindColorTexture(0, 8, frustumTestData->m_hzbRt);
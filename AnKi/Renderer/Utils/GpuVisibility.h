@@ -35,6 +35,10 @@ class FrustumGpuVisibilityInput : public BaseGpuVisibilityInput
 public:
 	Mat4 m_viewProjectionMatrix;
 	const RenderTargetHandle* m_hzbRt = nullptr; ///< Optional.
+
+	/// Optional. A bitset with one bit per renderable bounding volume of the technique. The set bits are renderables that the CPU found
+	/// occluded (see OcclusionCuller). It will be copied.
+	ConstWeakArray<U32> m_cpuOccludedRenderables;
 };
 
 /// @memberof GpuVisibility
@@ -0,0 +1,195 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+// WARNING: This file is auto generated.
+
+#pragma once
+
+#include <AnKi/Resource/Common.h>
+#include <AnKi/Math.h>
+
+namespace anki {
+
+/// @addtogroup resource
+/// @{
+
+inline constexpr const char* kAnimationMagic = "ANKIANI1";
+
+/// The offsets of the data of the tracks are multiple of that.
+inline constexpr U32 kAnimationBinaryDataAlignment = 4;
+
+/// Max value of the 16bit range quantization of the positions and scales.
+inline constexpr F32 kAnimationQuantizationMax = 65535.0f;
+
+/// The smallest 3 components of a normalized quaternion are in [-1/sqrt(2), 1/sqrt(2)].
+inline constexpr F32 kAnimationRotationComponentMax = 0.70710678118f;
+
+/// Pack a rotation into 48 bits using the "smallest three" method. The largest component is dropped (and reconstructed from the other
+/// three) and the rest are quantized to 15 bits each. The index of the dropped component goes to the top bits of the 1st and 2nd U16.
+inline Array<U16, 3> quantizeAnimationRotation(const Quat& rotation)
+{
+	U32 largest = 0;
+	for(U32 i = 1; i < 4; ++i)
+	{
+		if(absolute(rotation[i]) > absolute(rotation[largest]))
+		{
+			largest = i;
+		}
+	}
+
+	// q and -q are the same rotation. Make the largest positive so it can be reconstructed
+	const F32 sign = (rotation[largest] < 0.0f) ? -1.0f : 1.0f;
+
+	Array<U16, 3> out;
+	U32 count = 0;
+	for(U32 i = 0; i < 4; ++i)
+	{
+		if(i != largest)
+		{
+			const F32 f = clamp(rotation[i] * sign / kAnimationRotationComponentMax * 0.5f + 0.5f, 0.0f, 1.0f);
+			out[count++] = U16(std::round(f * 32767.0f));
+		}
+	}
+
+	out[0] |= U16((largest & 1) << 15);
+	out[1] |= U16((largest >> 1) << 15);
+	return out;
+}
+
+/// The opposite of quantizeAnimationRotation().
+inline Quat dequantizeAnimationRotation(const U16* packed)
+{
+	const U32 largest = U32(packed[0] >> 15) | (U32(packed[1] >> 15) << 1);
+
+	Quat out;
+	F32 lengthSquared = 0.0f;
+	U32 count = 0;
+	for(U32 i = 0; i < 4; ++i)
+	{
+		if(i != largest)
+		{
+			const F32 f = (F32(packed[count++] & 0x7FFF) / 32767.0f * 2.0f - 1.0f) * kAnimationRotationComponentMax;
+			out[i] = f;
+			lengthSquared += f * f;
+		}
+	}
+
+	out[largest] = sqrt(max(0.0f, 1.0f - lengthSquared));
+	return out;
+}
+
+/// Keys of the position, rotation or scale of a channel.
+class AnimationBinaryTrack
+{
+public:
+	/// Zero if the track is not present. Else it's at least 2.
+	U32 m_keyCount;
+
+	/// Offset in the data to m_keyCount F32 key times. Tracks with the same times share them.
+	U32 m_timesOffset;
+
+	/// Offset in the data to the quantized values. 3 U16 per key for positions and rotations and 1 U16 per key for scales. Rotations are quantized
+	/// with quantizeAnimationRotation().
+	U32 m_valuesOffset;
+
+	/// Position or scale is m_min + U16 / kAnimationQuantizationMax * m_range. Only the x is used for scales.
+	Vec3 m_min;
+
+	Vec3 m_range;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doValue("m_keyCount", offsetof(AnimationBinaryTrack, m_keyCount), self.m_keyCount);
+		s.doValue("m_timesOffset", offsetof(AnimationBinaryTrack, m_timesOffset), self.m_timesOffset);
+		s.doValue("m_valuesOffset", offsetof(AnimationBinaryTrack, m_valuesOffset), self.m_valuesOffset);
+		s.doValue("m_min", offsetof(AnimationBinaryTrack, m_min), self.m_min);
+		s.doValue("m_range", offsetof(AnimationBinaryTrack, m_range), self.m_range);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, AnimationBinaryTrack&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const AnimationBinaryTrack&>(serializer, *this);
+	}
+};
+
+/// A channel of an animation. Its data are in the data of the file.
+class AnimationBinaryChannel
+{
+public:
+	/// Offset in the data to the null terminated name of the channel.
+	U32 m_nameOffset;
+
+	/// The length of the name without the null terminator.
+	U32 m_nameLength;
+
+	AnimationBinaryTrack m_positions;
+	AnimationBinaryTrack m_rotations;
+	AnimationBinaryTrack m_scales;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doValue("m_nameOffset", offsetof(AnimationBinaryChannel, m_nameOffset), self.m_nameOffset);
+		s.doValue("m_nameLength", offsetof(AnimationBinaryChannel, m_nameLength), self.m_nameLength);
+		s.doValue("m_positions", offsetof(AnimationBinaryChannel, m_positions), self.m_positions);
+		s.doValue("m_rotations", offsetof(AnimationBinaryChannel, m_rotations), self.m_rotations);
+		s.doValue("m_scales", offsetof(AnimationBinaryChannel, m_scales), self.m_scales);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, AnimationBinaryChannel&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const AnimationBinaryChannel&>(serializer, *this);
+	}
+};
+
+/// The 1st thing that appears in an animation binary. It's followed by m_channelCount AnimationBinaryChannel and then m_dataSize bytes of data.
+class AnimationBinaryHeader
+{
+public:
+	Array<U8, 8> m_magic;
+	U32 m_channelCount;
+
+	/// It's a multiple of kAnimationBinaryDataAlignment.
+	U32 m_dataSize;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doArray("m_magic", offsetof(AnimationBinaryHeader, m_magic), &self.m_magic[0], self.m_magic.getSize());
+		s.doValue("m_channelCount", offsetof(AnimationBinaryHeader, m_channelCount), self.m_channelCount);
+		s.doValue("m_dataSize", offsetof(AnimationBinaryHeader, m_dataSize), self.m_dataSize);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, AnimationBinaryHeader&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const AnimationBinaryHeader&>(serializer, *this);
+	}
+};
+
+/// @}
+
+} // end namespace anki
@@ -4,11 +4,144 @@
 // http://www.anki3d.org/LICENSE
 
 #include <AnKi/Resource/AnimationResource.h>
+#include <AnKi/Resource/AnimationBinary.h>
+#include <AnKi/Resource/ResourceFilesystem.h>
 #include <AnKi/Util/Xml.h>
 
 namespace anki {
 
+static Vec3 dequantizeVec3(const AnimationQuantizedTrack& track, U32 key)
+{
+	const U16* values = track.m_values + key * 3;
+	return track.m_min + Vec3(F32(values[0]), F32(values[1]), F32(values[2])) * track.m_scale;
+}
+
+static F32 dequantizeF32(const AnimationQuantizedTrack& track, U32 key)
+{
+	return track.m_min.x() + F32(track.m_values[key]) * track.m_scale.x();
+}
+
 Error AnimationResource::load(const ResourceFilename& filename, [[maybe_unused]] Bool async)
+{
+	ResourceFilePtr file;
+	ANKI_CHECK(openFile(filename, file));
+
+	Array<U8, 8> magic = {};
+	if(file->getSize() >= sizeof(AnimationBinaryHeader))
+	{
+		ANKI_CHECK(file->read(&magic[0], sizeof(magic)));
+	}
+
+	if(memcmp(&magic[0], kAnimationMagic, sizeof(magic)) == 0)
+	{
+		ANKI_CHECK(file->seek(0, FileSeekOrigin::kBeginning));
+		ANKI_CHECK(loadBinary(*file));
+	}
+	else
+	{
+		// Older animations are XML
+		file.reset(nullptr);
+		ANKI_CHECK(loadXml(filename));
+	}
+
+	return Error::kNone;
+}
+
+Error AnimationResource::loadBinary(ResourceFile& file)
+{
+	AnimationBinaryHeader header;
+	ANKI_CHECK(file.read(&header, sizeof(header)));
+
+	if(memcmp(&header.m_magic[0], kAnimationMagic, sizeof(header.m_magic)) != 0)
+	{
+		ANKI_RESOURCE_LOGE("Wrong magic word");
+		return Error::kUserData;
+	}
+
+	if(header.m_channelCount == 0 || (header.m_dataSize % kAnimationBinaryDataAlignment) != 0)
+	{
+		ANKI_RESOURCE_LOGE("Incorrect animation header");
+		return Error::kUserData;
+	}
+
+	ResourceDynamicArray<AnimationBinaryChannel> binChannels;
+	binChannels.resize(header.m_channelCount);
+	ANKI_CHECK(file.read(&binChannels[0], binChannels.getSizeInBytes()));
+
+	// Keep the data as they are. The tracks will point to them
+	static_assert(kAnimationBinaryDataAlignment % sizeof(U32) == 0);
+	m_binaryData.resize(header.m_dataSize / sizeof(U32));
+	if(header.m_dataSize)
+	{
+		ANKI_CHECK(file.read(&m_binaryData[0], header.m_dataSize));
+	}
+	const U8* data = reinterpret_cast<const U8*>(m_binaryData.getBegin());
+	const PtrSize dataSize = header.m_dataSize;
+
+	m_startTime = kMaxSecond;
+	Second maxTime = kMinSecond;
+
+	m_channels.resize(header.m_channelCount);
+	for(U32 i = 0; i < header.m_channelCount; ++i)
+	{
+		const AnimationBinaryChannel& inChannel = binChannels[i];
+		AnimationChannel& outChannel = m_channels[i];
+
+		// Name
+		if(PtrSize(inChannel.m_nameOffset) + inChannel.m_nameLength >= dataSize || data[inChannel.m_nameOffset + inChannel.m_nameLength] != 0)
+		{
+			ANKI_RESOURCE_LOGE("Incorrect channel name");
+			return Error::kUserData;
+		}
+		outChannel.m_name = reinterpret_cast<const Char*>(data + inChannel.m_nameOffset);
+
+		// Tracks
+		const Array<const AnimationBinaryTrack*, 3> inTracks = {&inChannel.m_positions, &inChannel.m_rotations, &inChannel.m_scales};
+		const Array<AnimationQuantizedTrack*, 3> outTracks = {&outChannel.m_quantizedPositions, &outChannel.m_quantizedRotations,
+															  &outChannel.m_quantizedScales};
+		constexpr Array<U32, 3> kValueComponentCounts = {3, 3, 1};
+		for(U32 t = 0; t < 3; ++t)
+		{
+			const AnimationBinaryTrack& inTrack = *inTracks[t];
+			if(inTrack.m_keyCount == 0)
+			{
+				continue;
+			}
+
+			const PtrSize timesSize = PtrSize(inTrack.m_keyCount) * sizeof(F32);
+			const PtrSize valuesSize = PtrSize(inTrack.m_keyCount) * kValueComponentCounts[t] * sizeof(U16);
+			if(inTrack.m_keyCount < 2 || (inTrack.m_timesOffset % kAnimationBinaryDataAlignment) != 0
+			   || (inTrack.m_valuesOffset % kAnimationBinaryDataAlignment) != 0 || inTrack.m_timesOffset + timesSize > dataSize
+			   || inTrack.m_valuesOffset + valuesSize > dataSize)
+			{
+				ANKI_RESOURCE_LOGE("Incorrect track of channel: %s", outChannel.m_name.cstr());
+				return Error::kUserData;
+			}
+
+			AnimationQuantizedTrack& outTrack = *outTracks[t];
+			outTrack.m_times = ConstWeakArray<F32>(reinterpret_cast<const F32*>(data + inTrack.m_timesOffset), inTrack.m_keyCount);
+			outTrack.m_values = reinterpret_cast<const U16*>(data + inTrack.m_valuesOffset);
+			outTrack.m_min = inTrack.m_min;
+			outTrack.m_scale = inTrack.m_range / kAnimationQuantizationMax;
+
+			m_startTime = min(m_startTime, Second(outTrack.m_times[0]));
+			maxTime = max(maxTime, Second(outTrack.m_times[inTrack.m_keyCount - 1]));
+		}
+	}
+
+	if(m_startTime > maxTime)
+	{
+		// All channels are identities
+		m_startTime = 0.0;
+		maxTime = 0.0;
+	}
+
+	m_duration = maxTime - m_startTime;
+
+	return Error::kNone;
+}
+
+Error AnimationResource::loadXml(const ResourceFilename& filename)
 {
 	XmlElement el;
 
@@ -187,14 +320,73 @@ Error AnimationResource::load(const ResourceFilename& filename, [[maybe_unused]]
 	return Error::kNone;
 }
 
-void AnimationResource::interpolate(U32 channelIndex, Second time, Vec3& pos, Quat& rot, F32& scale) const
+void sampleAnimationChannel(const AnimationChannel& channel, Second time, AnimationChannelCursor& cursor, AnimationSample& sample)
 {
-	pos = Vec3(0.0f);
-	rot = Quat::getIdentity();
-	scale = 1.0f;
+	sample.m_position = Vec3(0.0f);
+	sample.m_rotation = Quat::getIdentity();
+	sample.m_scale = 1.0f;
+
+	// Position
+	if(channel.m_positions.getSize() > 1 && findAnimationKeyframe<Vec3>(channel.m_positions, time, cursor.m_position))
+	{
+		const AnimationKeyframe<Vec3>& left = channel.m_positions[cursor.m_position];
+		const AnimationKeyframe<Vec3>& right = channel.m_positions[cursor.m_position + 1];
+		const Second u = (time - left.getTime()) / (right.getTime() - left.getTime());
+		sample.m_position = linearInterpolate(left.getValue(), right.getValue(), F32(u));
+	}
+	else if(channel.m_quantizedPositions.m_times.getSize() > 1
+			&& findAnimationKeyframe(channel.m_quantizedPositions.m_times, time, cursor.m_position))
+	{
+		const AnimationQuantizedTrack& track = channel.m_quantizedPositions;
+		const U32 left = cursor.m_position;
+		const Second u = (time - track.m_times[left]) / (track.m_times[left + 1] - track.m_times[left]);
+		sample.m_position = linearInterpolate(dequantizeVec3(track, left), dequantizeVec3(track, left + 1), F32(u));
+	}
+
+	// Rotation
+	if(channel.m_rotations.getSize() > 1 && findAnimationKeyframe<Quat>(channel.m_rotations, time, cursor.m_rotation))
+	{
+		const AnimationKeyframe<Quat>& left = channel.m_rotations[cursor.m_rotation];
+		const AnimationKeyframe<Quat>& right = channel.m_rotations[cursor.m_rotation + 1];
+		const Second u = (time - left.getTime()) / (right.getTime() - left.getTime());
+		sample.m_rotation = left.getValue().slerp(right.getValue(), F32(u));
+	}
+	else if(channel.m_quantizedRotations.m_times.getSize() > 1
+			&& findAnimationKeyframe(channel.m_quantizedRotations.m_times, time, cursor.m_rotation))
+	{
+		const AnimationQuantizedTrack& track = channel.m_quantizedRotations;
+		const U32 left = cursor.m_rotation;
+		const Second u = (time - track.m_times[left]) / (track.m_times[left + 1] - track.m_times[left]);
+		sample.m_rotation =
+			dequantizeAnimationRotation(track.m_values + left * 3).slerp(dequantizeAnimationRotation(track.m_values + (left + 1) * 3), F32(u));
+	}
+
+	// Scale
+	if(channel.m_scales.getSize() > 1 && findAnimationKeyframe<F32>(channel.m_scales, time, cursor.m_scale))
+	{
+		const AnimationKeyframe<F32>& left = channel.m_scales[cursor.m_scale];
+		const AnimationKeyframe<F32>& right = channel.m_scales[cursor.m_scale + 1];
+		const Second u = (time - left.getTime()) / (right.getTime() - left.getTime());
+		sample.m_scale = linearInterpolate(left.getValue(), right.getValue(), F32(u));
+	}
+	else if(channel.m_quantizedScales.m_times.getSize() > 1 && findAnimationKeyframe(channel.m_quantizedScales.m_times, time, cursor.m_scale))
+	{
+		const AnimationQuantizedTrack& track = channel.m_quantizedScales;
+		const U32 left = cursor.m_scale;
+		const Second u = (time - track.m_times[left]) / (track.m_times[left + 1] - track.m_times[left]);
+		sample.m_scale = linearInterpolate(dequantizeF32(track, left), dequantizeF32(track, left + 1), F32(u));
+	}
+}
+
+void AnimationResource::interpolate(U32 channelIndex, Second time, AnimationChannelCursor& cursor, Vec3& pos, Quat& rot, F32& scale) const
+{
+	ANKI_ASSERT(channelIndex < m_channels.getSize());
 
 	if(time < m_startTime) [[unlikely]]
 	{
+		pos = Vec3(0.0f);
+		rot = Quat::getIdentity();
+		scale = 1.0f;
 		return;
 	}
 
@@ -205,57 +397,49 @@ void AnimationResource::interpolate(U32 channelIndex, Second time, Vec3& pos, Qu
 	}
 
 	ANKI_ASSERT(time >= m_startTime && time <= m_startTime + m_duration);
-	ANKI_ASSERT(channelIndex < m_channels.getSize());
 
-	const AnimationChannel& channel = m_channels[channelIndex];
+	AnimationSample sample;
+	sampleAnimationChannel(m_channels[channelIndex], time, cursor, sample);
+	pos = sample.m_position;
+	rot = sample.m_rotation;
+	scale = sample.m_scale;
+}
 
-	// Position
-	if(channel.m_positions.getSize() > 1)
+void AnimationResource::sample(Second time, WeakArray<AnimationChannelCursor> cursors, WeakArray<AnimationSample> samples) const
+{
+	ANKI_ASSERT(cursors.getSize() == m_channels.getSize() && samples.getSize() == m_channels.getSize());
+
+	if(time < m_startTime) [[unlikely]]
 	{
-		for(U32 i = 0; i < channel.m_positions.getSize() - 1; ++i)
+		for(AnimationSample& sample : samples)
 		{
-			const AnimationKeyframe<Vec3>& left = channel.m_positions[i];
-			const AnimationKeyframe<Vec3>& right = channel.m_positions[i + 1];
-			if(time >= left.m_time && time <= right.m_time)
-			{
-				const Second u = (time - left.m_time) / (right.m_time - left.m_time);
-				pos = linearInterpolate(left.m_value, right.m_value, F32(u));
-				break;
-			}
+			sample = {Vec3(0.0f), Quat::getIdentity(), 1.0f};
 		}
+		return;
 	}
 
-	// Rotation
-	if(channel.m_rotations.getSize() > 1)
+	// Adjust the time once for all channels
+	if(time > m_startTime + m_duration)
 	{
-		for(U32 i = 0; i < channel.m_rotations.getSize() - 1; ++i)
-		{
-			const AnimationKeyframe<Quat>& left = channel.m_rotations[i];
-			const AnimationKeyframe<Quat>& right = channel.m_rotations[i + 1];
-			if(time >= left.m_time && time <= right.m_time)
-			{
-				const Second u = (time - left.m_time) / (right.m_time - left.m_time);
-				rot = left.m_value.slerp(right.m_value, F32(u));
-				break;
-			}
-		}
+		time = mod(time - m_startTime, m_duration) + m_startTime;
 	}
 
-	// Scale
-	if(channel.m_scales.getSize() > 1)
+	for(U32 i = 0; i < m_channels.getSize(); ++i)
 	{
-		for(U32 i = 0; i < channel.m_scales.getSize() - 1; ++i)
-		{
-			const AnimationKeyframe<F32>& left = channel.m_scales[i];
-			const AnimationKeyframe<F32>& right = channel.m_scales[i + 1];
-			if(time >= left.m_time && time <= right.m_time)
-			{
-				const Second u = (time - left.m_time) / (right.m_time - left.m_time);
-				scale = linearInterpolate(left.m_value, right.m_value, F32(u));
-				break;
-			}
-		}
+		sampleAnimationChannel(m_channels[i], time, cursors[i], samples[i]);
 	}
 }
 
+PtrSize AnimationResource::getKeysMemorySize() const
+{
+	PtrSize size = m_binaryData.getSizeInBytes();
+	for(const AnimationChannel& channel : m_channels)
+	{
+		size += channel.m_positions.getSizeInBytes() + channel.m_rotations.getSizeInBytes() + channel.m_scales.getSizeInBytes()
+				+ channel.m_cameraFovs.getSizeInBytes();
+	}
+
+	return size;
+}
+
 } // end namespace anki
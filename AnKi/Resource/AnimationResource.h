@@ -14,6 +14,7 @@ namespace anki {
 
 // Forward
 class XmlElement;
+class ResourceFile;
 
 /// @addtogroup resource
 /// @{
@@ -25,6 +26,14 @@ class AnimationKeyframe
 	friend class AnimationResource;
 
 public:
+	AnimationKeyframe() = default;
+
+	AnimationKeyframe(Second time, const T& value)
+		: m_time(time)
+		, m_value(value)
+	{
+	}
+
 	Second getTime() const
 	{
 		return m_time;
@@ -40,6 +49,19 @@ private:
 	T m_value;
 };
 
+/// Quantized keys of a channel as they are stored in an .ankianim. They point to the memory of the AnimationResource and they are sampled
+/// without decompressing them first. See AnimationBinaryTrack.
+class AnimationQuantizedTrack
+{
+public:
+	ConstWeakArray<F32> m_times;
+	const U16* m_values = nullptr;
+
+	/// A position or scale is m_min + U16 * m_scale.
+	Vec3 m_min = Vec3(0.0f);
+	Vec3 m_scale = Vec3(0.0f);
+};
+
 /// Animation channel
 class AnimationChannel
 {
@@ -52,8 +74,109 @@ public:
 	ResourceDynamicArray<AnimationKeyframe<Quat>> m_rotations;
 	ResourceDynamicArray<AnimationKeyframe<F32>> m_scales;
 	ResourceDynamicArray<AnimationKeyframe<F32>> m_cameraFovs;
+
+	/// @name Keys of binary animations. If they are present the keyframes above are empty
+	/// @{
+	AnimationQuantizedTrack m_quantizedPositions;
+	AnimationQuantizedTrack m_quantizedRotations;
+	AnimationQuantizedTrack m_quantizedScales;
+	/// @}
 };
 
+/// Remembers the keyframes a channel was last sampled at. Sampling a channel while time moves forward finds the next keyframes in
+/// constant time. It's owned by the user of the animation.
+class AnimationChannelCursor
+{
+public:
+	U32 m_position = 0;
+	U32 m_rotation = 0;
+	U32 m_scale = 0;
+};
+
+/// The result of sampling an animation channel.
+class AnimationSample
+{
+public:
+	Vec3 m_position;
+	Quat m_rotation;
+	F32 m_scale;
+};
+
+/// Find the 1st keyframe of the pair that contains a time. It first checks the keyframe pointed by the hint and the next one and falls
+/// back to a binary search.
+/// @param getTime A functor that returns the time of a keyframe given its index.
+/// @param[in,out] hint Hint of where to search and the result.
+/// @return False if the time is outside the keyframes.
+template<typename TGetTimeFunc>
+Bool findAnimationKeyframe(U32 keyCount, TGetTimeFunc getTime, Second time, U32& hint)
+{
+	ANKI_ASSERT(keyCount > 1);
+	const U32 lastPair = keyCount - 2;
+
+	if(time < getTime(0) || time > getTime(lastPair + 1)) [[unlikely]]
+	{
+		return false;
+	}
+
+	// Try the cached pair and the next one
+	for(U32 i = hint; i <= min(hint + 1, lastPair); ++i)
+	{
+		if(time >= getTime(i) && time <= getTime(i + 1))
+		{
+			hint = i;
+			return true;
+		}
+	}
+
+	// Binary search the last keyframe that is not after the time
+	U32 first = 0;
+	U32 count = lastPair + 1;
+	while(count > 0)
+	{
+		const U32 step = count / 2;
+		if(getTime(first + step) <= time)
+		{
+			first += step + 1;
+			count -= step + 1;
+		}
+		else
+		{
+			count = step;
+		}
+	}
+
+	hint = (first > 0) ? first - 1 : 0;
+	ANKI_ASSERT(time >= getTime(hint) && time <= getTime(hint + 1));
+	return true;
+}
+
+/// @copydoc findAnimationKeyframe
+template<typename T>
+Bool findAnimationKeyframe(ConstWeakArray<AnimationKeyframe<T>> keys, Second time, U32& hint)
+{
+	return findAnimationKeyframe(
+		keys.getSize(),
+		[&](U32 i) {
+			return keys[i].getTime();
+		},
+		time, hint);
+}
+
+/// @copydoc findAnimationKeyframe
+inline Bool findAnimationKeyframe(ConstWeakArray<F32> times, Second time, U32& hint)
+{
+	return findAnimationKeyframe(
+		times.getSize(),
+		[&](U32 i) {
+			return Second(times[i]);
+		},
+		time, hint);
+}
+
+/// Interpolate a channel. The time is the time of the keyframes, it doesn't wrap.
+/// @note It's thread-safe as long as the cursor is not shared.
+void sampleAnimationChannel(const AnimationChannel& channel, Second time, AnimationChannelCursor& cursor, AnimationSample& sample);
+
 /// Animation consists of keyframe data.
 class AnimationResource : public ResourceObject
 {
@@ -64,6 +187,9 @@ public:
 
 	Error load(const ResourceFilename& filename, Bool async);
 
+	/// Load an .ankianim from a file that is already open. load() calls it for binary animations.
+	Error loadBinary(ResourceFile& file);
+
 	/// Get a vector of all animation channels
 	ConstWeakArray<AnimationChannel> getChannels() const
 	{
@@ -83,12 +209,30 @@ public:
 	}
 
 	/// Get the interpolated data
-	void interpolate(U32 channelIndex, Second time, Vec3& position, Quat& rotation, F32& scale) const;
+	void interpolate(U32 channelIndex, Second time, Vec3& position, Quat& rotation, F32& scale) const
+	{
+		AnimationChannelCursor cursor;
+		interpolate(channelIndex, time, cursor, position, rotation, scale);
+	}
+
+	/// Same as interpolate() but it uses and updates a cursor to find the keyframes faster.
+	void interpolate(U32 channelIndex, Second time, AnimationChannelCursor& cursor, Vec3& position, Quat& rotation, F32& scale) const;
+
+	/// Sample all channels at once. Many callers can sample the same animation in parallel as long as they don't share cursors.
+	/// @param[in,out] cursors One cursor per channel.
+	/// @param[out] samples One sample per channel.
+	void sample(Second time, WeakArray<AnimationChannelCursor> cursors, WeakArray<AnimationSample> samples) const;
+
+	/// Get the memory that holds the keys of the animation.
+	PtrSize getKeysMemorySize() const;
 
 private:
 	ResourceDynamicArray<AnimationChannel> m_channels;
+	ResourceDynamicArray<U32> m_binaryData; ///< The data of the .ankianim. The quantized tracks point to it.
 	Second m_duration;
 	Second m_startTime;
+
+	Error loadXml(const ResourceFilename& filename);
 };
 /// @}
 
@@ -5,33 +5,78 @@
 
 #include <AnKi/Resource/AsyncLoader.h>
 #include <AnKi/Core/StatsSet.h>
+#include <AnKi/Core/CVarSet.h>
 #include <AnKi/Util/Logger.h>
 #include <AnKi/Util/Tracer.h>
+#include <AnKi/Util/System.h>
 
 namespace anki {
 
 static StatCounter g_asyncTasksInFlightStatVar(StatCategory::kMisc, "Async loader tasks", StatFlag::kNone);
 
+static NumericCVar<U32> g_asyncLoaderIoThreadCountCVar(CVarSubsystem::kResource, "AsyncLoaderIoThreadCount", 1, 1, 16,
+													   "Number of threads of the async loader that read files");
+static NumericCVar<U32> g_asyncLoaderProcessThreadCountCVar(CVarSubsystem::kResource, "AsyncLoaderProcessThreadCount",
+															max(1u, getCpuCoresCount() / 4u), 1, 64,
+															"Number of threads of the async loader that decode and upload resources");
+
+class AsyncLoader::Worker
+{
+public:
+	Thread m_thread;
+	AsyncLoader* m_loader;
+	AsyncLoaderTaskStage m_stage;
+
+	Worker(const Char* name, AsyncLoader* loader, AsyncLoaderTaskStage stage)
+		: m_thread(name)
+		, m_loader(loader)
+		, m_stage(stage)
+	{
+	}
+};
+
 AsyncLoader::AsyncLoader()
-	: m_thread("AsyncLoad")
 {
-	m_thread.start(this, threadCallback);
+	for(AsyncLoaderTaskStage stage : EnumIterable<AsyncLoaderTaskStage>())
+	{
+		const U32 threadCount =
+			(stage == AsyncLoaderTaskStage::kIo) ? g_asyncLoaderIoThreadCountCVar.get() : g_asyncLoaderProcessThreadCountCVar.get();
+
+		for(U32 i = 0; i < threadCount; ++i)
+		{
+			Array<Char, 32> name;
+			snprintf(&name[0], name.getSize(), "AsyncLoad%s%u", (stage == AsyncLoaderTaskStage::kIo) ? "Io" : "Proc", i);
+
+			Worker* worker = newInstance<Worker>(ResourceMemoryPool::getSingleton(), &name[0], this, stage);
+			m_workers.emplaceBack(worker);
+			worker->m_thread.start(worker, threadCallback);
+		}
+	}
 }
 
 AsyncLoader::~AsyncLoader()
 {
 	stop();
 
-	if(!m_taskQueue.isEmpty())
+	for(Worker* worker : m_workers)
+	{
+		deleteInstance(ResourceMemoryPool::getSingleton(), worker);
+	}
+
+	if(m_tasks.getSize())
 	{
 		ANKI_RESOURCE_LOGW("Stoping loading thread while there is work to do");
 
-		while(!m_taskQueue.isEmpty())
+		// The workers are done so all tasks are either queued or waiting for dependencies
+		IntrusiveList<AsyncLoaderTask> tasksToDelete;
+		for(AsyncLoaderTask* task : m_tasks)
 		{
-			AsyncLoaderTask* task = &m_taskQueue.getFront();
-			m_taskQueue.popFront();
-			deleteInstance(ResourceMemoryPool::getSingleton(), task);
+			task->m_canceled = true;
+			tasksToDelete.pushBack(task);
 		}
+
+		m_tasks.destroy();
+		deleteTasks(tasksToDelete);
 	}
 }
 
@@ -40,99 +85,326 @@ void AsyncLoader::stop()
 	{
 		LockGuard<Mutex> lock(m_mtx);
 		m_quit = true;
-		m_condVar.notifyOne();
+
+		for(ConditionVariable& condVar : m_condVars)
+		{
+			condVar.notifyAll();
+		}
 	}
 
-	[[maybe_unused]] Error err = m_thread.join();
+	for(Worker* worker : m_workers)
+	{
+		[[maybe_unused]] Error err = worker->m_thread.join();
+	}
 }
 
 Error AsyncLoader::threadCallback(ThreadCallbackInfo& info)
 {
-	AsyncLoader& self = *reinterpret_cast<AsyncLoader*>(info.m_userData);
-	return self.threadWorker();
+	Worker& worker = *reinterpret_cast<Worker*>(info.m_userData);
+	worker.m_loader->threadWorker(worker.m_stage);
+	return Error::kNone;
 }
 
-Error AsyncLoader::threadWorker()
+void AsyncLoader::threadWorker(AsyncLoaderTaskStage stage)
 {
-	Error err = Error::kNone;
-
-	while(!err)
+	while(true)
 	{
 		AsyncLoaderTask* task = nullptr;
-		Bool quit = false;
 
 		{
 			// Wait for something
 			LockGuard<Mutex> lock(m_mtx);
-			while(m_taskQueue.isEmpty() && !m_quit)
+			while(m_queues[stage].isEmpty() && !m_quit)
 			{
-				m_condVar.wait(m_mtx);
+				m_condVars[stage].wait(m_mtx);
 			}
 
-			// Do some work
 			if(m_quit)
 			{
-				quit = true;
+				break;
 			}
-			else
+
+			task = popFromQueue(stage);
+		}
+
+		// Exec the task
+		AsyncLoaderTaskContext ctx;
+		ctx.m_stage = stage;
+
+		Bool failed = false;
+		{
+			ANKI_TRACE_SCOPED_EVENT(RsrcAsyncTask);
+			if((*task)(ctx))
 			{
-				task = &m_taskQueue.getFront();
-				m_taskQueue.popFront();
+				ANKI_RESOURCE_LOGE("Async loader task failed");
+				ctx.m_resubmitTask = false;
+				failed = true;
 			}
 		}
 
-		if(quit)
+		// Do other stuff
+		IntrusiveList<AsyncLoaderTask> tasksToDelete;
 		{
-			break;
+			LockGuard<Mutex> lock(m_mtx);
+
+			if(ctx.m_resubmitTask)
+			{
+				task->m_stage = ctx.m_stage;
+				pushToQueue(task);
+			}
+			else
+			{
+				if(failed)
+				{
+					// The dependents can't run without this one
+					for(AsyncLoaderTask* dependent : task->m_dependents)
+					{
+						cancelTaskAndDependents(dependent);
+					}
+				}
+
+				finishTask(task, tasksToDelete);
+			}
 		}
-		else
-		{
-			// Exec the task
-			ANKI_ASSERT(task);
-			AsyncLoaderTaskContext ctx;
 
+		deleteTasks(tasksToDelete);
+	}
+}
+
+AsyncLoaderTaskId AsyncLoader::submitTask(AsyncLoaderTask* task, F32 priority, AsyncLoaderTaskStage stage,
+										  ConstWeakArray<AsyncLoaderTaskId> dependencies)
+{
+	ANKI_ASSERT(task && task->m_id == 0);
+
+	m_tasksInFlightCount.fetchAdd(1);
+	g_asyncTasksInFlightStatVar.increment(1);
+
+	IntrusiveList<AsyncLoaderTask> tasksToDelete;
+	AsyncLoaderTaskId id;
+	{
+		LockGuard<Mutex> lock(m_mtx);
+
+		id = m_nextTaskId++;
+		task->m_id = id;
+		task->m_priority = priority;
+		task->m_stage = stage;
+		m_tasks.emplace(id, task);
+
+		// Dependencies that are done are not in the map
+		for(AsyncLoaderTaskId dependencyId : dependencies)
+		{
+			auto it = m_tasks.find(dependencyId);
+			if(it != m_tasks.getEnd())
 			{
-				ANKI_TRACE_SCOPED_EVENT(RsrcAsyncTask);
-				err = (*task)(ctx);
-				g_asyncTasksInFlightStatVar.decrement(1);
+				AsyncLoaderTask& dependency = **it;
+				dependency.m_dependents.emplaceBack(task);
+				++task->m_unfinishedDependencyCount;
+				task->m_canceled = task->m_canceled || dependency.m_canceled;
 			}
+		}
 
-			if(!err)
+		if(task->m_unfinishedDependencyCount == 0)
+		{
+			if(task->m_canceled)
 			{
-				m_tasksInFlightCount.fetchSub(1);
+				finishTask(task, tasksToDelete);
 			}
 			else
 			{
-				ANKI_RESOURCE_LOGE("Async loader task failed");
+				pushToQueue(task);
 			}
+		}
+	}
 
-			// Do other stuff
-			if(ctx.m_resubmitTask)
+	deleteTasks(tasksToDelete);
+	return id;
+}
+
+Bool AsyncLoader::cancelTask(AsyncLoaderTaskId taskId)
+{
+	IntrusiveList<AsyncLoaderTask> tasksToDelete;
+
+	{
+		LockGuard<Mutex> lock(m_mtx);
+
+		auto it = m_tasks.find(taskId);
+		if(it == m_tasks.getEnd())
+		{
+			// It's done
+			return false;
+		}
+
+		AsyncLoaderTask* task = *it;
+		const Bool queued = task->m_queueIndex != kMaxU32;
+		const Bool waitingDependencies = task->m_unfinishedDependencyCount > 0;
+		if(!queued && !waitingDependencies)
+		{
+			// It's running
+			return false;
+		}
+
+		cancelTaskAndDependents(task);
+
+		if(queued)
+		{
+			removeFromQueue(task);
+			finishTask(task, tasksToDelete);
+		}
+		else
+		{
+			// Will be deleted when its dependencies are done
+		}
+	}
+
+	deleteTasks(tasksToDelete);
+	return true;
+}
+
+void AsyncLoader::cancelTaskAndDependents(AsyncLoaderTask* task)
+{
+	if(task->m_canceled)
+	{
+		return;
+	}
+
+	task->m_canceled = true;
+
+	// The dependents can't be queued or running since they wait for this one
+	for(AsyncLoaderTask* dependent : task->m_dependents)
+	{
+		cancelTaskAndDependents(dependent);
+	}
+}
+
+void AsyncLoader::finishTask(AsyncLoaderTask* task, IntrusiveList<AsyncLoaderTask>& tasksToDelete)
+{
+	ANKI_ASSERT(task->m_queueIndex == kMaxU32 && task->m_unfinishedDependencyCount == 0);
+
+	for(AsyncLoaderTask* dependent : task->m_dependents)
+	{
+		ANKI_ASSERT(dependent->m_unfinishedDependencyCount > 0);
+		--dependent->m_unfinishedDependencyCount;
+		if(dependent->m_unfinishedDependencyCount == 0)
+		{
+			if(dependent->m_canceled)
 			{
-				LockGuard<Mutex> lock(m_mtx);
-				m_taskQueue.pushBack(task);
+				finishTask(dependent, tasksToDelete);
 			}
 			else
 			{
-				// Delete the task
-				deleteInstance(ResourceMemoryPool::getSingleton(), task);
+				pushToQueue(dependent);
 			}
 		}
 	}
 
-	return err;
+	auto it = m_tasks.find(task->m_id);
+	ANKI_ASSERT(it != m_tasks.getEnd());
+	m_tasks.erase(it);
+
+	m_tasksInFlightCount.fetchSub(1);
+	g_asyncTasksInFlightStatVar.decrement(1);
+
+	tasksToDelete.pushBack(task);
 }
 
-void AsyncLoader::submitTask(AsyncLoaderTask* task)
+void AsyncLoader::deleteTasks(IntrusiveList<AsyncLoaderTask>& tasks)
 {
-	ANKI_ASSERT(task);
+	while(!tasks.isEmpty())
+	{
+		AsyncLoaderTask* task = &tasks.getFront();
+		tasks.popFront();
 
-	m_tasksInFlightCount.fetchAdd(1);
-	g_asyncTasksInFlightStatVar.increment(1);
+		if(task->m_canceled)
+		{
+			task->onCanceled();
+		}
 
-	LockGuard<Mutex> lock(m_mtx);
-	m_taskQueue.pushBack(task);
-	m_condVar.notifyOne();
+		deleteInstance(ResourceMemoryPool::getSingleton(), task);
+	}
+}
+
+Bool AsyncLoader::runsBefore(const AsyncLoaderTask& a, const AsyncLoaderTask& b)
+{
+	return a.m_priority > b.m_priority || (a.m_priority == b.m_priority && a.m_sequence < b.m_sequence);
+}
+
+void AsyncLoader::placeInQueue(ResourceDynamicArray<AsyncLoaderTask*>& queue, U32 idx, AsyncLoaderTask* task)
+{
+	// Sift up
+	while(idx > 0)
+	{
+		const U32 parentIdx = (idx - 1) / 2;
+		AsyncLoaderTask* parent = queue[parentIdx];
+		if(!runsBefore(*task, *parent))
+		{
+			break;
+		}
+
+		queue[idx] = parent;
+		parent->m_queueIndex = idx;
+		idx = parentIdx;
+	}
+
+	// Sift down
+	while(true)
+	{
+		const U32 leftIdx = idx * 2 + 1;
+		const U32 rightIdx = leftIdx + 1;
+		if(leftIdx >= queue.getSize())
+		{
+			break;
+		}
+
+		const U32 childIdx = (rightIdx < queue.getSize() && runsBefore(*queue[rightIdx], *queue[leftIdx])) ? rightIdx : leftIdx;
+		AsyncLoaderTask* child = queue[childIdx];
+		if(!runsBefore(*child, *task))
+		{
+			break;
+		}
+
+		queue[idx] = child;
+		child->m_queueIndex = idx;
+		idx = childIdx;
+	}
+
+	queue[idx] = task;
+	task->m_queueIndex = idx;
+}
+
+void AsyncLoader::pushToQueue(AsyncLoaderTask* task)
+{
+	ANKI_ASSERT(task->m_queueIndex == kMaxU32 && task->m_unfinishedDependencyCount == 0 && !task->m_canceled);
+	ResourceDynamicArray<AsyncLoaderTask*>& queue = m_queues[task->m_stage];
+
+	task->m_sequence = m_nextSequence++;
+	queue.emplaceBack(task);
+	placeInQueue(queue, queue.getSize() - 1, task);
+
+	m_condVars[task->m_stage].notifyOne();
+}
+
+AsyncLoaderTask* AsyncLoader::popFromQueue(AsyncLoaderTaskStage stage)
+{
+	ANKI_ASSERT(!m_queues[stage].isEmpty());
+	AsyncLoaderTask* task = m_queues[stage][0];
+	removeFromQueue(task);
+	return task;
+}
+
+void AsyncLoader::removeFromQueue(AsyncLoaderTask* task)
+{
+	ResourceDynamicArray<AsyncLoaderTask*>& queue = m_queues[task->m_stage];
+	ANKI_ASSERT(task->m_queueIndex < queue.getSize() && queue[task->m_queueIndex] == task);
+
+	// Move the last in the place of the removed one
+	const U32 removedIdx = task->m_queueIndex;
+	task->m_queueIndex = kMaxU32;
+	AsyncLoaderTask* last = queue.getBack();
+	queue.popBack();
+	if(last != task)
+	{
+		placeInQueue(queue, removedIdx, last);
+	}
 }
 
 } // end namespace anki
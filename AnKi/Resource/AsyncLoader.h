@@ -8,6 +8,8 @@
 #include <AnKi/Resource/Common.h>
 #include <AnKi/Util/Thread.h>
 #include <AnKi/Util/List.h>
+#include <AnKi/Util/HashMap.h>
+#include <AnKi/Util/WeakArray.h>
 
 namespace anki {
 
@@ -17,25 +19,62 @@ class AsyncLoader;
 /// @addtogroup resource
 /// @{
 
+/// The pipeline stages of the AsyncLoader. Every stage has its own workers and its own queue.
+enum class AsyncLoaderTaskStage : U8
+{
+	kIo, ///< Read files.
+	kProcess, ///< Decode, decompress, upload to the GPU.
+
+	kCount,
+	kFirst = 0
+};
+ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS(AsyncLoaderTaskStage)
+
+/// It identifies a task. Used for cancellation and dependencies. It's never reused.
+using AsyncLoaderTaskId = U64;
+
 class AsyncLoaderTaskContext
 {
 public:
 	/// Resubmit the same task at the end of the queue.
 	Bool m_resubmitTask = false;
+
+	/// The stage the task is running. Change it and set m_resubmitTask to continue the task in another stage (eg move to the
+	/// kProcess stage when the file is read).
+	AsyncLoaderTaskStage m_stage = AsyncLoaderTaskStage::kIo;
 };
 
 /// Interface for tasks for the AsyncLoader.
 class AsyncLoaderTask : public IntrusiveListEnabled<AsyncLoaderTask>
 {
+	friend class AsyncLoader;
+
 public:
 	virtual ~AsyncLoaderTask()
 	{
 	}
 
 	virtual Error operator()(AsyncLoaderTaskContext& ctx) = 0;
+
+	/// Called instead of operator() if the task got canceled. Tasks get canceled by AsyncLoader::cancelTask(), when one of their
+	/// dependencies failed or got canceled and when the AsyncLoader is destroyed before they run. Use it to let the owner know that the load
+	/// won't happen. It's called outside of the locks of the AsyncLoader, right before the task is deleted.
+	virtual void onCanceled()
+	{
+	}
+
+private:
+	AsyncLoaderTaskId m_id = 0;
+	U64 m_sequence = 0; ///< Tasks with the same priority run in the order they are queued.
+	F32 m_priority = 0.0f;
+	U32 m_queueIndex = kMaxU32; ///< The position in the queue or kMaxU32 if it's not queued.
+	U32 m_unfinishedDependencyCount = 0;
+	AsyncLoaderTaskStage m_stage = AsyncLoaderTaskStage::kIo;
+	Bool m_canceled = false;
+	ResourceDynamicArray<AsyncLoaderTask*> m_dependents; ///< The tasks that wait for this one.
 };
 
-/// Asynchronous resource loader.
+/// Asynchronous resource loader. It has a pool of workers for each AsyncLoaderTaskStage. Tasks run in order of priority.
 class AsyncLoader
 {
 public:
@@ -44,7 +83,11 @@ public:
 	~AsyncLoader();
 
 	/// Submit a task.
-	void submitTask(AsyncLoaderTask* task);
+	/// @param priority Tasks with higher priority run first. Eg the negative distance of the resource from the camera.
+	/// @param stage The first stage of the task.
+	/// @param dependencies The task will run after these tasks are done. If one of them fails or gets canceled the task gets canceled.
+	AsyncLoaderTaskId submitTask(AsyncLoaderTask* task, F32 priority = 0.0f, AsyncLoaderTaskStage stage = AsyncLoaderTaskStage::kIo,
+								 ConstWeakArray<AsyncLoaderTaskId> dependencies = {});
 
 	/// Create a new asynchronous loading task.
 	template<typename TTask, typename... TArgs>
@@ -55,24 +98,32 @@ public:
 
 	/// Create and submit a new asynchronous loading task.
 	template<typename TTask, typename... TArgs>
-	void submitNewTask(TArgs&&... args)
+	AsyncLoaderTaskId submitNewTask(TArgs&&... args)
 	{
-		submitTask(newTask<TTask>(std::forward<TArgs>(args)...));
+		return submitTask(newTask<TTask>(std::forward<TArgs>(args)...));
 	}
 
-	/// Get the total number of completed tasks.
+	/// Cancel a task that hasn't started running. The tasks that depend on it will be canceled as well. See AsyncLoaderTask::onCanceled().
+	/// @return True if the task was canceled, false if it's running or it's done.
+	Bool cancelTask(AsyncLoaderTaskId taskId);
+
+	/// Get the number of tasks that are not done.
 	U32 getTasksInFlightCount() const
 	{
 		return m_tasksInFlightCount.load();
 	}
 
 private:
-	Thread m_thread;
-	Barrier m_barrier = {2};
+	class Worker;
+
+	ResourceDynamicArray<Worker*> m_workers;
 
-	Mutex m_mtx;
-	ConditionVariable m_condVar;
-	IntrusiveList<AsyncLoaderTask> m_taskQueue;
+	Mutex m_mtx; ///< Protects everything bellow.
+	Array<ConditionVariable, U32(AsyncLoaderTaskStage::kCount)> m_condVars;
+	Array<ResourceDynamicArray<AsyncLoaderTask*>, U32(AsyncLoaderTaskStage::kCount)> m_queues; ///< Binary heaps, sorted by priority.
+	ResourceHashMap<AsyncLoaderTaskId, AsyncLoaderTask*> m_tasks; ///< All the tasks that are not done.
+	AsyncLoaderTaskId m_nextTaskId = 1;
+	U64 m_nextSequence = 0;
 	Bool m_quit = false;
 
 	Atomic<U32> m_tasksInFlightCount = {0};
@@ -80,9 +131,28 @@ private:
 	/// Thread callback
 	static Error threadCallback(ThreadCallbackInfo& info);
 
-	Error threadWorker();
+	void threadWorker(AsyncLoaderTaskStage stage);
 
 	void stop();
+
+	/// Return true if task a should run before task b.
+	static Bool runsBefore(const AsyncLoaderTask& a, const AsyncLoaderTask& b);
+
+	/// Put a task to a position of the heap and then move it up or down to keep the heap sorted.
+	static void placeInQueue(ResourceDynamicArray<AsyncLoaderTask*>& queue, U32 idx, AsyncLoaderTask* task);
+
+	void pushToQueue(AsyncLoaderTask* task);
+
+	AsyncLoaderTask* popFromQueue(AsyncLoaderTaskStage stage);
+
+	void removeFromQueue(AsyncLoaderTask* task);
+
+	/// Remove the task, wake up the tasks that depend on it and add it to the list of tasks to be deleted.
+	void finishTask(AsyncLoaderTask* task, IntrusiveList<AsyncLoaderTask>& tasksToDelete);
+
+	void cancelTaskAndDependents(AsyncLoaderTask* task);
+
+	static void deleteTasks(IntrusiveList<AsyncLoaderTask>& tasks);
 };
 /// @}
 
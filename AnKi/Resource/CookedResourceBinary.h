@@ -0,0 +1,310 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+// WARNING: This file is auto generated.
+
+#pragma once
+
+#include <AnKi/Resource/Common.h>
+#include <AnKi/ShaderCompiler/Common.h>
+
+namespace anki {
+
+/// @addtogroup resource
+/// @{
+
+/// Bump it when the layout of the cooked resources or the way they are cooked changes. It will invalidate all the cooked resources.
+inline constexpr U32 kCookedResourceVersion = 1;
+
+/// A bone of a cooked SkeletonResource.
+class CookedSkeletonBone
+{
+public:
+	/// Null terminated.
+	WeakArray<char> m_name;
+
+	/// The elements of a Mat3x4.
+	Array<F32, 12> m_transform;
+
+	/// The elements of a Mat3x4.
+	Array<F32, 12> m_vertexTransform;
+
+	/// Index of the parent bone or kMaxU32 for the root.
+	U32 m_parent = kMaxU32;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doValue("m_name", offsetof(CookedSkeletonBone, m_name), self.m_name);
+		s.doArray("m_transform", offsetof(CookedSkeletonBone, m_transform), &self.m_transform[0], self.m_transform.getSize());
+		s.doArray("m_vertexTransform", offsetof(CookedSkeletonBone, m_vertexTransform), &self.m_vertexTransform[0], self.m_vertexTransform.getSize());
+		s.doValue("m_parent", offsetof(CookedSkeletonBone, m_parent), self.m_parent);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, CookedSkeletonBone&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const CookedSkeletonBone&>(serializer, *this);
+	}
+};
+
+/// The cooked form of a SkeletonResource.
+class CookedSkeleton
+{
+public:
+	/// It should be the 1st member. See CookedResourceCache.
+	U64 m_sourceHash = 0;
+
+	WeakArray<CookedSkeletonBone> m_bones;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doValue("m_sourceHash", offsetof(CookedSkeleton, m_sourceHash), self.m_sourceHash);
+		s.doValue("m_bones", offsetof(CookedSkeleton, m_bones), self.m_bones);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, CookedSkeleton&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const CookedSkeleton&>(serializer, *this);
+	}
+};
+
+/// A patch of a cooked ModelResource.
+class CookedModelPatch
+{
+public:
+	/// Null terminated filename.
+	WeakArray<char> m_mesh;
+
+	/// Null terminated filename.
+	WeakArray<char> m_material;
+
+	U32 m_subMeshIndex = kMaxU32;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doValue("m_mesh", offsetof(CookedModelPatch, m_mesh), self.m_mesh);
+		s.doValue("m_material", offsetof(CookedModelPatch, m_material), self.m_material);
+		s.doValue("m_subMeshIndex", offsetof(CookedModelPatch, m_subMeshIndex), self.m_subMeshIndex);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, CookedModelPatch&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const CookedModelPatch&>(serializer, *this);
+	}
+};
+
+/// The cooked form of a ModelResource.
+class CookedModel
+{
+public:
+	/// It should be the 1st member. See CookedResourceCache.
+	U64 m_sourceHash = 0;
+
+	WeakArray<CookedModelPatch> m_patches;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doValue("m_sourceHash", offsetof(CookedModel, m_sourceHash), self.m_sourceHash);
+		s.doValue("m_patches", offsetof(CookedModel, m_patches), self.m_patches);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, CookedModel&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const CookedModel&>(serializer, *this);
+	}
+};
+
+/// The cooked form of a ParticleEmitterResource.
+class CookedParticleEmitter
+{
+public:
+	/// It should be the 1st member. See CookedResourceCache.
+	U64 m_sourceHash = 0;
+
+	/// The bytes of a ParticleEmitterProperties.
+	WeakArray<U8> m_properties;
+
+	/// Null terminated filename.
+	WeakArray<char> m_material;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doValue("m_sourceHash", offsetof(CookedParticleEmitter, m_sourceHash), self.m_sourceHash);
+		s.doValue("m_properties", offsetof(CookedParticleEmitter, m_properties), self.m_properties);
+		s.doValue("m_material", offsetof(CookedParticleEmitter, m_material), self.m_material);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, CookedParticleEmitter&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const CookedParticleEmitter&>(serializer, *this);
+	}
+};
+
+/// A mutator value set by a material.
+class CookedMaterialMutation
+{
+public:
+	/// Null terminated.
+	WeakArray<char> m_name;
+
+	MutatorValue m_value = 0;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doValue("m_name", offsetof(CookedMaterialMutation, m_name), self.m_name);
+		s.doValue("m_value", offsetof(CookedMaterialMutation, m_value), self.m_value);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, CookedMaterialMutation&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const CookedMaterialMutation&>(serializer, *this);
+	}
+};
+
+/// A shader program of a cooked MaterialResource.
+class CookedMaterialProgram
+{
+public:
+	/// Null terminated.
+	WeakArray<char> m_name;
+
+	WeakArray<CookedMaterialMutation> m_mutation;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doValue("m_name", offsetof(CookedMaterialProgram, m_name), self.m_name);
+		s.doValue("m_mutation", offsetof(CookedMaterialProgram, m_mutation), self.m_mutation);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, CookedMaterialProgram&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const CookedMaterialProgram&>(serializer, *this);
+	}
+};
+
+/// An input of a cooked MaterialResource. The type of the variable is known only after the programs are loaded so it keeps the value both as text and
+/// as numbers.
+class CookedMaterialInput
+{
+public:
+	/// Null terminated.
+	WeakArray<char> m_name;
+
+	/// Null terminated. The value as written in the XML. It's the filename of textures.
+	WeakArray<char> m_value;
+
+	/// The value converted to numbers. Empty if it's not a list of numbers.
+	WeakArray<F64> m_numbers;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doValue("m_name", offsetof(CookedMaterialInput, m_name), self.m_name);
+		s.doValue("m_value", offsetof(CookedMaterialInput, m_value), self.m_value);
+		s.doValue("m_numbers", offsetof(CookedMaterialInput, m_numbers), self.m_numbers);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, CookedMaterialInput&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const CookedMaterialInput&>(serializer, *this);
+	}
+};
+
+/// The cooked form of a MaterialResource.
+class CookedMaterial
+{
+public:
+	/// It should be the 1st member. See CookedResourceCache.
+	U64 m_sourceHash = 0;
+
+	WeakArray<CookedMaterialProgram> m_programs;
+	WeakArray<CookedMaterialInput> m_inputs;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doValue("m_sourceHash", offsetof(CookedMaterial, m_sourceHash), self.m_sourceHash);
+		s.doValue("m_programs", offsetof(CookedMaterial, m_programs), self.m_programs);
+		s.doValue("m_inputs", offsetof(CookedMaterial, m_inputs), self.m_inputs);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, CookedMaterial&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const CookedMaterial&>(serializer, *this);
+	}
+};
+
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,83 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Resource/CookedResourceCache.h>
+#include <AnKi/Resource/CookedResourceBinary.h>
+#include <AnKi/Util/Process.h>
+#include <AnKi/Util/Hash.h>
+#include <cstdio>
+
+namespace anki {
+
+Error CookedResourceCache::init(CString cacheDir)
+{
+	if(cacheDir.isEmpty())
+	{
+		return Error::kNone;
+	}
+
+	ResourceString dir;
+	dir.sprintf("%s/CookedResources", cacheDir.cstr());
+
+	if(!directoryExists(dir))
+	{
+		// Another process might create it at the same time
+		if(createDirectory(dir) && !directoryExists(dir))
+		{
+			ANKI_RESOURCE_LOGW("Failed to create the directory of the cooked resources. Resources will be cooked on every load: %s", dir.cstr());
+			return Error::kNone;
+		}
+	}
+
+	m_dir = std::move(dir);
+	return Error::kNone;
+}
+
+WeakArray<char> CookedResourceCache::newString(BaseMemoryPool& pool, CString str)
+{
+	const U32 length = str.getLength();
+	WeakArray<char> out = newArray<char>(pool, length + 1);
+	if(length)
+	{
+		memcpy(out.getBegin(), str.cstr(), length);
+	}
+	out[length] = '\0';
+	return out;
+}
+
+U64 CookedResourceCache::computeSourceHash(CString source, PtrSize cookedSize)
+{
+	const Array<U64, 2> desc = {kCookedResourceVersion, cookedSize};
+	return appendHash(source.cstr(), source.getLength(), computeHash(&desc[0], sizeof(desc)));
+}
+
+void CookedResourceCache::getEntryFilename(CString filename, ResourceString& fname) const
+{
+	fname.sprintf("%s/%016" PRIx64 ".ankicooked", m_dir.cstr(), filename.computeHash());
+}
+
+void CookedResourceCache::getTempEntryFilename(CString entryFilename, ResourceString& fname)
+{
+	fname.sprintf("%s.%u.%u.tmp", entryFilename.cstr(), getCurrentProcessId(), m_storeCount.fetchAdd(1));
+}
+
+void CookedResourceCache::commitEntry(CString tmpFilename, CString entryFilename, Error writeErr)
+{
+	// The rename is atomic. It might fail if some other process stored the same entry first (on Windows), that's fine
+	if(writeErr || std::rename(tmpFilename.cstr(), entryFilename.cstr()) != 0)
+	{
+		if(fileExists(tmpFilename))
+		{
+			[[maybe_unused]] const Error err = removeFile(tmpFilename);
+		}
+	}
+
+	if(writeErr)
+	{
+		ANKI_RESOURCE_LOGW("Failed to store the cooked resource: %s", entryFilename.cstr());
+	}
+}
+
+} // end namespace anki
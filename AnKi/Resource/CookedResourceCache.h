@@ -0,0 +1,164 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Resource/Common.h>
+#include <AnKi/Util/Serializer.h>
+#include <AnKi/Util/File.h>
+#include <AnKi/Util/Filesystem.h>
+#include <AnKi/Util/Atomic.h>
+
+namespace anki {
+
+/// @addtogroup resource
+/// @{
+
+/// A cache of the binary ("cooked") form of the resources that are written in XML. The first time such a resource is loaded its XML
+/// is parsed into one of the structures of CookedResourceBinary.h and the result is stored in the cache directory using the
+/// BinarySerializer. The next loads read that instead of parsing the XML. The entries are named after the hash of the filename of the
+/// resource and they hold the hash of the XML so an edited resource will be cooked again.
+class CookedResourceCache
+{
+public:
+	CookedResourceCache() = default;
+
+	CookedResourceCache(const CookedResourceCache&) = delete; // Non-copyable
+
+	CookedResourceCache& operator=(const CookedResourceCache&) = delete; // Non-copyable
+
+	/// @param cacheDir The cooked resources will be stored in a directory inside that. If it's empty the resources will be cooked every
+	///                 time they are loaded.
+	Error init(CString cacheDir);
+
+	/// Get the cooked form of a resource and initialize the resource from that.
+	/// @param filename The filename of the resource.
+	/// @param source The contents of the file of the resource.
+	/// @param cookFunc An Error(BaseMemoryPool& pool, TCooked& cooked) functor that parses the source. The arrays of the cooked structure
+	///                 should be allocated from the pool.
+	/// @param buildFunc An Error(const TCooked& cooked) functor that initializes the resource.
+	/// @note It's thread-safe.
+	template<typename TCooked, typename TCookFunc, typename TBuildFunc>
+	Error load(CString filename, CString source, TCookFunc cookFunc, TBuildFunc buildFunc);
+
+	/// Copy a string to a null terminated array allocated from the pool. Used by the cook functors.
+	static WeakArray<char> newString(BaseMemoryPool& pool, CString str);
+
+	/// Allocate an array from the pool. Used by the cook functors.
+	template<typename T>
+	static WeakArray<T> newArray(BaseMemoryPool& pool, U32 size)
+	{
+		if(size == 0)
+		{
+			return WeakArray<T>();
+		}
+
+		T* arr = static_cast<T*>(pool.allocate(sizeof(T) * size, alignof(T)));
+		for(U32 i = 0; i < size; ++i)
+		{
+			callConstructor(arr[i]);
+		}
+
+		return WeakArray<T>(arr, size);
+	}
+
+	U32 getHitCount() const
+	{
+		return m_hitCount.load();
+	}
+
+	U32 getMissCount() const
+	{
+		return m_missCount.load();
+	}
+
+private:
+	ResourceString m_dir;
+
+	Atomic<U32> m_hitCount = {0};
+	Atomic<U32> m_missCount = {0};
+	Atomic<U32> m_storeCount = {0};
+
+	static U64 computeSourceHash(CString source, PtrSize cookedSize);
+
+	void getEntryFilename(CString filename, ResourceString& fname) const;
+
+	void getTempEntryFilename(CString entryFilename, ResourceString& fname);
+
+	/// Store an entry. It's written to a temporary file that gets renamed so readers never see half-written entries. Failing to store
+	/// isn't fatal, the resource will be cooked again next time.
+	template<typename TCooked>
+	void store(CString entryFilename, const TCooked& cooked, BaseMemoryPool& tmpPool);
+
+	/// Rename the temporary file of store() or remove it if writing it failed.
+	void commitEntry(CString tmpFilename, CString entryFilename, Error writeErr);
+};
+
+template<typename TCooked, typename TCookFunc, typename TBuildFunc>
+Error CookedResourceCache::load(CString filename, CString source, TCookFunc cookFunc, TBuildFunc buildFunc)
+{
+	static_assert(offsetof(TCooked, m_sourceHash) == 0, "The hash is checked before anything else");
+	const U64 sourceHash = computeSourceHash(source, sizeof(TCooked));
+
+	ResourceString entryFilename;
+	if(!m_dir.isEmpty())
+	{
+		getEntryFilename(filename, entryFilename);
+
+		// Try the cache
+		File file;
+		TCooked* cooked = nullptr;
+		if(fileExists(entryFilename) && !file.open(entryFilename, FileOpenFlag::kRead | FileOpenFlag::kBinary)
+		   && !BinaryDeserializer::deserialize(cooked, ResourceMemoryPool::getSingleton(), file))
+		{
+			if(cooked->m_sourceHash == sourceHash)
+			{
+				m_hitCount.fetchAdd(1);
+				const Error err = buildFunc(std::as_const(*cooked));
+				ResourceMemoryPool::getSingleton().free(cooked);
+				return err;
+			}
+
+			ANKI_RESOURCE_LOGV("The cooked resource is stale: %s", filename.cstr());
+			ResourceMemoryPool::getSingleton().free(cooked);
+		}
+	}
+
+	// Not in the cache, cook it
+	m_missCount.fetchAdd(1);
+
+	StackMemoryPool pool(ResourceMemoryPool::getSingleton().getAllocationCallback(),
+						 ResourceMemoryPool::getSingleton().getAllocationCallbackUserData(), 4_KB);
+	TCooked cooked;
+	ANKI_CHECK(cookFunc(static_cast<BaseMemoryPool&>(pool), cooked));
+	cooked.m_sourceHash = sourceHash;
+
+	if(!entryFilename.isEmpty())
+	{
+		store(entryFilename, cooked, pool);
+	}
+
+	return buildFunc(std::as_const(cooked));
+}
+
+template<typename TCooked>
+void CookedResourceCache::store(CString entryFilename, const TCooked& cooked, BaseMemoryPool& tmpPool)
+{
+	ResourceString tmpFilename;
+	getTempEntryFilename(entryFilename, tmpFilename);
+
+	auto writeEntry = [&]() -> Error {
+		File file;
+		ANKI_CHECK(file.open(tmpFilename, FileOpenFlag::kWrite | FileOpenFlag::kBinary));
+		BinarySerializer serializer;
+		ANKI_CHECK(serializer.serialize(cooked, tmpPool, file));
+		return Error::kNone;
+	};
+
+	commitEntry(tmpFilename, entryFilename, writeEntry());
+}
+/// @}
+
+} // end namespace anki
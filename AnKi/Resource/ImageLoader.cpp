@@ -389,8 +389,8 @@ Error ImageLoader::loadTga(FileInterface& fs, U32& width, U32& height, U32& bpp,
 Error ImageLoader::loadAnkiImage(FileInterface& file, U32 maxImageSize, ImageBinaryDataCompression& preferredCompression,
 								 DynamicArray<ImageLoaderSurface, MemoryPoolPtrWrapper<BaseMemoryPool>>& surfaces,
 								 DynamicArray<ImageLoaderVolume, MemoryPoolPtrWrapper<BaseMemoryPool>>& volumes, U32& width, U32& height, U32& depth,
-								 U32& layerCount, U32& mipCount, ImageBinaryType& imageType, ImageBinaryColorFormat& colorFormat,
-								 UVec2& astcBlockSize)
+								 U32& layerCount, U32& mipCount, U32& skippedMipCount, ImageBinaryType& imageType,
+								 ImageBinaryColorFormat& colorFormat, UVec2& astcBlockSize)
 {
 	//
 	// Read and check the header
@@ -626,6 +626,8 @@ Error ImageLoader::loadAnkiImage(FileInterface& file, U32 maxImageSize, ImageBin
 		depth = volumes[0].m_depth;
 	}
 
+	skippedMipCount = header.m_mipmapCount - mipCount;
+
 	return Error::kNone;
 }
 
@@ -698,8 +700,27 @@ Error ImageLoader::load(const CString& filename, U32 maxImageSize)
 	return err;
 }
 
+void ImageLoader::destroy()
+{
+	m_surfaces.destroy();
+	m_volumes.destroy();
+	m_mipmapCount = 0;
+	m_skippedMipmapCount = 0;
+	m_width = 0;
+	m_height = 0;
+	m_depth = 0;
+	m_layerCount = 0;
+	m_astcBlockSize = UVec2(0u);
+	m_compression = ImageBinaryDataCompression::kNone;
+	m_colorFormat = ImageBinaryColorFormat::kNone;
+	m_imageType = ImageBinaryType::kNone;
+}
+
 Error ImageLoader::loadInternal(FileInterface& file, const CString& filename, U32 maxImageSize)
 {
+	// Start clean in case the loader is re-used
+	destroy();
+
 	// get the extension
 	String ext;
 	getFilepathExtension(filename, ext);
@@ -751,7 +772,7 @@ Error ImageLoader::loadInternal(FileInterface& file, const CString& filename, U3
 #endif
 
 		ANKI_CHECK(loadAnkiImage(file, maxImageSize, m_compression, m_surfaces, m_volumes, m_width, m_height, m_depth, m_layerCount, m_mipmapCount,
-								 m_imageType, m_colorFormat, m_astcBlockSize));
+								 m_skippedMipmapCount, m_imageType, m_colorFormat, m_astcBlockSize));
 	}
 	else if(ext == "png" || ext == "jpg")
 	{
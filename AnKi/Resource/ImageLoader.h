@@ -73,6 +73,12 @@ public:
 		return m_mipmapCount;
 	}
 
+	/// How many of the biggest mips were not loaded because they were bigger than the maxImageSize.
+	U32 getSkippedMipmapCount() const
+	{
+		return m_skippedMipmapCount;
+	}
+
 	U32 getWidth() const
 	{
 		return m_width;
@@ -130,6 +136,7 @@ private:
 	DynamicArray<ImageLoaderVolume, MemoryPoolPtrWrapper<BaseMemoryPool>> m_volumes;
 
 	U32 m_mipmapCount = 0;
+	U32 m_skippedMipmapCount = 0;
 	U32 m_width = 0;
 	U32 m_height = 0;
 	U32 m_depth = 0;
@@ -155,7 +162,8 @@ private:
 	static Error loadAnkiImage(FileInterface& file, U32 maxImageSize, ImageBinaryDataCompression& preferredCompression,
 							   DynamicArray<ImageLoaderSurface, MemoryPoolPtrWrapper<BaseMemoryPool>>& surfaces,
 							   DynamicArray<ImageLoaderVolume, MemoryPoolPtrWrapper<BaseMemoryPool>>& volumes, U32& width, U32& height, U32& depth,
-							   U32& layerCount, U32& mipCount, ImageBinaryType& imageType, ImageBinaryColorFormat& colorFormat, UVec2& astcBlockSize);
+							   U32& layerCount, U32& mipCount, U32& skippedMipCount, ImageBinaryType& imageType, ImageBinaryColorFormat& colorFormat,
+							   UVec2& astcBlockSize);
 
 	Error loadInternal(FileInterface& file, const CString& filename, U32 maxImageSize);
 };
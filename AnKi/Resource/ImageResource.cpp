@@ -7,12 +7,38 @@
 #include <AnKi/Resource/ImageLoader.h>
 #include <AnKi/Resource/ResourceManager.h>
 #include <AnKi/Resource/AsyncLoader.h>
+#include <AnKi/Resource/TextureResidencyManager.h>
+#include <AnKi/Resource/TextureUploadQueue.h>
 #include <AnKi/Core/CVarSet.h>
 #include <AnKi/Util/Filesystem.h>
 
 namespace anki {
 
 static NumericCVar<U32> g_maxImageSizeCVar(CVarSubsystem::kResource, "MaxImageSize", 1024u * 1024u, 4u, kMaxU32, "Max image size to load");
+static NumericCVar<U32> g_textureStreamingTailSizeCVar(CVarSubsystem::kResource, "TextureStreamingTailSize", 128u, 1u, 4096u,
+													   "The mips of the streamed images that are this size or smaller are always resident");
+
+/// The streaming goes after the regular loading.
+constexpr F32 kStreamingTaskPriority = -1.0f;
+
+static void transitionToSampled(Texture& tex)
+{
+	CommandBufferInitInfo cmdbinit;
+	cmdbinit.m_flags = CommandBufferFlag::kGeneralWork | CommandBufferFlag::kSmallBatch;
+	CommandBufferPtr cmdb = GrManager::getSingleton().newCommandBuffer(cmdbinit);
+
+	TextureSubresourceInfo subresource;
+	subresource.m_faceCount = textureTypeIsCube(tex.getTextureType()) ? 6 : 1;
+	subresource.m_layerCount = tex.getLayerCount();
+	subresource.m_mipmapCount = tex.getMipmapCount();
+
+	const TextureBarrierInfo barrier = {&tex, TextureUsageBit::kNone, TextureUsageBit::kAllSampled, subresource};
+	cmdb->setPipelineBarrier({&barrier, 1}, {}, {});
+
+	FencePtr outFence;
+	cmdb->flush({}, &outFence);
+	outFence->clientWait(60.0_sec);
+}
 
 class ImageResource::LoadingContext
 {
@@ -34,13 +60,51 @@ public:
 	{
 		return ImageResource::load(m_ctx);
 	}
+
+	void onCanceled() final
+	{
+		ANKI_RESOURCE_LOGW("The upload of an image got canceled. The texture will stay empty");
+	}
+};
+
+/// Reads the mips of a streamed image and then creates a new texture with them.
+class ImageResource::StreamingTask : public AsyncLoaderTask
+{
+public:
+	ImageResourcePtr m_image;
+	U32 m_firstMip = 0;
+	ImageResource::LoadingContext m_ctx;
+
+	Error operator()(AsyncLoaderTaskContext& ctx) final
+	{
+		if(m_image->stream(ctx, *this))
+		{
+			ANKI_RESOURCE_LOGE("Failed to stream image: %s", m_image->getFilename().cstr());
+
+			// Let the residency manager know
+			ResourceManager::getSingleton().textureStreamed(std::move(m_image), TexturePtr(), TextureViewPtr());
+		}
+
+		return Error::kNone;
+	}
+
+	void onCanceled() final
+	{
+		// The residency manager waits for the change to be done
+		ResourceManager::getSingleton().textureStreamed(std::move(m_image), TexturePtr(), TextureViewPtr());
+	}
 };
 
 ImageResource::~ImageResource()
 {
+	if(m_streamingHandle != kMaxU32)
+	{
+		LockGuard lock(ResourceManager::getSingleton().getTextureStreamingMutex());
+		ResourceManager::getSingleton().getTextureResidencyManager().unregisterTexture(m_streamingHandle);
+	}
 }
 
-Error ImageResource::load(const ResourceFilename& filename, Bool async)
+Error ImageResource::load(const ResourceFilename& filename, Bool async, Bool allowStreaming)
 {
 	TexUploadTask* task;
 	LoadingContext* ctx;
@@ -68,7 +132,29 @@ Error ImageResource::load(const ResourceFilename& filename, Bool async)
 	ResourceFilePtr file;
 	ANKI_CHECK(openFile(filename, file));
 
-	ANKI_CHECK(loader.load(file, filename, g_maxImageSizeCVar.get()));
+	// If the image will be streamed read only the small mips
+	const Bool streamingEnabled = allowStreaming && ResourceManager::getSingleton().getTextureStreamingEnabled();
+	const U32 maxImageSize = g_maxImageSizeCVar.get();
+	ANKI_CHECK(loader.load(file, filename, (streamingEnabled) ? min(maxImageSize, g_textureStreamingTailSizeCVar.get()) : maxImageSize));
+
+	// The full size of the image (the one that respects the MaxImageSize)
+	U32 fullWidth = loader.getWidth();
+	U32 fullHeight = loader.getHeight();
+	U32 fullMipCount = loader.getMipmapCount();
+	for(U32 i = 0; i < loader.getSkippedMipmapCount() && max(fullWidth, fullHeight) * 2 <= maxImageSize; ++i)
+	{
+		fullWidth *= 2;
+		fullHeight *= 2;
+		++fullMipCount;
+	}
+
+	const Bool streamed = streamingEnabled && loader.getImageType() == ImageBinaryType::k2D && fullMipCount > loader.getMipmapCount();
+	if(streamingEnabled && !streamed && fullMipCount > loader.getMipmapCount())
+	{
+		// Can't stream that type, load it whole
+		ANKI_CHECK(openFile(filename, file));
+		ANKI_CHECK(loader.load(file, filename, maxImageSize));
+	}
 
 	// Various sizes
 	init.m_width = loader.getWidth();
@@ -197,23 +283,7 @@ Error ImageResource::load(const ResourceFilename& filename, Bool async)
 	m_tex = GrManager::getSingleton().newTexture(init);
 
 	// Transition it. TODO remove that eventually
-	{
-		CommandBufferInitInfo cmdbinit;
-		cmdbinit.m_flags = CommandBufferFlag::kGeneralWork | CommandBufferFlag::kSmallBatch;
-		CommandBufferPtr cmdb = GrManager::getSingleton().newCommandBuffer(cmdbinit);
-
-		TextureSubresourceInfo subresource;
-		subresource.m_faceCount = textureTypeIsCube(init.m_type) ? 6 : 1;
-		subresource.m_layerCount = init.m_layerCount;
-		subresource.m_mipmapCount = init.m_mipmapCount;
-
-		const TextureBarrierInfo barrier = {m_tex.get(), TextureUsageBit::kNone, TextureUsageBit::kAllSampled, subresource};
-		cmdb->setPipelineBarrier({&barrier, 1}, {}, {});
-
-		FencePtr outFence;
-		cmdb->flush({}, &outFence);
-		outFence->clientWait(60.0_sec);
-	}
+	transitionToSampled(*m_tex);
 
 	// Set the context
 	ctx->m_faces = faces;
@@ -224,11 +294,14 @@ Error ImageResource::load(const ResourceFilename& filename, Bool async)
 	// Upload the data
 	if(async)
 	{
-		ResourceManager::getSingleton().getAsyncLoader().submitTask(task);
+		ResourceManager::getSingleton().getAsyncLoader().submitTask(task, 0.0f, AsyncLoaderTaskStage::kProcess);
 	}
 	else
 	{
 		ANKI_CHECK(load(*ctx));
+
+		// Don't wait for the end of the frame
+		ResourceManager::getSingleton().getTextureUploadQueue().flush();
 	}
 
 	m_size = UVec3(init.m_width, init.m_height, init.m_depth);
@@ -238,130 +311,157 @@ Error ImageResource::load(const ResourceFilename& filename, Bool async)
 	TextureViewInitInfo viewInit(m_tex.get(), "Rsrc");
 	m_texView = GrManager::getSingleton().newTextureView(viewInit);
 
+	// Register the image to the residency manager. The mips that are resident now are the tail
+	if(streamed)
+	{
+		m_size = UVec3(fullWidth, fullHeight, 1);
+		m_streamedMipCount = fullMipCount;
+		m_format = init.m_format;
+
+		ResourceDynamicArray<PtrSize> mipSizes;
+		mipSizes.resize(fullMipCount);
+		for(U32 mip = 0; mip < fullMipCount; ++mip)
+		{
+			mipSizes[mip] = computeSurfaceSize(max(fullWidth >> mip, 1u), max(fullHeight >> mip, 1u), m_format);
+		}
+
+		m_streamingHandle = ResourceManager::getSingleton().getTextureResidencyManager().registerTexture(mipSizes, init.m_mipmapCount, this);
+	}
+
 	return Error::kNone;
 }
 
-Error ImageResource::load(LoadingContext& ctx)
+void ImageResource::requestMip(U32 mip) const
 {
-	const U32 copyCount = ctx.m_layerCount * ctx.m_faces * ctx.m_loader.getMipmapCount();
+	if(isStreamed())
+	{
+		ResourceManager::getSingleton().getTextureResidencyManager().requestMip(m_streamingHandle, mip);
+	}
+}
 
-	for(U32 b = 0; b < copyCount; b += kMaxCopiesBeforeFlush)
+void ImageResource::requestScreenSize(F32 pixels) const
+{
+	if(isStreamed())
 	{
-		const U32 begin = b;
-		const U32 end = min(copyCount, b + kMaxCopiesBeforeFlush);
+		const F32 texels = F32(max(m_size.x(), m_size.y()));
+		const F32 mip = (pixels > 0.0f) ? log2(texels / pixels) : F32(m_streamedMipCount);
+		ResourceManager::getSingleton().getTextureResidencyManager().requestMip(m_streamingHandle, U32(clamp(mip, 0.0f, F32(m_streamedMipCount - 1))),
+																				pixels);
+	}
+}
 
-		CommandBufferInitInfo ci;
-		ci.m_flags = CommandBufferFlag::kGeneralWork | CommandBufferFlag::kSmallBatch;
-		CommandBufferPtr cmdb = GrManager::getSingleton().newCommandBuffer(ci);
+void ImageResource::submitStreamingTask(U32 firstMip, F32 screenSize)
+{
+	ANKI_ASSERT(isStreamed() && firstMip < m_streamedMipCount);
 
-		// Set the barriers of the batch
-		Array<TextureBarrierInfo, kMaxCopiesBeforeFlush> barriers;
-		U32 barrierCount = 0;
-		for(U32 i = begin; i < end; ++i)
-		{
-			U32 mip, layer, face;
-			unflatten3dArrayIndex(ctx.m_layerCount, ctx.m_faces, ctx.m_loader.getMipmapCount(), i, layer, face, mip);
+	StreamingTask* task = ResourceManager::getSingleton().getAsyncLoader().newTask<StreamingTask>();
+	task->m_image.reset(this);
+	task->m_firstMip = firstMip;
 
-			TextureBarrierInfo& barrier = barriers[barrierCount++];
-			barrier = {ctx.m_tex.get(), TextureUsageBit::kNone, TextureUsageBit::kTransferDestination, TextureSubresourceInfo()};
+	// The images that are closer (bigger on the screen) stream first. The priority stays in [kStreamingTaskPriority - 1, kStreamingTaskPriority)
+	const F32 priority = kStreamingTaskPriority - 1.0f / (1.0f + max(screenSize, 0.0f));
+	ResourceManager::getSingleton().getAsyncLoader().submitTask(task, priority);
+}
 
-			if(ctx.m_texType == TextureType::k3D)
-			{
-				barrier.m_subresource = TextureVolumeInfo(mip);
-				TextureVolumeInfo vol(mip);
-			}
-			else
-			{
-				barrier.m_subresource = TextureSurfaceInfo(mip, 0, face, layer);
-			}
-		}
-		cmdb->setPipelineBarrier({&barriers[0], barrierCount}, {}, {});
+void ImageResource::swapStreamedTexture(TexturePtr& tex, TextureViewPtr& texView)
+{
+	ANKI_ASSERT(isStreamed());
+	std::swap(m_tex, tex);
+	std::swap(m_texView, texView);
+}
 
-		// Do the copies
-		Array<TransferGpuAllocatorHandle, kMaxCopiesBeforeFlush> handles;
-		U32 handleCount = 0;
-		for(U32 i = begin; i < end; ++i)
-		{
-			U32 mip, layer, face;
-			unflatten3dArrayIndex(ctx.m_layerCount, ctx.m_faces, ctx.m_loader.getMipmapCount(), i, layer, face, mip);
+Error ImageResource::stream(AsyncLoaderTaskContext& taskCtx, StreamingTask& task)
+{
+	const U32 width = max(m_size.x() >> task.m_firstMip, 1u);
+	const U32 height = max(m_size.y() >> task.m_firstMip, 1u);
 
-			PtrSize surfOrVolSize;
-			const void* surfOrVolData;
-			PtrSize allocationSize;
+	if(taskCtx.m_stage == AsyncLoaderTaskStage::kIo)
+	{
+		// Read the mips. The loader will skip the ones that are bigger than the first mip
+		ResourceFilePtr file;
+		ANKI_CHECK(openFile(getFilename(), file));
+		ANKI_CHECK(task.m_ctx.m_loader.load(file, getFilename(), max(width, height)));
+		ANKI_ASSERT(task.m_ctx.m_loader.getMipmapCount() == m_streamedMipCount - task.m_firstMip);
+
+		// Continue with the upload
+		taskCtx.m_stage = AsyncLoaderTaskStage::kProcess;
+		taskCtx.m_resubmitTask = true;
+		return Error::kNone;
+	}
 
-			if(ctx.m_texType == TextureType::k3D)
-			{
-				const auto& vol = ctx.m_loader.getVolume(mip);
-				surfOrVolSize = vol.m_data.getSize();
-				surfOrVolData = &vol.m_data[0];
+	String filenameExt;
+	getFilepathFilename(getFilename(), filenameExt);
 
-				allocationSize = computeVolumeSize(ctx.m_tex->getWidth() >> mip, ctx.m_tex->getHeight() >> mip, ctx.m_tex->getDepth() >> mip,
-												   ctx.m_tex->getFormat());
-			}
-			else
-			{
-				const auto& surf = ctx.m_loader.getSurface(mip, face, layer);
-				surfOrVolSize = surf.m_data.getSize();
-				surfOrVolData = &surf.m_data[0];
+	TextureInitInfo init(filenameExt);
+	init.m_usage = TextureUsageBit::kAllSampled | TextureUsageBit::kTransferDestination;
+	init.m_type = TextureType::k2D;
+	init.m_width = width;
+	init.m_height = height;
+	init.m_format = m_format;
+	init.m_mipmapCount = U8(m_streamedMipCount - task.m_firstMip);
 
-				allocationSize = computeSurfaceSize(ctx.m_tex->getWidth() >> mip, ctx.m_tex->getHeight() >> mip, ctx.m_tex->getFormat());
-			}
+	TexturePtr tex = GrManager::getSingleton().newTexture(init);
+	transitionToSampled(*tex);
 
-			ANKI_ASSERT(allocationSize >= surfOrVolSize);
-			TransferGpuAllocatorHandle& handle = handles[handleCount++];
-			ANKI_CHECK(ResourceManager::getSingleton().getTransferGpuAllocator().allocate(allocationSize, handle));
-			void* data = handle.getMappedMemory();
-			ANKI_ASSERT(data);
+	task.m_ctx.m_faces = 1;
+	task.m_ctx.m_layerCount = 1;
+	task.m_ctx.m_texType = TextureType::k2D;
+	task.m_ctx.m_tex = tex;
+	ANKI_CHECK(load(task.m_ctx));
 
-			memcpy(data, surfOrVolData, surfOrVolSize);
+	TextureViewPtr texView = GrManager::getSingleton().newTextureView(TextureViewInitInfo(tex.get(), "RsrcStreamed"));
 
-			// Create temp tex view
-			TextureSubresourceInfo subresource;
-			if(ctx.m_texType == TextureType::k3D)
-			{
-				subresource = TextureSubresourceInfo(TextureVolumeInfo(mip));
-			}
-			else
-			{
-				subresource = TextureSubresourceInfo(TextureSurfaceInfo(mip, 0, face, layer));
-			}
+	// It will be swapped at the end of the frame
+	ResourceManager::getSingleton().textureStreamed(std::move(task.m_image), std::move(tex), std::move(texView));
 
-			TextureViewPtr tmpView = GrManager::getSingleton().newTextureView(TextureViewInitInfo(ctx.m_tex.get(), subresource, "RsrcTmp"));
+	return Error::kNone;
+}
 
-			cmdb->copyBufferToTextureView(&handle.getBuffer(), handle.getOffset(), handle.getRange(), tmpView.get());
-		}
+Error ImageResource::load(LoadingContext& ctx)
+{
+	TextureUploadQueue& uploadQueue = ResourceManager::getSingleton().getTextureUploadQueue();
+	const U32 copyCount = ctx.m_layerCount * ctx.m_faces * ctx.m_loader.getMipmapCount();
+
+	for(U32 i = 0; i < copyCount; ++i)
+	{
+		U32 mip, layer, face;
+		unflatten3dArrayIndex(ctx.m_layerCount, ctx.m_faces, ctx.m_loader.getMipmapCount(), i, layer, face, mip);
 
-		// Set the barriers of the batch
-		barrierCount = 0;
-		for(U32 i = begin; i < end; ++i)
+		PtrSize surfOrVolSize;
+		const void* surfOrVolData;
+		PtrSize allocationSize;
+		TextureSubresourceInfo subresource;
+
+		if(ctx.m_texType == TextureType::k3D)
 		{
-			U32 mip, layer, face;
-			unflatten3dArrayIndex(ctx.m_layerCount, ctx.m_faces, ctx.m_loader.getMipmapCount(), i, layer, face, mip);
+			const auto& vol = ctx.m_loader.getVolume(mip);
+			surfOrVolSize = vol.m_data.getSize();
+			surfOrVolData = &vol.m_data[0];
 
-			TextureBarrierInfo& barrier = barriers[barrierCount++];
-			barrier.m_previousUsage = TextureUsageBit::kTransferDestination;
-			barrier.m_nextUsage = TextureUsageBit::kSampledFragment | TextureUsageBit::kSampledGeometry;
+			allocationSize =
+				computeVolumeSize(ctx.m_tex->getWidth() >> mip, ctx.m_tex->getHeight() >> mip, ctx.m_tex->getDepth() >> mip, ctx.m_tex->getFormat());
+			subresource = TextureSubresourceInfo(TextureVolumeInfo(mip));
+		}
+		else
+		{
+			const auto& surf = ctx.m_loader.getSurface(mip, face, layer);
+			surfOrVolSize = surf.m_data.getSize();
+			surfOrVolData = &surf.m_data[0];
 
-			if(ctx.m_texType == TextureType::k3D)
-			{
-				barrier.m_subresource = TextureVolumeInfo(mip);
-			}
-			else
-			{
-				barrier.m_subresource = TextureSurfaceInfo(mip, 0, face, layer);
-			}
+			allocationSize = computeSurfaceSize(ctx.m_tex->getWidth() >> mip, ctx.m_tex->getHeight() >> mip, ctx.m_tex->getFormat());
+			subresource = TextureSubresourceInfo(TextureSurfaceInfo(mip, 0, face, layer));
 		}
-		cmdb->setPipelineBarrier({&barriers[0], barrierCount}, {}, {});
 
-		// Flush batch
-		FencePtr fence;
-		cmdb->flush({}, &fence);
+		ANKI_ASSERT(allocationSize >= surfOrVolSize);
+		TransferGpuAllocatorHandle handle;
+		ANKI_CHECK(uploadQueue.allocate(allocationSize, handle));
+		void* data = handle.getMappedMemory();
+		ANKI_ASSERT(data);
 
-		for(U i = 0; i < handleCount; ++i)
-		{
-			ResourceManager::getSingleton().getTransferGpuAllocator().release(handles[i], fence);
-		}
-		cmdb.reset(nullptr);
+		memcpy(data, surfOrVolData, surfOrVolSize);
+
+		// The copy will be batched with the copies of other images
+		uploadQueue.pushCopy(handle, *ctx.m_tex, subresource);
 	}
 
 	return Error::kNone;
@@ -10,11 +10,18 @@
 
 namespace anki {
 
+// Forward
+class AsyncLoaderTaskContext;
+
 /// @addtogroup resource
 /// @{
 
 /// Image resource class. It loads or creates an image and then loads it in the GPU. It supports compressed and uncompressed TGAs, PNGs, JPEG and
 /// AnKi's image format.
+///
+/// If texture streaming is enabled the 2D images that are loaded with ResourceManager::loadStreamedImage() start with only their smallest
+/// mips resident. The TextureResidencyManager decides when to load or evict the rest based on the mips that get requested (see
+/// requestMip()). The texture (and its view) gets replaced when the resident mips change. The rest of the images are loaded whole.
 class ImageResource : public ResourceObject
 {
 public:
@@ -23,9 +30,10 @@ public:
 	~ImageResource();
 
 	/// Load an image.
-	Error load(const ResourceFilename& filename, Bool async);
+	/// @param allowStreaming Stream the mips of the image if texture streaming is enabled. See ResourceManager::loadStreamedImage().
+	Error load(const ResourceFilename& filename, Bool async, Bool allowStreaming = false);
 
-	/// Get the texture.
+	/// Get the texture. If the image is streamed it might have less mips than the image (and smaller size).
 	Texture& getTexture() const
 	{
 		return *m_tex;
@@ -61,10 +69,38 @@ public:
 		return m_layerCount;
 	}
 
-private:
-	static constexpr U32 kMaxCopiesBeforeFlush = 4;
+	/// Return true if the mips of the image are streamed.
+	Bool isStreamed() const
+	{
+		return m_streamingHandle != kMaxU32;
+	}
 
+	/// Request the mip the image needs to be sampled at. Mip 0 is the biggest. It does nothing if the image is not streamed.
+	/// @note It's thread-safe.
+	void requestMip(U32 mip) const;
+
+	/// Same as requestMip() but it computes the mip from the size in pixels the image covers on the screen.
+	/// @note It's thread-safe.
+	void requestScreenSize(F32 pixels) const;
+
+	// Internals:
+
+	ANKI_INTERNAL U32 getStreamingHandle() const
+	{
+		ANKI_ASSERT(isStreamed());
+		return m_streamingHandle;
+	}
+
+	/// Load or evict mips so the resident mips start from firstMip.
+	/// @param screenSize The size of the image on the screen (see TextureResidencyChange::m_screenSize). It's the priority of the task.
+	ANKI_INTERNAL void submitStreamingTask(U32 firstMip, F32 screenSize);
+
+	/// Swap the texture with the one the streaming created.
+	ANKI_INTERNAL void swapStreamedTexture(TexturePtr& tex, TextureViewPtr& texView);
+
+private:
 	class TexUploadTask;
+	class StreamingTask;
 	class LoadingContext;
 
 	TexturePtr m_tex;
@@ -72,7 +108,16 @@ private:
 	UVec3 m_size = UVec3(0u);
 	U32 m_layerCount = 0;
 
+	/// @name Streaming
+	/// @{
+	U32 m_streamingHandle = kMaxU32; ///< Handle in the TextureResidencyManager.
+	U32 m_streamedMipCount = 0;
+	Format m_format = Format::kNone;
+	/// @}
+
 	[[nodiscard]] static Error load(LoadingContext& ctx);
+
+	[[nodiscard]] Error stream(AsyncLoaderTaskContext& taskCtx, StreamingTask& task);
 };
 /// @}
 
@@ -6,7 +6,11 @@
 #include <AnKi/Resource/MaterialResource.h>
 #include <AnKi/Resource/ResourceManager.h>
 #include <AnKi/Resource/ImageResource.h>
+#include <AnKi/Resource/CookedResourceCache.h>
+#include <AnKi/Resource/CookedResourceBinary.h>
 #include <AnKi/Util/Xml.h>
+#include <AnKi/Util/StringList.h>
+#include <cerrno>
 
 namespace anki {
 
@@ -14,7 +18,7 @@ inline constexpr Array<CString, U32(BuiltinMutatorId::kCount)> kBuiltinMutatorNa
 
 inline constexpr Array<CString, U(RenderingTechnique::kCount)> kTechniqueNames = {{"GBuffer", "Depth", "Forward", "RtShadow"}};
 
-// This is some trickery to select calling between XmlElement::getAttributeNumber and XmlElement::getAttributeNumbers
+// This is some trickery to find if a type of ShaderVariableDataType has an operator[]
 namespace {
 
 template<typename T>
@@ -34,27 +38,62 @@ public:
 #include <AnKi/Gr/ShaderVariableDataType.defs.h>
 #undef ANKI_SVDT_MACRO
 
-template<typename T, Bool isArray = IsShaderVarDataTypeAnArray<T>::kValue>
-class GetAttribute
+} // namespace
+
+/// Convert the numbers of a cooked input to the type of the variable.
+template<typename T, typename TBase, U32 kComponentCount>
+static Error convertInputNumbers(CString varName, ConstWeakArray<F64> numbers, T& out)
 {
-public:
-	Error operator()(const XmlElement& el, T& out)
+	if(numbers.getSize() != kComponentCount)
 	{
-		return el.getAttributeNumbers("value", out);
+		ANKI_RESOURCE_LOGE("Wrong number of elements for input: %s", varName.cstr());
+		return Error::kUserData;
 	}
-};
 
-template<typename T>
-class GetAttribute<T, false>
+	for(U32 i = 0; i < kComponentCount; ++i)
+	{
+		if(std::is_integral<TBase>::value && numbers[i] != std::floor(numbers[i]))
+		{
+			ANKI_RESOURCE_LOGE("Expecting integers for input: %s", varName.cstr());
+			return Error::kUserData;
+		}
+
+		if constexpr(IsShaderVarDataTypeAnArray<T>::kValue)
+		{
+			out[i] = TBase(numbers[i]);
+		}
+		else
+		{
+			out = TBase(numbers[i]);
+		}
+	}
+
+	return Error::kNone;
+}
+
+/// Convert the value of an input to numbers. Unlike XmlElement::getAttributeNumbers() it doesn't complain if it's not a list of numbers
+/// since it might be a texture.
+static WeakArray<F64> parseInputNumbers(CString value, BaseMemoryPool& pool)
 {
-public:
-	Error operator()(const XmlElement& el, T& out)
+	ResourceStringList tokens;
+	tokens.splitString(value, ' ');
+
+	WeakArray<F64> numbers = CookedResourceCache::newArray<F64>(pool, U32(tokens.getSize()));
+	U32 count = 0;
+	for(const ResourceString& token : tokens)
 	{
-		return el.getAttributeNumber("value", out);
+		errno = 0;
+		char* end;
+		numbers[count++] = std::strtod(token.cstr(), &end);
+		if(errno || end != token.cstr() + token.getLength())
+		{
+			errno = 0;
+			return WeakArray<F64>();
+		}
 	}
-};
 
-} // namespace
+	return numbers;
+}
 
 MaterialVariable::MaterialVariable()
 {
@@ -136,10 +175,24 @@ const MaterialVariable* MaterialResource::tryFindVariableInternal(CString name)
 }
 
 Error MaterialResource::load(const ResourceFilename& filename, Bool async)
+{
+	ResourceString source;
+	ANKI_CHECK(openFileReadAllText(filename, source));
+
+	return ResourceManager::getSingleton().getCookedResourceCache().load<CookedMaterial>(
+		filename, source,
+		[&](BaseMemoryPool& pool, CookedMaterial& cooked) {
+			return cook(source, pool, cooked);
+		},
+		[&](const CookedMaterial& cooked) {
+			return build(cooked, async);
+		});
+}
+
+Error MaterialResource::cook(CString source, BaseMemoryPool& pool, CookedMaterial& cooked)
 {
 	ResourceXmlDocument doc;
-	XmlElement el;
-	ANKI_CHECK(openFileParseXml(filename, doc));
+	ANKI_CHECK(doc.parse(source));
 
 	// <material>
 	XmlElement rootEl;
@@ -150,28 +203,135 @@ Error MaterialResource::load(const ResourceFilename& filename, Bool async)
 	ANKI_CHECK(rootEl.getChildElement("shaderPrograms", shaderProgramsEl));
 	XmlElement shaderProgramEl;
 	ANKI_CHECK(shaderProgramsEl.getChildElement("shaderProgram", shaderProgramEl));
+
+	U32 count = 0;
+	ANKI_CHECK(shaderProgramEl.getSiblingElementsCount(count));
+	cooked.m_programs = CookedResourceCache::newArray<CookedMaterialProgram>(pool, count + 1);
+
+	count = 0;
 	do
 	{
-		ANKI_CHECK(parseShaderProgram(shaderProgramEl, async));
+		ANKI_CHECK(cookShaderProgram(shaderProgramEl, pool, cooked.m_programs[count++]));
 		ANKI_CHECK(shaderProgramEl.getNextSiblingElement("shaderProgram", shaderProgramEl));
 	} while(shaderProgramEl);
 
-	ANKI_ASSERT(!!m_techniquesMask);
-
 	// <inputs>
-	BitSet<128> varsSet(false);
+	XmlElement el;
 	ANKI_CHECK(rootEl.getChildElementOptional("inputs", el));
 	if(el)
 	{
 		XmlElement inputEl;
 		ANKI_CHECK(el.getChildElement("input", inputEl));
+
+		ANKI_CHECK(inputEl.getSiblingElementsCount(count));
+		cooked.m_inputs = CookedResourceCache::newArray<CookedMaterialInput>(pool, count + 1);
+
+		count = 0;
 		do
 		{
-			ANKI_CHECK(parseInput(inputEl, async, varsSet));
+			CookedMaterialInput& input = cooked.m_inputs[count++];
+
+			CString cstr;
+			ANKI_CHECK(inputEl.getAttributeText("name", cstr));
+			input.m_name = CookedResourceCache::newString(pool, cstr);
+
+			ANKI_CHECK(inputEl.getAttributeText("value", cstr));
+			input.m_value = CookedResourceCache::newString(pool, cstr);
+			input.m_numbers = parseInputNumbers(cstr, pool);
+
 			ANKI_CHECK(inputEl.getNextSiblingElement("input", inputEl));
 		} while(inputEl);
 	}
 
+	return Error::kNone;
+}
+
+Error MaterialResource::cookShaderProgram(XmlElement shaderProgramEl, BaseMemoryPool& pool, CookedMaterialProgram& cooked)
+{
+	// name
+	CString cstr;
+	ANKI_CHECK(shaderProgramEl.getAttributeText("name", cstr));
+	cooked.m_name = CookedResourceCache::newString(pool, cstr);
+
+	// <mutation>
+	XmlElement mutatorsEl;
+	ANKI_CHECK(shaderProgramEl.getChildElementOptional("mutation", mutatorsEl));
+	if(!mutatorsEl)
+	{
+		return Error::kNone;
+	}
+
+	XmlElement mutatorEl;
+	ANKI_CHECK(mutatorsEl.getChildElement("mutator", mutatorEl));
+
+	U32 mutatorCount = 0;
+	ANKI_CHECK(mutatorEl.getSiblingElementsCount(mutatorCount));
+	cooked.m_mutation = CookedResourceCache::newArray<CookedMaterialMutation>(pool, mutatorCount + 1);
+	mutatorCount = 0;
+
+	do
+	{
+		CookedMaterialMutation& mutation = cooked.m_mutation[mutatorCount];
+
+		// name
+		CString mutatorName;
+		ANKI_CHECK(mutatorEl.getAttributeText("name", mutatorName));
+		if(mutatorName.isEmpty())
+		{
+			ANKI_RESOURCE_LOGE("Mutator name is empty");
+			return Error::kUserData;
+		}
+
+		for(BuiltinMutatorId id : EnumIterable<BuiltinMutatorId>())
+		{
+			if(id == BuiltinMutatorId::kNone)
+			{
+				continue;
+			}
+
+			if(mutatorName == kBuiltinMutatorNames[id])
+			{
+				ANKI_RESOURCE_LOGE("Materials shouldn't list builtin mutators: %s", mutatorName.cstr());
+				return Error::kUserData;
+			}
+		}
+
+		if(mutatorName.find("ANKI_") == 0)
+		{
+			ANKI_RESOURCE_LOGE("Mutators can't start with ANKI_: %s", mutatorName.cstr());
+			return Error::kUserData;
+		}
+
+		mutation.m_name = CookedResourceCache::newString(pool, mutatorName);
+
+		// value
+		ANKI_CHECK(mutatorEl.getAttributeNumber("value", mutation.m_value));
+
+		// Advance
+		++mutatorCount;
+		ANKI_CHECK(mutatorEl.getNextSiblingElement("mutator", mutatorEl));
+	} while(mutatorEl);
+
+	ANKI_ASSERT(mutatorCount == cooked.m_mutation.getSize());
+
+	return Error::kNone;
+}
+
+Error MaterialResource::build(const CookedMaterial& cooked, Bool async)
+{
+	for(const CookedMaterialProgram& cookedProg : cooked.m_programs)
+	{
+		ANKI_CHECK(buildShaderProgram(cookedProg, async));
+	}
+
+	ANKI_ASSERT(!!m_techniquesMask);
+
+	BitSet<128> varsSet(false);
+	for(const CookedMaterialInput& input : cooked.m_inputs)
+	{
+		ANKI_CHECK(buildInput(input, async, varsSet));
+	}
+
 	if(varsSet.getSetBitCount() != m_vars.getSize())
 	{
 		ANKI_RESOURCE_LOGE("Forgot to set a default value in %u input variables", U32(m_vars.getSize() - varsSet.getSetBitCount()));
@@ -183,11 +343,9 @@ Error MaterialResource::load(const ResourceFilename& filename, Bool async)
 	return Error::kNone;
 }
 
-Error MaterialResource::parseShaderProgram(XmlElement shaderProgramEl, Bool async)
+Error MaterialResource::buildShaderProgram(const CookedMaterialProgram& cooked, Bool async)
 {
-	// name
-	CString shaderName;
-	ANKI_CHECK(shaderProgramEl.getAttributeText("name", shaderName));
+	const CString shaderName = cooked.m_name.getBegin();
 
 	if(!GrManager::getSingleton().getDeviceCapabilities().m_rayTracingEnabled && shaderName.find("Rt") == 0)
 	{
@@ -201,12 +359,10 @@ Error MaterialResource::parseShaderProgram(XmlElement shaderProgramEl, Bool asyn
 	Program& prog = *m_programs.emplaceBack();
 	ANKI_CHECK(ResourceManager::getSingleton().loadResource(fname, prog.m_prog, async));
 
-	// <mutation>
-	XmlElement mutatorsEl;
-	ANKI_CHECK(shaderProgramEl.getChildElementOptional("mutation", mutatorsEl));
-	if(mutatorsEl)
+	// Mutation
+	if(cooked.m_mutation.getSize())
 	{
-		ANKI_CHECK(parseMutators(mutatorsEl, prog));
+		ANKI_CHECK(buildMutators(cooked.m_mutation, prog));
 	}
 
 	// And find the builtin mutators
@@ -417,53 +573,15 @@ Error MaterialResource::createVars(Program& prog)
 	return Error::kNone;
 }
 
-Error MaterialResource::parseMutators(XmlElement mutatorsEl, Program& prog)
+Error MaterialResource::buildMutators(ConstWeakArray<CookedMaterialMutation> mutation, Program& prog)
 {
-	XmlElement mutatorEl;
-	ANKI_CHECK(mutatorsEl.getChildElement("mutator", mutatorEl));
-
-	U32 mutatorCount = 0;
-	ANKI_CHECK(mutatorEl.getSiblingElementsCount(mutatorCount));
-	++mutatorCount;
-	ANKI_ASSERT(mutatorCount > 0);
-	prog.m_partialMutation.resize(mutatorCount);
-	mutatorCount = 0;
+	prog.m_partialMutation.resize(mutation.getSize());
 
-	do
+	for(U32 i = 0; i < mutation.getSize(); ++i)
 	{
-		PartialMutation& pmutation = prog.m_partialMutation[mutatorCount];
-
-		// name
-		CString mutatorName;
-		ANKI_CHECK(mutatorEl.getAttributeText("name", mutatorName));
-		if(mutatorName.isEmpty())
-		{
-			ANKI_RESOURCE_LOGE("Mutator name is empty");
-			return Error::kUserData;
-		}
-
-		for(BuiltinMutatorId id : EnumIterable<BuiltinMutatorId>())
-		{
-			if(id == BuiltinMutatorId::kNone)
-			{
-				continue;
-			}
-
-			if(mutatorName == kBuiltinMutatorNames[id])
-			{
-				ANKI_RESOURCE_LOGE("Materials shouldn't list builtin mutators: %s", mutatorName.cstr());
-				return Error::kUserData;
-			}
-		}
-
-		if(mutatorName.find("ANKI_") == 0)
-		{
-			ANKI_RESOURCE_LOGE("Mutators can't start with ANKI_: %s", mutatorName.cstr());
-			return Error::kUserData;
-		}
-
-		// value
-		ANKI_CHECK(mutatorEl.getAttributeNumber("value", pmutation.m_value));
+		PartialMutation& pmutation = prog.m_partialMutation[i];
+		const CString mutatorName = mutation[i].m_name.getBegin();
+		pmutation.m_value = mutation[i].m_value;
 
 		// Find mutator
 		pmutation.m_mutator = prog.m_prog->tryFindMutator(mutatorName);
@@ -479,13 +597,7 @@ Error MaterialResource::parseMutators(XmlElement mutatorsEl, Program& prog)
 			ANKI_RESOURCE_LOGE("Value %d is not part of the mutator %s", pmutation.m_value, mutatorName.cstr());
 			return Error::kUserData;
 		}
-
-		// Advance
-		++mutatorCount;
-		ANKI_CHECK(mutatorEl.getNextSiblingElement("mutator", mutatorEl));
-	} while(mutatorEl);
-
-	ANKI_ASSERT(mutatorCount == prog.m_partialMutation.getSize());
+	}
 
 	return Error::kNone;
 }
@@ -590,11 +702,9 @@ Error MaterialResource::findBuiltinMutators(Program& prog)
 	return Error::kNone;
 }
 
-Error MaterialResource::parseInput(XmlElement inputEl, Bool async, BitSet<128>& varsSet)
+Error MaterialResource::buildInput(const CookedMaterialInput& input, Bool async, BitSet<128>& varsSet)
 {
-	// Get var name
-	CString varName;
-	ANKI_CHECK(inputEl.getAttributeText("name", varName));
+	const CString varName = input.m_name.getBegin();
 
 	// Try find var
 	MaterialVariable* foundVar = tryFindVariable(varName);
@@ -614,43 +724,19 @@ Error MaterialResource::parseInput(XmlElement inputEl, Bool async, BitSet<128>&
 	varsSet.set(idx);
 
 	// Set the value
+	const CString value = input.m_value.getBegin();
 	if(foundVar->isBoundableTexture())
 	{
-		CString texfname;
-		ANKI_CHECK(inputEl.getAttributeText("value", texfname));
-		ANKI_CHECK(ResourceManager::getSingleton().loadResource(texfname, foundVar->m_image, async));
+		ANKI_CHECK(ResourceManager::getSingleton().loadResource(value, foundVar->m_image, async));
 
 		m_textures.emplaceBack(&foundVar->m_image->getTexture());
 	}
-	else if(foundVar->m_dataType == ShaderVariableDataType::kU32)
+	else if(foundVar->m_dataType == ShaderVariableDataType::kU32 && input.m_numbers.getSize() == 0)
 	{
-		// U32 is a bit special. It might be a number or a bindless texture
-
-		CString value;
-		ANKI_CHECK(inputEl.getAttributeText("value", value));
-
-		// Check if the value has letters
-		Bool containsAlpharithmetic = false;
-		for(Char c : value)
-		{
-			if((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'a'))
-			{
-				containsAlpharithmetic = true;
-				break;
-			}
-		}
-
-		// If it has letters it's a texture
-		if(containsAlpharithmetic)
-		{
-			ANKI_CHECK(ResourceManager::getSingleton().loadResource(value, foundVar->m_image, async));
+		// U32 is a bit special. If it's not a number it's a bindless texture. The users of the material request the mips of those
+		ANKI_CHECK(ResourceManager::getSingleton().loadStreamedImage(value, foundVar->m_image, async));
 
-			foundVar->m_U32 = foundVar->m_image->getTextureView().getOrCreateBindlessTextureIndex();
-		}
-		else
-		{
-			ANKI_CHECK(GetAttribute<U32>()(inputEl, foundVar->m_U32));
-		}
+		foundVar->m_U32 = foundVar->m_image->getTextureView().getOrCreateBindlessTextureIndex();
 	}
 	else
 	{
@@ -658,7 +744,7 @@ Error MaterialResource::parseInput(XmlElement inputEl, Bool async, BitSet<128>&
 		{
 #define ANKI_SVDT_MACRO(type, baseType, rowCount, columnCount, isIntagralType) \
 	case ShaderVariableDataType::k##type: \
-		ANKI_CHECK(GetAttribute<type>()(inputEl, foundVar->ANKI_CONCATENATE(m_, type))); \
+		ANKI_CHECK((convertInputNumbers<type, baseType, rowCount * columnCount>(varName, input.m_numbers, foundVar->ANKI_CONCATENATE(m_, type)))); \
 		break;
 #include <AnKi/Gr/ShaderVariableDataType.defs.h>
 #undef ANKI_SVDT_MACRO
@@ -704,6 +790,41 @@ void MaterialResource::prefillLocalUniforms()
 	}
 }
 
+void MaterialResource::refreshStreamedTextures()
+{
+	Bool changed = false;
+	for(MaterialVariable& var : m_vars)
+	{
+		if(!var.isBindlessTexture() || !var.m_image->isStreamed())
+		{
+			continue;
+		}
+
+		const U32 idx = var.m_image->getTextureView().getOrCreateBindlessTextureIndex();
+		if(idx != var.m_U32)
+		{
+			var.m_U32 = idx;
+			memcpy(static_cast<U8*>(m_prefilledLocalUniforms) + var.m_offsetInLocalUniforms, &idx, sizeof(idx));
+			changed = true;
+		}
+	}
+
+	if(changed)
+	{
+		++m_streamedTexturesVersion;
+	}
+
+	// Don't hold the replaced textures
+	m_textures.destroy();
+	for(const MaterialVariable& var : m_vars)
+	{
+		if(var.isBoundableTexture() && var.m_image.isCreated())
+		{
+			m_textures.emplaceBack(&var.m_image->getTexture());
+		}
+	}
+}
+
 const MaterialVariant& MaterialResource::getOrCreateVariant(const RenderingKey& key_) const
 {
 	RenderingKey key = key_;
@@ -17,6 +17,10 @@ namespace anki {
 
 // Forward
 class XmlElement;
+class CookedMaterial;
+class CookedMaterialProgram;
+class CookedMaterialMutation;
+class CookedMaterialInput;
 
 /// @addtogroup resource
 /// @{
@@ -258,6 +262,20 @@ public:
 		return ConstWeakArray<U8>(static_cast<const U8*>(m_prefilledLocalUniforms), m_localUniformsSize);
 	}
 
+	/// It changes every time the texture streaming changes the prefilled uniforms.
+	U32 getStreamedTexturesVersion() const
+	{
+		return m_streamedTexturesVersion;
+	}
+
+	// Internals:
+
+	/// The texture streaming replaced some textures. Update the bindless indices that are baked in the prefilled uniforms.
+	ANKI_INTERNAL void refreshStreamedTextures();
+
+	/// Parse the XML of the resource. It's what the load() does the first time. See CookedResourceCache.
+	ANKI_INTERNAL static Error cook(CString source, BaseMemoryPool& pool, CookedMaterial& cooked);
+
 private:
 	class PartialMutation
 	{
@@ -281,10 +299,13 @@ private:
 
 	void* m_prefilledLocalUniforms = nullptr;
 	U32 m_localUniformsSize = 0;
+	U32 m_streamedTexturesVersion = 0;
 
-	Error parseMutators(XmlElement mutatorsEl, Program& prog);
-	Error parseShaderProgram(XmlElement techniqueEl, Bool async);
-	Error parseInput(XmlElement inputEl, Bool async, BitSet<128>& varsSet);
+	static Error cookShaderProgram(XmlElement shaderProgramEl, BaseMemoryPool& pool, CookedMaterialProgram& cooked);
+	Error build(const CookedMaterial& cooked, Bool async);
+	Error buildShaderProgram(const CookedMaterialProgram& cooked, Bool async);
+	Error buildMutators(ConstWeakArray<CookedMaterialMutation> mutation, Program& prog);
+	Error buildInput(const CookedMaterialInput& input, Bool async, BitSet<128>& varsSet);
 	Error findBuiltinMutators(Program& prog);
 	Error createVars(Program& prog);
 	void prefillLocalUniforms();
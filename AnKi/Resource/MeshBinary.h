@@ -16,7 +16,11 @@ namespace anki {
 /// @addtogroup resource
 /// @{
 
-inline constexpr const char* kMeshMagic = "ANKIMES7";
+inline constexpr const char* kMeshMagic = "ANKIMES9";
+
+/// The index and vertex buffers in the file start at offsets that are multiple of that. The buffers are padded with zeros to a multiple of
+/// that as well.
+inline constexpr U32 kMeshBinaryBufferAlignment = 16;
 
 enum class MeshBinaryFlag : U32
 {
@@ -94,12 +98,72 @@ public:
 	}
 };
 
+/// A cluster of triangles. It has the same layout as the Meshlet.
+class MeshBinaryMeshlet
+{
+public:
+	/// Points to the primitives of the LOD.
+	U32 m_firstPrimitive;
+
+	/// Points to the meshlet vertices of the LOD.
+	U32 m_firstVertex;
+
+	U32 m_primitiveCount;
+	U32 m_vertexCount;
+
+	/// Bounding sphere center.
+	Vec3 m_sphereCenter;
+
+	/// Bounding sphere radius.
+	F32 m_sphereRadius;
+
+	/// The apex of the normal cone.
+	Vec3 m_coneApex;
+
+	/// cos(angle/2) of the normal cone. 1.0 if the cone is degenerate.
+	F32 m_coneCutoff;
+
+	/// The axis of the normal cone.
+	Vec3 m_coneAxis;
+
+	F32 m_padding;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doValue("m_firstPrimitive", offsetof(MeshBinaryMeshlet, m_firstPrimitive), self.m_firstPrimitive);
+		s.doValue("m_firstVertex", offsetof(MeshBinaryMeshlet, m_firstVertex), self.m_firstVertex);
+		s.doValue("m_primitiveCount", offsetof(MeshBinaryMeshlet, m_primitiveCount), self.m_primitiveCount);
+		s.doValue("m_vertexCount", offsetof(MeshBinaryMeshlet, m_vertexCount), self.m_vertexCount);
+		s.doValue("m_sphereCenter", offsetof(MeshBinaryMeshlet, m_sphereCenter), self.m_sphereCenter);
+		s.doValue("m_sphereRadius", offsetof(MeshBinaryMeshlet, m_sphereRadius), self.m_sphereRadius);
+		s.doValue("m_coneApex", offsetof(MeshBinaryMeshlet, m_coneApex), self.m_coneApex);
+		s.doValue("m_coneCutoff", offsetof(MeshBinaryMeshlet, m_coneCutoff), self.m_coneCutoff);
+		s.doValue("m_coneAxis", offsetof(MeshBinaryMeshlet, m_coneAxis), self.m_coneAxis);
+		s.doValue("m_padding", offsetof(MeshBinaryMeshlet, m_padding), self.m_padding);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, MeshBinaryMeshlet&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const MeshBinaryMeshlet&>(serializer, *this);
+	}
+};
+
 /// MeshBinarySubMesh class.
 class MeshBinarySubMesh
 {
 public:
 	Array<U32, kMaxLodCount> m_firstIndices;
 	Array<U32, kMaxLodCount> m_indexCounts;
+	Array<U32, kMaxLodCount> m_firstMeshlets;
+	Array<U32, kMaxLodCount> m_meshletCounts;
 
 	/// Bounding box min.
 	Vec3 m_aabbMin;
@@ -112,6 +176,8 @@ public:
 	{
 		s.doArray("m_firstIndices", offsetof(MeshBinarySubMesh, m_firstIndices), &self.m_firstIndices[0], self.m_firstIndices.getSize());
 		s.doArray("m_indexCounts", offsetof(MeshBinarySubMesh, m_indexCounts), &self.m_indexCounts[0], self.m_indexCounts.getSize());
+		s.doArray("m_firstMeshlets", offsetof(MeshBinarySubMesh, m_firstMeshlets), &self.m_firstMeshlets[0], self.m_firstMeshlets.getSize());
+		s.doArray("m_meshletCounts", offsetof(MeshBinarySubMesh, m_meshletCounts), &self.m_meshletCounts[0], self.m_meshletCounts.getSize());
 		s.doValue("m_aabbMin", offsetof(MeshBinarySubMesh, m_aabbMin), self.m_aabbMin);
 		s.doValue("m_aabbMax", offsetof(MeshBinarySubMesh, m_aabbMax), self.m_aabbMax);
 	}
@@ -141,6 +207,8 @@ public:
 	Array<U8, 3> m_padding;
 	Array<U32, kMaxLodCount> m_totalIndexCounts;
 	Array<U32, kMaxLodCount> m_totalVertexCounts;
+	Array<U32, kMaxLodCount> m_totalMeshletCounts;
+	Array<U32, kMaxLodCount> m_totalMeshletVertexCounts;
 	U32 m_subMeshCount;
 	U32 m_lodCount;
 
@@ -164,6 +232,10 @@ public:
 				  self.m_totalIndexCounts.getSize());
 		s.doArray("m_totalVertexCounts", offsetof(MeshBinaryHeader, m_totalVertexCounts), &self.m_totalVertexCounts[0],
 				  self.m_totalVertexCounts.getSize());
+		s.doArray("m_totalMeshletCounts", offsetof(MeshBinaryHeader, m_totalMeshletCounts), &self.m_totalMeshletCounts[0],
+				  self.m_totalMeshletCounts.getSize());
+		s.doArray("m_totalMeshletVertexCounts", offsetof(MeshBinaryHeader, m_totalMeshletVertexCounts), &self.m_totalMeshletVertexCounts[0],
+				  self.m_totalMeshletVertexCounts.getSize());
 		s.doValue("m_subMeshCount", offsetof(MeshBinaryHeader, m_subMeshCount), self.m_subMeshCount);
 		s.doValue("m_lodCount", offsetof(MeshBinaryHeader, m_lodCount), self.m_lodCount);
 		s.doValue("m_aabbMin", offsetof(MeshBinaryHeader, m_aabbMin), self.m_aabbMin);
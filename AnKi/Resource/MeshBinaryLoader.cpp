@@ -10,8 +10,19 @@ namespace anki {
 
 Error MeshBinaryLoader::load(const ResourceFilename& filename)
 {
+	ResourceFilePtr file;
+	ANKI_CHECK(ResourceManager::getSingleton().getFilesystem().openFile(filename, file));
+	ANKI_CHECK(load(std::move(file)));
+
+	return Error::kNone;
+}
+
+Error MeshBinaryLoader::load(ResourceFilePtr file)
+{
+	ANKI_ASSERT(file);
+	m_file = std::move(file);
+
 	// Load header + submeshes
-	ANKI_CHECK(ResourceManager::getSingleton().getFilesystem().openFile(filename, m_file));
 	ANKI_CHECK(m_file->read(&m_header, sizeof(m_header)));
 	ANKI_CHECK(checkHeader());
 	ANKI_CHECK(loadSubmeshes());
@@ -30,6 +41,7 @@ Error MeshBinaryLoader::loadSubmeshes()
 	for(U32 lod = 0; lod < m_header.m_lodCount; ++lod)
 	{
 		U idxSum = 0;
+		U32 meshletSum = 0;
 		for(U32 i = 0; i < m_subMeshes.getSize(); i++)
 		{
 			const MeshBinarySubMesh& sm = m_subMeshes[i];
@@ -48,7 +60,14 @@ Error MeshBinaryLoader::loadSubmeshes()
 				}
 			}
 
+			if(sm.m_firstMeshlets[lod] != meshletSum || sm.m_meshletCounts[lod] == 0)
+			{
+				ANKI_RESOURCE_LOGE("Incorrect sub mesh meshlet info");
+				return Error::kUserData;
+			}
+
 			idxSum += sm.m_indexCounts[lod];
+			meshletSum += sm.m_meshletCounts[lod];
 		}
 
 		if(idxSum != m_header.m_totalIndexCounts[lod])
@@ -56,6 +75,12 @@ Error MeshBinaryLoader::loadSubmeshes()
 			ANKI_RESOURCE_LOGE("Submesh index count doesn't add up to the total");
 			return Error::kUserData;
 		}
+
+		if(meshletSum != m_header.m_totalMeshletCounts[lod])
+		{
+			ANKI_RESOURCE_LOGE("Submesh meshlet count doesn't add up to the total");
+			return Error::kUserData;
+		}
 	}
 
 	return Error::kNone;
@@ -198,6 +223,17 @@ Error MeshBinaryLoader::checkHeader() const
 		}
 	}
 
+	// Meshlets. They are only for triangles
+	for(U32 lod = 0; lod < h.m_lodCount; ++lod)
+	{
+		if(!!(h.m_flags & MeshBinaryFlag::kQuad) || h.m_totalMeshletCounts[lod] == 0
+		   || h.m_totalMeshletVertexCounts[lod] < h.m_totalMeshletCounts[lod])
+		{
+			ANKI_RESOURCE_LOGE("Wrong meshlet count");
+			return Error::kUserData;
+		}
+	}
+
 	// m_subMeshCount
 	if(h.m_subMeshCount == 0)
 	{
@@ -215,15 +251,8 @@ Error MeshBinaryLoader::checkHeader() const
 		}
 	}
 
-	// Check the file size
-	PtrSize totalSize = sizeof(m_header);
-	totalSize += sizeof(MeshBinarySubMesh) * m_header.m_subMeshCount;
-
-	for(U32 lod = 0; lod < h.m_lodCount; ++lod)
-	{
-		totalSize += getLodBuffersSize(lod);
-	}
-
+	// Check the file size. LOD 0 is the last in the file
+	const PtrSize totalSize = getLodBuffersOffset(0) + getLodBuffersSize(0);
 	if(totalSize != m_file->getSize())
 	{
 		ANKI_RESOURCE_LOGE("Unexpected file size");
@@ -240,13 +269,7 @@ Error MeshBinaryLoader::storeIndexBuffer(U32 lod, void* ptr, PtrSize size)
 	ANKI_ASSERT(lod < m_header.m_lodCount);
 	ANKI_ASSERT(size == getIndexBufferSize(lod));
 
-	PtrSize seek = sizeof(m_header) + m_subMeshes.getSizeInBytes();
-	for(U32 l = lod + 1; l < m_header.m_lodCount; ++l)
-	{
-		seek += getLodBuffersSize(l);
-	}
-
-	ANKI_CHECK(m_file->seek(seek, FileSeekOrigin::kBeginning));
+	ANKI_CHECK(m_file->seek(getLodBuffersOffset(lod), FileSeekOrigin::kBeginning));
 	ANKI_CHECK(m_file->read(ptr, size));
 
 	return Error::kNone;
@@ -259,22 +282,30 @@ Error MeshBinaryLoader::storeVertexBuffer(U32 lod, U32 bufferIdx, void* ptr, Ptr
 	ANKI_ASSERT(size == getVertexBufferSize(lod, bufferIdx));
 	ANKI_ASSERT(lod < m_header.m_lodCount);
 
-	PtrSize seek = sizeof(m_header) + m_subMeshes.getSizeInBytes();
+	ANKI_CHECK(m_file->seek(getLodBuffersOffset(lod) + getVertexBufferOffsetInLod(lod, bufferIdx), FileSeekOrigin::kBeginning));
+	ANKI_CHECK(m_file->read(ptr, size));
 
-	for(U32 l = lod + 1; l < m_header.m_lodCount; ++l)
-	{
-		seek += getLodBuffersSize(l);
-	}
+	return Error::kNone;
+}
 
-	seek += getIndexBufferSize(lod);
+Error MeshBinaryLoader::storeLodBuffers(U32 lod, void* ptr, PtrSize size)
+{
+	ANKI_ASSERT(ptr);
+	ANKI_ASSERT(isLoaded());
+	ANKI_ASSERT(lod < m_header.m_lodCount);
+	ANKI_ASSERT(size == getLodBuffersSize(lod));
 
-	for(U32 i = 0; i < bufferIdx; ++i)
+	// The file might be mapped. No need to go through read() then
+	const ConstWeakArray<U8, PtrSize> mapped = m_file->getMappedData();
+	if(mapped.getSize())
 	{
-		seek += getVertexBufferSize(lod, i);
+		memcpy(ptr, &mapped[getLodBuffersOffset(lod)], size);
+	}
+	else
+	{
+		ANKI_CHECK(m_file->seek(getLodBuffersOffset(lod), FileSeekOrigin::kBeginning));
+		ANKI_CHECK(m_file->read(ptr, size));
 	}
-
-	ANKI_CHECK(m_file->seek(seek, FileSeekOrigin::kBeginning));
-	ANKI_CHECK(m_file->read(ptr, size));
 
 	return Error::kNone;
 }
@@ -326,16 +357,62 @@ PtrSize MeshBinaryLoader::getLodBuffersSize(U32 lod) const
 {
 	ANKI_ASSERT(lod < m_header.m_lodCount);
 
-	PtrSize size = getIndexBufferSize(lod);
+	PtrSize size = getAlignedRoundUp(kMeshBinaryBufferAlignment, getIndexBufferSize(lod));
 	for(U32 vertBufferIdx = 0; vertBufferIdx < m_header.m_vertexBuffers.getSize(); ++vertBufferIdx)
 	{
-		if(m_header.m_vertexBuffers[vertBufferIdx].m_vertexStride > 0)
-		{
-			size += getVertexBufferSize(lod, vertBufferIdx);
-		}
+		size += getAlignedRoundUp(kMeshBinaryBufferAlignment, getVertexBufferSize(lod, vertBufferIdx));
 	}
 
+	size += getAlignedRoundUp(kMeshBinaryBufferAlignment, getMeshletsSize(lod));
+	size += getAlignedRoundUp(kMeshBinaryBufferAlignment, getMeshletVerticesSize(lod));
+	size += getAlignedRoundUp(kMeshBinaryBufferAlignment, getMeshletPrimitivesSize(lod));
+
 	return size;
 }
 
+PtrSize MeshBinaryLoader::getVertexBufferOffsetInLod(U32 lod, U32 bufferIdx) const
+{
+	ANKI_ASSERT(lod < m_header.m_lodCount);
+	ANKI_ASSERT(bufferIdx < m_header.m_vertexBuffers.getSize());
+
+	PtrSize offset = getAlignedRoundUp(kMeshBinaryBufferAlignment, getIndexBufferSize(lod));
+	for(U32 i = 0; i < bufferIdx; ++i)
+	{
+		offset += getAlignedRoundUp(kMeshBinaryBufferAlignment, getVertexBufferSize(lod, i));
+	}
+
+	return offset;
+}
+
+PtrSize MeshBinaryLoader::getMeshletsOffsetInLod(U32 lod) const
+{
+	// After the last vertex buffer
+	const U32 lastBufferIdx = m_header.m_vertexBuffers.getSize() - 1;
+	return getVertexBufferOffsetInLod(lod, lastBufferIdx) + getAlignedRoundUp(kMeshBinaryBufferAlignment, getVertexBufferSize(lod, lastBufferIdx));
+}
+
+PtrSize MeshBinaryLoader::getMeshletVerticesOffsetInLod(U32 lod) const
+{
+	return getMeshletsOffsetInLod(lod) + getAlignedRoundUp(kMeshBinaryBufferAlignment, getMeshletsSize(lod));
+}
+
+PtrSize MeshBinaryLoader::getMeshletPrimitivesOffsetInLod(U32 lod) const
+{
+	return getMeshletVerticesOffsetInLod(lod) + getAlignedRoundUp(kMeshBinaryBufferAlignment, getMeshletVerticesSize(lod));
+}
+
+PtrSize MeshBinaryLoader::getLodBuffersOffset(U32 lod) const
+{
+	ANKI_ASSERT(lod < m_header.m_lodCount);
+
+	// The LODs are stored in reverse
+	PtrSize offset = getAlignedRoundUp(kMeshBinaryBufferAlignment, sizeof(m_header) + sizeof(MeshBinarySubMesh) * m_header.m_subMeshCount);
+	for(U32 l = lod + 1; l < m_header.m_lodCount; ++l)
+	{
+		offset += getLodBuffersSize(l);
+	}
+
+	return offset;
+}
+
 } // end namespace anki
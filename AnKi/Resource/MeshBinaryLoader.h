@@ -27,6 +27,13 @@ namespace anki {
 /// ** Vert buffer #0 of #0 submesh
 /// ** etc ...
 /// * etc...
+/// * Meshlets of max LOD (MeshBinaryMeshlet)
+/// * Meshlet vertices of max LOD (U16 indices to the vertices of the LOD)
+/// * Meshlet primitives of max LOD (3 U8 indices to the meshlet vertices and one U8 of padding)
+/// * Index buffer of max LOD-1
+/// * etc...
+/// The buffers are in the formats of kMeshRelatedVertexStreamFormats and they are aligned to kMeshBinaryBufferAlignment so they can be
+/// copied to the GPU as they are.
 class MeshBinaryLoader
 {
 public:
@@ -40,10 +47,29 @@ public:
 
 	Error load(const ResourceFilename& filename);
 
+	/// Same as load() but the file is already open.
+	Error load(ResourceFilePtr file);
+
 	Error storeIndexBuffer(U32 lod, void* ptr, PtrSize size);
 
 	Error storeVertexBuffer(U32 lod, U32 bufferIdx, void* ptr, PtrSize size);
 
+	/// Store all the buffers of a LOD with a single read. They are stored as they are in the file: First the index buffer, then the
+	/// vertex buffers and then the meshlet buffers. Use getVertexBufferOffsetInLod() and the rest to find them.
+	/// @param size It should be getLodBuffersSize().
+	Error storeLodBuffers(U32 lod, void* ptr, PtrSize size);
+
+	/// The size of all the buffers of a LOD (padding included).
+	PtrSize getLodBuffersSize(U32 lod) const;
+
+	/// The offset of a vertex buffer from the start of the buffers of its LOD. The index buffer is at offset zero.
+	PtrSize getVertexBufferOffsetInLod(U32 lod, U32 bufferIdx) const;
+
+	/// The offsets of the meshlet buffers from the start of the buffers of their LOD.
+	PtrSize getMeshletsOffsetInLod(U32 lod) const;
+	PtrSize getMeshletVerticesOffsetInLod(U32 lod) const;
+	PtrSize getMeshletPrimitivesOffsetInLod(U32 lod) const;
+
 	/// Instead of calling storeIndexBuffer and storeVertexBuffer use this method to get those buffers into the CPU.
 	Error storeIndicesAndPosition(U32 lod, ResourceDynamicArray<U32>& indices, ResourceDynamicArray<Vec3>& positions);
 
@@ -84,7 +110,26 @@ private:
 		return PtrSize(m_header.m_totalVertexCounts[lod]) * PtrSize(m_header.m_vertexBuffers[bufferIdx].m_vertexStride);
 	}
 
-	PtrSize getLodBuffersSize(U32 lod) const;
+	PtrSize getMeshletsSize(U32 lod) const
+	{
+		ANKI_ASSERT(lod < m_header.m_lodCount);
+		return PtrSize(m_header.m_totalMeshletCounts[lod]) * sizeof(MeshBinaryMeshlet);
+	}
+
+	PtrSize getMeshletVerticesSize(U32 lod) const
+	{
+		ANKI_ASSERT(lod < m_header.m_lodCount);
+		return PtrSize(m_header.m_totalMeshletVertexCounts[lod]) * sizeof(U16);
+	}
+
+	PtrSize getMeshletPrimitivesSize(U32 lod) const
+	{
+		ANKI_ASSERT(lod < m_header.m_lodCount);
+		return PtrSize(m_header.m_totalIndexCounts[lod] / 3) * sizeof(U8Vec4);
+	}
+
+	/// The offset in the file of the buffers of a LOD.
+	PtrSize getLodBuffersOffset(U32 lod) const;
 
 	Error checkHeader() const;
 	Error checkFormat(VertexStreamId stream, Bool isOptional, Bool canBeTransformed) const;
@@ -12,6 +12,8 @@
 
 namespace anki {
 
+static_assert(sizeof(MeshBinaryMeshlet) == sizeof(Meshlet), "The meshlets are copied as they are");
+
 class MeshResource::LoadContext
 {
 public:
@@ -41,6 +43,11 @@ public:
 		return m_ctx.m_mesh->loadAsync(m_ctx.m_loader);
 	}
 
+	void onCanceled() final
+	{
+		ANKI_RESOURCE_LOGW("The upload of a mesh got canceled: %s", m_ctx.m_mesh->getFilename().cstr());
+	}
+
 	static BaseMemoryPool& getMemoryPool()
 	{
 		return ResourceMemoryPool::getSingleton();
@@ -61,6 +68,10 @@ MeshResource::~MeshResource()
 		{
 			UnifiedGeometryBuffer::getSingleton().deferredFree(lod.m_vertexBuffersAllocationToken[stream]);
 		}
+
+		UnifiedGeometryBuffer::getSingleton().deferredFree(lod.m_meshletsAllocationToken);
+		UnifiedGeometryBuffer::getSingleton().deferredFree(lod.m_meshletVerticesAllocationToken);
+		UnifiedGeometryBuffer::getSingleton().deferredFree(lod.m_meshletPrimitivesAllocationToken);
 	}
 }
 
@@ -104,6 +115,8 @@ Error MeshResource::load(const ResourceFilename& filename, Bool async)
 	{
 		m_subMeshes[i].m_firstIndices = loader.getSubMeshes()[i].m_firstIndices;
 		m_subMeshes[i].m_indexCounts = loader.getSubMeshes()[i].m_indexCounts;
+		m_subMeshes[i].m_firstMeshlets = loader.getSubMeshes()[i].m_firstMeshlets;
+		m_subMeshes[i].m_meshletCounts = loader.getSubMeshes()[i].m_meshletCounts;
 		m_subMeshes[i].m_aabb.setMin(loader.getSubMeshes()[i].m_aabbMin);
 		m_subMeshes[i].m_aabb.setMax(loader.getSubMeshes()[i].m_aabbMax);
 	}
@@ -135,6 +148,14 @@ Error MeshResource::load(const ResourceFilename& filename, Bool async)
 				UnifiedGeometryBuffer::getSingleton().allocateFormat(kMeshRelatedVertexStreamFormats[stream], lod.m_vertexCount);
 		}
 
+		// Meshlet stuff. One primitive per triangle
+		lod.m_meshletCount = header.m_totalMeshletCounts[l];
+		lod.m_meshletVertexCount = header.m_totalMeshletVertexCounts[l];
+		lod.m_meshletsAllocationToken =
+			UnifiedGeometryBuffer::getSingleton().allocate(PtrSize(lod.m_meshletCount) * sizeof(Meshlet), sizeof(Meshlet));
+		lod.m_meshletVerticesAllocationToken = UnifiedGeometryBuffer::getSingleton().allocateFormat(Format::kR16_Uint, lod.m_meshletVertexCount);
+		lod.m_meshletPrimitivesAllocationToken = UnifiedGeometryBuffer::getSingleton().allocateFormat(Format::kR8G8B8A8_Uint, lod.m_indexCount / 3);
+
 		// BLAS
 		if(rayTracingEnabled)
 		{
@@ -175,6 +196,12 @@ Error MeshResource::load(const ResourceFilename& filename, Bool async)
 									 lod.m_vertexBuffersAllocationToken[stream].getAllocatedSize(), 0);
 				}
 			}
+
+			for(const UnifiedGeometryBufferAllocation* alloc :
+				{&lod.m_meshletsAllocationToken, &lod.m_meshletVerticesAllocationToken, &lod.m_meshletPrimitivesAllocationToken})
+			{
+				cmdb->fillBuffer(&UnifiedGeometryBuffer::getSingleton().getBuffer(), alloc->getOffset(), alloc->getAllocatedSize(), 0);
+			}
 		}
 
 		const BufferBarrierInfo barrier = {&UnifiedGeometryBuffer::getSingleton().getBuffer(), BufferUsageBit::kTransferDestination,
@@ -188,7 +215,7 @@ Error MeshResource::load(const ResourceFilename& filename, Bool async)
 	// Submit the loading task
 	if(async)
 	{
-		ResourceManager::getSingleton().getAsyncLoader().submitTask(task.get());
+		m_asyncLoadTask = ResourceManager::getSingleton().getAsyncLoader().submitTask(task.get());
 		LoadTask* pTask;
 		task.moveAndReset(pTask);
 	}
@@ -205,7 +232,7 @@ Error MeshResource::loadAsync(MeshBinaryLoader& loader) const
 	GrManager& gr = GrManager::getSingleton();
 	TransferGpuAllocator& transferAlloc = ResourceManager::getSingleton().getTransferGpuAllocator();
 
-	Array<TransferGpuAllocatorHandle, kMaxLodCount*(U32(VertexStreamId::kMeshRelatedCount) + 1)> handles;
+	Array<TransferGpuAllocatorHandle, kMaxLodCount> handles;
 	U32 handleCount = 0;
 
 	Buffer* unifiedGeometryBuffer = &UnifiedGeometryBuffer::getSingleton().getBuffer();
@@ -220,27 +247,21 @@ Error MeshResource::loadAsync(MeshBinaryLoader& loader) const
 									   kMaxPtrSize};
 	cmdb->setPipelineBarrier({}, {&barrier, 1}, {});
 
-	// Upload index and vertex buffers
+	// Upload index, vertex and meshlet buffers. The buffers in the file are already in their final format so read all the buffers of a LOD
+	// straight to the staging memory and copy them from there
 	for(U32 lodIdx = 0; lodIdx < m_lods.getSize(); ++lodIdx)
 	{
 		const Lod& lod = m_lods[lodIdx];
 
-		// Upload index buffer
-		{
-			TransferGpuAllocatorHandle& handle = handles[handleCount++];
-			const PtrSize indexBufferSize = PtrSize(lod.m_indexCount) * getIndexSize(m_indexType);
-
-			ANKI_CHECK(transferAlloc.allocate(indexBufferSize, handle));
-			void* data = handle.getMappedMemory();
-			ANKI_ASSERT(data);
+		TransferGpuAllocatorHandle& handle = handles[handleCount++];
+		ANKI_CHECK(transferAlloc.allocate(loader.getLodBuffersSize(lodIdx), handle));
+		ANKI_CHECK(loader.storeLodBuffers(lodIdx, handle.getMappedMemory(), loader.getLodBuffersSize(lodIdx)));
 
-			ANKI_CHECK(loader.storeIndexBuffer(lodIdx, data, indexBufferSize));
-
-			cmdb->copyBufferToBuffer(&handle.getBuffer(), handle.getOffset(), unifiedGeometryBuffer, lod.m_indexBufferAllocationToken.getOffset(),
-									 handle.getRange());
-		}
+		// Index buffer
+		cmdb->copyBufferToBuffer(&handle.getBuffer(), handle.getOffset(), unifiedGeometryBuffer, lod.m_indexBufferAllocationToken.getOffset(),
+								 PtrSize(lod.m_indexCount) * getIndexSize(m_indexType));
 
-		// Upload vert buffers
+		// Vertex buffers
 		for(VertexStreamId stream : EnumIterable(VertexStreamId::kMeshRelatedFirst, VertexStreamId::kMeshRelatedCount))
 		{
 			if(!(m_presentVertStreams & VertexStreamMask(1 << stream)))
@@ -248,20 +269,18 @@ Error MeshResource::loadAsync(MeshBinaryLoader& loader) const
 				continue;
 			}
 
-			TransferGpuAllocatorHandle& handle = handles[handleCount++];
 			const PtrSize vertexBufferSize = PtrSize(lod.m_vertexCount) * getFormatInfo(kMeshRelatedVertexStreamFormats[stream]).m_texelSize;
-
-			ANKI_CHECK(transferAlloc.allocate(vertexBufferSize, handle));
-			U8* data = static_cast<U8*>(handle.getMappedMemory());
-			ANKI_ASSERT(data);
-
-			// Load to staging
-			ANKI_CHECK(loader.storeVertexBuffer(lodIdx, U32(stream), data, vertexBufferSize));
-
-			// Copy
-			cmdb->copyBufferToBuffer(&handle.getBuffer(), handle.getOffset(), unifiedGeometryBuffer,
-									 lod.m_vertexBuffersAllocationToken[stream].getOffset(), handle.getRange());
+			cmdb->copyBufferToBuffer(&handle.getBuffer(), handle.getOffset() + loader.getVertexBufferOffsetInLod(lodIdx, U32(stream)),
+									 unifiedGeometryBuffer, lod.m_vertexBuffersAllocationToken[stream].getOffset(), vertexBufferSize);
 		}
+
+		// Meshlet buffers
+		cmdb->copyBufferToBuffer(&handle.getBuffer(), handle.getOffset() + loader.getMeshletsOffsetInLod(lodIdx), unifiedGeometryBuffer,
+								 lod.m_meshletsAllocationToken.getOffset(), lod.m_meshletsAllocationToken.getAllocatedSize());
+		cmdb->copyBufferToBuffer(&handle.getBuffer(), handle.getOffset() + loader.getMeshletVerticesOffsetInLod(lodIdx), unifiedGeometryBuffer,
+								 lod.m_meshletVerticesAllocationToken.getOffset(), lod.m_meshletVerticesAllocationToken.getAllocatedSize());
+		cmdb->copyBufferToBuffer(&handle.getBuffer(), handle.getOffset() + loader.getMeshletPrimitivesOffsetInLod(lodIdx), unifiedGeometryBuffer,
+								 lod.m_meshletPrimitivesAllocationToken.getOffset(), lod.m_meshletPrimitivesAllocationToken.getAllocatedSize());
 	}
 
 	if(gr.getDeviceCapabilities().m_rayTracingEnabled)
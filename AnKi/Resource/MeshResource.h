@@ -6,6 +6,7 @@
 #pragma once
 
 #include <AnKi/Resource/ResourceObject.h>
+#include <AnKi/Resource/AsyncLoader.h>
 #include <AnKi/Math.h>
 #include <AnKi/Gr.h>
 #include <AnKi/Collision/Aabb.h>
@@ -68,6 +69,25 @@ public:
 		vertexCount = m_lods[lod].m_vertexCount;
 	}
 
+	/// Get the meshlets of a submesh. They index the meshlet buffer of the LOD.
+	void getSubMeshMeshletInfo(U32 lod, U32 subMeshId, U32& firstMeshlet, U32& meshletCount) const
+	{
+		const SubMesh& sm = m_subMeshes[subMeshId];
+		firstMeshlet = sm.m_firstMeshlets[lod];
+		meshletCount = sm.m_meshletCounts[lod];
+	}
+
+	/// Get the meshlet buffers of a LOD. The meshlets point to the meshlet vertices and primitives and the meshlet vertices point to the
+	/// vertices of the LOD.
+	void getMeshletBufferInfo(U32 lod, PtrSize& meshletsOffset, PtrSize& meshletVerticesOffset, PtrSize& primitivesOffset, U32& meshletCount) const
+	{
+		const Lod& l = m_lods[lod];
+		meshletsOffset = l.m_meshletsAllocationToken.getOffset();
+		meshletVerticesOffset = l.m_meshletVerticesAllocationToken.getOffset();
+		primitivesOffset = l.m_meshletPrimitivesAllocationToken.getOffset();
+		meshletCount = l.m_meshletCount;
+	}
+
 	const AccelerationStructurePtr& getBottomLevelAccelerationStructure(U32 lod) const
 	{
 		ANKI_ASSERT(m_lods[lod].m_blas);
@@ -95,6 +115,14 @@ public:
 		return m_positionsTranslation;
 	}
 
+	// Internals:
+
+	/// The task that uploads the mesh. It might be done already. It's 0 if the mesh was loaded synchronously.
+	ANKI_INTERNAL AsyncLoaderTaskId getAsyncLoadTask() const
+	{
+		return m_asyncLoadTask;
+	}
+
 private:
 	class LoadTask;
 	class LoadContext;
@@ -105,8 +133,14 @@ private:
 		UnifiedGeometryBufferAllocation m_indexBufferAllocationToken;
 		Array<UnifiedGeometryBufferAllocation, U32(VertexStreamId::kMeshRelatedCount)> m_vertexBuffersAllocationToken;
 
+		UnifiedGeometryBufferAllocation m_meshletsAllocationToken;
+		UnifiedGeometryBufferAllocation m_meshletVerticesAllocationToken;
+		UnifiedGeometryBufferAllocation m_meshletPrimitivesAllocationToken;
+
 		U32 m_indexCount = 0;
 		U32 m_vertexCount = 0;
+		U32 m_meshletCount = 0;
+		U32 m_meshletVertexCount = 0;
 
 		AccelerationStructurePtr m_blas;
 	};
@@ -116,6 +150,8 @@ private:
 	public:
 		Array<U32, kMaxLodCount> m_firstIndices;
 		Array<U32, kMaxLodCount> m_indexCounts;
+		Array<U32, kMaxLodCount> m_firstMeshlets;
+		Array<U32, kMaxLodCount> m_meshletCounts;
 		Aabb m_aabb;
 	};
 
@@ -128,6 +164,8 @@ private:
 	F32 m_positionsScale = 0.0f;
 	Vec3 m_positionsTranslation = Vec3(0.0f);
 
+	AsyncLoaderTaskId m_asyncLoadTask = 0;
+
 	Error loadAsync(MeshBinaryLoader& loader) const;
 };
 /// @}
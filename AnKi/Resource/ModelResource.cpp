@@ -6,6 +6,9 @@
 #include <AnKi/Resource/ModelResource.h>
 #include <AnKi/Resource/ResourceManager.h>
 #include <AnKi/Resource/MeshResource.h>
+#include <AnKi/Resource/AsyncLoader.h>
+#include <AnKi/Resource/CookedResourceCache.h>
+#include <AnKi/Resource/CookedResourceBinary.h>
 #include <AnKi/Util/Xml.h>
 #include <AnKi/Util/Logger.h>
 
@@ -126,12 +129,44 @@ Error ModelPatch::init([[maybe_unused]] ModelResource* model, CString meshFName,
 	return Error::kNone;
 }
 
+/// Runs after the meshes of the model are uploaded and marks the model as loaded.
+class ModelResource::LoadedTask : public AsyncLoaderTask
+{
+public:
+	ModelResourcePtr m_model;
+
+	Error operator()([[maybe_unused]] AsyncLoaderTaskContext& ctx) final
+	{
+		m_model->m_loadState.store(LoadState::kLoaded);
+		return Error::kNone;
+	}
+
+	void onCanceled() final
+	{
+		ANKI_RESOURCE_LOGE("Loading of the meshes of a model failed or got canceled: %s", m_model->getFilename().cstr());
+		m_model->m_loadState.store(LoadState::kFailed);
+	}
+};
+
 Error ModelResource::load(const ResourceFilename& filename, Bool async)
 {
-	// Load
-	//
+	ResourceString source;
+	ANKI_CHECK(openFileReadAllText(filename, source));
+
+	return ResourceManager::getSingleton().getCookedResourceCache().load<CookedModel>(
+		filename, source,
+		[&](BaseMemoryPool& pool, CookedModel& cooked) {
+			return cook(source, pool, cooked);
+		},
+		[&](const CookedModel& cooked) {
+			return build(cooked, async);
+		});
+}
+
+Error ModelResource::cook(CString source, BaseMemoryPool& pool, CookedModel& cooked)
+{
 	ResourceXmlDocument doc;
-	ANKI_CHECK(openFileParseXml(filename, doc));
+	ANKI_CHECK(doc.parse(source));
 
 	XmlElement rootEl;
 	ANKI_CHECK(doc.getChildElement("model", rootEl));
@@ -152,51 +187,64 @@ Error ModelResource::load(const ResourceFilename& filename, Bool async)
 		ANKI_CHECK(modelPatchEl.getNextSiblingElement("modelPatch", modelPatchEl));
 	} while(modelPatchEl);
 
-	// Check number of model patches
-	if(count < 1)
-	{
-		ANKI_RESOURCE_LOGE("Zero number of model patches");
-		return Error::kUserData;
-	}
-
-	m_modelPatches.resize(count);
+	cooked.m_patches = CookedResourceCache::newArray<CookedModelPatch>(pool, count);
 
 	count = 0;
 	ANKI_CHECK(modelPatchesEl.getChildElement("modelPatch", modelPatchEl));
 	do
 	{
+		CookedModelPatch& patch = cooked.m_patches[count];
+
 		XmlElement materialEl;
 		ANKI_CHECK(modelPatchEl.getChildElement("material", materialEl));
 
 		XmlElement meshEl;
 		ANKI_CHECK(modelPatchEl.getChildElement("mesh", meshEl));
-		CString meshFname;
-		ANKI_CHECK(meshEl.getText(meshFname));
+		CString cstr;
+		ANKI_CHECK(meshEl.getText(cstr));
+		patch.m_mesh = CookedResourceCache::newString(pool, cstr);
 
-		U32 subMeshIndex;
 		Bool subMeshIndexPresent;
-		ANKI_CHECK(meshEl.getAttributeNumberOptional("subMeshIndex", subMeshIndex, subMeshIndexPresent));
+		ANKI_CHECK(meshEl.getAttributeNumberOptional("subMeshIndex", patch.m_subMeshIndex, subMeshIndexPresent));
 		if(!subMeshIndexPresent)
 		{
-			subMeshIndex = kMaxU32;
+			patch.m_subMeshIndex = kMaxU32;
 		}
 
-		CString cstr;
 		ANKI_CHECK(materialEl.getText(cstr));
+		patch.m_material = CookedResourceCache::newString(pool, cstr);
+
+		// Move to next
+		ANKI_CHECK(modelPatchEl.getNextSiblingElement("modelPatch", modelPatchEl));
+		++count;
+	} while(modelPatchEl);
+	ANKI_ASSERT(count == cooked.m_patches.getSize());
+
+	return Error::kNone;
+}
+
+Error ModelResource::build(const CookedModel& cooked, Bool async)
+{
+	// Check number of model patches
+	if(cooked.m_patches.getSize() < 1)
+	{
+		ANKI_RESOURCE_LOGE("Zero number of model patches");
+		return Error::kUserData;
+	}
+
+	m_modelPatches.resize(cooked.m_patches.getSize());
 
-		ANKI_CHECK(m_modelPatches[count].init(this, meshFname, cstr, subMeshIndex, async));
+	for(U32 i = 0; i < m_modelPatches.getSize(); ++i)
+	{
+		const CookedModelPatch& patch = cooked.m_patches[i];
+		ANKI_CHECK(m_modelPatches[i].init(this, patch.m_mesh.getBegin(), patch.m_material.getBegin(), patch.m_subMeshIndex, async));
 
-		if(count > 0 && m_modelPatches[count].supportsSkinning() != m_modelPatches[count - 1].supportsSkinning())
+		if(i > 0 && m_modelPatches[i].supportsSkinning() != m_modelPatches[i - 1].supportsSkinning())
 		{
 			ANKI_RESOURCE_LOGE("All model patches should support skinning or all shouldn't support skinning");
 			return Error::kUserData;
 		}
-
-		// Move to next
-		ANKI_CHECK(modelPatchEl.getNextSiblingElement("modelPatch", modelPatchEl));
-		++count;
-	} while(modelPatchEl);
-	ANKI_ASSERT(count == m_modelPatches.getSize());
+	}
 
 	// Calculate compound bounding volume
 	m_boundingVolume = m_modelPatches[0].m_aabb;
@@ -205,6 +253,29 @@ Error ModelResource::load(const ResourceFilename& filename, Bool async)
 		m_boundingVolume = m_boundingVolume.getCompoundShape((*it).m_aabb);
 	}
 
+	// The model is loaded when the uploads of its meshes are done
+	ResourceDynamicArray<AsyncLoaderTaskId> meshTasks;
+	for(const ModelPatch& patch : m_modelPatches)
+	{
+		const AsyncLoaderTaskId taskId = patch.m_mesh->getAsyncLoadTask();
+		if(taskId != 0 && std::find(meshTasks.getBegin(), meshTasks.getEnd(), taskId) == meshTasks.getEnd())
+		{
+			meshTasks.emplaceBack(taskId);
+		}
+	}
+
+	if(async && meshTasks.getSize())
+	{
+		AsyncLoader& loader = ResourceManager::getSingleton().getAsyncLoader();
+		LoadedTask* task = loader.newTask<LoadedTask>();
+		task->m_model.reset(this);
+		loader.submitTask(task, 0.0f, AsyncLoaderTaskStage::kProcess, meshTasks);
+	}
+	else
+	{
+		m_loadState.store(LoadState::kLoaded);
+	}
+
 	return Error::kNone;
 }
 
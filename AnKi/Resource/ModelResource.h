@@ -14,6 +14,9 @@
 
 namespace anki {
 
+// Forward
+class CookedModel;
+
 /// @addtogroup resource
 /// @{
 
@@ -154,11 +157,40 @@ public:
 		return m_boundingVolume;
 	}
 
+	/// When the model is loaded asynchronously its meshes keep uploading after load() returns. Don't render the model before that.
+	Bool isLoaded() const
+	{
+		return m_loadState.load() == LoadState::kLoaded;
+	}
+
+	/// The upload of a mesh failed or got canceled. The model will never be loaded.
+	Bool loadFailed() const
+	{
+		return m_loadState.load() == LoadState::kFailed;
+	}
+
 	Error load(const ResourceFilename& filename, Bool async);
 
+	// Internals:
+
+	/// Parse the XML of the resource. It's what the load() does the first time. See CookedResourceCache.
+	ANKI_INTERNAL static Error cook(CString source, BaseMemoryPool& pool, CookedModel& cooked);
+
 private:
+	class LoadedTask;
+
+	enum class LoadState : U32
+	{
+		kLoading,
+		kLoaded,
+		kFailed
+	};
+
 	ResourceDynamicArray<ModelPatch> m_modelPatches;
 	Aabb m_boundingVolume;
+	Atomic<LoadState> m_loadState = {LoadState::kLoading};
+
+	Error build(const CookedModel& cooked, Bool async);
 };
 /// @}
 
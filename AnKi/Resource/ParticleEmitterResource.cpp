@@ -6,6 +6,8 @@
 #include <AnKi/Resource/ParticleEmitterResource.h>
 #include <AnKi/Resource/ResourceManager.h>
 #include <AnKi/Resource/ModelResource.h>
+#include <AnKi/Resource/CookedResourceCache.h>
+#include <AnKi/Resource/CookedResourceBinary.h>
 #include <AnKi/Util/StringList.h>
 #include <AnKi/Util/Xml.h>
 #include <cstring>
@@ -25,14 +27,31 @@ Error getXmlVal(const XmlElement& el, const CString& tag, Vec3& out, Bool& found
 }
 
 Error ParticleEmitterResource::load(const ResourceFilename& filename, Bool async)
+{
+	ResourceString source;
+	ANKI_CHECK(openFileReadAllText(filename, source));
+
+	return ResourceManager::getSingleton().getCookedResourceCache().load<CookedParticleEmitter>(
+		filename, source,
+		[&](BaseMemoryPool& pool, CookedParticleEmitter& cooked) {
+			return cook(source, pool, cooked);
+		},
+		[&](const CookedParticleEmitter& cooked) {
+			return build(cooked, async);
+		});
+}
+
+Error ParticleEmitterResource::cook(CString source, BaseMemoryPool& pool, CookedParticleEmitter& cooked)
 {
 	ResourceXmlDocument doc;
-	ANKI_CHECK(openFileParseXml(filename, doc));
+	ANKI_CHECK(doc.parse(source));
 	XmlElement rootEl; // Root element
 	ANKI_CHECK(doc.getChildElement("particleEmitter", rootEl));
 
+	ParticleEmitterProperties props;
+
 #define ANKI_XML(varName, VarName) \
-	ANKI_CHECK(readVar(rootEl, #varName, m_particle.m_min##VarName, m_particle.m_max##VarName, &m_particle.m_min##VarName))
+	ANKI_CHECK(readVar(rootEl, #varName, props.m_particle.m_min##VarName, props.m_particle.m_max##VarName, &props.m_particle.m_min##VarName))
 
 	ANKI_XML(life, Life);
 	ANKI_XML(mass, Mass);
@@ -49,31 +68,50 @@ Error ParticleEmitterResource::load(const ResourceFilename& filename, Bool async
 
 	XmlElement el;
 	ANKI_CHECK(rootEl.getChildElement("maxNumberOfParticles", el));
-	ANKI_CHECK(el.getAttributeNumber("value", m_maxNumOfParticles));
+	ANKI_CHECK(el.getAttributeNumber("value", props.m_maxNumOfParticles));
 
 	ANKI_CHECK(rootEl.getChildElement("emissionPeriod", el));
-	ANKI_CHECK(el.getAttributeNumber("value", m_emissionPeriod));
+	ANKI_CHECK(el.getAttributeNumber("value", props.m_emissionPeriod));
 
 	ANKI_CHECK(rootEl.getChildElement("particlesPerEmission", el));
-	ANKI_CHECK(el.getAttributeNumber("value", m_particlesPerEmission));
+	ANKI_CHECK(el.getAttributeNumber("value", props.m_particlesPerEmission));
 
 	ANKI_CHECK(rootEl.getChildElementOptional("usePhysicsEngine", el));
 	if(el)
 	{
-		ANKI_CHECK(el.getAttributeNumber("value", m_usePhysicsEngine));
+		ANKI_CHECK(el.getAttributeNumber("value", props.m_usePhysicsEngine));
 	}
 
 	ANKI_CHECK(rootEl.getChildElementOptional("emitterBoundingVolume", el));
 	if(el)
 	{
-		ANKI_CHECK(el.getAttributeNumbers("min", m_emitterBoundingVolumeMin));
-		ANKI_CHECK(el.getAttributeNumbers("max", m_emitterBoundingVolumeMax));
+		ANKI_CHECK(el.getAttributeNumbers("min", props.m_emitterBoundingVolumeMin));
+		ANKI_CHECK(el.getAttributeNumbers("max", props.m_emitterBoundingVolumeMax));
 	}
 
+	cooked.m_properties = CookedResourceCache::newArray<U8>(pool, sizeof(props));
+	memcpy(cooked.m_properties.getBegin(), static_cast<const void*>(&props), sizeof(props));
+
 	CString cstr;
 	ANKI_CHECK(rootEl.getChildElement("material", el));
 	ANKI_CHECK(el.getAttributeText("value", cstr));
-	ANKI_CHECK(ResourceManager::getSingleton().loadResource(cstr, m_material, async));
+	cooked.m_material = CookedResourceCache::newString(pool, cstr);
+
+	return Error::kNone;
+}
+
+Error ParticleEmitterResource::build(const CookedParticleEmitter& cooked, Bool async)
+{
+	if(cooked.m_properties.getSize() != sizeof(ParticleEmitterProperties))
+	{
+		ANKI_RESOURCE_LOGE("The cooked particle emitter doesn't match the properties. Bump kCookedResourceVersion");
+		return Error::kUserData;
+	}
+
+	ParticleEmitterProperties& props = *this;
+	memcpy(static_cast<void*>(&props), cooked.m_properties.getBegin(), sizeof(props));
+
+	ANKI_CHECK(ResourceManager::getSingleton().loadResource(cooked.m_material.getBegin(), m_material, async));
 
 	return Error::kNone;
 }
@@ -14,6 +14,7 @@
 namespace anki {
 
 class XmlElement;
+class CookedParticleEmitter;
 
 /// @addtogroup resource
 /// @{
@@ -123,6 +124,11 @@ public:
 	/// Load it
 	Error load(const ResourceFilename& filename, Bool async);
 
+	// Internals:
+
+	/// Parse the XML of the resource. It's what the load() does the first time. See CookedResourceCache.
+	ANKI_INTERNAL static Error cook(CString source, BaseMemoryPool& pool, CookedParticleEmitter& cooked);
+
 private:
 	MaterialResourcePtr m_material;
 	U8 m_lodCount = 1; ///< Cache the value from the material
@@ -130,7 +136,9 @@ private:
 	void loadInternal(const XmlElement& el);
 
 	template<typename T>
-	Error readVar(const XmlElement& rootEl, CString varName, T& minVal, T& maxVal, const T* defaultVal);
+	static Error readVar(const XmlElement& rootEl, CString varName, T& minVal, T& maxVal, const T* defaultVal);
+
+	Error build(const CookedParticleEmitter& cooked, Bool async);
 };
 /// @}
 
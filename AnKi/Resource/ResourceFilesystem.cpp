@@ -61,81 +61,85 @@ public:
 	}
 };
 
-/// ZIP file
-class ZipResourceFile final : public ResourceFile
+/// A file inside a memory mapped archive. Stored files are read straight from the mapping and deflated files are inflated straight to
+/// the caller's buffer.
+class ArchiveResourceFile final : public ResourceFile
 {
 public:
-	unzFile m_archive = nullptr;
+	const U8* m_data = nullptr; ///< The (compressed) data of the file inside the mapping.
+	PtrSize m_compressedSize = 0;
 	PtrSize m_size = 0;
+	PtrSize m_position = 0; ///< The position in the uncompressed data.
+	z_stream m_zstream;
+	Bool m_compressed = false;
 
-	~ZipResourceFile()
+	~ArchiveResourceFile()
 	{
-		if(m_archive)
+		if(m_compressed)
 		{
-			// It's open
-			unzClose(m_archive);
-			m_archive = nullptr;
-			m_size = 0;
+			inflateEnd(&m_zstream);
 		}
 	}
 
-	Error open(const CString& archive, const CString& archivedFname)
+	Error open(const MemoryMappedFile& archive, const ResourceFilesystem::ArchivedFile& archivedFile)
 	{
-		// Open archive
-		m_archive = unzOpen(&archive[0]);
-		if(m_archive == nullptr)
+		if(archivedFile.m_dataOffset + archivedFile.m_compressedSize > archive.getSize())
 		{
-			ANKI_RESOURCE_LOGE("Failed to open archive");
-			return Error::kFileAccess;
+			ANKI_RESOURCE_LOGE("File is out of the archive's bounds");
+			return Error::kUserData;
 		}
 
-		// Locate archived
-		const int caseSensitive = 1;
-		if(unzLocateFile(m_archive, &archivedFname[0], caseSensitive) != UNZ_OK)
+		m_data = archive.getData() + archivedFile.m_dataOffset;
+		m_compressedSize = archivedFile.m_compressedSize;
+		m_size = archivedFile.m_size;
+		ANKI_ASSERT(m_size != 0);
+
+		if(archivedFile.m_compressionMethod == Z_DEFLATED)
 		{
-			ANKI_RESOURCE_LOGE("Failed to locate file in archive");
-			return Error::kFileAccess;
-		}
+			zeroMemory(m_zstream);
+			if(inflateInit2(&m_zstream, -MAX_WBITS) != Z_OK) // Raw deflate stream, there is no zlib header
+			{
+				ANKI_RESOURCE_LOGE("inflateInit2() failed");
+				return Error::kFunctionFailed;
+			}
 
-		// Open file
-		if(unzOpenCurrentFile(m_archive) != UNZ_OK)
+			m_compressed = true;
+			rewindStream();
+		}
+		else if(archivedFile.m_compressionMethod != 0)
 		{
-			ANKI_RESOURCE_LOGE("unzOpenCurrentFile() failed");
-			return Error::kFileAccess;
+			ANKI_RESOURCE_LOGE("Unsupported compression method in archive: %u", archivedFile.m_compressionMethod);
+			return Error::kUserData;
 		}
-
-		// Get size just in case
-		unz_file_info zinfo;
-		zinfo.uncompressed_size = 0;
-		unzGetCurrentFileInfo(m_archive, &zinfo, nullptr, 0, nullptr, 0, nullptr, 0);
-		m_size = zinfo.uncompressed_size;
-		ANKI_ASSERT(m_size != 0);
-
-		return Error::kNone;
-	}
-
-	void close()
-	{
-		if(m_archive)
+		else if(m_compressedSize != m_size)
 		{
-			unzClose(m_archive);
-			m_archive = nullptr;
-			m_size = 0;
+			ANKI_RESOURCE_LOGE("Stored file has wrong size");
+			return Error::kUserData;
 		}
+
+		return Error::kNone;
 	}
 
 	Error read(void* buff, PtrSize size) override
 	{
 		ANKI_TRACE_SCOPED_EVENT(RsrcFileRead);
 
-		I64 readSize = unzReadCurrentFile(m_archive, buff, U32(size));
-
-		if(I64(size) != readSize)
+		if(m_position + size > m_size)
 		{
-			ANKI_RESOURCE_LOGE("File read failed");
+			ANKI_RESOURCE_LOGE("File read failed. Trying to read past the end of the file");
 			return Error::kFileAccess;
 		}
 
+		if(m_compressed)
+		{
+			ANKI_CHECK(inflateTo(buff, size));
+		}
+		else
+		{
+			memcpy(buff, m_data + m_position, size);
+		}
+
+		m_position += size;
 		return Error::kNone;
 	}
 
@@ -162,23 +166,52 @@ public:
 
 	Error seek(PtrSize offset, FileSeekOrigin origin) override
 	{
-		// Rewind if needed
-		if(origin == FileSeekOrigin::kBeginning)
+		PtrSize newPosition;
+		switch(origin)
 		{
-			if(unzCloseCurrentFile(m_archive) || unzOpenCurrentFile(m_archive))
+		case FileSeekOrigin::kBeginning:
+			newPosition = offset;
+			break;
+		case FileSeekOrigin::kCurrent:
+			newPosition = m_position + offset;
+			break;
+		default:
+			ANKI_ASSERT(origin == FileSeekOrigin::kEnd);
+			newPosition = m_size + offset;
+		}
+
+		if(newPosition > m_size)
+		{
+			ANKI_RESOURCE_LOGE("Seeking past the end of the file");
+			return Error::kFileAccess;
+		}
+
+		if(!m_compressed)
+		{
+			m_position = newPosition;
+			return Error::kNone;
+		}
+
+		// Can't go back in a deflate stream, start over
+		if(newPosition < m_position)
+		{
+			if(inflateReset(&m_zstream) != Z_OK)
 			{
 				ANKI_RESOURCE_LOGE("Rewind failed");
 				return Error::kFunctionFailed;
 			}
+
+			rewindStream();
+			m_position = 0;
 		}
 
-		// Move forward by reading dummy data
-		Array<char, 128> buff;
-		while(offset != 0)
+		// Move forward by inflating to a dummy buffer
+		Array<U8, 4_KB> buff;
+		while(m_position < newPosition)
 		{
-			PtrSize toRead = min<PtrSize>(offset, sizeof(buff));
-			ANKI_CHECK(read(&buff[0], toRead));
-			offset -= toRead;
+			const PtrSize toRead = min<PtrSize>(newPosition - m_position, sizeof(buff));
+			ANKI_CHECK(inflateTo(&buff[0], toRead));
+			m_position += toRead;
 		}
 
 		return Error::kNone;
@@ -189,14 +222,74 @@ public:
 		ANKI_ASSERT(m_size > 0);
 		return m_size;
 	}
+
+	ConstWeakArray<U8, PtrSize> getMappedData() const override
+	{
+		return (m_compressed) ? ConstWeakArray<U8, PtrSize>() : ConstWeakArray<U8, PtrSize>(m_data, m_size);
+	}
+
+private:
+	void rewindStream()
+	{
+		m_zstream.next_in = const_cast<Bytef*>(m_data);
+		m_zstream.avail_in = uInt(min<PtrSize>(m_compressedSize, kMaxU32));
+	}
+
+	Error inflateTo(void* buff, PtrSize size)
+	{
+		U8* out = static_cast<U8*>(buff);
+		while(size > 0)
+		{
+			// Feed more input if the file is bigger than what avail_in can hold
+			if(m_zstream.avail_in == 0)
+			{
+				const PtrSize consumed = PtrSize(m_zstream.next_in - m_data);
+				m_zstream.avail_in = uInt(min<PtrSize>(m_compressedSize - consumed, kMaxU32));
+			}
+
+			const uInt outSize = uInt(min<PtrSize>(size, kMaxU32));
+			m_zstream.next_out = out;
+			m_zstream.avail_out = outSize;
+
+			const int ret = inflate(&m_zstream, Z_NO_FLUSH);
+			const PtrSize produced = outSize - m_zstream.avail_out;
+			if((ret != Z_OK && ret != Z_STREAM_END) || (ret == Z_STREAM_END && produced != size))
+			{
+				ANKI_RESOURCE_LOGE("File read failed. inflate() returned %d", ret);
+				return Error::kFileAccess;
+			}
+
+			out += produced;
+			size -= produced;
+		}
+
+		return Error::kNone;
+	}
 };
 
+/// The header of the cached file list of an archive.
+class ArchiveFileListCacheHeader
+{
+public:
+	Array<Char, 8> m_magic;
+	U64 m_archiveSize;
+	Array<U32, 6> m_archiveModificationTime;
+	U32 m_fileCount;
+};
+
+static constexpr Array<Char, 8> kArchiveFileListCacheMagic = {'A', 'N', 'K', 'I', 'F', 'L', 'C', '2'};
+
 ResourceFilesystem::~ResourceFilesystem()
 {
 }
 
-Error ResourceFilesystem::init()
+Error ResourceFilesystem::init(CString cacheDir)
 {
+	if(!cacheDir.isEmpty())
+	{
+		m_cacheDir = cacheDir;
+	}
+
 	ResourceStringList paths;
 	paths.splitString(g_dataPathsCVar.get(), ':');
 
@@ -272,44 +365,24 @@ Error ResourceFilesystem::addNewPath(const CString& filepath, const ResourceStri
 	{
 		// It's an archive
 
-		// Open
-		unzFile zfile = unzOpen(&filepath[0]);
-		if(!zfile)
-		{
-			ANKI_RESOURCE_LOGE("Failed to open archive");
-			return Error::kFileAccess;
-		}
-
-		// List files
-		if(unzGoToFirstFile(zfile) != UNZ_OK)
-		{
-			unzClose(zfile);
-			ANKI_RESOURCE_LOGE("unzGoToFirstFile() failed. Empty archive?");
-			return Error::kFileAccess;
-		}
+		ResourceStringList filenames;
+		ResourceDynamicArray<ArchivedFile> files;
+		ANKI_CHECK(readArchiveFileList(filepath, filenames, files));
 
-		do
+		U32 i = 0;
+		for(const ResourceString& filename : filenames)
 		{
-			Array<char, 1024> filename;
-
-			unz_file_info info;
-			if(unzGetCurrentFileInfo(zfile, &info, &filename[0], filename.getSize(), nullptr, 0, nullptr, 0) != UNZ_OK)
+			if(!rejectPath(filename))
 			{
-				unzClose(zfile);
-				ANKI_RESOURCE_LOGE("unzGetCurrentFileInfo() failed");
-				return Error::kFileAccess;
-			}
-
-			const Bool itsADir = info.uncompressed_size == 0;
-			if(!itsADir && !rejectPath(&filename[0]))
-			{
-				path.m_files.pushBackSprintf("%s", &filename[0]);
+				path.m_files.pushBack(filename);
+				path.m_archivedFiles.emplaceBack(files[i]);
 				++fileCount;
 			}
-		} while(unzGoToNextFile(zfile) == UNZ_OK);
 
-		unzClose(zfile);
+			++i;
+		}
 
+		ANKI_CHECK(path.m_archiveMapping.open(filepath));
 		path.m_isArchive = true;
 	}
 	else
@@ -336,6 +409,7 @@ Error ResourceFilesystem::addNewPath(const CString& filepath, const ResourceStri
 	{
 		path.m_path.sprintf("%s", &filepath[0]);
 		m_paths.emplaceFront(std::move(path));
+		indexPath(m_paths.getFront());
 
 		ANKI_RESOURCE_LOGI("Added new data path \"%s\" that contains %u files", &filepath[0], fileCount);
 	}
@@ -351,6 +425,227 @@ Error ResourceFilesystem::addNewPath(const CString& filepath, const ResourceStri
 	return Error::kNone;
 }
 
+Error ResourceFilesystem::readArchiveFileList(const CString& archive, ResourceStringList& filenames, ResourceDynamicArray<ArchivedFile>& files)
+{
+	// Identify the archive by its size and modification time
+	ArchiveFileListCacheHeader header;
+	header.m_magic = kArchiveFileListCacheMagic;
+	header.m_fileCount = 0;
+	{
+		File file;
+		ANKI_CHECK(file.open(archive, FileOpenFlag::kRead | FileOpenFlag::kBinary));
+		header.m_archiveSize = file.getSize();
+	}
+	ANKI_CHECK(getFileModificationTime(archive, header.m_archiveModificationTime[0], header.m_archiveModificationTime[1],
+									   header.m_archiveModificationTime[2], header.m_archiveModificationTime[3], header.m_archiveModificationTime[4],
+									   header.m_archiveModificationTime[5]));
+
+	ResourceString cacheFilename;
+	if(!m_cacheDir.isEmpty())
+	{
+		cacheFilename.sprintf("%s/ArchiveFileList_%016" PRIx64 ".cache", m_cacheDir.cstr(), archive.computeHash());
+	}
+
+	// Try the cache first
+	if(!cacheFilename.isEmpty() && fileExists(cacheFilename))
+	{
+		auto readCache = [&]() -> Error {
+			File file;
+			ANKI_CHECK(file.open(cacheFilename, FileOpenFlag::kRead | FileOpenFlag::kBinary));
+
+			ArchiveFileListCacheHeader cachedHeader;
+			ANKI_CHECK(file.read(&cachedHeader, sizeof(cachedHeader)));
+			if(memcmp(&cachedHeader, &header, offsetof(ArchiveFileListCacheHeader, m_fileCount)) != 0)
+			{
+				return Error::kUserData;
+			}
+
+			files.resize(cachedHeader.m_fileCount);
+			for(ArchivedFile& archivedFile : files)
+			{
+				ANKI_CHECK(file.read(&archivedFile, sizeof(archivedFile)));
+
+				U32 filenameLength;
+				ANKI_CHECK(file.readU32(filenameLength));
+				if(filenameLength == 0 || filenameLength > 1024)
+				{
+					return Error::kUserData;
+				}
+
+				ResourceString& filename = *filenames.emplaceBack(' ', filenameLength);
+				ANKI_CHECK(file.read(&filename[0], filenameLength));
+			}
+
+			return Error::kNone;
+		};
+
+		if(!readCache())
+		{
+			ANKI_RESOURCE_LOGV("Using the cached file list of archive: %s", archive.cstr());
+			return Error::kNone;
+		}
+
+		ANKI_RESOURCE_LOGV("The cached file list of the archive is stale: %s", archive.cstr());
+		filenames.destroy();
+		files.destroy();
+	}
+
+	// Read the central directory of the archive
+	unzFile zfile = unzOpen(&archive[0]);
+	if(!zfile)
+	{
+		ANKI_RESOURCE_LOGE("Failed to open archive");
+		return Error::kFileAccess;
+	}
+
+	if(unzGoToFirstFile(zfile) != UNZ_OK)
+	{
+		unzClose(zfile);
+		ANKI_RESOURCE_LOGE("unzGoToFirstFile() failed. Empty archive?");
+		return Error::kFileAccess;
+	}
+
+	do
+	{
+		Array<char, 1024> filename;
+
+		unz_file_info64 info;
+		if(unzGetCurrentFileInfo64(zfile, &info, &filename[0], filename.getSize(), nullptr, 0, nullptr, 0) != UNZ_OK)
+		{
+			unzClose(zfile);
+			ANKI_RESOURCE_LOGE("unzGetCurrentFileInfo() failed");
+			return Error::kFileAccess;
+		}
+
+		const Bool itsADir = info.uncompressed_size == 0;
+		if(!itsADir)
+		{
+			if(info.flag & 1)
+			{
+				unzClose(zfile);
+				ANKI_RESOURCE_LOGE("Encrypted files are not supported: %s", &filename[0]);
+				return Error::kUserData;
+			}
+
+			// Open the file to skip the local header and find where the data start
+			if(unzOpenCurrentFile(zfile) != UNZ_OK)
+			{
+				unzClose(zfile);
+				ANKI_RESOURCE_LOGE("unzOpenCurrentFile() failed");
+				return Error::kFileAccess;
+			}
+			const U64 dataOffset = unzGetCurrentFileZStreamPos64(zfile);
+			unzCloseCurrentFile(zfile);
+
+			filenames.pushBackSprintf("%s", &filename[0]);
+
+			ArchivedFile& file = *files.emplaceBack();
+			zeroMemory(file);
+			file.m_dataOffset = dataOffset;
+			file.m_size = info.uncompressed_size;
+			file.m_compressedSize = info.compressed_size;
+			file.m_compressionMethod = U32(info.compression_method);
+		}
+	} while(unzGoToNextFile(zfile) == UNZ_OK);
+
+	unzClose(zfile);
+
+	// Store it to the cache. Not fatal if it fails
+	if(!cacheFilename.isEmpty())
+	{
+		header.m_fileCount = files.getSize();
+
+		auto writeCache = [&]() -> Error {
+			File file;
+			ANKI_CHECK(file.open(cacheFilename, FileOpenFlag::kWrite | FileOpenFlag::kBinary));
+			ANKI_CHECK(file.write(&header, sizeof(header)));
+
+			U32 i = 0;
+			for(const ResourceString& filename : filenames)
+			{
+				ANKI_CHECK(file.write(&files[i++], sizeof(ArchivedFile)));
+				const U32 filenameLength = filename.getLength();
+				ANKI_CHECK(file.write(&filenameLength, sizeof(filenameLength)));
+				ANKI_CHECK(file.write(filename.cstr(), filenameLength));
+			}
+
+			return Error::kNone;
+		};
+
+		if(writeCache())
+		{
+			ANKI_RESOURCE_LOGW("Failed to cache the file list of archive: %s", archive.cstr());
+		}
+	}
+
+	return Error::kNone;
+}
+
+void ResourceFilesystem::indexPath(const Path& path)
+{
+	U32 i = 0;
+	for(const ResourceString& filename : path.m_files)
+	{
+		const IndexedFile newFile = {&path, &filename, (path.m_isArchive) ? &path.m_archivedFiles[i] : nullptr};
+		++i;
+
+		const U64 hash = filename.toCString().computeHash();
+		auto it = m_fileIndex.find(hash);
+		if(it == m_fileIndex.getEnd())
+		{
+			m_fileIndex.emplace(hash, newFile);
+		}
+		else if(*it->m_filename == filename)
+		{
+			// Same file in an older path, this one hides it
+			*it = newFile;
+		}
+		else
+		{
+			// Hash collision, rare enough to not care about the linear search
+			Bool found = false;
+			for(IndexedFile& collidingFile : m_collidingFiles)
+			{
+				if(*collidingFile.m_filename == filename)
+				{
+					collidingFile = newFile;
+					found = true;
+					break;
+				}
+			}
+
+			if(!found)
+			{
+				m_collidingFiles.emplaceBack(newFile);
+			}
+		}
+	}
+}
+
+const ResourceFilesystem::IndexedFile* ResourceFilesystem::findFile(const CString& filename) const
+{
+	auto it = m_fileIndex.find(filename.computeHash());
+	if(it == m_fileIndex.getEnd())
+	{
+		return nullptr;
+	}
+
+	if(*it->m_filename == filename)
+	{
+		return &(*it);
+	}
+
+	for(const IndexedFile& collidingFile : m_collidingFiles)
+	{
+		if(*collidingFile.m_filename == filename)
+		{
+			return &collidingFile;
+		}
+	}
+
+	return nullptr;
+}
+
 Error ResourceFilesystem::openFile(const ResourceFilename& filename, ResourceFilePtr& filePtr)
 {
 	ResourceFile* rfile;
@@ -374,44 +669,31 @@ Error ResourceFilesystem::openFileInternal(const ResourceFilename& filename, Res
 {
 	rfile = nullptr;
 
-	// Search for the fname in reverse order
-	for(const Path& p : m_paths)
+	const IndexedFile* indexedFile = findFile(filename);
+	if(indexedFile)
 	{
-		for(const ResourceString& pfname : p.m_files)
+		const Path& p = *indexedFile->m_path;
+		if(p.m_isArchive)
 		{
-			if(pfname != filename)
-			{
-				continue;
-			}
+			ArchiveResourceFile* file = newInstance<ArchiveResourceFile>(ResourceMemoryPool::getSingleton());
+			rfile = file;
 
-			// Found
-			if(p.m_isArchive)
-			{
-				ZipResourceFile* file = newInstance<ZipResourceFile>(ResourceMemoryPool::getSingleton());
-				rfile = file;
-
-				ANKI_CHECK(file->open(p.m_path.toCString(), filename));
-			}
-			else
-			{
-				ResourceString newFname;
-				newFname.sprintf("%s/%s", &p.m_path[0], &filename[0]);
+			ANKI_CHECK(file->open(p.m_archiveMapping, *indexedFile->m_archivedFile));
+		}
+		else
+		{
+			ResourceString newFname;
+			newFname.sprintf("%s/%s", &p.m_path[0], &filename[0]);
 
-				CResourceFile* file = newInstance<CResourceFile>(ResourceMemoryPool::getSingleton());
-				rfile = file;
-				ANKI_CHECK(file->m_file.open(newFname, FileOpenFlag::kRead));
+			CResourceFile* file = newInstance<CResourceFile>(ResourceMemoryPool::getSingleton());
+			rfile = file;
+			ANKI_CHECK(file->m_file.open(newFname, FileOpenFlag::kRead));
 
 #if 0
-				printf("Opening asset %s\n", &newFname[0]);
+			printf("Opening asset %s\n", &newFname[0]);
 #endif
-			}
-		}
-
-		if(rfile)
-		{
-			break;
 		}
-	} // end for all paths
+	}
 
 	// File not found? On Win/Linux try to find it outside the resource dirs. On Android try the archive
 	if(!rfile)
@@ -10,6 +10,8 @@
 #include <AnKi/Util/StringList.h>
 #include <AnKi/Util/File.h>
 #include <AnKi/Util/Ptr.h>
+#include <AnKi/Util/HashMap.h>
+#include <AnKi/Util/WeakArray.h>
 #include <AnKi/Core/CVarSet.h>
 
 namespace anki {
@@ -54,6 +56,12 @@ public:
 	/// Get the size of the file.
 	virtual PtrSize getSize() const = 0;
 
+	/// If the whole file is memory mapped and uncompressed get its contents without copying. It's empty if it's not.
+	virtual ConstWeakArray<U8, PtrSize> getMappedData() const
+	{
+		return {};
+	}
+
 	void retain() const
 	{
 		m_refcount.fetchAdd(1);
@@ -80,7 +88,8 @@ public:
 
 using ResourceFilePtr = IntrusivePtr<ResourceFile, ResourceFileDeleter>;
 
-/// Resource filesystem.
+/// Resource filesystem. It indexes the files of all the paths and archives at init time so finding a file is a hash lookup. The archives are
+/// memory mapped.
 class ResourceFilesystem
 {
 public:
@@ -92,9 +101,10 @@ public:
 
 	ResourceFilesystem& operator=(const ResourceFilesystem&) = delete; // Non-copyable
 
-	Error init();
+	/// @param cacheDir If it's not empty the file lists of the archives will be cached there to avoid reading them again next time.
+	Error init(CString cacheDir = {});
 
-	/// Search the path list to find the file. Then open the file for reading. It's thread-safe.
+	/// Find the file in the index. Then open the file for reading. It's thread-safe.
 	Error openFile(const ResourceFilename& filename, ResourceFilePtr& file);
 
 	/// Iterate all the filenames from all paths provided.
@@ -114,11 +124,23 @@ public:
 #if !ANKI_TESTS
 private:
 #endif
+	/// The location of a file inside an archive.
+	class ArchivedFile
+	{
+	public:
+		U64 m_dataOffset; ///< Offset of the (compressed) data in the archive.
+		U64 m_size;
+		U64 m_compressedSize;
+		U32 m_compressionMethod;
+	};
+
 	class Path
 	{
 	public:
 		ResourceStringList m_files; ///< Files inside the directory.
+		ResourceDynamicArray<ArchivedFile> m_archivedFiles; ///< If it's an archive. One for each of the m_files and in the same order.
 		ResourceString m_path; ///< A directory or an archive.
+		MemoryMappedFile m_archiveMapping; ///< If it's an archive it stays mapped for the lifetime of the filesystem.
 		Bool m_isArchive = false;
 
 		Path() = default;
@@ -135,18 +157,39 @@ private:
 		Path& operator=(Path&& b)
 		{
 			m_files = std::move(b.m_files);
+			m_archivedFiles = std::move(b.m_archivedFiles);
 			m_path = std::move(b.m_path);
+			m_archiveMapping = std::move(b.m_archiveMapping);
 			m_isArchive = b.m_isArchive;
 			return *this;
 		}
 	};
 
+	class IndexedFile
+	{
+	public:
+		const Path* m_path;
+		const ResourceString* m_filename;
+		const ArchivedFile* m_archivedFile; ///< nullptr if it's not in an archive.
+	};
+
 	ResourceList<Path> m_paths;
 	ResourceString m_cacheDir;
 
+	ResourceHashMap<U64, IndexedFile> m_fileIndex; ///< Indexed by the hash of the filename.
+	ResourceDynamicArray<IndexedFile> m_collidingFiles; ///< Files whose filename hash collides with some other in m_fileIndex.
+
 	/// Add a filesystem path or an archive. The path is read-only.
 	Error addNewPath(const CString& path, const ResourceStringList& excludedStrings);
 
+	/// Read the file list of an archive or get it from the cache.
+	Error readArchiveFileList(const CString& archive, ResourceStringList& filenames, ResourceDynamicArray<ArchivedFile>& files);
+
+	/// Add the files of a path to the index. They take precedence over the files of the older paths.
+	void indexPath(const Path& path);
+
+	const IndexedFile* findFile(const CString& filename) const;
+
 	Error openFileInternal(const ResourceFilename& filename, ResourceFile*& rfile);
 };
 /// @}
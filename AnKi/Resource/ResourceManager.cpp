@@ -7,8 +7,14 @@
 #include <AnKi/Resource/AsyncLoader.h>
 #include <AnKi/Resource/ShaderProgramResourceSystem.h>
 #include <AnKi/Resource/AnimationResource.h>
+#include <AnKi/Resource/TextureResidencyManager.h>
+#include <AnKi/Resource/TextureUploadQueue.h>
+#include <AnKi/Resource/CookedResourceCache.h>
 #include <AnKi/Util/Logger.h>
+#include <AnKi/Util/Hash.h>
+#include <AnKi/Util/Tracer.h>
 #include <AnKi/Core/CVarSet.h>
+#include <AnKi/Core/StatsSet.h>
 
 #include <AnKi/Resource/MaterialResource.h>
 #include <AnKi/Resource/MeshResource.h>
@@ -28,6 +34,20 @@ namespace anki {
 static NumericCVar<PtrSize> g_transferScratchMemorySizeCVar(CVarSubsystem::kResource, "TransferScratchMemorySize", 256_MB, 1_MB, 4_GB,
 															"Memory that is used fot texture and buffer uploads");
 
+static BoolCVar g_textureStreamingCVar(CVarSubsystem::kResource, "TextureStreaming", false,
+									   "Load only the small mips of the 2D images and stream the rest on demand");
+static NumericCVar<PtrSize> g_textureStreamingMemoryBudgetCVar(CVarSubsystem::kResource, "TextureStreamingMemoryBudget", 1_GB, 16_MB, 64_GB,
+															   "The max memory of the resident mips of the streamed images");
+static NumericCVar<PtrSize> g_textureStreamingUploadBudgetCVar(CVarSubsystem::kResource, "TextureStreamingUploadBudget", 16_MB, 1_MB, 1_GB,
+															   "The max size of the mips that start streaming in a single frame");
+static NumericCVar<U32> g_textureStreamingEvictionDelayCVar(CVarSubsystem::kResource, "TextureStreamingEvictionDelay", 120, 1, 10000,
+															"Frames to wait before evicting mips that are not needed any more");
+
+static StatCounter g_textureStreamingMemoryStatVar(StatCategory::kGpuMem, "Streamed textures", StatFlag::kBytes | StatFlag::kMainThreadUpdates);
+StatCounter g_resourceCacheHitsStatVar(StatCategory::kMisc, "Resource cache hits", StatFlag::kNone);
+StatCounter g_resourceCacheMissesStatVar(StatCategory::kMisc, "Resource cache misses", StatFlag::kNone);
+StatCounter g_resourceLoadWaitsStatVar(StatCategory::kMisc, "Resource load waits", StatFlag::kNone);
+
 ResourceManager::ResourceManager()
 {
 }
@@ -37,21 +57,40 @@ ResourceManager::~ResourceManager()
 	ANKI_RESOURCE_LOGI("Destroying resource manager");
 
 	deleteInstance(ResourceMemoryPool::getSingleton(), m_asyncLoader);
+
+	m_streamedTextures.destroy();
+	for(ResourceDynamicArray<StreamedTexture>& textures : m_retiredTextures)
+	{
+		textures.destroy();
+	}
+	deleteInstance(ResourceMemoryPool::getSingleton(), m_textureResidency);
+
 	deleteInstance(ResourceMemoryPool::getSingleton(), m_shaderProgramSystem);
+	deleteInstance(ResourceMemoryPool::getSingleton(), m_textureUploadQueue);
 	deleteInstance(ResourceMemoryPool::getSingleton(), m_transferGpuAlloc);
+	deleteInstance(ResourceMemoryPool::getSingleton(), m_cookedCache);
 	deleteInstance(ResourceMemoryPool::getSingleton(), m_fs);
 
+#define ANKI_INSTANTIATE_RESOURCE(rsrc_, ptr_) TypeResourceManager<rsrc_>::destroyEntries();
+#define ANKI_INSTANSIATE_RESOURCE_DELIMITER()
+#include <AnKi/Resource/InstantiationMacros.h>
+#undef ANKI_INSTANTIATE_RESOURCE
+#undef ANKI_INSTANSIATE_RESOURCE_DELIMITER
+
 	ResourceMemoryPool::freeSingleton();
 }
 
-Error ResourceManager::init(AllocAlignedCallback allocCallback, void* allocCallbackData)
+Error ResourceManager::init(AllocAlignedCallback allocCallback, void* allocCallbackData, CString cacheDir)
 {
 	ANKI_RESOURCE_LOGI("Initializing resource manager");
 
 	ResourceMemoryPool::allocateSingleton(allocCallback, allocCallbackData);
 
 	m_fs = newInstance<ResourceFilesystem>(ResourceMemoryPool::getSingleton());
-	ANKI_CHECK(m_fs->init());
+	ANKI_CHECK(m_fs->init(cacheDir));
+
+	m_cookedCache = newInstance<CookedResourceCache>(ResourceMemoryPool::getSingleton());
+	ANKI_CHECK(m_cookedCache->init(cacheDir));
 
 	// Init the thread
 	m_asyncLoader = newInstance<AsyncLoader>(ResourceMemoryPool::getSingleton());
@@ -59,6 +98,15 @@ Error ResourceManager::init(AllocAlignedCallback allocCallback, void* allocCallb
 	m_transferGpuAlloc = newInstance<TransferGpuAllocator>(ResourceMemoryPool::getSingleton());
 	ANKI_CHECK(m_transferGpuAlloc->init(g_transferScratchMemorySizeCVar.get()));
 
+	m_textureUploadQueue = newInstance<TextureUploadQueue>(ResourceMemoryPool::getSingleton(), *m_transferGpuAlloc);
+
+	if(g_textureStreamingCVar.get())
+	{
+		m_textureResidency =
+			newInstance<TextureResidencyManager>(ResourceMemoryPool::getSingleton(), g_textureStreamingMemoryBudgetCVar.get(),
+												 g_textureStreamingUploadBudgetCVar.get(), g_textureStreamingEvictionDelayCVar.get());
+	}
+
 	// Init the programs
 	m_shaderProgramSystem = newInstance<ShaderProgramResourceSystem>(ResourceMemoryPool::getSingleton());
 	ANKI_CHECK(m_shaderProgramSystem->init());
@@ -68,40 +116,141 @@ Error ResourceManager::init(AllocAlignedCallback allocCallback, void* allocCallb
 
 template<typename T>
 Error ResourceManager::loadResource(const CString& filename, ResourcePtr<T>& out, Bool async)
+{
+	return loadResourceInternal(filename, filename.computeHash(), out, [&](T& rsrc) {
+		return rsrc.load(filename, async);
+	});
+}
+
+Error ResourceManager::loadStreamedImage(const CString& filename, ImageResourcePtr& out, Bool async)
+{
+	// The streamed images are a variant of the whole ones. Give them a different key so they don't mix
+	const U64 variant = 1;
+	return loadResourceInternal(filename, appendHash(&variant, sizeof(variant), filename.computeHash()), out, [&](ImageResource& image) {
+		return image.load(filename, async, true);
+	});
+}
+
+template<typename T, typename TLoadFunc>
+Error ResourceManager::loadResourceInternal(const CString& filename, U64 cacheKey, ResourcePtr<T>& out, TLoadFunc loadFunc)
 {
 	ANKI_ASSERT(!out.isCreated() && "Already loaded");
 
-	Error err = Error::kNone;
+	using TypeManager = TypeResourceManager<T>;
+	using InFlightLoad = typename TypeManager::InFlightLoad;
+	TypeManager& typeManager = *this;
+
+	// Fast path: The resource is loaded
+	{
+		RLockGuard lock(typeManager.m_entriesMtx);
+
+		U64 key;
+		auto it = typeManager.findEntry(filename, cacheKey, key);
+		if(it != typeManager.m_entries.getEnd() && it->m_resource && it->m_resource->tryRetain())
+		{
+			out.reset(it->m_resource);
+			it->m_resource->release();
+			g_resourceCacheHitsStatVar.increment(1);
+			return Error::kNone;
+		}
+	}
+
+	// Slow path: Check again and if no one else is loading it load it
+	InFlightLoad* load = nullptr;
+	InFlightLoad* otherLoad = nullptr;
+	U64 entryKey;
+	{
+		WLockGuard lock(typeManager.m_entriesMtx);
+
+		auto it = typeManager.findEntry(filename, cacheKey, entryKey);
+		if(it != typeManager.m_entries.getEnd() && it->m_resource && it->m_resource->tryRetain())
+		{
+			// Got loaded in the meantime
+			out.reset(it->m_resource);
+			it->m_resource->release();
+			g_resourceCacheHitsStatVar.increment(1);
+			return Error::kNone;
+		}
+
+		if(it != typeManager.m_entries.getEnd() && it->m_inFlightLoad)
+		{
+			// Some other thread is loading it
+			otherLoad = it->m_inFlightLoad;
+			otherLoad->m_refcount.fetchAdd(1);
+		}
+		else
+		{
+			// Not loaded or the loaded one is being deleted. Replace the entry
+			load = newInstance<InFlightLoad>(ResourceMemoryPool::getSingleton());
+			typeManager.setEntry(entryKey, typename TypeManager::Entry{nullptr, load, filename, cacheKey});
+		}
+	}
+
+	if(otherLoad)
+	{
+		return waitInFlightLoad(typeManager, *otherLoad, out);
+	}
+
+	g_resourceCacheMissesStatVar.increment(1);
+
+	// Allocate ptr
+	T* ptr = newInstance<T>(ResourceMemoryPool::getSingleton());
+	ANKI_ASSERT(ptr->getRefcount() == 0);
 
-	T* const other = findLoadedResource<T>(filename);
+	// Increment the refcount in that case where async jobs increment it and decrement it in the scope of a load()
+	ptr->retain();
 
-	if(other)
+	ptr->setFilename(filename);
+	ptr->setCacheKey(entryKey);
+	const Error err = loadFunc(*ptr);
+	if(err)
 	{
-		// Found
-		out.reset(other);
+		ANKI_RESOURCE_LOGE("Failed to load resource: %s", &filename[0]);
+		deleteInstance(ResourceMemoryPool::getSingleton(), ptr);
+		ptr = nullptr;
 	}
 	else
 	{
-		// Allocate ptr
-		T* ptr = newInstance<T>(ResourceMemoryPool::getSingleton());
-		ANKI_ASSERT(ptr->getRefcount() == 0);
+		ptr->setUuid(m_uuid.fetchAdd(1) + 1);
+	}
 
-		// Increment the refcount in that case where async jobs increment it and decrement it in the scope of a load()
-		ptr->retain();
+	// Register resource. No one else can join the load after that so every waiter gets a reference
+	{
+		WLockGuard lock(typeManager.m_entriesMtx);
 
-		err = ptr->load(filename, async);
+		auto it = typeManager.m_entries.find(entryKey);
+		ANKI_ASSERT(it != typeManager.m_entries.getEnd() && it->m_inFlightLoad == load);
 		if(err)
 		{
-			ANKI_RESOURCE_LOGE("Failed to load resource: %s", &filename[0]);
-			deleteInstance(ResourceMemoryPool::getSingleton(), ptr);
-			return err;
+			typeManager.eraseEntry(it, entryKey);
+		}
+		else
+		{
+			it->m_resource = ptr;
+			it->m_inFlightLoad = nullptr;
+
+			for(U32 i = 1; i < load->m_refcount.load(); ++i)
+			{
+				ptr->retain();
+			}
 		}
+	}
 
-		ptr->setFilename(filename);
-		ptr->setUuid(++m_uuid);
+	{
+		LockGuard lock(typeManager.m_inFlightMtx);
+		load->m_resource = ptr;
+		load->m_err = err;
+		load->m_done = true;
+	}
+	typeManager.m_inFlightCondVar.notifyAll();
 
-		// Register resource
-		registerResource(ptr);
+	if(load->m_refcount.fetchSub(1) == 1)
+	{
+		deleteInstance(ResourceMemoryPool::getSingleton(), load);
+	}
+
+	if(!err)
+	{
 		out.reset(ptr);
 
 		// Decrement because of the increment happened a few lines above
@@ -111,6 +260,130 @@ Error ResourceManager::loadResource(const CString& filename, ResourcePtr<T>& out
 	return err;
 }
 
+template<typename T>
+Error ResourceManager::waitInFlightLoad(TypeResourceManager<T>& typeManager, typename TypeResourceManager<T>::InFlightLoad& load, ResourcePtr<T>& out)
+{
+	g_resourceLoadWaitsStatVar.increment(1);
+
+	{
+		LockGuard lock(typeManager.m_inFlightMtx);
+		while(!load.m_done)
+		{
+			typeManager.m_inFlightCondVar.wait(typeManager.m_inFlightMtx);
+		}
+	}
+
+	const Error err = load.m_err;
+	if(!err)
+	{
+		// The loader has retained it for us
+		out.reset(load.m_resource);
+		load.m_resource->release();
+	}
+
+	if(load.m_refcount.fetchSub(1) == 1)
+	{
+		deleteInstance(ResourceMemoryPool::getSingleton(), &load);
+	}
+
+	return err;
+}
+
+void ResourceManager::textureStreamed(ImageResourcePtr image, TexturePtr tex, TextureViewPtr texView)
+{
+	LockGuard lock(m_textureStreamingMtx);
+	m_streamedTextures.emplaceBack(StreamedTexture{std::move(image), std::move(tex), std::move(texView)});
+}
+
+void ResourceManager::endFrame()
+{
+	// Take the streamed textures before the uploads get flushed. Their copies were pushed before they got here
+	ResourceDynamicArray<StreamedTexture> streamed;
+	{
+		LockGuard lock(m_textureStreamingMtx);
+		streamed = std::move(m_streamedTextures);
+	}
+
+	// Submit the texture uploads of the frame
+	m_textureUploadQueue->endFrame();
+
+	if(!m_textureResidency)
+	{
+		return;
+	}
+
+	ANKI_TRACE_SCOPED_EVENT(RsrcTextureStreaming);
+
+	// The GPU is done with the textures that got replaced kMaxFramesInFlight frames ago
+	ResourceDynamicArray<StreamedTexture>& retired = m_retiredTextures[m_frame % kMaxFramesInFlight];
+	retired.destroy();
+	++m_frame;
+
+	// Swap the textures that finished streaming
+	Bool texturesSwapped = false;
+	for(StreamedTexture& s : streamed)
+	{
+		const Bool applied = s.m_tex.isCreated();
+		if(applied)
+		{
+			s.m_image->swapStreamedTexture(s.m_tex, s.m_texView);
+			texturesSwapped = true;
+		}
+
+		m_textureResidency->changeDone(s.m_image->getStreamingHandle(), applied);
+	}
+
+	// Keep the old textures alive and release the images outside the lock because they might get deleted
+	retired = std::move(streamed);
+
+	if(texturesSwapped)
+	{
+		++m_textureStreamingEpoch;
+
+		// The materials have the bindless indices of the textures baked in their uniforms
+		ResourceDynamicArray<MaterialResourcePtr> materials;
+		{
+			TypeResourceManager<MaterialResource>& typeManager = *this;
+			RLockGuard lock(typeManager.m_entriesMtx);
+			for(auto& entry : typeManager.m_entries)
+			{
+				if(entry.m_resource && entry.m_resource->tryRetain())
+				{
+					materials.emplaceBack()->reset(entry.m_resource);
+					entry.m_resource->release();
+				}
+			}
+		}
+
+		for(MaterialResourcePtr& mtl : materials)
+		{
+			mtl->refreshStreamedTextures();
+		}
+	}
+
+	// Decide the next changes and start them
+	{
+		LockGuard lock(m_textureStreamingMtx);
+
+		ResourceDynamicArray<TextureResidencyChange> changes;
+		m_textureResidency->update(changes);
+
+		for(const TextureResidencyChange& change : changes)
+		{
+			ImageResource* image = static_cast<ImageResource*>(change.m_userData);
+
+			// If the refcount is zero the image is being deleted. It will unregister itself after the lock is released
+			if(image->tryRetain())
+			{
+				image->submitStreamingTask(change.m_firstResidentMip, change.m_screenSize);
+				image->release();
+			}
+		}
+	}
+
+	g_textureStreamingMemoryStatVar.set(m_textureResidency->getResidentMemory());
+}
+
 // Instansiate the ResourceManager::loadResource()
 #define ANKI_INSTANTIATE_RESOURCE(rsrc_, ptr_) \
 	template Error ResourceManager::loadResource<rsrc_>(const CString& filename, ResourcePtr<rsrc_>& out, Bool async);
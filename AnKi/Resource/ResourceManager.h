@@ -7,7 +7,8 @@
 
 #include <AnKi/Resource/TransferGpuAllocator.h>
 #include <AnKi/Resource/ResourceFilesystem.h>
-#include <AnKi/Util/List.h>
+#include <AnKi/Util/HashMap.h>
+#include <AnKi/Util/Thread.h>
 #include <AnKi/Util/Functions.h>
 #include <AnKi/Util/String.h>
 
@@ -20,15 +21,26 @@ class ResourceManager;
 class AsyncLoader;
 class ResourceManagerModel;
 class ShaderCompilerCache;
+class CookedResourceCache;
 class ShaderProgramResourceSystem;
+class TextureResidencyManager;
+class TextureUploadQueue;
+class StatCounter;
+
+extern StatCounter g_resourceCacheHitsStatVar;
+extern StatCounter g_resourceCacheMissesStatVar;
+extern StatCounter g_resourceLoadWaitsStatVar;
 
 /// @addtogroup resource
 /// @{
 
-/// Manage resources of a certain type
+/// Manage resources of a certain type. It keeps the loaded resources in a map indexed by the hash of their filename. Filenames with the
+/// same hash are linearly probed.
 template<typename Type>
 class TypeResourceManager
 {
+	friend class ResourceManager;
+
 protected:
 	TypeResourceManager()
 	{
@@ -36,47 +48,115 @@ protected:
 
 	~TypeResourceManager()
 	{
-		ANKI_ASSERT(m_ptrs.isEmpty() && "Forgot to delete some resources");
-		m_ptrs.destroy();
-	}
-
-	Type* findLoadedResource(const CString& filename)
-	{
-		auto it = find(filename);
-		return (it != m_ptrs.end()) ? *it : nullptr;
+		ANKI_ASSERT(m_entries.isEmpty() && "Forgot to delete some resources");
 	}
 
-	void registerResource(Type* ptr)
+	/// Needs to be called before the memory pool goes away.
+	void destroyEntries()
 	{
-		ANKI_ASSERT(find(ptr->getFilename()) == m_ptrs.getEnd());
-		m_ptrs.pushBack(ptr);
+		ANKI_ASSERT(m_entries.isEmpty() && "Forgot to delete some resources");
+		m_entries.destroy();
 	}
 
 	void unregisterResource(Type* ptr)
 	{
-		auto it = find(ptr->getFilename());
-		ANKI_ASSERT(it != m_ptrs.end());
-		m_ptrs.erase(it);
+		WLockGuard lock(m_entriesMtx);
+
+		// The entry might point to a new instance of the same resource that got loaded while this one was being deleted
+		auto it = m_entries.find(ptr->getCacheKey());
+		if(it != m_entries.getEnd() && it->m_resource == ptr)
+		{
+			eraseEntry(it, ptr->getCacheKey());
+		}
 	}
 
 private:
-	using Container = ResourceList<Type*>;
+	/// A load that is in progress. Threads that ask for the same resource wait for it instead of loading it again.
+	class InFlightLoad
+	{
+	public:
+		Type* m_resource = nullptr; ///< Holds a reference for every waiter.
+		Error m_err = Error::kNone;
+		Atomic<U32> m_refcount = {1}; ///< The loader and the waiters.
+		Bool m_done = false; ///< Protected by m_inFlightMtx.
+	};
+
+	class Entry
+	{
+	public:
+		Type* m_resource = nullptr;
+		InFlightLoad* m_inFlightLoad = nullptr;
+		ResourceString m_filename; ///< Different filenames might have the same hash. It's empty if the entry is a tombstone.
+		U64 m_hash = 0; ///< The hash of the filename (or of the variant). The key of the entry might be different because of probing.
+	};
 
-	Container m_ptrs;
+	using EntryIterator = typename ResourceHashMap<U64, Entry>::Iterator;
 
-	typename Container::Iterator find(const CString& filename)
-	{
-		typename Container::Iterator it;
+	ResourceHashMap<U64, Entry> m_entries; ///< Indexed by the cache key of the resource. See ResourceObject::getCacheKey().
+	RWMutex m_entriesMtx;
+
+	Mutex m_inFlightMtx;
+	ConditionVariable m_inFlightCondVar;
 
-		for(it = m_ptrs.getBegin(); it != m_ptrs.getEnd(); ++it)
+	/// Find the entry of a resource. The entries with the same hash are linearly probed starting from the hash.
+	/// @param[out] key The key of the entry. If it's not found it's the key that a new entry should take.
+	/// @note m_entriesMtx should be locked.
+	EntryIterator findEntry(CString filename, U64 hash, U64& key)
+	{
+		key = kMaxU64;
+		U64 probe = hash;
+		while(true)
 		{
-			if((*it)->getFilename() == filename)
+			EntryIterator it = m_entries.find(probe);
+			if(it == m_entries.getEnd())
+			{
+				key = (key == kMaxU64) ? probe : key;
+				return it;
+			}
+
+			if(it->m_hash == hash && it->m_filename == filename)
 			{
-				break;
+				key = probe;
+				return it;
 			}
+
+			if(key == kMaxU64 && it->m_filename.isEmpty())
+			{
+				// Tombstone, a new entry can reuse it
+				key = probe;
+			}
+
+			++probe;
 		}
+	}
 
-		return it;
+	/// Add or replace an entry.
+	/// @note m_entriesMtx should be locked.
+	void setEntry(U64 key, Entry&& entry)
+	{
+		EntryIterator it = m_entries.find(key);
+		if(it != m_entries.getEnd())
+		{
+			*it = std::move(entry);
+		}
+		else
+		{
+			m_entries.emplace(key, std::move(entry));
+		}
+	}
+
+	/// Remove an entry. If there are entries probed after it it becomes a tombstone so their probing doesn't stop early.
+	/// @note m_entriesMtx should be locked.
+	void eraseEntry(EntryIterator it, U64 key)
+	{
+		if(m_entries.find(key + 1) != m_entries.getEnd()) [[unlikely]]
+		{
+			*it = Entry();
+		}
+		else
+		{
+			m_entries.erase(it);
+		}
 	}
 };
 
@@ -102,29 +182,46 @@ public \
 	friend class MakeSingleton;
 
 public:
-	Error init(AllocAlignedCallback allocCallback, void* allocCallbackData);
+	/// @param cacheDir A directory the resource manager can use to cache things. Can be empty.
+	Error init(AllocAlignedCallback allocCallback, void* allocCallbackData, CString cacheDir = {});
 
-	/// Load a resource.
+	/// Load a resource. If the resource is already loaded it returns the same one.
+	/// @note It's thread-safe. If many threads load the same resource at the same time only one of them will load it and the rest will
+	///       wait for it.
 	template<typename T>
 	Error loadResource(const CString& filename, ResourcePtr<T>& out, Bool async = true);
 
-	// Internals:
+	/// Same as loadResource() but if texture streaming is enabled the mips of the image will be streamed. The user of the image should
+	/// request the mips it needs every frame (see ImageResource::requestScreenSize()) or the image will stay at its smallest mips. The
+	/// streamed images are not shared with the images that loadResource() returns.
+	/// @note It's thread-safe.
+	Error loadStreamedImage(const CString& filename, ImageResourcePtr& out, Bool async = true);
 
-	ANKI_INTERNAL TransferGpuAllocator& getTransferGpuAllocator()
+	/// Call it once at the end of every frame. It submits the texture uploads of the frame, publishes the textures that got streamed and
+	/// schedules the next streaming work.
+	void endFrame();
+
+	Bool getTextureStreamingEnabled() const
 	{
-		return *m_transferGpuAlloc;
+		return m_textureResidency != nullptr;
 	}
 
-	template<typename T>
-	ANKI_INTERNAL T* findLoadedResource(const CString& filename)
+	/// The texture streaming replaces the textures of the images. This number changes every time that happens.
+	U64 getTextureStreamingEpoch() const
 	{
-		return TypeResourceManager<T>::findLoadedResource(filename);
+		return m_textureStreamingEpoch;
 	}
 
-	template<typename T>
-	ANKI_INTERNAL void registerResource(T* ptr)
+	// Internals:
+
+	ANKI_INTERNAL TransferGpuAllocator& getTransferGpuAllocator()
+	{
+		return *m_transferGpuAlloc;
+	}
+
+	ANKI_INTERNAL TextureUploadQueue& getTextureUploadQueue()
 	{
-		TypeResourceManager<T>::registerResource(ptr);
+		return *m_textureUploadQueue;
 	}
 
 	template<typename T>
@@ -152,17 +249,67 @@ public:
 		return *m_fs;
 	}
 
+	ANKI_INTERNAL CookedResourceCache& getCookedResourceCache()
+	{
+		return *m_cookedCache;
+	}
+
+	ANKI_INTERNAL TextureResidencyManager& getTextureResidencyManager()
+	{
+		ANKI_ASSERT(m_textureResidency);
+		return *m_textureResidency;
+	}
+
+	/// Images lock it before they stop being streamed.
+	ANKI_INTERNAL Mutex& getTextureStreamingMutex()
+	{
+		return m_textureStreamingMtx;
+	}
+
+	/// The streaming task of an image is done. The texture will be swapped at the end of the frame.
+	/// @param tex The new texture. If it's null the streaming failed.
+	/// @note It's thread-safe.
+	ANKI_INTERNAL void textureStreamed(ImageResourcePtr image, TexturePtr tex, TextureViewPtr texView);
+
 private:
+	class StreamedTexture
+	{
+	public:
+		ImageResourcePtr m_image;
+		TexturePtr m_tex;
+		TextureViewPtr m_texView;
+	};
+
 	ResourceFilesystem* m_fs = nullptr;
+	CookedResourceCache* m_cookedCache = nullptr;
 	AsyncLoader* m_asyncLoader = nullptr; ///< Async loading thread
 	ShaderProgramResourceSystem* m_shaderProgramSystem = nullptr;
 	TransferGpuAllocator* m_transferGpuAlloc = nullptr;
+	TextureUploadQueue* m_textureUploadQueue = nullptr;
+
+	Atomic<U64> m_uuid = {0};
 
-	U64 m_uuid = 0;
+	/// @name Texture streaming
+	/// @{
+	TextureResidencyManager* m_textureResidency = nullptr;
+	Mutex m_textureStreamingMtx;
+	ResourceDynamicArray<StreamedTexture> m_streamedTextures; ///< Waiting for the end of the frame.
+	Array<ResourceDynamicArray<StreamedTexture>, kMaxFramesInFlight> m_retiredTextures; ///< The GPU might still use them.
+	U64 m_frame = 0;
+	U64 m_textureStreamingEpoch = 0;
+	/// @}
 
 	ResourceManager();
 
 	~ResourceManager();
+
+	/// The body of loadResource().
+	/// @param loadFunc An Error(T& resource) functor that loads a new resource.
+	template<typename T, typename TLoadFunc>
+	Error loadResourceInternal(const CString& filename, U64 cacheKey, ResourcePtr<T>& out, TLoadFunc loadFunc);
+
+	template<typename T>
+	Error waitInFlightLoad(TypeResourceManager<T>& typeManager, typename TypeResourceManager<T>::InFlightLoad& load, ResourcePtr<T>& out);
 };
 /// @}
 
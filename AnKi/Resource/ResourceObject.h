@@ -35,6 +35,21 @@ public:
 		return m_refcount.fetchSub(1);
 	}
 
+	/// Retain only if the refcount is not zero. A zero refcount means that the resource is being deleted.
+	ANKI_INTERNAL Bool tryRetain() const
+	{
+		I32 refcount = m_refcount.load();
+		while(refcount > 0)
+		{
+			if(m_refcount.compareExchange(refcount, refcount + 1))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
 	I32 getRefcount() const
 	{
 		return m_refcount.load();
@@ -54,6 +69,18 @@ public:
 		m_fname = fname;
 	}
 
+	/// The key of the resource in the ResourceManager. It's the hash of the filename unless the resource is a variant of another or its
+	/// hash collided with another resource's.
+	ANKI_INTERNAL void setCacheKey(U64 key)
+	{
+		m_cacheKey = key;
+	}
+
+	ANKI_INTERNAL U64 getCacheKey() const
+	{
+		return m_cacheKey;
+	}
+
 	ANKI_INTERNAL void setUuid(U64 uuid)
 	{
 		ANKI_ASSERT(uuid > 0);
@@ -77,6 +104,7 @@ private:
 	mutable Atomic<I32> m_refcount = {0};
 	ResourceString m_fname; ///< Unique resource name.
 	U64 m_uuid = 0;
+	U64 m_cacheKey = 0;
 };
 /// @}
 
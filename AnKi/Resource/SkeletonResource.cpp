@@ -5,15 +5,32 @@
 
 #include <AnKi/Resource/SkeletonResource.h>
 #include <AnKi/Resource/ResourceManager.h>
+#include <AnKi/Resource/CookedResourceCache.h>
+#include <AnKi/Resource/CookedResourceBinary.h>
 #include <AnKi/Util/Xml.h>
 #include <AnKi/Util/StringList.h>
 
 namespace anki {
 
 Error SkeletonResource::load(const ResourceFilename& filename, [[maybe_unused]] Bool async)
+{
+	ResourceString source;
+	ANKI_CHECK(openFileReadAllText(filename, source));
+
+	return ResourceManager::getSingleton().getCookedResourceCache().load<CookedSkeleton>(
+		filename, source,
+		[&](BaseMemoryPool& pool, CookedSkeleton& cooked) {
+			return cook(source, pool, cooked);
+		},
+		[this](const CookedSkeleton& cooked) {
+			return build(cooked);
+		});
+}
+
+Error SkeletonResource::cook(CString source, BaseMemoryPool& pool, CookedSkeleton& cooked)
 {
 	ResourceXmlDocument doc;
-	ANKI_CHECK(openFileParseXml(filename, doc));
+	ANKI_CHECK(doc.parse(source));
 
 	XmlElement rootEl;
 	ANKI_CHECK(doc.getChildElement("skeleton", rootEl));
@@ -28,7 +45,7 @@ Error SkeletonResource::load(const ResourceFilename& filename, [[maybe_unused]]
 	ANKI_CHECK(boneEl.getSiblingElementsCount(boneCount));
 	++boneCount;
 
-	m_bones.resize(boneCount);
+	cooked.m_bones = CookedResourceCache::newArray<CookedSkeletonBone>(pool, boneCount);
 
 	ResourceStringList boneParents;
 
@@ -36,40 +53,33 @@ Error SkeletonResource::load(const ResourceFilename& filename, [[maybe_unused]]
 	boneCount = 0;
 	do
 	{
-		Bone& bone = m_bones[boneCount];
-		bone.m_idx = boneCount;
+		CookedSkeletonBone& bone = cooked.m_bones[boneCount];
 
 		// name
 		CString name;
 		ANKI_CHECK(boneEl.getAttributeText("name", name));
-		bone.m_name = name;
+		bone.m_name = CookedResourceCache::newString(pool, name);
 
 		// transform
-		ANKI_CHECK(boneEl.getAttributeNumbers("transform", bone.m_transform));
+		Mat3x4 trf;
+		ANKI_CHECK(boneEl.getAttributeNumbers("transform", trf));
+		for(U32 i = 0; i < 12; ++i)
+		{
+			bone.m_transform[i] = trf[i];
+		}
 
 		// boneTransform
-		ANKI_CHECK(boneEl.getAttributeNumbers("boneTransform", bone.m_vertTrf));
+		ANKI_CHECK(boneEl.getAttributeNumbers("boneTransform", trf));
+		for(U32 i = 0; i < 12; ++i)
+		{
+			bone.m_vertexTransform[i] = trf[i];
+		}
 
 		// parent
 		CString parent;
 		Bool hasParent;
 		ANKI_CHECK(boneEl.getAttributeTextOptional("parent", parent, hasParent));
-		if(hasParent)
-		{
-			boneParents.pushBack(parent);
-		}
-		else
-		{
-			boneParents.pushBack("");
-
-			if(m_rootBoneIdx != kMaxU32)
-			{
-				ANKI_RESOURCE_LOGE("Skeleton cannot have more than one root nodes");
-				return Error::kUserData;
-			}
-
-			m_rootBoneIdx = boneCount;
-		}
+		boneParents.pushBack((hasParent) ? parent : "");
 
 		// Advance
 		ANKI_CHECK(boneEl.getNextSiblingElement("bone", boneEl));
@@ -78,37 +88,92 @@ Error SkeletonResource::load(const ResourceFilename& filename, [[maybe_unused]]
 
 	// Resolve the parents
 	auto it = boneParents.getBegin();
-	for(U32 i = 0; i < m_bones.getSize(); ++i)
+	for(CookedSkeletonBone& bone : cooked.m_bones)
 	{
-		Bone& bone = m_bones[i];
-
 		if(it->getLength() > 0)
 		{
-			for(U32 j = 0; j < m_bones.getSize(); ++j)
+			for(U32 j = 0; j < cooked.m_bones.getSize(); ++j)
 			{
-				if(m_bones[j].m_name == *it)
+				if(*it == cooked.m_bones[j].m_name.getBegin())
 				{
-					bone.m_parent = &m_bones[j];
+					bone.m_parent = j;
 					break;
 				}
 			}
 
-			if(bone.m_parent == nullptr)
+			if(bone.m_parent == kMaxU32)
 			{
-				ANKI_RESOURCE_LOGE("Bone \"%s\" is referencing an unknown parent \"%s\"", &bone.m_name[0], &it->toCString()[0]);
+				ANKI_RESOURCE_LOGE("Bone \"%s\" is referencing an unknown parent \"%s\"", bone.m_name.getBegin(), it->cstr());
 				return Error::kUserData;
 			}
+		}
+
+		++it;
+	}
+
+	return Error::kNone;
+}
+
+Error SkeletonResource::build(const CookedSkeleton& cooked)
+{
+	m_bones.resize(cooked.m_bones.getSize());
+
+	for(U32 i = 0; i < m_bones.getSize(); ++i)
+	{
+		const CookedSkeletonBone& in = cooked.m_bones[i];
+		Bone& bone = m_bones[i];
+		bone.m_idx = i;
+
+		// name
+		const CString name = in.m_name.getBegin();
+		bone.m_name = name;
 
-			if(bone.m_parent->m_childrenCount >= kMaxChildrenPerBone)
+		const U64 nameHash = name.computeHash();
+		if(m_boneNameHashToIdx.find(nameHash) != m_boneNameHashToIdx.getEnd())
+		{
+			ANKI_RESOURCE_LOGE("Bone name is not unique (or its hash collides with another): %s", name.cstr());
+			return Error::kUserData;
+		}
+		m_boneNameHashToIdx.emplace(nameHash, i);
+
+		// transforms
+		for(U32 j = 0; j < 12; ++j)
+		{
+			bone.m_transform[j] = in.m_transform[j];
+			bone.m_vertTrf[j] = in.m_vertexTransform[j];
+		}
+
+		// parent
+		if(in.m_parent == kMaxU32)
+		{
+			if(m_rootBoneIdx != kMaxU32)
 			{
-				ANKI_RESOURCE_LOGE("Bone \"%s\" cannot have more that %u children", &bone.m_parent->m_name[0], kMaxChildrenPerBone);
+				ANKI_RESOURCE_LOGE("Skeleton cannot have more than one root nodes");
 				return Error::kUserData;
 			}
 
-			bone.m_parent->m_children[bone.m_parent->m_childrenCount++] = &bone;
+			m_rootBoneIdx = i;
 		}
+	}
 
-		++it;
+	for(U32 i = 0; i < m_bones.getSize(); ++i)
+	{
+		const U32 parentIdx = cooked.m_bones[i].m_parent;
+		if(parentIdx == kMaxU32)
+		{
+			continue;
+		}
+
+		Bone& bone = m_bones[i];
+		bone.m_parent = &m_bones[parentIdx];
+
+		if(bone.m_parent->m_childrenCount >= kMaxChildrenPerBone)
+		{
+			ANKI_RESOURCE_LOGE("Bone \"%s\" cannot have more that %u children", &bone.m_parent->m_name[0], kMaxChildrenPerBone);
+			return Error::kUserData;
+		}
+
+		bone.m_parent->m_children[bone.m_parent->m_childrenCount++] = &bone;
 	}
 
 	return Error::kNone;
@@ -8,9 +8,13 @@
 #include <AnKi/Resource/ResourceObject.h>
 #include <AnKi/Math.h>
 #include <AnKi/Util/WeakArray.h>
+#include <AnKi/Util/HashMap.h>
 
 namespace anki {
 
+// Forward
+class CookedSkeleton;
+
 /// @addtogroup resource
 /// @{
 
@@ -103,13 +107,10 @@ public:
 
 	const Bone* tryFindBone(CString name) const
 	{
-		// TODO Optimize
-		for(const Bone& b : m_bones)
+		auto it = m_boneNameHashToIdx.find(name.computeHash());
+		if(it != m_boneNameHashToIdx.getEnd() && m_bones[*it].m_name == name)
 		{
-			if(b.m_name == name)
-			{
-				return &b;
-			}
+			return &m_bones[*it];
 		}
 
 		return nullptr;
@@ -120,9 +121,17 @@ public:
 		return m_bones[m_rootBoneIdx];
 	}
 
+	// Internals:
+
+	/// Parse the XML of the resource. It's what the load() does the first time. See CookedResourceCache.
+	ANKI_INTERNAL static Error cook(CString source, BaseMemoryPool& pool, CookedSkeleton& cooked);
+
 private:
 	ResourceDynamicArray<Bone> m_bones;
+	ResourceHashMap<U64, U32> m_boneNameHashToIdx;
 	U32 m_rootBoneIdx = kMaxU32;
+
+	Error build(const CookedSkeleton& cooked);
 };
 /// @}
 
@@ -0,0 +1,334 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Resource/TextureResidencyManager.h>
+#include <AnKi/Util/Tracer.h>
+#include <algorithm>
+
+namespace anki {
+
+/// The bits of non-negative floats compare the same way as the floats.
+static U32 screenSizeToBits(F32 screenSize)
+{
+	ANKI_ASSERT(screenSize >= 0.0f);
+	U32 bits;
+	memcpy(&bits, &screenSize, sizeof(bits));
+	return bits;
+}
+
+static F32 bitsToScreenSize(U32 bits)
+{
+	F32 screenSize;
+	memcpy(&screenSize, &bits, sizeof(screenSize));
+	return screenSize;
+}
+
+PtrSize TextureResidencyManager::Texture::getResidentMemory() const
+{
+	PtrSize size = 0;
+	for(U32 mip = m_firstResidentMip; mip < m_mipSizes.getSize(); ++mip)
+	{
+		size += m_mipSizes[mip];
+	}
+	return size;
+}
+
+TextureResidencyManager::TextureResidencyManager(PtrSize memoryBudget, PtrSize uploadBudgetPerFrame, U32 evictionDelayFrameCount)
+	: m_memoryBudget(memoryBudget)
+	, m_uploadBudgetPerFrame(uploadBudgetPerFrame)
+	, m_evictionDelayFrameCount(evictionDelayFrameCount)
+{
+}
+
+TextureResidencyManager::~TextureResidencyManager()
+{
+	for(Texture* tex : m_textures)
+	{
+		if(tex->m_alive)
+		{
+			ANKI_RESOURCE_LOGW("Texture still registered in the residency manager");
+		}
+
+		deleteInstance(ResourceMemoryPool::getSingleton(), tex);
+	}
+}
+
+U32 TextureResidencyManager::registerTexture(ConstWeakArray<PtrSize> mipSizes, U32 tailMipCount, void* userData)
+{
+	ANKI_ASSERT(mipSizes.getSize() > 0);
+	ANKI_ASSERT(tailMipCount > 0 && tailMipCount <= mipSizes.getSize());
+
+	WLockGuard<RWMutex> lock(m_mtx);
+
+	U32 handle;
+	if(!m_freeHandles.isEmpty())
+	{
+		handle = m_freeHandles.getBack();
+		m_freeHandles.popBack();
+	}
+	else
+	{
+		handle = m_textures.getSize();
+		m_textures.emplaceBack(newInstance<Texture>(ResourceMemoryPool::getSingleton()));
+	}
+
+	Texture& tex = *m_textures[handle];
+	ANKI_ASSERT(!tex.m_alive);
+	tex.m_mipSizes.resize(mipSizes.getSize());
+	memcpy(tex.m_mipSizes.getBegin(), mipSizes.getBegin(), mipSizes.getSizeInBytes());
+	tex.m_userData = userData;
+	tex.m_requestedMip.setNonAtomically(kMaxU32);
+	tex.m_requestedScreenSize.setNonAtomically(0);
+	tex.m_screenSize = 0.0f;
+	tex.m_tailFirstMip = mipSizes.getSize() - tailMipCount;
+	tex.m_firstResidentMip = tex.m_tailFirstMip;
+	tex.m_wantedMip = tex.m_tailFirstMip;
+	tex.m_lastRequestFrame = 0;
+	tex.m_wantedMipFrame = 0;
+	tex.m_alive = true;
+	tex.m_busy = false;
+
+	m_residentMemory += tex.getResidentMemory();
+
+	return handle;
+}
+
+void TextureResidencyManager::unregisterTexture(U32 texture)
+{
+	WLockGuard<RWMutex> lock(m_mtx);
+
+	Texture& tex = *m_textures[texture];
+	ANKI_ASSERT(tex.m_alive);
+
+	const PtrSize size = tex.getResidentMemory();
+	ANKI_ASSERT(m_residentMemory >= size);
+	m_residentMemory -= size;
+
+	tex.m_alive = false;
+	tex.m_userData = nullptr;
+	tex.m_mipSizes.destroy();
+	m_freeHandles.emplaceBack(texture);
+}
+
+void TextureResidencyManager::requestMip(U32 texture, U32 mip, F32 screenSize)
+{
+	RLockGuard<RWMutex> lock(m_mtx);
+	ANKI_ASSERT(m_textures[texture]->m_alive);
+	m_textures[texture]->m_requestedMip.min(mip);
+	m_textures[texture]->m_requestedScreenSize.max(screenSizeToBits(max(screenSize, 0.0f)));
+}
+
+void TextureResidencyManager::changeDone(U32 texture, Bool applied)
+{
+	WLockGuard<RWMutex> lock(m_mtx);
+	Texture& tex = *m_textures[texture];
+	ANKI_ASSERT(tex.m_alive && tex.m_busy);
+	tex.m_busy = false;
+
+	if(!applied)
+	{
+		m_residentMemory -= tex.getResidentMemory();
+		tex.m_firstResidentMip = tex.m_prevFirstResidentMip;
+		tex.m_wantedMip = tex.m_prevFirstResidentMip;
+		m_residentMemory += tex.getResidentMemory();
+	}
+}
+
+U32 TextureResidencyManager::getFirstResidentMip(U32 texture) const
+{
+	RLockGuard<RWMutex> lock(m_mtx);
+	ANKI_ASSERT(m_textures[texture]->m_alive);
+	return m_textures[texture]->m_firstResidentMip;
+}
+
+Bool TextureResidencyManager::loadsBefore(const Texture& a, const Texture& b)
+{
+	const U32 gapA = a.m_firstResidentMip - a.m_wantedMip;
+	const U32 gapB = b.m_firstResidentMip - b.m_wantedMip;
+	if(gapA != gapB)
+	{
+		return gapA > gapB;
+	}
+
+	// The closer a texture is the bigger it is on the screen
+	if(a.m_screenSize != b.m_screenSize)
+	{
+		return a.m_screenSize > b.m_screenSize;
+	}
+
+	return a.m_lastRequestFrame > b.m_lastRequestFrame;
+}
+
+void TextureResidencyManager::evict(U32 handle, U32 newFirstResidentMip, ResourceDynamicArray<TextureResidencyChange>& changes)
+{
+	Texture& tex = *m_textures[handle];
+	ANKI_ASSERT(!tex.m_busy && newFirstResidentMip > tex.m_firstResidentMip && newFirstResidentMip <= tex.m_tailFirstMip);
+
+	for(U32 mip = tex.m_firstResidentMip; mip < newFirstResidentMip; ++mip)
+	{
+		ANKI_ASSERT(m_residentMemory >= tex.m_mipSizes[mip]);
+		m_residentMemory -= tex.m_mipSizes[mip];
+	}
+
+	tex.m_prevFirstResidentMip = tex.m_firstResidentMip;
+	tex.m_firstResidentMip = newFirstResidentMip;
+	tex.m_busy = true;
+
+	TextureResidencyChange& change = *changes.emplaceBack();
+	change.m_userData = tex.m_userData;
+	change.m_texture = handle;
+	change.m_firstResidentMip = newFirstResidentMip;
+	change.m_screenSize = tex.m_screenSize;
+	change.m_load = false;
+}
+
+void TextureResidencyManager::update(ResourceDynamicArray<TextureResidencyChange>& changes)
+{
+	ANKI_TRACE_SCOPED_EVENT(RsrcTextureResidency);
+
+	WLockGuard<RWMutex> lock(m_mtx);
+	const U64 frame = m_frame++;
+
+	// Gather the requests of the frame and decide which mip each texture wants
+	for(Texture* tex : m_textures)
+	{
+		if(!tex->m_alive)
+		{
+			continue;
+		}
+
+		const U32 requestedMip = tex->m_requestedMip.exchange(kMaxU32);
+		const U32 requestedScreenSize = tex->m_requestedScreenSize.exchange(0);
+		if(requestedMip != kMaxU32)
+		{
+			const U32 mip = min(requestedMip, tex->m_tailFirstMip);
+			tex->m_lastRequestFrame = frame;
+			tex->m_screenSize = bitsToScreenSize(requestedScreenSize);
+
+			// Finer mips are wanted immediately. Coarser only after a while to avoid thrashing
+			if(mip <= tex->m_wantedMip || frame - tex->m_wantedMipFrame >= m_evictionDelayFrameCount)
+			{
+				tex->m_wantedMip = mip;
+				tex->m_wantedMipFrame = frame;
+			}
+		}
+		else if(frame - tex->m_lastRequestFrame >= m_evictionDelayFrameCount)
+		{
+			// Not requested for some time, drop to the tail
+			tex->m_wantedMip = tex->m_tailFirstMip;
+		}
+	}
+
+	// Evict the mips that are not wanted any more
+	ResourceDynamicArray<U32> loadCandidates;
+	ResourceDynamicArray<U32> evictionCandidates;
+	for(U32 handle = 0; handle < m_textures.getSize(); ++handle)
+	{
+		Texture& tex = *m_textures[handle];
+		if(!tex.m_alive || tex.m_busy)
+		{
+			continue;
+		}
+
+		if(tex.m_firstResidentMip < tex.m_wantedMip)
+		{
+			evict(handle, tex.m_wantedMip, changes);
+			continue;
+		}
+
+		if(tex.m_firstResidentMip > tex.m_wantedMip)
+		{
+			loadCandidates.emplaceBack(handle);
+		}
+
+		if(tex.m_firstResidentMip < tex.m_tailFirstMip && tex.m_lastRequestFrame < frame)
+		{
+			evictionCandidates.emplaceBack(handle);
+		}
+	}
+
+	if(loadCandidates.isEmpty())
+	{
+		return;
+	}
+
+	std::sort(loadCandidates.getBegin(), loadCandidates.getEnd(), [this](U32 a, U32 b) {
+		return loadsBefore(*m_textures[a], *m_textures[b]);
+	});
+
+	// The least recently requested textures give their memory first
+	std::sort(evictionCandidates.getBegin(), evictionCandidates.getEnd(), [this](U32 a, U32 b) {
+		return m_textures[a]->m_lastRequestFrame < m_textures[b]->m_lastRequestFrame;
+	});
+	U32 evictionCandidateIdx = 0;
+
+	// Load one mip at a time
+	PtrSize uploadSize = 0;
+	U32 loadCount = 0;
+	for(U32 handle : loadCandidates)
+	{
+		Texture& tex = *m_textures[handle];
+		if(tex.m_busy)
+		{
+			// Got evicted to make room for another
+			continue;
+		}
+
+		const U32 newFirstResidentMip = tex.m_firstResidentMip - 1;
+		const PtrSize mipSize = tex.m_mipSizes[newFirstResidentMip];
+
+		if(loadCount > 0 && uploadSize + mipSize > m_uploadBudgetPerFrame)
+		{
+			// Maybe a smaller mip fits
+			continue;
+		}
+
+		// Make room by evicting mips of textures that are not used this frame
+		while(m_residentMemory + mipSize > m_memoryBudget && evictionCandidateIdx < evictionCandidates.getSize())
+		{
+			const U32 victimHandle = evictionCandidates[evictionCandidateIdx++];
+			Texture& victim = *m_textures[victimHandle];
+			if(victimHandle == handle || victim.m_busy)
+			{
+				continue;
+			}
+
+			PtrSize freedSize = 0;
+			U32 victimNewFirstResidentMip = victim.m_firstResidentMip;
+			while(victimNewFirstResidentMip < victim.m_tailFirstMip && m_residentMemory - freedSize + mipSize > m_memoryBudget)
+			{
+				freedSize += victim.m_mipSizes[victimNewFirstResidentMip];
+				++victimNewFirstResidentMip;
+			}
+
+			evict(victimHandle, victimNewFirstResidentMip, changes);
+
+			// Don't load them back until they are requested again
+			victim.m_wantedMip = max(victim.m_wantedMip, victimNewFirstResidentMip);
+		}
+
+		if(m_residentMemory + mipSize > m_memoryBudget)
+		{
+			// Out of memory. Maybe a smaller mip fits
+			continue;
+		}
+
+		tex.m_prevFirstResidentMip = tex.m_firstResidentMip;
+		tex.m_firstResidentMip = newFirstResidentMip;
+		tex.m_busy = true;
+		m_residentMemory += mipSize;
+		uploadSize += mipSize;
+		++loadCount;
+
+		TextureResidencyChange& change = *changes.emplaceBack();
+		change.m_userData = tex.m_userData;
+		change.m_texture = handle;
+		change.m_firstResidentMip = newFirstResidentMip;
+		change.m_screenSize = tex.m_screenSize;
+		change.m_load = true;
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,119 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Resource/Common.h>
+#include <AnKi/Util/WeakArray.h>
+#include <AnKi/Util/Thread.h>
+
+namespace anki {
+
+/// @addtogroup resource
+/// @{
+
+/// A change in the resident mips of a texture that the TextureResidencyManager decided.
+class TextureResidencyChange
+{
+public:
+	void* m_userData;
+	U32 m_texture;
+	U32 m_firstResidentMip; ///< The new first resident mip.
+	F32 m_screenSize; ///< The biggest size (in pixels) the texture covered on the screen the last frame it was requested. 0 if not known.
+	Bool m_load; ///< If true mips need to be loaded, if false mips need to be evicted.
+};
+
+/// Decides which mips of the streamed textures should be resident. It knows nothing about the GPU. The textures request the mip they need
+/// (feedback from the renderer or some distance heuristic) and once a frame update() decides what to load and what to evict. Loads are
+/// incremental (one mip at a time) and they are limited by a memory budget and by a per-frame upload budget.
+class TextureResidencyManager
+{
+public:
+	/// @param memoryBudget The max size of all resident mips (tail mips included).
+	/// @param uploadBudgetPerFrame The max size of the mips that will be loaded in a single frame. At least one mip will be loaded every
+	///                             frame even if it's bigger.
+	/// @param evictionDelayFrameCount How many frames to wait before evicting mips that are not requested any more.
+	TextureResidencyManager(PtrSize memoryBudget, PtrSize uploadBudgetPerFrame, U32 evictionDelayFrameCount = 60);
+
+	TextureResidencyManager(const TextureResidencyManager&) = delete; // Non-copyable
+
+	~TextureResidencyManager();
+
+	TextureResidencyManager& operator=(const TextureResidencyManager&) = delete; // Non-copyable
+
+	/// Register a texture. Its tail mips are considered resident.
+	/// @param mipSizes The size in bytes of each mip. Mip 0 is the biggest.
+	/// @param tailMipCount How many of the smallest mips are always resident.
+	/// @param userData Will be passed to the TextureResidencyChange.
+	/// @return A handle to the texture.
+	/// @note It's thread-safe.
+	U32 registerTexture(ConstWeakArray<PtrSize> mipSizes, U32 tailMipCount, void* userData);
+
+	/// @note It's thread-safe.
+	void unregisterTexture(U32 texture);
+
+	/// Request a mip. The finest mip requested during a frame wins.
+	/// @param screenSize The size in pixels that the texture covers on the screen (if known). The textures that are bigger on the screen
+	///                   load first.
+	/// @note It's thread-safe.
+	void requestMip(U32 texture, U32 mip, F32 screenSize = 0.0f);
+
+	/// Decide what to load and what to evict. Call it once a frame. The texture of every change is considered busy until changeDone() is
+	/// called for it.
+	void update(ResourceDynamicArray<TextureResidencyChange>& changes);
+
+	/// Notify that a change that update() decided is done.
+	/// @param applied If false the change couldn't be applied (failed to load the mips for example) and the texture goes back to what it was.
+	/// @note It's thread-safe.
+	void changeDone(U32 texture, Bool applied = true);
+
+	/// @note It's thread-safe.
+	U32 getFirstResidentMip(U32 texture) const;
+
+	/// The size of the resident mips of all textures.
+	PtrSize getResidentMemory() const
+	{
+		return m_residentMemory;
+	}
+
+private:
+	class Texture
+	{
+	public:
+		ResourceDynamicArray<PtrSize> m_mipSizes;
+		void* m_userData = nullptr;
+		Atomic<U32> m_requestedMip = {kMaxU32}; ///< The finest mip requested this frame.
+		Atomic<U32> m_requestedScreenSize = {0}; ///< The biggest screen size requested this frame. The bits of a non-negative F32.
+		F32 m_screenSize = 0.0f;
+		U32 m_tailFirstMip = 0; ///< The first of the tail mips.
+		U32 m_firstResidentMip = 0;
+		U32 m_prevFirstResidentMip = 0; ///< What m_firstResidentMip was before the change in flight.
+		U32 m_wantedMip = 0; ///< The mip it wants to have resident.
+		U64 m_lastRequestFrame = 0;
+		U64 m_wantedMipFrame = 0; ///< The frame that m_wantedMip was last requested.
+		Bool m_alive = false;
+		Bool m_busy = false;
+
+		PtrSize getResidentMemory() const;
+	};
+
+	ResourceDynamicArray<Texture*> m_textures; ///< Indexed by the handle.
+	ResourceDynamicArray<U32> m_freeHandles;
+	mutable RWMutex m_mtx; ///< Protects the m_textures and m_freeHandles and the fields of the textures that are not atomic.
+
+	PtrSize m_memoryBudget;
+	PtrSize m_uploadBudgetPerFrame;
+	PtrSize m_residentMemory = 0;
+	U64 m_frame = 1;
+	U32 m_evictionDelayFrameCount;
+
+	/// Return true if texture a should load a mip before texture b.
+	static Bool loadsBefore(const Texture& a, const Texture& b);
+
+	void evict(U32 handle, U32 newFirstResidentMip, ResourceDynamicArray<TextureResidencyChange>& changes);
+};
+/// @}
+
+} // end namespace anki
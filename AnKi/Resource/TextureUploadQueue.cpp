@@ -0,0 +1,134 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Resource/TextureUploadQueue.h>
+#include <AnKi/Gr/GrManager.h>
+#include <AnKi/Gr/CommandBuffer.h>
+#include <AnKi/Gr/Fence.h>
+#include <AnKi/Core/StatsSet.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <AnKi/Util/Tracer.h>
+
+namespace anki {
+
+static StatCounter g_textureUploadRateStatVar(StatCategory::kMisc, "Texture upload MB/s",
+											  StatFlag::kFloat | StatFlag::kShowAverage | StatFlag::kMainThreadUpdates);
+static StatCounter g_textureUploadStallStatVar(StatCategory::kTime, "Texture upload stall",
+											   StatFlag::kMilisecond | StatFlag::kShowAverage | StatFlag::kMainThreadUpdates);
+
+TextureUploadQueue::TextureUploadQueue(TransferGpuAllocator& transferAlloc)
+	: m_transferAlloc(&transferAlloc)
+{
+	// The allocator might wait for the memory of copies that are still pending. Flush them when that happens
+	m_transferAlloc->setWaitCallback(
+		[](void* userData) {
+			static_cast<TextureUploadQueue*>(userData)->flush();
+		},
+		this);
+}
+
+TextureUploadQueue::~TextureUploadQueue()
+{
+	m_transferAlloc->setWaitCallback(nullptr, nullptr);
+	flush();
+}
+
+Error TextureUploadQueue::allocate(PtrSize size, TransferGpuAllocatorHandle& handle)
+{
+	const Second begin = HighRezTimer::getCurrentTime();
+	const Error err = m_transferAlloc->allocate(size, handle);
+	m_stallNs.fetchAdd(U64((HighRezTimer::getCurrentTime() - begin) * 1000000000.0));
+
+	return err;
+}
+
+void TextureUploadQueue::pushCopy(TransferGpuAllocatorHandle& handle, Texture& tex, const TextureSubresourceInfo& subresource)
+{
+	Copy copy;
+	copy.m_tex.reset(&tex);
+	copy.m_view = GrManager::getSingleton().newTextureView(TextureViewInitInfo(&tex, subresource, "RsrcTmp"));
+	copy.m_subresource = subresource;
+	copy.m_handle = std::move(handle);
+
+	{
+		LockGuard lock(m_mtx);
+		m_copies.emplaceBack(std::move(copy));
+	}
+
+	// Someone waits for staging memory and the memory of this copy might be what it waits for
+	if(m_transferAlloc->hasWaiters())
+	{
+		flush();
+	}
+}
+
+void TextureUploadQueue::flush()
+{
+	ResourceDynamicArray<Copy> copies;
+	{
+		LockGuard lock(m_mtx);
+		copies = std::move(m_copies);
+	}
+
+	if(copies.isEmpty())
+	{
+		return;
+	}
+
+	ANKI_TRACE_SCOPED_EVENT(RsrcTextureUpload);
+
+	CommandBufferInitInfo cmdbInit("TextureUploads");
+	cmdbInit.m_flags = CommandBufferFlag::kGeneralWork | CommandBufferFlag::kSmallBatch;
+	CommandBufferPtr cmdb = GrManager::getSingleton().newCommandBuffer(cmdbInit);
+
+	ResourceDynamicArray<TextureBarrierInfo> barriers;
+	barriers.resize(copies.getSize());
+	for(U32 i = 0; i < copies.getSize(); ++i)
+	{
+		barriers[i] = {copies[i].m_tex.get(), TextureUsageBit::kNone, TextureUsageBit::kTransferDestination, copies[i].m_subresource};
+	}
+	cmdb->setPipelineBarrier(barriers, {}, {});
+
+	PtrSize uploadedBytes = 0;
+	for(Copy& copy : copies)
+	{
+		cmdb->copyBufferToTextureView(&copy.m_handle.getBuffer(), copy.m_handle.getOffset(), copy.m_handle.getRange(), copy.m_view.get());
+		uploadedBytes += copy.m_handle.getRange();
+	}
+
+	for(TextureBarrierInfo& barrier : barriers)
+	{
+		barrier.m_previousUsage = TextureUsageBit::kTransferDestination;
+		barrier.m_nextUsage = TextureUsageBit::kSampledFragment | TextureUsageBit::kSampledGeometry;
+	}
+	cmdb->setPipelineBarrier(barriers, {}, {});
+
+	// All the staging memory of the batch is released with the same fence
+	FencePtr fence;
+	cmdb->flush({}, &fence);
+
+	for(Copy& copy : copies)
+	{
+		m_transferAlloc->release(copy.m_handle, fence);
+	}
+
+	m_uploadedBytes.fetchAdd(uploadedBytes);
+}
+
+void TextureUploadQueue::endFrame()
+{
+	flush();
+
+	const Second now = HighRezTimer::getCurrentTime();
+	const Second elapsed = now - m_lastEndFrameTime;
+	if(m_lastEndFrameTime > 0.0 && elapsed > 0.0)
+	{
+		g_textureUploadRateStatVar.set(F64(m_uploadedBytes.exchange(0)) / F64(1_MB) / elapsed);
+		g_textureUploadStallStatVar.set(F64(m_stallNs.exchange(0)) / 1000000.0);
+	}
+	m_lastEndFrameTime = now;
+}
+
+} // end namespace anki
@@ -0,0 +1,71 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Resource/TransferGpuAllocator.h>
+#include <AnKi/Gr/Texture.h>
+#include <AnKi/Gr/TextureView.h>
+
+namespace anki {
+
+/// @addtogroup resource
+/// @{
+
+/// Batches the texture uploads of all resources. The loading threads allocate staging memory and write to it in parallel and then push
+/// the copies to the queue. The copies of many textures are recorded to a single command buffer when the queue gets flushed. That happens
+/// once a frame or when the staging memory runs out. The staging memory of a batch is recycled when the fence of the batch is signaled.
+class TextureUploadQueue
+{
+public:
+	/// @note It registers itself as the wait callback of the allocator (see TransferGpuAllocator::setWaitCallback()).
+	TextureUploadQueue(TransferGpuAllocator& transferAlloc);
+
+	TextureUploadQueue(const TextureUploadQueue&) = delete; // Non-copyable
+
+	~TextureUploadQueue();
+
+	TextureUploadQueue& operator=(const TextureUploadQueue&) = delete; // Non-copyable
+
+	/// Allocate staging memory for a copy. If the staging memory is running out it will block and the pending copies will get flushed.
+	/// @note It's thread-safe.
+	Error allocate(PtrSize size, TransferGpuAllocatorHandle& handle);
+
+	/// Copy the staging memory to a surface or a volume of a texture. The queue takes ownership of the handle.
+	/// @note It's thread-safe.
+	void pushCopy(TransferGpuAllocatorHandle& handle, Texture& tex, const TextureSubresourceInfo& subresource);
+
+	/// Record the pending copies to a command buffer and submit it.
+	/// @note It's thread-safe.
+	void flush();
+
+	/// Call it once a frame. It flushes and updates the stats.
+	void endFrame();
+
+private:
+	class Copy
+	{
+	public:
+		TransferGpuAllocatorHandle m_handle;
+		TexturePtr m_tex;
+		TextureViewPtr m_view;
+		TextureSubresourceInfo m_subresource;
+	};
+
+	TransferGpuAllocator* m_transferAlloc = nullptr;
+
+	Mutex m_mtx;
+	ResourceDynamicArray<Copy> m_copies; ///< Pending copies.
+
+	/// @name Stats
+	/// @{
+	Atomic<U64> m_uploadedBytes = {0};
+	Atomic<U64> m_stallNs = {0}; ///< Time spent waiting for staging memory.
+	Second m_lastEndFrameTime = 0.0;
+	/// @}
+};
+/// @}
+
+} // end namespace anki
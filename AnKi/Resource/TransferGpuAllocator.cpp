@@ -77,6 +77,16 @@ Error TransferGpuAllocator::allocate(PtrSize size, TransferGpuAllocatorHandle& h
 
 		{
 			ANKI_TRACE_SCOPED_EVENT(RsrcWaitTransfer);
+			m_waiterCount.fetchAdd(1);
+
+			// Some of the memory of the pool might belong to work that is not submitted yet. Ask the owner to submit it. Work that is queued
+			// after this point will see the waiter and submit on its own
+			if(m_waitCallback)
+			{
+				m_mtx.unlock();
+				m_waitCallback(m_waitCallbackUserData);
+				m_mtx.lock();
+			}
 
 			// Wait for all memory to be released
 			while(pool->m_pendingReleases != 0)
@@ -95,6 +105,8 @@ Error TransferGpuAllocator::allocate(PtrSize size, TransferGpuAllocatorHandle& h
 					pool->m_fences.popFront();
 				}
 			}
+
+			m_waiterCount.fetchSub(1);
 		}
 
 		pool->m_stackAlloc.reset();
@@ -154,7 +166,8 @@ void TransferGpuAllocator::release(TransferGpuAllocatorHandle& handle, FencePtr
 		ANKI_ASSERT(pool.m_pendingReleases > 0);
 		--pool.m_pendingReleases;
 
-		m_condVar.notifyOne();
+		// More than one thread might wait, each for a different pool
+		m_condVar.notifyAll();
 	}
 
 	handle.invalidate();
@@ -107,6 +107,8 @@ public:
 	static constexpr PtrSize kChunkInitialSize = 64_MB;
 	static constexpr Second kMaxFenceWaitTime = 500.0_ms;
 
+	using WaitCallback = void (*)(void* userData);
+
 	TransferGpuAllocator();
 
 	~TransferGpuAllocator();
@@ -120,6 +122,22 @@ public:
 	/// Release the memory. It will not be recycled before the fence is signaled. It's threadsafe.
 	void release(TransferGpuAllocatorHandle& handle, FencePtr fence);
 
+	/// Return true if some thread is blocked in allocate() waiting for memory to be released.
+	Bool hasWaiters() const
+	{
+		return m_waiterCount.load() > 0;
+	}
+
+	/// Set a callback that allocate() will call when it's about to block waiting for memory to be released. The owner of the handles should
+	/// submit the work that will release them. The callback is called after the waiter is counted (see hasWaiters()) and without holding
+	/// any locks of the allocator. Set it to nullptr to remove it.
+	void setWaitCallback(WaitCallback callback, void* userData)
+	{
+		LockGuard<Mutex> lock(m_mtx);
+		m_waitCallback = callback;
+		m_waitCallbackUserData = userData;
+	}
+
 private:
 	/// This is the chunk the StackAllocatorBuilder will be allocating.
 	class Chunk
@@ -198,9 +216,12 @@ private:
 	};
 
 	PtrSize m_maxAllocSize = 0;
+	Atomic<U32> m_waiterCount = {0};
 
 	Mutex m_mtx; ///< Protect all members bellow.
 	ConditionVariable m_condVar;
+	WaitCallback m_waitCallback = nullptr;
+	void* m_waitCallbackUserData = nullptr;
 	Array<Pool, kPoolCount> m_pools;
 	U8 m_crntPool = 0;
 	PtrSize m_crntPoolAllocatedSize = 0;
@@ -17,6 +17,7 @@
 #include <AnKi/Scene/Components/LightComponent.h>
 #include <AnKi/Scene/Components/ModelComponent.h>
 #include <AnKi/Scene/Components/MoveComponent.h>
+#include <AnKi/Scene/Components/OccluderComponent.h>
 #include <AnKi/Scene/Components/ParticleEmitterComponent.h>
 #include <AnKi/Scene/Components/PlayerControllerComponent.h>
 #include <AnKi/Scene/Components/ReflectionProbeComponent.h>
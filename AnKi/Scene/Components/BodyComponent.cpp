@@ -49,6 +49,10 @@ void BodyComponent::loadMeshResource(CString meshFilename)
 	m_body->setTransform(m_node->getWorldTransform());
 
 	m_dirty = true;
+	markForUpdate();
+
+	// Dynamic bodies are moved by the physics engine, poll them every frame
+	setUpdateEveryFrame(prevMass > 0.0f);
 }
 
 void BodyComponent::setMeshFromModelComponent(U32 patchIndex)
@@ -91,6 +95,8 @@ void BodyComponent::setMass(F32 mass)
 		m_body->setUserData(this);
 
 		m_dirty = true;
+		markForUpdate();
+		setUpdateEveryFrame(mass > 0.0f);
 	}
 	else
 	{
@@ -18,6 +18,9 @@ CameraComponent::CameraComponent(SceneNode* node)
 	m_frustum.init(FrustumType::kPerspective);
 	m_frustum.setWorldTransform(node->getWorldTransform());
 	m_frustum.update();
+
+	// The frustum can be changed directly so poll it
+	setUpdateEveryFrame(true);
 }
 
 CameraComponent::~CameraComponent()
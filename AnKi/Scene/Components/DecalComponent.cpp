@@ -5,6 +5,7 @@
 
 #include <AnKi/Scene/Components/DecalComponent.h>
 #include <AnKi/Scene/SceneGraph.h>
+#include <AnKi/Collision/Functions.h>
 #include <AnKi/Resource/ResourceManager.h>
 #include <AnKi/Shaders/Include/ClusteredShadingTypes.h>
 #include <AnKi/Core/GpuMemory/GpuSceneBuffer.h>
@@ -35,6 +36,7 @@ void DecalComponent::setLayer(CString fname, F32 blendFactor, LayerType type)
 	}
 
 	m_dirty = true;
+	markForUpdate();
 
 	l.m_image = std::move(rsrc);
 	l.m_bindlessTextureIndex = l.m_image->getTextureView().getOrCreateBindlessTextureIndex();
@@ -80,6 +82,8 @@ Error DecalComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
 		gpuDecal.m_sphereRadius = obbW.getExtend().getLength();
 
 		m_gpuSceneDecal.uploadToGpuScene(gpuDecal);
+
+		updateOctreePlaceable(computeAabb(obbW));
 	}
 
 	return Error::kNone;
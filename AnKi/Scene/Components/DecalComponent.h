@@ -48,6 +48,7 @@ public:
 	{
 		m_boxSize = sizeXYZ;
 		m_dirty = true;
+		markForUpdate();
 	}
 
 	const Vec3& getBoxVolumeSize() const
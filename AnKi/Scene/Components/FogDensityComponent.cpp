@@ -46,6 +46,15 @@ Error FogDensityComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
 		gpuVolume.m_density = m_density;
 
 		m_gpuSceneVolume.uploadToGpuScene(gpuVolume);
+
+		if(m_isBox)
+		{
+			updateOctreePlaceable(Aabb(m_aabbMin + m_worldPos, m_aabbMax + m_worldPos));
+		}
+		else
+		{
+			updateOctreePlaceable(Aabb(m_worldPos - m_sphereRadius, m_worldPos + m_sphereRadius));
+		}
 	}
 
 	return Error::kNone;
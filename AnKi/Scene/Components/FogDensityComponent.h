@@ -34,6 +34,7 @@ public:
 		m_aabbMax = sizeXYZ / 2.0f;
 		m_isBox = true;
 		m_dirty = true;
+		markForUpdate();
 	}
 
 	Vec3 getBoxVolumeSize() const
@@ -47,6 +48,7 @@ public:
 		m_sphereRadius = max(kMinShapeSize, radius);
 		m_isBox = false;
 		m_dirty = true;
+		markForUpdate();
 	}
 
 	F32 getSphereVolumeRadius() const
@@ -69,6 +71,7 @@ public:
 	{
 		ANKI_ASSERT(d >= 0.0f);
 		m_dirty = true;
+		markForUpdate();
 		m_density = d;
 	}
 
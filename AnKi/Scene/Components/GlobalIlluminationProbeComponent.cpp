@@ -130,6 +130,8 @@ Error GlobalIlluminationProbeComponent::update(SceneComponentUpdateInfo& info, B
 		gpuProbe.m_uuid = m_uuid;
 		gpuProbe.m_componentArrayIndex = getArrayIndex();
 		m_gpuSceneProbe.uploadToGpuScene(gpuProbe);
+
+		updateOctreePlaceable(aabb);
 	}
 
 	m_shapeDirty = false;
@@ -31,6 +31,7 @@ public:
 		m_halfSize = sizeXYZ / 2.0f;
 		updateMembers();
 		m_shapeDirty = true;
+		markForUpdate();
 	}
 
 	Vec3 getBoxVolumeSize() const
@@ -45,6 +46,7 @@ public:
 		m_cellSize = cellSize;
 		updateMembers();
 		m_shapeDirty = true;
+		markForUpdate();
 	}
 
 	F32 getCellSize() const
@@ -61,6 +63,7 @@ public:
 	{
 		m_fadeDistance = max(0.0f, dist);
 		m_shapeDirty = true;
+		markForUpdate();
 	}
 
 	/// Check if any of the probe's cells need to be re-rendered.
@@ -82,6 +85,7 @@ public:
 		m_cellsRefreshedCount += cellCount;
 		ANKI_ASSERT(m_cellsRefreshedCount <= m_totalCellCount);
 		m_refreshDirty = true;
+		markForUpdate();
 	}
 
 	U32 getUuid() const
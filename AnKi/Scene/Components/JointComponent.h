@@ -23,6 +23,8 @@ public:
 		: SceneComponent(node, kClassType)
 		, m_node(node)
 	{
+		// Joints can break at any time
+		setUpdateEveryFrame(true);
 	}
 
 	~JointComponent();
@@ -45,6 +45,7 @@ void LightComponent::setLightComponentType(LightComponentType newType)
 		m_shadowAtlasUvViewportCount = 0;
 		m_shapeDirty = true;
 		m_otherDirty = true;
+		markForUpdate();
 		m_uuid = 0;
 
 		if(newType == LightComponentType::kDirectional)
@@ -118,6 +119,12 @@ Error LightComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
 			m_gpuSceneLight.allocate();
 		}
 		m_gpuSceneLight.uploadToGpuScene(gpuLight);
+
+		if(m_shapeDirty || moveUpdated)
+		{
+			const Vec3 origin = m_worldTransform.getOrigin().xyz();
+			updateOctreePlaceable(Aabb(origin - m_point.m_radius, origin + m_point.m_radius));
+		}
 	}
 	else if(updated && m_type == LightComponentType::kSpot)
 	{
@@ -161,13 +168,14 @@ Error LightComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
 		gpuLight.m_direction = -m_worldTransform.getRotation().getZAxis();
 		gpuLight.m_outerCos = cos(m_spot.m_outerAngle / 2.0f);
 
-		Array<Vec3, 4> points;
+		Array<Vec3, 5> points;
 		computeEdgesOfFrustum(m_spot.m_distance, m_spot.m_outerAngle, m_spot.m_outerAngle, &points[0]);
 		for(U32 i = 0; i < 4; ++i)
 		{
 			points[i] = m_worldTransform.transform(points[i]);
 			gpuLight.m_edgePoints[i] = points[i].xyz0();
 		}
+		points[4] = m_worldTransform.getOrigin().xyz();
 
 		if(reallyShadow)
 		{
@@ -192,10 +200,18 @@ Error LightComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
 			m_gpuSceneLight.allocate();
 		}
 		m_gpuSceneLight.uploadToGpuScene(gpuLight);
+
+		if(m_shapeDirty || moveUpdated)
+		{
+			updateOctreePlaceable(Aabb(&points[0], points.getSize(), sizeof(Vec3), sizeof(points)));
+		}
 	}
 	else if(m_type == LightComponentType::kDirectional)
 	{
 		m_gpuSceneLight.free();
+
+		// Directional lights affect everything, no point in indexing them
+		deleteOctreePlaceable();
 	}
 
 	m_shapeDirty = false;
@@ -355,6 +371,7 @@ void LightComponent::setShadowAtlasUvViewports(ConstWeakArray<Vec4> viewports)
 		}
 
 		m_shapeDirty = true;
+		markForUpdate();
 	}
 }
 
@@ -53,12 +53,14 @@ public:
 	{
 		m_diffColor = x;
 		m_otherDirty = true;
+		markForUpdate();
 	}
 
 	void setRadius(F32 x)
 	{
 		m_point.m_radius = x;
 		m_shapeDirty = true;
+		markForUpdate();
 	}
 
 	F32 getRadius() const
@@ -70,6 +72,7 @@ public:
 	{
 		m_spot.m_distance = x;
 		m_shapeDirty = true;
+		markForUpdate();
 	}
 
 	F32 getDistance() const
@@ -81,6 +84,7 @@ public:
 	{
 		m_spot.m_innerAngle = ang;
 		m_shapeDirty = true;
+		markForUpdate();
 	}
 
 	F32 getInnerAngle() const
@@ -92,6 +96,7 @@ public:
 	{
 		m_spot.m_outerAngle = ang;
 		m_shapeDirty = true;
+		markForUpdate();
 	}
 
 	F32 getOuterAngle() const
@@ -110,6 +115,7 @@ public:
 		{
 			m_shadow = x;
 			m_shapeDirty = m_otherDirty = true;
+			markForUpdate();
 		}
 	}
 
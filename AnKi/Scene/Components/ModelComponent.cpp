@@ -9,6 +9,7 @@
 #include <AnKi/Scene/Components/MoveComponent.h>
 #include <AnKi/Scene/Components/SkinComponent.h>
 #include <AnKi/Resource/ModelResource.h>
+#include <AnKi/Resource/ImageResource.h>
 #include <AnKi/Resource/ResourceManager.h>
 #include <AnKi/Shaders/Include/GpuSceneFunctions.h>
 
@@ -55,6 +56,7 @@ void ModelComponent::loadModelResource(CString filename)
 	}
 
 	m_resourceChanged = true;
+	markForUpdate();
 
 	m_model = std::move(rsrc);
 	const U32 modelPatchCount = m_model->getModelPatches().getSize();
@@ -123,6 +125,17 @@ Error ModelComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
 		return Error::kNone;
 	}
 
+	if(m_resourceChanged && m_model.isCreated() && !m_model->isLoaded()) [[unlikely]]
+	{
+		// The meshes are still uploading. Poll until they are done. Treat the 1st update after that like the 1st update of the component
+		updated = false;
+		m_firstTimeUpdate = true;
+		setUpdateEveryFrame(!m_model->loadFailed());
+		return Error::kNone;
+	}
+
+	setUpdateEveryFrame(false);
+
 	const Bool resourceUpdated = m_resourceChanged;
 	m_resourceChanged = false;
 	const Bool moved = info.m_node->movedThisFrame() || m_firstTimeUpdate;
@@ -133,7 +146,7 @@ Error ModelComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
 
 	updated = resourceUpdated || moved || movedLastFrame;
 
-	// Upload GpuSceneMeshLod, uniforms and GpuSceneRenderable
+	// Upload GpuSceneMeshLod and GpuSceneRenderable
 	if(resourceUpdated) [[unlikely]]
 	{
 		// Upload the mesh views
@@ -205,8 +218,14 @@ Error ModelComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
 			gpuRenderable.m_uuid = SceneGraph::getSingleton().getNewUuid();
 			m_patchInfos[i].m_gpuSceneRenderable.uploadToGpuScene(gpuRenderable);
 		}
+	}
 
-		// Upload the uniforms
+	// Upload the uniforms
+	const Bool uniformsDirty = m_uniformsDirty;
+	m_uniformsDirty = false;
+	if(resourceUpdated || uniformsDirty) [[unlikely]]
+	{
+		const U32 modelPatchCount = m_model->getModelPatches().getSize();
 		DynamicArray<U32, MemoryPoolPtrWrapper<StackMemoryPool>> allUniforms(info.m_framePool);
 		allUniforms.resize(m_gpuSceneUniforms.getAllocatedSize() / 4);
 		U32 count = 0;
@@ -238,7 +257,9 @@ Error ModelComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
 	if(aabbUpdated) [[unlikely]]
 	{
 		const Aabb aabbWorld = computeAabbWorldSpace(info.m_node->getWorldTransform());
+		m_worldAabb = aabbWorld;
 		SceneGraph::getSingleton().updateSceneBounds(aabbWorld.getMin().xyz(), aabbWorld.getMax().xyz());
+		updateOctreePlaceable(aabbWorld);
 	}
 
 	// Update the buckets
@@ -339,11 +360,73 @@ void ModelComponent::onOtherComponentRemovedOrAdded(SceneComponent* other, Bool
 	{
 		m_skinComponent = static_cast<SkinComponent*>(other);
 		m_resourceChanged = true;
+		markForUpdate();
 	}
 	else if(!added && other == m_skinComponent)
 	{
 		m_skinComponent = nullptr;
 		m_resourceChanged = true;
+		markForUpdate();
+	}
+}
+
+void ModelComponent::updateStreamedTextures()
+{
+	if(!isEnabled() || m_resourceChanged || m_firstTimeUpdate)
+	{
+		// Not ready
+		return;
+	}
+
+	U32 version = 0;
+	for(const ModelPatch& patch : m_model->getModelPatches())
+	{
+		version += patch.getMaterial()->getStreamedTexturesVersion();
+	}
+
+	if(version != m_streamedTexturesVersion)
+	{
+		m_streamedTexturesVersion = version;
+		m_uniformsDirty = true;
+		markForUpdate();
+	}
+}
+
+void ModelComponent::requestStreamedTextureMips() const
+{
+	if(!isEnabled() || m_resourceChanged || m_firstTimeUpdate)
+	{
+		// Not ready
+		return;
+	}
+
+	// Assume that the textures are mapped once on the model
+	const F32 pixels = SceneGraph::getSingleton().estimateScreenSize(m_worldAabb);
+
+	for(const ModelPatch& patch : m_model->getModelPatches())
+	{
+		for(const MaterialVariable& var : patch.getMaterial()->getVariables())
+		{
+			if(var.isBindlessTexture())
+			{
+				var.getValue<ImageResourcePtr>()->requestScreenSize(pixels);
+			}
+		}
+	}
+}
+
+U32 ModelComponent::getRenderableBoundingVolumeIndex(U32 patch, RenderingTechnique t) const
+{
+	const PatchInfo& info = m_patchInfos[patch];
+	switch(t)
+	{
+	case RenderingTechnique::kGBuffer:
+		return (info.m_gpuSceneRenderableAabbGBuffer.isValid()) ? info.m_gpuSceneRenderableAabbGBuffer.getIndex() : kMaxU32;
+	case RenderingTechnique::kForward:
+		return (info.m_gpuSceneRenderableAabbForward.isValid()) ? info.m_gpuSceneRenderableAabbForward.getIndex() : kMaxU32;
+	default:
+		ANKI_ASSERT(!"Not supported");
+		return kMaxU32;
 	}
 }
 
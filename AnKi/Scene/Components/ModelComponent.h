@@ -44,6 +44,28 @@ public:
 		return m_castsShadow;
 	}
 
+	/// The last AABB that got computed.
+	const Aabb& getWorldAabb() const
+	{
+		return m_worldAabb;
+	}
+
+	ANKI_INTERNAL U32 getPatchCount() const
+	{
+		return m_patchInfos.getSize();
+	}
+
+	/// Get the index of a patch in the GpuSceneArrays::RenderableBoundingVolumeXXX array of a technique. Returns kMaxU32 if the patch isn't
+	/// rendered with that technique. Only kGBuffer and kForward are supported.
+	ANKI_INTERNAL U32 getRenderableBoundingVolumeIndex(U32 patch, RenderingTechnique t) const;
+
+	/// Re-upload the uniforms if the texture streaming changed the textures of the model.
+	/// @note It's thread-safe against other ModelComponents.
+	ANKI_INTERNAL void updateStreamedTextures();
+
+	/// Request the mips of the streamed textures based on the size of the model on the screen.
+	ANKI_INTERNAL void requestStreamedTextureMips() const;
+
 private:
 	class PatchInfo
 	{
@@ -69,7 +91,11 @@ private:
 	GpuSceneArrays::Transform::Allocation m_gpuSceneTransforms;
 	SceneDynamicArray<PatchInfo> m_patchInfos;
 
+	Aabb m_worldAabb; ///< The last one that got computed.
+	U32 m_streamedTexturesVersion = 0; ///< The sum of the versions of all materials.
+
 	Bool m_resourceChanged : 1 = true;
+	Bool m_uniformsDirty : 1 = false;
 	Bool m_castsShadow : 1 = false;
 	Bool m_movedLastFrame : 1 = true;
 	Bool m_firstTimeUpdate : 1 = true; ///< Extra flag in case the component is added in a node that hasn't been moved.
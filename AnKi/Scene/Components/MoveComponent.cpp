@@ -10,7 +10,8 @@ namespace anki {
 
 Error MoveComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
 {
-	updated = info.m_node->updateTransform();
+	// The SceneGraph has already updated the world transform of the node
+	updated = info.m_node->movedThisFrame();
 	return Error::kNone;
 }
 
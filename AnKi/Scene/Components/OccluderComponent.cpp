@@ -0,0 +1,73 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Scene/Components/OccluderComponent.h>
+#include <AnKi/Scene/SceneNode.h>
+#include <AnKi/Resource/CpuMeshResource.h>
+#include <AnKi/Resource/ResourceManager.h>
+
+namespace anki {
+
+OccluderComponent::OccluderComponent(SceneNode* node)
+	: SceneComponent(node, kClassType)
+{
+}
+
+OccluderComponent::~OccluderComponent()
+{
+}
+
+void OccluderComponent::loadMeshResource(CString meshFilename)
+{
+	CpuMeshResourcePtr rsrc;
+	const Error err = ResourceManager::getSingleton().loadResource(meshFilename, rsrc);
+	if(err)
+	{
+		ANKI_SCENE_LOGE("Failed to load mesh");
+		return;
+	}
+
+	m_mesh = std::move(rsrc);
+	m_dirty = true;
+	markForUpdate();
+}
+
+CString OccluderComponent::getMeshResourceFilename() const
+{
+	return (m_mesh.isCreated()) ? m_mesh->getFilename() : CString();
+}
+
+Error OccluderComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
+{
+	updated = isEnabled() && (m_dirty || info.m_node->movedThisFrame());
+	if(!updated)
+	{
+		return Error::kNone;
+	}
+
+	m_dirty = false;
+
+	// Unpack the triangles to world space. The rasterizer doesn't care about indices
+	const Transform& trf = info.m_node->getWorldTransform();
+	const ConstWeakArray<Vec3> positions = m_mesh->getPositions();
+	const ConstWeakArray<U32> indices = m_mesh->getIndices();
+	m_worldTriangles.resize(indices.getSize());
+
+	Vec3 aabbMin(kMaxF32);
+	Vec3 aabbMax(kMinF32);
+	for(U32 i = 0; i < indices.getSize(); ++i)
+	{
+		m_worldTriangles[i] = trf.transform(positions[indices[i]]);
+		aabbMin = aabbMin.min(m_worldTriangles[i]);
+		aabbMax = aabbMax.max(m_worldTriangles[i]);
+	}
+
+	m_worldAabb = (indices.getSize()) ? Aabb(aabbMin, aabbMax + kEpsilonf) : Aabb(Vec3(0.0f), Vec3(kEpsilonf));
+	updateOctreePlaceable(m_worldAabb);
+
+	return Error::kNone;
+}
+
+} // end namespace anki
@@ -0,0 +1,59 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Scene/Components/SceneComponent.h>
+#include <AnKi/Resource/Forward.h>
+#include <AnKi/Collision/Aabb.h>
+#include <AnKi/Util/WeakArray.h>
+
+namespace anki {
+
+/// @addtogroup scene
+/// @{
+
+/// Designates a mesh as an occluder of the CPU occlusion culling (see OcclusionCuller). The mesh should be simple and it should be inside
+/// the geometry it stands for (a few boxes inside the walls of a building for example) or it will hide things that are visible.
+class OccluderComponent : public SceneComponent
+{
+	ANKI_SCENE_COMPONENT(OccluderComponent)
+
+public:
+	OccluderComponent(SceneNode* node);
+
+	~OccluderComponent();
+
+	void loadMeshResource(CString meshFilename);
+
+	CString getMeshResourceFilename() const;
+
+	Bool isEnabled() const
+	{
+		return m_mesh.isCreated();
+	}
+
+	/// The triangles of the mesh in world space. Every 3 vertices are a triangle.
+	ConstWeakArray<Vec3> getWorldTriangles() const
+	{
+		return m_worldTriangles;
+	}
+
+	const Aabb& getWorldAabb() const
+	{
+		return m_worldAabb;
+	}
+
+private:
+	CpuMeshResourcePtr m_mesh;
+	SceneDynamicArray<Vec3> m_worldTriangles;
+	Aabb m_worldAabb = Aabb(Vec3(0.0f), Vec3(kEpsilonf));
+	Bool m_dirty = true;
+
+	Error update(SceneComponentUpdateInfo& info, Bool& updated) override;
+};
+/// @}
+
+} // end namespace anki
@@ -8,6 +8,7 @@
 #include <AnKi/Scene/SceneNode.h>
 #include <AnKi/Scene/Components/MoveComponent.h>
 #include <AnKi/Resource/ParticleEmitterResource.h>
+#include <AnKi/Resource/ImageResource.h>
 #include <AnKi/Resource/ResourceManager.h>
 #include <AnKi/Physics/PhysicsBody.h>
 #include <AnKi/Physics/PhysicsCollisionShape.h>
@@ -196,6 +197,9 @@ public:
 ParticleEmitterComponent::ParticleEmitterComponent(SceneNode* node)
 	: SceneComponent(node, kClassType)
 {
+	// The simulation runs every frame
+	setUpdateEveryFrame(true);
+
 	// Allocate and populate a quad
 	const U32 vertCount = 4;
 	const U32 indexCount = 6;
@@ -360,6 +364,28 @@ Error ParticleEmitterComponent::update(SceneComponentUpdateInfo& info, Bool& upd
 		patcher.newCopy(*info.m_framePool, m_gpuSceneAlphas, sizeof(F32) * m_aliveParticleCount, alphas);
 	}
 
+	// Upload uniforms. The texture streaming might change them
+	const MaterialResource& mtl = *m_particleEmitterResource->getMaterial();
+	if(m_resourceUpdated || mtl.getStreamedTexturesVersion() != m_streamedTexturesVersion)
+	{
+		m_streamedTexturesVersion = mtl.getStreamedTexturesVersion();
+		patcher.newCopy(*info.m_framePool, m_gpuSceneUniforms, mtl.getPrefilledLocalUniforms().getSizeInBytes(),
+						mtl.getPrefilledLocalUniforms().getBegin());
+	}
+
+	// Request the mips of the streamed textures
+	if(m_aliveParticleCount > 0 && ResourceManager::getSingleton().getTextureStreamingEnabled())
+	{
+		const F32 pixels = SceneGraph::getSingleton().estimateScreenSize(aabbWorld);
+		for(const MaterialVariable& var : mtl.getVariables())
+		{
+			if(var.isBindlessTexture())
+			{
+				var.getValue<ImageResourcePtr>()->requestScreenSize(pixels);
+			}
+		}
+	}
+
 	if(m_resourceUpdated)
 	{
 		// Upload GpuSceneParticleEmitter
@@ -374,10 +400,6 @@ Error ParticleEmitterComponent::update(SceneComponentUpdateInfo& info, Bool& upd
 		}
 		m_gpuSceneParticleEmitter.uploadToGpuScene(particles);
 
-		// Upload uniforms
-		patcher.newCopy(*info.m_framePool, m_gpuSceneUniforms, m_particleEmitterResource->getMaterial()->getPrefilledLocalUniforms().getSizeInBytes(),
-						m_particleEmitterResource->getMaterial()->getPrefilledLocalUniforms().getBegin());
-
 		// Upload mesh LODs
 		GpuSceneMeshLod meshLod = {};
 		meshLod.m_vertexOffsets[U32(VertexStreamId::kPosition)] =
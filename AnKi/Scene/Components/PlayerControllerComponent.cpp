@@ -19,6 +19,9 @@ PlayerControllerComponent::PlayerControllerComponent(SceneNode* node)
 	m_player->setUserData(this);
 
 	node->setIgnoreParentTransform(true);
+
+	// The player is moved by the physics engine
+	setUpdateEveryFrame(true);
 }
 
 Error PlayerControllerComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
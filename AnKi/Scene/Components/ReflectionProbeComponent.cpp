@@ -74,6 +74,8 @@ Error ReflectionProbeComponent::update(SceneComponentUpdateInfo& info, Bool& upd
 		gpuProbe.m_uuid = m_uuid;
 		gpuProbe.m_componentArrayIndex = getArrayIndex();
 		m_gpuSceneProbe.uploadToGpuScene(gpuProbe);
+
+		updateOctreePlaceable(aabbWorld);
 	}
 
 	return Error::kNone;
@@ -32,6 +32,7 @@ public:
 	{
 		m_halfSize = sizeXYZ / 2.0f;
 		m_dirty = true;
+		markForUpdate();
 		m_reflectionNeedsRefresh = true;
 	}
 
@@ -49,6 +50,7 @@ public:
 	{
 		m_reflectionNeedsRefresh = false;
 		m_dirty = true; // To force update of the gpu scene
+		markForUpdate();
 	}
 
 	U32 getUuid() const
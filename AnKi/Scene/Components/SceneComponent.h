@@ -9,6 +9,7 @@
 #include <AnKi/Util/Functions.h>
 #include <AnKi/Util/BitMask.h>
 #include <AnKi/Util/Enum.h>
+#include <AnKi/Collision/Forward.h>
 
 namespace anki {
 
@@ -74,12 +75,14 @@ class SceneComponent
 {
 public:
 	/// Construct the scene component.
-	SceneComponent([[maybe_unused]] SceneNode* node, SceneComponentType type)
-		: m_type(type)
+	SceneComponent(SceneNode* node, SceneComponentType type)
+		: m_ownerNode(node)
+		, m_type(type)
 	{
+		ANKI_ASSERT(node);
 	}
 
-	virtual ~SceneComponent() = default;
+	virtual ~SceneComponent();
 
 	SceneComponentType getType() const
 	{
@@ -125,10 +128,36 @@ public:
 		return m_updateOrderWeights[type];
 	}
 
+	Bool getUpdateEveryFrame() const
+	{
+		return m_updateEveryFrame;
+	}
+
+protected:
+	/// The SceneGraph updates only the nodes that changed. Call this when the state of the component changes and update() needs to
+	/// run again.
+	/// @note It's thread-safe.
+	void markForUpdate();
+
+	/// Components that poll state they don't own (physics, scripts etc) can ask their node to be updated every frame.
+	void setUpdateEveryFrame(Bool updateEveryFrame);
+
+	/// Spatial components call this when their world bounds change so the queries of the Octree can find them. The user data of the
+	/// placeable is the SceneComponent.
+	/// @note It's thread-safe.
+	void updateOctreePlaceable(const Aabb& aabbWorld);
+
+	/// Remove the component from the Octree (if it's there). It's called by the destructor as well.
+	/// @note It's thread-safe.
+	void deleteOctreePlaceable();
+
 private:
+	SceneNode* m_ownerNode;
 	Timestamp m_timestamp = 1; ///< Indicates when an update happened
 	U32 m_arrayIdx = kMaxU32;
+	U32 m_octreePlaceable = kMaxU32;
 	SceneComponentType m_type; ///< Cache the type ID.
+	Bool m_updateEveryFrame = false;
 
 	static constexpr Array<F32, U32(SceneComponentType::kCount)> m_updateOrderWeights = {
 #define ANKI_DEFINE_SCENE_COMPONENT(name, weight) weight
@@ -28,6 +28,8 @@ ANKI_SCENE_COMPONENT_SEPARATOR
 
 ANKI_DEFINE_SCENE_COMPONENT(Model, 100.0f)
 ANKI_SCENE_COMPONENT_SEPARATOR
+ANKI_DEFINE_SCENE_COMPONENT(Occluder, 100.0f)
+ANKI_SCENE_COMPONENT_SEPARATOR
 ANKI_DEFINE_SCENE_COMPONENT(ParticleEmitter, 100.0f)
 ANKI_SCENE_COMPONENT_SEPARATOR
 ANKI_DEFINE_SCENE_COMPONENT(Decal, 100.0f)
@@ -16,6 +16,7 @@ ScriptComponent::ScriptComponent(SceneNode* node)
 	: SceneComponent(node, kClassType)
 {
 	ANKI_ASSERT(node);
+	setUpdateEveryFrame(true);
 }
 
 ScriptComponent::~ScriptComponent()
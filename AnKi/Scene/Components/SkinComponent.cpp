@@ -16,6 +16,8 @@ namespace anki {
 SkinComponent::SkinComponent(SceneNode* node)
 	: SceneComponent(node, kClassType)
 {
+	// The animation time advances every frame
+	setUpdateEveryFrame(true);
 }
 
 SkinComponent::~SkinComponent()
@@ -33,6 +35,7 @@ void SkinComponent::loadSkeletonResource(CString fname)
 	}
 
 	m_forceFullUpdate = true;
+	markForUpdate();
 
 	m_skeleton = std::move(rsrc);
 
@@ -49,6 +52,41 @@ void SkinComponent::loadSkeletonResource(CString fname)
 	m_animationTrfs.resize(boneCount, Trf{Vec3(0.0f), Quat::getIdentity(), 1.0f});
 
 	m_gpuSceneBoneTransforms = GpuSceneBuffer::getSingleton().allocate(sizeof(Mat4) * boneCount * 2, 4);
+
+	// The bone indices of the animations depend on the skeleton
+	for(Track& track : m_tracks)
+	{
+		bindTrackChannels(track);
+	}
+}
+
+void SkinComponent::bindTrackChannels(Track& track)
+{
+	track.m_channelBoneIndices.destroy();
+	track.m_channelCursors.destroy();
+
+	if(!track.m_anim.isCreated() || !m_skeleton.isCreated())
+	{
+		return;
+	}
+
+	const ConstWeakArray<AnimationChannel> channels = track.m_anim->getChannels();
+	track.m_channelBoneIndices.resize(channels.getSize());
+	track.m_channelCursors.resize(channels.getSize());
+
+	for(U32 i = 0; i < channels.getSize(); ++i)
+	{
+		const Bone* bone = m_skeleton->tryFindBone(channels[i].m_name.toCString());
+		if(bone)
+		{
+			track.m_channelBoneIndices[i] = bone->getIndex();
+		}
+		else
+		{
+			ANKI_SCENE_LOGW("Animation is referencing unknown bone \"%s\"", channels[i].m_name.cstr());
+			track.m_channelBoneIndices[i] = kMaxU32;
+		}
+	}
 }
 
 void SkinComponent::playAnimation(U32 track, AnimationResourcePtr anim, const AnimationPlayInfo& info)
@@ -69,6 +107,8 @@ void SkinComponent::playAnimation(U32 track, AnimationResourcePtr anim, const An
 		m_tracks[track].m_blendOutTime = 0.0; // Irrelevant
 	}
 	m_tracks[track].m_repeatTimes = info.m_repeatTimes;
+
+	bindTrackChannels(m_tracks[track]);
 }
 
 Error SkinComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
@@ -113,23 +153,22 @@ Error SkinComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
 		const Second animTime = track.m_relativeTimePassed;
 		track.m_relativeTimePassed += dt;
 
-		// Iterate the animation channels and interpolate
-		for(U32 i = 0; i < track.m_anim->getChannels().getSize(); ++i)
+		// Sample all the channels in one go
+		DynamicArray<AnimationSample, MemoryPoolPtrWrapper<StackMemoryPool>> samples(info.m_framePool);
+		samples.resize(track.m_anim->getChannels().getSize());
+		track.m_anim->sample(animTime, WeakArray<AnimationChannelCursor>(track.m_channelCursors), WeakArray<AnimationSample>(samples));
+
+		for(U32 i = 0; i < samples.getSize(); ++i)
 		{
-			const AnimationChannel& channel = track.m_anim->getChannels()[i];
-			const Bone* bone = m_skeleton->tryFindBone(channel.m_name.toCString());
-			if(!bone)
+			const U32 boneIdx = track.m_channelBoneIndices[i];
+			if(boneIdx == kMaxU32)
 			{
-				ANKI_SCENE_LOGW("Animation is referencing unknown bone \"%s\"", &channel.m_name[0]);
 				continue;
 			}
-			const U32 boneIdx = bone->getIndex();
 
-			// Interpolate
-			Vec3 position;
-			Quat rotation;
-			F32 scale;
-			track.m_anim->interpolate(i, animTime, position, rotation, scale);
+			Vec3 position = samples[i].m_position;
+			Quat rotation = samples[i].m_rotation;
+			F32 scale = samples[i].m_scale;
 
 			// Blend with previous track
 			if(bonesAnimated.get(boneIdx) && (track.m_blendInTime > 0.0 || track.m_blendOutTime > 0.0))
@@ -12,6 +12,7 @@
 #include <AnKi/Util/WeakArray.h>
 #include <AnKi/Math.h>
 #include <AnKi/Core/GpuMemory/GpuSceneBuffer.h>
+#include <AnKi/Resource/AnimationResource.h>
 
 namespace anki {
 
@@ -92,6 +93,10 @@ private:
 		Second m_blendInTime = 0.0;
 		Second m_blendOutTime = 0.0f;
 		F32 m_repeatTimes = 1.0f;
+
+		/// The bone of every channel of the animation. kMaxU32 if the skeleton doesn't have the bone.
+		SceneDynamicArray<U32> m_channelBoneIndices;
+		SceneDynamicArray<AnimationChannelCursor> m_channelCursors;
 	};
 
 	class Trf
@@ -117,6 +122,8 @@ private:
 
 	Error update(SceneComponentUpdateInfo& info, Bool& updated) override;
 
+	void bindTrackChannels(Track& track);
+
 	void visitBones(const Bone& bone, const Mat3x4& parentTrf, const BitSet<128, U8>& bonesAnimated, Vec4& minExtend, Vec4& maxExtend);
 };
 /// @}
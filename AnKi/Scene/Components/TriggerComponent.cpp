@@ -31,6 +31,7 @@ public:
 		}
 
 		m_updated = true;
+		m_comp->markForUpdate();
 
 		m_comp->m_bodiesEnter.emplaceBack(static_cast<BodyComponent*>(obj.getUserData()));
 	}
@@ -45,6 +46,7 @@ public:
 		}
 
 		m_updated = true;
+		m_comp->markForUpdate();
 
 		m_comp->m_bodiesInside.emplaceBack(static_cast<BodyComponent*>(obj.getUserData()));
 	}
@@ -59,6 +61,7 @@ public:
 		}
 
 		m_updated = true;
+		m_comp->markForUpdate();
 
 		m_comp->m_bodiesExit.emplaceBack(static_cast<BodyComponent*>(obj.getUserData()));
 	}
@@ -86,6 +89,10 @@ void TriggerComponent::setSphereVolumeRadius(F32 radius)
 	m_trigger->setUserData(this);
 	m_trigger->setContactProcessCallback(m_callbacks);
 	m_trigger->setTransform(m_node->getWorldTransform());
+
+	m_sphereRadius = radius;
+	m_shapeDirty = true;
+	markForUpdate();
 }
 
 Error TriggerComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
@@ -105,6 +112,13 @@ Error TriggerComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
 			updated = true;
 			m_trigger->setTransform(info.m_node->getWorldTransform());
 		}
+
+		if(info.m_node->movedThisFrame() || m_shapeDirty)
+		{
+			m_shapeDirty = false;
+			const Vec3 center = info.m_node->getWorldTransform().getOrigin().xyz();
+			updateOctreePlaceable(Aabb(center - m_sphereRadius, center + m_sphereRadius));
+		}
 	}
 
 	return Error::kNone;
@@ -53,6 +53,8 @@ private:
 	SceneDynamicArray<BodyComponent*> m_bodiesInside;
 	SceneDynamicArray<BodyComponent*> m_bodiesExit;
 	MyPhysicsTriggerProcessContactCallback* m_callbacks = nullptr;
+	F32 m_sphereRadius = 0.0f;
+	Bool m_shapeDirty = false;
 
 	Error update(SceneComponentUpdateInfo& info, Bool& updated) override;
 };
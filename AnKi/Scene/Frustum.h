@@ -186,6 +186,15 @@ public:
 		return true;
 	}
 
+	/// Batched version of insideFrustum(). See insidePlanes().
+	/// @param shapes An AabbSoa, SphereSoa or ObbSoa.
+	/// @param[out] insideMask One bit per shape.
+	template<typename TSoa>
+	void insideFrustum(const TSoa& shapes, WeakArray<U32> insideMask) const
+	{
+		insidePlanes(m_viewPlanesW, shapes, insideMask);
+	}
+
 	const ConvexHullShape& getPerspectiveBoundingShapeWorldSpace() const
 	{
 		ANKI_ASSERT(m_frustumType == FrustumType::kPerspective);
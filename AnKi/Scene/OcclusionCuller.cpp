@@ -0,0 +1,134 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Scene/OcclusionCuller.h>
+#include <AnKi/Scene/SceneGraph.h>
+#include <AnKi/Scene/Frustum.h>
+#include <AnKi/Scene/GpuSceneArray.h>
+#include <AnKi/Scene/Components/ModelComponent.h>
+#include <AnKi/Scene/Components/OccluderComponent.h>
+#include <AnKi/Collision/Functions.h>
+#include <AnKi/Core/App.h>
+#include <AnKi/Core/StatsSet.h>
+#include <AnKi/Util/Tracer.h>
+
+namespace anki {
+
+BoolCVar g_occlusionCullingCVar(CVarSubsystem::kScene, "OcclusionCulling", true,
+								"Cull the models that are hidden behind the occluders (see OccluderComponent) on the CPU");
+static NumericCVar<U32> g_occlusionCullingBufferHeightCVar(CVarSubsystem::kScene, "OcclusionCullingBufferHeight", 144, 32, 1024,
+														   "The height of the depth buffer of the CPU occlusion culling");
+
+static StatCounter g_occludedModelsStatVar(StatCategory::kMisc, "Models occluded on CPU", StatFlag::kMainThreadUpdates | StatFlag::kZeroEveryFrame);
+
+void OcclusionCuller::cull(const Frustum& frustum, ConstWeakArray<void*> visibleComponents)
+{
+	m_occludedModelCount = 0;
+	for(SceneDynamicArray<U32>& bitset : m_occludedRenderables)
+	{
+		bitset.resize(0);
+	}
+
+	if(!g_occlusionCullingCVar.get() || frustum.getFrustumType() != FrustumType::kPerspective)
+	{
+		return;
+	}
+
+	ANKI_TRACE_SCOPED_EVENT(SceneOcclusionCulling);
+	StackMemoryPool& framePool = SceneGraph::getSingleton().getFrameMemoryPool();
+	CoreThreadJobManager& jobManager = CoreThreadJobManager::getSingleton();
+
+	// Only the occluders and the models that are inside the frustum. The rest will be culled by the GPU visibility anyway
+	DynamicArray<const OccluderComponent*, MemoryPoolPtrWrapper<StackMemoryPool>> occluders(&framePool);
+	DynamicArray<const ModelComponent*, MemoryPoolPtrWrapper<StackMemoryPool>> models(&framePool);
+	DynamicArray<Aabb, MemoryPoolPtrWrapper<StackMemoryPool>> aabbs(&framePool);
+	for(void* userData : visibleComponents)
+	{
+		const SceneComponent* comp = static_cast<const SceneComponent*>(userData);
+		if(comp->getType() == SceneComponentType::kOccluder)
+		{
+			const OccluderComponent& occluder = static_cast<const OccluderComponent&>(*comp);
+			if(occluder.isEnabled() && occluder.getWorldTriangles().getSize())
+			{
+				occluders.emplaceBack(&occluder);
+			}
+		}
+		else if(comp->getType() == SceneComponentType::kModel)
+		{
+			const ModelComponent& model = static_cast<const ModelComponent&>(*comp);
+			if(model.isEnabled() && model.getPatchCount())
+			{
+				models.emplaceBack(&model);
+				aabbs.emplaceBack(model.getWorldAabb());
+			}
+		}
+	}
+
+	if(occluders.getSize() == 0 || models.getSize() == 0)
+	{
+		return;
+	}
+
+	// Render the occluders. The triangles are already in world space
+	const U32 height = g_occlusionCullingBufferHeightCVar.get();
+	const U32 width = max(1u, U32(F32(height) * F32(g_windowWidthCVar.get()) / F32(max(1u, g_windowHeightCVar.get()))));
+	m_rasterizer.prepare(Mat4(frustum.getViewMatrix(), Vec4(0.0f, 0.0f, 0.0f, 1.0f)), frustum.getProjectionMatrix(), width, height);
+
+	{
+		ThreadJobCounter counter;
+		for(const OccluderComponent* occluder : occluders)
+		{
+			jobManager.dispatchTask(
+				[this, occluder]([[maybe_unused]] U32 tid) {
+					const ConstWeakArray<Vec3> tris = occluder->getWorldTriangles();
+					m_rasterizer.draw(&tris[0][0], tris.getSize(), sizeof(Vec3), true);
+				},
+				&counter);
+		}
+
+		jobManager.waitForCounter(counter);
+	}
+
+	m_rasterizer.rasterize(&jobManager);
+
+	// Test them in one batch
+	DynamicArray<Bool, MemoryPoolPtrWrapper<StackMemoryPool>> visible(&framePool);
+	visible.resize(models.getSize());
+	m_rasterizer.visibilityTests(ConstWeakArray<Aabb>(aabbs), WeakArray<Bool>(visible), &jobManager);
+
+	// Mark the renderables of the occluded models
+	m_occludedRenderables[techniqueToArrayIndex(RenderingTechnique::kGBuffer)].resize(
+		(GpuSceneArrays::RenderableBoundingVolumeGBuffer::getSingleton().getElementCount() + 31) / 32, 0u);
+	m_occludedRenderables[techniqueToArrayIndex(RenderingTechnique::kForward)].resize(
+		(GpuSceneArrays::RenderableBoundingVolumeForward::getSingleton().getElementCount() + 31) / 32, 0u);
+
+	for(U32 i = 0; i < models.getSize(); ++i)
+	{
+		if(visible[i])
+		{
+			continue;
+		}
+
+		++m_occludedModelCount;
+
+		for(U32 patch = 0; patch < models[i]->getPatchCount(); ++patch)
+		{
+			for(RenderingTechnique t : {RenderingTechnique::kGBuffer, RenderingTechnique::kForward})
+			{
+				const U32 idx = models[i]->getRenderableBoundingVolumeIndex(patch, t);
+				if(idx != kMaxU32)
+				{
+					SceneDynamicArray<U32>& bitset = m_occludedRenderables[techniqueToArrayIndex(t)];
+					ANKI_ASSERT(idx / 32 < bitset.getSize());
+					bitset[idx / 32] |= 1u << (idx % 32);
+				}
+			}
+		}
+	}
+
+	g_occludedModelsStatVar.set(m_occludedModelCount);
+}
+
+} // end namespace anki
@@ -0,0 +1,62 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Scene/Common.h>
+#include <AnKi/Scene/SoftwareRasterizer.h>
+#include <AnKi/Resource/RenderingKey.h>
+#include <AnKi/Core/CVarSet.h>
+
+namespace anki {
+
+// Forward
+class Frustum;
+extern BoolCVar g_occlusionCullingCVar;
+
+/// @addtogroup scene
+/// @{
+
+/// CPU occlusion culling of the models. It renders the OccluderComponents with the SoftwareRasterizer from the point of view of the
+/// camera and tests the AABBs of the models against the result. The output is a bitset per rendering technique that the GPU visibility
+/// uses to skip the occluded renderables.
+class OcclusionCuller
+{
+public:
+	/// Render the occluders and test the models.
+	/// @param visibleComponents The components the Octree found inside the frustum. The occluders and the models are taken from there.
+	/// @note Call it after the components are updated.
+	void cull(const Frustum& frustum, ConstWeakArray<void*> visibleComponents);
+
+	/// Get the results of the last cull().
+	/// @param t Only kGBuffer and kForward are supported.
+	/// @return One bit for every element of GpuSceneArrays::RenderableBoundingVolumeGBuffer or RenderableBoundingVolumeForward. If the
+	///         bit is set the renderable is occluded. The array is empty if nothing was culled.
+	ConstWeakArray<U32> getOccludedRenderables(RenderingTechnique t) const
+	{
+		return m_occludedRenderables[techniqueToArrayIndex(t)];
+	}
+
+	/// The number of models the last cull() found occluded.
+	U32 getOccludedModelCount() const
+	{
+		return m_occludedModelCount;
+	}
+
+private:
+	SoftwareRasterizer m_rasterizer;
+
+	Array<SceneDynamicArray<U32>, 2> m_occludedRenderables; ///< One for kGBuffer and one for kForward.
+	U32 m_occludedModelCount = 0;
+
+	static U32 techniqueToArrayIndex(RenderingTechnique t)
+	{
+		ANKI_ASSERT(t == RenderingTechnique::kGBuffer || t == RenderingTechnique::kForward);
+		return (t == RenderingTechnique::kGBuffer) ? 0 : 1;
+	}
+};
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,464 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Scene/Octree.h>
+#include <AnKi/Collision/Functions.h>
+#include <AnKi/Collision/Sphere.h>
+#include <AnKi/Collision/Ray.h>
+#include <AnKi/Util/ThreadJobManager.h>
+
+namespace anki {
+
+/// The depth of the cells that gatherVisible() will walk in parallel.
+constexpr U32 kParallelCellDepth = 2;
+
+template<typename T>
+static U32 computeChildSlot(const Array<T, 3>& coords)
+{
+	return (coords[0] & 1u) | ((coords[1] & 1u) << 1u) | ((coords[2] & 1u) << 2u);
+}
+
+Octree::~Octree()
+{
+	ANKI_ASSERT(getPlaceableCount() == 0 && "Forgot to delete some placeables");
+}
+
+void Octree::init(const Vec3& sceneMin, const Vec3& sceneMax, U32 maxDepth)
+{
+	ANKI_ASSERT(sceneMin < sceneMax);
+	ANKI_ASSERT(maxDepth <= kMaxDepth);
+	ANKI_ASSERT(m_cells.getSize() == 0 && "Already initialized");
+
+	m_min = sceneMin;
+	const Vec3 size = sceneMax - sceneMin;
+	m_rootSize = max(size.x(), max(size.y(), size.z()));
+	m_maxDepth = maxDepth;
+
+	newCell(kMaxU32, 0, {0, 0, 0});
+}
+
+U32 Octree::newCell(U32 parent, U32 depth, const Array<U32, 3>& coords)
+{
+	U32 idx;
+	if(m_freeCells.getSize())
+	{
+		idx = m_freeCells.getBack();
+		m_freeCells.popBack();
+	}
+	else
+	{
+		idx = m_cells.getSize();
+		m_cells.emplaceBack();
+	}
+
+	Cell& cell = m_cells[idx];
+	cell.m_children.fill(kMaxU32);
+	ANKI_ASSERT(cell.m_entries.getSize() == 0);
+	cell.m_parent = parent;
+	cell.m_subtreePlaceableCount = 0;
+	cell.m_depth = U8(depth);
+
+	const F32 cellSize = m_rootSize / F32(1u << depth);
+	Vec3 tightMin;
+	for(U32 i = 0; i < 3; ++i)
+	{
+		cell.m_coords[i] = U16(coords[i]);
+		tightMin[i] = m_min[i] + F32(coords[i]) * cellSize;
+	}
+
+	// The loose bounds extend half a cell in all directions
+	cell.m_looseAabb = Aabb(tightMin - cellSize * 0.5f, tightMin + cellSize * 1.5f);
+
+	return idx;
+}
+
+void Octree::computeTargetCell(const Aabb& aabb, U32& depth, Array<U32, 3>& coords) const
+{
+	const Vec3 extent = (aabb.getMax() - aabb.getMin()).xyz();
+	const F32 maxExtent = max(extent.x(), max(extent.y(), extent.z()));
+	const Vec3 relativeCenter = (aabb.getMin() + aabb.getMax()).xyz() * 0.5f - m_min;
+
+	depth = 0;
+	coords = {0, 0, 0};
+
+	// Objects with their center outside the octree go to the root
+	for(U32 i = 0; i < 3; ++i)
+	{
+		if(!(relativeCenter[i] >= 0.0f && relativeCenter[i] < m_rootSize))
+		{
+			return;
+		}
+	}
+
+	// An object fits in the loose bounds of a cell if its center is inside the tight bounds and its size is less than the cell size
+	F32 cellSize = m_rootSize;
+	while(depth < m_maxDepth && cellSize * 0.5f >= maxExtent)
+	{
+		cellSize *= 0.5f;
+		++depth;
+	}
+
+	const U32 maxCoord = (1u << depth) - 1;
+	for(U32 i = 0; i < 3; ++i)
+	{
+		coords[i] = min(U32(relativeCenter[i] / cellSize), maxCoord);
+	}
+}
+
+U32 Octree::getOrCreateCell(U32 depth, const Array<U32, 3>& coords)
+{
+	U32 cellIdx = 0;
+	for(U32 d = 1; d <= depth; ++d)
+	{
+		const U32 shift = depth - d;
+		const Array<U32, 3> childCoords = {coords[0] >> shift, coords[1] >> shift, coords[2] >> shift};
+		const U32 slot = computeChildSlot(childCoords);
+
+		U32 childIdx = m_cells[cellIdx].m_children[slot];
+		if(childIdx == kMaxU32)
+		{
+			childIdx = newCell(cellIdx, d, childCoords);
+			m_cells[cellIdx].m_children[slot] = childIdx;
+		}
+
+		cellIdx = childIdx;
+	}
+
+	return cellIdx;
+}
+
+void Octree::linkPlaceable(U32 placeable, U32 cellIdx, const Aabb& aabb, void* userData)
+{
+	Cell& cell = m_cells[cellIdx];
+
+	m_placeableCells[placeable] = cellIdx;
+	m_placeableSlots[placeable] = cell.m_entries.getSize();
+
+	CellEntry& entry = *cell.m_entries.emplaceBack();
+	entry.m_aabb = aabb;
+	entry.m_userData = userData;
+	entry.m_placeable = placeable;
+
+	for(U32 idx = cellIdx; idx != kMaxU32; idx = m_cells[idx].m_parent)
+	{
+		++m_cells[idx].m_subtreePlaceableCount;
+	}
+}
+
+void* Octree::unlinkPlaceable(U32 placeable)
+{
+	const U32 cellIdx = m_placeableCells[placeable];
+	const U32 slot = m_placeableSlots[placeable];
+	Cell& cell = m_cells[cellIdx];
+
+	void* userData = cell.m_entries[slot].m_userData;
+
+	// Swap with the last entry
+	if(slot != cell.m_entries.getSize() - 1)
+	{
+		cell.m_entries[slot] = cell.m_entries.getBack();
+		m_placeableSlots[cell.m_entries[slot].m_placeable] = slot;
+	}
+	cell.m_entries.popBack();
+
+	m_placeableCells[placeable] = kMaxU32;
+
+	for(U32 idx = cellIdx; idx != kMaxU32; idx = m_cells[idx].m_parent)
+	{
+		ANKI_ASSERT(m_cells[idx].m_subtreePlaceableCount > 0);
+		--m_cells[idx].m_subtreePlaceableCount;
+	}
+
+	// Release the cells that got empty. Their children are already released. Never release the root
+	U32 idx = cellIdx;
+	while(idx != 0 && m_cells[idx].m_subtreePlaceableCount == 0)
+	{
+		Cell& emptyCell = m_cells[idx];
+		ANKI_ASSERT(emptyCell.m_entries.getSize() == 0);
+		ANKI_ASSERT(std::all_of(emptyCell.m_children.getBegin(), emptyCell.m_children.getEnd(), [](U32 child) {
+			return child == kMaxU32;
+		}));
+
+		emptyCell.m_entries.destroy();
+
+		const U32 parent = emptyCell.m_parent;
+		m_cells[parent].m_children[computeChildSlot(emptyCell.m_coords)] = kMaxU32;
+		m_freeCells.emplaceBack(idx);
+
+		idx = parent;
+	}
+
+	return userData;
+}
+
+U32 Octree::newPlaceable(const Aabb& aabb, void* userData)
+{
+	ANKI_ASSERT(m_cells.getSize() && "Not initialized");
+
+	LockGuard lock(m_mtx);
+
+	U32 idx;
+	if(m_freePlaceables.getSize())
+	{
+		idx = m_freePlaceables.getBack();
+		m_freePlaceables.popBack();
+	}
+	else
+	{
+		idx = m_placeableCells.getSize();
+		m_placeableCells.emplaceBack();
+		m_placeableSlots.emplaceBack();
+	}
+
+	U32 depth;
+	Array<U32, 3> coords;
+	computeTargetCell(aabb, depth, coords);
+	linkPlaceable(idx, getOrCreateCell(depth, coords), aabb, userData);
+
+	return idx;
+}
+
+void Octree::updatePlaceable(U32 placeable, const Aabb& aabb)
+{
+	U32 depth;
+	Array<U32, 3> coords;
+	computeTargetCell(aabb, depth, coords);
+
+	LockGuard lock(m_mtx);
+	ANKI_ASSERT(isAlive(placeable));
+
+	// Most of the time the object stays in the same cell
+	Cell& crntCell = m_cells[m_placeableCells[placeable]];
+	if(crntCell.m_depth == depth && crntCell.m_coords[0] == coords[0] && crntCell.m_coords[1] == coords[1] && crntCell.m_coords[2] == coords[2])
+	{
+		crntCell.m_entries[m_placeableSlots[placeable]].m_aabb = aabb;
+		return;
+	}
+
+	void* userData = unlinkPlaceable(placeable);
+	linkPlaceable(placeable, getOrCreateCell(depth, coords), aabb, userData);
+}
+
+void Octree::deletePlaceable(U32 placeable)
+{
+	LockGuard lock(m_mtx);
+	ANKI_ASSERT(isAlive(placeable));
+
+	unlinkPlaceable(placeable);
+	m_freePlaceables.emplaceBack(placeable);
+}
+
+void Octree::gatherSubtree(U32 cellIdx, OctreeGatherArray& out) const
+{
+	const Cell& cell = m_cells[cellIdx];
+	for(const CellEntry& entry : cell.m_entries)
+	{
+		out.emplaceBack(entry.m_userData);
+	}
+
+	for(U32 child : cell.m_children)
+	{
+		if(child != kMaxU32)
+		{
+			gatherSubtree(child, out);
+		}
+	}
+}
+
+void Octree::gatherVisibleInternal(U32 cellIdx, ConstWeakArray<Plane> planes, OctreeGatherArray& out, U32 taskDepth,
+								   DynamicArray<U32, MemoryPoolPtrWrapper<StackMemoryPool>>* taskCells) const
+{
+	const Cell& cell = m_cells[cellIdx];
+	if(cell.m_subtreePlaceableCount == 0)
+	{
+		return;
+	}
+
+	if(cell.m_depth == taskDepth)
+	{
+		taskCells->emplaceBack(cellIdx);
+		return;
+	}
+
+	// Test the loose bounds. The root holds the objects outside the octree so it can't be tested
+	if(cellIdx != 0)
+	{
+		Bool fullyInside = true;
+		for(const Plane& plane : planes)
+		{
+			const F32 test = testPlane(plane, cell.m_looseAabb);
+			if(test < 0.0f)
+			{
+				return;
+			}
+
+			fullyInside = fullyInside && test > 0.0f;
+		}
+
+		if(fullyInside)
+		{
+			gatherSubtree(cellIdx, out);
+			return;
+		}
+	}
+
+	for(const CellEntry& entry : cell.m_entries)
+	{
+		Bool inside = true;
+		for(const Plane& plane : planes)
+		{
+			if(testPlane(plane, entry.m_aabb) < 0.0f)
+			{
+				inside = false;
+				break;
+			}
+		}
+
+		if(inside)
+		{
+			out.emplaceBack(entry.m_userData);
+		}
+	}
+
+	for(U32 child : cell.m_children)
+	{
+		if(child != kMaxU32)
+		{
+			gatherVisibleInternal(child, planes, out, taskDepth, taskCells);
+		}
+	}
+}
+
+void Octree::gatherVisible(ConstWeakArray<Plane> planes, OctreeGatherArray& out, ThreadJobManager* jobManager) const
+{
+	ANKI_ASSERT(m_cells.getSize() && "Not initialized");
+
+	if(jobManager == nullptr || m_maxDepth < kParallelCellDepth)
+	{
+		gatherVisibleInternal(0, planes, out);
+		return;
+	}
+
+	// Walk the top of the tree serially and gather the cells that will be walked in parallel
+	StackMemoryPool& pool = out.getMemoryPool();
+	DynamicArray<U32, MemoryPoolPtrWrapper<StackMemoryPool>> taskCells(&pool);
+	gatherVisibleInternal(0, planes, out, kParallelCellDepth, &taskCells);
+
+	if(taskCells.getSize() == 0)
+	{
+		return;
+	}
+
+	// Every task writes to its own array and it grabs cells until there are no more
+	const U32 taskCount = min(jobManager->getThreadCount(), taskCells.getSize());
+
+	class Ctx
+	{
+	public:
+		const Octree* m_octree;
+		ConstWeakArray<Plane> m_planes;
+		ConstWeakArray<U32> m_cells;
+		WeakArray<OctreeGatherArray> m_outs;
+		Atomic<U32> m_crntCell = {0};
+		Atomic<U32> m_crntTask = {0};
+	} ctx;
+
+	DynamicArray<OctreeGatherArray, MemoryPoolPtrWrapper<StackMemoryPool>> taskOuts(&pool);
+	for(U32 i = 0; i < taskCount; ++i)
+	{
+		taskOuts.emplaceBack(&pool);
+	}
+
+	ctx.m_octree = this;
+	ctx.m_planes = planes;
+	ctx.m_cells = taskCells;
+	ctx.m_outs = WeakArray<OctreeGatherArray>(taskOuts);
+
+	ThreadJobCounter counter;
+	for(U32 i = 0; i < taskCount; ++i)
+	{
+		jobManager->dispatchTask(
+			[&ctx]([[maybe_unused]] U32 threadId) {
+				OctreeGatherArray& taskOut = ctx.m_outs[ctx.m_crntTask.fetchAdd(1)];
+				while(true)
+				{
+					const U32 idx = ctx.m_crntCell.fetchAdd(1);
+					if(idx >= ctx.m_cells.getSize())
+					{
+						break;
+					}
+
+					ctx.m_octree->gatherVisibleInternal(ctx.m_cells[idx], ctx.m_planes, taskOut);
+				}
+			},
+			&counter);
+	}
+
+	jobManager->waitForCounter(counter);
+
+	// Merge
+	U32 count = out.getSize();
+	for(const OctreeGatherArray& taskOut : taskOuts)
+	{
+		count += taskOut.getSize();
+	}
+
+	U32 offset = out.getSize();
+	out.resize(count);
+	for(const OctreeGatherArray& taskOut : taskOuts)
+	{
+		if(taskOut.getSize())
+		{
+			memcpy(&out[offset], &taskOut[0], taskOut.getSizeInBytes());
+			offset += taskOut.getSize();
+		}
+	}
+}
+
+template<typename TShape>
+void Octree::gatherOverlappingInternal(U32 cellIdx, const TShape& shape, OctreeGatherArray& out) const
+{
+	const Cell& cell = m_cells[cellIdx];
+	if(cell.m_subtreePlaceableCount == 0 || (cellIdx != 0 && !testCollision(cell.m_looseAabb, shape)))
+	{
+		return;
+	}
+
+	for(const CellEntry& entry : cell.m_entries)
+	{
+		if(testCollision(entry.m_aabb, shape))
+		{
+			out.emplaceBack(entry.m_userData);
+		}
+	}
+
+	for(U32 child : cell.m_children)
+	{
+		if(child != kMaxU32)
+		{
+			gatherOverlappingInternal(child, shape, out);
+		}
+	}
+}
+
+void Octree::gatherOverlapping(const Aabb& aabb, OctreeGatherArray& out) const
+{
+	ANKI_ASSERT(m_cells.getSize() && "Not initialized");
+	gatherOverlappingInternal(0, aabb, out);
+}
+
+void Octree::gatherOverlapping(const Sphere& sphere, OctreeGatherArray& out) const
+{
+	ANKI_ASSERT(m_cells.getSize() && "Not initialized");
+	gatherOverlappingInternal(0, sphere, out);
+}
+
+void Octree::gatherOverlapping(const Ray& ray, OctreeGatherArray& out) const
+{
+	ANKI_ASSERT(m_cells.getSize() && "Not initialized");
+	gatherOverlappingInternal(0, ray, out);
+}
+
+} // end namespace anki
@@ -0,0 +1,166 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Scene/Common.h>
+#include <AnKi/Math.h>
+#include <AnKi/Collision/Aabb.h>
+#include <AnKi/Collision/Plane.h>
+#include <AnKi/Util/WeakArray.h>
+
+namespace anki {
+
+// Forward
+class ThreadJobManager;
+class Sphere;
+class Ray;
+
+/// @addtogroup scene
+/// @{
+
+/// The results of the Octree queries.
+using OctreeGatherArray = DynamicArray<void*, MemoryPoolPtrWrapper<StackMemoryPool>>;
+
+/// Loose octree for CPU spatial queries. Every cell has loose bounds twice the size of its tight bounds so an object is stored in a
+/// single cell that is picked by the object's size (depth) and center (cell). The bounds of the objects (placeables) are stored
+/// packed in their cells and the objects are referenced by an index.
+///
+/// Moving an object that stays in the same cell only updates its bounds. Cells are created when needed and released when their
+/// subtree gets empty. Objects outside the octree are stored in the root.
+class Octree
+{
+public:
+	static constexpr U32 kMaxDepth = 10;
+
+	Octree() = default;
+
+	Octree(const Octree&) = delete; // Non-copyable
+
+	~Octree();
+
+	Octree& operator=(const Octree&) = delete; // Non-copyable
+
+	/// @param sceneMin The min of the area the octree will cover.
+	/// @param sceneMax The max of the area the octree will cover.
+	/// @param maxDepth The max depth of the tree. The root is depth 0.
+	void init(const Vec3& sceneMin, const Vec3& sceneMax, U32 maxDepth);
+
+	/// Add a new object.
+	/// @param aabb The world space bounds.
+	/// @param userData What the queries will return.
+	/// @return The index of the placeable.
+	/// @note It's thread-safe against the other methods that change the octree.
+	U32 newPlaceable(const Aabb& aabb, void* userData);
+
+	/// Change the bounds of an object.
+	/// @note It's thread-safe against the other methods that change the octree.
+	void updatePlaceable(U32 placeable, const Aabb& aabb);
+
+	/// @note It's thread-safe against the other methods that change the octree.
+	void deletePlaceable(U32 placeable);
+
+	/// Gather the objects that are inside a volume defined by some planes (a frustum).
+	/// @param planes The planes in world space. Their normals point inside the volume.
+	/// @param[out] out The user data of the objects.
+	/// @param jobManager If not nullptr the sub-trees will be walked in parallel.
+	void gatherVisible(ConstWeakArray<Plane> planes, OctreeGatherArray& out, ThreadJobManager* jobManager = nullptr) const;
+
+	/// Gather the objects that collide with an AABB.
+	void gatherOverlapping(const Aabb& aabb, OctreeGatherArray& out) const;
+
+	/// Gather the objects that collide with a sphere.
+	void gatherOverlapping(const Sphere& sphere, OctreeGatherArray& out) const;
+
+	/// Gather the objects that a ray hits. They are not sorted.
+	void gatherOverlapping(const Ray& ray, OctreeGatherArray& out) const;
+
+	const Aabb& getPlaceableAabb(U32 placeable) const
+	{
+		ANKI_ASSERT(isAlive(placeable));
+		return m_cells[m_placeableCells[placeable]].m_entries[m_placeableSlots[placeable]].m_aabb;
+	}
+
+	/// The number of live placeables.
+	U32 getPlaceableCount() const
+	{
+		return (m_cells.getSize()) ? m_cells[0].m_subtreePlaceableCount : 0;
+	}
+
+	/// The number of live cells. Useful for stats.
+	U32 getCellCount() const
+	{
+		return m_cells.getSize() - m_freeCells.getSize();
+	}
+
+private:
+	/// A placeable inside a cell. The entries of a cell are packed so the queries walk them linearly.
+	class CellEntry
+	{
+	public:
+		Aabb m_aabb;
+		void* m_userData;
+		U32 m_placeable;
+	};
+
+	class Cell
+	{
+	public:
+		SceneDynamicArray<CellEntry> m_entries;
+		Array<U32, 8> m_children;
+		U32 m_parent;
+		U32 m_subtreePlaceableCount; ///< The placeables of this cell and all its children.
+		Array<U16, 3> m_coords; ///< The coordinates of the cell in its depth.
+		U8 m_depth;
+		Aabb m_looseAabb;
+	};
+
+	SceneDynamicArray<Cell> m_cells; ///< The 1st is the root.
+	SceneDynamicArray<U32> m_freeCells;
+
+	// Placeables
+	SceneDynamicArray<U32> m_placeableCells; ///< kMaxU32 if not alive.
+	SceneDynamicArray<U32> m_placeableSlots; ///< The index in Cell::m_entries.
+	SceneDynamicArray<U32> m_freePlaceables;
+
+	Vec3 m_min = Vec3(0.0f);
+	F32 m_rootSize = 0.0f; ///< The size of the tight bounds of the root. The root is a cube.
+	U32 m_maxDepth = 0;
+
+	SpinLock m_mtx;
+
+	Bool isAlive(U32 placeable) const
+	{
+		return placeable < m_placeableCells.getSize() && m_placeableCells[placeable] != kMaxU32;
+	}
+
+	/// Find the depth and coordinates of the cell that should hold an AABB.
+	void computeTargetCell(const Aabb& aabb, U32& depth, Array<U32, 3>& coords) const;
+
+	/// Get the cell of some depth and coordinates, create it and its parents if needed.
+	U32 getOrCreateCell(U32 depth, const Array<U32, 3>& coords);
+
+	U32 newCell(U32 parent, U32 depth, const Array<U32, 3>& coords);
+
+	void linkPlaceable(U32 placeable, U32 cell, const Aabb& aabb, void* userData);
+
+	/// Remove from its cell and release the cells that got empty.
+	/// @return The user data of the placeable.
+	void* unlinkPlaceable(U32 placeable);
+
+	/// Gather all placeables of a sub-tree without testing them.
+	void gatherSubtree(U32 cell, OctreeGatherArray& out) const;
+
+	/// Walk a sub-tree and gather the placeables inside the planes.
+	/// @param taskDepth If a cell of that depth is visited it won't be walked but it will be added to taskCells.
+	void gatherVisibleInternal(U32 cell, ConstWeakArray<Plane> planes, OctreeGatherArray& out, U32 taskDepth = kMaxU32,
+							   DynamicArray<U32, MemoryPoolPtrWrapper<StackMemoryPool>>* taskCells = nullptr) const;
+
+	template<typename TShape>
+	void gatherOverlappingInternal(U32 cell, const TShape& shape, OctreeGatherArray& out) const;
+};
+/// @}
+
+} // end namespace anki
@@ -26,6 +26,7 @@
 #include <AnKi/Scene/Components/LightComponent.h>
 #include <AnKi/Scene/Components/ModelComponent.h>
 #include <AnKi/Scene/Components/MoveComponent.h>
+#include <AnKi/Scene/Components/OccluderComponent.h>
 #include <AnKi/Scene/Components/ParticleEmitterComponent.h>
 #include <AnKi/Scene/Components/PlayerControllerComponent.h>
 #include <AnKi/Scene/Components/ReflectionProbeComponent.h>
@@ -39,10 +40,13 @@ namespace anki {
 
 static StatCounter g_sceneUpdateTimeStatVar(StatCategory::kTime, "All scene update",
 											StatFlag::kMilisecond | StatFlag::kShowAverage | StatFlag::kMainThreadUpdates);
+static StatCounter g_sceneNodesUpdatedStatVar(StatCategory::kMisc, "Scene nodes updated", StatFlag::kMainThreadUpdates);
 static StatCounter g_scenePhysicsTimeStatVar(StatCategory::kTime, "Physics",
 											 StatFlag::kMilisecond | StatFlag::kShowAverage | StatFlag::kMainThreadUpdates);
 
 static NumericCVar<U32> g_octreeMaxDepthCVar(CVarSubsystem::kScene, "OctreeMaxDepth", 5, 2, 10, "The max depth of the octree");
+static NumericCVar<F32> g_octreeSizeCVar(CVarSubsystem::kScene, "OctreeSize", 2048.0f, 16.0f, kMaxF32,
+										 "The size of the area the octree covers. It's centered at the origin");
 
 NumericCVar<F32> g_probeEffectiveDistanceCVar(CVarSubsystem::kScene, "ProbeEffectiveDistance", 256.0f, 1.0f, kMaxF32,
 											  "How far various probes can render");
@@ -70,15 +74,27 @@ static NumericCVar<U32> g_minGpuSceneRenderablesCVar(CVarSubsystem::kScene, "Min
 													 "The min number of renderables stored in the GPU scene");
 
 constexpr U32 kUpdateNodeBatchSize = 10;
+constexpr U32 kDeleteNodeBatchSize = 64;
+constexpr U32 kStreamedTexturesBatchSize = 64;
+
+class SceneGraph::UpdateSetEntry
+{
+public:
+	SceneNode* m_node;
+	U32 m_depth; ///< Depth in the hierarchy.
+	Bool m_componentUpdated = false;
+};
 
 class SceneGraph::UpdateSceneNodesCtx
 {
 public:
-	IntrusiveList<SceneNode>::Iterator m_crntNode;
-	SpinLock m_crntNodeLock;
+	WeakArray<UpdateSetEntry> m_nodes; ///< Nodes of the same depth.
+	Atomic<U32> m_crntNode = {0};
 
 	Second m_prevUpdateTime;
 	Second m_crntTime;
+
+	Bool m_afterTransformUpdate; ///< Update the components that run before or after the world transform update.
 };
 
 SceneGraph::SceneGraph()
@@ -94,6 +110,8 @@ SceneGraph::~SceneGraph()
 
 	deleteNodesMarkedForDeletion();
 
+	TransformHierarchy::freeSingleton();
+
 #define ANKI_CAT_TYPE(arrayName, gpuSceneType, id, cvarName) GpuSceneArrays::arrayName::freeSingleton();
 #include <AnKi/Scene/GpuSceneArrays.def.h>
 
@@ -106,6 +124,11 @@ Error SceneGraph::init(AllocAlignedCallback allocCallback, void* allocCallbackDa
 
 	m_framePool.init(allocCallback, allocCallbackData, 1_MB, 2.0, 0, true, ANKI_SAFE_ALIGNMENT, "SceneGraphFramePool");
 
+	TransformHierarchy::allocateSingleton();
+
+	const F32 octreeHalfSize = g_octreeSizeCVar.get() / 2.0f;
+	m_octree.init(Vec3(-octreeHalfSize), Vec3(octreeHalfSize), g_octreeMaxDepthCVar.get());
+
 	// Init the default main camera
 	ANKI_CHECK(newSceneNode<SceneNode>("mainCamera", m_defaultMainCam));
 	CameraComponent* camc = m_defaultMainCam->newComponent<CameraComponent>();
@@ -151,6 +174,9 @@ Error SceneGraph::registerNode(SceneNode* node)
 	m_nodes.pushBack(node);
 	++m_nodesCount;
 
+	// Every node gets at least one update
+	node->markForUpdate();
+
 	return Error::kNone;
 }
 
@@ -189,30 +215,60 @@ SceneNode* SceneGraph::tryFindSceneNode(const CString& name)
 
 void SceneGraph::deleteNodesMarkedForDeletion()
 {
-	/// Delete all nodes pending deletion. At this point all scene threads
-	/// should have finished their tasks
-	while(m_objectsMarkedForDeletionCount.load() > 0)
+	// Delete all nodes pending deletion. At this point all scene threads should have finished their tasks
+	SceneNode* head = m_nodesPendingDeletion.exchange(nullptr, AtomicMemoryOrder::kAcquire);
+	if(head == nullptr)
 	{
-		[[maybe_unused]] Bool found = false;
-		auto it = m_nodes.begin();
-		auto end = m_nodes.end();
-		for(; it != end; ++it)
-		{
-			SceneNode& node = *it;
+		ANKI_ASSERT(m_objectsMarkedForDeletionCount.load() == 0);
+		return;
+	}
 
-			if(node.getMarkedForDeletion())
-			{
-				// Delete node
-				unregisterNode(&node);
-				deleteInstance(SceneMemoryPool::getSingleton(), &node);
-				m_objectsMarkedForDeletionCount.fetchSub(1);
-				found = true;
-				break;
-			}
+	ANKI_TRACE_SCOPED_EVENT(SceneNodesDelete);
+
+	DynamicArray<SceneNode*, MemoryPoolPtrWrapper<StackMemoryPool>> nodes(&m_framePool);
+	for(SceneNode* node = head; node; node = node->m_nextPendingDeletion)
+	{
+		nodes.emplaceBack(node);
+	}
+
+	// Remove them from the scene. It's not thread-safe since it touches the component arrays, the hierarchy and others
+	for(SceneNode* node : nodes)
+	{
+		unregisterNode(node);
+		node->detachFromScene();
+	}
+
+	// What's left is the destructors of the nodes and freeing memory. Go wide if there are many
+	if(nodes.getSize() <= kDeleteNodeBatchSize)
+	{
+		for(SceneNode* node : nodes)
+		{
+			deleteInstance(SceneMemoryPool::getSingleton(), node);
+		}
+	}
+	else
+	{
+		const U32 batchCount = (nodes.getSize() + kDeleteNodeBatchSize - 1) / kDeleteNodeBatchSize;
+		ThreadJobCounter counter;
+		for(U32 batch = 0; batch < batchCount; ++batch)
+		{
+			const WeakArray<SceneNode*> batchNodes(&nodes[batch * kDeleteNodeBatchSize],
+												   min(kDeleteNodeBatchSize, nodes.getSize() - batch * kDeleteNodeBatchSize));
+			CoreThreadJobManager::getSingleton().dispatchTask(
+				[batchNodes]([[maybe_unused]] U32 tid) {
+					for(SceneNode* node : batchNodes)
+					{
+						deleteInstance(SceneMemoryPool::getSingleton(), node);
+					}
+				},
+				&counter);
 		}
 
-		ANKI_ASSERT(found && "Something is wrong with marked for deletion");
+		CoreThreadJobManager::getSingleton().waitForCounter(counter);
 	}
+
+	ANKI_ASSERT(m_objectsMarkedForDeletionCount.load() >= nodes.getSize());
+	m_objectsMarkedForDeletionCount.fetchSub(nodes.getSize());
 }
 
 Error SceneGraph::update(Second prevUpdateTime, Second crntTime)
@@ -243,26 +299,26 @@ Error SceneGraph::update(Second prevUpdateTime, Second crntTime)
 		g_scenePhysicsTimeStatVar.set((HighRezTimer::getCurrentTime() - physicsUpdate) * 1000.0);
 	}
 
+	updateStreamedTextures();
+
 	{
 		ANKI_TRACE_SCOPED_EVENT(SceneNodesUpdate);
 		ANKI_CHECK(m_events.updateAllEvents(prevUpdateTime, crntTime));
+		ANKI_CHECK(updateNodes(prevUpdateTime, crntTime));
+	}
 
-		UpdateSceneNodesCtx updateCtx;
-		updateCtx.m_crntNode = m_nodes.getBegin();
-		updateCtx.m_prevUpdateTime = prevUpdateTime;
-		updateCtx.m_crntTime = crntTime;
+	// Gather what the camera sees. The occlusion culling and the texture streaming work on that
+	{
+		const Frustum& frustum = getActiveCameraNode().getFirstComponentOfType<CameraComponent>().getFrustum();
 
-		for(U i = 0; i < CoreThreadJobManager::getSingleton().getThreadCount(); i++)
+		OctreeGatherArray visibleComponents(&m_framePool);
 		{
-			CoreThreadJobManager::getSingleton().dispatchTask([this, &updateCtx]([[maybe_unused]] U32 tid) {
-				if(updateNodes(updateCtx))
-				{
-					ANKI_SCENE_LOGF("Will not recover");
-				}
-			});
+			ANKI_TRACE_SCOPED_EVENT(SceneVisibility);
+			m_octree.gatherVisible(ConstWeakArray<Plane>(frustum.getViewPlanes()), visibleComponents, &CoreThreadJobManager::getSingleton());
 		}
 
-		CoreThreadJobManager::getSingleton().waitForAllTasksToFinish();
+		m_occlusionCuller.cull(frustum, ConstWeakArray<void*>(visibleComponents));
+		requestStreamedTextureMips(ConstWeakArray<void*>(visibleComponents));
 	}
 
 #define ANKI_CAT_TYPE(arrayName, gpuSceneType, id, cvarName) GpuSceneArrays::arrayName::getSingleton().flush();
@@ -272,23 +328,293 @@ Error SceneGraph::update(Second prevUpdateTime, Second crntTime)
 	return Error::kNone;
 }
 
-Error SceneGraph::updateNode(Second prevTime, Second crntTime, SceneNode& node)
+void SceneGraph::updateStreamedTextures()
 {
-	ANKI_TRACE_INC_COUNTER(SceneNodeUpdated, 1);
+	if(!ResourceManager::getSingleton().getTextureStreamingEnabled())
+	{
+		return;
+	}
+
+	const U64 epoch = ResourceManager::getSingleton().getTextureStreamingEpoch();
+	if(epoch == m_textureStreamingEpoch)
+	{
+		// Nothing got streamed since the last time
+		return;
+	}
+
+	m_textureStreamingEpoch = epoch;
+
+	ANKI_TRACE_SCOPED_EVENT(SceneTextureStreaming);
+
+	// All models need to be checked since the ones the camera doesn't see might still be rendered (eg in the shadows)
+	DynamicArray<ModelComponent*, MemoryPoolPtrWrapper<StackMemoryPool>> models(&m_framePool);
+	models.resizeStorage(m_componentArrays.getModels().getSize());
+	for(ModelComponent& comp : m_componentArrays.getModels())
+	{
+		models.emplaceBack(&comp);
+	}
+
+	const U32 batchCount = (models.getSize() + kStreamedTexturesBatchSize - 1) / kStreamedTexturesBatchSize;
+	ThreadJobCounter counter;
+	for(U32 batch = 0; batch < batchCount; ++batch)
+	{
+		const WeakArray<ModelComponent*> batchModels(&models[batch * kStreamedTexturesBatchSize],
+													 min(kStreamedTexturesBatchSize, models.getSize() - batch * kStreamedTexturesBatchSize));
+		CoreThreadJobManager::getSingleton().dispatchTask(
+			[batchModels]([[maybe_unused]] U32 tid) {
+				for(ModelComponent* comp : batchModels)
+				{
+					comp->updateStreamedTextures();
+				}
+			},
+			&counter);
+	}
+
+	CoreThreadJobManager::getSingleton().waitForCounter(counter);
+}
+
+void SceneGraph::requestStreamedTextureMips(ConstWeakArray<void*> visibleComponents)
+{
+	if(!ResourceManager::getSingleton().getTextureStreamingEnabled())
+	{
+		return;
+	}
+
+	ANKI_TRACE_SCOPED_EVENT(SceneTextureStreaming);
+
+	const SceneNode& camNode = getActiveCameraNode();
+	const CameraComponent& cam = camNode.getFirstComponentOfType<CameraComponent>();
+	m_streamingCameraPos = camNode.getWorldTransform().getOrigin().xyz();
+	m_streamingPixelsPerUnit = F32(g_windowHeightCVar.get()) / (2.0f * tan(cam.getFovY() / 2.0f));
+
+	for(void* userData : visibleComponents)
+	{
+		const SceneComponent* comp = static_cast<const SceneComponent*>(userData);
+		if(comp->getType() == SceneComponentType::kModel)
+		{
+			static_cast<const ModelComponent*>(comp)->requestStreamedTextureMips();
+		}
+	}
+}
+
+F32 SceneGraph::estimateScreenSize(const Aabb& aabb) const
+{
+	const Vec3 aabbMin = aabb.getMin().xyz();
+	const Vec3 aabbMax = aabb.getMax().xyz();
+	const Vec3 closestPoint = m_streamingCameraPos.max(aabbMin).min(aabbMax);
+	const F32 distance = max((closestPoint - m_streamingCameraPos).getLength(), kEpsilonf);
+	return (aabbMax - aabbMin).getLength() * m_streamingPixelsPerUnit / distance;
+}
+
+void SceneGraph::addToUpdateSet(SceneNode& node)
+{
+	LockGuard lock(m_updateSetLock);
+	if(node.m_updateSetIndex == kMaxU32)
+	{
+		node.m_updateSetIndex = m_updateSet.getSize();
+		m_updateSet.emplaceBack(&node);
+	}
+}
+
+void SceneGraph::removeFromUpdateSet(SceneNode& node)
+{
+	LockGuard lock(m_updateSetLock);
+	if(node.m_updateSetIndex != kMaxU32)
+	{
+		ANKI_ASSERT(m_updateSet[node.m_updateSetIndex] == &node);
+
+		// Swap with the last
+		SceneNode* last = m_updateSet.getBack();
+		m_updateSet[node.m_updateSetIndex] = last;
+		last->m_updateSetIndex = node.m_updateSetIndex;
+		m_updateSet.popBack();
+
+		node.m_updateSetIndex = kMaxU32;
+	}
+}
+
+Bool SceneGraph::fetchUpdateSet(DynamicArray<UpdateSetEntry, MemoryPoolPtrWrapper<StackMemoryPool>>& nodes)
+{
+	LockGuard lock(m_updateSetLock);
+
+	const U32 prevNodeCount = nodes.getSize();
+	U32 remainingCount = 0;
+	for(SceneNode* node : m_updateSet)
+	{
+		if(node->m_lastUpdateTimestamp == m_updateTimestamp)
+		{
+			// Already updated in this update(), it will be updated again in the next one
+			node->m_updateSetIndex = remainingCount;
+			m_updateSet[remainingCount++] = node;
+		}
+		else
+		{
+			node->m_updateSetIndex = kMaxU32;
+
+			U32 depth = 0;
+			for(const SceneNode* parent = node->getParent(); parent; parent = parent->getParent())
+			{
+				++depth;
+			}
+
+			nodes.emplaceBack(UpdateSetEntry{node, depth, false});
+		}
+	}
+
+	m_updateSet.resize(remainingCount);
+
+	return nodes.getSize() > prevNodeCount;
+}
+
+Error SceneGraph::updateNodes(Second prevUpdateTime, Second crntTime)
+{
+	++m_updateTimestamp;
+
+	DynamicArray<UpdateSetEntry, MemoryPoolPtrWrapper<StackMemoryPool>> nodes(&m_framePool);
+	Bool newNodes = fetchUpdateSet(nodes);
+	U32 levelBegin = 0;
+
+	// Update the nodes level by level because children depend on the transform of their parents. When a node moves it marks its
+	// children for update so fetch the new nodes after every level
+	while(true)
+	{
+		if(newNodes)
+		{
+			// Sort what's not updated by depth and remove duplicates
+			std::sort(nodes.getBegin() + levelBegin, nodes.getEnd(), [](const UpdateSetEntry& a, const UpdateSetEntry& b) {
+				return (a.m_depth != b.m_depth) ? a.m_depth < b.m_depth : a.m_node < b.m_node;
+			});
+
+			auto newEnd = std::unique(nodes.getBegin() + levelBegin, nodes.getEnd(), [](const UpdateSetEntry& a, const UpdateSetEntry& b) {
+				return a.m_node == b.m_node;
+			});
+			nodes.resize(U32(newEnd - nodes.getBegin()));
+		}
 
+		if(levelBegin == nodes.getSize())
+		{
+			break;
+		}
+
+		U32 levelEnd = levelBegin + 1;
+		while(levelEnd < nodes.getSize() && nodes[levelEnd].m_depth == nodes[levelBegin].m_depth)
+		{
+			++levelEnd;
+		}
+
+		const WeakArray<UpdateSetEntry> levelNodes(&nodes[levelBegin], levelEnd - levelBegin);
+
+		// First the components that move the nodes (scripts, physics etc)
+		ANKI_CHECK(updateNodesOfSameDepth(levelNodes, false, prevUpdateTime, crntTime));
+
+		// Then the world transforms of the whole level in one go
+		{
+			DynamicArray<U32, MemoryPoolPtrWrapper<StackMemoryPool>> transformIndices(&m_framePool);
+			transformIndices.resize(levelNodes.getSize());
+			for(U32 i = 0; i < levelNodes.getSize(); ++i)
+			{
+				transformIndices[i] = levelNodes[i].m_node->getTransformIndex();
+			}
+
+			TransformHierarchy::getSingleton().updateWorldTransforms(transformIndices, &CoreThreadJobManager::getSingleton());
+		}
+
+		// And the rest of the components that depend on the world transforms
+		ANKI_CHECK(updateNodesOfSameDepth(levelNodes, true, prevUpdateTime, crntTime));
+
+		levelBegin = levelEnd;
+		newNodes = fetchUpdateSet(nodes);
+	}
+
+	g_sceneNodesUpdatedStatVar.set(nodes.getSize());
+
+	return Error::kNone;
+}
+
+Error SceneGraph::updateNodesOfSameDepth(WeakArray<UpdateSetEntry> nodes, Bool afterTransformUpdate, Second prevUpdateTime, Second crntTime)
+{
+	UpdateSceneNodesCtx ctx;
+	ctx.m_nodes = nodes;
+	ctx.m_prevUpdateTime = prevUpdateTime;
+	ctx.m_crntTime = crntTime;
+	ctx.m_afterTransformUpdate = afterTransformUpdate;
+
+	if(nodes.getSize() <= kUpdateNodeBatchSize)
+	{
+		// Not worth it to go wide
+		return updateNodesOfSameDepthTask(ctx);
+	}
+
+	const U32 taskCount =
+		min(CoreThreadJobManager::getSingleton().getThreadCount(), (nodes.getSize() + kUpdateNodeBatchSize - 1) / kUpdateNodeBatchSize);
+	for(U32 i = 0; i < taskCount; i++)
+	{
+		CoreThreadJobManager::getSingleton().dispatchTask([this, &ctx]([[maybe_unused]] U32 tid) {
+			if(updateNodesOfSameDepthTask(ctx))
+			{
+				ANKI_SCENE_LOGF("Will not recover");
+			}
+		});
+	}
+
+	CoreThreadJobManager::getSingleton().waitForAllTasksToFinish();
+
+	return Error::kNone;
+}
+
+Error SceneGraph::updateNodesOfSameDepthTask(UpdateSceneNodesCtx& ctx)
+{
+	ANKI_TRACE_SCOPED_EVENT(SceneNodeUpdate);
+
+	Error err = Error::kNone;
+	while(!err)
+	{
+		const U32 begin = ctx.m_crntNode.fetchAdd(kUpdateNodeBatchSize);
+		if(begin >= ctx.m_nodes.getSize())
+		{
+			break;
+		}
+
+		const U32 end = min(begin + kUpdateNodeBatchSize, ctx.m_nodes.getSize());
+		for(U32 i = begin; i < end && !err; ++i)
+		{
+			if(ctx.m_afterTransformUpdate)
+			{
+				err = updateNodeAfterTransformUpdate(ctx.m_prevUpdateTime, ctx.m_crntTime, ctx.m_nodes[i]);
+			}
+			else
+			{
+				err = updateNodeBeforeTransformUpdate(ctx.m_prevUpdateTime, ctx.m_crntTime, ctx.m_nodes[i]);
+			}
+		}
+	}
+
+	return err;
+}
+
+Error SceneGraph::updateNodeComponents(Second prevTime, Second crntTime, Bool afterTransformUpdate, UpdateSetEntry& entry)
+{
+	SceneNode& node = *entry.m_node;
 	Error err = Error::kNone;
 
-	// Components update
 	SceneComponentUpdateInfo componentUpdateInfo(prevTime, crntTime);
 	componentUpdateInfo.m_framePool = &m_framePool;
 
-	Bool atLeastOneComponentUpdated = false;
+	// The components are sorted by weight. The ones that come before the MoveComponent can change the local transform
+	const F32 moveWeight = SceneComponent::getUpdateOrderWeight(SceneComponentType::kMove);
+
 	node.iterateComponents([&](SceneComponent& comp) {
 		if(err)
 		{
 			return;
 		}
 
+		const Bool afterMove = SceneComponent::getUpdateOrderWeight(comp.getType()) >= moveWeight;
+		if(afterMove != afterTransformUpdate)
+		{
+			return;
+		}
+
 		componentUpdateInfo.m_node = &node;
 		Bool updated = false;
 		err = comp.update(componentUpdateInfo, updated);
@@ -297,22 +623,33 @@ Error SceneGraph::updateNode(Second prevTime, Second crntTime, SceneNode& node)
 		{
 			ANKI_TRACE_INC_COUNTER(SceneComponentUpdated, 1);
 			comp.setTimestamp(GlobalFrameIndex::getSingleton().m_value);
-			atLeastOneComponentUpdated = true;
+			entry.m_componentUpdated = true;
 		}
 	});
 
-	// Update children
-	if(!err)
-	{
-		err = node.visitChildrenMaxDepth(0, [&](SceneNode& child) -> Error {
-			return updateNode(prevTime, crntTime, child);
-		});
-	}
+	return err;
+}
+
+Error SceneGraph::updateNodeBeforeTransformUpdate(Second prevTime, Second crntTime, UpdateSetEntry& entry)
+{
+	ANKI_TRACE_INC_COUNTER(SceneNodeUpdated, 1);
+
+	// Set it before the components update so if they mark the node again it will be updated in the next update()
+	entry.m_node->m_lastUpdateTimestamp = m_updateTimestamp;
+
+	return updateNodeComponents(prevTime, crntTime, false, entry);
+}
+
+Error SceneGraph::updateNodeAfterTransformUpdate(Second prevTime, Second crntTime, UpdateSetEntry& entry)
+{
+	SceneNode& node = *entry.m_node;
+
+	Error err = updateNodeComponents(prevTime, crntTime, true, entry);
 
 	// Frame update
 	if(!err)
 	{
-		if(atLeastOneComponentUpdated)
+		if(entry.m_componentUpdated)
 		{
 			node.setComponentMaxTimestamp(GlobalFrameIndex::getSingleton().m_value);
 		}
@@ -324,54 +661,21 @@ Error SceneGraph::updateNode(Second prevTime, Second crntTime, SceneNode& node)
 		err = node.frameUpdate(prevTime, crntTime);
 	}
 
-	return err;
-}
-
-Error SceneGraph::updateNodes(UpdateSceneNodesCtx& ctx)
-{
-	ANKI_TRACE_SCOPED_EVENT(SceneNodeUpdate);
-
-	IntrusiveList<SceneNode>::ConstIterator end = m_nodes.getEnd();
-
-	Bool quit = false;
-	Error err = Error::kNone;
-	while(!quit && !err)
+	// The children need to recompute their world transforms. Don't walk the whole tree because the children will mark their own
+	// children when they get updated
+	if(!err && node.movedThisFrame())
 	{
-		// Fetch a batch of scene nodes that don't have parent
-		Array<SceneNode*, kUpdateNodeBatchSize> batch;
-		U batchSize = 0;
-
-		{
-			LockGuard<SpinLock> lock(ctx.m_crntNodeLock);
-
-			while(1)
-			{
-				if(batchSize == batch.getSize())
-				{
-					break;
-				}
-
-				if(ctx.m_crntNode == end)
-				{
-					quit = true;
-					break;
-				}
-
-				SceneNode& node = *ctx.m_crntNode;
-				if(node.getParent() == nullptr)
-				{
-					batch[batchSize++] = &node;
-				}
-
-				++ctx.m_crntNode;
-			}
-		}
+		[[maybe_unused]] const Error err2 = node.visitChildrenMaxDepth(1, [](SceneNode& childNode) -> Error {
+			childNode.markForUpdate();
+			return Error::kNone;
+		});
+	}
 
-		// Process nodes
-		for(U i = 0; i < batchSize && !err; ++i)
-		{
-			err = updateNode(ctx.m_prevUpdateTime, ctx.m_crntTime, *batch[i]);
-		}
+	// Keep the node in the update set while it changes. Many components compare against the previous frame (eg if it moved in the
+	// previous frame) so they need one more update to settle
+	if(!err && (entry.m_componentUpdated || node.movedThisFrame() || node.getUpdateEveryFrame()))
+	{
+		node.markForUpdate();
 	}
 
 	return err;
@@ -7,6 +7,8 @@
 
 #include <AnKi/Scene/Common.h>
 #include <AnKi/Scene/SceneNode.h>
+#include <AnKi/Scene/Octree.h>
+#include <AnKi/Scene/OcclusionCuller.h>
 #include <AnKi/Math.h>
 #include <AnKi/Util/HashMap.h>
 #include <AnKi/Util/BlockArray.h>
@@ -125,8 +127,17 @@ public:
 		node->setMarkedForDeletion();
 	}
 
-	void increaseObjectsMarkedForDeletion()
+	/// Push a node to the list of nodes pending deletion.
+	/// @note It's thread-safe.
+	void addNodeMarkedForDeletion(SceneNode& node)
 	{
+		ANKI_ASSERT(node.getMarkedForDeletion() && node.m_nextPendingDeletion == nullptr);
+		SceneNode* head = m_nodesPendingDeletion.load();
+		do
+		{
+			node.m_nextPendingDeletion = head;
+		} while(!m_nodesPendingDeletion.compareExchange(head, &node, AtomicMemoryOrder::kRelease, AtomicMemoryOrder::kRelaxed));
+
 		m_objectsMarkedForDeletionCount.fetchAdd(1);
 	}
 
@@ -152,6 +163,23 @@ public:
 		return m_componentArrays;
 	}
 
+	/// The spatial index of the bounds of the components.
+	Octree& getOctree()
+	{
+		return m_octree;
+	}
+
+	const Octree& getOctree() const
+	{
+		return m_octree;
+	}
+
+	/// The CPU occlusion culling of the active camera. Its results are valid after update().
+	const OcclusionCuller& getOcclusionCuller() const
+	{
+		return m_occlusionCuller;
+	}
+
 	void addDirectionalLight(LightComponent* comp)
 	{
 		ANKI_ASSERT(m_dirLights.find(comp) == m_dirLights.getEnd());
@@ -209,8 +237,13 @@ public:
 		return {m_sceneMin, m_sceneMax};
 	}
 
+	/// Estimate the size in pixels that a box covers on the screen. The texture streaming uses it to decide the mips of the textures.
+	/// @note It's thread-safe.
+	F32 estimateScreenSize(const Aabb& aabb) const;
+
 private:
 	class UpdateSceneNodesCtx;
+	class UpdateSetEntry;
 
 	class InitMemPoolDummy
 	{
@@ -238,14 +271,31 @@ private:
 	mutable SpinLock m_sceneBoundsMtx;
 
 	Atomic<U32> m_objectsMarkedForDeletionCount = {0};
+	Atomic<SceneNode*> m_nodesPendingDeletion = {nullptr}; ///< Lock-free list of the nodes marked for deletion.
 
 	Atomic<U32> m_nodesUuid = {1};
 
 	SceneComponentArrays m_componentArrays;
 
+	Octree m_octree;
+
+	OcclusionCuller m_occlusionCuller;
+
 	SceneDynamicArray<LightComponent*> m_dirLights;
 	SceneDynamicArray<SkyboxComponent*> m_skyboxes;
 
+	/// The nodes that will be updated in the next update(). Static nodes don't end up here so they cost nothing.
+	SceneDynamicArray<SceneNode*> m_updateSet;
+	SpinLock m_updateSetLock;
+	Timestamp m_updateTimestamp = 0; ///< Increases in every update().
+
+	/// @name Texture streaming
+	/// @{
+	Vec3 m_streamingCameraPos = Vec3(0.0f);
+	F32 m_streamingPixelsPerUnit = 0.0f; ///< The pixels an object of unit size covers at unit distance from the camera.
+	U64 m_textureStreamingEpoch = 0;
+	/// @}
+
 	SceneGraph();
 
 	~SceneGraph();
@@ -257,8 +307,30 @@ private:
 	/// Delete the nodes that are marked for deletion
 	void deleteNodesMarkedForDeletion();
 
-	Error updateNodes(UpdateSceneNodesCtx& ctx);
-	Error updateNode(Second prevTime, Second crntTime, SceneNode& node);
+	/// Refresh the models whose textures got streamed in or out. The models are walked (in parallel) only in the frames that some texture
+	/// got streamed.
+	void updateStreamedTextures();
+
+	/// Request the mips of the textures of the models the camera sees. The textures of the rest of the models will be evicted after a while.
+	void requestStreamedTextureMips(ConstWeakArray<void*> visibleComponents);
+
+	/// @note It's thread-safe.
+	void addToUpdateSet(SceneNode& node);
+
+	/// @note It's thread-safe.
+	void removeFromUpdateSet(SceneNode& node);
+
+	/// Move the nodes of the update set to an array. Nodes that have already been updated in this update() stay in the set.
+	Bool fetchUpdateSet(DynamicArray<UpdateSetEntry, MemoryPoolPtrWrapper<StackMemoryPool>>& nodes);
+
+	/// Update the nodes of the update set one level of the hierarchy at a time. Every level is updated in 3 steps: The components that
+	/// change the local transforms, the world transforms of the whole level (see TransformHierarchy) and the rest of the components.
+	Error updateNodes(Second prevUpdateTime, Second crntTime);
+	Error updateNodesOfSameDepth(WeakArray<UpdateSetEntry> nodes, Bool afterTransformUpdate, Second prevUpdateTime, Second crntTime);
+	Error updateNodesOfSameDepthTask(UpdateSceneNodesCtx& ctx);
+	Error updateNodeComponents(Second prevTime, Second crntTime, Bool afterTransformUpdate, UpdateSetEntry& entry);
+	Error updateNodeBeforeTransformUpdate(Second prevTime, Second crntTime, UpdateSetEntry& entry);
+	Error updateNodeAfterTransformUpdate(Second prevTime, Second crntTime, UpdateSetEntry& entry);
 };
 
 template<typename Node, typename... Args>
@@ -18,6 +18,7 @@
 #include <AnKi/Scene/Components/LightComponent.h>
 #include <AnKi/Scene/Components/ModelComponent.h>
 #include <AnKi/Scene/Components/MoveComponent.h>
+#include <AnKi/Scene/Components/OccluderComponent.h>
 #include <AnKi/Scene/Components/ParticleEmitterComponent.h>
 #include <AnKi/Scene/Components/PlayerControllerComponent.h>
 #include <AnKi/Scene/Components/ReflectionProbeComponent.h>
@@ -49,12 +50,27 @@ SceneNode::SceneNode(CString name)
 		m_name = name;
 	}
 
+	m_transformIndex = TransformHierarchy::getSingleton().newTransform();
+
 	// Add the implicit MoveComponent
 	newComponent<MoveComponent>();
 }
 
 SceneNode::~SceneNode()
 {
+	detachFromScene();
+}
+
+void SceneNode::detachFromScene()
+{
+	if(m_transformIndex == kMaxU32)
+	{
+		// Already detached
+		return;
+	}
+
+	SceneGraph::getSingleton().removeFromUpdateSet(*this);
+
 	for(SceneComponent* comp : m_components)
 	{
 		comp->onDestroy(*this);
@@ -70,15 +86,30 @@ SceneNode::~SceneNode()
 			ANKI_ASSERT(0);
 		}
 	}
+
+	m_components.destroy();
+	m_componentTypeMask = SceneComponentTypeMask::kNone;
+
+	// The children will outlive this node for a while, detach their transforms
+	[[maybe_unused]] const Error err = visitChildrenMaxDepth(1, [](SceneNode& childNode) -> Error {
+		TransformHierarchy::getSingleton().setParent(childNode.m_transformIndex, kMaxU32);
+		return Error::kNone;
+	});
+
+	TransformHierarchy::getSingleton().deleteTransform(m_transformIndex);
+	m_transformIndex = kMaxU32;
+
+	// Detach from the parent and the children
+	Base::destroy();
 }
 
 void SceneNode::setMarkedForDeletion()
 {
-	// Mark for deletion only when it's not already marked because we don't want to increase the counter again
+	// Mark for deletion only when it's not already marked because we don't want to add it to the pending list twice
 	if(!getMarkedForDeletion())
 	{
 		m_markedForDeletion = true;
-		SceneGraph::getSingleton().increaseObjectsMarkedForDeletion();
+		SceneGraph::getSingleton().addNodeMarkedForDeletion(*this);
 	}
 
 	[[maybe_unused]] const Error err = visitChildren([](SceneNode& obj) -> Error {
@@ -87,6 +118,11 @@ void SceneNode::setMarkedForDeletion()
 	});
 }
 
+void SceneNode::markForUpdate()
+{
+	SceneGraph::getSingleton().addToUpdateSet(*this);
+}
+
 void SceneNode::newComponentInternal(SceneComponent* newc)
 {
 	m_componentTypeMask |= 1 << SceneComponentTypeMask(newc->getType());
@@ -118,42 +154,62 @@ void SceneNode::newComponentInternal(SceneComponent* newc)
 			return a->getType() < b->getType();
 		}
 	});
+
+	// The new component needs at least one update
+	markForUpdate();
+}
+
+SceneComponent::~SceneComponent()
+{
+	deleteOctreePlaceable();
 }
 
-Bool SceneNode::updateTransform()
+void SceneComponent::markForUpdate()
 {
-	const Bool needsUpdate = m_localTransformDirty;
-	m_localTransformDirty = false;
-	const Bool updatedLastFrame = m_transformUpdatedThisFrame;
-	m_transformUpdatedThisFrame = needsUpdate;
+	m_ownerNode->markForUpdate();
+}
 
-	if(needsUpdate || updatedLastFrame)
+void SceneComponent::setUpdateEveryFrame(Bool updateEveryFrame)
+{
+	if(updateEveryFrame == m_updateEveryFrame)
 	{
-		m_prevWTrf = m_wtrf;
+		return;
 	}
 
-	// Update world transform
-	if(needsUpdate)
+	m_updateEveryFrame = updateEveryFrame;
+	if(updateEveryFrame)
+	{
+		++m_ownerNode->m_updateEveryFrameComponentCount;
+	}
+	else
 	{
-		const SceneNode* parent = getParent();
+		ANKI_ASSERT(m_ownerNode->m_updateEveryFrameComponentCount > 0);
+		--m_ownerNode->m_updateEveryFrameComponentCount;
+	}
 
-		if(parent == nullptr || m_ignoreParentNodeTransform)
-		{
-			m_wtrf = m_ltrf;
-		}
-		else
-		{
-			m_wtrf = parent->getWorldTransform().combineTransformations(m_ltrf);
-		}
+	m_ownerNode->markForUpdate();
+}
 
-		// Make children dirty as well. Don't walk the whole tree because you will re-walk it later
-		[[maybe_unused]] const Error err = visitChildrenMaxDepth(1, [](SceneNode& childNode) -> Error {
-			childNode.m_localTransformDirty = true;
-			return Error::kNone;
-		});
+void SceneComponent::updateOctreePlaceable(const Aabb& aabbWorld)
+{
+	Octree& octree = SceneGraph::getSingleton().getOctree();
+	if(m_octreePlaceable == kMaxU32) [[unlikely]]
+	{
+		m_octreePlaceable = octree.newPlaceable(aabbWorld, this);
+	}
+	else
+	{
+		octree.updatePlaceable(m_octreePlaceable, aabbWorld);
 	}
+}
 
-	return needsUpdate;
+void SceneComponent::deleteOctreePlaceable()
+{
+	if(m_octreePlaceable != kMaxU32)
+	{
+		SceneGraph::getSingleton().getOctree().deletePlaceable(m_octreePlaceable);
+		m_octreePlaceable = kMaxU32;
+	}
 }
 
 } // end namespace anki
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <AnKi/Scene/Components/SceneComponent.h>
+#include <AnKi/Scene/TransformHierarchy.h>
 #include <AnKi/Util/Hierarchy.h>
 #include <AnKi/Util/BitMask.h>
 #include <AnKi/Util/BitSet.h>
@@ -21,6 +22,7 @@ namespace anki {
 class SceneNode : public SceneHierarchy<SceneNode>, public IntrusiveListEnabled<SceneNode>
 {
 	friend class SceneComponent;
+	friend class SceneGraph;
 
 public:
 	using Base = SceneHierarchy<SceneNode>;
@@ -30,7 +32,9 @@ public:
 	/// @param name The unique name of the node. If it's empty the the node is not searchable.
 	SceneNode(CString name);
 
-	/// Unregister node
+	/// Unregister node.
+	/// @note When many nodes get deleted at once the destructors may run on job threads (see
+	///       SceneGraph::deleteNodesMarkedForDeletion()). The components have already been destroyed by then.
 	virtual ~SceneNode();
 
 	/// A dummy init for those scene nodes that don't need it.
@@ -71,9 +75,36 @@ public:
 	void addChild(SceneNode* obj)
 	{
 		Base::addChild(obj);
+		TransformHierarchy::getSingleton().setParent(obj->m_transformIndex, m_transformIndex);
+		obj->markForUpdate();
 	}
 
-	/// This is called by the scenegraph every frame after all component updates. By default it does nothing.
+	void removeChild(SceneNode* obj)
+	{
+		Base::removeChild(obj);
+		TransformHierarchy::getSingleton().setParent(obj->m_transformIndex, kMaxU32);
+		obj->markForUpdate();
+	}
+
+	/// The SceneGraph updates only the nodes that changed. This will make sure that the node (its components and frameUpdate()) will
+	/// be updated in the next SceneGraph::update(). The transform setters and the components call it.
+	/// @note It's thread-safe.
+	void markForUpdate();
+
+	/// Update the node every frame even if nothing changed. Useful for nodes that do work in frameUpdate().
+	void setUpdateEveryFrame(Bool updateEveryFrame)
+	{
+		m_updateEveryFrame = updateEveryFrame;
+		markForUpdate();
+	}
+
+	Bool getUpdateEveryFrame() const
+	{
+		return m_updateEveryFrame || m_updateEveryFrameComponentCount > 0;
+	}
+
+	/// This is called by the scenegraph after all component updates. It's called only when the node is updated (see markForUpdate()
+	/// and setUpdateEveryFrame()). By default it does nothing.
 	/// @param prevUpdateTime Timestamp of the previous update
 	/// @param crntTime Timestamp of this update
 	virtual Error frameUpdate([[maybe_unused]] Second prevUpdateTime, [[maybe_unused]] Second crntTime)
@@ -253,117 +284,125 @@ public:
 	/// Ignore parent nodes's transform.
 	void setIgnoreParentTransform(Bool ignore)
 	{
-		m_ignoreParentNodeTransform = ignore;
+		TransformHierarchy::getSingleton().setIgnoreParentTransform(m_transformIndex, ignore);
+		markForUpdate();
 	}
 
 	const Transform& getLocalTransform() const
 	{
-		return m_ltrf;
+		return TransformHierarchy::getSingleton().getLocalTransform(m_transformIndex);
 	}
 
 	void setLocalTransform(const Transform& x)
 	{
-		m_ltrf = x;
-		m_localTransformDirty = true;
+		getLocalTransformForWrite() = x;
+		setLocalTransformDirty();
 	}
 
 	void setLocalOrigin(const Vec4& x)
 	{
-		m_ltrf.setOrigin(x);
-		m_localTransformDirty = true;
+		getLocalTransformForWrite().setOrigin(x);
+		setLocalTransformDirty();
 	}
 
 	const Vec4& getLocalOrigin() const
 	{
-		return m_ltrf.getOrigin();
+		return getLocalTransform().getOrigin();
 	}
 
 	void setLocalRotation(const Mat3x4& x)
 	{
-		m_ltrf.setRotation(x);
-		m_localTransformDirty = true;
+		getLocalTransformForWrite().setRotation(x);
+		setLocalTransformDirty();
 	}
 
 	const Mat3x4& getLocalRotation() const
 	{
-		return m_ltrf.getRotation();
+		return getLocalTransform().getRotation();
 	}
 
 	void setLocalScale(F32 x)
 	{
-		m_ltrf.setScale(x);
-		m_localTransformDirty = true;
+		getLocalTransformForWrite().setScale(x);
+		setLocalTransformDirty();
 	}
 
 	F32 getLocalScale() const
 	{
-		return m_ltrf.getScale();
+		return getLocalTransform().getScale();
 	}
 
 	const Transform& getWorldTransform() const
 	{
-		return m_wtrf;
+		return TransformHierarchy::getSingleton().getWorldTransform(m_transformIndex);
 	}
 
 	const Transform& getPreviousWorldTransform() const
 	{
-		return m_prevWTrf;
+		return TransformHierarchy::getSingleton().getPreviousWorldTransform(m_transformIndex);
 	}
 
 	/// @name Mess with the local transform
 	/// @{
 	void rotateLocalX(F32 angleRad)
 	{
-		m_ltrf.getRotation().rotateXAxis(angleRad);
-		m_localTransformDirty = true;
+		getLocalTransformForWrite().getRotation().rotateXAxis(angleRad);
+		setLocalTransformDirty();
 	}
 	void rotateLocalY(F32 angleRad)
 	{
-		m_ltrf.getRotation().rotateYAxis(angleRad);
-		m_localTransformDirty = true;
+		getLocalTransformForWrite().getRotation().rotateYAxis(angleRad);
+		setLocalTransformDirty();
 	}
 	void rotateLocalZ(F32 angleRad)
 	{
-		m_ltrf.getRotation().rotateZAxis(angleRad);
-		m_localTransformDirty = true;
+		getLocalTransformForWrite().getRotation().rotateZAxis(angleRad);
+		setLocalTransformDirty();
 	}
 	void moveLocalX(F32 distance)
 	{
-		Vec3 x_axis = m_ltrf.getRotation().getColumn(0);
-		m_ltrf.getOrigin() += Vec4(x_axis, 0.0) * distance;
-		m_localTransformDirty = true;
+		Transform& ltrf = getLocalTransformForWrite();
+		Vec3 x_axis = ltrf.getRotation().getColumn(0);
+		ltrf.getOrigin() += Vec4(x_axis, 0.0) * distance;
+		setLocalTransformDirty();
 	}
 	void moveLocalY(F32 distance)
 	{
-		Vec3 y_axis = m_ltrf.getRotation().getColumn(1);
-		m_ltrf.getOrigin() += Vec4(y_axis, 0.0) * distance;
-		m_localTransformDirty = true;
+		Transform& ltrf = getLocalTransformForWrite();
+		Vec3 y_axis = ltrf.getRotation().getColumn(1);
+		ltrf.getOrigin() += Vec4(y_axis, 0.0) * distance;
+		setLocalTransformDirty();
 	}
 	void moveLocalZ(F32 distance)
 	{
-		Vec3 z_axis = m_ltrf.getRotation().getColumn(2);
-		m_ltrf.getOrigin() += Vec4(z_axis, 0.0) * distance;
-		m_localTransformDirty = true;
+		Transform& ltrf = getLocalTransformForWrite();
+		Vec3 z_axis = ltrf.getRotation().getColumn(2);
+		ltrf.getOrigin() += Vec4(z_axis, 0.0) * distance;
+		setLocalTransformDirty();
 	}
 	void scale(F32 s)
 	{
-		m_ltrf.getScale() *= s;
-		m_localTransformDirty = true;
+		getLocalTransformForWrite().getScale() *= s;
+		setLocalTransformDirty();
 	}
 
 	void lookAtPoint(const Vec4& point)
 	{
-		m_ltrf.lookAt(point, Vec4(0.0f, 1.0f, 0.0f, 0.0f));
-		m_localTransformDirty = true;
+		getLocalTransformForWrite().lookAt(point, Vec4(0.0f, 1.0f, 0.0f, 0.0f));
+		setLocalTransformDirty();
 	}
 	/// @}
 
 	Bool movedThisFrame() const
 	{
-		return m_transformUpdatedThisFrame;
+		return TransformHierarchy::getSingleton().getWorldTransformUpdated(m_transformIndex);
 	}
 
-	ANKI_INTERNAL Bool updateTransform();
+	/// Index of the node's transform in the TransformHierarchy.
+	U32 getTransformIndex() const
+	{
+		return m_transformIndex;
+	}
 
 	/// Create and append a component to the components container. The SceneNode has the ownership.
 	template<typename TComponent>
@@ -379,22 +418,39 @@ private:
 
 	Timestamp m_maxComponentTimestamp = 0;
 
-	/// The transformation in local space.
-	Transform m_ltrf = Transform::getIdentity();
-
-	/// The transformation in world space (local combined with parent's transformation).
-	Transform m_wtrf = Transform::getIdentity();
+	/// @name Updated by the SceneGraph
+	/// @{
+	Timestamp m_lastUpdateTimestamp = 0;
+	U32 m_updateEveryFrameComponentCount = 0;
+	U32 m_updateSetIndex = kMaxU32; ///< Index in SceneGraph::m_updateSet. Protected by SceneGraph::m_updateSetLock.
+	SceneNode* m_nextPendingDeletion = nullptr; ///< Link in SceneGraph::m_nodesPendingDeletion.
+	/// @}
 
-	/// Keep the previous transformation for checking if it moved.
-	Transform m_prevWTrf = Transform::getIdentity();
+	U32 m_transformIndex = kMaxU32; ///< The local and world transforms live in the TransformHierarchy.
 
 	// Flags
 	Bool m_markedForDeletion : 1 = false;
-	Bool m_localTransformDirty : 1 = true;
-	Bool m_ignoreParentNodeTransform : 1 = false;
-	Bool m_transformUpdatedThisFrame : 1 = true;
+	Bool m_updateEveryFrame : 1 = false;
 
 	void newComponentInternal(SceneComponent* newc);
+
+	/// Destroy the components and remove the node from the hierarchy and the various scene containers. It's called before the destructor
+	/// by the SceneGraph because it's not thread-safe.
+	void detachFromScene();
+
+	Transform& getLocalTransformForWrite()
+	{
+		return TransformHierarchy::getSingleton().getLocalTransform(m_transformIndex);
+	}
+
+	void setLocalTransformDirty()
+	{
+		// If it's already dirty then it's already marked for update
+		if(TransformHierarchy::getSingleton().markLocalTransformDirty(m_transformIndex))
+		{
+			markForUpdate();
+		}
+	}
 };
 /// @}
 
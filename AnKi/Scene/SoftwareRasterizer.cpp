@@ -7,9 +7,14 @@
 #include <AnKi/Collision/Aabb.h>
 #include <AnKi/Collision/Functions.h>
 #include <AnKi/Util/Tracer.h>
+#include <AnKi/Util/ThreadJobManager.h>
 
 namespace anki {
 
+constexpr U32 kTrianglesPerDrawBatch = 64;
+constexpr U32 kTilesPerTask = 4;
+constexpr U32 kVisibilityTestsPerTask = 64;
+
 void SoftwareRasterizer::prepare(const Mat4& mv, const Mat4& p, U32 width, U32 height)
 {
 	m_mv = mv;
@@ -20,15 +25,35 @@ void SoftwareRasterizer::prepare(const Mat4& mv, const Mat4& p, U32 width, U32 h
 	extractClipPlanes(m_mvp, m_planesW);
 
 	// Reset z buffer
-	ANKI_ASSERT(width > 0 && height > 0);
+	ANKI_ASSERT(width > 0 && height > 0 && width <= kMaxU16 && height <= kMaxU16);
 	m_width = width;
 	m_height = height;
-	U32 size = width * height;
-	if(m_zbuffer.getSize() < size)
+	m_tileCountX = (width + kTileSize - 1) / kTileSize;
+	m_tileCountY = (height + kTileSize - 1) / kTileSize;
+
+	const U32 tileCount = m_tileCountX * m_tileCountY;
+	const U32 size = tileCount * kTileSize * kTileSize;
+	if(m_depthBuffer.getSize() < size)
 	{
-		m_zbuffer.resize(size);
+		m_depthBuffer.resize(size);
+		m_tileMaxDepths.resize(tileCount);
 	}
-	memset(&m_zbuffer[0], 0xFF, sizeof(m_zbuffer[0]) * size);
+	else if(m_tileMaxDepths.getSize() < tileCount)
+	{
+		m_tileMaxDepths.resize(tileCount);
+	}
+
+	for(U32 i = 0; i < size; ++i)
+	{
+		m_depthBuffer[i] = 1.0f;
+	}
+
+	for(U32 i = 0; i < tileCount; ++i)
+	{
+		m_tileMaxDepths[i] = 1.0f;
+	}
+
+	m_triangleCount = 0;
 }
 
 void SoftwareRasterizer::clipTriangle(const Vec4* inVerts, Vec4* outVerts, U& outVertCount) const
@@ -163,6 +188,10 @@ void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride, Bool back
 	ANKI_ASSERT(verts && vertCount > 0 && (vertCount % 3) == 0);
 	ANKI_ASSERT(stride >= sizeof(F32) * 3 && (stride % sizeof(F32)) == 0);
 
+	// Setup the triangles in a local batch to avoid locking for every triangle
+	Array<Triangle, kTrianglesPerDrawBatch> batch;
+	U32 batchCount = 0;
+
 	U floatStride = stride / sizeof(F32);
 	const F32* vertsEnd = verts + vertCount * floatStride;
 	while(verts != vertsEnd)
@@ -198,7 +227,7 @@ void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride, Bool back
 			continue;
 		}
 
-		// Rasterize
+		// Setup
 		Array<Vec4, 3> clip;
 		for(U j = 0; j < clippedCount; j += 3)
 		{
@@ -208,87 +237,356 @@ void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride, Bool back
 				ANKI_ASSERT(clip[k].w() > 0.0f);
 			}
 
-			rasterizeTriangle(&clip[0]);
+			if(setupTriangle(&clip[0], batch[batchCount]))
+			{
+				++batchCount;
+			}
+
+			if(batchCount == batch.getSize())
+			{
+				appendTriangles(ConstWeakArray<Triangle>(&batch[0], batchCount));
+				batchCount = 0;
+			}
 		}
 	}
+
+	if(batchCount)
+	{
+		appendTriangles(ConstWeakArray<Triangle>(&batch[0], batchCount));
+	}
 }
 
-Bool SoftwareRasterizer::computeBarycetrinc(const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& p, Vec3& uvw) const
+void SoftwareRasterizer::appendTriangles(ConstWeakArray<Triangle> triangles)
 {
-	Vec2 dca = c - a;
-	Vec2 dba = b - a;
-	Vec2 dap = a - p;
+	LockGuard lock(m_trianglesLock);
 
-	Vec3 n(dca.x(), dba.x(), dap.x());
-	Vec3 m(dca.y(), dba.y(), dap.y());
+	if(m_triangles.getSize() < m_triangleCount + triangles.getSize())
+	{
+		m_triangles.resize(max(m_triangleCount + triangles.getSize(), m_triangles.getSize() * 2));
+	}
 
-	Vec3 k = n.cross(m);
+	memcpy(&m_triangles[m_triangleCount], &triangles[0], triangles.getSizeInBytes());
+	m_triangleCount += triangles.getSize();
+}
+
+Bool SoftwareRasterizer::setupTriangle(const Vec4* tri, Triangle& out) const
+{
+	ANKI_ASSERT(tri);
 
-	Bool skip = false;
-	if(!isZero(k.z()))
+	// To window space
+	const Vec2 windowSize{F32(m_width), F32(m_height)};
+	Array<Vec2, 3> window;
+	Array<F32, 3> depth;
+	for(U i = 0; i < 3; i++)
 	{
-		uvw = Vec3(1.0f - (k.x() + k.y()) / k.z(), k.y() / k.z(), k.x() / k.z());
+		const Vec3 ndc = tri[i].xyz() / tri[i].w();
+		window[i] = (ndc.xy() / 2.0f + 0.5f) * windowSize;
+		depth[i] = ndc.z();
+	}
 
-		if(uvw.x() < 0.0f || uvw.y() < 0.0f || uvw.z() < 0.0f)
-		{
-			skip = true;
-		}
+	// Make it counter-clockwise so the edge functions are positive inside
+	const Vec2 d10 = window[1] - window[0];
+	const Vec2 d20 = window[2] - window[0];
+	F32 area = d10.x() * d20.y() - d20.x() * d10.y();
+	if(absolute(area) < kEpsilonf)
+	{
+		return false;
 	}
-	else
+
+	if(area < 0.0f)
 	{
-		skip = true;
+		std::swap(window[1], window[2]);
+		std::swap(depth[1], depth[2]);
+		area = -area;
 	}
 
-	return skip;
+	// Bounding box
+	Vec2 bboxMin = window[0].min(window[1]).min(window[2]);
+	Vec2 bboxMax = window[0].max(window[1]).max(window[2]);
+	for(U i = 0; i < 2; ++i)
+	{
+		bboxMin[i] = clamp(std::floor(bboxMin[i]), 0.0f, windowSize[i]);
+		bboxMax[i] = clamp(std::ceil(bboxMax[i]), 0.0f, windowSize[i]);
+	}
+	if(bboxMin.x() >= bboxMax.x() || bboxMin.y() >= bboxMax.y())
+	{
+		return false;
+	}
+
+	out.m_bbox = {U16(bboxMin.x()), U16(bboxMin.y()), U16(bboxMax.x()), U16(bboxMax.y())};
+
+	// Edge functions. The edge i goes from vertex i to vertex i+1
+	for(U i = 0; i < 3; ++i)
+	{
+		const Vec2& a = window[i];
+		const Vec2& b = window[(i + 1) % 3];
+
+		out.m_edgeA[i] = a.y() - b.y();
+		out.m_edgeB[i] = b.x() - a.x();
+		out.m_edgeC[i] = -(out.m_edgeA[i] * a.x() + out.m_edgeB[i] * a.y());
+	}
+
+	out.m_edgeA[3] = out.m_edgeB[3] = out.m_edgeC[3] = 0.0f;
+
+	// Depth plane. The barycentric of a vertex is the edge function of the opposite edge divided by the area
+	const F32 invArea = 1.0f / area;
+	out.m_depthPlane[0] = (depth[0] * out.m_edgeA[1] + depth[1] * out.m_edgeA[2] + depth[2] * out.m_edgeA[0]) * invArea;
+	out.m_depthPlane[1] = (depth[0] * out.m_edgeB[1] + depth[1] * out.m_edgeB[2] + depth[2] * out.m_edgeB[0]) * invArea;
+	out.m_depthPlane[2] = (depth[0] * out.m_edgeC[1] + depth[1] * out.m_edgeC[2] + depth[2] * out.m_edgeC[0]) * invArea;
+	out.m_depthPlane[3] = 0.0f;
+
+	return true;
 }
 
-void SoftwareRasterizer::rasterizeTriangle(const Vec4* tri)
+void SoftwareRasterizer::binTriangles()
 {
-	ANKI_ASSERT(tri);
+	ANKI_TRACE_SCOPED_EVENT(SceneRasterizerBin);
 
-	const Vec2 windowSize{F32(m_width), F32(m_height)};
-	Array<Vec3, 3> ndc;
-	Array<Vec2, 3> window;
-	Vec2 bboxMin(kMaxF32), bboxMax(kMinF32);
-	for(U i = 0; i < 3; i++)
+	const U32 tileCount = m_tileCountX * m_tileCountY;
+	if(m_binOffsets.getSize() < tileCount + 1)
 	{
-		ndc[i] = tri[i].xyz() / tri[i].w();
-		window[i] = (ndc[i].xy() / 2.0f + 0.5f) * windowSize;
+		m_binOffsets.resize(tileCount + 1);
+	}
 
-		for(U j = 0; j < 2; j++)
-		{
-			bboxMin[j] = std::floor(min(bboxMin[j], window[i][j]));
-			bboxMin[j] = clamp(bboxMin[j], 0.0f, windowSize[j]);
+	for(U32 i = 0; i < tileCount + 1; ++i)
+	{
+		m_binOffsets[i] = 0;
+	}
 
-			bboxMax[j] = std::ceil(max(bboxMax[j], window[i][j]));
-			bboxMax[j] = clamp(bboxMax[j], 0.0f, windowSize[j]);
+	// Count the triangles of every tile
+	U32 binnedCount = 0;
+	for(U32 i = 0; i < m_triangleCount; ++i)
+	{
+		const Triangle& tri = m_triangles[i];
+		for(U32 ty = tri.m_bbox[1] / kTileSize; ty <= (tri.m_bbox[3] - 1u) / kTileSize; ++ty)
+		{
+			for(U32 tx = tri.m_bbox[0] / kTileSize; tx <= (tri.m_bbox[2] - 1u) / kTileSize; ++tx)
+			{
+				++m_binOffsets[ty * m_tileCountX + tx];
+				++binnedCount;
+			}
 		}
 	}
 
-	for(F32 y = bboxMin.y() + 0.5f; y < bboxMax.y() + 0.5f; y += 1.0f)
+	// Offsets to the end of every bin
+	for(U32 i = 1; i < tileCount; ++i)
 	{
-		for(F32 x = bboxMin.x() + 0.5f; x < bboxMax.x() + 0.5f; x += 1.0f)
+		m_binOffsets[i] += m_binOffsets[i - 1];
+	}
+	m_binOffsets[tileCount] = binnedCount;
+
+	if(m_binnedTriangles.getSize() < binnedCount)
+	{
+		m_binnedTriangles.resize(binnedCount);
+	}
+
+	// Fill the bins backwards. At the end the offsets will point to the start of every bin
+	for(U32 i = m_triangleCount; i-- > 0;)
+	{
+		const Triangle& tri = m_triangles[i];
+		for(U32 ty = tri.m_bbox[1] / kTileSize; ty <= (tri.m_bbox[3] - 1u) / kTileSize; ++ty)
 		{
-			Vec2 p(x, y);
-			Vec3 bc;
-			if(!computeBarycetrinc(window[0], window[1], window[2], p, bc))
+			for(U32 tx = tri.m_bbox[0] / kTileSize; tx <= (tri.m_bbox[2] - 1u) / kTileSize; ++tx)
 			{
-				const F32 z0 = ndc[0].z();
-				const F32 z1 = ndc[1].z();
-				const F32 z2 = ndc[2].z();
+				m_binnedTriangles[--m_binOffsets[ty * m_tileCountX + tx]] = i;
+			}
+		}
+	}
+}
 
-				F32 depth = z0 * bc[0] + z1 * bc[1] + z2 * bc[2];
-				ANKI_ASSERT(depth >= 0.0 && depth <= 1.0);
+void SoftwareRasterizer::rasterize(ThreadJobManager* jobManager)
+{
+	ANKI_TRACE_SCOPED_EVENT(SceneRasterizerRasterize);
 
-				// Clamp it to a bit less that 1.0f because 1.0f will produce a 0 depthi
-				depth = min(depth, 1.0f - kEpsilonf);
+	binTriangles();
+
+	const U32 tileCount = m_tileCountX * m_tileCountY;
+	if(jobManager == nullptr || tileCount <= kTilesPerTask)
+	{
+		for(U32 i = 0; i < tileCount; ++i)
+		{
+			rasterizeTile(i);
+		}
+
+		return;
+	}
+
+	// Every tile is owned by one task so there is no need to synchronize the depth writes
+	class Ctx
+	{
+	public:
+		SoftwareRasterizer* m_rasterizer;
+		U32 m_tileCount;
+		Atomic<U32> m_crntTile = {0};
+	} ctx;
+	ctx.m_rasterizer = this;
+	ctx.m_tileCount = tileCount;
+
+	const U32 taskCount = min(jobManager->getThreadCount(), (tileCount + kTilesPerTask - 1) / kTilesPerTask);
+	ThreadJobCounter counter;
+	for(U32 i = 0; i < taskCount; ++i)
+	{
+		jobManager->dispatchTask(
+			[&ctx]([[maybe_unused]] U32 threadId) {
+				while(true)
+				{
+					const U32 begin = ctx.m_crntTile.fetchAdd(kTilesPerTask);
+					if(begin >= ctx.m_tileCount)
+					{
+						break;
+					}
+
+					const U32 end = min(begin + kTilesPerTask, ctx.m_tileCount);
+					for(U32 tile = begin; tile < end; ++tile)
+					{
+						ctx.m_rasterizer->rasterizeTile(tile);
+					}
+				}
+			},
+			&counter);
+	}
+
+	jobManager->waitForCounter(counter);
+}
+
+void SoftwareRasterizer::rasterizeTile(U32 tileIdx)
+{
+	const U32 tileX = (tileIdx % m_tileCountX) * kTileSize;
+	const U32 tileY = (tileIdx / m_tileCountX) * kTileSize;
+	F32* depths = getTileDepths(tileIdx);
 
-				// Store the min of the current value and new one
-				const U32 depthi = U32(depth * F32(kMaxU32));
-				m_zbuffer[U32(y) * m_width + U32(x)].min(depthi);
+	for(U32 b = m_binOffsets[tileIdx]; b < m_binOffsets[tileIdx + 1]; ++b)
+	{
+		const Triangle& tri = m_triangles[m_binnedTriangles[b]];
+
+		// The part of the triangle's bbox inside the tile. Start from a multiple of 4 to process 4 pixels at a time. The extra pixels
+		// are inside the tile and the edge functions will take care of them
+		const U32 minX = max<U32>(tri.m_bbox[0], tileX) & ~3u;
+		const U32 maxX = min<U32>(tri.m_bbox[2], tileX + kTileSize);
+		const U32 minY = max<U32>(tri.m_bbox[1], tileY);
+		const U32 maxY = min<U32>(tri.m_bbox[3], tileY + kTileSize);
+
+#if ANKI_SIMD_SSE
+		const __m128 edgeA = _mm_load_ps(&tri.m_edgeA[0]);
+		const __m128 edgeB = _mm_load_ps(&tri.m_edgeB[0]);
+		const __m128 edgeC = _mm_load_ps(&tri.m_edgeC[0]);
+		const __m128 pixelOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 zero = _mm_setzero_ps();
+
+		for(U32 y = minY; y < maxY; ++y)
+		{
+			// Edge functions and depth at the start of the row for the 4 pixels
+			const F32 py = F32(y) + 0.5f;
+			const __m128 px = _mm_add_ps(_mm_set1_ps(F32(minX)), pixelOffsets);
+			const __m128 rowStart = _mm_add_ps(_mm_mul_ps(edgeB, _mm_set1_ps(py)), edgeC);
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.m_edgeA[0]), px), _mm_shuffle_ps(rowStart, rowStart, _MM_SHUFFLE(0, 0, 0, 0)));
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.m_edgeA[1]), px), _mm_shuffle_ps(rowStart, rowStart, _MM_SHUFFLE(1, 1, 1, 1)));
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.m_edgeA[2]), px), _mm_shuffle_ps(rowStart, rowStart, _MM_SHUFFLE(2, 2, 2, 2)));
+			__m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.m_depthPlane[0]), px), _mm_set1_ps(tri.m_depthPlane[1] * py + tri.m_depthPlane[2]));
+
+			const __m128 stepX = _mm_mul_ps(edgeA, _mm_set1_ps(4.0f));
+			const __m128 e0Step = _mm_shuffle_ps(stepX, stepX, _MM_SHUFFLE(0, 0, 0, 0));
+			const __m128 e1Step = _mm_shuffle_ps(stepX, stepX, _MM_SHUFFLE(1, 1, 1, 1));
+			const __m128 e2Step = _mm_shuffle_ps(stepX, stepX, _MM_SHUFFLE(2, 2, 2, 2));
+			const __m128 zStep = _mm_set1_ps(tri.m_depthPlane[0] * 4.0f);
+
+			F32* rowDepths = depths + (y - tileY) * kTileSize - tileX;
+			for(U32 x = minX; x < maxX; x += 4)
+			{
+				const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+				if(_mm_movemask_ps(inside))
+				{
+					const __m128 oldDepth = _mm_loadu_ps(rowDepths + x);
+					const __m128 newDepth = _mm_blendv_ps(oldDepth, _mm_min_ps(oldDepth, z), inside);
+					_mm_storeu_ps(rowDepths + x, newDepth);
+				}
+
+				e0 = _mm_add_ps(e0, e0Step);
+				e1 = _mm_add_ps(e1, e1Step);
+				e2 = _mm_add_ps(e2, e2Step);
+				z = _mm_add_ps(z, zStep);
+			}
+		}
+#elif ANKI_SIMD_NEON
+		const float32x4_t pixelOffsets = {0.5f, 1.5f, 2.5f, 3.5f};
+		const float32x4_t zero = vdupq_n_f32(0.0f);
+
+		for(U32 y = minY; y < maxY; ++y)
+		{
+			const F32 py = F32(y) + 0.5f;
+			const float32x4_t px = vaddq_f32(vdupq_n_f32(F32(minX)), pixelOffsets);
+			float32x4_t e0 = vmlaq_n_f32(vdupq_n_f32(tri.m_edgeB[0] * py + tri.m_edgeC[0]), px, tri.m_edgeA[0]);
+			float32x4_t e1 = vmlaq_n_f32(vdupq_n_f32(tri.m_edgeB[1] * py + tri.m_edgeC[1]), px, tri.m_edgeA[1]);
+			float32x4_t e2 = vmlaq_n_f32(vdupq_n_f32(tri.m_edgeB[2] * py + tri.m_edgeC[2]), px, tri.m_edgeA[2]);
+			float32x4_t z = vmlaq_n_f32(vdupq_n_f32(tri.m_depthPlane[1] * py + tri.m_depthPlane[2]), px, tri.m_depthPlane[0]);
+
+			const float32x4_t e0Step = vdupq_n_f32(tri.m_edgeA[0] * 4.0f);
+			const float32x4_t e1Step = vdupq_n_f32(tri.m_edgeA[1] * 4.0f);
+			const float32x4_t e2Step = vdupq_n_f32(tri.m_edgeA[2] * 4.0f);
+			const float32x4_t zStep = vdupq_n_f32(tri.m_depthPlane[0] * 4.0f);
+
+			F32* rowDepths = depths + (y - tileY) * kTileSize - tileX;
+			for(U32 x = minX; x < maxX; x += 4)
+			{
+				const uint32x4_t inside = vandq_u32(vandq_u32(vcgeq_f32(e0, zero), vcgeq_f32(e1, zero)), vcgeq_f32(e2, zero));
+				if(vmaxvq_u32(inside))
+				{
+					const float32x4_t oldDepth = vld1q_f32(rowDepths + x);
+					vst1q_f32(rowDepths + x, vbslq_f32(inside, vminq_f32(oldDepth, z), oldDepth));
+				}
+
+				e0 = vaddq_f32(e0, e0Step);
+				e1 = vaddq_f32(e1, e1Step);
+				e2 = vaddq_f32(e2, e2Step);
+				z = vaddq_f32(z, zStep);
 			}
 		}
+#else
+		for(U32 y = minY; y < maxY; ++y)
+		{
+			const F32 py = F32(y) + 0.5f;
+			F32* rowDepths = depths + (y - tileY) * kTileSize - tileX;
+			for(U32 x = minX; x < maxX; ++x)
+			{
+				const F32 px = F32(x) + 0.5f;
+				Bool inside = true;
+				for(U32 e = 0; e < 3; ++e)
+				{
+					inside = inside && tri.m_edgeA[e] * px + tri.m_edgeB[e] * py + tri.m_edgeC[e] >= 0.0f;
+				}
+
+				if(inside)
+				{
+					const F32 z = tri.m_depthPlane[0] * px + tri.m_depthPlane[1] * py + tri.m_depthPlane[2];
+					rowDepths[x] = min(rowDepths[x], z);
+				}
+			}
+		}
+#endif
+	}
+
+	computeTileMaxDepth(tileIdx);
+}
+
+void SoftwareRasterizer::computeTileMaxDepth(U32 tileIdx)
+{
+	// Only the pixels inside the window count
+	const U32 tileX = (tileIdx % m_tileCountX) * kTileSize;
+	const U32 tileY = (tileIdx / m_tileCountX) * kTileSize;
+	const U32 width = min(kTileSize, m_width - tileX);
+	const U32 height = min(kTileSize, m_height - tileY);
+
+	const F32* depths = getTileDepths(tileIdx);
+	F32 maxDepth = 0.0f;
+	for(U32 y = 0; y < height; ++y)
+	{
+		for(U32 x = 0; x < width; ++x)
+		{
+			maxDepth = max(maxDepth, depths[y * kTileSize + x]);
+		}
 	}
+
+	m_tileMaxDepths[tileIdx] = maxDepth;
 }
 
 Bool SoftwareRasterizer::visibilityTest(const Aabb& aabb) const
@@ -299,6 +597,60 @@ Bool SoftwareRasterizer::visibilityTest(const Aabb& aabb) const
 	return inside;
 }
 
+void SoftwareRasterizer::visibilityTests(ConstWeakArray<Aabb> aabbs, WeakArray<Bool> visible, ThreadJobManager* jobManager) const
+{
+	ANKI_TRACE_SCOPED_EVENT(SceneRasterizerTest);
+	ANKI_ASSERT(aabbs.getSize() == visible.getSize());
+
+	if(jobManager == nullptr || aabbs.getSize() <= kVisibilityTestsPerTask)
+	{
+		for(U32 i = 0; i < aabbs.getSize(); ++i)
+		{
+			visible[i] = visibilityTestInternal(aabbs[i]);
+		}
+
+		return;
+	}
+
+	class Ctx
+	{
+	public:
+		const SoftwareRasterizer* m_rasterizer;
+		ConstWeakArray<Aabb> m_aabbs;
+		WeakArray<Bool> m_visible;
+		Atomic<U32> m_crntAabb = {0};
+	} ctx;
+	ctx.m_rasterizer = this;
+	ctx.m_aabbs = aabbs;
+	ctx.m_visible = visible;
+
+	const U32 taskCount = min(jobManager->getThreadCount(), (aabbs.getSize() + kVisibilityTestsPerTask - 1) / kVisibilityTestsPerTask);
+	ThreadJobCounter counter;
+	for(U32 i = 0; i < taskCount; ++i)
+	{
+		jobManager->dispatchTask(
+			[&ctx]([[maybe_unused]] U32 threadId) {
+				while(true)
+				{
+					const U32 begin = ctx.m_crntAabb.fetchAdd(kVisibilityTestsPerTask);
+					if(begin >= ctx.m_aabbs.getSize())
+					{
+						break;
+					}
+
+					const U32 end = min(begin + kVisibilityTestsPerTask, ctx.m_aabbs.getSize());
+					for(U32 j = begin; j < end; ++j)
+					{
+						ctx.m_visible[j] = ctx.m_rasterizer->visibilityTestInternal(ctx.m_aabbs[j]);
+					}
+				}
+			},
+			&counter);
+	}
+
+	jobManager->waitForCounter(counter);
+}
+
 Bool SoftwareRasterizer::visibilityTestInternal(const Aabb& aabb) const
 {
 	// Set the AABB points
@@ -353,30 +705,42 @@ Bool SoftwareRasterizer::visibilityTestInternal(const Aabb& aabb) const
 	}
 
 	// Fix the bounds
-	bboxMin.x() = floorf(bboxMin.x());
-	bboxMin.x() = clamp(bboxMin.x(), 0.0f, F32(m_width));
-
-	bboxMax.x() = ceilf(bboxMax.x());
-	bboxMax.x() = clamp(bboxMax.x(), 0.0f, F32(m_width));
-
-	bboxMin.y() = floorf(bboxMin.y());
-	bboxMin.y() = clamp(bboxMin.y(), 0.0f, F32(m_height));
-
-	bboxMax.y() = ceilf(bboxMax.y());
-	bboxMax.y() = clamp(bboxMax.y(), 0.0f, F32(m_height));
+	const U32 minX = U32(clamp(floorf(bboxMin.x()), 0.0f, F32(m_width)));
+	const U32 maxX = U32(clamp(ceilf(bboxMax.x()), 0.0f, F32(m_width)));
+	const U32 minY = U32(clamp(floorf(bboxMin.y()), 0.0f, F32(m_height)));
+	const U32 maxY = U32(clamp(ceilf(bboxMax.y()), 0.0f, F32(m_height)));
+	if(minX >= maxX || minY >= maxY)
+	{
+		// Off screen
+		return false;
+	}
 
 	// Loop the tiles
-	F32 minZ = bboxMin.z();
-	for(F32 y = bboxMin.y(); y < bboxMax.y(); y += 1.0f)
+	const F32 minZ = bboxMin.z();
+	for(U32 ty = minY / kTileSize; ty <= (maxY - 1) / kTileSize; ++ty)
 	{
-		for(F32 x = bboxMin.x(); x < bboxMax.x(); x += 1.0f)
+		for(U32 tx = minX / kTileSize; tx <= (maxX - 1) / kTileSize; ++tx)
 		{
-			const U32 idx = U32(y) * m_width + U32(x);
-			const U32 depthi = m_zbuffer[idx].getNonAtomically();
-			const F32 depthf = F32(depthi) / F32(kMaxU32);
-			if(minZ < depthf)
+			const U32 tileIdx = ty * m_tileCountX + tx;
+			if(minZ >= m_tileMaxDepths[tileIdx])
 			{
-				return true;
+				// Everything in the tile is in front of the box
+				continue;
+			}
+
+			// Check the pixels
+			const U32 tileX = tx * kTileSize;
+			const U32 tileY = ty * kTileSize;
+			const F32* depths = getTileDepths(tileIdx);
+			for(U32 y = max(minY, tileY); y < min(maxY, tileY + kTileSize); ++y)
+			{
+				for(U32 x = max(minX, tileX); x < min(maxX, tileX + kTileSize); ++x)
+				{
+					if(minZ < depths[(y - tileY) * kTileSize + (x - tileX)])
+					{
+						return true;
+					}
+				}
 			}
 		}
 	}
@@ -386,18 +750,23 @@ Bool SoftwareRasterizer::visibilityTestInternal(const Aabb& aabb) const
 
 void SoftwareRasterizer::fillDepthBuffer(ConstWeakArray<F32> depthValues)
 {
-	ANKI_ASSERT(m_zbuffer.getSize() == depthValues.getSize());
+	ANKI_ASSERT(m_width * m_height == depthValues.getSize());
 
-	U32 count = depthValues.getSize();
-	while(count--)
+	for(U32 y = 0; y < m_height; ++y)
 	{
-		F32 depth = depthValues[count];
-		ANKI_ASSERT(depth >= 0.0f && depth <= 1.0f);
+		for(U32 x = 0; x < m_width; ++x)
+		{
+			const F32 depth = depthValues[y * m_width + x];
+			ANKI_ASSERT(depth >= 0.0f && depth <= 1.0f);
 
-		depth = min(depth, 1.0f - kEpsilonf); // See a few lines above why is that
+			const U32 tileIdx = (y / kTileSize) * m_tileCountX + x / kTileSize;
+			getTileDepths(tileIdx)[(y % kTileSize) * kTileSize + x % kTileSize] = depth;
+		}
+	}
 
-		const U32 depthi = U32(depth * F32(kMaxU32));
-		m_zbuffer[count].setNonAtomically(depthi);
+	for(U32 i = 0; i < m_tileCountX * m_tileCountY; ++i)
+	{
+		computeTileMaxDepth(i);
 	}
 }
 
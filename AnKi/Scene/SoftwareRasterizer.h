@@ -12,17 +12,29 @@
 
 namespace anki {
 
+// Forward
+class ThreadJobManager;
+
 /// @addtogroup scene
 /// @{
 
-/// Software rasterizer for visibility tests.
+/// Software rasterizer for CPU occlusion culling. The usage is:
+/// - prepare()
+/// - draw() or fillDepthBuffer() to render the occluders
+/// - rasterize() (only when draw() is used)
+/// - visibilityTest() or visibilityTests() to test the occludees
+///
+/// The draw() only sets up the triangles. The rasterize() bins them into screen tiles and renders every tile in parallel. The depth
+/// buffer is stored tile by tile and every tile keeps its max depth so the visibility tests can skip whole tiles.
 class SoftwareRasterizer
 {
 public:
+	static constexpr U32 kTileSize = 32; ///< In pixels.
+
 	/// Prepare for rendering. Call it before every draw.
 	void prepare(const Mat4& mv, const Mat4& p, U32 width, U32 height);
 
-	/// Render some verts.
+	/// Setup some triangles for rendering. They will be rendered in rasterize().
 	/// @param[in] verts Pointer to the first vertex to draw.
 	/// @param vertCount The number of verts to draw.
 	/// @param stride The stride (in bytes) of the next vertex.
@@ -30,7 +42,12 @@ public:
 	/// @note It's thread-safe against other draw() invocations only.
 	void draw(const F32* verts, U vertCount, U stride, Bool backfaceCulling);
 
-	/// Fill the depth buffer with some values.
+	/// Bin the triangles of draw() into tiles and rasterize them.
+	/// @param jobManager If not nullptr the tiles will be rasterized in parallel.
+	void rasterize(ThreadJobManager* jobManager = nullptr);
+
+	/// Fill the depth buffer with some values. It's an alternative to draw() and rasterize().
+	/// @param depthValues Row-major depth values. Their count should be width*height.
 	void fillDepthBuffer(ConstWeakArray<F32> depthValues);
 
 	/// Perform visibility tests.
@@ -38,7 +55,30 @@ public:
 	/// @return Return true if it's visible and false otherwise.
 	Bool visibilityTest(const Aabb& aabb) const;
 
+	/// Perform many visibility tests.
+	/// @param aabbs The Aabbs in world space.
+	/// @param[out] visible The results of the tests. Its size should be the same as the aabbs.
+	/// @param jobManager If not nullptr the tests will be split in tasks.
+	void visibilityTests(ConstWeakArray<Aabb> aabbs, WeakArray<Bool> visible, ThreadJobManager* jobManager = nullptr) const;
+
+	/// The number of triangles that passed the culling and clipping of draw(). Useful for stats.
+	U32 getTriangleCount() const
+	{
+		return m_triangleCount;
+	}
+
 private:
+	/// A triangle in screen space ready for rasterization.
+	class alignas(16) Triangle
+	{
+	public:
+		Array<F32, 4> m_edgeA; ///< The A of the A*x+B*y+C of the 3 edges. They are positive inside the triangle.
+		Array<F32, 4> m_edgeB;
+		Array<F32, 4> m_edgeC;
+		Array<F32, 4> m_depthPlane; ///< The depth is z=A*x+B*y+C.
+		Array<U16, 4> m_bbox; ///< minX, minY, maxX, maxY in pixels. The max is exclusive.
+	};
+
 	Mat4 m_mv; ///< ModelView.
 	Mat4 m_p; ///< Projection.
 	Mat4 m_mvp;
@@ -46,18 +86,46 @@ private:
 	Array<Plane, 6> m_planesW; ///< In world space.
 	U32 m_width;
 	U32 m_height;
-	SceneDynamicArray<Atomic<U32>> m_zbuffer;
+	U32 m_tileCountX;
+	U32 m_tileCountY;
+
+	SceneDynamicArray<F32> m_depthBuffer; ///< Tile by tile. Pixels in a tile are row-major.
+	SceneDynamicArray<F32> m_tileMaxDepths;
+
+	SceneDynamicArray<Triangle> m_triangles; ///< It only grows. The m_triangleCount are the valid ones.
+	U32 m_triangleCount = 0;
+	SpinLock m_trianglesLock;
+
+	SceneDynamicArray<U32> m_binOffsets; ///< Where the triangles of a tile start in m_binnedTriangles.
+	SceneDynamicArray<U32> m_binnedTriangles; ///< Indices to m_triangles.
 
 	/// @param tri In clip space.
-	void rasterizeTriangle(const Vec4* tri);
+	/// @return False if the triangle is degenerate or off screen.
+	Bool setupTriangle(const Vec4* tri, Triangle& out) const;
 
-	Bool computeBarycetrinc(const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& p, Vec3& uvw) const;
+	void appendTriangles(ConstWeakArray<Triangle> triangles);
 
 	/// Clip triangle in the near plane.
 	/// @note Triangles in view space.
 	void clipTriangle(const Vec4* inTriangle, Vec4* outTriangles, U& outTriangleCount) const;
 
+	void binTriangles();
+
+	void rasterizeTile(U32 tileIdx);
+
+	void computeTileMaxDepth(U32 tileIdx);
+
 	Bool visibilityTestInternal(const Aabb& aabb) const;
+
+	F32* getTileDepths(U32 tileIdx)
+	{
+		return &m_depthBuffer[tileIdx * kTileSize * kTileSize];
+	}
+
+	const F32* getTileDepths(U32 tileIdx) const
+	{
+		return &m_depthBuffer[tileIdx * kTileSize * kTileSize];
+	}
 };
 /// @}
 
@@ -0,0 +1,169 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Scene/TransformHierarchy.h>
+#include <AnKi/Util/ThreadJobManager.h>
+
+namespace anki {
+
+TransformHierarchy::~TransformHierarchy()
+{
+	ANKI_ASSERT(m_transformCount == 0 && "Forgot to delete some transforms");
+
+	for(U32 i = 0; i < m_pageCount.load(); ++i)
+	{
+		deleteInstance(SceneMemoryPool::getSingleton(), m_pages[i]);
+	}
+}
+
+U32 TransformHierarchy::newTransform()
+{
+	U32 idx;
+	{
+		LockGuard lock(m_mtx);
+
+		if(m_freeIndices.getSize())
+		{
+			idx = m_freeIndices.getBack();
+			m_freeIndices.popBack();
+		}
+		else
+		{
+			idx = m_indexCount++;
+
+			const U32 pageIdx = idx >> kTransformsPerPageLog2;
+			if(pageIdx == m_pageCount.load())
+			{
+				ANKI_ASSERT(pageIdx < kMaxPages && "Too many transforms");
+
+				// The page is published before the count so the readers never see a null page
+				m_pages[pageIdx] = newInstance<Page>(SceneMemoryPool::getSingleton());
+				m_pageCount.store(pageIdx + 1);
+			}
+		}
+
+		++m_transformCount;
+	}
+
+	// The transform belongs to the caller from now on, no need to hold the lock
+	get(&Page::m_localTransforms, idx) = Transform::getIdentity();
+	get(&Page::m_worldTransforms, idx) = Transform::getIdentity();
+	get(&Page::m_prevWorldTransforms, idx) = Transform::getIdentity();
+	get(&Page::m_parents, idx) = kMaxU32;
+	get(&Page::m_versions, idx) = 0;
+	get(&Page::m_parentVersions, idx) = kMaxU32;
+	get(&Page::m_flags, idx) = TransformFlag::kAlive | TransformFlag::kLocalDirty | TransformFlag::kUpdatedThisFrame;
+
+	return idx;
+}
+
+void TransformHierarchy::deleteTransform(U32 idx)
+{
+	ANKI_ASSERT(isAlive(idx));
+	get(&Page::m_flags, idx) = TransformFlag::kNone;
+
+	LockGuard lock(m_mtx);
+	m_freeIndices.emplaceBack(idx);
+	ANKI_ASSERT(m_transformCount > 0);
+	--m_transformCount;
+}
+
+Bool TransformHierarchy::updateWorldTransform(U32 idx)
+{
+	ANKI_ASSERT(isAlive(idx));
+
+	Page& page = getPage(idx);
+	const U32 i = getPageOffset(idx);
+
+	TransformFlag& flags = page.m_flags[i];
+	const U32 parent = page.m_parents[i];
+	const Bool useParent = parent != kMaxU32 && !(flags & TransformFlag::kIgnoreParent);
+
+	// Needs update if the local changed or the parent's world changed since the last time
+	const Bool needsUpdate = !!(flags & TransformFlag::kLocalDirty) || (useParent && page.m_parentVersions[i] != get(&Page::m_versions, parent));
+	const Bool updatedLastFrame = !!(flags & TransformFlag::kUpdatedThisFrame);
+
+	flags &= ~(TransformFlag::kLocalDirty | TransformFlag::kUpdatedThisFrame);
+	if(needsUpdate)
+	{
+		flags |= TransformFlag::kUpdatedThisFrame;
+	}
+
+	if(needsUpdate || updatedLastFrame)
+	{
+		page.m_prevWorldTransforms[i] = page.m_worldTransforms[i];
+	}
+
+	if(needsUpdate)
+	{
+		if(useParent)
+		{
+			ANKI_ASSERT(isAlive(parent));
+			const Page& parentPage = getPage(parent);
+			const U32 parentI = getPageOffset(parent);
+			page.m_worldTransforms[i] = parentPage.m_worldTransforms[parentI].combineTransformations(page.m_localTransforms[i]);
+			page.m_parentVersions[i] = parentPage.m_versions[parentI];
+		}
+		else
+		{
+			page.m_worldTransforms[i] = page.m_localTransforms[i];
+		}
+
+		++page.m_versions[i];
+	}
+
+	return needsUpdate;
+}
+
+void TransformHierarchy::updateWorldTransforms(ConstWeakArray<U32> indices, ThreadJobManager* jobManager)
+{
+	if(jobManager == nullptr || indices.getSize() <= kTransformsPerTask)
+	{
+		for(U32 idx : indices)
+		{
+			updateWorldTransform(idx);
+		}
+
+		return;
+	}
+
+	class Ctx
+	{
+	public:
+		TransformHierarchy* m_hierarchy;
+		ConstWeakArray<U32> m_indices;
+		Atomic<U32> m_crntIndex = {0};
+	} ctx;
+	ctx.m_hierarchy = this;
+	ctx.m_indices = indices;
+
+	const U32 taskCount = min(jobManager->getThreadCount(), (indices.getSize() + kTransformsPerTask - 1) / kTransformsPerTask);
+	ThreadJobCounter counter;
+	for(U32 i = 0; i < taskCount; ++i)
+	{
+		jobManager->dispatchTask(
+			[&ctx]([[maybe_unused]] U32 threadId) {
+				while(true)
+				{
+					const U32 begin = ctx.m_crntIndex.fetchAdd(kTransformsPerTask);
+					if(begin >= ctx.m_indices.getSize())
+					{
+						break;
+					}
+
+					const U32 end = min(begin + kTransformsPerTask, ctx.m_indices.getSize());
+					for(U32 j = begin; j < end; ++j)
+					{
+						ctx.m_hierarchy->updateWorldTransform(ctx.m_indices[j]);
+					}
+				}
+			},
+			&counter);
+	}
+
+	jobManager->waitForCounter(counter);
+}
+
+} // end namespace anki
@@ -0,0 +1,200 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Scene/Common.h>
+#include <AnKi/Math.h>
+#include <AnKi/Util/Enum.h>
+#include <AnKi/Util/WeakArray.h>
+#include <AnKi/Util/Thread.h>
+#include <AnKi/Util/Atomic.h>
+
+namespace anki {
+
+// Forward
+class ThreadJobManager;
+
+/// @addtogroup scene
+/// @{
+
+/// @memberof TransformHierarchy
+enum class TransformFlag : U8
+{
+	kNone = 0,
+	kAlive = 1 << 0,
+	kLocalDirty = 1 << 1,
+	kIgnoreParent = 1 << 2,
+	kUpdatedThisFrame = 1 << 3
+};
+ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS(TransformFlag)
+
+/// Packed (SoA) storage of the transforms of the scene nodes. Every transform has a local and a world transformation and the index of
+/// its parent. World transforms are computed a whole level of the hierarchy at a time (parents first) and every level is processed
+/// in parallel chunks without touching the scene nodes. The transforms live in pages that never move so new transforms can be created
+/// (by loader or script threads for example) while others are being read or updated.
+class TransformHierarchy : public MakeSingleton<TransformHierarchy>
+{
+	template<typename>
+	friend class MakeSingleton;
+
+public:
+	/// Transforms per task in updateWorldTransforms().
+	static constexpr U32 kTransformsPerTask = 256;
+
+	/// Allocate a new identity transform without a parent.
+	/// @note It's thread-safe against other newTransform() and deleteTransform() calls and against the access of other transforms.
+	U32 newTransform();
+
+	/// @note It's thread-safe against other newTransform() and deleteTransform() calls and against the access of other transforms.
+	void deleteTransform(U32 idx);
+
+	/// Set the parent. Use kMaxU32 to remove the parent.
+	void setParent(U32 idx, U32 parentIdx)
+	{
+		ANKI_ASSERT(isAlive(idx) && idx != parentIdx);
+		ANKI_ASSERT(parentIdx == kMaxU32 || isAlive(parentIdx));
+		get(&Page::m_parents, idx) = parentIdx;
+		get(&Page::m_parentVersions, idx) = kMaxU32;
+		get(&Page::m_flags, idx) |= TransformFlag::kLocalDirty; // Force an update
+	}
+
+	U32 getParent(U32 idx) const
+	{
+		ANKI_ASSERT(isAlive(idx));
+		return get(&Page::m_parents, idx);
+	}
+
+	void setIgnoreParentTransform(U32 idx, Bool ignore)
+	{
+		ANKI_ASSERT(isAlive(idx));
+		if(ignore)
+		{
+			get(&Page::m_flags, idx) |= TransformFlag::kIgnoreParent;
+		}
+		else
+		{
+			get(&Page::m_flags, idx) &= ~TransformFlag::kIgnoreParent;
+		}
+		get(&Page::m_flags, idx) |= TransformFlag::kLocalDirty;
+	}
+
+	const Transform& getLocalTransform(U32 idx) const
+	{
+		ANKI_ASSERT(isAlive(idx));
+		return get(&Page::m_localTransforms, idx);
+	}
+
+	/// Get the local transform to change it. Call markLocalTransformDirty() after that.
+	Transform& getLocalTransform(U32 idx)
+	{
+		ANKI_ASSERT(isAlive(idx));
+		return get(&Page::m_localTransforms, idx);
+	}
+
+	/// @return True if it wasn't dirty already.
+	Bool markLocalTransformDirty(U32 idx)
+	{
+		ANKI_ASSERT(isAlive(idx));
+		const Bool wasDirty = !!(get(&Page::m_flags, idx) & TransformFlag::kLocalDirty);
+		get(&Page::m_flags, idx) |= TransformFlag::kLocalDirty;
+		return !wasDirty;
+	}
+
+	const Transform& getWorldTransform(U32 idx) const
+	{
+		ANKI_ASSERT(isAlive(idx));
+		return get(&Page::m_worldTransforms, idx);
+	}
+
+	const Transform& getPreviousWorldTransform(U32 idx) const
+	{
+		ANKI_ASSERT(isAlive(idx));
+		return get(&Page::m_prevWorldTransforms, idx);
+	}
+
+	/// Return true if the world transform changed in the last update of this transform.
+	Bool getWorldTransformUpdated(U32 idx) const
+	{
+		ANKI_ASSERT(isAlive(idx));
+		return !!(get(&Page::m_flags, idx) & TransformFlag::kUpdatedThisFrame);
+	}
+
+	/// Compute the world transform if the local or the parent's world transform changed. Call it once per frame. The world transform
+	/// of the parent needs to be up to date.
+	/// @return True if the world transform changed.
+	Bool updateWorldTransform(U32 idx);
+
+	/// Same as updateWorldTransform() for many transforms. Since the parents need to be up to date call it for one level of the
+	/// hierarchy at a time starting from the roots.
+	/// @param indices The transforms to update. None of them can be the parent of another.
+	/// @param jobManager If not nullptr the work will be split in tasks.
+	void updateWorldTransforms(ConstWeakArray<U32> indices, ThreadJobManager* jobManager = nullptr);
+
+	/// The number of live transforms.
+	U32 getTransformCount() const
+	{
+		LockGuard lock(m_mtx);
+		return m_transformCount;
+	}
+
+private:
+	static constexpr U32 kTransformsPerPageLog2 = 10;
+	static constexpr U32 kTransformsPerPage = 1u << kTransformsPerPageLog2;
+	static constexpr U32 kMaxPages = 4 * 1024;
+
+	class Page
+	{
+	public:
+		Array<Transform, kTransformsPerPage> m_localTransforms;
+		Array<Transform, kTransformsPerPage> m_worldTransforms;
+		Array<Transform, kTransformsPerPage> m_prevWorldTransforms;
+		Array<U32, kTransformsPerPage> m_parents;
+		Array<U32, kTransformsPerPage> m_versions; ///< Increases every time the world transform changes.
+		Array<U32, kTransformsPerPage> m_parentVersions; ///< The version of the parent when the world transform was computed.
+		Array<TransformFlag, kTransformsPerPage> m_flags;
+	};
+
+	Array<Page*, kMaxPages> m_pages = {};
+	Atomic<U32> m_pageCount = {0};
+
+	/// @name Protected by m_mtx
+	/// @{
+	SceneDynamicArray<U32> m_freeIndices;
+	U32 m_transformCount = 0;
+	U32 m_indexCount = 0; ///< The indices that have been handed out at least once.
+	/// @}
+
+	mutable Mutex m_mtx;
+
+	TransformHierarchy() = default;
+
+	~TransformHierarchy();
+
+	Page& getPage(U32 idx) const
+	{
+		ANKI_ASSERT(idx < m_pageCount.load() * kTransformsPerPage);
+		return *m_pages[idx >> kTransformsPerPageLog2];
+	}
+
+	static U32 getPageOffset(U32 idx)
+	{
+		return idx & (kTransformsPerPage - 1);
+	}
+
+	template<typename T>
+	T& get(Array<T, kTransformsPerPage> Page::*member, U32 idx) const
+	{
+		return (getPage(idx).*member)[getPageOffset(idx)];
+	}
+
+	Bool isAlive(U32 idx) const
+	{
+		return idx < m_pageCount.load() * kTransformsPerPage && !!(get(&Page::m_flags, idx) & TransformFlag::kAlive);
+	}
+};
+/// @}
+
+} // end namespace anki
@@ -4,14 +4,102 @@
 // http://www.anki3d.org/LICENSE
 
 #include <AnKi/ShaderCompiler/Dxc.h>
+#include <AnKi/ShaderCompiler/ShaderCompilerCache.h>
 #include <AnKi/Util/Process.h>
 #include <AnKi/Util/Filesystem.h>
 #include <AnKi/Util/File.h>
 #include <AnKi/Util/HighRezTimer.h>
+#include <AnKi/Util/Thread.h>
+#if ANKI_OS_WINDOWS
+#	include <AnKi/Util/Win32Minimal.h>
+#elif ANKI_OS_LINUX
+#	include <dlfcn.h>
+#endif
 
 namespace anki {
 
+namespace {
+
+// A minimal subset of DXC's dxcapi.h. Only what's needed to compile from memory to memory. The interfaces need to match DXC's vtables
+
+using DxcHresult = I32;
+
+class DxcGuid
+{
+public:
+	U32 m_data1;
+	U16 m_data2;
+	U16 m_data3;
+	U8 m_data4[8];
+};
+
+inline constexpr DxcGuid kClsidDxcCompiler = {0x73e22d93, 0xe6ce, 0x47f3, {0xb5, 0xbf, 0xf0, 0x66, 0x4f, 0x39, 0xc1, 0xb0}};
+inline constexpr DxcGuid kIidIDxcCompiler3 = {0x228b4687, 0x5a6a, 0x4730, {0x90, 0x0c, 0x97, 0x02, 0xb2, 0x20, 0x3f, 0x54}};
+inline constexpr DxcGuid kIidIDxcOperationResult = {0xcedb484a, 0xd4e9, 0x445a, {0xb9, 0x91, 0xca, 0x21, 0xca, 0x15, 0x7d, 0xc2}};
+
+inline constexpr U32 kDxcCpUtf8 = 65001;
+
+class DxcBuffer
+{
+public:
+	const void* m_ptr;
+	PtrSize m_size;
+	U32 m_encoding;
+};
+
+class DxcIUnknown
+{
+public:
+	virtual DxcHresult queryInterface(const DxcGuid& iid, void** object) = 0;
+	virtual U32 addRef() = 0;
+	virtual U32 release() = 0;
+
+#if !ANKI_OS_WINDOWS
+	// DXC's IUnknown emulation has a virtual destructor outside Windows
+	virtual ~DxcIUnknown() = default;
+#endif
+};
+
+class DxcIDxcBlob : public DxcIUnknown
+{
+public:
+	virtual void* getBufferPointer() = 0;
+	virtual PtrSize getBufferSize() = 0;
+};
+
+class DxcIDxcOperationResult : public DxcIUnknown
+{
+public:
+	virtual DxcHresult getStatus(DxcHresult* status) = 0;
+	virtual DxcHresult getResult(DxcIDxcBlob** result) = 0;
+	virtual DxcHresult getErrorBuffer(DxcIDxcBlob** errors) = 0; ///< It's an IDxcBlobEncoding but only the IDxcBlob part is needed.
+};
+
+class DxcIDxcCompiler3 : public DxcIUnknown
+{
+public:
+	virtual DxcHresult compile(const DxcBuffer* source, const wchar_t** arguments, U32 argCount, void* includeHandler, const DxcGuid& iid,
+							   void** result) = 0;
+};
+
+using DxcCreateInstanceProc = DxcHresult (*)(const DxcGuid& clsid, const DxcGuid& iid, void** object);
+
+/// The loaded DXC library and a pool of compiler instances. A compiler instance is not thread-safe so every compilation takes one out of
+/// the pool. The instances get recycled by the threads of the ShaderProgramAsyncTaskInterface.
+class DxcLibrary
+{
+public:
+	void* m_handle = nullptr;
+	DxcCreateInstanceProc m_createInstance = nullptr;
+
+	Mutex m_mtx;
+	DynamicArray<DxcIDxcCompiler3*> m_freeCompilers;
+};
+
+} // namespace
+
 static Atomic<U32> g_nextFileId = {1};
+static DxcLibrary g_dxcLibrary;
 
 static CString profile(ShaderType shaderType)
 {
@@ -56,7 +144,58 @@ static CString profile(ShaderType shaderType)
 	return "";
 }
 
-Error compileHlslToSpirv(CString src, ShaderType shaderType, Bool compileWith16bitTypes, DynamicArray<U8>& spirv, String& errorMessage)
+static CString getDxcBinary()
+{
+#if ANKI_OS_WINDOWS
+	return ANKI_SOURCE_DIRECTORY "/ThirdParty/Bin/Windows64/dxc.exe";
+#elif ANKI_OS_LINUX
+	return ANKI_SOURCE_DIRECTORY "/ThirdParty/Bin/Linux64/dxc";
+#else
+	return "N/A";
+#endif
+}
+
+static CString getDxcLibraryFilename()
+{
+#if ANKI_OS_WINDOWS
+	return ANKI_SOURCE_DIRECTORY "/ThirdParty/Bin/Windows64/dxcompiler.dll";
+#elif ANKI_OS_LINUX
+	return ANKI_SOURCE_DIRECTORY "/ThirdParty/Bin/Linux64/libdxcompiler.so";
+#else
+	return "N/A";
+#endif
+}
+
+/// Get a hash of the DXC version. It's part of the keys of the ShaderCompilerCache. Asks DXC only once. The executable is a thin wrapper
+/// of the library that sits next to it so the hash is valid for both.
+static Error getDxcVersionHash(U64& hash)
+{
+	static Mutex mtx;
+	static U64 versionHash = 0;
+
+	LockGuard lock(mtx);
+
+	if(versionHash == 0)
+	{
+		Array<CString, 1> args = {"--version"};
+		String version;
+		I32 exitCode;
+		ANKI_CHECK(Process::callProcess(getDxcBinary(), args, &version, nullptr, exitCode));
+		if(exitCode != 0 || version.isEmpty())
+		{
+			ANKI_SHADER_COMPILER_LOGE("Failed to get the version of DXC");
+			return Error::kFunctionFailed;
+		}
+
+		versionHash = computeHash(version.cstr(), version.getLength());
+	}
+
+	hash = versionHash;
+	return Error::kNone;
+}
+
+/// Store the HLSL to a temp file and call the DXC executable.
+static Error compileWithExecutable(CString src, DynamicArray<String>& dxcArgs, DynamicArray<U8>& spirv, String& errorMessage)
 {
 	Array<U64, 3> toHash = {g_nextFileId.fetchAdd(1), getCurrentProcessId(), getRandom() & kMaxU32};
 	const U64 rand = computeHash(&toHash[0], sizeof(toHash));
@@ -78,33 +217,10 @@ Error compileHlslToSpirv(CString src, ShaderType shaderType, Bool compileWith16b
 	String spvFilename;
 	spvFilename.sprintf("%s/%" PRIu64 ".spv", tmpDir.cstr(), rand);
 
-	DynamicArray<String> dxcArgs;
 	dxcArgs.emplaceBack("-Fo");
 	dxcArgs.emplaceBack(spvFilename);
-	dxcArgs.emplaceBack("-Wall");
-	dxcArgs.emplaceBack("-Wextra");
-	dxcArgs.emplaceBack("-Wno-conversion");
-	dxcArgs.emplaceBack("-Werror");
-	dxcArgs.emplaceBack("-Wfatal-errors");
-	dxcArgs.emplaceBack("-Wundef");
-	dxcArgs.emplaceBack("-Wno-unused-const-variable");
-	dxcArgs.emplaceBack("-HV");
-	dxcArgs.emplaceBack("2021");
-	dxcArgs.emplaceBack("-E");
-	dxcArgs.emplaceBack("main");
-	dxcArgs.emplaceBack("-T");
-	dxcArgs.emplaceBack(profile(shaderType));
-	dxcArgs.emplaceBack("-spirv");
-	dxcArgs.emplaceBack("-fspv-target-env=vulkan1.1spirv1.4");
-	// dxcArgs.emplaceBack("-fvk-support-nonzero-base-instance"); // Match DX12's behavior, SV_INSTANCEID starts from zero
-	// dxcArgs.emplaceBack("-Zi"); // Debug info
 	dxcArgs.emplaceBack(hlslFilename);
 
-	if(compileWith16bitTypes)
-	{
-		dxcArgs.emplaceBack("-enable-16bit-types");
-	}
-
 	DynamicArray<CString> dxcArgs2;
 	dxcArgs2.resize(dxcArgs.getSize());
 	for(U32 i = 0; i < dxcArgs.getSize(); ++i)
@@ -117,13 +233,7 @@ Error compileHlslToSpirv(CString src, ShaderType shaderType, Bool compileWith16b
 		I32 exitCode;
 		String stdOut;
 
-#if ANKI_OS_WINDOWS
-		CString dxcBin = ANKI_SOURCE_DIRECTORY "/ThirdParty/Bin/Windows64/dxc.exe";
-#elif ANKI_OS_LINUX
-		CString dxcBin = ANKI_SOURCE_DIRECTORY "/ThirdParty/Bin/Linux64/dxc";
-#else
-		CString dxcBin = "N/A";
-#endif
+		const CString dxcBin = getDxcBinary();
 
 		// Run once without stdout or stderr. Because if you do the process library will crap out after a while
 		ANKI_CHECK(Process::callProcess(dxcBin, dxcArgs2, nullptr, nullptr, exitCode));
@@ -168,4 +278,246 @@ Error compileHlslToSpirv(CString src, ShaderType shaderType, Bool compileWith16b
 	return Error::kNone;
 }
 
+/// Compile using the DXC library.
+static Error compileInProcess(CString src, ConstWeakArray<String> dxcArgs, DynamicArray<U8>& spirv, String& errorMessage)
+{
+	// The library wants wide strings
+	DynamicArray<wchar_t> wideChars;
+	for(const String& arg : dxcArgs)
+	{
+		for(const Char c : arg)
+		{
+			wideChars.emplaceBack(wchar_t(c));
+		}
+		wideChars.emplaceBack(L'\0');
+	}
+
+	DynamicArray<const wchar_t*> wideArgs;
+	for(U32 i = 0, offset = 0; i < dxcArgs.getSize(); ++i)
+	{
+		wideArgs.emplaceBack(&wideChars[offset]);
+		offset += dxcArgs[i].getLength() + 1;
+	}
+
+	// Get a compiler from the pool or create a new one
+	DxcIDxcCompiler3* compiler = nullptr;
+	{
+		LockGuard lock(g_dxcLibrary.m_mtx);
+		if(!g_dxcLibrary.m_freeCompilers.isEmpty())
+		{
+			compiler = g_dxcLibrary.m_freeCompilers.getBack();
+			g_dxcLibrary.m_freeCompilers.popBack();
+		}
+	}
+
+	if(!compiler && g_dxcLibrary.m_createInstance(kClsidDxcCompiler, kIidIDxcCompiler3, reinterpret_cast<void**>(&compiler)) < 0)
+	{
+		ANKI_SHADER_COMPILER_LOGE("Failed to create a DXC compiler instance");
+		return Error::kFunctionFailed;
+	}
+
+	// Compile
+	const DxcBuffer srcBuffer = {src.cstr(), src.getLength(), kDxcCpUtf8};
+	DxcIDxcOperationResult* result = nullptr;
+	DxcHresult status = -1;
+	Error err = Error::kNone;
+	if(compiler->compile(&srcBuffer, &wideArgs[0], wideArgs.getSize(), nullptr, kIidIDxcOperationResult, reinterpret_cast<void**>(&result)) < 0
+	   || result->getStatus(&status) < 0)
+	{
+		errorMessage = "The DXC library failed to compile";
+		err = Error::kFunctionFailed;
+	}
+	else if(status < 0)
+	{
+		DxcIDxcBlob* errors = nullptr;
+		if(result->getErrorBuffer(&errors) >= 0 && errors && errors->getBufferSize() > 0)
+		{
+			const Char* first = static_cast<const Char*>(errors->getBufferPointer());
+			const Char* last = first;
+			while(last < first + errors->getBufferSize() && *last != '\0')
+			{
+				++last;
+			}
+			errorMessage = String(first, last);
+		}
+
+		if(errors)
+		{
+			errors->release();
+		}
+
+		if(errorMessage.isEmpty())
+		{
+			errorMessage = "Unknown error";
+		}
+		err = Error::kFunctionFailed;
+	}
+	else
+	{
+		DxcIDxcBlob* blob = nullptr;
+		if(result->getResult(&blob) < 0 || !blob || blob->getBufferSize() == 0)
+		{
+			errorMessage = "The DXC library returned no SPIR-V";
+			err = Error::kFunctionFailed;
+		}
+		else
+		{
+			spirv.resize(U32(blob->getBufferSize()));
+			memcpy(&spirv[0], blob->getBufferPointer(), spirv.getSizeInBytes());
+		}
+
+		if(blob)
+		{
+			blob->release();
+		}
+	}
+
+	if(result)
+	{
+		result->release();
+	}
+
+	// Give the compiler back to the pool
+	{
+		LockGuard lock(g_dxcLibrary.m_mtx);
+		g_dxcLibrary.m_freeCompilers.emplaceBack(compiler);
+	}
+
+	return err;
+}
+
+Error compileHlslToSpirv(CString src, ShaderType shaderType, Bool compileWith16bitTypes, DynamicArray<U8>& spirv, String& errorMessage)
+{
+	// The arguments that affect the output
+	DynamicArray<String> dxcArgs;
+	dxcArgs.emplaceBack("-Wall");
+	dxcArgs.emplaceBack("-Wextra");
+	dxcArgs.emplaceBack("-Wno-conversion");
+	dxcArgs.emplaceBack("-Werror");
+	dxcArgs.emplaceBack("-Wfatal-errors");
+	dxcArgs.emplaceBack("-Wundef");
+	dxcArgs.emplaceBack("-Wno-unused-const-variable");
+	dxcArgs.emplaceBack("-HV");
+	dxcArgs.emplaceBack("2021");
+	dxcArgs.emplaceBack("-E");
+	dxcArgs.emplaceBack("main");
+	dxcArgs.emplaceBack("-T");
+	dxcArgs.emplaceBack(profile(shaderType));
+	dxcArgs.emplaceBack("-spirv");
+	dxcArgs.emplaceBack("-fspv-target-env=vulkan1.1spirv1.4");
+	// dxcArgs.emplaceBack("-fvk-support-nonzero-base-instance"); // Match DX12's behavior, SV_INSTANCEID starts from zero
+	// dxcArgs.emplaceBack("-Zi"); // Debug info
+
+	if(compileWith16bitTypes)
+	{
+		dxcArgs.emplaceBack("-enable-16bit-types");
+	}
+
+	// Try the cache first. The source is already preprocessed so the key captures the includes as well
+	U64 cacheKey = 0;
+	if(ShaderCompilerCache::isAllocated())
+	{
+		ANKI_CHECK(getDxcVersionHash(cacheKey));
+		cacheKey = appendHash(src.cstr(), src.getLength(), cacheKey);
+		for(const String& arg : dxcArgs)
+		{
+			cacheKey = appendHash(arg.cstr(), arg.getLength() + 1, cacheKey);
+		}
+
+		if(ShaderCompilerCache::getSingleton().find(cacheKey, spirv))
+		{
+			return Error::kNone;
+		}
+	}
+
+	if(isDxcLibraryInitialized())
+	{
+		ANKI_CHECK(compileInProcess(src, dxcArgs, spirv, errorMessage));
+	}
+	else
+	{
+		ANKI_CHECK(compileWithExecutable(src, dxcArgs, spirv, errorMessage));
+	}
+
+	if(ShaderCompilerCache::isAllocated())
+	{
+		ShaderCompilerCache::getSingleton().store(cacheKey, spirv);
+	}
+
+	return Error::kNone;
+}
+
+Error initDxcLibrary()
+{
+	ANKI_ASSERT(!isDxcLibraryInitialized());
+	const CString fname = getDxcLibraryFilename();
+
+	void* handle = nullptr;
+	void* createInstance = nullptr;
+#if ANKI_OS_WINDOWS
+	HMODULE module = LoadLibraryA(fname.cstr());
+	if(module)
+	{
+		handle = module;
+		createInstance = reinterpret_cast<void*>(GetProcAddress(module, "DxcCreateInstance"));
+	}
+#elif ANKI_OS_LINUX
+	handle = dlopen(fname.cstr(), RTLD_NOW | RTLD_LOCAL);
+	if(handle)
+	{
+		createInstance = dlsym(handle, "DxcCreateInstance");
+	}
+#endif
+
+	if(!handle)
+	{
+		ANKI_SHADER_COMPILER_LOGW("Failed to load the DXC library. Will use the executable: %s", fname.cstr());
+		return Error::kFunctionFailed;
+	}
+
+	if(!createInstance)
+	{
+		ANKI_SHADER_COMPILER_LOGW("DxcCreateInstance() not found. Will use the executable: %s", fname.cstr());
+#if ANKI_OS_WINDOWS
+		FreeLibrary(static_cast<HMODULE>(handle));
+#elif ANKI_OS_LINUX
+		dlclose(handle);
+#endif
+		return Error::kFunctionFailed;
+	}
+
+	g_dxcLibrary.m_handle = handle;
+	g_dxcLibrary.m_createInstance = reinterpret_cast<DxcCreateInstanceProc>(createInstance);
+	ANKI_SHADER_COMPILER_LOGV("Loaded the DXC library: %s", fname.cstr());
+	return Error::kNone;
+}
+
+void shutdownDxcLibrary()
+{
+	if(!isDxcLibraryInitialized())
+	{
+		return;
+	}
+
+	for(DxcIDxcCompiler3* compiler : g_dxcLibrary.m_freeCompilers)
+	{
+		compiler->release();
+	}
+	g_dxcLibrary.m_freeCompilers.destroy();
+
+#if ANKI_OS_WINDOWS
+	FreeLibrary(static_cast<HMODULE>(g_dxcLibrary.m_handle));
+#elif ANKI_OS_LINUX
+	dlclose(g_dxcLibrary.m_handle);
+#endif
+
+	g_dxcLibrary.m_handle = nullptr;
+	g_dxcLibrary.m_createInstance = nullptr;
+}
+
+Bool isDxcLibraryInitialized()
+{
+	return g_dxcLibrary.m_handle != nullptr;
+}
+
 } // end namespace anki
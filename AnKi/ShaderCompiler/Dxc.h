@@ -13,8 +13,21 @@ namespace anki {
 /// @addtogroup shader_compiler
 /// @{
 
-/// Compile HLSL to SPIR-V.
+/// Compile HLSL to SPIR-V. It uses the DXC library if initDxcLibrary() succeeded or it calls the DXC executable otherwise.
+/// @note It's thread-safe.
 Error compileHlslToSpirv(CString src, ShaderType shaderType, Bool compileWith16bitTypes, DynamicArray<U8>& spirv, String& errorMessage);
+
+/// Load the DXC shared library and compile in-process from now on. It saves the process creation and the temporary files of every
+/// compilation. If it fails compileHlslToSpirv() will keep calling the DXC executable.
+/// @note It's not thread-safe. Call it before any compilation.
+Error initDxcLibrary();
+
+/// Unload the DXC library. compileHlslToSpirv() will call the DXC executable from now on.
+/// @note It's not thread-safe. Call it after all compilations have finished.
+void shutdownDxcLibrary();
+
+/// Check if initDxcLibrary() has succeeded.
+Bool isDxcLibraryInitialized();
 /// @}
 
 } // end namespace anki
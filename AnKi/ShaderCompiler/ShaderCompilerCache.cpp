@@ -0,0 +1,204 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/ShaderCompiler/ShaderCompilerCache.h>
+#include <AnKi/Util/Filesystem.h>
+#include <AnKi/Util/File.h>
+#include <AnKi/Util/Process.h>
+#include <AnKi/Util/Functions.h>
+#include <AnKi/Util/Hash.h>
+#include <algorithm>
+#include <cstdio>
+
+namespace anki {
+
+inline constexpr const char* kShaderCompilerCacheEntryMagic = "ANKISCC1";
+
+/// The header of the entry files. The binary follows.
+class ShaderCompilerCacheEntryHeader
+{
+public:
+	Array<U8, 8> m_magic;
+	U64 m_key;
+	U64 m_binaryHash;
+	U64 m_binarySize;
+};
+
+ShaderCompilerCache::~ShaderCompilerCache()
+{
+	// Only this process' entries can make the cache grow
+	if(m_storeCount.load() > 0 && evict())
+	{
+		ANKI_SHADER_COMPILER_LOGW("Shader cache eviction failed");
+	}
+}
+
+Error ShaderCompilerCache::init(CString directory, PtrSize maxSize)
+{
+	ANKI_ASSERT(!directory.isEmpty() && maxSize > 0);
+	m_dir = directory;
+	m_maxSize = maxSize;
+
+	if(!directoryExists(m_dir))
+	{
+		// Another process might create it at the same time
+		if(createDirectory(m_dir) && !directoryExists(m_dir))
+		{
+			ANKI_SHADER_COMPILER_LOGE("Failed to create the shader cache directory: %s", m_dir.cstr());
+			return Error::kFunctionFailed;
+		}
+	}
+
+	return Error::kNone;
+}
+
+void ShaderCompilerCache::getEntryFilename(U64 key, String& fname) const
+{
+	fname.sprintf("%s/%016" PRIx64 ".spv", m_dir.cstr(), key);
+}
+
+Bool ShaderCompilerCache::find(U64 key, DynamicArray<U8>& binary)
+{
+	String fname;
+	getEntryFilename(key, fname);
+
+	Bool found = false;
+	File file;
+	if(fileExists(fname) && !file.open(fname, FileOpenFlag::kRead | FileOpenFlag::kBinary))
+	{
+		ShaderCompilerCacheEntryHeader header;
+		if(file.getSize() > sizeof(header) && !file.read(&header, sizeof(header))
+		   && memcmp(&header.m_magic[0], kShaderCompilerCacheEntryMagic, 8) == 0 && header.m_key == key
+		   && header.m_binarySize == file.getSize() - sizeof(header))
+		{
+			binary.resize(U32(header.m_binarySize));
+			found = !file.read(&binary[0], binary.getSizeInBytes()) && computeHash(&binary[0], binary.getSizeInBytes()) == header.m_binaryHash;
+		}
+
+		if(!found)
+		{
+			ANKI_SHADER_COMPILER_LOGW("Ignoring corrupted shader cache entry: %s", fname.cstr());
+		}
+	}
+
+	if(found)
+	{
+		m_hitCount.fetchAdd(1);
+	}
+	else
+	{
+		binary.destroy();
+		m_missCount.fetchAdd(1);
+	}
+
+	return found;
+}
+
+void ShaderCompilerCache::store(U64 key, ConstWeakArray<U8> binary)
+{
+	ANKI_ASSERT(binary.getSize() > 0);
+
+	// Write to a file with a unique name first
+	String fname;
+	getEntryFilename(key, fname);
+	String tmpFname;
+	tmpFname.sprintf("%s.%u.%u.tmp", fname.cstr(), getCurrentProcessId(), m_storeCount.fetchAdd(1));
+
+	ShaderCompilerCacheEntryHeader header;
+	memcpy(&header.m_magic[0], kShaderCompilerCacheEntryMagic, 8);
+	header.m_key = key;
+	header.m_binaryHash = computeHash(binary.getBegin(), binary.getSizeInBytes());
+	header.m_binarySize = binary.getSizeInBytes();
+
+	auto writeEntry = [&]() -> Error {
+		File file;
+		ANKI_CHECK(file.open(tmpFname, FileOpenFlag::kWrite | FileOpenFlag::kBinary));
+		ANKI_CHECK(file.write(&header, sizeof(header)));
+		ANKI_CHECK(file.write(binary.getBegin(), binary.getSizeInBytes()));
+		return Error::kNone;
+	};
+	const Error err = writeEntry();
+
+	// Then rename it. The rename is atomic so readers will see the whole entry or nothing. It might fail if some other process stored
+	// the same entry first (on Windows), that's fine
+	if(err || std::rename(tmpFname.cstr(), fname.cstr()) != 0)
+	{
+		if(fileExists(tmpFname))
+		{
+			[[maybe_unused]] const Error err2 = removeFile(tmpFname);
+		}
+	}
+
+	if(err)
+	{
+		ANKI_SHADER_COMPILER_LOGW("Failed to store shader cache entry: %s", fname.cstr());
+	}
+}
+
+Error ShaderCompilerCache::evict()
+{
+	class Entry
+	{
+	public:
+		String m_fname;
+		U64 m_time;
+		PtrSize m_size;
+	};
+
+	DynamicArray<Entry> entries;
+	PtrSize totalSize = 0;
+	ANKI_CHECK(walkDirectoryTree(m_dir, [&](CString path, Bool isDir) -> Error {
+		String ext;
+		getFilepathExtension(path, ext);
+		if(isDir || ext != "spv")
+		{
+			return Error::kNone;
+		}
+
+		Entry& entry = *entries.emplaceBack();
+		entry.m_fname.sprintf("%s/%s", m_dir.cstr(), path.cstr());
+
+		// Other processes might evict at the same time so ignore missing entries
+		File file;
+		U32 year = 0, month = 0, day = 0, hour = 0, min = 0, second = 0;
+		if(file.open(entry.m_fname, FileOpenFlag::kRead | FileOpenFlag::kBinary)
+		   || getFileModificationTime(entry.m_fname, year, month, day, hour, min, second))
+		{
+			entries.popBack();
+			return Error::kNone;
+		}
+
+		entry.m_size = file.getSize();
+		entry.m_time = ((((U64(year) * 12 + month) * 31 + day) * 24 + hour) * 60 + min) * 60 + second;
+		totalSize += entry.m_size;
+		return Error::kNone;
+	}));
+
+	if(totalSize <= m_maxSize)
+	{
+		return Error::kNone;
+	}
+
+	// Evict the oldest first
+	std::sort(entries.getBegin(), entries.getEnd(), [](const Entry& a, const Entry& b) {
+		return a.m_time < b.m_time;
+	});
+
+	U32 evictedCount = 0;
+	for(U32 i = 0; i < entries.getSize() && totalSize > m_maxSize; ++i)
+	{
+		if(fileExists(entries[i].m_fname) && !removeFile(entries[i].m_fname))
+		{
+			++evictedCount;
+		}
+
+		totalSize -= entries[i].m_size;
+	}
+
+	ANKI_SHADER_COMPILER_LOGV("Evicted %u shader cache entries", evictedCount);
+	return Error::kNone;
+}
+
+} // end namespace anki
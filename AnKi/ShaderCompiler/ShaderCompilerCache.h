@@ -0,0 +1,74 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/ShaderCompiler/Common.h>
+#include <AnKi/Util/Singleton.h>
+#include <AnKi/Util/WeakArray.h>
+#include <AnKi/Util/Atomic.h>
+
+namespace anki {
+
+/// @addtogroup shader_compiler
+/// @{
+
+/// A persistent cache of compiled shaders that lives in a directory. Every entry is a file named after its key. The key is a hash of
+/// everything that affects the compilation: The preprocessed source, the compiler flags and the compiler version. The cache can be
+/// accessed by many threads and many processes at the same time. The entries are written to temporary files that get renamed once
+/// they are complete so a reader never sees half-written entries.
+class ShaderCompilerCache : public MakeSingleton<ShaderCompilerCache>
+{
+	template<typename>
+	friend class MakeSingleton;
+
+public:
+	ShaderCompilerCache(const ShaderCompilerCache&) = delete; // Non-copyable
+
+	ShaderCompilerCache& operator=(const ShaderCompilerCache&) = delete; // Non-copyable
+
+	/// @param directory The directory of the cache. It will be created if it doesn't exist.
+	/// @param maxSize The max size of all the entries. If it's exceeded the oldest entries get evicted.
+	Error init(CString directory, PtrSize maxSize);
+
+	/// Find an entry.
+	/// @note It's thread-safe.
+	Bool find(U64 key, DynamicArray<U8>& binary);
+
+	/// Store an entry. Failing to store isn't fatal, the entry will be missing from the cache.
+	/// @note It's thread-safe.
+	void store(U64 key, ConstWeakArray<U8> binary);
+
+	U32 getHitCount() const
+	{
+		return m_hitCount.load();
+	}
+
+	U32 getMissCount() const
+	{
+		return m_missCount.load();
+	}
+
+private:
+	String m_dir;
+	PtrSize m_maxSize = 0;
+
+	Atomic<U32> m_hitCount = {0};
+	Atomic<U32> m_missCount = {0};
+	Atomic<U32> m_storeCount = {0};
+
+	ShaderCompilerCache() = default;
+
+	/// Evicts entries if needed.
+	~ShaderCompilerCache();
+
+	void getEntryFilename(U64 key, String& fname) const;
+
+	/// Remove the oldest entries until the size of the cache drops under the max size.
+	Error evict();
+};
+/// @}
+
+} // end namespace anki
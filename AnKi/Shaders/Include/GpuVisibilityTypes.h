@@ -16,7 +16,7 @@ struct FrustumGpuVisibilityConstants
 	Vec4 m_maxLodDistances;
 
 	Vec3 m_lodReferencePoint;
-	F32 m_padding3;
+	U32 m_cpuOccludedRenderableWordCount; ///< The size of the bitset of the renderables the CPU occlusion culling found occluded.
 
 	Mat4 m_viewProjectionMat;
 };
@@ -75,6 +75,27 @@ inline constexpr Array<Format, U32(VertexStreamId::kParticleRelatedCount)> kPart
 	Format::kR32_Sfloat,       Format::kR32_Sfloat,       Format::kR32G32B32_Sfloat};
 #endif
 
+constexpr U32 kMaxVerticesPerMeshlet = 64u;
+constexpr U32 kMaxPrimitivesPerMeshlet = 124u;
+
+/// A small cluster of the triangles of a mesh LOD. Same layout as the MeshBinaryMeshlet.
+struct Meshlet
+{
+	U32 m_firstPrimitive; ///< Points to the primitives of the LOD. A primitive is 3 U8 indices to the vertices of the meshlet.
+	U32 m_firstVertex; ///< Points to the meshlet vertices of the LOD. A meshlet vertex is a U16 index to the vertex buffers of the LOD.
+	U32 m_primitiveCount;
+	U32 m_vertexCount;
+
+	Vec3 m_sphereCenter;
+	F32 m_sphereRadius;
+
+	Vec3 m_coneApex;
+	F32 m_coneCutoff; ///< cos(angle/2) of the normal cone. If it's 1.0 the meshlet can't be backface culled.
+
+	Vec3 m_coneAxis;
+	F32 m_padding;
+};
+
 struct UnpackedMeshVertex
 {
 	Vec3 m_position;
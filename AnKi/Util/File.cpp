@@ -15,6 +15,11 @@
 #endif
 #if ANKI_POSIX
 #	include <sys/stat.h>
+#	include <sys/mman.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#else
+#	include <AnKi/Util/Win32Minimal.h>
 #endif
 
 namespace anki {
@@ -458,4 +463,93 @@ FileOpenFlag File::getMachineEndianness()
 	}
 }
 
+Error MemoryMappedFile::open(const CString& filename)
+{
+	ANKI_ASSERT(!isOpen());
+
+#if ANKI_POSIX
+	const int fd = ::open(filename.cstr(), O_RDONLY);
+	if(fd < 0)
+	{
+		ANKI_UTIL_LOGE("open() failed: %s", filename.cstr());
+		return Error::kFileAccess;
+	}
+
+	struct stat stbuf;
+	if(fstat(fd, &stbuf) != 0 || !S_ISREG(stbuf.st_mode) || stbuf.st_size == 0)
+	{
+		ANKI_UTIL_LOGE("fstat() failed or the file is empty: %s", filename.cstr());
+		::close(fd);
+		return Error::kFileAccess;
+	}
+
+	void* data = mmap(nullptr, PtrSize(stbuf.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // The mapping keeps a reference to the file
+	if(data == MAP_FAILED)
+	{
+		ANKI_UTIL_LOGE("mmap() failed: %s", filename.cstr());
+		return Error::kFileAccess;
+	}
+
+	m_data = static_cast<const U8*>(data);
+	m_size = PtrSize(stbuf.st_size);
+#else
+	HANDLE file = CreateFileA(filename.cstr(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		ANKI_UTIL_LOGE("CreateFileA() failed: %s", filename.cstr());
+		return Error::kFileAccess;
+	}
+
+	DWORD sizeHigh = 0;
+	const DWORD sizeLow = GetFileSize(file, &sizeHigh);
+	const PtrSize size = (PtrSize(sizeHigh) << 32) | sizeLow;
+	if(sizeLow == INVALID_FILE_SIZE || size == 0)
+	{
+		ANKI_UTIL_LOGE("GetFileSize() failed or the file is empty: %s", filename.cstr());
+		CloseHandle(file);
+		return Error::kFileAccess;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void* data = (mapping) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if(data == nullptr)
+	{
+		ANKI_UTIL_LOGE("Failed to map file: %s", filename.cstr());
+		if(mapping)
+		{
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		return Error::kFileAccess;
+	}
+
+	m_data = static_cast<const U8*>(data);
+	m_size = size;
+	m_handles = {file, mapping};
+#endif
+
+	return Error::kNone;
+}
+
+void MemoryMappedFile::close()
+{
+	if(m_data == nullptr)
+	{
+		return;
+	}
+
+#if ANKI_POSIX
+	munmap(const_cast<U8*>(m_data), m_size);
+#else
+	UnmapViewOfFile(m_data);
+	CloseHandle(m_handles[1]);
+	CloseHandle(m_handles[0]);
+	m_handles = {};
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+}
+
 } // end namespace anki
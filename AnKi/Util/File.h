@@ -7,6 +7,7 @@
 
 #include <AnKi/Util/String.h>
 #include <AnKi/Util/Enum.h>
+#include <AnKi/Util/Array.h>
 #include <cstdio>
 
 namespace anki {
@@ -159,6 +160,67 @@ private:
 		m_size = 0;
 	}
 };
+
+/// A read-only file that is mapped to memory.
+class MemoryMappedFile
+{
+public:
+	MemoryMappedFile() = default;
+
+	MemoryMappedFile(const MemoryMappedFile&) = delete; // Non-copyable
+
+	MemoryMappedFile(MemoryMappedFile&& b)
+	{
+		*this = std::move(b);
+	}
+
+	/// Unmaps the file.
+	~MemoryMappedFile()
+	{
+		close();
+	}
+
+	MemoryMappedFile& operator=(const MemoryMappedFile&) = delete; // Non-copyable
+
+	MemoryMappedFile& operator=(MemoryMappedFile&& b)
+	{
+		close();
+		m_data = b.m_data;
+		m_size = b.m_size;
+		m_handles = b.m_handles;
+		b.m_data = nullptr;
+		b.m_size = 0;
+		b.m_handles = {};
+		return *this;
+	}
+
+	/// Map a whole file.
+	Error open(const CString& filename);
+
+	void close();
+
+	Bool isOpen() const
+	{
+		return m_data != nullptr;
+	}
+
+	const U8* getData() const
+	{
+		ANKI_ASSERT(isOpen());
+		return m_data;
+	}
+
+	PtrSize getSize() const
+	{
+		ANKI_ASSERT(isOpen());
+		return m_size;
+	}
+
+private:
+	const U8* m_data = nullptr;
+	PtrSize m_size = 0;
+	Array<void*, 2> m_handles = {}; ///< The file and mapping handles in Windows.
+};
 /// @}
 
 } // end namespace anki
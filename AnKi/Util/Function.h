@@ -145,6 +145,12 @@ public:
 		m_state = kStateUninitialized;
 	}
 
+	/// Return true if it doesn't hold a callable.
+	Bool isEmpty() const
+	{
+		return getState() == kStateUninitialized;
+	}
+
 	/// Call the Function with some arguments.
 	TReturn call(TArgs... args) const
 	{
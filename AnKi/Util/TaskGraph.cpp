@@ -0,0 +1,192 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Util/TaskGraph.h>
+
+namespace anki {
+
+/// Holds the user function of a parallel-for. All the batches share it.
+class TaskGraph::ParallelForContext
+{
+public:
+	ParallelForFunc m_func;
+};
+
+TaskGraph::TaskGraph(ThreadJobManager& manager)
+	: m_manager(&manager)
+{
+	init();
+}
+
+TaskGraph::TaskGraph(U32 threadCount, Bool pinToCores)
+{
+	m_ownedManager.init(threadCount, pinToCores);
+	m_manager = m_ownedManager.get();
+	m_ownsManager = true;
+	init();
+}
+
+TaskGraph::~TaskGraph()
+{
+	waitAllTasks();
+
+	if(m_ownsManager)
+	{
+		m_ownedManager.destroy();
+	}
+}
+
+void TaskGraph::init()
+{
+	m_pool.init(allocAligned, nullptr, 4_KB, 2.0, 0, true, ANKI_SAFE_ALIGNMENT, "TaskGraph");
+}
+
+TaskGraphTask* TaskGraph::newTask(const Func& func)
+{
+	TaskGraphTask* task = ::new(m_pool.allocate(sizeof(TaskGraphTask), alignof(TaskGraphTask))) TaskGraphTask();
+	task->m_func = func;
+	task->m_hasFunc = !func.isEmpty();
+	if(task->m_hasFunc)
+	{
+		m_unfinishedTaskCount.fetchAdd(1);
+	}
+	return task;
+}
+
+void TaskGraph::addDependency(TaskGraphTask& before, TaskGraphTask& after)
+{
+	ANKI_ASSERT(&before != &after);
+	after.m_pendingDependencyCount.fetchAdd(1);
+
+	Bool beforeFinished;
+	{
+		LockGuard lock(before.m_successorsLock);
+		beforeFinished = before.m_finished;
+		if(!beforeFinished)
+		{
+			TaskGraphTask::Edge* edge = static_cast<TaskGraphTask::Edge*>(m_pool.allocate(sizeof(TaskGraphTask::Edge), alignof(TaskGraphTask::Edge)));
+			edge->m_successor = &after;
+			edge->m_next = before.m_successors;
+			before.m_successors = edge;
+		}
+	}
+
+	if(beforeFinished)
+	{
+		// Too late, the dependency is already satisfied
+		releaseDependency(after);
+	}
+}
+
+TaskGraphTask* TaskGraph::newContinuation(TaskGraphTask& task, const Func& func)
+{
+	TaskGraphTask* continuation = newTask(func);
+	addDependency(task, *continuation);
+	submitTask(*continuation);
+	return continuation;
+}
+
+TaskGraphTask* TaskGraph::newParallelFor(U32 count, U32 batchSize, const ParallelForFunc& func, TaskGraphTask* dependency)
+{
+	ANKI_ASSERT(batchSize > 0);
+
+	ParallelForContext* ctx = newInstance<ParallelForContext>(m_pool);
+	ctx->m_func = func;
+
+	// The join task destroys the context when all batches are done
+	TaskGraphTask* join = newTask([ctx]([[maybe_unused]] U32 threadId) {
+		ctx->m_func.destroy();
+	});
+
+	for(U32 begin = 0; begin < count; begin += batchSize)
+	{
+		const U32 end = min(count, begin + batchSize);
+		TaskGraphTask* batch = newTask([ctx, begin, end](U32 threadId) {
+			ctx->m_func(begin, end, threadId);
+		});
+
+		if(dependency)
+		{
+			addDependency(*dependency, *batch);
+		}
+
+		addDependency(*batch, *join);
+		submitTask(*batch);
+	}
+
+	if(count == 0 && dependency)
+	{
+		addDependency(*dependency, *join);
+	}
+
+	submitTask(*join);
+	return join;
+}
+
+void TaskGraph::releaseDependency(TaskGraphTask& task)
+{
+	const U32 prev = task.m_pendingDependencyCount.fetchSub(1);
+	ANKI_ASSERT(prev > 0);
+	if(prev == 1)
+	{
+		dispatch(task);
+	}
+}
+
+void TaskGraph::dispatch(TaskGraphTask& task)
+{
+	if(!task.m_hasFunc)
+	{
+		// Join node, no need to go through the job manager
+		finishTask(task);
+		return;
+	}
+
+	TaskGraphTask* pTask = &task;
+	m_manager->dispatchTask(
+		[this, pTask](U32 threadId) {
+			pTask->m_func(threadId);
+			pTask->m_func.destroy();
+			finishTask(*pTask);
+		},
+		&m_counter);
+}
+
+void TaskGraph::finishTask(TaskGraphTask& task)
+{
+	TaskGraphTask::Edge* edge;
+	{
+		LockGuard lock(task.m_successorsLock);
+		ANKI_ASSERT(!task.m_finished);
+		task.m_finished = true;
+		edge = task.m_successors;
+		task.m_successors = nullptr;
+	}
+
+	// The successors might be the last thing the counter waits for so release them before marking this one as done
+	while(edge)
+	{
+		TaskGraphTask::Edge* next = edge->m_next;
+		releaseDependency(*edge->m_successor);
+		edge = next;
+	}
+
+	if(task.m_hasFunc)
+	{
+		[[maybe_unused]] const U32 prev = m_unfinishedTaskCount.fetchSub(1);
+		ANKI_ASSERT(prev > 0);
+	}
+}
+
+void TaskGraph::waitAllTasks()
+{
+	m_manager->waitForCounter(m_counter);
+
+	// All the dispatched tasks are done. If something remains it was never submitted. Join tasks are allowed to remain pending
+	ANKI_ASSERT(m_unfinishedTaskCount.load() == 0 && "Some tasks were never submitted or some dependencies never resolved");
+	m_pool.reset();
+}
+
+} // end namespace anki
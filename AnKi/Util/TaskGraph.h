@@ -0,0 +1,176 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Util/ThreadJobManager.h>
+#include <AnKi/Util/MemoryPool.h>
+#include <AnKi/Util/ClassWrapper.h>
+
+namespace anki {
+
+// Forward
+class TaskGraph;
+
+/// @addtogroup util_thread
+/// @{
+
+/// A node of the TaskGraph. It's opaque and it's allocated by the TaskGraph. @memberof TaskGraph
+class TaskGraphTask
+{
+	friend class TaskGraph;
+
+public:
+	TaskGraphTask(const TaskGraphTask&) = delete; // Non-copyable
+
+	TaskGraphTask& operator=(const TaskGraphTask&) = delete; // Non-copyable
+
+private:
+	/// An edge to a successor.
+	class Edge
+	{
+	public:
+		Edge* m_next;
+		TaskGraphTask* m_successor;
+	};
+
+	Function<void(U32)> m_func;
+
+	/// The task will be dispatched when this reaches zero. It starts from one and that one is removed on submission.
+	Atomic<U32> m_pendingDependencyCount = {1};
+
+	SpinLock m_successorsLock;
+	Edge* m_successors = nullptr; ///< Protected by m_successorsLock.
+	Bool m_finished = false; ///< Protected by m_successorsLock.
+	Bool m_hasFunc = false;
+
+	TaskGraphTask() = default;
+};
+
+/// Task-graph runtime on top of ThreadJobManager. Tasks have explicit edges (dependencies), can get continuations at any time and
+/// they can be used to build parallel-for loops. Many TaskGraphs (and the ThreadHive and the ThreadPool that are built on top of
+/// the TaskGraph) can share the workers of a single ThreadJobManager.
+/// @code
+/// TaskGraphTask* a = graph.newTask(...);
+/// TaskGraphTask* b = graph.newTask(...);
+/// graph.addDependency(*a, *b); // b will run after a
+/// graph.submitTask(*a);
+/// graph.submitTask(*b);
+/// graph.newContinuation(*b, ...); // Will run after b
+/// graph.waitAllTasks();
+/// @endcode
+class TaskGraph
+{
+public:
+	using Func = Function<void(U32 threadId)>;
+	using ParallelForFunc = Function<void(U32 begin, U32 end, U32 threadId)>;
+
+	/// Create a graph that uses the workers of an existing ThreadJobManager.
+	explicit TaskGraph(ThreadJobManager& manager);
+
+	/// Create a graph that has its own workers.
+	TaskGraph(U32 threadCount, Bool pinToCores = false);
+
+	TaskGraph(const TaskGraph&) = delete; // Non-copyable
+
+	~TaskGraph();
+
+	TaskGraph& operator=(const TaskGraph&) = delete; // Non-copyable
+
+	ThreadJobManager& getJobManager()
+	{
+		return *m_manager;
+	}
+
+	/// @copydoc ThreadJobManager::getThreadCount
+	U32 getThreadCount() const
+	{
+		return m_manager->getThreadCount();
+	}
+
+	/// Create a new task. It will not run before submitTask() is called and all its dependencies are done.
+	/// @note It's thread-safe.
+	/// @param func The work. Can be empty and then the task acts as a join node.
+	TaskGraphTask* newTask(const Func& func = {});
+
+	/// Add an edge. The @a after task will run after the @a before task finishes. The @a after task shouldn't have started.
+	/// @note It's thread-safe.
+	void addDependency(TaskGraphTask& before, TaskGraphTask& after);
+
+	/// Add dependencies that will be resolved manually with resolveManualDependency().
+	/// @note It's thread-safe.
+	/// @return False if all the dependencies of the task have already been resolved. A task can't be re-armed so nothing is added then.
+	Bool addManualDependencies(TaskGraphTask& task, U32 count)
+	{
+		ANKI_ASSERT(count > 0);
+		U32 crnt = task.m_pendingDependencyCount.load();
+		do
+		{
+			if(crnt == 0)
+			{
+				// It's been dispatched (or it's about to be). Adding to it would dispatch it a second time
+				return false;
+			}
+		} while(!task.m_pendingDependencyCount.compareExchange(crnt, crnt + count));
+
+		return true;
+	}
+
+	/// Resolve one dependency that was added with addManualDependencies().
+	/// @note It's thread-safe.
+	void resolveManualDependency(TaskGraphTask& task)
+	{
+		releaseDependency(task);
+	}
+
+	/// Allow the task to run when its dependencies are done. Every task that is created needs to be submitted once.
+	/// @note It's thread-safe.
+	void submitTask(TaskGraphTask& task)
+	{
+		releaseDependency(task);
+	}
+
+	/// Create and submit a task that will run after @a task finishes. It can be called at any time, even after @a task finished
+	/// or from inside the @a task.
+	/// @note It's thread-safe.
+	TaskGraphTask* newContinuation(TaskGraphTask& task, const Func& func);
+
+	/// Split the range [0, count) in batches and run func for each batch in parallel. Everything is submitted.
+	/// @param count The number of elements.
+	/// @param batchSize The number of elements per batch.
+	/// @param func Will be called for each batch.
+	/// @param dependency Optional task that the batches will wait for.
+	/// @return A task that finishes when all the batches finish. Use it to add continuations.
+	TaskGraphTask* newParallelFor(U32 count, U32 batchSize, const ParallelForFunc& func, TaskGraphTask* dependency = nullptr);
+
+	/// Wait for all the submitted tasks to finish. The calling thread will execute tasks while it waits. After that call all the
+	/// TaskGraphTask pointers are invalid.
+	void waitAllTasks();
+
+private:
+	class ParallelForContext;
+
+	ThreadJobManager* m_manager = nullptr;
+	ClassWrapper<ThreadJobManager> m_ownedManager;
+	Bool m_ownsManager = false;
+
+	StackMemoryPool m_pool;
+
+	ThreadJobCounter m_counter;
+
+	/// Tasks (excluding join tasks) that have been created but didn't finish.
+	Atomic<U32> m_unfinishedTaskCount = {0};
+
+	void init();
+
+	void releaseDependency(TaskGraphTask& task);
+
+	void dispatch(TaskGraphTask& task);
+
+	void finishTask(TaskGraphTask& task);
+};
+/// @}
+
+} // end namespace anki
@@ -5,9 +5,10 @@
 
 #pragma once
 
-#include <AnKi/Util/Thread.h>
+#include <AnKi/Util/TaskGraph.h>
 #include <AnKi/Util/WeakArray.h>
 #include <AnKi/Util/MemoryPool.h>
+#include <AnKi/Util/Logger.h>
 
 namespace anki {
 
@@ -17,7 +18,7 @@ class ThreadHive;
 /// @addtogroup util_thread
 /// @{
 
-/// Opaque handle that defines a ThreadHive depedency. @memberof ThreadHive
+/// Opaque handle that defines a ThreadHive depedency. Internally it's a join TaskGraphTask. @memberof ThreadHive
 class ThreadHiveSemaphore
 {
 	friend class ThreadHive;
@@ -25,13 +26,21 @@ class ThreadHiveSemaphore
 public:
 	/// Increase the value of the semaphore. It's easy to brake things with that.
 	/// @note It's thread-safe.
-	void increaseSemaphore(U32 increase)
+	/// @return Error if the semaphore has already reached zero. The tasks that wait on it have been released and it can't be re-armed.
+	Error increaseSemaphore(U32 increase)
 	{
-		m_atomic.fetchAdd(increase);
+		if(!m_graph->addManualDependencies(*m_task, increase))
+		{
+			ANKI_UTIL_LOGE("Can't increase a semaphore that has already reached zero");
+			return Error::kFunctionFailed;
+		}
+
+		return Error::kNone;
 	}
 
 private:
-	Atomic<U32> m_atomic;
+	TaskGraph* m_graph;
+	TaskGraphTask* m_task;
 
 	// No need to construct it or delete it
 	ThreadHiveSemaphore() = delete;
@@ -71,35 +80,33 @@ public:
 	}
 
 /// A scheduler of small tasks. It takes a number of tasks and schedules them in one of the threads. The tasks can
-/// depend on previously submitted tasks or be completely independent.
+/// depend on previously submitted tasks or be completely independent. It's a thin layer on top of the TaskGraph.
 class ThreadHive
 {
 public:
 	static constexpr U32 kMaxThreads = 32;
 
-	/// Create the hive.
+	/// Create the hive with its own threads.
 	ThreadHive(U32 threadCount, Bool pinToCores = false);
 
+	/// Create the hive on top of the workers of an existing ThreadJobManager.
+	explicit ThreadHive(ThreadJobManager& manager);
+
 	ThreadHive(const ThreadHive&) = delete; // Non-copyable
 
 	~ThreadHive();
 
 	ThreadHive& operator=(const ThreadHive&) = delete; // Non-copyable
 
+	/// @copydoc ThreadJobManager::getThreadCount
 	U32 getThreadCount() const
 	{
-		return m_threadCount;
+		return m_graph.getThreadCount();
 	}
 
 	/// Create a new semaphore with some initial value.
 	/// @param initialValue Can't be zero.
-	ThreadHiveSemaphore* newSemaphore(const U32 initialValue)
-	{
-		ANKI_ASSERT(initialValue > 0);
-		ThreadHiveSemaphore* sem = static_cast<ThreadHiveSemaphore*>(m_pool.allocate(sizeof(ThreadHiveSemaphore), alignof(ThreadHiveSemaphore)));
-		sem->m_atomic.setNonAtomically(initialValue);
-		return sem;
-	}
+	ThreadHiveSemaphore* newSemaphore(const U32 initialValue);
 
 	/// Allocate some scratch memory. The memory becomes invalid after waitAllTasks() is called.
 	void* allocateScratchMemory(PtrSize size, U32 alignment)
@@ -128,45 +135,8 @@ public:
 	void waitAllTasks();
 
 private:
-	class Thread;
-
-	/// Lightweight task.
-	class Task;
-
+	TaskGraph m_graph;
 	StackMemoryPool m_pool;
-	Thread* m_threads = nullptr;
-	U32 m_threadCount = 0;
-
-	Task* m_head = nullptr; ///< Head of the task list.
-	Task* m_tail = nullptr; ///< Tail of the task list.
-	Bool m_quit = false;
-	U32 m_pendingTasks = 0;
-
-	Mutex m_mtx;
-	ConditionVariable m_cvar;
-
-	static Atomic<U32> m_uuid;
-
-	void threadRun(U32 threadId);
-
-	/// Wait for more tasks.
-	Bool waitForWork(U32 threadId, Task*& task);
-
-	/// Get new work from the queue.
-	Task* getNewTask();
-
-	static void* stackPoolAllocate([[maybe_unused]] void* userData, void* ptr, PtrSize size, PtrSize alignment)
-	{
-		if(ptr)
-		{
-			DefaultMemoryPool::getSingleton().free(ptr);
-			return nullptr;
-		}
-		else
-		{
-			return DefaultMemoryPool::getSingleton().allocate(size, alignment);
-		}
-	}
 };
 /// @}
 
@@ -4,10 +4,15 @@
 // http://www.anki3d.org/LICENSE
 
 #include <AnKi/Util/ThreadJobManager.h>
-#include <AnKi/Util/String.h>
+#include <AnKi/Util/Functions.h>
+#include <cstdio>
 
 namespace anki {
 
+/// The manager that owns the current thread (if the current thread is a worker).
+static thread_local const ThreadJobManager* g_tlsJobManager = nullptr;
+static thread_local U32 g_tlsJobManagerThreadIdx = kMaxU32;
+
 class ThreadJobManager::WorkerThread
 {
 public:
@@ -15,9 +20,9 @@ public:
 	Thread m_thread;
 	ThreadJobManager* m_manager;
 
-	WorkerThread(ThreadJobManager* manager, U32 id, Bool pinToCore, CString threadName)
+	WorkerThread(ThreadJobManager* manager, U32 id, Bool pinToCore, const Char* threadName)
 		: m_id(id)
-		, m_thread(threadName.cstr())
+		, m_thread(threadName)
 		, m_manager(manager)
 	{
 		m_thread.start(this, threadCallback, ThreadCoreAffinityMask(false).set(m_id, pinToCore));
@@ -31,93 +36,341 @@ public:
 	}
 };
 
+/// Bounded Chase-Lev work-stealing deque. The owner pushes and pops from the bottom and the thieves steal from the top. Every
+/// slot has a busy flag so the owner won't overwrite a slot that a thief is still reading from.
+class ThreadJobManager::Queue
+{
+public:
+	class Slot
+	{
+	public:
+		Func m_func;
+		ThreadJobCounter* m_counter = nullptr;
+		Atomic<Bool> m_busy = {false};
+	};
+
+	alignas(ANKI_CACHE_LINE_SIZE) Atomic<I64> m_top = {0};
+	alignas(ANKI_CACHE_LINE_SIZE) Atomic<I64> m_bottom = {0};
+	alignas(ANKI_CACHE_LINE_SIZE) DynamicArray<Slot, MemoryPoolPtrWrapper<HeapMemoryPool>> m_slots;
+	I64 m_mask = 0;
+
+	Queue(HeapMemoryPool* pool, U32 size)
+		: m_slots(pool)
+	{
+		ANKI_ASSERT(isPowerOfTwo(size));
+		m_slots.resize(size);
+		m_mask = size - 1;
+	}
+
+	/// Called by the owner.
+	Bool push(const Func& func, ThreadJobCounter* counter)
+	{
+		const I64 b = m_bottom.load(AtomicMemoryOrder::kRelaxed);
+		Slot& slot = m_slots[U32(b & m_mask)];
+		if(slot.m_busy.load(AtomicMemoryOrder::kAcquire))
+		{
+			// Queue is full or a thief is still reading from it
+			return false;
+		}
+
+		slot.m_func = func;
+		slot.m_counter = counter;
+		slot.m_busy.store(true, AtomicMemoryOrder::kRelaxed);
+		m_bottom.store(b + 1, AtomicMemoryOrder::kRelease);
+		return true;
+	}
+
+	/// Called by the owner.
+	Bool pop(Func& func, ThreadJobCounter*& counter)
+	{
+		const I64 b = m_bottom.load(AtomicMemoryOrder::kRelaxed) - 1;
+		m_bottom.store(b, AtomicMemoryOrder::kRelaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		I64 t = m_top.load(AtomicMemoryOrder::kRelaxed);
+
+		if(t > b)
+		{
+			// Empty
+			m_bottom.store(b + 1, AtomicMemoryOrder::kRelaxed);
+			return false;
+		}
+
+		if(t == b)
+		{
+			// Last element, race with the thieves
+			const Bool won = m_top.compareExchange(t, t + 1, AtomicMemoryOrder::kSeqCst, AtomicMemoryOrder::kRelaxed);
+			m_bottom.store(b + 1, AtomicMemoryOrder::kRelaxed);
+			if(!won)
+			{
+				return false;
+			}
+		}
+
+		takeSlot(b, func, counter);
+		return true;
+	}
+
+	/// Called by anyone.
+	Bool steal(Func& func, ThreadJobCounter*& counter)
+	{
+		I64 t = m_top.load(AtomicMemoryOrder::kAcquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const I64 b = m_bottom.load(AtomicMemoryOrder::kAcquire);
+
+		if(t < b && m_top.compareExchange(t, t + 1, AtomicMemoryOrder::kSeqCst, AtomicMemoryOrder::kRelaxed))
+		{
+			takeSlot(t, func, counter);
+			return true;
+		}
+
+		return false;
+	}
+
+	Bool isEmpty() const
+	{
+		return m_top.load(AtomicMemoryOrder::kSeqCst) >= m_bottom.load(AtomicMemoryOrder::kSeqCst);
+	}
+
+private:
+	void takeSlot(I64 idx, Func& func, ThreadJobCounter*& counter)
+	{
+		Slot& slot = m_slots[U32(idx & m_mask)];
+		ANKI_ASSERT(slot.m_busy.load(AtomicMemoryOrder::kRelaxed));
+		func = std::move(slot.m_func);
+		counter = slot.m_counter;
+		slot.m_busy.store(false, AtomicMemoryOrder::kRelease);
+	}
+};
+
 ThreadJobManager::ThreadJobManager(U32 threadCount, Bool pinToCores, U32 queueSize)
+	: m_pool(allocAligned, nullptr, "ThreadJobManager")
+	, m_threads(&m_pool)
+	, m_queues(&m_pool)
 {
-	ANKI_ASSERT(threadCount);
+	ANKI_ASSERT(threadCount && queueSize);
+	queueSize = nextPowerOfTwo(queueSize);
+
+	// Create the queues first because the threads will start using them
+	m_queues.resize(threadCount + 1);
+	for(Queue*& queue : m_queues)
+	{
+		queue = newInstance<Queue>(m_pool, &m_pool, queueSize);
+	}
+
 	m_threads.resize(threadCount);
 	for(U32 i = 0; i < threadCount; ++i)
 	{
-		String threadName;
-		threadName.sprintf("JobManager#%u", i);
-		m_threads[i] = newInstance<WorkerThread>(DefaultMemoryPool::getSingleton(), this, i, pinToCores, threadName);
+		Array<Char, 32> threadName;
+		snprintf(&threadName[0], threadName.getSize(), "JobManager#%u", i);
+		m_threads[i] = newInstance<WorkerThread>(m_pool, this, i, pinToCores, &threadName[0]);
 	}
-
-	m_tasks.resize(queueSize);
 }
 
 ThreadJobManager::~ThreadJobManager()
 {
 	{
-		LockGuard lock(m_tasksMtx);
-		m_quit = true;
+		LockGuard lock(m_mtx);
+		m_quit.store(true);
+		m_cvar.notifyAll();
 	}
 
-	m_cvar.notifyAll();
-
 	for(WorkerThread* thread : m_threads)
 	{
 		[[maybe_unused]] const Error err = thread->m_thread.join();
-		deleteInstance(DefaultMemoryPool::getSingleton(), thread);
+		deleteInstance(m_pool, thread);
+	}
+
+	for(Queue* queue : m_queues)
+	{
+		deleteInstance(m_pool, queue);
 	}
 }
 
-Bool ThreadJobManager::pushBackTask(const Func& func)
+U32 ThreadJobManager::getCurrentThreadIndex() const
 {
-	LockGuard lock(m_tasksMtx);
-	const U32 next = (m_tasksBack + 1) % m_tasks.getSize();
-	if(next != m_tasksFront)
+	return (g_tlsJobManager == this) ? g_tlsJobManagerThreadIdx : getThreadCount();
+}
+
+void ThreadJobManager::dispatchTask(const Func& func, ThreadJobCounter* counter)
+{
+	m_tasksInFlightCount.fetchAdd(1);
+	if(counter)
 	{
-		m_tasks[m_tasksBack] = func;
-		m_tasksBack = next;
-		return true;
+		counter->m_pendingTaskCount.fetchAdd(1);
 	}
 
-	return false;
+	const U32 threadIdx = getCurrentThreadIndex();
+	Queue& queue = *m_queues[threadIdx];
+	const Bool workerThread = threadIdx < getThreadCount();
+
+	while(true)
+	{
+		Bool pushed;
+		if(workerThread)
+		{
+			pushed = queue.push(func, counter);
+		}
+		else
+		{
+			LockGuard lock(m_submissionQueueLock);
+			pushed = queue.push(func, counter);
+		}
+
+		if(pushed)
+		{
+			break;
+		}
+
+		// Queue is full, make some room by doing some work
+		if(!tryRunTask(threadIdx))
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	wakeUpThread();
+}
+
+void ThreadJobManager::waitForCounter(const ThreadJobCounter& counter)
+{
+	const U32 threadIdx = getCurrentThreadIndex();
+	while(!counter.isDone())
+	{
+		if(!tryRunTask(threadIdx))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void ThreadJobManager::waitForAllTasksToFinish()
+{
+	const U32 threadIdx = getCurrentThreadIndex();
+	while(m_tasksInFlightCount.load(AtomicMemoryOrder::kAcquire) != 0)
+	{
+		if(!tryRunTask(threadIdx))
+		{
+			std::this_thread::yield();
+		}
+	}
 }
 
-Bool ThreadJobManager::popFrontTask(Func& func, Bool& quit)
+Bool ThreadJobManager::tryRunTask(U32 threadIdx)
 {
-	LockGuard lock(m_tasksMtx);
-	quit = m_quit;
+	Func func;
+	ThreadJobCounter* counter = nullptr;
+	const U32 queueCount = m_queues.getSize();
+	Bool found = false;
 
-	if(quit) [[unlikely]]
+	// The submission queue is stolen from, never popped
+	if(threadIdx < getThreadCount())
 	{
-		return true;
+		found = m_queues[threadIdx]->pop(func, counter);
 	}
 
-	if(m_tasksBack != m_tasksFront)
+	// Steal starting from the next queue to spread the contention
+	for(U32 i = 1; i <= queueCount && !found; ++i)
 	{
-		func = m_tasks[m_tasksFront];
-		m_tasksFront = (m_tasksFront + 1) % m_tasks.getSize();
-		return true;
+		const U32 victim = (threadIdx + i) % queueCount;
+		if(victim != threadIdx || victim == getThreadCount())
+		{
+			found = m_queues[victim]->steal(func, counter);
+		}
+	}
+
+	if(!found)
+	{
+		return false;
+	}
+
+	func(threadIdx);
+
+	if(counter)
+	{
+		[[maybe_unused]] const U32 count = counter->m_pendingTaskCount.fetchSub(1, AtomicMemoryOrder::kRelease);
+		ANKI_ASSERT(count > 0);
+	}
+
+	[[maybe_unused]] const U32 count = m_tasksInFlightCount.fetchSub(1, AtomicMemoryOrder::kRelease);
+	ANKI_ASSERT(count > 0);
+
+	return true;
+}
+
+Bool ThreadJobManager::hasPendingTasks() const
+{
+	for(const Queue* queue : m_queues)
+	{
+		if(!queue->isEmpty())
+		{
+			return true;
+		}
 	}
 
 	return false;
 }
 
+void ThreadJobManager::wakeUpThread()
+{
+	// Pairs with the fence in threadRun(). Either the sleeping thread will see the new task or we'll see the sleeping thread
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(m_sleepingThreadCount.load(AtomicMemoryOrder::kRelaxed) > 0)
+	{
+		LockGuard lock(m_mtx);
+
+		// Decrement here and not in the sleeping thread to avoid waking it up multiple times before it gets the chance to run
+		if(m_sleepingThreadCount.load(AtomicMemoryOrder::kRelaxed) > 0)
+		{
+			m_sleepingThreadCount.fetchSub(1);
+			m_cvar.notifyOne();
+		}
+	}
+}
+
 void ThreadJobManager::threadRun(U32 threadId)
 {
-	while(true)
+	g_tlsJobManager = this;
+	g_tlsJobManagerThreadIdx = threadId;
+
+	constexpr U32 kSpinCount = 64;
+	U32 failedAttempts = 0;
+
+	while(!m_quit.load(AtomicMemoryOrder::kRelaxed))
 	{
-		Bool quit;
-		Func func;
-		if(popFrontTask(func, quit))
+		if(tryRunTask(threadId))
 		{
-			if(quit) [[unlikely]]
-			{
-				break;
-			}
+			failedAttempts = 0;
+			continue;
+		}
 
-			func(threadId);
-			[[maybe_unused]] const U32 count = m_tasksInFlightCount.fetchSub(1);
-			ANKI_ASSERT(count > 0);
+		if(++failedAttempts < kSpinCount)
+		{
+#if ANKI_SIMD_SSE
+			_mm_pause();
+#else
+			std::this_thread::yield();
+#endif
+			continue;
+		}
+
+		// Nothing to do, go to sleep
+		failedAttempts = 0;
+		LockGuard lock(m_mtx);
+		m_sleepingThreadCount.fetchAdd(1);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(m_quit.load() || hasPendingTasks())
+		{
+			m_sleepingThreadCount.fetchSub(1);
 		}
 		else
 		{
-			LockGuard lock(m_mtx);
+			// The thread that wakes us will decrement the m_sleepingThreadCount
 			m_cvar.wait(m_mtx);
 		}
 	}
+
+	g_tlsJobManager = nullptr;
+	g_tlsJobManagerThreadIdx = kMaxU32;
 }
 
 } // end namespace anki
@@ -14,13 +14,46 @@ namespace anki {
 /// @addtogroup util_thread
 /// @{
 
+/// A counter (or fence) that tracks a subset of the tasks of a ThreadJobManager. Pass it to
+/// ThreadJobManager::dispatchTask() and wait on it with ThreadJobManager::waitForCounter().
+/// @memberof ThreadJobManager
+class ThreadJobCounter
+{
+	friend class ThreadJobManager;
+
+public:
+	ThreadJobCounter() = default;
+
+	ThreadJobCounter(const ThreadJobCounter&) = delete; // Non-copyable
+
+	ThreadJobCounter& operator=(const ThreadJobCounter&) = delete; // Non-copyable
+
+	/// Return true if all the tasks that were associated with this counter have finished.
+	Bool isDone() const
+	{
+		return m_pendingTaskCount.load(AtomicMemoryOrder::kAcquire) == 0;
+	}
+
+	U32 getPendingTaskCount() const
+	{
+		return m_pendingTaskCount.load(AtomicMemoryOrder::kAcquire);
+	}
+
+private:
+	Atomic<U32> m_pendingTaskCount = {0};
+};
+
 /// Parallel task dispatcher. You feed it with tasks and sends them for execution in parallel and then waits for all to finish.
+/// Every worker thread owns a work-stealing queue (Chase-Lev deque). Tasks dispatched from a worker go to its own queue, tasks
+/// dispatched from any other thread go to a shared submission queue. Idle workers steal from the other queues and the threads
+/// that wait for tasks will execute tasks while waiting.
 class ThreadJobManager
 {
 public:
 	using Func = Function<void(U32 threadId)>;
 
 	/// Constructor.
+	/// @param queueSize The size of each of the task queues. It will be rounded up to the next power of two.
 	ThreadJobManager(U32 threadCount, Bool pinToCores = false, U32 queueSize = 256);
 
 	ThreadJobManager(const ThreadJobManager&) = delete; // Non-copyable
@@ -29,30 +62,20 @@ public:
 
 	ThreadJobManager& operator=(const ThreadJobManager&) = delete; // Non-copyable
 
-	/// Assign a task to a working thread
-	void dispatchTask(const Func& func)
-	{
-		m_tasksInFlightCount.fetchAdd(1);
-
-		while(!pushBackTask(func))
-		{
-			m_cvar.notifyOne();
-			std::this_thread::yield();
-		}
+	/// Assign a task to a working thread. Can be called from any thread, even from inside a task.
+	/// @param func The task.
+	/// @param counter Optional counter that will be incremented now and decremented when the task finishes.
+	void dispatchTask(const Func& func, ThreadJobCounter* counter = nullptr);
 
-		m_cvar.notifyOne();
-	}
+	/// Wait for the tasks associated with a counter to finish. The caller will execute tasks while it waits. Can be called from
+	/// inside a task.
+	void waitForCounter(const ThreadJobCounter& counter);
 
-	/// Wait for all tasks to finish.
-	void waitForAllTasksToFinish()
-	{
-		while(m_tasksInFlightCount.load() != 0)
-		{
-			m_cvar.notifyOne();
-			std::this_thread::yield();
-		}
-	}
+	/// Wait for all tasks to finish. The caller will execute tasks while it waits.
+	void waitForAllTasksToFinish();
 
+	/// The number of worker threads. Note that a thread that waits on the manager will execute tasks as well and those tasks will
+	/// get a threadId equal to getThreadCount().
 	U32 getThreadCount() const
 	{
 		return m_threads.getSize();
@@ -60,23 +83,34 @@ public:
 
 private:
 	class WorkerThread;
+	class Queue;
+
+	/// Internal pool. Don't use the DefaultMemoryPool because the manager might be used before it's created.
+	HeapMemoryPool m_pool;
 
-	DynamicArray<WorkerThread*> m_threads;
+	DynamicArray<WorkerThread*, MemoryPoolPtrWrapper<HeapMemoryPool>> m_threads;
 
-	DynamicArray<Func> m_tasks;
-	U32 m_tasksFront = 0;
-	U32 m_tasksBack = 0;
-	Mutex m_tasksMtx;
+	/// One queue per worker thread plus one (the last) for the tasks that are dispatched from non-worker threads.
+	DynamicArray<Queue*, MemoryPoolPtrWrapper<HeapMemoryPool>> m_queues;
+	SpinLock m_submissionQueueLock; ///< Protects the owner side of the submission queue.
 
 	Atomic<U32> m_tasksInFlightCount = {0};
 
+	Atomic<U32> m_sleepingThreadCount = {0};
 	ConditionVariable m_cvar;
 	Mutex m_mtx;
 
-	Bool m_quit = false;
+	Atomic<Bool> m_quit = {false};
+
+	/// Return the index of the current thread if it's one of the workers. If not it returns getThreadCount().
+	U32 getCurrentThreadIndex() const;
+
+	/// Try to execute a single task. First look in the own queue and then steal from the rest.
+	Bool tryRunTask(U32 threadIdx);
+
+	Bool hasPendingTasks() const;
 
-	Bool pushBackTask(const Func& func);
-	Bool popFrontTask(Func& func, Bool& quit);
+	void wakeUpThread();
 
 	void threadRun(U32 threadId);
 };
@@ -5,15 +5,10 @@
 
 #pragma once
 
-#include <AnKi/Util/Thread.h>
+#include <AnKi/Util/TaskGraph.h>
 
 namespace anki {
 
-// Forward
-namespace detail {
-class ThreadPoolThread;
-}
-
 /// @addtogroup util_thread
 /// @{
 
@@ -30,17 +25,20 @@ public:
 };
 
 /// Parallel task dispatcher. You feed it with tasks and sends them for execution in parallel and then waits for all to
-/// finish.
+/// finish. It's a thin layer on top of the TaskGraph. Every slot becomes a task.
 class ThreadPool
 {
-	friend class detail::ThreadPoolThread;
-
 public:
 	static constexpr U kMaxThreads = 32; ///< An absolute limit
 
-	/// Constructor.
+	/// Create the pool with its own threads.
 	ThreadPool(U32 threadCount, Bool pinToCores = false);
 
+	/// Create the pool on top of the workers of an existing ThreadJobManager. It will have as many slots as the manager's threads.
+	/// @note The workers are shared with other users of the manager so the slots are not guaranteed to run at the same time. The tasks
+	///       shouldn't wait for each other (with a Barrier for example) or they might deadlock. Use the other constructor for that.
+	explicit ThreadPool(ThreadJobManager& manager);
+
 	ThreadPool(const ThreadPool&) = delete; // Non-copyable
 
 	~ThreadPool();
@@ -56,11 +54,9 @@ public:
 	/// @return The error code in one of the worker threads.
 	Error waitForAllThreadsToFinish()
 	{
-		m_barrier.wait();
+		m_graph.waitAllTasks();
 		m_tasksAssigned = 0;
-		Error err = m_err;
-		m_err = Error::kNone;
-		return err;
+		return Error(m_err.exchange(Error::kNone));
 	}
 
 	/// @return The number of threads in the ThreadPool.
@@ -70,22 +66,11 @@ public:
 	}
 
 private:
-	/// A dummy task for a ThreadPool
-	class DummyTask : public ThreadPoolTask
-	{
-	public:
-		Error operator()([[maybe_unused]] U32 taskId, [[maybe_unused]] PtrSize threadsCount)
-		{
-			return Error::kNone;
-		}
-	};
-
-	Barrier m_barrier; ///< Synchronization barrier
-	detail::ThreadPoolThread* m_threads = nullptr; ///< Threads array
+	TaskGraph m_graph;
+	Array<ThreadPoolTask*, kMaxThreads> m_tasks = {};
 	U32 m_tasksAssigned = 0;
 	U32 m_threadsCount = 0;
-	Error m_err = Error::kNone;
-	static DummyTask m_dummyTask;
+	Atomic<I32> m_err = {Error::kNone};
 };
 /// @}
 
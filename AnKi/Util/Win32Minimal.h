@@ -42,11 +42,13 @@ typedef DWORD* LPDWORD;
 typedef void* HANDLE;
 typedef void* PVOID;
 typedef void* LPVOID;
+typedef const void* LPCVOID;
 typedef const CHAR *LPCSTR, *PCSTR;
 typedef const CHAR* PCZZSTR;
 typedef CHAR* LPSTR;
 typedef struct HINSTANCE__* HINSTANCE;
 typedef HINSTANCE HMODULE;
+typedef __int64(ANKI_WINAPI* FARPROC)();
 typedef wchar_t WCHAR;
 typedef const WCHAR* PCWSTR;
 typedef WCHAR *NWPSTR, *LPWSTR, *PWSTR;
@@ -108,6 +110,15 @@ ANKI_WINBASEAPI HANDLE ANKI_WINAPI FindFirstFileA(LPCSTR lpFileName, LPWIN32_FIN
 ANKI_WINBASEAPI BOOL ANKI_WINAPI FindClose(HANDLE hFindFile);
 ANKI_WINBASEAPI BOOL ANKI_WINAPI FindNextFileA(HANDLE hFindFile, LPWIN32_FIND_DATAA lpFindFileData);
 ANKI_WINBASEAPI DWORD ANKI_WINAPI GetTempPathA(DWORD nBufferLength, LPSTR lpBuffer);
+ANKI_WINBASEAPI HANDLE ANKI_WINAPI CreateFileA(LPCSTR lpFileName, DWORD dwDesiredAccess, DWORD dwShareMode,
+											   LPSECURITY_ATTRIBUTES lpSecurityAttributes, DWORD dwCreationDisposition, DWORD dwFlagsAndAttributes,
+											   HANDLE hTemplateFile);
+ANKI_WINBASEAPI DWORD ANKI_WINAPI GetFileSize(HANDLE hFile, LPDWORD lpFileSizeHigh);
+ANKI_WINBASEAPI HANDLE ANKI_WINAPI CreateFileMappingA(HANDLE hFile, LPSECURITY_ATTRIBUTES lpFileMappingAttributes, DWORD flProtect,
+													  DWORD dwMaximumSizeHigh, DWORD dwMaximumSizeLow, LPCSTR lpName);
+ANKI_WINBASEAPI LPVOID ANKI_WINAPI MapViewOfFile(HANDLE hFileMappingObject, DWORD dwDesiredAccess, DWORD dwFileOffsetHigh, DWORD dwFileOffsetLow,
+												 SIZE_T dwNumberOfBytesToMap);
+ANKI_WINBASEAPI BOOL ANKI_WINAPI UnmapViewOfFile(LPCVOID lpBaseAddress);
 
 // Other
 ANKI_WINBASEAPI DWORD ANKI_WINAPI GetLastError(VOID);
@@ -120,6 +131,9 @@ ANKI_WINBASEAPI BOOL ANKI_WINAPI SetConsoleTextAttribute(HANDLE hConsoleOutput,
 ANKI_WINBASEAPI VOID ANKI_WINAPI GetSystemInfo(LPSYSTEM_INFO lpSystemInfo);
 ANKI_WINBASEAPI DWORD ANKI_WINAPI GetModuleFileNameA(HMODULE hModule, LPSTR lpFilename, DWORD nSize);
 ANKI_WINBASEAPI int ANKI_WINAPI MessageBoxA(HWND hWnd, LPCSTR lpText, LPCSTR lpCaption, UINT uType);
+ANKI_WINBASEAPI HMODULE ANKI_WINAPI LoadLibraryA(LPCSTR lpLibFileName);
+ANKI_WINBASEAPI FARPROC ANKI_WINAPI GetProcAddress(HMODULE hModule, LPCSTR lpProcName);
+ANKI_WINBASEAPI BOOL ANKI_WINAPI FreeLibrary(HMODULE hLibModule);
 
 #undef ANKI_WINBASEAPI
 #undef ANKI_DECLARE_HANDLE
@@ -137,6 +151,13 @@ constexpr DWORD MAX_PATH = 260;
 static const HANDLE INVALID_HANDLE_VALUE = (HANDLE)(LONG_PTR)-1;
 constexpr DWORD ERROR_NO_MORE_FILES = 18L;
 constexpr WORD FO_DELETE = 0x0003;
+constexpr DWORD GENERIC_READ = 0x80000000L;
+constexpr DWORD FILE_SHARE_READ = 0x00000001;
+constexpr DWORD OPEN_EXISTING = 3;
+constexpr DWORD FILE_ATTRIBUTE_NORMAL = 0x00000080;
+constexpr DWORD PAGE_READONLY = 0x02;
+constexpr DWORD FILE_MAP_READ = 0x0004;
+constexpr DWORD INVALID_FILE_SIZE = (DWORD)0xFFFFFFFF;
 constexpr WORD FOF_NOCONFIRMATION = 0x0010;
 constexpr WORD FOF_NOERRORUI = 0x0400;
 constexpr WORD FOF_SILENT = 0x0004;
@@ -457,4 +478,19 @@ inline int MessageBoxA(HWND hWnd, LPCSTR lpText, LPCSTR lpCaption, UINT uType)
 	return ::MessageBoxA(hWnd, lpText, lpCaption, uType);
 }
 
+inline HMODULE LoadLibraryA(LPCSTR lpLibFileName)
+{
+	return ::LoadLibraryA(lpLibFileName);
+}
+
+inline FARPROC GetProcAddress(HMODULE hModule, LPCSTR lpProcName)
+{
+	return ::GetProcAddress(hModule, lpProcName);
+}
+
+inline BOOL FreeLibrary(HMODULE hLibModule)
+{
+	return ::FreeLibrary(hLibModule);
+}
+
 } // end namespace anki
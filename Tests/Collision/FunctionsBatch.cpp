@@ -0,0 +1,223 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Collision/Functions.h>
+#include <AnKi/Collision/Sphere.h>
+#include <AnKi/Collision/Obb.h>
+#include <AnKi/Util/HighRezTimer.h>
+
+using namespace anki;
+
+namespace {
+
+F32 randomF32(U32& state, F32 min, F32 max)
+{
+	state = state * 1664525u + 1013904223u;
+	return min + (max - min) * (F32(state >> 8) / F32(1u << 24));
+}
+
+template<typename TShape>
+Bool insidePlanesScalar(ConstWeakArray<Plane> planes, const TShape& shape)
+{
+	for(const Plane& plane : planes)
+	{
+		if(testPlane(plane, shape) < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/// Compare the batched test with the scalar for every shape and return the number of visible.
+template<typename TShape>
+U32 compareWithScalar(ConstWeakArray<Plane> planes, ConstWeakArray<TShape> shapes, ConstWeakArray<U32> insideMask, Bool& identical)
+{
+	U32 visibleCount = 0;
+	for(U32 i = 0; i < shapes.getSize(); ++i)
+	{
+		const Bool batchInside = !!(insideMask[i / 32] & (1u << (i % 32)));
+		identical = identical && batchInside == insidePlanesScalar(planes, shapes[i]);
+		visibleCount += batchInside;
+	}
+
+	return visibleCount;
+}
+
+} // namespace
+
+ANKI_TEST(Collision, FunctionsBatch)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	// An odd count to test the shapes that don't fill a whole register
+	constexpr U32 kCount = 50 * 1000 + 7;
+
+	const Mat4 proj = Mat4::calculatePerspectiveProjectionMatrix(toRad(70.0f), toRad(50.0f), 0.1f, 200.0f);
+	const Mat4 view = Mat4(Vec4(10.0f, 0.0f, 5.0f, 1.0f), Mat3(Euler(0.1f, 0.8f, 0.0f)), 1.0f).getInverse();
+	Array<Plane, 6> planes;
+	extractClipPlanes(proj * view, planes);
+
+	{
+		U32 seed = 0xC0FFEE;
+		DynamicArray<U32> insideMask;
+		insideMask.resize((kCount + 31) / 32, 0xFFFFFFFF);
+
+		// AABBs
+		{
+			DynamicArray<Aabb> aabbs;
+			Array<DynamicArray<F32>, 3> mins;
+			Array<DynamicArray<F32>, 3> maxs;
+			for(U32 i = 0; i < kCount; ++i)
+			{
+				const Vec3 center(randomF32(seed, -300.0f, 300.0f), randomF32(seed, -50.0f, 50.0f), randomF32(seed, -300.0f, 300.0f));
+				const Vec3 extend(randomF32(seed, 0.1f, 5.0f), randomF32(seed, 0.1f, 5.0f), randomF32(seed, 0.1f, 5.0f));
+				aabbs.emplaceBack(center - extend, center + extend);
+
+				for(U32 c = 0; c < 3; ++c)
+				{
+					mins[c].emplaceBack(aabbs.getBack().getMin()[c]);
+					maxs[c].emplaceBack(aabbs.getBack().getMax()[c]);
+				}
+			}
+
+			AabbSoa soa;
+			for(U32 c = 0; c < 3; ++c)
+			{
+				soa.m_min[c] = &mins[c][0];
+				soa.m_max[c] = &maxs[c][0];
+			}
+			soa.m_count = kCount;
+
+			Second begin = HighRezTimer::getCurrentTime();
+			insidePlanes(planes, soa, WeakArray<U32>(insideMask));
+			const Second batchTime = HighRezTimer::getCurrentTime() - begin;
+
+			U32 scalarVisibleCount = 0;
+			begin = HighRezTimer::getCurrentTime();
+			for(const Aabb& aabb : aabbs)
+			{
+				scalarVisibleCount += insidePlanesScalar(planes, aabb);
+			}
+			const Second scalarTime = HighRezTimer::getCurrentTime() - begin;
+
+			Bool identical = true;
+			const U32 visibleCount = compareWithScalar<Aabb>(planes, aabbs, insideMask, identical);
+			ANKI_TEST_EXPECT_EQ(identical, true);
+			ANKI_TEST_EXPECT_EQ(visibleCount, scalarVisibleCount);
+			ANKI_TEST_EXPECT_GT(visibleCount, 0);
+			ANKI_TEST_EXPECT_LT(visibleCount, kCount);
+
+			ANKI_TEST_LOGI("%u AABBs (%u visible): scalar %fms, batched %fms", kCount, visibleCount, scalarTime * 1000.0, batchTime * 1000.0);
+		}
+
+		// Spheres
+		{
+			DynamicArray<Sphere> spheres;
+			Array<DynamicArray<F32>, 3> centers;
+			DynamicArray<F32> radii;
+			for(U32 i = 0; i < kCount; ++i)
+			{
+				const Vec3 center(randomF32(seed, -300.0f, 300.0f), randomF32(seed, -50.0f, 50.0f), randomF32(seed, -300.0f, 300.0f));
+				const F32 radius = randomF32(seed, 0.1f, 10.0f);
+				spheres.emplaceBack(center, radius);
+
+				for(U32 c = 0; c < 3; ++c)
+				{
+					centers[c].emplaceBack(center[c]);
+				}
+				radii.emplaceBack(radius);
+			}
+
+			SphereSoa soa;
+			for(U32 c = 0; c < 3; ++c)
+			{
+				soa.m_center[c] = &centers[c][0];
+			}
+			soa.m_radius = &radii[0];
+			soa.m_count = kCount;
+
+			Second begin = HighRezTimer::getCurrentTime();
+			insidePlanes(planes, soa, WeakArray<U32>(insideMask));
+			const Second batchTime = HighRezTimer::getCurrentTime() - begin;
+
+			U32 scalarVisibleCount = 0;
+			begin = HighRezTimer::getCurrentTime();
+			for(const Sphere& sphere : spheres)
+			{
+				scalarVisibleCount += insidePlanesScalar(planes, sphere);
+			}
+			const Second scalarTime = HighRezTimer::getCurrentTime() - begin;
+
+			Bool identical = true;
+			const U32 visibleCount = compareWithScalar<Sphere>(planes, spheres, insideMask, identical);
+			ANKI_TEST_EXPECT_EQ(identical, true);
+			ANKI_TEST_EXPECT_EQ(visibleCount, scalarVisibleCount);
+
+			ANKI_TEST_LOGI("%u spheres (%u visible): scalar %fms, batched %fms", kCount, visibleCount, scalarTime * 1000.0, batchTime * 1000.0);
+		}
+
+		// OBBs
+		{
+			DynamicArray<Obb> obbs;
+			Array<DynamicArray<F32>, 3> centers;
+			Array<DynamicArray<F32>, 3> extends;
+			Array<DynamicArray<F32>, 9> rotations;
+			for(U32 i = 0; i < kCount; ++i)
+			{
+				const Vec4 center(randomF32(seed, -300.0f, 300.0f), randomF32(seed, -50.0f, 50.0f), randomF32(seed, -300.0f, 300.0f), 0.0f);
+				const Vec4 extend(randomF32(seed, 0.1f, 5.0f), randomF32(seed, 0.1f, 5.0f), randomF32(seed, 0.1f, 5.0f), 0.0f);
+				const Mat3x4 rotation(Vec3(0.0f), Euler(randomF32(seed, -kPi, kPi), randomF32(seed, -kPi, kPi), randomF32(seed, -kPi, kPi)));
+				obbs.emplaceBack(center, rotation, extend);
+
+				for(U32 c = 0; c < 3; ++c)
+				{
+					centers[c].emplaceBack(center[c]);
+					extends[c].emplaceBack(extend[c]);
+
+					for(U32 r = 0; r < 3; ++r)
+					{
+						rotations[r * 3 + c].emplaceBack(rotation(r, c));
+					}
+				}
+			}
+
+			ObbSoa soa;
+			for(U32 c = 0; c < 3; ++c)
+			{
+				soa.m_center[c] = &centers[c][0];
+				soa.m_extend[c] = &extends[c][0];
+			}
+			for(U32 i = 0; i < 9; ++i)
+			{
+				soa.m_rotation[i] = &rotations[i][0];
+			}
+			soa.m_count = kCount;
+
+			Second begin = HighRezTimer::getCurrentTime();
+			insidePlanes(planes, soa, WeakArray<U32>(insideMask));
+			const Second batchTime = HighRezTimer::getCurrentTime() - begin;
+
+			U32 scalarVisibleCount = 0;
+			begin = HighRezTimer::getCurrentTime();
+			for(const Obb& obb : obbs)
+			{
+				scalarVisibleCount += insidePlanesScalar(planes, obb);
+			}
+			const Second scalarTime = HighRezTimer::getCurrentTime() - begin;
+
+			Bool identical = true;
+			const U32 visibleCount = compareWithScalar<Obb>(planes, obbs, insideMask, identical);
+			ANKI_TEST_EXPECT_EQ(identical, true);
+			ANKI_TEST_EXPECT_EQ(visibleCount, scalarVisibleCount);
+
+			ANKI_TEST_LOGI("%u OBBs (%u visible): scalar %fms, batched %fms", kCount, visibleCount, scalarTime * 1000.0, batchTime * 1000.0);
+		}
+	}
+
+	DefaultMemoryPool::freeSingleton();
+}
@@ -0,0 +1,264 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Importer/AnimationEncoder.h>
+#include <AnKi/Resource/AnimationResource.h>
+#include <AnKi/Resource/AnimationBinary.h>
+#include <AnKi/Resource/ResourceFilesystem.h>
+#include <AnKi/Util/Filesystem.h>
+#include <AnKi/Util/HighRezTimer.h>
+
+using namespace anki;
+
+namespace {
+
+F32 randomF32(U32& state, F32 min, F32 max)
+{
+	state = state * 1664525u + 1013904223u;
+	return min + (max - min) * (F32(state >> 8) / F32(1u << 24));
+}
+
+F32 rotationAngle(const Quat& a, const Quat& b)
+{
+	// q and -q are the same rotation
+	const Vec4 va(a.x(), a.y(), a.z(), a.w());
+	const Vec4 vb(b.x(), b.y(), b.z(), b.w());
+	const F32 chord = sqrt(min((va - vb).getLengthSquared(), (va + vb).getLengthSquared()));
+	return 4.0f * asin(min(chord * 0.5f, 1.0f));
+}
+
+template<typename T>
+using KeyArray = DynamicArray<AnimationEncoderKey<T>>;
+
+} // namespace
+
+ANKI_TEST(Importer, AnimationEncoder)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+	ResourceMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	{
+		HeapMemoryPool pool(allocAligned, nullptr);
+		U32 seed = 0xC0FFEE;
+
+		// Smallest three quaternions
+		{
+			F32 maxError = 0.0f;
+			for(U32 i = 0; i < 10000; ++i)
+			{
+				const Quat q(Euler(randomF32(seed, -kPi, kPi), randomF32(seed, -kPi, kPi), randomF32(seed, -kPi, kPi)));
+				const Array<U16, 3> packed = quantizeAnimationRotation(q);
+				maxError = max(maxError, rotationAngle(q, dequantizeAnimationRotation(&packed[0])));
+			}
+
+			ANKI_TEST_LOGI("Max error of the smallest three quaternions %f degrees", toDegrees(maxError));
+			ANKI_TEST_EXPECT_LT(maxError, toRad(0.01f));
+		}
+
+		// A mocap-like set: 2 minutes at 120Hz. The root moves and every bone rotates with some sensor noise
+		constexpr U32 kChannelCount = 64;
+		constexpr U32 kKeyCount = 120 * 120;
+		constexpr Second kFrameTime = 1.0 / 120.0;
+
+		DynamicArray<String> names;
+		DynamicArray<KeyArray<Vec3>> positions;
+		DynamicArray<KeyArray<Quat>> rotations;
+		DynamicArray<KeyArray<F32>> scales;
+		names.resize(kChannelCount);
+		positions.resize(kChannelCount);
+		rotations.resize(kChannelCount);
+		scales.resize(kChannelCount);
+
+		for(U32 c = 0; c < kChannelCount; ++c)
+		{
+			names[c].sprintf("Bone_%u", c);
+			positions[c].resize(kKeyCount);
+			rotations[c].resize(kKeyCount);
+			scales[c].resize(kKeyCount);
+
+			const Vec3 boneOffset(0.0f, randomF32(seed, 0.05f, 0.5f), 0.0f);
+			const Vec3 frequency(randomF32(seed, 0.1f, 2.0f), randomF32(seed, 0.1f, 2.0f), randomF32(seed, 0.1f, 2.0f));
+			const Vec3 amplitude(randomF32(seed, 0.0f, 1.0f), randomF32(seed, 0.0f, 0.5f), randomF32(seed, 0.0f, 0.2f));
+
+			for(U32 k = 0; k < kKeyCount; ++k)
+			{
+				const F32 t = F32(Second(k) * kFrameTime);
+				const Second time = Second(k) * kFrameTime;
+
+				const Vec3 rootMotion(t * 1.5f, 0.9f + sin(t * 8.0f) * 0.05f, sin(t * 0.3f) * 2.0f);
+				positions[c][k] = {time, (c == 0) ? rootMotion : boneOffset};
+
+				const Vec3 noise(randomF32(seed, -1.0f, 1.0f), randomF32(seed, -1.0f, 1.0f), randomF32(seed, -1.0f, 1.0f));
+				const Vec3 angles = amplitude * Vec3(sin(frequency.x() * t), sin(frequency.y() * t), cos(frequency.z() * t)) + noise * 0.0001f;
+				rotations[c][k] = {time, Quat(Euler(angles.x(), angles.y(), angles.z()))};
+
+				scales[c][k] = {time, 1.0f};
+			}
+		}
+
+		DynamicArray<AnimationEncoderChannel> channels;
+		channels.resize(kChannelCount);
+		for(U32 c = 0; c < kChannelCount; ++c)
+		{
+			channels[c].m_name = names[c];
+			channels[c].m_positions = positions[c];
+			channels[c].m_rotations = rotations[c];
+			channels[c].m_scales = scales[c];
+		}
+
+		// Encode
+		String dir;
+		ANKI_TEST_EXPECT_NO_ERR(getTempDirectory(dir));
+		dir += "/AnKiAnimationEncoderTest";
+		if(directoryExists(dir))
+		{
+			ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
+		}
+		ANKI_TEST_EXPECT_NO_ERR(createDirectory(dir));
+
+		AnimationEncoderConfig config;
+		AnimationEncoderStats stats;
+		HighRezTimer timer;
+		timer.start();
+		String fname = dir;
+		fname += "/anim.ankianim";
+		ANKI_TEST_EXPECT_NO_ERR(encodeAnimation(pool, channels, config, fname, &stats));
+		timer.stop();
+		const Second encodeTime = timer.getElapsedTime();
+
+		config.m_reduceKeys = false;
+		AnimationEncoderStats unreducedStats;
+		fname = dir;
+		fname += "/unreduced.ankianim";
+		ANKI_TEST_EXPECT_NO_ERR(encodeAnimation(pool, channels, config, fname, &unreducedStats));
+
+		// Load
+		ResourceFilesystem fs;
+		ANKI_TEST_EXPECT_NO_ERR(fs.init());
+		ANKI_TEST_EXPECT_NO_ERR(fs.addNewPath(dir, ResourceStringList()));
+
+		AnimationResource anim;
+		ResourceFilePtr file;
+		ANKI_TEST_EXPECT_NO_ERR(fs.openFile("anim.ankianim", file));
+		timer.start();
+		ANKI_TEST_EXPECT_NO_ERR(anim.loadBinary(*file));
+		timer.stop();
+		const Second loadTime = timer.getElapsedTime();
+
+		ANKI_TEST_EXPECT_EQ(anim.getChannels().getSize(), kChannelCount);
+		ANKI_TEST_EXPECT_NEAR(anim.getDuration(), Second(kKeyCount - 1) * kFrameTime, 0.001);
+
+		// All the original keys should be reconstructed within the error bounds plus the error of the quantization
+		{
+			Bool namesMatch = true;
+			F32 maxPositionError = 0.0f;
+			F32 maxRotationError = 0.0f;
+			F32 maxScaleError = 0.0f;
+			for(U32 c = 0; c < kChannelCount; ++c)
+			{
+				const AnimationChannel& channel = anim.getChannels()[c];
+				namesMatch = namesMatch && channel.m_name.toCString() == names[c].toCString();
+
+				// Nothing was expanded
+				ANKI_TEST_EXPECT_EQ(channel.m_rotations.getSize(), 0);
+				ANKI_TEST_EXPECT_EQ(channel.m_quantizedScales.m_times.getSize(), 0);
+
+				const F32 positionQuantizationError = (channel.m_quantizedPositions.m_scale * 0.5f).getLength();
+
+				AnimationChannelCursor cursor;
+				for(U32 k = 0; k < kKeyCount; ++k)
+				{
+					AnimationSample sample;
+					sampleAnimationChannel(channel, positions[c][k].m_time, cursor, sample);
+
+					maxPositionError = max(maxPositionError, (sample.m_position - positions[c][k].m_value).getLength() - positionQuantizationError);
+					maxRotationError = max(maxRotationError, rotationAngle(sample.m_rotation, rotations[c][k].m_value));
+					maxScaleError = max(maxScaleError, absolute(sample.m_scale - scales[c][k].m_value));
+				}
+			}
+
+			ANKI_TEST_EXPECT_EQ(namesMatch, true);
+			ANKI_TEST_EXPECT_LT(maxPositionError, AnimationEncoderConfig().m_positionError * 1.01f);
+			ANKI_TEST_EXPECT_LT(maxRotationError, AnimationEncoderConfig().m_rotationError + toRad(0.01f));
+			ANKI_TEST_EXPECT_LT(maxScaleError, AnimationEncoderConfig().m_scaleError);
+		}
+
+		// Memory and sampling speed compared to the full precision keyframes
+		{
+			DynamicArray<AnimationChannel> floatChannels;
+			floatChannels.resize(kChannelCount);
+			PtrSize floatMemory = 0;
+			for(U32 c = 0; c < kChannelCount; ++c)
+			{
+				floatChannels[c].m_positions.resize(kKeyCount);
+				floatChannels[c].m_rotations.resize(kKeyCount);
+				floatChannels[c].m_scales.resize(kKeyCount);
+				for(U32 k = 0; k < kKeyCount; ++k)
+				{
+					floatChannels[c].m_positions[k] = {positions[c][k].m_time, positions[c][k].m_value};
+					floatChannels[c].m_rotations[k] = {rotations[c][k].m_time, rotations[c][k].m_value};
+					floatChannels[c].m_scales[k] = {scales[c][k].m_time, scales[c][k].m_value};
+				}
+
+				floatMemory += floatChannels[c].m_positions.getSizeInBytes() + floatChannels[c].m_rotations.getSizeInBytes()
+							   + floatChannels[c].m_scales.getSizeInBytes();
+			}
+
+			constexpr U32 kCharacterCount = 64;
+			constexpr U32 kFrameCount = 16;
+			DynamicArray<AnimationChannelCursor> cursors;
+			cursors.resize(kCharacterCount * kChannelCount);
+			DynamicArray<AnimationSample> samples;
+			samples.resize(kCharacterCount * kChannelCount);
+
+			auto characterTime = [&](U32 character, U32 frame) {
+				return Second(character) * 1.37 + Second(frame) / 60.0;
+			};
+
+			auto benchmark = [&](ConstWeakArray<AnimationChannel> sampledChannels) {
+				HighRezTimer benchmarkTimer;
+				benchmarkTimer.start();
+				for(U32 f = 0; f < kFrameCount; ++f)
+				{
+					for(U32 ch = 0; ch < kCharacterCount; ++ch)
+					{
+						for(U32 c = 0; c < kChannelCount; ++c)
+						{
+							sampleAnimationChannel(sampledChannels[c], characterTime(ch, f), cursors[ch * kChannelCount + c],
+												   samples[ch * kChannelCount + c]);
+						}
+					}
+				}
+				benchmarkTimer.stop();
+				return benchmarkTimer.getElapsedTime();
+			};
+
+			const Second floatSampleTime = benchmark(floatChannels);
+			for(AnimationChannelCursor& cursor : cursors)
+			{
+				cursor = {};
+			}
+			const Second quantizedSampleTime = benchmark(anim.getChannels());
+
+			ANKI_TEST_LOGI("%u channels x %u keys. Encoded in %fms. Keys %u -> %u (%u without the reduction). Memory %zuKB as floats, %zuKB as "
+						   "file without the reduction, %zuKB as file and %zuKB loaded. Loaded in %fms",
+						   kChannelCount, kKeyCount, encodeTime * 1000.0, stats.m_inputKeyCount, stats.m_outputKeyCount,
+						   unreducedStats.m_outputKeyCount, floatMemory / 1024, unreducedStats.m_fileSize / 1024, stats.m_fileSize / 1024,
+						   anim.getKeysMemorySize() / 1024, loadTime * 1000.0);
+			ANKI_TEST_LOGI("Sampling %u characters for %u frames: %fms with the float keys, %fms with the quantized keys", kCharacterCount,
+						   kFrameCount, floatSampleTime * 1000.0, quantizedSampleTime * 1000.0);
+
+			ANKI_TEST_EXPECT_LT(unreducedStats.m_fileSize, floatMemory / 2);
+			ANKI_TEST_EXPECT_LT(stats.m_fileSize, unreducedStats.m_fileSize);
+			ANKI_TEST_EXPECT_LT(anim.getKeysMemorySize(), floatMemory / 2);
+		}
+
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
+	}
+
+	ResourceMemoryPool::freeSingleton();
+	DefaultMemoryPool::freeSingleton();
+}
@@ -0,0 +1,183 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Importer/BcEncoder.h>
+#include <AnKi/Importer/ImageImporter.h>
+#include <AnKi/Resource/Stb.h>
+#include <AnKi/Util/ThreadJobManager.h>
+#include <AnKi/Util/System.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <AnKi/Util/Filesystem.h>
+#include <AnKi/Util/File.h>
+
+using namespace anki;
+
+using PixelArray = DynamicArray<U8, SingletonMemoryPoolWrapper<DefaultMemoryPool>, PtrSize>;
+
+/// PSNR of the first channelCount channels of 2 RGBA8 images.
+static F64 computePsnr(ConstWeakArray<U8, PtrSize> a, ConstWeakArray<U8, PtrSize> b, U32 channelCount)
+{
+	F64 error = 0.0;
+	for(PtrSize i = 0; i < a.getSize(); i += 4)
+	{
+		for(U32 c = 0; c < channelCount; ++c)
+		{
+			const F64 diff = F64(a[i + c]) - F64(b[i + c]);
+			error += diff * diff;
+		}
+	}
+
+	error /= F64(a.getSize() / 4 * channelCount);
+	return (error > 0.0) ? 10.0 * log10(255.0 * 255.0 / error) : 100.0;
+}
+
+/// Decode the S3TC of the first mip of an .ankitex with a single mip.
+static Error readAnkiTexBc1(CString fname, U32 width, U32 height, PixelArray& pixels)
+{
+	File file;
+	ANKI_CHECK(file.open(fname, FileOpenFlag::kRead | FileOpenFlag::kBinary));
+	ImageBinaryHeader header;
+	ANKI_CHECK(file.read(&header, sizeof(header)));
+	PixelArray blocks;
+	blocks.resize(PtrSize(width / 4) * (height / 4) * 8);
+	ANKI_CHECK(file.read(&blocks[0], blocks.getSizeInBytes()));
+
+	pixels.resize(PtrSize(width) * height * 4);
+	decompressBc(BcFormat::kBc1, blocks, width, height, WeakArray<U8, PtrSize>(pixels));
+	return Error::kNone;
+}
+
+ANKI_TEST(Importer, BcEncoder)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	{
+		// Smooth gradients with some high frequency detail
+		constexpr U32 kSize = 512;
+		PixelArray pixels;
+		pixels.resize(PtrSize(kSize) * kSize * 4);
+		for(U32 y = 0; y < kSize; ++y)
+		{
+			for(U32 x = 0; x < kSize; ++x)
+			{
+				U8* texel = &pixels[(PtrSize(y) * kSize + x) * 4];
+				const F32 detail = sin(F32(x) * 0.3f) * cos(F32(y) * 0.2f) * 16.0f;
+				texel[0] = U8(clamp(F32(x) / F32(kSize) * 200.0f + detail + 20.0f, 0.0f, 255.0f));
+				texel[1] = U8(clamp(F32(y) / F32(kSize) * 200.0f - detail + 20.0f, 0.0f, 255.0f));
+				texel[2] = U8(clamp(F32(x + y) / F32(2 * kSize) * 128.0f + detail + 64.0f, 0.0f, 255.0f));
+				texel[3] = U8(((x / 32 + y / 32) & 1) ? 255 : U8(F32(x) / F32(kSize) * 255.0f));
+			}
+		}
+
+		ThreadJobManager jobManager(getCpuCoresCount());
+
+		class FormatInfo
+		{
+		public:
+			BcFormat m_format;
+			CString m_name;
+			U32 m_channelCount;
+			F64 m_minPsnr;
+		};
+
+		const Array<FormatInfo, 4> formats = {
+			{{BcFormat::kBc1, "BC1", 3, 35.0}, {BcFormat::kBc3, "BC3", 4, 35.0}, {BcFormat::kBc4, "BC4", 1, 40.0}, {BcFormat::kBc5, "BC5", 2, 40.0}}};
+
+		for(const FormatInfo& info : formats)
+		{
+			PixelArray blocks;
+			blocks.resize(PtrSize(getBcBlockSize(info.m_format)) * (kSize / 4) * (kSize / 4));
+			PixelArray parallelBlocks;
+			parallelBlocks.resize(blocks.getSize());
+
+			HighRezTimer timer;
+			timer.start();
+			compressBc(info.m_format, pixels, kSize, kSize, 4, WeakArray<U8, PtrSize>(blocks));
+			timer.stop();
+			const Second serialTime = timer.getElapsedTime();
+
+			timer.start();
+			ThreadJobCounter counter;
+			compressBc(info.m_format, pixels, kSize, kSize, 4, WeakArray<U8, PtrSize>(parallelBlocks), &jobManager, &counter);
+			jobManager.waitForCounter(counter);
+			timer.stop();
+			const Second parallelTime = timer.getElapsedTime();
+
+			// The tasks should produce the exact same blocks
+			ANKI_TEST_EXPECT_EQ(memcmp(&blocks[0], &parallelBlocks[0], blocks.getSizeInBytes()), 0);
+
+			PixelArray decoded;
+			decoded.resize(pixels.getSize());
+			decompressBc(info.m_format, blocks, kSize, kSize, WeakArray<U8, PtrSize>(decoded));
+
+			const F64 psnr = computePsnr(pixels, decoded, info.m_channelCount);
+			const F64 mpixels = F64(kSize * kSize) / 1000000.0;
+			ANKI_TEST_LOGI("%s: PSNR %.2fdB, %.1f MPixels/s in 1 thread, %.1f MPixels/s in %u threads", info.m_name.cstr(), psnr,
+						   mpixels / serialTime, mpixels / parallelTime, jobManager.getThreadCount());
+			ANKI_TEST_EXPECT_GT(psnr, info.m_minPsnr);
+		}
+
+		// Compare with Compressonator if it's around
+#if ANKI_OS_LINUX
+		const CString compressonator = ANKI_SOURCE_DIRECTORY "/ThirdParty/Bin/Linux64/Compressonator/compressonatorcli";
+#else
+		const CString compressonator = ANKI_SOURCE_DIRECTORY "/ThirdParty/Bin/Windows64/Compressonator/compressonatorcli.exe";
+#endif
+		String tmpDir;
+		ANKI_TEST_EXPECT_NO_ERR(getTempDirectory(tmpDir));
+		if(!fileExists(compressonator))
+		{
+			ANKI_TEST_LOGW("Compressonator is missing. Skipping the comparison");
+		}
+		else
+		{
+			String inFname;
+			inFname.sprintf("%s/AnKiBcEncoderTest.png", tmpDir.cstr());
+			ANKI_TEST_EXPECT_EQ(stbi_write_png(inFname.cstr(), kSize, kSize, 4, &pixels[0], 0) != 0, true);
+			CleanupFile inCleanup(inFname);
+
+			String outFname;
+			outFname.sprintf("%s/AnKiBcEncoderTest.ankitex", tmpDir.cstr());
+			CleanupFile outCleanup(outFname);
+
+			HeapMemoryPool pool(allocAligned, nullptr);
+			const Array<CString, 1> inFnames = {inFname};
+			ImageImporterConfig config;
+			config.m_pool = &pool;
+			config.m_inputFilenames = inFnames;
+			config.m_outFilename = outFname;
+			config.m_compressions = ImageBinaryDataCompression::kS3tc;
+			config.m_mipmapCount = 1;
+			config.m_flipImage = false;
+			config.m_tempDirectory = tmpDir;
+			config.m_compressonatorFilename = compressonator;
+			config.m_jobManager = &jobManager;
+
+			Array<F64, 2> psnrs;
+			Array<Second, 2> times;
+			for(U32 builtin = 0; builtin < 2; ++builtin)
+			{
+				config.m_builtinS3tcEncoder = builtin;
+
+				HighRezTimer timer;
+				timer.start();
+				ANKI_TEST_EXPECT_NO_ERR(importImage(config));
+				timer.stop();
+				times[builtin] = timer.getElapsedTime();
+
+				PixelArray decoded;
+				ANKI_TEST_EXPECT_NO_ERR(readAnkiTexBc1(outFname, kSize, kSize, decoded));
+				psnrs[builtin] = (decoded.getSize() == pixels.getSize()) ? computePsnr(pixels, decoded, 3) : 0.0;
+			}
+
+			ANKI_TEST_LOGI("BC1 import. Compressonator: PSNR %.2fdB in %fms. Built-in: PSNR %.2fdB in %fms", psnrs[0], times[0] * 1000.0, psnrs[1],
+						   times[1] * 1000.0);
+			ANKI_TEST_EXPECT_GT(psnrs[1], psnrs[0] - 1.0);
+		}
+	}
+
+	DefaultMemoryPool::freeSingleton();
+}
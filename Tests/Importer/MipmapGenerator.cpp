@@ -0,0 +1,234 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Importer/MipmapGenerator.h>
+#include <AnKi/Util/ThreadJobManager.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <AnKi/Util/System.h>
+
+using namespace anki;
+
+using PixelArray = DynamicArray<U8, SingletonMemoryPoolWrapper<DefaultMemoryPool>, PtrSize>;
+
+/// The 2x2 box filter that the image importer used to have. Used as a baseline.
+template<typename T, U32 kChannelCount>
+static void legacyBoxMipmap(ConstWeakArray<U8, PtrSize> inBuffer, U32 inWidth, U32 inHeight, WeakArray<U8, PtrSize> outBuffer)
+{
+	const T* in = reinterpret_cast<const T*>(&inBuffer[0]);
+	T* out = reinterpret_cast<T*>(&outBuffer[0]);
+	const U32 outWidth = inWidth >> 1;
+	const U32 outHeight = inHeight >> 1;
+
+	for(U32 h = 0; h < outHeight; ++h)
+	{
+		for(U32 w = 0; w < outWidth; ++w)
+		{
+			Array<F32, kChannelCount> average = {};
+			for(U32 y = 0; y < 2; ++y)
+			{
+				for(U32 x = 0; x < 2; ++x)
+				{
+					const PtrSize idx = (PtrSize(h * 2 + y) * inWidth + (w * 2 + x)) * kChannelCount;
+					for(U32 c = 0; c < kChannelCount; ++c)
+					{
+						average[c] += F32(in[idx + c]) * 0.25f;
+					}
+				}
+			}
+
+			for(U32 c = 0; c < kChannelCount; ++c)
+			{
+				out[(PtrSize(h) * outWidth + w) * kChannelCount + c] = T(average[c]);
+			}
+		}
+	}
+}
+
+ANKI_TEST(Importer, MipmapGenerator)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	{
+		HeapMemoryPool pool(allocAligned, nullptr);
+		ThreadJobManager jobManager(getCpuCoresCount());
+
+		// Filtering in linear space. A black and white checkerboard should average to middle grey in linear which is 188 in sRGB
+		{
+			constexpr U32 kSize = 16;
+			PixelArray pixels;
+			pixels.resize(kSize * kSize * 4);
+			for(U32 i = 0; i < kSize * kSize; ++i)
+			{
+				const U8 c = (((i % kSize) + (i / kSize)) & 1) ? 255 : 0;
+				pixels[i * 4 + 0] = c;
+				pixels[i * 4 + 1] = c;
+				pixels[i * 4 + 2] = c;
+				pixels[i * 4 + 3] = c;
+			}
+
+			PixelArray mip;
+			mip.resize(pixels.getSize() / 4);
+			generateMipmap(pool, ImageMipmapFilter::kBox, pixels, kSize, kSize, 4, false, true, WeakArray<U8, PtrSize>(mip));
+			ANKI_TEST_EXPECT_NEAR(mip[0], 188, 1);
+			ANKI_TEST_EXPECT_NEAR(mip[3], 128, 1);
+
+			generateMipmap(pool, ImageMipmapFilter::kBox, pixels, kSize, kSize, 4, false, false, WeakArray<U8, PtrSize>(mip));
+			ANKI_TEST_EXPECT_NEAR(mip[0], 128, 1);
+		}
+
+		// The filters should keep a constant image constant and the alpha coverage should be preserved
+		{
+			constexpr U32 kSize = 64;
+			PixelArray pixels;
+			pixels.resize(kSize * kSize * 4);
+			for(U32 y = 0; y < kSize; ++y)
+			{
+				for(U32 x = 0; x < kSize; ++x)
+				{
+					U8* texel = &pixels[(y * kSize + x) * 4];
+					texel[0] = 100;
+					texel[1] = 150;
+					texel[2] = 200;
+
+					// Thin stripes like grass
+					texel[3] = ((x % 32) < 8) ? 255 : 0;
+				}
+			}
+
+			const F32 coverage = computeAlphaCoverage(pixels, 0.5f);
+			ANKI_TEST_EXPECT_NEAR(coverage, 0.25f, 0.001f);
+
+			for(ImageMipmapFilter filter : EnumIterable<ImageMipmapFilter>())
+			{
+				PixelArray mip;
+				mip.resize(pixels.getSize() / 4);
+				generateMipmap(pool, filter, pixels, kSize, kSize, 4, false, true, WeakArray<U8, PtrSize>(mip));
+
+				PixelArray mip2;
+				mip2.resize(mip.getSize() / 4);
+				generateMipmap(pool, filter, mip, kSize / 2, kSize / 2, 4, false, true, WeakArray<U8, PtrSize>(mip2));
+
+				Bool constant = true;
+				for(PtrSize i = 0; i < mip2.getSize(); i += 4)
+				{
+					constant = constant && absolute(I32(mip2[i]) - 100) <= 1 && absolute(I32(mip2[i + 1]) - 150) <= 1
+							   && absolute(I32(mip2[i + 2]) - 200) <= 1;
+				}
+				ANKI_TEST_EXPECT_EQ(constant, true);
+
+				preserveAlphaCoverage(WeakArray<U8, PtrSize>(mip2), 0.5f, coverage);
+				ANKI_TEST_EXPECT_NEAR(computeAlphaCoverage(mip2, 0.5f), coverage, 0.05f);
+			}
+		}
+
+		// Benchmark against the old filter. 16384 is the size of the big textures but it needs a few GB so keep it smaller by default
+		constexpr U32 kSize = 4096;
+		const F64 mpixels = F64(kSize) * kSize / 1000000.0;
+
+		// HDR
+		{
+			PixelArray pixels;
+			pixels.resize(PtrSize(kSize) * kSize * 3 * sizeof(F32));
+			F32* texels = reinterpret_cast<F32*>(&pixels[0]);
+			for(PtrSize i = 0; i < PtrSize(kSize) * kSize * 3; ++i)
+			{
+				texels[i] = F32(i % 1021) * 0.01f;
+			}
+
+			PixelArray legacy;
+			legacy.resize(pixels.getSize() / 4);
+			PixelArray serial;
+			serial.resize(legacy.getSize());
+			PixelArray parallel;
+			parallel.resize(legacy.getSize());
+
+			HighRezTimer timer;
+			timer.start();
+			legacyBoxMipmap<F32, 3>(pixels, kSize, kSize, WeakArray<U8, PtrSize>(legacy));
+			timer.stop();
+			const Second legacyTime = timer.getElapsedTime();
+
+			timer.start();
+			generateMipmap(pool, ImageMipmapFilter::kBox, pixels, kSize, kSize, 3, true, false, WeakArray<U8, PtrSize>(serial));
+			timer.stop();
+			const Second serialTime = timer.getElapsedTime();
+
+			timer.start();
+			ThreadJobCounter counter;
+			generateMipmap(pool, ImageMipmapFilter::kBox, pixels, kSize, kSize, 3, true, false, WeakArray<U8, PtrSize>(parallel), &jobManager,
+						   &counter);
+			jobManager.waitForCounter(counter);
+			timer.stop();
+			const Second parallelTime = timer.getElapsedTime();
+
+			ANKI_TEST_EXPECT_EQ(memcmp(&serial[0], &parallel[0], serial.getSizeInBytes()), 0);
+
+			timer.start();
+			generateMipmap(pool, ImageMipmapFilter::kKaiser, pixels, kSize, kSize, 3, true, false, WeakArray<U8, PtrSize>(parallel),
+						   &jobManager, &counter);
+			jobManager.waitForCounter(counter);
+			timer.stop();
+			const Second kaiserTime = timer.getElapsedTime();
+
+			ANKI_TEST_LOGI("%ux%u HDR: legacy %.1f MPixels/s, box %.1f MPixels/s, box in %u threads %.1f MPixels/s, Kaiser in %u threads %.1f "
+						   "MPixels/s",
+						   kSize, kSize, mpixels / legacyTime, mpixels / serialTime, jobManager.getThreadCount(), mpixels / parallelTime,
+						   jobManager.getThreadCount(), mpixels / kaiserTime);
+		}
+
+		// sRGB
+		{
+			PixelArray pixels;
+			pixels.resize(PtrSize(kSize) * kSize * 4);
+			for(PtrSize i = 0; i < pixels.getSize(); ++i)
+			{
+				pixels[i] = U8((i * 7) % 251);
+			}
+
+			PixelArray legacy;
+			legacy.resize(pixels.getSize() / 4);
+			PixelArray serial;
+			serial.resize(legacy.getSize());
+			PixelArray parallel;
+			parallel.resize(legacy.getSize());
+
+			HighRezTimer timer;
+			timer.start();
+			legacyBoxMipmap<U8, 4>(pixels, kSize, kSize, WeakArray<U8, PtrSize>(legacy));
+			timer.stop();
+			const Second legacyTime = timer.getElapsedTime();
+
+			timer.start();
+			generateMipmap(pool, ImageMipmapFilter::kBox, pixels, kSize, kSize, 4, false, true, WeakArray<U8, PtrSize>(serial));
+			timer.stop();
+			const Second serialTime = timer.getElapsedTime();
+
+			timer.start();
+			ThreadJobCounter counter;
+			generateMipmap(pool, ImageMipmapFilter::kBox, pixels, kSize, kSize, 4, false, true, WeakArray<U8, PtrSize>(parallel), &jobManager,
+						   &counter);
+			jobManager.waitForCounter(counter);
+			timer.stop();
+			const Second parallelTime = timer.getElapsedTime();
+
+			ANKI_TEST_EXPECT_EQ(memcmp(&serial[0], &parallel[0], serial.getSizeInBytes()), 0);
+
+			timer.start();
+			generateMipmap(pool, ImageMipmapFilter::kKaiser, pixels, kSize, kSize, 4, false, true, WeakArray<U8, PtrSize>(parallel),
+						   &jobManager, &counter);
+			jobManager.waitForCounter(counter);
+			timer.stop();
+			const Second kaiserTime = timer.getElapsedTime();
+
+			ANKI_TEST_LOGI("%ux%u sRGB: legacy %.1f MPixels/s, box %.1f MPixels/s, box in %u threads %.1f MPixels/s, Kaiser in %u threads "
+						   "%.1f MPixels/s",
+						   kSize, kSize, mpixels / legacyTime, mpixels / serialTime, jobManager.getThreadCount(), mpixels / parallelTime,
+						   jobManager.getThreadCount(), mpixels / kaiserTime);
+		}
+	}
+
+	DefaultMemoryPool::freeSingleton();
+}
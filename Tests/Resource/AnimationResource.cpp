@@ -0,0 +1,243 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Resource/AnimationResource.h>
+#include <AnKi/Util/ThreadJobManager.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <AnKi/Util/System.h>
+
+using namespace anki;
+
+namespace {
+
+F32 randomF32(U32& state, F32 min, F32 max)
+{
+	state = state * 1664525u + 1013904223u;
+	return min + (max - min) * (F32(state >> 8) / F32(1u << 24));
+}
+
+/// The old way of sampling. Scan all keyframes.
+void sampleChannelLinear(const AnimationChannel& channel, Second time, AnimationSample& sample)
+{
+	sample.m_position = Vec3(0.0f);
+	sample.m_rotation = Quat::getIdentity();
+	sample.m_scale = 1.0f;
+
+	for(U32 i = 0; i + 1 < channel.m_positions.getSize(); ++i)
+	{
+		const AnimationKeyframe<Vec3>& left = channel.m_positions[i];
+		const AnimationKeyframe<Vec3>& right = channel.m_positions[i + 1];
+		if(time >= left.getTime() && time <= right.getTime())
+		{
+			const Second u = (time - left.getTime()) / (right.getTime() - left.getTime());
+			sample.m_position = linearInterpolate(left.getValue(), right.getValue(), F32(u));
+			break;
+		}
+	}
+
+	for(U32 i = 0; i + 1 < channel.m_rotations.getSize(); ++i)
+	{
+		const AnimationKeyframe<Quat>& left = channel.m_rotations[i];
+		const AnimationKeyframe<Quat>& right = channel.m_rotations[i + 1];
+		if(time >= left.getTime() && time <= right.getTime())
+		{
+			const Second u = (time - left.getTime()) / (right.getTime() - left.getTime());
+			sample.m_rotation = left.getValue().slerp(right.getValue(), F32(u));
+			break;
+		}
+	}
+
+	for(U32 i = 0; i + 1 < channel.m_scales.getSize(); ++i)
+	{
+		const AnimationKeyframe<F32>& left = channel.m_scales[i];
+		const AnimationKeyframe<F32>& right = channel.m_scales[i + 1];
+		if(time >= left.getTime() && time <= right.getTime())
+		{
+			const Second u = (time - left.getTime()) / (right.getTime() - left.getTime());
+			sample.m_scale = linearInterpolate(left.getValue(), right.getValue(), F32(u));
+			break;
+		}
+	}
+}
+
+Bool samplesEqual(const AnimationSample& a, const AnimationSample& b)
+{
+	// q and -q are the same rotation
+	const Vec4 rotA(a.m_rotation.x(), a.m_rotation.y(), a.m_rotation.z(), a.m_rotation.w());
+	const Vec4 rotB(b.m_rotation.x(), b.m_rotation.y(), b.m_rotation.z(), b.m_rotation.w());
+	const F32 rotDiff = min((rotA - rotB).getLengthSquared(), (rotA + rotB).getLengthSquared());
+
+	return (a.m_position - b.m_position).getLengthSquared() < 1e-6f && rotDiff < 1e-6f && absolute(a.m_scale - b.m_scale) < 1e-3f;
+}
+
+} // namespace
+
+ANKI_TEST(Resource, AnimationResource)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+	ResourceMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	constexpr U32 kChannelCount = 64;
+	constexpr U32 kKeyCount = 2000;
+	constexpr Second kDuration = 60.0;
+	U32 seed = 0xBADF00D;
+
+	{
+		// Create the channels. The keys of each channel have different times
+		DynamicArray<AnimationChannel> channels;
+		channels.resize(kChannelCount);
+		for(AnimationChannel& channel : channels)
+		{
+			const U32 keyCount = kKeyCount - U32(randomF32(seed, 0.0f, 100.0f));
+			channel.m_positions.resize(keyCount);
+			channel.m_rotations.resize(keyCount);
+			channel.m_scales.resize(keyCount);
+
+			Second time = randomF32(seed, 0.0f, 0.1f);
+			for(U32 k = 0; k < keyCount; ++k)
+			{
+				channel.m_positions[k] = {time, Vec3(randomF32(seed, -1.0f, 1.0f), randomF32(seed, -1.0f, 1.0f), randomF32(seed, -1.0f, 1.0f))};
+				channel.m_rotations[k] = {time, Quat(Euler(randomF32(seed, -kPi, kPi), randomF32(seed, -kPi, kPi), randomF32(seed, -kPi, kPi)))};
+				channel.m_scales[k] = {time, randomF32(seed, 0.5f, 2.0f)};
+
+				time += kDuration / Second(kKeyCount);
+			}
+		}
+
+		// Compare with the linear scan. Go forward, backwards and randomly to test the cursor
+		{
+			DynamicArray<AnimationChannelCursor> cursors;
+			cursors.resize(kChannelCount);
+			Bool identical = true;
+
+			auto test = [&](Second time) {
+				for(U32 c = 0; c < kChannelCount; ++c)
+				{
+					AnimationSample a, b;
+					sampleAnimationChannel(channels[c], time, cursors[c], a);
+					sampleChannelLinear(channels[c], time, b);
+					identical = identical && samplesEqual(a, b);
+				}
+			};
+
+			for(Second time = -1.0; time < kDuration + 1.0; time += 1.0 / 60.0)
+			{
+				test(time);
+			}
+
+			for(Second time = kDuration + 1.0; time > -1.0; time -= 1.0 / 30.0)
+			{
+				test(time);
+			}
+
+			for(U32 i = 0; i < 1000; ++i)
+			{
+				test(randomF32(seed, -1.0f, F32(kDuration) + 1.0f));
+			}
+
+			// Exactly on the keys
+			for(U32 k = 0; k < kKeyCount - 100; k += 7)
+			{
+				test(channels[0].m_positions[k].getTime());
+			}
+
+			ANKI_TEST_EXPECT_EQ(identical, true);
+		}
+
+		// Benchmark: Many characters sample their channels every frame
+		{
+			constexpr U32 kCharacterCount = 256;
+			constexpr U32 kFrameCount = 8;
+
+			DynamicArray<AnimationChannelCursor> cursors;
+			cursors.resize(kCharacterCount * kChannelCount);
+			DynamicArray<AnimationSample> samples;
+			samples.resize(kCharacterCount * kChannelCount);
+
+			auto characterTime = [&](U32 character, U32 frame) {
+				return mod(Second(character) * 0.37 + Second(frame) / 60.0, kDuration - 1.0) + 0.5;
+			};
+
+			// Linear
+			Second begin = HighRezTimer::getCurrentTime();
+			for(U32 f = 0; f < kFrameCount; ++f)
+			{
+				for(U32 ch = 0; ch < kCharacterCount; ++ch)
+				{
+					for(U32 c = 0; c < kChannelCount; ++c)
+					{
+						sampleChannelLinear(channels[c], characterTime(ch, f), samples[ch * kChannelCount + c]);
+					}
+				}
+			}
+			const Second linearTime = HighRezTimer::getCurrentTime() - begin;
+
+			// With cursors
+			begin = HighRezTimer::getCurrentTime();
+			for(U32 f = 0; f < kFrameCount; ++f)
+			{
+				for(U32 ch = 0; ch < kCharacterCount; ++ch)
+				{
+					for(U32 c = 0; c < kChannelCount; ++c)
+					{
+						sampleAnimationChannel(channels[c], characterTime(ch, f), cursors[ch * kChannelCount + c], samples[ch * kChannelCount + c]);
+					}
+				}
+			}
+			const Second cursorTime = HighRezTimer::getCurrentTime() - begin;
+
+			// Binary search only
+			begin = HighRezTimer::getCurrentTime();
+			for(U32 f = 0; f < kFrameCount; ++f)
+			{
+				for(U32 ch = 0; ch < kCharacterCount; ++ch)
+				{
+					for(U32 c = 0; c < kChannelCount; ++c)
+					{
+						AnimationChannelCursor cursor;
+						sampleAnimationChannel(channels[c], characterTime(ch, f), cursor, samples[ch * kChannelCount + c]);
+					}
+				}
+			}
+			const Second binarySearchTime = HighRezTimer::getCurrentTime() - begin;
+
+			// With cursors and in parallel. Every task samples a few characters
+			ThreadJobManager jobManager(getCpuCoresCount(), false);
+			begin = HighRezTimer::getCurrentTime();
+			for(U32 f = 0; f < kFrameCount; ++f)
+			{
+				constexpr U32 kCharactersPerTask = 16;
+				ThreadJobCounter counter;
+				for(U32 firstCharacter = 0; firstCharacter < kCharacterCount; firstCharacter += kCharactersPerTask)
+				{
+					jobManager.dispatchTask(
+						[&, firstCharacter, f]([[maybe_unused]] U32 threadId) {
+							for(U32 ch = firstCharacter; ch < firstCharacter + kCharactersPerTask; ++ch)
+							{
+								for(U32 c = 0; c < kChannelCount; ++c)
+								{
+									sampleAnimationChannel(channels[c], characterTime(ch, f), cursors[ch * kChannelCount + c],
+														   samples[ch * kChannelCount + c]);
+								}
+							}
+						},
+						&counter);
+				}
+
+				jobManager.waitForCounter(counter);
+			}
+			const Second parallelTime = HighRezTimer::getCurrentTime() - begin;
+
+			ANKI_TEST_LOGI("%u characters x %u channels x %u keys, %u frames: linear %fms, binary search %fms, cursors %fms, "
+						   "cursors in parallel %fms",
+						   kCharacterCount, kChannelCount, kKeyCount, kFrameCount, linearTime * 1000.0, binarySearchTime * 1000.0,
+						   cursorTime * 1000.0, parallelTime * 1000.0);
+		}
+	}
+
+	ResourceMemoryPool::freeSingleton();
+	DefaultMemoryPool::freeSingleton();
+}
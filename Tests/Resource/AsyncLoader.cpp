@@ -266,3 +266,206 @@ ANKI_TEST(Resource, AsyncLoader)
 #endif
 
 } // namespace
+
+namespace {
+
+/// A task that records the order it run and optionally moves to another stage.
+class OrderTask : public AsyncLoaderTask
+{
+public:
+	Atomic<U32>* m_counter;
+	U32* m_order;
+	Atomic<U32>* m_gate;
+	Bool m_moveToProcessStage;
+	Bool m_fail = false;
+	Atomic<U32>* m_canceledCounter = nullptr;
+
+	OrderTask(Atomic<U32>* counter, U32* order, Atomic<U32>* gate = nullptr, Bool moveToProcessStage = false)
+		: m_counter(counter)
+		, m_order(order)
+		, m_gate(gate)
+		, m_moveToProcessStage(moveToProcessStage)
+	{
+	}
+
+	Error operator()(AsyncLoaderTaskContext& ctx) override
+	{
+		// Block until the gate opens
+		while(m_gate && m_gate->load() == 0)
+		{
+			HighRezTimer::sleep(1.0_ms);
+		}
+
+		if(m_moveToProcessStage && ctx.m_stage == AsyncLoaderTaskStage::kIo)
+		{
+			ctx.m_stage = AsyncLoaderTaskStage::kProcess;
+			ctx.m_resubmitTask = true;
+			return Error::kNone;
+		}
+
+		if(m_fail)
+		{
+			return Error::kFunctionFailed;
+		}
+
+		*m_order = m_counter->fetchAdd(1);
+		return Error::kNone;
+	}
+
+	void onCanceled() override
+	{
+		if(m_canceledCounter)
+		{
+			m_canceledCounter->fetchAdd(1);
+		}
+	}
+};
+
+void waitAllTasks(AsyncLoader& loader)
+{
+	while(loader.getTasksInFlightCount() != 0)
+	{
+		HighRezTimer::sleep(1.0_ms);
+	}
+}
+
+} // namespace
+
+ANKI_TEST(Resource, AsyncLoaderScheduling)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+	ResourceMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	constexpr U32 kNotRun = kMaxU32;
+
+	// Priorities. There is one IO thread by default so the order is deterministic
+	{
+		AsyncLoader loader;
+		Atomic<U32> counter(0);
+		Atomic<U32> gate(0);
+		U32 gateOrder = kNotRun;
+		Array<U32, 5> orders;
+		orders.fill(kNotRun);
+		const Array<F32, 5> priorities = {1.0f, 5.0f, -2.0f, 5.0f, 3.0f};
+
+		// Block the IO thread and then queue the rest
+		loader.submitTask(loader.newTask<OrderTask>(&counter, &gateOrder, &gate), 100.0f);
+		for(U32 i = 0; i < orders.getSize(); ++i)
+		{
+			loader.submitTask(loader.newTask<OrderTask>(&counter, &orders[i]), priorities[i]);
+		}
+
+		gate.store(1);
+		waitAllTasks(loader);
+
+		ANKI_TEST_EXPECT_EQ(gateOrder, 0);
+		ANKI_TEST_EXPECT_EQ(orders[1], 1); // Same priority runs in submission order
+		ANKI_TEST_EXPECT_EQ(orders[3], 2);
+		ANKI_TEST_EXPECT_EQ(orders[4], 3);
+		ANKI_TEST_EXPECT_EQ(orders[0], 4);
+		ANKI_TEST_EXPECT_EQ(orders[2], 5);
+	}
+
+	// Cancellation and dependencies
+	{
+		AsyncLoader loader;
+		Atomic<U32> counter(0);
+		Atomic<U32> gate(0);
+		U32 gateOrder = kNotRun;
+		U32 meshAOrder = kNotRun, meshBOrder = kNotRun, modelOrder = kNotRun, canceledOrder = kNotRun, canceledDependentOrder = kNotRun;
+
+		const AsyncLoaderTaskId gateId = loader.submitTask(loader.newTask<OrderTask>(&counter, &gateOrder, &gate));
+
+		// The model waits for the meshes. The meshes have lower priority than the model but they have to run first
+		const AsyncLoaderTaskId meshAId = loader.submitTask(loader.newTask<OrderTask>(&counter, &meshAOrder), -1.0f);
+		const AsyncLoaderTaskId meshBId =
+			loader.submitTask(loader.newTask<OrderTask>(&counter, &meshBOrder, nullptr, true), -2.0f, AsyncLoaderTaskStage::kIo);
+		const Array<AsyncLoaderTaskId, 2> meshIds = {meshAId, meshBId};
+		loader.submitTask(loader.newTask<OrderTask>(&counter, &modelOrder), 10.0f, AsyncLoaderTaskStage::kProcess, meshIds);
+
+		// Cancel a task and the one that depends on it
+		const AsyncLoaderTaskId canceledId = loader.submitTask(loader.newTask<OrderTask>(&counter, &canceledOrder));
+		const Array<AsyncLoaderTaskId, 1> canceledIds = {canceledId};
+		const AsyncLoaderTaskId canceledDependentId =
+			loader.submitTask(loader.newTask<OrderTask>(&counter, &canceledDependentOrder), 0.0f, AsyncLoaderTaskStage::kIo, canceledIds);
+		ANKI_TEST_EXPECT_EQ(loader.cancelTask(canceledId), true);
+		ANKI_TEST_EXPECT_EQ(loader.cancelTask(canceledDependentId), false); // Already canceled
+		ANKI_TEST_EXPECT_EQ(loader.getTasksInFlightCount(), 4);
+
+		gate.store(1);
+		waitAllTasks(loader);
+
+		ANKI_TEST_EXPECT_EQ(loader.cancelTask(gateId), false); // It's done
+		ANKI_TEST_EXPECT_EQ(counter.load(), 4);
+		ANKI_TEST_EXPECT_EQ(canceledOrder, kNotRun);
+		ANKI_TEST_EXPECT_EQ(canceledDependentOrder, kNotRun);
+		ANKI_TEST_EXPECT_LT(meshAOrder, modelOrder);
+		ANKI_TEST_EXPECT_LT(meshBOrder, modelOrder);
+		ANKI_TEST_EXPECT_EQ(modelOrder, 3);
+	}
+
+	// Failed dependencies cancel the dependents and the canceled tasks get notified
+	{
+		AsyncLoader loader;
+		Atomic<U32> counter(0);
+		Atomic<U32> canceledCounter(0);
+		Atomic<U32> gate(0);
+		U32 gateOrder = kNotRun, failedOrder = kNotRun, dependentOrder = kNotRun, dependentDependentOrder = kNotRun, canceledOrder = kNotRun;
+
+		loader.submitTask(loader.newTask<OrderTask>(&counter, &gateOrder, &gate));
+
+		OrderTask* failedTask = loader.newTask<OrderTask>(&counter, &failedOrder);
+		failedTask->m_fail = true;
+		failedTask->m_canceledCounter = &canceledCounter;
+		const Array<AsyncLoaderTaskId, 1> failedIds = {loader.submitTask(failedTask)};
+
+		OrderTask* dependentTask = loader.newTask<OrderTask>(&counter, &dependentOrder);
+		dependentTask->m_canceledCounter = &canceledCounter;
+		const Array<AsyncLoaderTaskId, 1> dependentIds = {loader.submitTask(dependentTask, 0.0f, AsyncLoaderTaskStage::kProcess, failedIds)};
+
+		OrderTask* dependentDependentTask = loader.newTask<OrderTask>(&counter, &dependentDependentOrder);
+		dependentDependentTask->m_canceledCounter = &canceledCounter;
+		loader.submitTask(dependentDependentTask, 0.0f, AsyncLoaderTaskStage::kIo, dependentIds);
+
+		OrderTask* canceledTask = loader.newTask<OrderTask>(&counter, &canceledOrder);
+		canceledTask->m_canceledCounter = &canceledCounter;
+		ANKI_TEST_EXPECT_EQ(loader.cancelTask(loader.submitTask(canceledTask)), true);
+		ANKI_TEST_EXPECT_EQ(canceledCounter.load(), 1);
+
+		gate.store(1);
+		waitAllTasks(loader);
+
+		ANKI_TEST_EXPECT_EQ(counter.load(), 1);
+		ANKI_TEST_EXPECT_EQ(canceledCounter.load(), 3); // The failed task is not canceled
+		ANKI_TEST_EXPECT_EQ(failedOrder, kNotRun);
+		ANKI_TEST_EXPECT_EQ(dependentOrder, kNotRun);
+		ANKI_TEST_EXPECT_EQ(dependentDependentOrder, kNotRun);
+		ANKI_TEST_EXPECT_EQ(canceledOrder, kNotRun);
+	}
+
+	// Many tasks from many stages. Some of them won't finish and they will be canceled
+	{
+		Atomic<U32> counter(0);
+		Atomic<U32> canceledCounter(0);
+		DynamicArray<U32> orders;
+		orders.resize(1000, kNotRun);
+
+		{
+			AsyncLoader loader;
+
+			for(U32 i = 0; i < orders.getSize(); ++i)
+			{
+				OrderTask* task = loader.newTask<OrderTask>(&counter, &orders[i], nullptr, (i % 3) == 0);
+				task->m_canceledCounter = &canceledCounter;
+				loader.submitTask(task, F32(i % 7), (i % 2) ? AsyncLoaderTaskStage::kIo : AsyncLoaderTaskStage::kProcess);
+			}
+
+			HighRezTimer::sleep(1.0_ms);
+		}
+
+		ANKI_TEST_EXPECT_EQ(counter.load() + canceledCounter.load(), orders.getSize());
+	}
+
+	ResourceMemoryPool::freeSingleton();
+	DefaultMemoryPool::freeSingleton();
+}
@@ -0,0 +1,217 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Resource/CookedResourceCache.h>
+#include <AnKi/Resource/CookedResourceBinary.h>
+#include <AnKi/Resource/SkeletonResource.h>
+#include <AnKi/Resource/MaterialResource.h>
+#include <AnKi/Resource/ParticleEmitterResource.h>
+#include <AnKi/Util/HighRezTimer.h>
+
+using namespace anki;
+
+static void generateSkeleton(U32 boneCount, ResourceString& xml)
+{
+	xml = "<skeleton><bones>\n";
+	for(U32 i = 0; i < boneCount; ++i)
+	{
+		xml += ResourceString().sprintf("<bone name=\"bone_%u\" transform=\"1 0 0 %u 0 1 0 0 0 0 1 0\" boneTransform=\"1 0 0 0 0 1 0 %u 0 0 1 0\"", i,
+										i, i * 2);
+		if(i > 0)
+		{
+			xml += ResourceString().sprintf(" parent=\"bone_%u\"", (i - 1) / 4);
+		}
+		xml += "/>\n";
+	}
+	xml += "</bones></skeleton>\n";
+}
+
+ANKI_TEST(Resource, CookedResourceCache)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+	ResourceMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	{
+		String dir;
+		ANKI_TEST_EXPECT_NO_ERR(getTempDirectory(dir));
+		dir += "/AnKiCookedResourceCacheTest";
+		if(directoryExists(dir))
+		{
+			ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
+		}
+		ANKI_TEST_EXPECT_NO_ERR(createDirectory(dir));
+
+		constexpr U32 kBoneCount = 2048;
+		ResourceString xml;
+		generateSkeleton(kBoneCount, xml);
+
+		Bool cooked = false;
+		auto cookSkeleton = [&](BaseMemoryPool& pool, CookedSkeleton& out) {
+			cooked = true;
+			return SkeletonResource::cook(xml, pool, out);
+		};
+
+		U32 wrongCount = 0;
+		auto checkSkeleton = [&](const CookedSkeleton& skeleton) {
+			wrongCount += skeleton.m_bones.getSize() != kBoneCount;
+			for(U32 i = 0; i < skeleton.m_bones.getSize(); ++i)
+			{
+				const CookedSkeletonBone& bone = skeleton.m_bones[i];
+				wrongCount += CString(bone.m_name.getBegin()) != ResourceString().sprintf("bone_%u", i);
+				wrongCount += bone.m_parent != ((i > 0) ? (i - 1) / 4 : kMaxU32);
+				wrongCount += bone.m_transform[3] != F32(i) || bone.m_vertexTransform[7] != F32(i * 2);
+			}
+			return Error::kNone;
+		};
+
+		CookedResourceCache cache;
+		ANKI_TEST_EXPECT_NO_ERR(cache.init(dir));
+
+		// Cold, it gets cooked
+		Second begin = HighRezTimer::getCurrentTime();
+		ANKI_TEST_EXPECT_NO_ERR(cache.load<CookedSkeleton>("Skeleton.ankiskel", xml, cookSkeleton, checkSkeleton));
+		const Second coldTime = HighRezTimer::getCurrentTime() - begin;
+		ANKI_TEST_EXPECT_EQ(cooked, true);
+		ANKI_TEST_EXPECT_EQ(cache.getMissCount(), 1);
+
+		// Warm, it's read from the cache
+		cooked = false;
+		begin = HighRezTimer::getCurrentTime();
+		ANKI_TEST_EXPECT_NO_ERR(cache.load<CookedSkeleton>("Skeleton.ankiskel", xml, cookSkeleton, checkSkeleton));
+		const Second warmTime = HighRezTimer::getCurrentTime() - begin;
+		ANKI_TEST_EXPECT_EQ(cooked, false);
+		ANKI_TEST_EXPECT_EQ(cache.getHitCount(), 1);
+
+		ANKI_TEST_EXPECT_EQ(wrongCount, 0);
+		ANKI_TEST_LOGI("Skeleton with %u bones: Parse XML and cook %fms, read cooked %fms", kBoneCount, coldTime * 1000.0, warmTime * 1000.0);
+
+		// Another cache in the same directory (next run of the app) gets hits
+		{
+			CookedResourceCache cache2;
+			ANKI_TEST_EXPECT_NO_ERR(cache2.init(dir));
+			ANKI_TEST_EXPECT_NO_ERR(cache2.load<CookedSkeleton>("Skeleton.ankiskel", xml, cookSkeleton, checkSkeleton));
+			ANKI_TEST_EXPECT_EQ(cooked, false);
+			ANKI_TEST_EXPECT_EQ(cache2.getHitCount(), 1);
+		}
+
+		// Edit the source, it gets cooked again
+		xml += " ";
+		ANKI_TEST_EXPECT_NO_ERR(cache.load<CookedSkeleton>("Skeleton.ankiskel", xml, cookSkeleton, checkSkeleton));
+		ANKI_TEST_EXPECT_EQ(cooked, true);
+		ANKI_TEST_EXPECT_EQ(cache.getMissCount(), 2);
+		ANKI_TEST_EXPECT_EQ(wrongCount, 0);
+
+		// Errors in the XML are reported
+		{
+			CString badXml = "<skeleton><bones><bone name=\"a\" transform=\"1 0 0\" boneTransform=\"1 0 0 0 0 1 0 0 0 0 1 0\"/></bones></skeleton>";
+			ANKI_TEST_EXPECT_ERR(cache.load<CookedSkeleton>(
+									 "Bad.ankiskel", badXml,
+									 [&](BaseMemoryPool& pool, CookedSkeleton& out) {
+										 return SkeletonResource::cook(badXml, pool, out);
+									 },
+									 checkSkeleton),
+								 Error::kUserData);
+		}
+
+		// Without a directory it always cooks
+		{
+			CookedResourceCache cache2;
+			ANKI_TEST_EXPECT_NO_ERR(cache2.init(CString()));
+			for(U32 i = 0; i < 2; ++i)
+			{
+				cooked = false;
+				ANKI_TEST_EXPECT_NO_ERR(cache2.load<CookedSkeleton>("Skeleton.ankiskel", xml, cookSkeleton, checkSkeleton));
+				ANKI_TEST_EXPECT_EQ(cooked, true);
+			}
+			ANKI_TEST_EXPECT_EQ(cache2.getMissCount(), 2);
+			ANKI_TEST_EXPECT_EQ(wrongCount, 0);
+		}
+
+		// Material
+		{
+			const CString materialXml = R"(<material>
+	<shaderPrograms>
+		<shaderProgram name="GBufferGeneric">
+			<mutation>
+				<mutator name="DIFFUSE_TEX" value="1"/>
+				<mutator name="EMISSIVE_TEX" value="0"/>
+			</mutation>
+		</shaderProgram>
+		<shaderProgram name="RtShadowsHit"/>
+	</shaderPrograms>
+	<inputs>
+		<input name="m_diffuseTex" value="Textures/Diffuse.ankitex"/>
+		<input name="m_emission" value="0.5 -1 2e-3"/>
+	</inputs>
+</material>)";
+
+			for(U32 i = 0; i < 2; ++i)
+			{
+				ANKI_TEST_EXPECT_NO_ERR(cache.load<CookedMaterial>(
+					"Material.ankimtl", materialXml,
+					[&](BaseMemoryPool& pool, CookedMaterial& out) {
+						return MaterialResource::cook(materialXml, pool, out);
+					},
+					[&](const CookedMaterial& mtl) {
+						wrongCount += mtl.m_programs.getSize() != 2 || mtl.m_inputs.getSize() != 2;
+						wrongCount += CString(mtl.m_programs[0].m_name.getBegin()) != "GBufferGeneric";
+						wrongCount += mtl.m_programs[0].m_mutation.getSize() != 2 || mtl.m_programs[1].m_mutation.getSize() != 0;
+						wrongCount += CString(mtl.m_programs[0].m_mutation[1].m_name.getBegin()) != "EMISSIVE_TEX";
+						wrongCount += mtl.m_programs[0].m_mutation[0].m_value != 1;
+
+						wrongCount += CString(mtl.m_inputs[0].m_value.getBegin()) != "Textures/Diffuse.ankitex";
+						wrongCount += mtl.m_inputs[0].m_numbers.getSize() != 0;
+						wrongCount += mtl.m_inputs[1].m_numbers.getSize() != 3;
+						wrongCount +=
+							mtl.m_inputs[1].m_numbers[0] != 0.5 || mtl.m_inputs[1].m_numbers[1] != -1.0 || mtl.m_inputs[1].m_numbers[2] != 2e-3;
+						return Error::kNone;
+					}));
+			}
+
+			ANKI_TEST_EXPECT_EQ(wrongCount, 0);
+		}
+
+		// Particle emitter
+		{
+			const CString emitterXml = R"(<particleEmitter>
+	<life min="2" max="3"/>
+	<forceDirection value="0 -1 0"/>
+	<maxNumberOfParticles value="100"/>
+	<emissionPeriod value="0.5"/>
+	<particlesPerEmission value="4"/>
+	<material value="Materials/Smoke.ankimtl"/>
+</particleEmitter>)";
+
+			for(U32 i = 0; i < 2; ++i)
+			{
+				ANKI_TEST_EXPECT_NO_ERR(cache.load<CookedParticleEmitter>(
+					"Emitter.ankipart", emitterXml,
+					[&](BaseMemoryPool& pool, CookedParticleEmitter& out) {
+						return ParticleEmitterResource::cook(emitterXml, pool, out);
+					},
+					[&](const CookedParticleEmitter& emitter) {
+						ParticleEmitterProperties props;
+						wrongCount += emitter.m_properties.getSize() != sizeof(props);
+						memcpy(static_cast<void*>(&props), emitter.m_properties.getBegin(), sizeof(props));
+
+						wrongCount += props.m_particle.m_minLife != 2.0 || props.m_particle.m_maxLife != 3.0;
+						wrongCount += props.m_particle.m_maxForceDirection != Vec3(0.0f, -1.0f, 0.0f);
+						wrongCount += props.m_maxNumOfParticles != 100 || props.m_particlesPerEmission != 4 || props.m_emissionPeriod != 0.5f;
+						wrongCount += CString(emitter.m_material.getBegin()) != "Materials/Smoke.ankimtl";
+						return Error::kNone;
+					}));
+			}
+
+			ANKI_TEST_EXPECT_EQ(wrongCount, 0);
+		}
+
+		ANKI_TEST_EXPECT_EQ(cache.getHitCount(), 3);
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
+	}
+
+	ResourceMemoryPool::freeSingleton();
+	DefaultMemoryPool::freeSingleton();
+}
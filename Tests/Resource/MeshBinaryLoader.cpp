@@ -0,0 +1,228 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Resource/MeshBinaryLoader.h>
+#include <AnKi/Util/Filesystem.h>
+#include <AnKi/Util/HighRezTimer.h>
+
+using namespace anki;
+
+ANKI_TEST(Resource, MeshBinaryLoader)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+	ResourceMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	{
+		// A big mesh with 2 LODs. Odd counts so the buffers need padding
+		constexpr U32 kLodCount = 2;
+		constexpr Array<U32, kLodCount> kVertexCounts = {65535, 12347};
+		constexpr Array<U32, kLodCount> kIndexCounts = {3 * 500001, 3 * 100003};
+		constexpr Array<U32, kLodCount> kMeshletCounts = {4033, 807};
+		constexpr Array<U32, kLodCount> kMeshletVertexCounts = {4033 * 41, 807 * 41 + 3};
+		constexpr U32 kMeshletsBuffer = kMaxU32 - 1;
+		constexpr U32 kMeshletVerticesBuffer = kMaxU32 - 2;
+		constexpr U32 kMeshletPrimitivesBuffer = kMaxU32 - 3;
+		constexpr Array<VertexStreamId, 4> kStreams = {VertexStreamId::kPosition, VertexStreamId::kNormal, VertexStreamId::kTangent,
+													   VertexStreamId::kUv};
+
+		String dir;
+		ANKI_TEST_EXPECT_NO_ERR(getTempDirectory(dir));
+		dir += "/AnKiMeshBinaryLoaderTest";
+		if(directoryExists(dir))
+		{
+			ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
+		}
+		ANKI_TEST_EXPECT_NO_ERR(createDirectory(dir));
+
+		// The value of every byte of a buffer
+		auto bufferByte = [](U32 lod, U32 buffer, PtrSize i) {
+			return U8((i * 7 + buffer * 13 + lod * 31) & 0xFF);
+		};
+
+		// Write the file the way the importer does
+		PtrSize totalBuffersSize = 0; // Only the index and vertex buffers
+		{
+			MeshBinaryHeader header;
+			memset(&header, 0, sizeof(header));
+			memcpy(&header.m_magic[0], kMeshMagic, 8);
+			header.m_indexType = IndexType::kU16;
+			header.m_subMeshCount = 1;
+			header.m_lodCount = kLodCount;
+			header.m_aabbMin = Vec3(-1.0f);
+			header.m_aabbMax = Vec3(1.0f);
+
+			for(VertexStreamId stream : kStreams)
+			{
+				MeshBinaryVertexAttribute& attrib = header.m_vertexAttributes[stream];
+				attrib.m_bufferIndex = U32(stream);
+				attrib.m_format = kMeshRelatedVertexStreamFormats[stream];
+				attrib.m_scale = {1.0f, 1.0f, 1.0f, 1.0f};
+				header.m_vertexBuffers[stream].m_vertexStride = getFormatInfo(attrib.m_format).m_texelSize;
+			}
+
+			MeshBinarySubMesh submesh;
+			memset(&submesh, 0, sizeof(submesh));
+			submesh.m_aabbMin = header.m_aabbMin;
+			submesh.m_aabbMax = header.m_aabbMax;
+
+			for(U32 lod = 0; lod < kLodCount; ++lod)
+			{
+				header.m_totalIndexCounts[lod] = kIndexCounts[lod];
+				header.m_totalVertexCounts[lod] = kVertexCounts[lod];
+				submesh.m_indexCounts[lod] = kIndexCounts[lod];
+				header.m_totalMeshletCounts[lod] = kMeshletCounts[lod];
+				header.m_totalMeshletVertexCounts[lod] = kMeshletVertexCounts[lod];
+				submesh.m_meshletCounts[lod] = kMeshletCounts[lod];
+			}
+
+			String fname = dir;
+			fname += "/mesh.ankimesh";
+			File file;
+			ANKI_TEST_EXPECT_NO_ERR(file.open(fname, FileOpenFlag::kWrite | FileOpenFlag::kBinary));
+			ANKI_TEST_EXPECT_NO_ERR(file.write(&header, sizeof(header)));
+			ANKI_TEST_EXPECT_NO_ERR(file.write(&submesh, sizeof(submesh)));
+
+			DynamicArray<U8, MemoryPoolPtrWrapper<BaseMemoryPool>, PtrSize> data(&DefaultMemoryPool::getSingleton());
+			auto writeBuffer = [&](U32 lod, U32 buffer, PtrSize size) {
+				const PtrSize padding = getAlignedRoundUp(kMeshBinaryBufferAlignment, file.tell()) - file.tell();
+				data.resize(padding + size);
+				memset(&data[0], 0, padding);
+				for(PtrSize i = 0; i < size; ++i)
+				{
+					data[padding + i] = bufferByte(lod, buffer, i);
+				}
+
+				ANKI_TEST_EXPECT_NO_ERR(file.write(&data[0], data.getSize()));
+				totalBuffersSize += (buffer < kMeshletPrimitivesBuffer || buffer == kMaxU32) ? size : 0;
+			};
+
+			for(I32 lod = kLodCount - 1; lod >= 0; --lod)
+			{
+				writeBuffer(lod, kMaxU32, PtrSize(kIndexCounts[lod]) * sizeof(U16));
+
+				for(VertexStreamId stream : kStreams)
+				{
+					writeBuffer(lod, U32(stream), PtrSize(kVertexCounts[lod]) * header.m_vertexBuffers[stream].m_vertexStride);
+				}
+
+				writeBuffer(lod, kMeshletsBuffer, PtrSize(kMeshletCounts[lod]) * sizeof(MeshBinaryMeshlet));
+				writeBuffer(lod, kMeshletVerticesBuffer, PtrSize(kMeshletVertexCounts[lod]) * sizeof(U16));
+				writeBuffer(lod, kMeshletPrimitivesBuffer, PtrSize(kIndexCounts[lod] / 3) * sizeof(U8Vec4));
+			}
+
+			const PtrSize padding = getAlignedRoundUp(kMeshBinaryBufferAlignment, file.tell()) - file.tell();
+			const Array<U8, kMeshBinaryBufferAlignment> zeros = {};
+			ANKI_TEST_EXPECT_NO_ERR(file.write(&zeros[0], padding));
+		}
+
+		{
+			ResourceFilesystem fs;
+			ANKI_TEST_EXPECT_NO_ERR(fs.init());
+			ANKI_TEST_EXPECT_NO_ERR(fs.addNewPath(dir, ResourceStringList()));
+
+			ResourceFilePtr file;
+			ANKI_TEST_EXPECT_NO_ERR(fs.openFile("mesh.ankimesh", file));
+			MeshBinaryLoader loader(&ResourceMemoryPool::getSingleton());
+			ANKI_TEST_EXPECT_NO_ERR(loader.load(file));
+
+			// Per buffer and all the buffers of a LOD at once should give the same data
+			DynamicArray<U8, MemoryPoolPtrWrapper<BaseMemoryPool>, PtrSize> lodBuffers(&DefaultMemoryPool::getSingleton());
+			DynamicArray<U8, MemoryPoolPtrWrapper<BaseMemoryPool>, PtrSize> buffer(&DefaultMemoryPool::getSingleton());
+			Bool identical = true;
+			for(U32 lod = 0; lod < kLodCount; ++lod)
+			{
+				lodBuffers.resize(loader.getLodBuffersSize(lod));
+				ANKI_TEST_EXPECT_NO_ERR(loader.storeLodBuffers(lod, &lodBuffers[0], lodBuffers.getSize()));
+
+				buffer.resize(PtrSize(kIndexCounts[lod]) * sizeof(U16));
+				ANKI_TEST_EXPECT_NO_ERR(loader.storeIndexBuffer(lod, &buffer[0], buffer.getSize()));
+				for(PtrSize i = 0; i < buffer.getSize(); ++i)
+				{
+					identical = identical && buffer[i] == bufferByte(lod, kMaxU32, i) && lodBuffers[i] == buffer[i];
+				}
+
+				for(VertexStreamId stream : kStreams)
+				{
+					const PtrSize offset = loader.getVertexBufferOffsetInLod(lod, U32(stream));
+					ANKI_TEST_EXPECT_EQ(offset % kMeshBinaryBufferAlignment, 0);
+
+					buffer.resize(PtrSize(kVertexCounts[lod]) * loader.getHeader().m_vertexBuffers[stream].m_vertexStride);
+					ANKI_TEST_EXPECT_NO_ERR(loader.storeVertexBuffer(lod, U32(stream), &buffer[0], buffer.getSize()));
+					for(PtrSize i = 0; i < buffer.getSize(); ++i)
+					{
+						identical = identical && buffer[i] == bufferByte(lod, U32(stream), i) && lodBuffers[offset + i] == buffer[i];
+					}
+				}
+
+				// The meshlet buffers are only read with the rest of the LOD
+				const Array<PtrSize, 3> meshletBufferOffsets = {loader.getMeshletsOffsetInLod(lod), loader.getMeshletVerticesOffsetInLod(lod),
+																loader.getMeshletPrimitivesOffsetInLod(lod)};
+				const Array<PtrSize, 3> meshletBufferSizes = {PtrSize(kMeshletCounts[lod]) * sizeof(MeshBinaryMeshlet),
+															  PtrSize(kMeshletVertexCounts[lod]) * sizeof(U16),
+															  PtrSize(kIndexCounts[lod] / 3) * sizeof(U8Vec4)};
+				const Array<U32, 3> meshletBufferIds = {kMeshletsBuffer, kMeshletVerticesBuffer, kMeshletPrimitivesBuffer};
+				for(U32 b = 0; b < 3; ++b)
+				{
+					ANKI_TEST_EXPECT_EQ(meshletBufferOffsets[b] % kMeshBinaryBufferAlignment, 0);
+					ANKI_TEST_EXPECT_LEQ(meshletBufferOffsets[b] + meshletBufferSizes[b], lodBuffers.getSize());
+					for(PtrSize i = 0; i < meshletBufferSizes[b]; ++i)
+					{
+						identical = identical && lodBuffers[meshletBufferOffsets[b] + i] == bufferByte(lod, meshletBufferIds[b], i);
+					}
+				}
+			}
+			ANKI_TEST_EXPECT_EQ(identical, true);
+
+			// Benchmark: Read the buffers one by one vs all the buffers of a LOD with one read
+			constexpr U32 kIterationCount = 50;
+			lodBuffers.resize(loader.getLodBuffersSize(0));
+			Second perBufferTime = 0.0;
+			Second perLodTime = 0.0;
+			for(U32 it = 0; it < kIterationCount; ++it)
+			{
+				Second begin = HighRezTimer::getCurrentTime();
+				for(U32 lod = 0; lod < kLodCount; ++lod)
+				{
+					PtrSize offset = 0;
+					ANKI_TEST_EXPECT_NO_ERR(loader.storeIndexBuffer(lod, &lodBuffers[0], PtrSize(kIndexCounts[lod]) * sizeof(U16)));
+					offset += PtrSize(kIndexCounts[lod]) * sizeof(U16);
+
+					for(VertexStreamId stream : kStreams)
+					{
+						const PtrSize size = PtrSize(kVertexCounts[lod]) * loader.getHeader().m_vertexBuffers[stream].m_vertexStride;
+						ANKI_TEST_EXPECT_NO_ERR(loader.storeVertexBuffer(lod, U32(stream), &lodBuffers[offset], size));
+						offset += size;
+					}
+				}
+				perBufferTime += HighRezTimer::getCurrentTime() - begin;
+
+				begin = HighRezTimer::getCurrentTime();
+				for(U32 lod = 0; lod < kLodCount; ++lod)
+				{
+					ANKI_TEST_EXPECT_NO_ERR(loader.storeLodBuffers(lod, &lodBuffers[0], loader.getLodBuffersSize(lod)));
+				}
+				perLodTime += HighRezTimer::getCurrentTime() - begin;
+			}
+
+			// The reads per LOD read the meshlet buffers as well
+			PtrSize totalLodBuffersSize = 0;
+			for(U32 lod = 0; lod < kLodCount; ++lod)
+			{
+				totalLodBuffersSize += loader.getLodBuffersSize(lod);
+			}
+
+			const F64 totalMb = F64(totalBuffersSize) * kIterationCount / F64(1_MB);
+			const F64 totalLodMb = F64(totalLodBuffersSize) * kIterationCount / F64(1_MB);
+			ANKI_TEST_LOGI("Mesh buffers %fMB: Per buffer reads %fMB/s, one read per LOD %fMB/s", F64(totalBuffersSize) / F64(1_MB),
+						   totalMb / perBufferTime, totalLodMb / perLodTime);
+		}
+
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
+	}
+
+	ResourceMemoryPool::freeSingleton();
+	DefaultMemoryPool::freeSingleton();
+}
@@ -5,6 +5,10 @@
 
 #include <Tests/Framework/Framework.h>
 #include <AnKi/Resource/ResourceFilesystem.h>
+#include <AnKi/Util/Filesystem.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <ZLib/contrib/minizip/zip.h>
+#include <ZLib/contrib/minizip/unzip.h>
 
 ANKI_TEST(Resource, ResourceFilesystem)
 {
@@ -30,4 +34,154 @@ ANKI_TEST(Resource, ResourceFilesystem)
 		ANKI_TEST_EXPECT_NO_ERR(file->readAllText(txt));
 		ANKI_TEST_EXPECT_EQ(txt, "hell\n");
 	}
+
+	// Index the archive twice. The 2nd time the file list comes from the cache
+	{
+		String cacheDir;
+		ANKI_TEST_EXPECT_NO_ERR(getTempDirectory(cacheDir));
+		cacheDir += "/AnKiResourceFilesystemTest";
+		if(directoryExists(cacheDir))
+		{
+			ANKI_TEST_EXPECT_NO_ERR(removeDirectory(cacheDir));
+		}
+		ANKI_TEST_EXPECT_NO_ERR(createDirectory(cacheDir));
+
+		for(U32 i = 0; i < 2; ++i)
+		{
+			ResourceFilesystem fs;
+			ANKI_TEST_EXPECT_NO_ERR(fs.init(cacheDir));
+			ANKI_TEST_EXPECT_NO_ERR(fs.addNewPath("./Tests/Data/Dir.ankizip", ResourceStringList()));
+
+			U32 cacheFileCount = 0;
+			ANKI_TEST_EXPECT_NO_ERR(walkDirectoryTree(cacheDir, [&]([[maybe_unused]] const CString& fname, Bool isDir) -> Error {
+				cacheFileCount += !isDir;
+				return Error::kNone;
+			}));
+			ANKI_TEST_EXPECT_EQ(cacheFileCount, 1);
+
+			ResourceFilePtr file;
+			ANKI_TEST_EXPECT_NO_ERR(fs.openFile("subdir0/hello.txt", file));
+			ResourceString txt;
+			ANKI_TEST_EXPECT_NO_ERR(file->readAllText(txt));
+			ANKI_TEST_EXPECT_EQ(txt, "hell\n");
+		}
+
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(cacheDir));
+	}
+
+	// Open many small files from an archive and compare with using minizip directly
+	{
+		constexpr U32 kFileCount = 10 * 1000;
+
+		String tmpDir;
+		ANKI_TEST_EXPECT_NO_ERR(getTempDirectory(tmpDir));
+		String archiveFilename;
+		archiveFilename.sprintf("%s/AnKiResourceFilesystemTest.ankizip", tmpDir.cstr());
+
+		// Create the archive. Half of the files are stored and the other half deflated
+		auto fileContents = [](U32 i, String& out) {
+			out.sprintf("File %u.", i);
+			for(U32 j = 0; j < i % 32; ++j)
+			{
+				out += " Some text that compresses.";
+			}
+		};
+
+		zipFile zfile = zipOpen(archiveFilename.cstr(), APPEND_STATUS_CREATE);
+		ANKI_TEST_EXPECT_NEQ(zfile, nullptr);
+		for(U32 i = 0; i < kFileCount; ++i)
+		{
+			String fname;
+			fname.sprintf("dir%u/file%u.txt", i % 16, i);
+			String contents;
+			fileContents(i, contents);
+
+			const Bool stored = (i % 2) == 0;
+			ANKI_TEST_EXPECT_EQ(
+				zipOpenNewFileInZip(zfile, fname.cstr(), nullptr, nullptr, 0, nullptr, 0, nullptr, (stored) ? 0 : Z_DEFLATED, Z_DEFAULT_COMPRESSION),
+				ZIP_OK);
+			ANKI_TEST_EXPECT_EQ(zipWriteInFileInZip(zfile, contents.cstr(), contents.getLength()), ZIP_OK);
+			ANKI_TEST_EXPECT_EQ(zipCloseFileInZip(zfile), ZIP_OK);
+		}
+		ANKI_TEST_EXPECT_EQ(zipClose(zfile, nullptr), ZIP_OK);
+
+		ResourceFilesystem fs;
+		ANKI_TEST_EXPECT_NO_ERR(fs.init());
+		ANKI_TEST_EXPECT_NO_ERR(fs.addNewPath(archiveFilename, ResourceStringList()));
+
+		// Mapped filesystem
+		Bool identical = true;
+		Second begin = HighRezTimer::getCurrentTime();
+		for(U32 i = 0; i < kFileCount; ++i)
+		{
+			ResourceString fname;
+			fname.sprintf("dir%u/file%u.txt", i % 16, i);
+
+			ResourceFilePtr file;
+			ANKI_TEST_EXPECT_NO_ERR(fs.openFile(fname, file));
+			ResourceString txt;
+			ANKI_TEST_EXPECT_NO_ERR(file->readAllText(txt));
+
+			String contents;
+			fileContents(i, contents);
+			identical = identical && txt == contents.cstr();
+			identical = identical && (file->getMappedData().getSize() != 0) == ((i % 2) == 0);
+		}
+		const Second mappedTime = HighRezTimer::getCurrentTime() - begin;
+		ANKI_TEST_EXPECT_EQ(identical, true);
+
+		// Minizip, the way the filesystem used to do it. Re-open the archive and go straight to the file for every file
+		DynamicArray<unz_file_pos> filePositions;
+		filePositions.resize(kFileCount);
+		{
+			unzFile zfile = unzOpen(archiveFilename.cstr());
+			ANKI_TEST_EXPECT_EQ(unzGoToFirstFile(zfile), UNZ_OK);
+			for(U32 i = 0; i < kFileCount; ++i)
+			{
+				ANKI_TEST_EXPECT_EQ(unzGetFilePos(zfile, &filePositions[i]), UNZ_OK);
+				unzGoToNextFile(zfile);
+			}
+			unzClose(zfile);
+		}
+
+		begin = HighRezTimer::getCurrentTime();
+		for(U32 i = 0; i < kFileCount; ++i)
+		{
+			unzFile zfile = unzOpen(archiveFilename.cstr());
+			ANKI_TEST_EXPECT_EQ(unzGoToFilePos(zfile, &filePositions[i]), UNZ_OK);
+			unz_file_info info;
+			ANKI_TEST_EXPECT_EQ(unzGetCurrentFileInfo(zfile, &info, nullptr, 0, nullptr, 0, nullptr, 0), UNZ_OK);
+			ANKI_TEST_EXPECT_EQ(unzOpenCurrentFile(zfile), UNZ_OK);
+			String txt('?', info.uncompressed_size);
+			ANKI_TEST_EXPECT_EQ(unzReadCurrentFile(zfile, &txt[0], U32(info.uncompressed_size)), I32(info.uncompressed_size));
+			unzCloseCurrentFile(zfile);
+			unzClose(zfile);
+		}
+		const Second minizipTime = HighRezTimer::getCurrentTime() - begin;
+
+		ANKI_TEST_LOGI("Opening and reading %u files from an archive: memory mapped %fms, minizip %fms", kFileCount, mappedTime * 1000.0,
+					   minizipTime * 1000.0);
+
+		// Seek back and forth in a deflated file
+		{
+			ResourceFilePtr file;
+			ANKI_TEST_EXPECT_NO_ERR(fs.openFile("dir15/file31.txt", file));
+			String contents;
+			fileContents(31, contents);
+
+			Array<Char, 4> buff;
+			ANKI_TEST_EXPECT_NO_ERR(file->seek(10, FileSeekOrigin::kBeginning));
+			ANKI_TEST_EXPECT_NO_ERR(file->read(&buff[0], buff.getSize()));
+			ANKI_TEST_EXPECT_EQ(memcmp(&buff[0], &contents[10], buff.getSize()), 0);
+			ANKI_TEST_EXPECT_NO_ERR(file->seek(2, FileSeekOrigin::kBeginning));
+			ANKI_TEST_EXPECT_NO_ERR(file->read(&buff[0], buff.getSize()));
+			ANKI_TEST_EXPECT_EQ(memcmp(&buff[0], &contents[2], buff.getSize()), 0);
+			ANKI_TEST_EXPECT_NO_ERR(file->seek(contents.getLength() - 4, FileSeekOrigin::kBeginning));
+			ANKI_TEST_EXPECT_NO_ERR(file->read(&buff[0], buff.getSize()));
+			ANKI_TEST_EXPECT_EQ(memcmp(&buff[0], &contents[contents.getLength() - 4], buff.getSize()), 0);
+			ANKI_TEST_EXPECT_EQ(file->read(&buff[0], 1), Error::kFileAccess);
+		}
+
+		ANKI_TEST_EXPECT_NO_ERR(removeFile(archiveFilename));
+	}
 }
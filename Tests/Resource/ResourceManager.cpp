@@ -6,6 +6,8 @@
 #include <Tests/Framework/Framework.h>
 #include <AnKi/Resource/DummyResource.h>
 #include <AnKi/Resource/ResourceManager.h>
+#include <AnKi/Util/ThreadJobManager.h>
+#include <AnKi/Core/StatsSet.h>
 
 ANKI_TEST(Resource, ResourceManager)
 {
@@ -69,6 +71,57 @@ ANKI_TEST(Resource, ResourceManager)
 		}
 	}
 
+	// Many threads load the same resources at the same time. They should all get the same ones
+	{
+		constexpr U32 kThreadCount = 8;
+		constexpr U32 kResourceCount = 64;
+		Array2d<DummyResourcePtr, kThreadCount, kResourceCount> ptrs;
+
+#if ANKI_STATS_ENABLED
+		const U64 hitsBefore = g_resourceCacheHitsStatVar.getValue<U64>();
+		const U64 missesBefore = g_resourceCacheMissesStatVar.getValue<U64>();
+		const U64 waitsBefore = g_resourceLoadWaitsStatVar.getValue<U64>();
+#endif
+
+		ThreadJobManager jobManager(kThreadCount, false);
+		ThreadJobCounter counter;
+		for(U32 t = 0; t < kThreadCount; ++t)
+		{
+			jobManager.dispatchTask(
+				[&ptrs, t]([[maybe_unused]] U32 threadId) {
+					for(U32 r = 0; r < kResourceCount; ++r)
+					{
+						Array<Char, 32> fname;
+						snprintf(fname.getBegin(), fname.getSize(), "concurrent%u", (r + t) % kResourceCount);
+						ANKI_TEST_EXPECT_NO_ERR(
+							ResourceManager::getSingleton().loadResource(fname.getBegin(), ptrs[t][(r + t) % kResourceCount]));
+					}
+				},
+				&counter);
+		}
+		jobManager.waitForCounter(counter);
+
+		for(U32 r = 0; r < kResourceCount; ++r)
+		{
+			for(U32 t = 0; t < kThreadCount; ++t)
+			{
+				ANKI_TEST_EXPECT_NEQ(ptrs[t][r].get(), nullptr);
+				ANKI_TEST_EXPECT_EQ(ptrs[t][r].get(), ptrs[0][r].get());
+			}
+
+			ANKI_TEST_EXPECT_EQ(ptrs[0][r]->getRefcount(), I32(kThreadCount));
+		}
+
+#if ANKI_STATS_ENABLED
+		// Every resource got loaded once. The rest of the requests either found it loaded or waited for the load
+		const U64 hits = g_resourceCacheHitsStatVar.getValue<U64>() - hitsBefore;
+		const U64 misses = g_resourceCacheMissesStatVar.getValue<U64>() - missesBefore;
+		const U64 waits = g_resourceLoadWaitsStatVar.getValue<U64>() - waitsBefore;
+		ANKI_TEST_EXPECT_EQ(misses, kResourceCount);
+		ANKI_TEST_EXPECT_EQ(hits + waits, (kThreadCount - 1) * kResourceCount);
+#endif
+	}
+
 	// Delete
 	ResourceManager::freeSingleton();
 }
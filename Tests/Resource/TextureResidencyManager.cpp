@@ -0,0 +1,176 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Resource/TextureResidencyManager.h>
+
+using namespace anki;
+
+ANKI_TEST(Resource, TextureResidencyManager)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+	ResourceMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	// 5 mips of 256, 64, 16, 4, 1 bytes. The last 2 are the tail
+	const Array<PtrSize, 5> mipSizes = {256, 64, 16, 4, 1};
+	constexpr U32 kTailMipCount = 2;
+	constexpr U32 kEvictionDelay = 4;
+
+	auto applyChanges = [](TextureResidencyManager& mgr, ResourceDynamicArray<TextureResidencyChange>& changes) {
+		for(const TextureResidencyChange& change : changes)
+		{
+			mgr.changeDone(change.m_texture);
+		}
+		changes.destroy();
+	};
+
+	// Incremental loading and the upload budget
+	{
+		TextureResidencyManager mgr(kMaxPtrSize, 64, kEvictionDelay);
+		ResourceDynamicArray<TextureResidencyChange> changes;
+
+		const U32 a = mgr.registerTexture(mipSizes, kTailMipCount, nullptr);
+		const U32 b = mgr.registerTexture(mipSizes, kTailMipCount, nullptr);
+		ANKI_TEST_EXPECT_EQ(mgr.getFirstResidentMip(a), 3);
+		ANKI_TEST_EXPECT_EQ(mgr.getResidentMemory(), 2 * 5);
+
+		// Nothing requested, nothing changes
+		mgr.update(changes);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 0);
+
+		// One mip per frame per texture
+		mgr.requestMip(a, 0);
+		mgr.requestMip(b, 1);
+		mgr.update(changes);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 2);
+		ANKI_TEST_EXPECT_EQ(changes[0].m_load, true);
+		ANKI_TEST_EXPECT_EQ(mgr.getFirstResidentMip(a), 2);
+		ANKI_TEST_EXPECT_EQ(mgr.getFirstResidentMip(b), 2);
+
+		// Busy textures don't change
+		mgr.requestMip(a, 0);
+		mgr.requestMip(b, 1);
+		mgr.update(changes);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 2);
+		applyChanges(mgr, changes);
+
+		// Both want a 64 byte mip but the budget allows only one. The one with the biggest gap goes first
+		mgr.requestMip(a, 0);
+		mgr.requestMip(b, 1);
+		mgr.update(changes);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 1);
+		ANKI_TEST_EXPECT_EQ(changes[0].m_texture, a);
+		applyChanges(mgr, changes);
+
+		// The rest. A mip bigger than the budget is still loaded if it's the only one
+		for(U32 i = 0; i < 2; ++i)
+		{
+			mgr.requestMip(a, 0);
+			mgr.requestMip(b, 1);
+			mgr.update(changes);
+			ANKI_TEST_EXPECT_EQ(changes.getSize(), 1);
+			applyChanges(mgr, changes);
+		}
+
+		ANKI_TEST_EXPECT_EQ(mgr.getFirstResidentMip(a), 0);
+		ANKI_TEST_EXPECT_EQ(mgr.getFirstResidentMip(b), 1);
+		ANKI_TEST_EXPECT_EQ(mgr.getResidentMemory(), (256 + 64 + 16 + 5) + (64 + 16 + 5));
+
+		// Stop requesting. The mips stay for a while and then they are evicted to the tail
+		U32 frame = 0;
+		while(changes.getSize() == 0)
+		{
+			mgr.update(changes);
+			++frame;
+		}
+		ANKI_TEST_EXPECT_EQ(frame, kEvictionDelay);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 2);
+		ANKI_TEST_EXPECT_EQ(changes[0].m_load, false);
+		ANKI_TEST_EXPECT_EQ(changes[0].m_firstResidentMip, 3);
+		ANKI_TEST_EXPECT_EQ(mgr.getResidentMemory(), 2 * 5);
+		applyChanges(mgr, changes);
+
+		mgr.unregisterTexture(a);
+		mgr.unregisterTexture(b);
+		ANKI_TEST_EXPECT_EQ(mgr.getResidentMemory(), 0);
+	}
+
+	// Coarser requests evict after a delay
+	{
+		TextureResidencyManager mgr(kMaxPtrSize, kMaxPtrSize, kEvictionDelay);
+		ResourceDynamicArray<TextureResidencyChange> changes;
+
+		const U32 a = mgr.registerTexture(mipSizes, kTailMipCount, nullptr);
+		for(U32 i = 0; i < 3; ++i)
+		{
+			mgr.requestMip(a, 0);
+			mgr.update(changes);
+			applyChanges(mgr, changes);
+		}
+		ANKI_TEST_EXPECT_EQ(mgr.getFirstResidentMip(a), 0);
+
+		U32 frame = 0;
+		while(mgr.getFirstResidentMip(a) == 0)
+		{
+			mgr.requestMip(a, 2);
+			mgr.update(changes);
+			applyChanges(mgr, changes);
+			++frame;
+		}
+		ANKI_TEST_EXPECT_EQ(frame, kEvictionDelay);
+		ANKI_TEST_EXPECT_EQ(mgr.getFirstResidentMip(a), 2);
+
+		mgr.unregisterTexture(a);
+	}
+
+	// Memory budget. Textures that are not used give their mips to the ones that are used
+	{
+		const PtrSize budget = (256 + 64 + 16 + 5) + 5;
+		TextureResidencyManager mgr(budget, kMaxPtrSize, 1000);
+		ResourceDynamicArray<TextureResidencyChange> changes;
+
+		const U32 a = mgr.registerTexture(mipSizes, kTailMipCount, nullptr);
+		const U32 b = mgr.registerTexture(mipSizes, kTailMipCount, nullptr);
+
+		for(U32 i = 0; i < 3; ++i)
+		{
+			mgr.requestMip(a, 0);
+			mgr.update(changes);
+			applyChanges(mgr, changes);
+		}
+		ANKI_TEST_EXPECT_EQ(mgr.getFirstResidentMip(a), 0);
+		ANKI_TEST_EXPECT_EQ(mgr.getResidentMemory(), budget);
+
+		// B can't load anything while A is in use
+		mgr.requestMip(a, 0);
+		mgr.requestMip(b, 0);
+		mgr.update(changes);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 0);
+
+		// A is not used any more. It gives a mip to B
+		mgr.requestMip(b, 0);
+		mgr.update(changes);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 2);
+		ANKI_TEST_EXPECT_EQ(mgr.getFirstResidentMip(a), 1);
+		ANKI_TEST_EXPECT_EQ(mgr.getFirstResidentMip(b), 2);
+		applyChanges(mgr, changes);
+
+		for(U32 i = 0; i < 2; ++i)
+		{
+			mgr.requestMip(b, 0);
+			mgr.update(changes);
+			applyChanges(mgr, changes);
+		}
+		ANKI_TEST_EXPECT_EQ(mgr.getFirstResidentMip(a), 3);
+		ANKI_TEST_EXPECT_EQ(mgr.getFirstResidentMip(b), 0);
+		ANKI_TEST_EXPECT_LEQ(mgr.getResidentMemory(), budget);
+
+		mgr.unregisterTexture(a);
+		mgr.unregisterTexture(b);
+	}
+
+	ResourceMemoryPool::freeSingleton();
+	DefaultMemoryPool::freeSingleton();
+}
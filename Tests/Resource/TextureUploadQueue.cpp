@@ -0,0 +1,99 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Resource/TextureUploadQueue.h>
+#include <AnKi/Gr/GrManager.h>
+#include <AnKi/Util/Thread.h>
+
+using namespace anki;
+
+namespace {
+
+class UploadThreadCtx
+{
+public:
+	TextureUploadQueue* m_queue = nullptr;
+	TexturePtr m_tex;
+	PtrSize m_layerSize = 0;
+	Atomic<U32>* m_copyCount = nullptr;
+};
+
+} // namespace
+
+ANKI_TEST(Resource, TextureUploadQueue)
+{
+	ResourceMemoryPool::allocateSingleton(allocAligned, nullptr);
+	NativeWindow* win = createWindow();
+	createGrManager(win);
+
+	{
+		// The smallest budget. It's two pools of TransferGpuAllocator::kChunkInitialSize
+		TransferGpuAllocator transferAlloc;
+		ANKI_TEST_EXPECT_NO_ERR(transferAlloc.init(0));
+		TextureUploadQueue queue(transferAlloc);
+
+		// Every copy takes a quarter of a pool so the threads run out of staging memory often and they wait for the copies of each other.
+		// Nobody calls endFrame() so only the queue itself can flush the pending copies
+		constexpr U32 kThreadCount = 2;
+		constexpr U32 kLayerCount = 8;
+		constexpr U32 kTexSize = 2048;
+		constexpr PtrSize kLayerSize = PtrSize(kTexSize) * kTexSize * 4;
+		static_assert(kLayerSize * 4 == TransferGpuAllocator::kChunkInitialSize);
+
+		Atomic<U32> copyCount(0);
+		Array<UploadThreadCtx, kThreadCount> ctxs;
+		for(UploadThreadCtx& ctx : ctxs)
+		{
+			TextureInitInfo texInit("UploadTest");
+			texInit.m_width = kTexSize;
+			texInit.m_height = kTexSize;
+			texInit.m_layerCount = kLayerCount;
+			texInit.m_type = TextureType::k2DArray;
+			texInit.m_format = Format::kR8G8B8A8_Unorm;
+			texInit.m_usage = TextureUsageBit::kTransferDestination | TextureUsageBit::kAllSampled;
+
+			ctx.m_queue = &queue;
+			ctx.m_tex = GrManager::getSingleton().newTexture(texInit);
+			ctx.m_layerSize = kLayerSize;
+			ctx.m_copyCount = &copyCount;
+		}
+
+		Thread threadA("UploadA");
+		Thread threadB("UploadB");
+		const Array<Thread*, kThreadCount> threads = {&threadA, &threadB};
+		for(U32 i = 0; i < kThreadCount; ++i)
+		{
+			threads[i]->start(&ctxs[i], [](ThreadCallbackInfo& info) -> Error {
+				UploadThreadCtx& ctx = *static_cast<UploadThreadCtx*>(info.m_userData);
+				for(U32 layer = 0; layer < ctx.m_tex->getLayerCount(); ++layer)
+				{
+					TransferGpuAllocatorHandle handle;
+					ANKI_CHECK(ctx.m_queue->allocate(ctx.m_layerSize, handle));
+					memset(handle.getMappedMemory(), layer, ctx.m_layerSize);
+
+					ctx.m_queue->pushCopy(handle, *ctx.m_tex, TextureSubresourceInfo(TextureSurfaceInfo(0, 0, 0, layer)));
+					ctx.m_copyCount->fetchAdd(1);
+				}
+
+				return Error::kNone;
+			});
+		}
+
+		for(Thread* thread : threads)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(thread->join());
+		}
+
+		ANKI_TEST_EXPECT_EQ(copyCount.load(), kThreadCount * kLayerCount);
+
+		queue.flush();
+		GrManager::getSingleton().finish();
+	}
+
+	GrManager::freeSingleton();
+	NativeWindow::freeSingleton();
+	ResourceMemoryPool::freeSingleton();
+}
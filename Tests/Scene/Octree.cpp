@@ -0,0 +1,306 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Scene/Octree.h>
+#include <AnKi/Collision/Functions.h>
+#include <AnKi/Collision/Sphere.h>
+#include <AnKi/Collision/Ray.h>
+#include <AnKi/Util/ThreadJobManager.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <AnKi/Util/System.h>
+#include <algorithm>
+
+using namespace anki;
+
+namespace {
+
+constexpr F32 kWorldHalfSize = 1024.0f;
+
+class Random
+{
+public:
+	U32 m_state = 0x12345678;
+
+	U32 next()
+	{
+		m_state ^= m_state << 13;
+		m_state ^= m_state >> 17;
+		m_state ^= m_state << 5;
+		return m_state;
+	}
+
+	F32 nextF32(F32 min, F32 max)
+	{
+		return min + (max - min) * (F32(next() & 0xFFFFFF) / F32(0xFFFFFF));
+	}
+};
+
+/// Mostly small objects, a few big ones and some outside the octree.
+Aabb randomAabb(Random& rand)
+{
+	const U32 kind = rand.next() % 100;
+	const F32 worldHalfSize = (kind == 0) ? kWorldHalfSize * 1.5f : kWorldHalfSize;
+	const Vec3 center(rand.nextF32(-worldHalfSize, worldHalfSize), rand.nextF32(-worldHalfSize, worldHalfSize),
+					  rand.nextF32(-worldHalfSize, worldHalfSize));
+	const F32 halfSize = (kind == 1) ? rand.nextF32(20.0f, 200.0f) : rand.nextF32(0.25f, 4.0f);
+	return Aabb(center - halfSize, center + halfSize);
+}
+
+Array<Plane, 6> createFrustumPlanes(const Vec3& origin, F32 angle)
+{
+	const Mat4 proj = Mat4::calculatePerspectiveProjectionMatrix(toRad(60.0f), toRad(40.0f), 0.1f, 800.0f);
+	const Mat4 camTrf(origin.xyz1(), Mat3(Euler(0.0f, angle, 0.0f)), 1.0f);
+	Array<Plane, 6> planes;
+	extractClipPlanes(proj * camTrf.getInverse(), planes);
+	return planes;
+}
+
+Bool insidePlanes(ConstWeakArray<Plane> planes, const Aabb& aabb)
+{
+	for(const Plane& plane : planes)
+	{
+		if(testPlane(plane, aabb) < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void* indexToUserData(U32 idx)
+{
+	return numberToPtr<void*>(idx + 1);
+}
+
+/// Sort the results of a query and compare them with the results of a linear scan.
+Bool sameResults(OctreeGatherArray& octreeResults, DynamicArray<void*>& linearResults)
+{
+	if(octreeResults.getSize() != linearResults.getSize())
+	{
+		return false;
+	}
+
+	std::sort(octreeResults.getBegin(), octreeResults.getEnd());
+	std::sort(linearResults.getBegin(), linearResults.getEnd());
+	return std::equal(octreeResults.getBegin(), octreeResults.getEnd(), linearResults.getBegin());
+}
+
+void benchmark(U32 count, ThreadJobManager& jobManager, StackMemoryPool& pool)
+{
+	Random rand;
+	Octree octree;
+	octree.init(Vec3(-kWorldHalfSize), Vec3(kWorldHalfSize), 5);
+
+	DynamicArray<Aabb> aabbs;
+	DynamicArray<U32> placeables;
+	aabbs.resize(count);
+	placeables.resize(count);
+
+	Second begin = HighRezTimer::getCurrentTime();
+	for(U32 i = 0; i < count; ++i)
+	{
+		aabbs[i] = randomAabb(rand);
+		placeables[i] = octree.newPlaceable(aabbs[i], indexToUserData(i));
+	}
+	const Second insertTime = HighRezTimer::getCurrentTime() - begin;
+
+	// Move 10% of the objects a little
+	const U32 movedCount = count / 10;
+	begin = HighRezTimer::getCurrentTime();
+	for(U32 i = 0; i < movedCount; ++i)
+	{
+		const U32 idx = (i * 7919) % count;
+		const Vec4 offset(rand.nextF32(-1.0f, 1.0f), 0.0f, rand.nextF32(-1.0f, 1.0f), 0.0f);
+		aabbs[idx] = Aabb(aabbs[idx].getMin() + offset, aabbs[idx].getMax() + offset);
+		octree.updatePlaceable(placeables[idx], aabbs[idx]);
+	}
+	const Second updateTime = HighRezTimer::getCurrentTime() - begin;
+
+	const Array<Plane, 6> planes = createFrustumPlanes(Vec3(0.0f, 10.0f, 0.0f), 0.3f);
+
+	// Linear scan
+	DynamicArray<void*> linearResults;
+	begin = HighRezTimer::getCurrentTime();
+	for(U32 i = 0; i < count; ++i)
+	{
+		if(insidePlanes(planes, aabbs[i]))
+		{
+			linearResults.emplaceBack(indexToUserData(i));
+		}
+	}
+	const Second linearTime = HighRezTimer::getCurrentTime() - begin;
+
+	// Octree
+	OctreeGatherArray serialResults(&pool);
+	begin = HighRezTimer::getCurrentTime();
+	octree.gatherVisible(planes, serialResults);
+	const Second serialTime = HighRezTimer::getCurrentTime() - begin;
+
+	OctreeGatherArray parallelResults(&pool);
+	begin = HighRezTimer::getCurrentTime();
+	octree.gatherVisible(planes, parallelResults, &jobManager);
+	const Second parallelTime = HighRezTimer::getCurrentTime() - begin;
+
+	// Small AABB query
+	const Aabb queryAabb(Vec3(-50.0f), Vec3(50.0f));
+	OctreeGatherArray aabbResults(&pool);
+	begin = HighRezTimer::getCurrentTime();
+	octree.gatherOverlapping(queryAabb, aabbResults);
+	const Second aabbTime = HighRezTimer::getCurrentTime() - begin;
+
+	ANKI_TEST_LOGI("%u objects: Insert %fms. Update %u %fms. Frustum (%u visible): linear %fms, octree %fms, octree parallel %fms. "
+				   "AABB query (%u overlapping) %fms. %u cells",
+				   count, insertTime * 1000.0, movedCount, updateTime * 1000.0, linearResults.getSize(), linearTime * 1000.0, serialTime * 1000.0,
+				   parallelTime * 1000.0, aabbResults.getSize(), aabbTime * 1000.0, octree.getCellCount());
+
+	ANKI_TEST_EXPECT_EQ(serialResults.getSize(), linearResults.getSize());
+	ANKI_TEST_EXPECT_EQ(sameResults(parallelResults, linearResults), true);
+
+	for(U32 placeable : placeables)
+	{
+		octree.deletePlaceable(placeable);
+	}
+
+	pool.reset();
+}
+
+} // namespace
+
+ANKI_TEST(Scene, Octree)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+	SceneMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	{
+		StackMemoryPool pool(allocAligned, nullptr, 1_MB);
+		ThreadJobManager jobManager(getCpuCoresCount(), false);
+
+		// All queries against a linear scan
+		{
+			Random rand;
+			Octree octree;
+			octree.init(Vec3(-kWorldHalfSize), Vec3(kWorldHalfSize), 6);
+
+			constexpr U32 kCount = 5000;
+			DynamicArray<Aabb> aabbs;
+			DynamicArray<U32> placeables;
+			DynamicArray<Bool> alive;
+			aabbs.resize(kCount);
+			placeables.resize(kCount);
+			alive.resize(kCount, true);
+			for(U32 i = 0; i < kCount; ++i)
+			{
+				aabbs[i] = randomAabb(rand);
+				placeables[i] = octree.newPlaceable(aabbs[i], indexToUserData(i));
+			}
+
+			// Move some far away, move some a little and delete some
+			for(U32 i = 0; i < kCount; i += 3)
+			{
+				if(i % 2)
+				{
+					aabbs[i] = randomAabb(rand);
+				}
+				else
+				{
+					const Vec4 offset(0.5f, -0.5f, 0.25f, 0.0f);
+					aabbs[i] = Aabb(aabbs[i].getMin() + offset, aabbs[i].getMax() + offset);
+				}
+
+				octree.updatePlaceable(placeables[i], aabbs[i]);
+				ANKI_TEST_EXPECT_EQ(octree.getPlaceableAabb(placeables[i]).getMin(), aabbs[i].getMin());
+			}
+
+			for(U32 i = 1; i < kCount; i += 5)
+			{
+				octree.deletePlaceable(placeables[i]);
+				alive[i] = false;
+			}
+
+			auto check = [&](auto testFunc, auto queryFunc) {
+				DynamicArray<void*> linearResults;
+				for(U32 i = 0; i < kCount; ++i)
+				{
+					if(alive[i] && testFunc(aabbs[i]))
+					{
+						linearResults.emplaceBack(indexToUserData(i));
+					}
+				}
+
+				OctreeGatherArray results(&pool);
+				queryFunc(results);
+				ANKI_TEST_EXPECT_GT(linearResults.getSize(), 0);
+				ANKI_TEST_EXPECT_EQ(sameResults(results, linearResults), true);
+			};
+
+			for(U32 i = 0; i < 4; ++i)
+			{
+				const Array<Plane, 6> planes = createFrustumPlanes(Vec3(F32(i) * 100.0f, 0.0f, 0.0f), F32(i) * 1.5f);
+				auto test = [&](const Aabb& aabb) {
+					return insidePlanes(planes, aabb);
+				};
+
+				check(test, [&](OctreeGatherArray& out) {
+					octree.gatherVisible(planes, out);
+				});
+				check(test, [&](OctreeGatherArray& out) {
+					octree.gatherVisible(planes, out, &jobManager);
+				});
+			}
+
+			const Aabb queryAabb(Vec3(-200.0f, -100.0f, -300.0f), Vec3(100.0f, 150.0f, 0.0f));
+			check(
+				[&](const Aabb& aabb) {
+					return testCollision(aabb, queryAabb);
+				},
+				[&](OctreeGatherArray& out) {
+					octree.gatherOverlapping(queryAabb, out);
+				});
+
+			const Sphere sphere(Vec3(100.0f, 0.0f, -100.0f), 300.0f);
+			check(
+				[&](const Aabb& aabb) {
+					return testCollision(aabb, sphere);
+				},
+				[&](OctreeGatherArray& out) {
+					octree.gatherOverlapping(sphere, out);
+				});
+
+			// Ray through a big object so it hits something
+			const Vec3 rayTarget = ((aabbs[0].getMin() + aabbs[0].getMax()) * 0.5f).xyz();
+			const Ray ray(Vec3(-1500.0f, 20.0f, 30.0f), (rayTarget - Vec3(-1500.0f, 20.0f, 30.0f)).getNormalized());
+			check(
+				[&](const Aabb& aabb) {
+					return testCollision(aabb, ray);
+				},
+				[&](OctreeGatherArray& out) {
+					octree.gatherOverlapping(ray, out);
+				});
+
+			// Delete everything, only the root should remain
+			for(U32 i = 0; i < kCount; ++i)
+			{
+				if(alive[i])
+				{
+					octree.deletePlaceable(placeables[i]);
+				}
+			}
+
+			ANKI_TEST_EXPECT_EQ(octree.getPlaceableCount(), 0);
+			ANKI_TEST_EXPECT_EQ(octree.getCellCount(), 1);
+
+			pool.reset();
+		}
+
+		// Benchmarks
+		benchmark(10 * 1000, jobManager, pool);
+		benchmark(100 * 1000, jobManager, pool);
+		benchmark(1000 * 1000, jobManager, pool);
+	}
+
+	SceneMemoryPool::freeSingleton();
+	DefaultMemoryPool::freeSingleton();
+}
@@ -0,0 +1,173 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Scene/SoftwareRasterizer.h>
+#include <AnKi/Collision/Aabb.h>
+#include <AnKi/Util/ThreadJobManager.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <AnKi/Util/System.h>
+
+using namespace anki;
+
+/// Append a quad facing the camera (that looks at -z) as 2 triangles.
+static void appendQuad(F32 minX, F32 minY, F32 maxX, F32 maxY, F32 z, DynamicArray<Vec3>& verts)
+{
+	verts.emplaceBack(minX, minY, z);
+	verts.emplaceBack(maxX, minY, z);
+	verts.emplaceBack(maxX, maxY, z);
+
+	verts.emplaceBack(minX, minY, z);
+	verts.emplaceBack(maxX, maxY, z);
+	verts.emplaceBack(minX, maxY, z);
+}
+
+ANKI_TEST(Scene, SoftwareRasterizer)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+	SceneMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	{
+		constexpr U32 kWidth = 640;
+		constexpr U32 kHeight = 360;
+		const Mat4 proj = Mat4::calculatePerspectiveProjectionMatrix(toRad(90.0f), toRad(60.0f), 0.1f, 1000.0f);
+		const Mat4 view = Mat4::getIdentity(); // Looks at -z
+
+		ThreadJobManager jobManager(getCpuCoresCount(), false);
+		SoftwareRasterizer rasterizer;
+
+		// One big wall at z=-10 that covers the left half of the screen
+		{
+			DynamicArray<Vec3> verts;
+			appendQuad(-100.0f, -100.0f, 0.0f, 100.0f, -10.0f, verts);
+
+			rasterizer.prepare(view, proj, kWidth, kHeight);
+			rasterizer.draw(&verts[0][0], verts.getSize(), sizeof(Vec3), true);
+			rasterizer.rasterize(&jobManager);
+			ANKI_TEST_EXPECT_EQ(rasterizer.getTriangleCount(), 2);
+
+			Array<Aabb, 5> aabbs = {Aabb(Vec3(-3.0f, -1.0f, -21.0f), Vec3(-2.0f, 1.0f, -20.0f)), // Behind the wall
+									Aabb(Vec3(-3.0f, -1.0f, -6.0f), Vec3(-2.0f, 1.0f, -5.0f)), // In front of the wall
+									Aabb(Vec3(2.0f, -1.0f, -21.0f), Vec3(3.0f, 1.0f, -20.0f)), // Right side, nothing in front
+									Aabb(Vec3(-1.0f, -1.0f, -21.0f), Vec3(1.0f, 1.0f, -20.0f)), // Half behind the wall
+									Aabb(Vec3(-1.0f, -1.0f, 1.0f), Vec3(1.0f, 1.0f, 2.0f))}; // Behind the camera
+			Array<Bool, 5> visible;
+			rasterizer.visibilityTests(aabbs, visible);
+
+			ANKI_TEST_EXPECT_EQ(visible[0], false);
+			ANKI_TEST_EXPECT_EQ(visible[1], true);
+			ANKI_TEST_EXPECT_EQ(visible[2], true);
+			ANKI_TEST_EXPECT_EQ(visible[3], true);
+			ANKI_TEST_EXPECT_EQ(visible[4], true); // Touches the near plane, assumed visible
+
+			for(U32 i = 0; i < aabbs.getSize(); ++i)
+			{
+				ANKI_TEST_EXPECT_EQ(rasterizer.visibilityTest(aabbs[i]), visible[i]);
+			}
+
+			// Backfacing wall doesn't occlude
+			DynamicArray<Vec3> backVerts;
+			appendQuad(0.0f, -100.0f, -100.0f, 100.0f, -10.0f, backVerts);
+			rasterizer.prepare(view, proj, kWidth, kHeight);
+			rasterizer.draw(&backVerts[0][0], backVerts.getSize(), sizeof(Vec3), true);
+			rasterizer.rasterize();
+			ANKI_TEST_EXPECT_EQ(rasterizer.visibilityTest(aabbs[0]), true);
+		}
+
+		// Wall that gets clipped by the near plane
+		{
+			DynamicArray<Vec3> verts;
+			verts.emplaceBack(-100.0f, -100.0f, 5.0f);
+			verts.emplaceBack(100.0f, -100.0f, -15.0f);
+			verts.emplaceBack(0.0f, 100.0f, -15.0f);
+
+			rasterizer.prepare(view, proj, kWidth, kHeight);
+			rasterizer.draw(&verts[0][0], verts.getSize(), sizeof(Vec3), false);
+			rasterizer.rasterize(&jobManager);
+			ANKI_TEST_EXPECT_GT(rasterizer.getTriangleCount(), 0);
+			ANKI_TEST_EXPECT_EQ(rasterizer.visibilityTest(Aabb(Vec3(-1.0f, -1.0f, -101.0f), Vec3(1.0f, 1.0f, -100.0f))), false);
+		}
+
+		// Same result with fillDepthBuffer()
+		{
+			DynamicArray<F32> depths;
+			depths.resize(kWidth * kHeight, 1.0f);
+			for(U32 y = 0; y < kHeight; ++y)
+			{
+				for(U32 x = 0; x < kWidth / 2; ++x)
+				{
+					depths[y * kWidth + x] = 0.5f;
+				}
+			}
+
+			rasterizer.prepare(view, proj, kWidth, kHeight);
+			rasterizer.fillDepthBuffer(depths);
+
+			ANKI_TEST_EXPECT_EQ(rasterizer.visibilityTest(Aabb(Vec3(-3.0f, -1.0f, -21.0f), Vec3(-2.0f, 1.0f, -20.0f))), false);
+			ANKI_TEST_EXPECT_EQ(rasterizer.visibilityTest(Aabb(Vec3(2.0f, -1.0f, -21.0f), Vec3(3.0f, 1.0f, -20.0f))), true);
+		}
+
+		// Throughput. A grid of small quads in front of the camera, all inside the view
+		{
+			DynamicArray<Vec3> verts;
+			constexpr U32 kQuadsPerRow = 300;
+			for(U32 y = 0; y < kQuadsPerRow; ++y)
+			{
+				for(U32 x = 0; x < kQuadsPerRow; ++x)
+				{
+					const F32 size = 10.0f / F32(kQuadsPerRow);
+					const F32 minX = -5.0f + F32(x) * size;
+					const F32 minY = -5.0f + F32(y) * size;
+					appendQuad(minX, minY, minX + size * 0.9f, minY + size * 0.9f, -10.0f - F32((x + y) % 7), verts);
+				}
+			}
+
+			constexpr U32 kAabbCount = 10000;
+			DynamicArray<Aabb> aabbs;
+			DynamicArray<Bool> visible;
+			aabbs.resize(kAabbCount);
+			visible.resize(kAabbCount);
+			for(U32 i = 0; i < kAabbCount; ++i)
+			{
+				const Vec3 center(F32(i % 100) - 50.0f, F32((i / 100) % 60) - 30.0f, -20.0f - F32(i % 13));
+				aabbs[i] = Aabb(center - 0.5f, center + 0.5f);
+			}
+
+			for(ThreadJobManager* manager : {static_cast<ThreadJobManager*>(nullptr), &jobManager})
+			{
+				rasterizer.prepare(view, proj, 1920, 1080);
+
+				Second begin = HighRezTimer::getCurrentTime();
+				rasterizer.draw(&verts[0][0], verts.getSize(), sizeof(Vec3), true);
+				const Second setupTime = HighRezTimer::getCurrentTime() - begin;
+
+				begin = HighRezTimer::getCurrentTime();
+				rasterizer.rasterize(manager);
+				const Second rasterTime = HighRezTimer::getCurrentTime() - begin;
+
+				begin = HighRezTimer::getCurrentTime();
+				rasterizer.visibilityTests(aabbs, WeakArray<Bool>(visible), manager);
+				const Second testTime = HighRezTimer::getCurrentTime() - begin;
+
+				U32 visibleCount = 0;
+				for(Bool v : visible)
+				{
+					visibleCount += v;
+				}
+
+				const F64 triCount = F64(rasterizer.getTriangleCount());
+				ANKI_TEST_LOGI("%s: %u triangles. Setup %f tris/ms, rasterization %f tris/ms. %u AABB tests in %fms, %u visible",
+							   (manager) ? "Parallel" : "Serial", rasterizer.getTriangleCount(), triCount / (setupTime * 1000.0),
+							   triCount / (rasterTime * 1000.0), kAabbCount, testTime * 1000.0, visibleCount);
+
+				ANKI_TEST_EXPECT_EQ(rasterizer.getTriangleCount(), kQuadsPerRow * kQuadsPerRow * 2);
+				ANKI_TEST_EXPECT_LT(visibleCount, kAabbCount);
+			}
+		}
+	}
+
+	SceneMemoryPool::freeSingleton();
+	DefaultMemoryPool::freeSingleton();
+}
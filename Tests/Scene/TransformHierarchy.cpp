@@ -0,0 +1,300 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Scene/TransformHierarchy.h>
+#include <AnKi/Util/ThreadJobManager.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <AnKi/Util/System.h>
+
+using namespace anki;
+
+namespace {
+
+/// Emulates the old pointer based hierarchy where every node updated its world transform and then recursed to its children.
+class PointerNode
+{
+public:
+	Transform m_local = Transform::getIdentity();
+	Transform m_world = Transform::getIdentity();
+	Transform m_prevWorld = Transform::getIdentity();
+	PointerNode* m_parent = nullptr;
+	DynamicArray<PointerNode*> m_children;
+	Bool m_localDirty = true;
+
+	void update()
+	{
+		if(m_localDirty)
+		{
+			m_prevWorld = m_world;
+			m_world = (m_parent) ? m_parent->m_world.combineTransformations(m_local) : m_local;
+			m_localDirty = false;
+
+			for(PointerNode* child : m_children)
+			{
+				child->m_localDirty = true;
+			}
+		}
+
+		for(PointerNode* child : m_children)
+		{
+			child->update();
+		}
+	}
+};
+
+Transform randomTransform(U32 seed)
+{
+	const F32 f = F32(seed % 1024) / 1024.0f;
+	return Transform(Vec4(f, f * 2.0f, -f, 0.0f), Mat3x4(Vec3(0.0f), Euler(f, f * 0.5f, -f)), 1.0f);
+}
+
+/// Build a forest of chains of some depth. Both hierarchies get the same local transforms. The transforms are allocated one level at a
+/// time (like a scene that creates the parents first).
+void buildForest(U32 rootCount, U32 depth, DynamicArray<PointerNode>& pointerNodes, DynamicArray<DynamicArray<U32>>& levels)
+{
+	TransformHierarchy& hierarchy = TransformHierarchy::getSingleton();
+
+	pointerNodes.resize(rootCount * depth);
+	levels.resize(depth);
+
+	for(U32 d = 0; d < depth; ++d)
+	{
+		for(U32 r = 0; r < rootCount; ++r)
+		{
+			const U32 idx = hierarchy.newTransform();
+			const Transform trf = randomTransform(idx);
+			hierarchy.getLocalTransform(idx) = trf;
+			hierarchy.setParent(idx, (d > 0) ? levels[d - 1][r] : kMaxU32);
+			levels[d].emplaceBack(idx);
+
+			PointerNode& pnode = pointerNodes[r * depth + d];
+			pnode.m_local = trf;
+			if(d > 0)
+			{
+				pnode.m_parent = &pointerNodes[r * depth + d - 1];
+				pnode.m_parent->m_children.emplaceBack(&pnode);
+			}
+		}
+	}
+}
+
+void deleteForest(DynamicArray<DynamicArray<U32>>& levels)
+{
+	for(DynamicArray<U32>& level : levels)
+	{
+		for(U32 idx : level)
+		{
+			TransformHierarchy::getSingleton().deleteTransform(idx);
+		}
+	}
+}
+
+void benchmark(CString name, U32 rootCount, U32 depth, ThreadJobManager& jobManager)
+{
+	TransformHierarchy& hierarchy = TransformHierarchy::getSingleton();
+
+	DynamicArray<PointerNode> pointerNodes;
+	DynamicArray<DynamicArray<U32>> levels;
+	buildForest(rootCount, depth, pointerNodes, levels);
+
+	// Recursive
+	Second begin = HighRezTimer::getCurrentTime();
+	for(U32 r = 0; r < rootCount; ++r)
+	{
+		pointerNodes[r * depth].update();
+	}
+	const Second recursiveTime = HighRezTimer::getCurrentTime() - begin;
+
+	// Level by level
+	begin = HighRezTimer::getCurrentTime();
+	for(const DynamicArray<U32>& level : levels)
+	{
+		hierarchy.updateWorldTransforms(level, &jobManager);
+	}
+	const Second levelTime = HighRezTimer::getCurrentTime() - begin;
+
+	// Check the results
+	Bool identical = true;
+	for(U32 r = 0; r < rootCount; ++r)
+	{
+		for(U32 d = 0; d < depth; ++d)
+		{
+			const Transform& a = pointerNodes[r * depth + d].m_world;
+			const Transform& b = hierarchy.getWorldTransform(levels[d][r]);
+			identical = identical && a.getOrigin() == b.getOrigin() && a.getRotation() == b.getRotation() && a.getScale() == b.getScale();
+		}
+	}
+	ANKI_TEST_EXPECT_EQ(identical, true);
+
+	// Move the roots only. The rest will be updated because their parents changed
+	for(U32 r = 0; r < rootCount; ++r)
+	{
+		pointerNodes[r * depth].m_local.getOrigin() += Vec4(1.0f, 0.0f, 0.0f, 0.0f);
+		pointerNodes[r * depth].m_localDirty = true;
+
+		hierarchy.getLocalTransform(levels[0][r]).getOrigin() += Vec4(1.0f, 0.0f, 0.0f, 0.0f);
+		hierarchy.markLocalTransformDirty(levels[0][r]);
+	}
+
+	begin = HighRezTimer::getCurrentTime();
+	for(U32 r = 0; r < rootCount; ++r)
+	{
+		pointerNodes[r * depth].update();
+	}
+	const Second recursiveMoveTime = HighRezTimer::getCurrentTime() - begin;
+
+	begin = HighRezTimer::getCurrentTime();
+	for(const DynamicArray<U32>& level : levels)
+	{
+		hierarchy.updateWorldTransforms(level, &jobManager);
+	}
+	const Second levelMoveTime = HighRezTimer::getCurrentTime() - begin;
+
+	const U32 last = levels[depth - 1][rootCount - 1];
+	ANKI_TEST_EXPECT_EQ(hierarchy.getWorldTransformUpdated(last), true);
+	ANKI_TEST_EXPECT_EQ(hierarchy.getWorldTransform(last).getOrigin(), pointerNodes[rootCount * depth - 1].m_world.getOrigin());
+
+	ANKI_TEST_LOGI("%s (%u nodes, depth %u): Full update: recursive %fms, level by level %fms. Move roots: recursive %fms, level by level %fms",
+				   name.cstr(), rootCount * depth, depth, recursiveTime * 1000.0, levelTime * 1000.0, recursiveMoveTime * 1000.0,
+				   levelMoveTime * 1000.0);
+
+	deleteForest(levels);
+}
+
+} // namespace
+
+ANKI_TEST(Scene, TransformHierarchy)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+	SceneMemoryPool::allocateSingleton(allocAligned, nullptr);
+	TransformHierarchy::allocateSingleton();
+
+	{
+		TransformHierarchy& hierarchy = TransformHierarchy::getSingleton();
+
+		// Basic propagation
+		{
+			const U32 root = hierarchy.newTransform();
+			const U32 child = hierarchy.newTransform();
+			hierarchy.setParent(child, root);
+
+			hierarchy.getLocalTransform(root).setOrigin(Vec4(1.0f, 0.0f, 0.0f, 0.0f));
+			hierarchy.markLocalTransformDirty(root);
+			hierarchy.getLocalTransform(child).setOrigin(Vec4(0.0f, 2.0f, 0.0f, 0.0f));
+			hierarchy.markLocalTransformDirty(child);
+
+			ANKI_TEST_EXPECT_EQ(hierarchy.updateWorldTransform(root), true);
+			ANKI_TEST_EXPECT_EQ(hierarchy.updateWorldTransform(child), true);
+			ANKI_TEST_EXPECT_EQ(hierarchy.getWorldTransform(child).getOrigin(), Vec4(1.0f, 2.0f, 0.0f, 0.0f));
+
+			// Nothing changed
+			ANKI_TEST_EXPECT_EQ(hierarchy.updateWorldTransform(root), false);
+			ANKI_TEST_EXPECT_EQ(hierarchy.updateWorldTransform(child), false);
+			ANKI_TEST_EXPECT_EQ(hierarchy.getWorldTransformUpdated(child), false);
+			ANKI_TEST_EXPECT_EQ(hierarchy.getPreviousWorldTransform(child).getOrigin(), Vec4(1.0f, 2.0f, 0.0f, 0.0f));
+
+			// Move the parent, the child follows
+			hierarchy.getLocalTransform(root).setOrigin(Vec4(3.0f, 0.0f, 0.0f, 0.0f));
+			ANKI_TEST_EXPECT_EQ(hierarchy.markLocalTransformDirty(root), true);
+			ANKI_TEST_EXPECT_EQ(hierarchy.markLocalTransformDirty(root), false);
+			ANKI_TEST_EXPECT_EQ(hierarchy.updateWorldTransform(root), true);
+			ANKI_TEST_EXPECT_EQ(hierarchy.updateWorldTransform(child), true);
+			ANKI_TEST_EXPECT_EQ(hierarchy.getWorldTransform(child).getOrigin(), Vec4(3.0f, 2.0f, 0.0f, 0.0f));
+			ANKI_TEST_EXPECT_EQ(hierarchy.getPreviousWorldTransform(child).getOrigin(), Vec4(1.0f, 2.0f, 0.0f, 0.0f));
+
+			// Ignore the parent
+			hierarchy.setIgnoreParentTransform(child, true);
+			ANKI_TEST_EXPECT_EQ(hierarchy.updateWorldTransform(child), true);
+			ANKI_TEST_EXPECT_EQ(hierarchy.getWorldTransform(child).getOrigin(), Vec4(0.0f, 2.0f, 0.0f, 0.0f));
+
+			// Detach from the parent and recycle
+			hierarchy.setIgnoreParentTransform(child, false);
+			hierarchy.setParent(child, kMaxU32);
+			hierarchy.deleteTransform(root);
+			ANKI_TEST_EXPECT_EQ(hierarchy.updateWorldTransform(child), true);
+			ANKI_TEST_EXPECT_EQ(hierarchy.getWorldTransform(child).getOrigin(), Vec4(0.0f, 2.0f, 0.0f, 0.0f));
+
+			const U32 recycled = hierarchy.newTransform();
+			ANKI_TEST_EXPECT_EQ(recycled, root);
+			hierarchy.deleteTransform(recycled);
+			hierarchy.deleteTransform(child);
+			ANKI_TEST_EXPECT_EQ(hierarchy.getTransformCount(), 0);
+		}
+
+		// Create and delete transforms from many threads while others are being updated. New pages get allocated in the meantime
+		{
+			DynamicArray<U32> updated;
+			for(U32 i = 0; i < 100; ++i)
+			{
+				updated.emplaceBack(hierarchy.newTransform());
+				hierarchy.getLocalTransform(updated.getBack()).setOrigin(Vec4(F32(i), 0.0f, 0.0f, 0.0f));
+			}
+
+			constexpr U32 kThreadCount = 4;
+			constexpr U32 kTransformsPerThread = 10 * 1024;
+			ThreadJobManager jobManager(kThreadCount, false);
+			ThreadJobCounter counter;
+			Atomic<U32> wrongCount = {0};
+			for(U32 t = 0; t < kThreadCount; ++t)
+			{
+				jobManager.dispatchTask(
+					[&, t]([[maybe_unused]] U32 tid) {
+						DynamicArray<U32> mine;
+						for(U32 i = 0; i < kTransformsPerThread; ++i)
+						{
+							mine.emplaceBack(hierarchy.newTransform());
+							hierarchy.getLocalTransform(mine.getBack()).setOrigin(Vec4(F32(t), F32(i), 0.0f, 0.0f));
+
+							if(i % 3 == 0)
+							{
+								hierarchy.deleteTransform(mine.getBack());
+								mine.popBack();
+							}
+						}
+
+						for(U32 idx : mine)
+						{
+							wrongCount.fetchAdd(hierarchy.getLocalTransform(idx).getOrigin().x() != F32(t));
+							hierarchy.deleteTransform(idx);
+						}
+					},
+					&counter);
+			}
+
+			while(!counter.isDone())
+			{
+				for(U32 idx : updated)
+				{
+					hierarchy.markLocalTransformDirty(idx);
+				}
+				hierarchy.updateWorldTransforms(updated);
+			}
+			jobManager.waitForCounter(counter);
+
+			for(U32 i = 0; i < updated.getSize(); ++i)
+			{
+				wrongCount.fetchAdd(hierarchy.getWorldTransform(updated[i]).getOrigin().x() != F32(i));
+				hierarchy.deleteTransform(updated[i]);
+			}
+
+			ANKI_TEST_EXPECT_EQ(wrongCount.load(), 0);
+			ANKI_TEST_EXPECT_EQ(hierarchy.getTransformCount(), 0);
+		}
+
+		// Benchmarks against the recursive pointer hierarchy
+		{
+			ThreadJobManager jobManager(getCpuCoresCount(), false);
+
+			benchmark("Flat", 1000 * 1000, 1, jobManager);
+			benchmark("Deep", 1000, 1000, jobManager);
+			benchmark("Mixed", 100 * 1000, 10, jobManager);
+		}
+	}
+
+	TransformHierarchy::freeSingleton();
+	SceneMemoryPool::freeSingleton();
+	DefaultMemoryPool::freeSingleton();
+}
@@ -0,0 +1,135 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/ShaderCompiler/ShaderCompilerCache.h>
+#include <AnKi/Util/ThreadJobManager.h>
+#include <AnKi/Util/Filesystem.h>
+#include <AnKi/Util/File.h>
+
+ANKI_TEST(ShaderCompiler, ShaderCompilerCache)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	{
+		String dir;
+		ANKI_TEST_EXPECT_NO_ERR(getTempDirectory(dir));
+		dir += "/AnKiShaderCompilerCacheTest";
+		if(directoryExists(dir))
+		{
+			ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
+		}
+
+		constexpr U32 kEntryCount = 64;
+		constexpr U32 kEntrySize = 1024;
+
+		auto fillBinary = [](U64 key, DynamicArray<U8>& binary) {
+			binary.resize(kEntrySize);
+			for(U32 i = 0; i < kEntrySize; ++i)
+			{
+				binary[i] = U8(key * 3 + i);
+			}
+		};
+
+		// Store and find from many threads. Every entry is stored by more than one thread
+		{
+			ShaderCompilerCache::allocateSingleton();
+			ANKI_TEST_EXPECT_NO_ERR(ShaderCompilerCache::getSingleton().init(dir, 1_MB));
+
+			ThreadJobManager jobManager(8);
+			Atomic<U32> wrongCount = {0};
+			for(U32 i = 0; i < kEntryCount * 4; ++i)
+			{
+				jobManager.dispatchTask([i, &fillBinary, &wrongCount]([[maybe_unused]] U32 threadIdx) {
+					const U64 key = i % kEntryCount + 1;
+					DynamicArray<U8> expected;
+					fillBinary(key, expected);
+
+					DynamicArray<U8> binary;
+					if(ShaderCompilerCache::getSingleton().find(key, binary))
+					{
+						if(binary.getSize() != expected.getSize() || memcmp(&binary[0], &expected[0], kEntrySize) != 0)
+						{
+							wrongCount.fetchAdd(1);
+						}
+					}
+					else
+					{
+						ShaderCompilerCache::getSingleton().store(key, expected);
+					}
+				});
+			}
+			jobManager.waitForAllTasksToFinish();
+
+			ANKI_TEST_EXPECT_EQ(wrongCount.load(), 0);
+			ANKI_TEST_EXPECT_EQ(ShaderCompilerCache::getSingleton().getHitCount() + ShaderCompilerCache::getSingleton().getMissCount(),
+								kEntryCount * 4);
+
+			ShaderCompilerCache::freeSingleton();
+		}
+
+		// All should be hits now
+		{
+			ShaderCompilerCache::allocateSingleton();
+			ANKI_TEST_EXPECT_NO_ERR(ShaderCompilerCache::getSingleton().init(dir, 1_MB));
+
+			DynamicArray<U8> expected;
+			DynamicArray<U8> binary;
+			for(U64 key = 1; key <= kEntryCount; ++key)
+			{
+				fillBinary(key, expected);
+				ANKI_TEST_EXPECT_EQ(ShaderCompilerCache::getSingleton().find(key, binary), true);
+				ANKI_TEST_EXPECT_EQ(memcmp(&binary[0], &expected[0], kEntrySize), 0);
+			}
+
+			ANKI_TEST_EXPECT_EQ(ShaderCompilerCache::getSingleton().getHitCount(), kEntryCount);
+			ANKI_TEST_EXPECT_EQ(ShaderCompilerCache::getSingleton().getMissCount(), 0);
+
+			// Corrupt an entry, it should be a miss
+			String fname;
+			fname.sprintf("%s/%016x.spv", dir.cstr(), 1);
+			{
+				File file;
+				ANKI_TEST_EXPECT_NO_ERR(file.open(fname, FileOpenFlag::kWrite | FileOpenFlag::kBinary));
+				ANKI_TEST_EXPECT_NO_ERR(file.write(&expected[0], 100));
+			}
+			ANKI_TEST_EXPECT_EQ(ShaderCompilerCache::getSingleton().find(1, binary), false);
+
+			ShaderCompilerCache::freeSingleton();
+		}
+
+		// A smaller cache should evict entries when something gets stored
+		{
+			ShaderCompilerCache::allocateSingleton();
+			constexpr PtrSize kMaxSize = 16 * (kEntrySize + 64);
+			ANKI_TEST_EXPECT_NO_ERR(ShaderCompilerCache::getSingleton().init(dir, kMaxSize));
+
+			DynamicArray<U8> binary;
+			fillBinary(kEntryCount + 1, binary);
+			ShaderCompilerCache::getSingleton().store(kEntryCount + 1, binary);
+
+			ShaderCompilerCache::freeSingleton();
+
+			PtrSize totalSize = 0;
+			ANKI_TEST_EXPECT_NO_ERR(walkDirectoryTree(dir, [&](CString path, Bool isDir) -> Error {
+				if(!isDir)
+				{
+					String fname;
+					fname.sprintf("%s/%s", dir.cstr(), path.cstr());
+					File file;
+					ANKI_CHECK(file.open(fname, FileOpenFlag::kRead | FileOpenFlag::kBinary));
+					totalSize += file.getSize();
+				}
+				return Error::kNone;
+			}));
+			ANKI_TEST_EXPECT_LEQ(totalSize, kMaxSize);
+			ANKI_TEST_EXPECT_GT(totalSize, 0);
+		}
+
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
+	}
+
+	DefaultMemoryPool::freeSingleton();
+}
@@ -5,7 +5,10 @@
 
 #include <Tests/Framework/Framework.h>
 #include <AnKi/ShaderCompiler/ShaderProgramCompiler.h>
+#include <AnKi/ShaderCompiler/Dxc.h>
 #include <AnKi/Util/ThreadHive.h>
+#include <AnKi/Util/System.h>
+#include <AnKi/Util/HighRezTimer.h>
 
 ANKI_TEST(ShaderCompiler, ShaderProgramCompilerSimple)
 {
@@ -342,3 +345,178 @@ void main()
 	ANKI_LOGI("Binary disassembly:\n%s\n", dis.cstr());
 #endif
 }
+
+ANKI_TEST(ShaderCompiler, ShaderProgramCompilerDxcLibrary)
+{
+	const CString sourceCode = R"(
+#pragma anki mutator INSTANCE_COUNT 1 2 4 8
+#pragma anki mutator DIFFUSE_TEX 0 1
+#pragma anki mutator NORMAL_TEX 0 1
+#pragma anki mutator EMISSIVE_TEX 0 1
+#pragma anki mutator VELOCITY 0 1
+
+struct Constants
+{
+	float4x4 m_mvp[INSTANCE_COUNT];
+	float4 m_color;
+};
+
+[[vk::push_constant]] ConstantBuffer<Constants> g_pc;
+
+[[vk::binding(0)]] SamplerState g_sampler;
+[[vk::binding(1)]] Texture2D<float4> g_diffuseTex;
+[[vk::binding(2)]] Texture2D<float4> g_normalTex;
+[[vk::binding(3)]] Texture2D<float4> g_emissiveTex;
+
+struct VertOut
+{
+	float4 m_position : SV_POSITION;
+	float2 m_uv : TEXCOORD;
+};
+
+#pragma anki start vert
+VertOut main(float3 position : POSITION, uint svInstanceId : SV_INSTANCEID)
+{
+	VertOut output;
+	output.m_position = mul(g_pc.m_mvp[svInstanceId % INSTANCE_COUNT], float4(position, 1.0));
+	output.m_uv = position.xy;
+	return output;
+}
+#pragma anki end
+
+#pragma anki start frag
+struct FragOut
+{
+	float4 m_color : SV_TARGET0;
+#if VELOCITY
+	float2 m_velocity : SV_TARGET1;
+#endif
+};
+
+FragOut main(VertOut input)
+{
+	FragOut output;
+	output.m_color = g_pc.m_color;
+#if DIFFUSE_TEX
+	output.m_color *= g_diffuseTex.Sample(g_sampler, input.m_uv);
+#endif
+#if NORMAL_TEX
+	output.m_color.xyz *= normalize(g_normalTex.Sample(g_sampler, input.m_uv).xyz * 2.0 - 1.0);
+#endif
+#if EMISSIVE_TEX
+	output.m_color.xyz += g_emissiveTex.Sample(g_sampler, input.m_uv).xyz;
+#endif
+#if VELOCITY
+	output.m_velocity = ddx(input.m_uv);
+#endif
+	return output;
+}
+#pragma anki end
+	)";
+
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	{
+		{
+			File file;
+			ANKI_TEST_EXPECT_NO_ERR(file.open("test.ankiprog", FileOpenFlag::kWrite));
+			ANKI_TEST_EXPECT_NO_ERR(file.writeText(sourceCode));
+		}
+
+		class Fsystem : public ShaderProgramFilesystemInterface
+		{
+		public:
+			Error readAllText(CString filename, String& txt) final
+			{
+				File file;
+				ANKI_CHECK(file.open(filename, FileOpenFlag::kRead));
+				ANKI_CHECK(file.readAllText(txt));
+				return Error::kNone;
+			}
+		} fsystem;
+
+		HeapMemoryPool pool(allocAligned, nullptr);
+		ThreadHive hive(getCpuCoresCount(), &pool);
+
+		class TaskManager : public ShaderProgramAsyncTaskInterface
+		{
+		public:
+			ThreadHive* m_hive = nullptr;
+			HeapMemoryPool* m_pool = nullptr;
+
+			void enqueueTask(void (*callback)(void* userData), void* userData)
+			{
+				struct Ctx
+				{
+					void (*m_callback)(void* userData);
+					void* m_userData;
+					HeapMemoryPool* m_pool;
+				};
+				Ctx* ctx = newInstance<Ctx>(*m_pool);
+				ctx->m_callback = callback;
+				ctx->m_userData = userData;
+				ctx->m_pool = m_pool;
+
+				m_hive->submitTask(
+					[](void* userData, [[maybe_unused]] U32 threadId, [[maybe_unused]] ThreadHive& hive,
+					   [[maybe_unused]] ThreadHiveSemaphore* signalSemaphore) {
+						Ctx* ctx = static_cast<Ctx*>(userData);
+						ctx->m_callback(ctx->m_userData);
+						deleteInstance(*ctx->m_pool, ctx);
+					},
+					ctx);
+			}
+
+			Error joinTasks()
+			{
+				m_hive->waitAllTasks();
+				return Error::kNone;
+			}
+		} taskManager;
+		taskManager.m_hive = &hive;
+		taskManager.m_pool = &pool;
+
+		// Compile all the variants by calling the DXC executable
+		HighRezTimer timer;
+		timer.start();
+		ShaderProgramBinaryWrapper executableBinary(&pool);
+		ANKI_TEST_EXPECT_NO_ERR(compileShaderProgram("test.ankiprog", fsystem, nullptr, &taskManager, ShaderCompilerOptions(), executableBinary));
+		timer.stop();
+		const Second executableTime = timer.getElapsedTime();
+
+		// Again using the library
+		if(initDxcLibrary())
+		{
+			ANKI_TEST_LOGW("The DXC library is missing. Skipping the in-process compilation");
+		}
+		else
+		{
+			timer.start();
+			ShaderProgramBinaryWrapper libraryBinary(&pool);
+			ANKI_TEST_EXPECT_NO_ERR(compileShaderProgram("test.ankiprog", fsystem, nullptr, &taskManager, ShaderCompilerOptions(), libraryBinary));
+			timer.stop();
+			const Second libraryTime = timer.getElapsedTime();
+			shutdownDxcLibrary();
+
+			ANKI_TEST_LOGI("Compiled %u variants. DXC executable %fms, DXC library %fms", executableBinary.getBinary().m_variants.getSize(),
+						   executableTime * 1000.0, libraryTime * 1000.0);
+
+			// The SPIR-V should be identical
+			const ShaderProgramBinary& a = executableBinary.getBinary();
+			const ShaderProgramBinary& b = libraryBinary.getBinary();
+			ANKI_TEST_EXPECT_EQ(a.m_codeBlocks.getSize(), b.m_codeBlocks.getSize());
+			for(U32 i = 0; i < min(a.m_codeBlocks.getSize(), b.m_codeBlocks.getSize()); ++i)
+			{
+				const ConstWeakArray<U8> codeA = a.m_codeBlocks[i].m_binary;
+				const ConstWeakArray<U8> codeB = b.m_codeBlocks[i].m_binary;
+				ANKI_TEST_EXPECT_EQ(codeA.getSize(), codeB.getSize());
+				if(codeA.getSize() == codeB.getSize())
+				{
+					ANKI_TEST_EXPECT_EQ(memcmp(codeA.getBegin(), codeB.getBegin(), codeA.getSizeInBytes()), 0);
+				}
+			}
+		}
+	}
+
+	DefaultMemoryPool::freeSingleton();
+}
@@ -0,0 +1,205 @@
+// Copyright (C) 2009-2023, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Util/TaskGraph.h>
+#include <AnKi/Util/ThreadHive.h>
+#include <AnKi/Util/ThreadPool.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <AnKi/Util/System.h>
+
+ANKI_TEST(Util, TaskGraph)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	{
+		const U32 threadCount = getCpuCoresCount();
+		TaskGraph graph(threadCount, true);
+
+		// Explicit edges
+		{
+			Atomic<U32> order = {0};
+			U32 aOrder = kMaxU32, bOrder = kMaxU32, cOrder = kMaxU32;
+
+			TaskGraphTask* a = graph.newTask([&]([[maybe_unused]] U32 tid) {
+				HighRezTimer::sleep(10.0_ms);
+				aOrder = order.fetchAdd(1);
+			});
+			TaskGraphTask* b = graph.newTask([&]([[maybe_unused]] U32 tid) {
+				HighRezTimer::sleep(5.0_ms);
+				bOrder = order.fetchAdd(1);
+			});
+			TaskGraphTask* c = graph.newTask([&]([[maybe_unused]] U32 tid) {
+				cOrder = order.fetchAdd(1);
+			});
+
+			graph.addDependency(*a, *c);
+			graph.addDependency(*b, *c);
+			graph.addDependency(*a, *b);
+
+			graph.submitTask(*c);
+			graph.submitTask(*b);
+			graph.submitTask(*a);
+			graph.waitAllTasks();
+
+			ANKI_TEST_EXPECT_EQ(aOrder, 0);
+			ANKI_TEST_EXPECT_EQ(bOrder, 1);
+			ANKI_TEST_EXPECT_EQ(cOrder, 2);
+		}
+
+		// Continuations, even after the task finished
+		{
+			Atomic<U32> count = {0};
+			TaskGraphTask* a = graph.newTask([&]([[maybe_unused]] U32 tid) {
+				count.fetchAdd(1);
+			});
+			graph.submitTask(*a);
+
+			HighRezTimer::sleep(5.0_ms);
+
+			for(U32 i = 0; i < 16; ++i)
+			{
+				graph.newContinuation(*a, [&]([[maybe_unused]] U32 tid) {
+					ANKI_TEST_EXPECT_GEQ(count.fetchAdd(1), 1);
+				});
+			}
+
+			graph.waitAllTasks();
+			ANKI_TEST_EXPECT_EQ(count.load(), 17);
+		}
+
+		// Parallel-for
+		{
+			constexpr U32 kCount = 100 * 1000;
+			DynamicArray<U32> values;
+			values.resize(kCount, 0);
+			Atomic<U32> joined = {0};
+
+			TaskGraphTask* first = graph.newTask([&]([[maybe_unused]] U32 tid) {
+				for(U32 i = 0; i < kCount; ++i)
+				{
+					values[i] = i;
+				}
+			});
+
+			TaskGraphTask* join = graph.newParallelFor(
+				kCount, 1000,
+				[&](U32 begin, U32 end, [[maybe_unused]] U32 tid) {
+					for(U32 i = begin; i < end; ++i)
+					{
+						values[i] *= 2;
+					}
+				},
+				first);
+
+			graph.newContinuation(*join, [&]([[maybe_unused]] U32 tid) {
+				Bool correct = true;
+				for(U32 i = 0; i < kCount; ++i)
+				{
+					correct = correct && values[i] == i * 2;
+				}
+
+				joined.store(correct);
+			});
+
+			graph.submitTask(*first);
+			graph.waitAllTasks();
+
+			ANKI_TEST_EXPECT_EQ(joined.load(), 1);
+		}
+	}
+
+	DefaultMemoryPool::freeSingleton();
+}
+
+ANKI_TEST(Util, TaskGraphSharedWorkers)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	{
+		// The hive, the pool and a graph all share the same workers
+		ThreadJobManager manager(getCpuCoresCount(), true);
+		ThreadHive hive(manager);
+		ThreadPool pool(manager);
+		TaskGraph graph(manager);
+
+		Atomic<U32> count = {0};
+
+		for(U32 i = 0; i < 100; ++i)
+		{
+			hive.submitTask(
+				[](void* arg, [[maybe_unused]] U32 threadId, [[maybe_unused]] ThreadHive& hive, [[maybe_unused]] ThreadHiveSemaphore* sem) {
+					static_cast<Atomic<U32>*>(arg)->fetchAdd(1);
+				},
+				&count);
+
+			graph.submitTask(*graph.newTask([&]([[maybe_unused]] U32 tid) {
+				count.fetchAdd(1);
+			}));
+		}
+
+		class Task : public ThreadPoolTask
+		{
+		public:
+			Atomic<U32>* m_count;
+
+			Error operator()([[maybe_unused]] U32 taskId, [[maybe_unused]] PtrSize threadsCount)
+			{
+				m_count->fetchAdd(1);
+				return Error::kNone;
+			}
+		};
+
+		DynamicArray<Task> tasks;
+		tasks.resize(U32(pool.getThreadCount()));
+		for(U32 i = 0; i < pool.getThreadCount(); ++i)
+		{
+			tasks[i].m_count = &count;
+			pool.assignNewTask(i, &tasks[i]);
+		}
+
+		hive.waitAllTasks();
+		graph.waitAllTasks();
+		ANKI_TEST_EXPECT_NO_ERR(pool.waitForAllThreadsToFinish());
+
+		ANKI_TEST_EXPECT_EQ(count.load(), 200 + pool.getThreadCount());
+	}
+
+	DefaultMemoryPool::freeSingleton();
+}
+
+ANKI_TEST(Util, ThreadHiveSemaphoreRearm)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	{
+		ThreadHive hive(2);
+		Atomic<U32> count = {0};
+
+		ThreadHiveSemaphore* sem = hive.newSemaphore(1);
+		ANKI_TEST_EXPECT_NO_ERR(sem->increaseSemaphore(1));
+
+		Array<ThreadHiveTask, 3> tasks;
+		for(U32 i = 0; i < 2; ++i)
+		{
+			tasks[i] = ANKI_THREAD_HIVE_TASK({ self->fetchAdd(1); }, &count, nullptr, sem);
+		}
+		tasks[2] = ANKI_THREAD_HIVE_TASK({ self->fetchAdd(10); }, &count, sem, nullptr);
+		hive.submitTasks(&tasks[0], tasks.getSize());
+
+		while(count.load() != 12)
+		{
+			HighRezTimer::sleep(1.0_ms);
+		}
+
+		// It reached zero and the waiting task ran. Re-arming it would run the task again
+		ANKI_TEST_EXPECT_ERR(sem->increaseSemaphore(1), Error::kFunctionFailed);
+
+		hive.waitAllTasks();
+		ANKI_TEST_EXPECT_EQ(count.load(), 12);
+	}
+
+	DefaultMemoryPool::freeSingleton();
+}
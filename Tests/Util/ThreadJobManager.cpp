@@ -11,6 +11,198 @@
 
 using namespace anki;
 
+namespace {
+
+/// The old ThreadJobManager that used a single mutex protected ring buffer. Kept to compare against.
+class LegacyThreadJobManager
+{
+public:
+	using Func = Function<void(U32 threadId)>;
+
+	LegacyThreadJobManager(U32 threadCount, Bool pinToCores, U32 queueSize)
+	{
+		m_threads.resize(threadCount);
+		for(U32 i = 0; i < threadCount; ++i)
+		{
+			m_threads[i] = newInstance<WorkerThread>(DefaultMemoryPool::getSingleton(), this, i, pinToCores);
+		}
+
+		m_tasks.resize(queueSize);
+	}
+
+	~LegacyThreadJobManager()
+	{
+		{
+			LockGuard lock(m_tasksMtx);
+			m_quit = true;
+		}
+
+		m_cvar.notifyAll();
+
+		for(WorkerThread* thread : m_threads)
+		{
+			[[maybe_unused]] const Error err = thread->m_thread.join();
+			deleteInstance(DefaultMemoryPool::getSingleton(), thread);
+		}
+	}
+
+	void dispatchTask(const Func& func)
+	{
+		m_tasksInFlightCount.fetchAdd(1);
+
+		while(!pushBackTask(func))
+		{
+			m_cvar.notifyOne();
+			std::this_thread::yield();
+		}
+
+		m_cvar.notifyOne();
+	}
+
+	void waitForAllTasksToFinish()
+	{
+		while(m_tasksInFlightCount.load() != 0)
+		{
+			m_cvar.notifyOne();
+			std::this_thread::yield();
+		}
+	}
+
+private:
+	class WorkerThread
+	{
+	public:
+		U32 m_id;
+		Thread m_thread;
+		LegacyThreadJobManager* m_manager;
+
+		WorkerThread(LegacyThreadJobManager* manager, U32 id, Bool pinToCore)
+			: m_id(id)
+			, m_thread("LegacyJobs")
+			, m_manager(manager)
+		{
+			m_thread.start(this, threadCallback, ThreadCoreAffinityMask(false).set(m_id, pinToCore));
+		}
+
+		static Error threadCallback(ThreadCallbackInfo& info)
+		{
+			WorkerThread& self = *static_cast<WorkerThread*>(info.m_userData);
+			self.m_manager->threadRun(self.m_id);
+			return Error::kNone;
+		}
+	};
+
+	DynamicArray<WorkerThread*> m_threads;
+
+	DynamicArray<Func> m_tasks;
+	U32 m_tasksFront = 0;
+	U32 m_tasksBack = 0;
+	Mutex m_tasksMtx;
+
+	Atomic<U32> m_tasksInFlightCount = {0};
+
+	ConditionVariable m_cvar;
+	Mutex m_mtx;
+
+	Bool m_quit = false;
+
+	Bool pushBackTask(const Func& func)
+	{
+		LockGuard lock(m_tasksMtx);
+		const U32 next = (m_tasksBack + 1) % m_tasks.getSize();
+		if(next != m_tasksFront)
+		{
+			m_tasks[m_tasksBack] = func;
+			m_tasksBack = next;
+			return true;
+		}
+
+		return false;
+	}
+
+	Bool popFrontTask(Func& func, Bool& quit)
+	{
+		LockGuard lock(m_tasksMtx);
+		quit = m_quit;
+
+		if(quit) [[unlikely]]
+		{
+			return true;
+		}
+
+		if(m_tasksBack != m_tasksFront)
+		{
+			func = m_tasks[m_tasksFront];
+			m_tasksFront = (m_tasksFront + 1) % m_tasks.getSize();
+			return true;
+		}
+
+		return false;
+	}
+
+	void threadRun(U32 threadId)
+	{
+		while(true)
+		{
+			Bool quit;
+			Func func;
+			if(popFrontTask(func, quit))
+			{
+				if(quit) [[unlikely]]
+				{
+					break;
+				}
+
+				func(threadId);
+				m_tasksInFlightCount.fetchSub(1);
+			}
+			else
+			{
+				LockGuard lock(m_mtx);
+				m_cvar.wait(m_mtx);
+			}
+		}
+	}
+};
+
+/// Dispatch a number of tasks from the main thread. If nested is true half of them will be dispatched from inside the workers.
+template<typename TManager>
+Second jobManagerThroughput(TManager& manager, U32 taskCount, Bool nested)
+{
+	ANKI_ASSERT((taskCount & 1) == 0);
+	Atomic<U32> atomic(0);
+
+	const Second begin = HighRezTimer::getCurrentTime();
+
+	auto simpleTask = [&atomic]([[maybe_unused]] U32 tid) {
+		atomic.fetchAdd(1);
+	};
+
+	for(U32 i = 0; i < taskCount; i += 2)
+	{
+		if(nested)
+		{
+			manager.dispatchTask([&atomic, &manager, simpleTask]([[maybe_unused]] U32 tid) {
+				atomic.fetchAdd(1);
+				manager.dispatchTask(simpleTask);
+			});
+		}
+		else
+		{
+			manager.dispatchTask(simpleTask);
+			manager.dispatchTask(simpleTask);
+		}
+	}
+
+	manager.waitForAllTasksToFinish();
+
+	const Second timeDiff = HighRezTimer::getCurrentTime() - begin;
+	ANKI_TEST_EXPECT_EQ(atomic.load(), taskCount);
+	return timeDiff;
+}
+
+} // namespace
+
 ANKI_TEST(Util, ThreadJobManager)
 {
 	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
@@ -36,6 +228,53 @@ ANKI_TEST(Util, ThreadJobManager)
 		ANKI_TEST_EXPECT_EQ(atomic.load(), kTaskCount);
 	}
 
+	// Counters and nested tasks
+	{
+		constexpr U32 kTaskCount = 1024;
+
+		ThreadJobManager manager(getCpuCoresCount(), true, 16);
+
+		Atomic<U32> atomicA(0);
+		Atomic<U32> atomicB(0);
+		ThreadJobCounter counterA;
+		ThreadJobCounter counterB;
+
+		for(U32 i = 0; i < kTaskCount; ++i)
+		{
+			manager.dispatchTask(
+				[&]([[maybe_unused]] U32 tid) {
+					ThreadJobCounter innerCounter;
+					for(U32 j = 0; j < 4; ++j)
+					{
+						manager.dispatchTask(
+							[&atomicA]([[maybe_unused]] U32 tid) {
+								atomicA.fetchAdd(1);
+							},
+							&innerCounter);
+					}
+
+					manager.waitForCounter(innerCounter);
+				},
+				&counterA);
+
+			manager.dispatchTask(
+				[&atomicB]([[maybe_unused]] U32 tid) {
+					HighRezTimer::sleep(1.0_ms);
+					atomicB.fetchAdd(1);
+				},
+				&counterB);
+		}
+
+		manager.waitForCounter(counterA);
+		ANKI_TEST_EXPECT_EQ(counterA.isDone(), true);
+		ANKI_TEST_EXPECT_EQ(atomicA.load(), kTaskCount * 4);
+
+		manager.waitForCounter(counterB);
+		ANKI_TEST_EXPECT_EQ(atomicB.load(), kTaskCount);
+
+		manager.waitForAllTasksToFinish();
+	}
+
 	DefaultMemoryPool::freeSingleton();
 }
 
@@ -69,3 +308,32 @@ ANKI_TEST(Util, ThreadJobManagerBench)
 
 	DefaultMemoryPool::freeSingleton();
 }
+
+ANKI_TEST(Util, ThreadJobManagerThroughput)
+{
+	DefaultMemoryPool::allocateSingleton(allocAligned, nullptr);
+
+	constexpr U32 kTaskCount = 4 * 1024 * 1024;
+	const U32 threadCount = getCpuCoresCount();
+
+	Second legacyTime;
+	{
+		LegacyThreadJobManager manager(threadCount, true, 256);
+		legacyTime = jobManagerThroughput(manager, kTaskCount, false);
+	}
+
+	Second newTime;
+	Second newNestedTime;
+	{
+		ThreadJobManager manager(threadCount, true, 256);
+		newTime = jobManagerThroughput(manager, kTaskCount, false);
+		newNestedTime = jobManagerThroughput(manager, kTaskCount, true);
+	}
+
+	ANKI_TEST_LOGI("%u tasks on %u threads. Mutex ring buffer: %fms (%f tasks/ms). Work-stealing: %fms (%f tasks/ms). "
+				   "Work-stealing with nested dispatches: %fms (%f tasks/ms)",
+				   kTaskCount, threadCount, legacyTime * 1000.0, kTaskCount / (legacyTime * 1000.0), newTime * 1000.0,
+				   kTaskCount / (newTime * 1000.0), newNestedTime * 1000.0, kTaskCount / (newNestedTime * 1000.0));
+
+	DefaultMemoryPool::freeSingleton();
+}
@@ -12,12 +12,13 @@ Options:
 -rpath <string>            : Replace all absolute paths of assets with that path
 -texrpath <string>         : Same as rpath but for textures
 -optimize-meshes <0|1>     : Optimize meshes. Default is 1
--optimize-animations <0|1> : Optimize animations. Default is 1
+-optimize-animations <0|1> : Remove the animation keys that can be interpolated. Default is 1
 -j <thread_count>          : Number of threads. Defaults to system's max
 -lod-count <1|2|3>         : The number of geometry LODs to generate. Default is 1
 -lod-factor <float>        : The decimate factor for each LOD. Default 0.25
 -light-scale <float>       : Multiply the light intensity with this number. Default is 1.0
 -import-textures <0|1>     : Import textures. Default is 0
+-incremental <0|1>         : Skip the meshes, materials and animations that didn't change since the last import. Default is 1
 -v                         : Enable verbose log
 )";
 
@@ -31,6 +32,7 @@ public:
 	Bool m_optimizeMeshes = true;
 	Bool m_optimizeAnimations = true;
 	Bool m_importTextures = false;
+	Bool m_incremental = true;
 	U32 m_threadCount = kMaxU32;
 	U32 m_lodCount = 1;
 	F32 m_lodFactor = 0.25f;
@@ -198,6 +200,21 @@ static Error parseCommandLineArgs(int argc, char** argv, CmdLineArgs& info)
 				return Error::kUserData;
 			}
 		}
+		else if(strcmp(argv[i], "-incremental") == 0)
+		{
+			++i;
+
+			if(i < argc)
+			{
+				I val = 1;
+				ANKI_CHECK(CString(argv[i]).toNumber(val));
+				info.m_incremental = val != 0;
+			}
+			else
+			{
+				return Error::kUserData;
+			}
+		}
 		else
 		{
 			return Error::kUserData;
@@ -269,6 +286,7 @@ int myMain(int argc, char** argv)
 	initInfo.m_threadCount = cmdArgs.m_threadCount;
 	initInfo.m_comment = comment;
 	initInfo.m_importTextures = cmdArgs.m_importTextures;
+	initInfo.m_incremental = cmdArgs.m_incremental;
 
 	GltfImporter importer(&DefaultMemoryPool::getSingleton());
 	if(importer.init(initInfo))
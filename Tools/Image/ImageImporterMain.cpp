@@ -5,6 +5,9 @@
 
 #include <AnKi/Importer/ImageImporter.h>
 #include <AnKi/Util/Filesystem.h>
+#include <AnKi/Util/ThreadJobManager.h>
+#include <AnKi/Util/System.h>
+#include <AnKi/Util/Ptr.h>
 
 using namespace anki;
 
@@ -15,6 +18,7 @@ class Cleanup
 public:
 	DynamicArray<CString> m_inputFilenames;
 	String m_outFilename;
+	U32 m_threadCount = getCpuCoresCount();
 };
 
 } // namespace
@@ -32,9 +36,14 @@ Options:
 -v                     : Verbose log
 -to-linear             : Convert sRGB to linear
 -to-srgb               : Convert linear to sRGB
+-srgb                  : The input is sRGB. The mipmaps will be filtered in linear space
+-mip-filter <filter>   : The mipmap filter. One of: box, kaiser, lanczos. Default is box
+-alpha-coverage <ref>  : Keep the alpha test coverage of the mipmaps for that alpha reference. eg 0.5
 -flip-image <0|1>      : Flip the image. Default is 1
 -hdr-scale <3 floats>  : Apply some scale to HDR images. Default is {1 1 1}
 -hdr-bias <3 floats>   : Apply some bias to HDR images. Default is {0 0 0}
+-j <thread count>      : Number of threads to generate mipmaps and compress with. 0 compresses in the main thread. Defaults to system's max
+-compressonator-s3tc   : Use Compressonator for BC1/BC3 instead of the built-in encoder
 )";
 
 static Error parseCommandLineArgs(int argc, char** argv, ImageImporterConfig& config, Cleanup& cleanup)
@@ -204,6 +213,45 @@ static Error parseCommandLineArgs(int argc, char** argv, ImageImporterConfig& co
 		{
 			config.m_linearToSRgb = true;
 		}
+		else if(CString(argv[i]) == "-srgb")
+		{
+			config.m_sRgb = true;
+		}
+		else if(CString(argv[i]) == "-mip-filter")
+		{
+			++i;
+			if(i >= argc)
+			{
+				return Error::kUserData;
+			}
+
+			if(CString(argv[i]) == "box")
+			{
+				config.m_mipmapFilter = ImageMipmapFilter::kBox;
+			}
+			else if(CString(argv[i]) == "kaiser")
+			{
+				config.m_mipmapFilter = ImageMipmapFilter::kKaiser;
+			}
+			else if(CString(argv[i]) == "lanczos")
+			{
+				config.m_mipmapFilter = ImageMipmapFilter::kLanczos;
+			}
+			else
+			{
+				return Error::kUserData;
+			}
+		}
+		else if(CString(argv[i]) == "-alpha-coverage")
+		{
+			++i;
+			if(i >= argc)
+			{
+				return Error::kUserData;
+			}
+
+			ANKI_CHECK(CString(argv[i]).toNumber(config.m_alphaCoverageReference));
+		}
 		else if(CString(argv[i]) == "-flip-image")
 		{
 			++i;
@@ -253,6 +301,20 @@ static Error parseCommandLineArgs(int argc, char** argv, ImageImporterConfig& co
 			ANKI_CHECK(CString(argv[i]).toNumber(z));
 			config.m_hdrBias = Vec3(x, y, z);
 		}
+		else if(CString(argv[i]) == "-j")
+		{
+			++i;
+			if(i >= argc)
+			{
+				return Error::kUserData;
+			}
+
+			ANKI_CHECK(CString(argv[i]).toNumber(cleanup.m_threadCount));
+		}
+		else if(CString(argv[i]) == "-compressonator-s3tc")
+		{
+			config.m_builtinS3tcEncoder = false;
+		}
 		else
 		{
 			// Probably input, break
@@ -337,6 +399,13 @@ int myMain(int argc, char** argv)
 #	error "Unupported"
 #endif
 
+	UniquePtr<ThreadJobManager, SingletonMemoryPoolDeleter<DefaultMemoryPool>> jobManager;
+	if(cleanup.m_threadCount > 0)
+	{
+		jobManager.reset(newInstance<ThreadJobManager>(DefaultMemoryPool::getSingleton(), cleanup.m_threadCount));
+		config.m_jobManager = jobManager.get();
+	}
+
 	ANKI_IMPORTER_LOGI("Image importing started: %s", config.m_outFilename.cstr());
 
 	if(importImage(config))
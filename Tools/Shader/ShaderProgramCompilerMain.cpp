@@ -4,6 +4,8 @@
 // http://www.anki3d.org/LICENSE
 
 #include <AnKi/ShaderCompiler/ShaderProgramCompiler.h>
+#include <AnKi/ShaderCompiler/ShaderCompilerCache.h>
+#include <AnKi/ShaderCompiler/Dxc.h>
 #include <AnKi/Util.h>
 using namespace anki;
 
@@ -15,6 +17,9 @@ Options:
 -I <include path>    : The path of the #include files
 -force-full-fp       : Force full floating point precision
 -mobile-platform     : Build for mobile
+-cache <directory>   : Cache the compiled shaders in a directory. Unchanged shaders won't be recompiled
+-cache-size <MB>     : The max size of the cache. Defaults to 512
+-dxc-in-process      : Load the DXC library instead of calling the DXC executable for every shader
 )";
 
 class CmdLineArgs
@@ -23,9 +28,12 @@ public:
 	String m_inputFname;
 	String m_outFname;
 	String m_includePath;
+	String m_cacheDir;
+	U32 m_cacheSizeMb = 512;
 	U32 m_threadCount = getCpuCoresCount();
 	Bool m_fullFpPrecision = false;
 	Bool m_mobilePlatform = false;
+	Bool m_dxcInProcess = false;
 };
 
 static Error parseCommandLineArgs(int argc, char** argv, CmdLineArgs& info)
@@ -91,6 +99,32 @@ static Error parseCommandLineArgs(int argc, char** argv, CmdLineArgs& info)
 				return Error::kUserData;
 			}
 		}
+		else if(strcmp(argv[i], "-cache") == 0)
+		{
+			++i;
+
+			if(i < argc && std::strlen(argv[i]) > 0)
+			{
+				info.m_cacheDir.sprintf("%s", argv[i]);
+			}
+			else
+			{
+				return Error::kUserData;
+			}
+		}
+		else if(strcmp(argv[i], "-cache-size") == 0)
+		{
+			++i;
+
+			if(i < argc)
+			{
+				ANKI_CHECK(CString(argv[i]).toNumber(info.m_cacheSizeMb));
+			}
+			else
+			{
+				return Error::kUserData;
+			}
+		}
 		else if(strcmp(argv[i], "-force-full-fp") == 0)
 		{
 			info.m_fullFpPrecision = true;
@@ -99,6 +133,10 @@ static Error parseCommandLineArgs(int argc, char** argv, CmdLineArgs& info)
 		{
 			info.m_mobilePlatform = true;
 		}
+		else if(strcmp(argv[i], "-dxc-in-process") == 0)
+		{
+			info.m_dxcInProcess = true;
+		}
 		else
 		{
 			return Error::kUserData;
@@ -186,6 +224,14 @@ static Error work(const CmdLineArgs& info)
 	ShaderProgramBinaryWrapper binary(&pool);
 	ANKI_CHECK(compileShaderProgram(info.m_inputFname, fsystem, nullptr, (info.m_threadCount) ? &taskManager : nullptr, compilerOptions, binary));
 
+	if(ShaderCompilerCache::isAllocated())
+	{
+		const U32 hits = ShaderCompilerCache::getSingleton().getHitCount();
+		const U32 total = hits + ShaderCompilerCache::getSingleton().getMissCount();
+		ANKI_LOGI("Shader cache hits %u out of %u (%.1f%%): %s", hits, total, (total) ? F32(hits) * 100.0f / F32(total) : 0.0f,
+				  info.m_inputFname.cstr());
+	}
+
 	// Store the binary
 	ANKI_CHECK(binary.serializeToFile(info.m_outFname));
 
@@ -224,7 +270,26 @@ int myMain(int argc, char** argv)
 		info.m_includePath = "./";
 	}
 
-	if(work(info))
+	if(!info.m_cacheDir.isEmpty())
+	{
+		ShaderCompilerCache::allocateSingleton();
+		if(ShaderCompilerCache::getSingleton().init(info.m_cacheDir, PtrSize(info.m_cacheSizeMb) * 1_MB))
+		{
+			ANKI_LOGW("Will continue without a shader cache");
+			ShaderCompilerCache::freeSingleton();
+		}
+	}
+
+	if(info.m_dxcInProcess && initDxcLibrary())
+	{
+		ANKI_LOGW("Will continue calling the DXC executable");
+	}
+
+	const Error err = work(info);
+	shutdownDxcLibrary();
+	ShaderCompilerCache::freeSingleton();
+
+	if(err)
 	{
 		ANKI_LOGE("Compilation failed");
 		return 1;